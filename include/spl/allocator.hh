@@ -0,0 +1,701 @@
+#ifndef _spl_allocator_hh_
+#define _spl_allocator_hh_
+
+#ifndef _WIN32
+#include <sys/mman.h>  // for madvise()
+#endif
+
+#include <atomic>
+#include <cstdlib>   // for posix_memalign(), free(), getenv(), atoi()
+#include <cstring>   // for memset()
+#include <map>
+#include <mutex>
+#include <vector>
+
+#include <spl/typesbase.hh>
+#include <spl/mathbase.hh>
+#include <spl/simd.hh>
+#include <spl/threadpool.hh>
+
+#define SPL_MEMORY_HUGE_PAGE_SIZE (SPLint64(2) << 20)	//!< Size in bytes of a transparent huge page (and the minimum size of allocations backed by them).
+#define SPL_MEMORY_PAGE_SIZE 4096						//!< Size in bytes of a page, the unit of the parallel zeroing for the first touch placement.
+#define SPL_ARENA_CHUNK_SIZE (SPLint64(64) << 20)		//!< Default size in bytes of the chunks of an \ref SPLArena.
+
+/*! \file allocator.hh
+ * \brief Aligned allocation, arenas and pools of large buffers.
+ *
+ * All buffers of grids, vector arrays and out-of-core slots are allocated
+ * with \ref splMemoryAlloc, which aligns them to at least
+ * \ref SPL_SIMD_ALIGNMENT bytes and counts them in \ref splMemoryGetStats.
+ * Two global options change how new memory is backed:
+ * - huge pages (\ref splMemorySetHugePages, environment variable
+ *   \c SPL_HUGE_PAGES=1): allocations of at least
+ *   \ref SPL_MEMORY_HUGE_PAGE_SIZE bytes start on a huge page boundary
+ *   (the buffer itself follows the header, i.e. it is aligned to
+ *   \ref SPL_SIMD_ALIGNMENT bytes or the requested alignment) and their
+ *   whole huge pages are advised with \c madvise(MADV_HUGEPAGE), i.e. a
+ *   volume of 1 GB needs about 512 instead of 262144 page faults and TLB
+ *   entries (Linux only),
+ * - first touch (\ref splMemorySetFirstTouch, environment variable
+ *   \c SPL_FIRST_TOUCH=1): new grids are zeroed in parallel by the
+ *   threads of the global \ref SPLThreadPool, such that on NUMA systems
+ *   the pages are spread over the nodes of these threads instead of all
+ *   being placed on the node of the allocating thread. The chunks of
+ *   \ref SPLThreadPool::parallelFor are distributed dynamically, i.e. a
+ *   page is not necessarily placed on the node of the thread which
+ *   later processes it.
+ *
+ * Temporaries of processing pipelines avoid the system allocator with
+ * - \ref SPLArena: allocations from large chunks which are freed in bulk,
+ * - \ref SPLMemoryPool: buffers in size classes which are recycled, e.g.
+ *   the volume sized scratch grids of consecutive stages.
+ *
+ * Example
+ * \code
+ * SPLMemoryPool scratch;
+ * for (...)
+ * {
+ *     SPLGridf tmp;
+ *     tmp.resize(size, SPL_GRID_BRICKED, 8, scratch);	// recycled after the first stage
+ *     ...
+ * }	// tmp returns its memory to the pool
+ * const SPLMemoryStats s = splMemoryGetStats();
+ * printf("peak %lld MB\n", (long long)(s.peak >> 20));
+ * \endcode
+ * */
+
+/*! \class SPLMemoryStats
+ * \brief Counters of the allocations, see \ref splMemoryGetStats.
+ */
+struct SPLMemoryStats
+{
+	SPLint64 allocations;	//!< Number of allocations from the system.
+	SPLint64 frees;			//!< Number of buffers returned to the system.
+	SPLint64 bytes;			//!< Bytes currently allocated from the system.
+	SPLint64 peak;			//!< Maximum of \c bytes, see \ref splMemoryResetPeak.
+	SPLint64 hugeBytes;		//!< Bytes of \c bytes advised to be backed by huge pages.
+	SPLint64 poolHits;		//!< Allocations of pools served by recycled buffers.
+	SPLint64 poolMisses;	//!< Allocations of pools served by the system.
+	SPLint64 poolCached;	//!< Bytes of \c bytes kept by pools for reuse.
+	SPLint64 arenaBytes;	//!< Bytes of \c bytes in the chunks of arenas.
+	SPLint64 arenaUsed;		//!< Bytes of the chunks of arenas currently handed out.
+};
+
+namespace SPLMemoryDetail
+{
+	//! Stored in front of every buffer of splMemoryAlloc().
+	struct Header
+	{
+		SPLvoidp base;		//!< The system allocation.
+		SPLint64 size;		//!< Requested number of bytes.
+		SPLint64 total;		//!< Number of bytes of the system allocation.
+		bool huge;			//!< Set if advised for huge pages.
+	};
+
+	//! The global counters.
+	struct Counters
+	{
+		std::atomic<SPLint64> allocations, frees, bytes, peak, hugeBytes, poolHits, poolMisses, poolCached, arenaBytes, arenaUsed;
+	};
+
+	inline Counters& counters(void) throw()
+	{
+		static Counters c;
+		return c;
+	}
+
+	//! A global option, initialized by an environment variable.
+	inline std::atomic<bool>& option(const SPLindex index) throw()
+	{
+		static std::atomic<bool> options[2] = { { getenv("SPL_HUGE_PAGES") != 0 && atoi(getenv("SPL_HUGE_PAGES")) != 0 },
+												{ getenv("SPL_FIRST_TOUCH") != 0 && atoi(getenv("SPL_FIRST_TOUCH")) != 0 } };
+		return options[index];
+	}
+
+	inline Header* header(const SPLvoidp p) throw()
+	{
+		return (Header *)((SPLuint8 *)p - sizeof(Header));
+	}
+
+	inline void add(std::atomic<SPLint64> &counter, const SPLint64 value) throw()
+	{
+		counter.fetch_add(value, std::memory_order_relaxed);
+	}
+
+	//! Zeroes memory, in parallel chunks of pages which spread them over the NUMA nodes.
+	inline void zero(const SPLvoidp p, const SPLint64 bytes) throw()
+	{
+		if (!option(1).load(std::memory_order_relaxed) || bytes < SPL_MEMORY_HUGE_PAGE_SIZE)
+		{
+			memset(p, 0, size_t(bytes));
+			return;
+		}
+		SPLThreadPool &pool = SPLThreadPool::getGlobal();
+		const SPLint64 pages = (bytes + SPL_MEMORY_PAGE_SIZE - 1) / SPL_MEMORY_PAGE_SIZE;
+		SPLuint8 *data = (SPLuint8 *)p;
+		pool.parallelFor(0, pages, pool.getGrain(pages, 16), [&](const SPLint64 first, const SPLint64 last)
+		{
+			const SPLint64 end = MIN(last * SPL_MEMORY_PAGE_SIZE, bytes);
+			memset(data + first * SPL_MEMORY_PAGE_SIZE, 0, size_t(end - first * SPL_MEMORY_PAGE_SIZE));
+		});
+	}
+}
+
+/*! \brief Allocates aligned memory!
+ *
+ * The memory is not initialized.
+ *
+ * \param size Number of bytes.
+ * \param alignment Alignment in bytes, a power of 2 (at least \ref SPL_SIMD_ALIGNMENT is used).
+ *
+ * \return Pointer to the memory or \c 0 on failure.
+ */
+inline SPLvoidp splMemoryAlloc(const SPLint64 size, const SPLsizei alignment = SPL_SIMD_ALIGNMENT) throw()
+{
+	using namespace SPLMemoryDetail;
+	if (size < 0 || (alignment & (alignment - 1)) != 0)
+	{
+		return 0;
+	}
+	// the header is stored in the alignment in front of the buffer
+	static_assert(sizeof(Header) <= SPL_SIMD_ALIGNMENT, "header does not fit into the alignment");
+	const SPLint64 align = MAX(SPLint64(alignment), SPLint64(SPL_SIMD_ALIGNMENT));
+	const SPLint64 total = size + align;
+	const bool huge = option(0).load(std::memory_order_relaxed) && size >= SPL_MEMORY_HUGE_PAGE_SIZE;
+	const SPLint64 base = huge ? MAX(align, SPL_MEMORY_HUGE_PAGE_SIZE) : align;
+	SPLvoidp p = 0;
+#ifdef _WIN32
+	p = _aligned_malloc(size_t(total), size_t(base));
+#else
+	if (posix_memalign(&p, size_t(base), size_t(total)) != 0)
+	{
+		p = 0;
+	}
+#endif
+	if (p == 0)
+	{
+		return 0;
+	}
+	SPLuint8 *data = (SPLuint8 *)p + align;
+	Header *h = header(data);
+	h->base = p;
+	h->size = size;
+	h->total = total;
+	h->huge = false;
+#if defined(MADV_HUGEPAGE)
+	if (huge)
+	{
+		// only the huge pages inside of the allocation
+		const SPLint64 length = total / SPL_MEMORY_HUGE_PAGE_SIZE * SPL_MEMORY_HUGE_PAGE_SIZE;
+		h->huge = madvise(p, size_t(length), MADV_HUGEPAGE) == 0;
+	}
+#endif
+
+	Counters &c = counters();
+	add(c.allocations, 1);
+	add(c.hugeBytes, h->huge ? total : 0);
+	const SPLint64 bytes = c.bytes.fetch_add(total, std::memory_order_relaxed) + total;
+	SPLint64 peak = c.peak.load(std::memory_order_relaxed);
+	while (bytes > peak && !c.peak.compare_exchange_weak(peak, bytes, std::memory_order_relaxed))
+	{
+	}
+	return data;
+}
+
+/*! \brief Frees memory allocated with \ref splMemoryAlloc!
+ *
+ * \param p Pointer to the memory (may be \c 0).
+ */
+inline void splMemoryFree(const SPLvoidp p) throw()
+{
+	using namespace SPLMemoryDetail;
+	if (p == 0)
+	{
+		return;
+	}
+	const Header *h = header(p);
+	Counters &c = counters();
+	add(c.frees, 1);
+	add(c.bytes, -h->total);
+	add(c.hugeBytes, h->huge ? -h->total : 0);
+	const SPLvoidp base = h->base;
+#ifdef _WIN32
+	_aligned_free(base);
+#else
+	free(base);
+#endif
+}
+
+/*! \brief Returns the size of memory allocated with \ref splMemoryAlloc!
+ *
+ * \param p Pointer to the memory.
+ *
+ * \return The requested number of bytes.
+ */
+inline SPLint64 splMemoryGetSize(const SPLvoidp p) throw()
+{
+	return (p == 0) ? 0 : SPLMemoryDetail::header(p)->size;
+}
+
+/*! \brief Zeroes new memory!
+ *
+ * With \ref splMemorySetFirstTouch the pages of large buffers are zeroed
+ * by the threads of the global \ref SPLThreadPool, i.e. spread over
+ * their NUMA nodes, and by the calling thread otherwise.
+ *
+ * \param p Pointer to the memory.
+ * \param size Number of bytes.
+ */
+inline void splMemoryZero(const SPLvoidp p, const SPLint64 size) throw()
+{
+	if (p != 0 && size > 0)
+	{
+		SPLMemoryDetail::zero(p, size);
+	}
+}
+
+/*! \brief Enables or disables huge pages for new allocations!
+ *
+ * \param enable \c true to back allocations of at least \ref SPL_MEMORY_HUGE_PAGE_SIZE bytes by transparent huge pages.
+ */
+inline void splMemorySetHugePages(const bool enable) throw() { SPLMemoryDetail::option(0).store(enable); }
+
+/*! \brief Returns whether huge pages are enabled!
+ *
+ * \return \c true if enabled.
+ */
+inline bool splMemoryGetHugePages(void) throw() { return SPLMemoryDetail::option(0).load(); }
+
+/*! \brief Enables or disables the first touch placement of new grids!
+ *
+ * \param enable \c true to zero new buffers in parallel, see \ref splMemoryZero.
+ */
+inline void splMemorySetFirstTouch(const bool enable) throw() { SPLMemoryDetail::option(1).store(enable); }
+
+/*! \brief Returns whether the first touch placement is enabled!
+ *
+ * \return \c true if enabled.
+ */
+inline bool splMemoryGetFirstTouch(void) throw() { return SPLMemoryDetail::option(1).load(); }
+
+/*! \brief Returns the counters of the allocations!
+ *
+ * \return The counters since the start of the program.
+ */
+inline SPLMemoryStats splMemoryGetStats(void) throw()
+{
+	const SPLMemoryDetail::Counters &c = SPLMemoryDetail::counters();
+	SPLMemoryStats s;
+	s.allocations = c.allocations.load();
+	s.frees = c.frees.load();
+	s.bytes = c.bytes.load();
+	s.peak = c.peak.load();
+	s.hugeBytes = c.hugeBytes.load();
+	s.poolHits = c.poolHits.load();
+	s.poolMisses = c.poolMisses.load();
+	s.poolCached = c.poolCached.load();
+	s.arenaBytes = c.arenaBytes.load();
+	s.arenaUsed = c.arenaUsed.load();
+	return s;
+}
+
+/*! \brief Resets the peak to the bytes currently allocated!
+ *
+ * E.g. to measure the peak of a single stage.
+ */
+inline void splMemoryResetPeak(void) throw()
+{
+	SPLMemoryDetail::Counters &c = SPLMemoryDetail::counters();
+	c.peak.store(c.bytes.load());
+}
+
+/*! \class SPLArena
+ * \brief Memory of a pipeline which is freed in bulk.
+ *
+ * Allocations are carved from chunks of \ref splMemoryAlloc and are not
+ * freed individually: \ref reset frees all of them at once and keeps the
+ * chunks for the next run of the pipeline, \ref release returns the chunks
+ * to the system. The arena is thread safe.
+ *
+ * Example
+ * \code
+ * SPLArena arena;
+ * for (each volume)
+ * {
+ *     SPLGridf gradient;
+ *     gradient.resize(size, SPL_GRID_BRICKED, 8, arena);
+ *     SPLieee32 *histogram = arena.allocate<SPLieee32>(4096);
+ *     ...
+ *     arena.reset();	// after the grids of the arena are destroyed or resized
+ * }
+ * \endcode
+ */
+class SPLArena
+{
+public:
+	/*! \brief Constructor!
+	 *
+	 * No memory is allocated before the first allocation.
+	 *
+	 * \param chunk Size in bytes of the chunks (larger allocations get a chunk of their own).
+	 */
+	explicit SPLArena(const SPLint64 chunk = SPL_ARENA_CHUNK_SIZE) throw();
+
+	/*! \brief Destructor!
+	 *
+	 * Returns the chunks to the system.
+	 */
+	~SPLArena(void) throw();
+
+	/*! \brief Allocates memory!
+	 *
+	 * The memory is not initialized and is valid until \ref reset or \ref release.
+	 *
+	 * \param size Number of bytes.
+	 * \param alignment Alignment in bytes, a power of 2 up to \ref SPL_MEMORY_PAGE_SIZE.
+	 *
+	 * \return Pointer to the memory or \c 0 on failure.
+	 */
+	SPLvoidp allocate(const SPLint64 size, const SPLsizei alignment = SPL_SIMD_ALIGNMENT) throw();
+
+	/*! \brief Allocates an array!
+	 *
+	 * \param n Number of elements.
+	 *
+	 * \return Pointer to \f$ n \f$ uninitialized elements aligned to \ref SPL_SIMD_ALIGNMENT or \c 0 on failure.
+	 */
+	template <class T>
+	T* allocate(const SPLint64 n) throw() { return (T *)this->allocate(n * SPLint64(sizeof(T)), MAX(SPLsizei(alignof(T)), SPL_SIMD_ALIGNMENT)); }
+
+	/*! \brief Frees all allocations!
+	 *
+	 * The chunks are kept for the next allocations.
+	 */
+	void reset(void) throw();
+
+	/*! \brief Frees all allocations and returns the chunks to the system!
+	 */
+	void release(void) throw();
+
+	/*! \brief Returns the bytes handed out!
+	 *
+	 * \return Number of bytes including the alignment since the last \ref reset.
+	 */
+	SPLint64 getUsed(void) const throw() { return this->used; }
+
+	/*! \brief Returns the size of the chunks!
+	 *
+	 * \return Number of bytes of all chunks.
+	 */
+	SPLint64 getCapacity(void) const throw() { return this->capacity; }
+
+private:
+	SPLArena(const SPLArena &);
+	SPLArena& operator = (const SPLArena &);
+
+	//! A block of memory of splMemoryAlloc().
+	struct Chunk
+	{
+		SPLuint8 *data;		//!< The memory.
+		SPLint64 size;		//!< Number of bytes.
+	};
+
+	std::vector<Chunk> chunks;	//!< The chunks, the current one and those after it are free.
+	size_t current;				//!< Index of the chunk of the next allocation.
+	SPLint64 offset;			//!< First free byte of the current chunk.
+	SPLint64 used;				//!< Bytes handed out.
+	SPLint64 capacity;			//!< Bytes of all chunks.
+	SPLint64 chunk;				//!< Default size of new chunks.
+	std::mutex mutex;			//!< Serializes the allocations.
+};
+
+/*! \class SPLMemoryPool
+ * \brief Recycles large buffers between the stages of a pipeline.
+ *
+ * Requests are rounded up to size classes (a quarter of a power of 2,
+ * i.e. at most 25% larger) and freed buffers are kept in a list per class,
+ * such that the next request of the class is served without a system
+ * call and without page faults. Buffers beyond the limit of cached bytes
+ * are returned to the system. The pool is thread safe.
+ *
+ * Buffers must be returned to the pool which allocated them, before the
+ * pool is destroyed.
+ */
+class SPLMemoryPool
+{
+public:
+	/*! \brief Constructor!
+	 *
+	 * \param limit Maximum number of cached bytes, or \f$ -1 \f$ for no limit.
+	 */
+	explicit SPLMemoryPool(const SPLint64 limit = -1) throw();
+
+	/*! \brief Destructor!
+	 *
+	 * Returns the cached buffers to the system, see \ref trim.
+	 */
+	~SPLMemoryPool(void) throw();
+
+	/*! \brief Allocates a buffer!
+	 *
+	 * The memory is not initialized and aligned to \ref SPL_SIMD_ALIGNMENT.
+	 *
+	 * \param size Number of bytes.
+	 *
+	 * \return Pointer to the memory or \c 0 on failure.
+	 */
+	SPLvoidp allocate(const SPLint64 size) throw();
+
+	/*! \brief Returns a buffer to the pool!
+	 *
+	 * \param p Pointer to a buffer of \ref allocate (may be \c 0).
+	 */
+	void deallocate(const SPLvoidp p) throw();
+
+	/*! \brief Returns all cached buffers to the system!
+	 */
+	void trim(void) throw();
+
+	/*! \brief Changes the maximum number of cached bytes!
+	 *
+	 * Cached buffers beyond the limit are returned to the system.
+	 *
+	 * \param limit Number of bytes, or \f$ -1 \f$ for no limit.
+	 */
+	void setLimit(const SPLint64 limit) throw();
+
+	/*! \brief Returns the maximum number of cached bytes!
+	 *
+	 * \return Number of bytes, or \f$ -1 \f$ for no limit.
+	 */
+	SPLint64 getLimit(void) const throw() { return this->limit; }
+
+	/*! \brief Returns the cached bytes!
+	 *
+	 * \return Number of bytes of the buffers which wait for reuse.
+	 */
+	SPLint64 getCached(void) const throw() { return this->cached; }
+
+	/*! \brief Returns the size class of a request!
+	 *
+	 * \param size Number of bytes.
+	 *
+	 * \return Number of bytes of the buffers of the class.
+	 */
+	static SPLint64 getSizeClass(const SPLint64 size) throw();
+
+	/*! \brief Returns the pool shared by the library!
+	 *
+	 * \return Reference of the global pool.
+	 */
+	static SPLMemoryPool& getGlobal(void) throw();
+
+private:
+	SPLMemoryPool(const SPLMemoryPool &);
+	SPLMemoryPool& operator = (const SPLMemoryPool &);
+
+	void shrink(void) throw();
+
+	std::map<SPLint64, std::vector<SPLvoidp> > free;	//!< The cached buffers per size class.
+	SPLint64 cached;			//!< Bytes of the cached buffers.
+	SPLint64 limit;				//!< Maximum of cached.
+	std::mutex mutex;			//!< Protects the lists.
+};
+
+/************************************************************************************************
+ ** SPLArena class implementation
+ ************************************************************************************************/
+inline SPLArena::SPLArena(const SPLint64 chunk) throw()
+	: current(0), offset(0), used(0), capacity(0), chunk(MAX(chunk, SPLint64(SPL_MEMORY_PAGE_SIZE)))
+{
+}
+
+inline SPLArena::~SPLArena(void) throw()
+{
+	this->release();
+}
+
+inline SPLvoidp SPLArena::allocate(const SPLint64 size, const SPLsizei alignment) throw()
+{
+	if (size < 0 || alignment <= 0 || alignment > SPL_MEMORY_PAGE_SIZE || (alignment & (alignment - 1)) != 0)
+	{
+		return 0;
+	}
+	std::lock_guard<std::mutex> lock(this->mutex);
+	const SPLint64 mask = SPLint64(alignment) - 1;
+	while (this->current < this->chunks.size())
+	{
+		const Chunk &c = this->chunks[this->current];
+		const SPLint64 first = (this->offset + mask) & ~mask;
+		if (first + size <= c.size)
+		{
+			this->used += first + size - this->offset;
+			SPLMemoryDetail::add(SPLMemoryDetail::counters().arenaUsed, first + size - this->offset);
+			this->offset = first + size;
+			return c.data + first;
+		}
+		// the rest of the chunk stays unused until the next reset
+		this->current++;
+		this->offset = 0;
+	}
+
+	// chunks are page aligned
+	Chunk c;
+	c.size = MAX(this->chunk, (size + SPL_MEMORY_PAGE_SIZE - 1) / SPL_MEMORY_PAGE_SIZE * SPL_MEMORY_PAGE_SIZE);
+	c.data = (SPLuint8 *)splMemoryAlloc(c.size, SPL_MEMORY_PAGE_SIZE);
+	if (c.data == 0)
+	{
+		return 0;
+	}
+	this->chunks.push_back(c);
+	this->current = this->chunks.size() - 1;
+	this->capacity += c.size;
+	this->used += size;
+	this->offset = size;
+	SPLMemoryDetail::add(SPLMemoryDetail::counters().arenaBytes, c.size);
+	SPLMemoryDetail::add(SPLMemoryDetail::counters().arenaUsed, size);
+	return c.data;
+}
+
+inline void SPLArena::reset(void) throw()
+{
+	std::lock_guard<std::mutex> lock(this->mutex);
+	SPLMemoryDetail::add(SPLMemoryDetail::counters().arenaUsed, -this->used);
+	this->current = 0;
+	this->offset = 0;
+	this->used = 0;
+}
+
+inline void SPLArena::release(void) throw()
+{
+	this->reset();
+	std::lock_guard<std::mutex> lock(this->mutex);
+	for (size_t i = 0; i < this->chunks.size(); i++)
+	{
+		splMemoryFree(this->chunks[i].data);
+	}
+	SPLMemoryDetail::add(SPLMemoryDetail::counters().arenaBytes, -this->capacity);
+	this->chunks.clear();
+	this->capacity = 0;
+}
+
+/************************************************************************************************
+ ** SPLMemoryPool class implementation
+ ************************************************************************************************/
+inline SPLMemoryPool::SPLMemoryPool(const SPLint64 limit) throw()
+	: cached(0), limit(limit)
+{
+}
+
+inline SPLMemoryPool::~SPLMemoryPool(void) throw()
+{
+	this->trim();
+}
+
+inline SPLint64 SPLMemoryPool::getSizeClass(const SPLint64 size) throw()
+{
+	if (size <= SPL_MEMORY_PAGE_SIZE)
+	{
+		return MAX((size + SPL_SIMD_ALIGNMENT - 1) / SPL_SIMD_ALIGNMENT * SPL_SIMD_ALIGNMENT, SPLint64(SPL_SIMD_ALIGNMENT));
+	}
+	// quarters of the largest power of 2 not above the size
+	SPLint64 power = SPL_MEMORY_PAGE_SIZE;
+	while (power <= size / 2)
+	{
+		power *= 2;
+	}
+	const SPLint64 step = power / 4;
+	return (size + step - 1) / step * step;
+}
+
+inline SPLvoidp SPLMemoryPool::allocate(const SPLint64 size) throw()
+{
+	if (size < 0)
+	{
+		return 0;
+	}
+	const SPLint64 c = getSizeClass(size);
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		std::map<SPLint64, std::vector<SPLvoidp> >::iterator it = this->free.find(c);
+		if (it != this->free.end() && !it->second.empty())
+		{
+			const SPLvoidp p = it->second.back();
+			it->second.pop_back();
+			this->cached -= c;
+			SPLMemoryDetail::add(SPLMemoryDetail::counters().poolCached, -c);
+			SPLMemoryDetail::add(SPLMemoryDetail::counters().poolHits, 1);
+			return p;
+		}
+	}
+	SPLMemoryDetail::add(SPLMemoryDetail::counters().poolMisses, 1);
+	return splMemoryAlloc(c);
+}
+
+inline void SPLMemoryPool::deallocate(const SPLvoidp p) throw()
+{
+	if (p == 0)
+	{
+		return;
+	}
+	const SPLint64 c = splMemoryGetSize(p);
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		if (this->limit < 0 || this->cached + c <= this->limit)
+		{
+			this->free[c].push_back(p);
+			this->cached += c;
+			SPLMemoryDetail::add(SPLMemoryDetail::counters().poolCached, c);
+			return;
+		}
+	}
+	splMemoryFree(p);
+}
+
+inline void SPLMemoryPool::trim(void) throw()
+{
+	std::lock_guard<std::mutex> lock(this->mutex);
+	for (std::map<SPLint64, std::vector<SPLvoidp> >::iterator it = this->free.begin(); it != this->free.end(); ++it)
+	{
+		for (size_t i = 0; i < it->second.size(); i++)
+		{
+			splMemoryFree(it->second[i]);
+		}
+	}
+	SPLMemoryDetail::add(SPLMemoryDetail::counters().poolCached, -this->cached);
+	this->free.clear();
+	this->cached = 0;
+}
+
+inline void SPLMemoryPool::setLimit(const SPLint64 limit) throw()
+{
+	std::lock_guard<std::mutex> lock(this->mutex);
+	this->limit = limit;
+	this->shrink();
+}
+
+inline void SPLMemoryPool::shrink(void) throw()
+{
+	// the largest buffers first
+	std::map<SPLint64, std::vector<SPLvoidp> >::reverse_iterator it = this->free.rbegin();
+	while (this->limit >= 0 && this->cached > this->limit && it != this->free.rend())
+	{
+		if (it->second.empty())
+		{
+			++it;
+			continue;
+		}
+		splMemoryFree(it->second.back());
+		it->second.pop_back();
+		this->cached -= it->first;
+		SPLMemoryDetail::add(SPLMemoryDetail::counters().poolCached, -it->first);
+	}
+}
+
+inline SPLMemoryPool& SPLMemoryPool::getGlobal(void) throw()
+{
+	static SPLMemoryPool pool;
+	return pool;
+}
+
+#endif /* _spl_allocator_hh_ */
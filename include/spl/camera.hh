@@ -0,0 +1,260 @@
+#ifndef _spl_camera_hh_
+#define _spl_camera_hh_
+
+#include <cmath>
+
+#include <spl/typesbase.hh>
+#include <spl/mathbase.hh>
+#include <spl/vector3.hh>
+#include <spl/vector4.hh>
+#include <spl/matrix4.hh>
+
+/*! \file camera.hh
+ * */
+
+/*! \class SPLCamera
+ * \brief A camera with the matrices of the OpenGL pipeline.
+ *
+ * The camera holds one matrix per \c SPL_CAMERA_MATRIX_* identification
+ * number:
+ *
+ * - \ref SPL_CAMERA_MATRIX_MODELVIEW: world to eye coordinates, see \ref setLookAt.
+ * - \ref SPL_CAMERA_MATRIX_ORTHO or \ref SPL_CAMERA_MATRIX_FRUSTUM: eye to
+ *   normalized device coordinates, see \ref setOrtho, \ref setFrustum and
+ *   \ref setPerspective. The last one set is the projection of the camera.
+ * - \ref SPL_CAMERA_MATRIX_VIEWPORT: normalized device to window
+ *   coordinates, see \ref setViewport.
+ *
+ * The conventions are those of OpenGL, i.e. the eye looks along \f$ -z \f$
+ * and the window origin is the lower left corner.
+ *
+ * Example
+ * \code
+ * SPLCamera c;
+ * c.setLookAt(SPLVector3f(0.0f, 0.0f, 5.0f), SPLVector3f(0.0f, 0.0f, 0.0f), SPLVector3f(0.0f, 1.0f, 0.0f));
+ * c.setPerspective(45.0f, 4.0f / 3.0f, 0.1f, 100.0f);
+ * c.setViewport(0, 0, 640, 480);
+ *
+ * // the ray through a pixel in object coordinates
+ * const SPLMatrix4f u = c.getUnprojection(model);
+ * SPLVector3f origin, direction;
+ * c.getRay(u, 320.5f, 240.5f, origin, direction);
+ * \endcode
+ *
+ * \sa SPLRayCaster SPLMatrix4
+ */
+class SPLCamera
+{
+public:
+	/*! \brief Constructor!
+	 *
+	 * Initializes the identity modelview, an orthographic projection of
+	 * the cube \f$ [-1, 1]^3 \f$ and a viewport of \f$ 1 \times 1 \f$ pixels.
+	 */
+	SPLCamera(void) throw();
+
+	/*! \brief Sets a matrix!
+	 *
+	 * Setting \ref SPL_CAMERA_MATRIX_ORTHO or \ref SPL_CAMERA_MATRIX_FRUSTUM
+	 * selects the projection.
+	 *
+	 * \param type A \c SPL_CAMERA_MATRIX_* identification number.
+	 * \param m The matrix.
+	 */
+	void setMatrix(const SPLenum type, const SPLMatrix4f &m) throw();
+
+	/*! \brief Returns a matrix!
+	 *
+	 * \param type A \c SPL_CAMERA_MATRIX_* identification number.
+	 *
+	 * \return The matrix.
+	 */
+	const SPLMatrix4f& getMatrix(const SPLenum type) const throw();
+
+	/*! \brief Returns the projection!
+	 *
+	 * \return \ref SPL_CAMERA_MATRIX_ORTHO or \ref SPL_CAMERA_MATRIX_FRUSTUM.
+	 */
+	SPLenum getProjection(void) const throw() { return this->projection; }
+
+	/*! \brief Sets the modelview matrix of an eye!
+	 *
+	 * Like \c gluLookAt().
+	 *
+	 * \param eye Position of the eye.
+	 * \param center The point the eye looks at.
+	 * \param up The up direction (not parallel to the view direction).
+	 */
+	void setLookAt(const SPLVector3f &eye, const SPLVector3f &center, const SPLVector3f &up) throw();
+
+	/*! \brief Sets an orthographic projection!
+	 *
+	 * Like \c glOrtho().
+	 *
+	 * \param left Left clipping plane.
+	 * \param right Right clipping plane.
+	 * \param bottom Bottom clipping plane.
+	 * \param top Top clipping plane.
+	 * \param zNear Distance of the near clipping plane.
+	 * \param zFar Distance of the far clipping plane.
+	 */
+	void setOrtho(const SPLieee32 left, const SPLieee32 right, const SPLieee32 bottom, const SPLieee32 top,
+				  const SPLieee32 zNear, const SPLieee32 zFar) throw();
+
+	/*! \brief Sets a perspective projection!
+	 *
+	 * Like \c glFrustum().
+	 *
+	 * \param left Left clipping plane at the near plane.
+	 * \param right Right clipping plane at the near plane.
+	 * \param bottom Bottom clipping plane at the near plane.
+	 * \param top Top clipping plane at the near plane.
+	 * \param zNear Distance of the near clipping plane (positive).
+	 * \param zFar Distance of the far clipping plane (positive).
+	 */
+	void setFrustum(const SPLieee32 left, const SPLieee32 right, const SPLieee32 bottom, const SPLieee32 top,
+					const SPLieee32 zNear, const SPLieee32 zFar) throw();
+
+	/*! \brief Sets a perspective projection!
+	 *
+	 * Like \c gluPerspective().
+	 *
+	 * \param fovy Field of view along y in degrees.
+	 * \param aspect Width divided by height.
+	 * \param zNear Distance of the near clipping plane (positive).
+	 * \param zFar Distance of the far clipping plane (positive).
+	 */
+	void setPerspective(const SPLieee32 fovy, const SPLieee32 aspect, const SPLieee32 zNear, const SPLieee32 zFar) throw();
+
+	/*! \brief Sets the viewport!
+	 *
+	 * \param x Left window coordinate.
+	 * \param y Bottom window coordinate.
+	 * \param width Width in pixels.
+	 * \param height Height in pixels.
+	 */
+	void setViewport(const SPLint32 x, const SPLint32 y, const SPLint32 width, const SPLint32 height) throw();
+
+	/*! \brief Returns the viewport!
+	 *
+	 * \return Left and bottom window coordinate, width and height.
+	 */
+	const SPLVector4i& getViewport(void) const throw() { return this->viewport; }
+
+	/*! \brief Returns the transformation from window to object coordinates!
+	 *
+	 * \param model Object to world coordinates.
+	 *
+	 * \return The inverse of viewport, projection, modelview and model matrix.
+	 */
+	SPLMatrix4f getUnprojection(const SPLMatrix4f &model = SPLMatrix4f()) const throw();
+
+	/*! \brief Returns the ray through a window position!
+	 *
+	 * The ray starts at the near plane. Its direction points to the far
+	 * plane and has the length of the segment between both planes.
+	 *
+	 * \param unprojection The matrix of \ref getUnprojection.
+	 * \param x Window coordinate (\f$ x + 0.5 \f$ for the center of a pixel).
+	 * \param y Window coordinate.
+	 * \param origin The point at the near plane.
+	 * \param direction From the near to the far plane.
+	 */
+	static void getRay(const SPLMatrix4f &unprojection, const SPLieee32 x, const SPLieee32 y, SPLVector3f &origin, SPLVector3f &direction) throw();
+
+private:
+	SPLMatrix4f matrices[SPL_CAMERA_MAX - SPL_CAMERA_MIN - 1];	//!< The matrices.
+	SPLenum projection;		//!< The projection.
+	SPLVector4i viewport;	//!< The viewport.
+};
+
+/************************************************************************************************
+ ** SPLCamera class implementation
+ ************************************************************************************************/
+inline SPLCamera::SPLCamera(void) throw()
+{
+	this->setOrtho(-1.0f, 1.0f, -1.0f, 1.0f, -1.0f, 1.0f);
+	this->setViewport(0, 0, 1, 1);
+}
+
+inline void SPLCamera::setMatrix(const SPLenum type, const SPLMatrix4f &m) throw()
+{
+	assert(type > SPL_CAMERA_MIN && type < SPL_CAMERA_MAX);
+	this->matrices[type - SPL_CAMERA_MIN - 1] = m;
+	if (type == SPL_CAMERA_MATRIX_ORTHO || type == SPL_CAMERA_MATRIX_FRUSTUM)
+	{
+		this->projection = type;
+	}
+}
+
+inline const SPLMatrix4f& SPLCamera::getMatrix(const SPLenum type) const throw()
+{
+	assert(type > SPL_CAMERA_MIN && type < SPL_CAMERA_MAX);
+	return this->matrices[type - SPL_CAMERA_MIN - 1];
+}
+
+inline void SPLCamera::setLookAt(const SPLVector3f &eye, const SPLVector3f &center, const SPLVector3f &up) throw()
+{
+	const SPLVector3f f = (center - eye).getNormalized(1.0f);
+	const SPLVector3f s = f.crossProduct(up).getNormalized(1.0f);
+	const SPLVector3f u = s.crossProduct(f);
+	this->setMatrix(SPL_CAMERA_MATRIX_MODELVIEW, SPLMatrix4f(
+		s.x, s.y, s.z, -(s * eye),
+		u.x, u.y, u.z, -(u * eye),
+		-f.x, -f.y, -f.z, f * eye,
+		0.0f, 0.0f, 0.0f, 1.0f));
+}
+
+inline void SPLCamera::setOrtho(const SPLieee32 left, const SPLieee32 right, const SPLieee32 bottom, const SPLieee32 top,
+								const SPLieee32 zNear, const SPLieee32 zFar) throw()
+{
+	const SPLieee32 w = right - left, h = top - bottom, d = zFar - zNear;
+	this->setMatrix(SPL_CAMERA_MATRIX_ORTHO, SPLMatrix4f(
+		2.0f / w, 0.0f, 0.0f, -(right + left) / w,
+		0.0f, 2.0f / h, 0.0f, -(top + bottom) / h,
+		0.0f, 0.0f, -2.0f / d, -(zFar + zNear) / d,
+		0.0f, 0.0f, 0.0f, 1.0f));
+}
+
+inline void SPLCamera::setFrustum(const SPLieee32 left, const SPLieee32 right, const SPLieee32 bottom, const SPLieee32 top,
+								  const SPLieee32 zNear, const SPLieee32 zFar) throw()
+{
+	const SPLieee32 w = right - left, h = top - bottom, d = zFar - zNear;
+	this->setMatrix(SPL_CAMERA_MATRIX_FRUSTUM, SPLMatrix4f(
+		2.0f * zNear / w, 0.0f, (right + left) / w, 0.0f,
+		0.0f, 2.0f * zNear / h, (top + bottom) / h, 0.0f,
+		0.0f, 0.0f, -(zFar + zNear) / d, -2.0f * zFar * zNear / d,
+		0.0f, 0.0f, -1.0f, 0.0f));
+}
+
+inline void SPLCamera::setPerspective(const SPLieee32 fovy, const SPLieee32 aspect, const SPLieee32 zNear, const SPLieee32 zFar) throw()
+{
+	const SPLieee32 top = zNear * std::tan(fovy * 3.14159265358979f / 360.0f);
+	this->setFrustum(-top * aspect, top * aspect, -top, top, zNear, zFar);
+}
+
+inline void SPLCamera::setViewport(const SPLint32 x, const SPLint32 y, const SPLint32 width, const SPLint32 height) throw()
+{
+	assert(width > 0 && height > 0);
+	this->viewport = SPLVector4i(x, y, width, height);
+	const SPLieee32 w = 0.5f * SPLieee32(width), h = 0.5f * SPLieee32(height);
+	this->setMatrix(SPL_CAMERA_MATRIX_VIEWPORT, SPLMatrix4f(
+		w, 0.0f, 0.0f, SPLieee32(x) + w,
+		0.0f, h, 0.0f, SPLieee32(y) + h,
+		0.0f, 0.0f, 0.5f, 0.5f,
+		0.0f, 0.0f, 0.0f, 1.0f));
+}
+
+inline SPLMatrix4f SPLCamera::getUnprojection(const SPLMatrix4f &model) const throw()
+{
+	return (this->getMatrix(SPL_CAMERA_MATRIX_VIEWPORT) * this->getMatrix(this->projection) *
+			this->getMatrix(SPL_CAMERA_MATRIX_MODELVIEW) * model).getInverse();
+}
+
+inline void SPLCamera::getRay(const SPLMatrix4f &unprojection, const SPLieee32 x, const SPLieee32 y, SPLVector3f &origin, SPLVector3f &direction) throw()
+{
+	origin = unprojection.transformPoint(SPLVector3f(x, y, 0.0f));
+	direction = unprojection.transformPoint(SPLVector3f(x, y, 1.0f)) - origin;
+}
+
+#endif /* _spl_camera_hh_ */
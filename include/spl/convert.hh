@@ -0,0 +1,257 @@
+#ifndef _spl_convert_hh_
+#define _spl_convert_hh_
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+#include <spl/typesbase.hh>
+#include <spl/mathbase.hh>
+#include <spl/threadpool.hh>
+#include <spl/simd.hh>
+#include <spl/vector3.hh>
+#include <spl/grid.hh>
+#include <spl/dispatch.hh>
+
+#define SPL_CONVERT_CHUNK 512	//!< Number of values of the float buffer of the conversions of half precision without F16C at compile time.
+
+/*! \file convert.hh
+ * \brief Conversions between the storage types.
+ *
+ * A value \f$ s \f$ is converted to \f$ d = a s + b \f$, which is rounded
+ * to the nearest integer (ties to even) and saturated to the range of
+ * integer types. Conversions between \ref SPLuint8, \ref SPLint8,
+ * \ref SPLuint16, \ref SPLint16, \ref SPLieee32 and the compact types of
+ * half.hh run on the registers of \c SPLSimd<SPLieee32> in single precision,
+ * see \ref SPLSimdConvert, all other pairs element by element in double
+ * precision. In builds without the F16C instructions \ref SPLieee16 is
+ * converted in chunks through a buffer of floats, with F16C if the
+ * processor has it (see half.hh).
+ * */
+
+namespace SPLConvertDetail
+{
+	//! Whether a type is converted on the registers of \c SPLSimd<SPLieee32>.
+	template <class T>
+	struct Simd
+	{
+		static const bool value = std::is_same<T, SPLieee32>::value || std::is_same<T, SPLuint8>::value ||
+								  std::is_same<T, SPLint8>::value || std::is_same<T, SPLuint16>::value ||
+								  std::is_same<T, SPLint16>::value || std::is_same<T, SPLunorm8>::value ||
+								  std::is_same<T, SPLunorm16>::value
+#if defined(SPL_HALF_SIMD)
+								  || std::is_same<T, SPLieee16>::value
+#endif
+								  ;
+	};
+
+	//! Whether a pair of types is converted through a float buffer with the half conversions of the processor.
+	template <class S, class D>
+	struct Staged
+	{
+#if defined(SPL_HALF_DISPATCH)
+		static const bool value = (std::is_same<S, SPLieee16>::value && (Simd<D>::value || std::is_same<D, SPLieee16>::value)) ||
+								  (Simd<S>::value && std::is_same<D, SPLieee16>::value);
+#else
+		static const bool value = false;
+#endif
+	};
+
+	//! Rounds a value to the nearest value of the type, saturated for integer types.
+	template <class D, class V>
+	inline D saturate(const V v) throw()
+	{
+		if constexpr (std::numeric_limits<D>::is_integer)
+		{
+			// the limits of 32 and 64 bit integers round up to the next power of 2
+			if (!(v > V(std::numeric_limits<D>::min())))
+			{
+				return std::numeric_limits<D>::min();
+			}
+			if (v >= V(std::numeric_limits<D>::max()))
+			{
+				return std::numeric_limits<D>::max();
+			}
+			return D(std::nearbyint(v));
+		}
+		else
+		{
+			return D(v);
+		}
+	}
+
+	//! Converts the elements \f$ [first, last) \f$.
+	template <class S, class D>
+	void convert(const S *src, D *dst, const SPLint64 first, const SPLint64 last, const SPLieee64 scale, const SPLieee64 offset) throw()
+	{
+		if constexpr (Simd<S>::value && Simd<D>::value)
+		{
+			const SPLieee32 a = SPLieee32(scale), b = SPLieee32(offset);
+			const S *s = src + first;
+			D *d = dst + first;
+			splSimdForEach<SPLieee32>(SPLsizei(last - first), [&](auto simd, const SPLindex i)
+			{
+				typedef decltype(simd) R;
+				if constexpr (R::width == 1)
+				{
+					d[i] = saturate<D>(SPLieee32(s[i]) * a + b);
+				}
+				else
+				{
+					typename R::Type v;
+					if constexpr (std::is_same<S, SPLieee32>::value)
+					{
+						v = R::load(s + i);
+					}
+					else
+					{
+						v = SPLSimdConvert<S>::load(s + i);
+					}
+					v = R::add(R::mul(v, R::set(a)), R::set(b));
+					if constexpr (std::is_same<D, SPLieee32>::value)
+					{
+						R::store(d + i, v);
+					}
+					else
+					{
+						SPLSimdConvert<D>::store(d + i, v);
+					}
+				}
+			});
+		}
+		else if constexpr (Staged<S, D>::value)
+		{
+			// in single precision as on the registers of SPLSimd
+			const SPLieee32 a = SPLieee32(scale), b = SPLieee32(offset);
+			alignas(SPL_SIMD_ALIGNMENT) SPLieee32 buffer[SPL_CONVERT_CHUNK];
+			for (SPLint64 c = first; c < last; c += SPL_CONVERT_CHUNK)
+			{
+				const SPLint64 m = MIN(last - c, SPLint64(SPL_CONVERT_CHUNK));
+				if constexpr (std::is_same<S, SPLieee16>::value)
+				{
+					SPLHalfDetail::toFloat((const SPLuint16 *)(src + c), buffer, m);
+				}
+				else
+				{
+					for (SPLint64 i = 0; i < m; i++)
+					{
+						buffer[i] = SPLieee32(src[c + i]);
+					}
+				}
+				for (SPLint64 i = 0; i < m; i++)
+				{
+					buffer[i] = buffer[i] * a + b;
+				}
+				if constexpr (std::is_same<D, SPLieee16>::value)
+				{
+					SPLHalfDetail::fromFloat(buffer, (SPLuint16 *)(dst + c), m);
+				}
+				else
+				{
+					for (SPLint64 i = 0; i < m; i++)
+					{
+						dst[c + i] = saturate<D>(buffer[i]);
+					}
+				}
+			}
+		}
+		else
+		{
+			for (SPLint64 i = first; i < last; i++)
+			{
+				dst[i] = saturate<D>(SPLieee64(src[i]) * scale + offset);
+			}
+		}
+	}
+}
+
+/*! \brief Converts an array!
+ *
+ * Example
+ * \code
+ * // Hounsfield units of 12 bit CT values
+ * splConvert(raw, hu, n, 1.0, -1024.0);
+ * \endcode
+ *
+ * \param src The \f$ n \f$ values.
+ * \param dst The \f$ n \f$ converted values, \f$ d_i = a s_i + b \f$ (output).
+ * \param n Number of values.
+ * \param scale The factor \f$ a \f$.
+ * \param offset The summand \f$ b \f$.
+ * \param pool The threads.
+ */
+template <class S, class D>
+void splConvert(const S *src, D *dst, const SPLint64 n, const SPLieee64 scale = 1.0, const SPLieee64 offset = 0.0,
+				SPLThreadPool &pool = SPLThreadPool::getGlobal()) throw()
+{
+	const bool copy = std::is_same<S, D>::value && scale == 1.0 && offset == 0.0;
+	pool.parallelFor(0, n, pool.getGrain(n, 16384), [&](const SPLint64 first, const SPLint64 last)
+	{
+		if (copy)
+		{
+			memcpy((void *)(dst + first), (const void *)(src + first), size_t(last - first) * sizeof(S));
+		}
+		else
+		{
+			SPLConvertDetail::convert(src, dst, first, last, scale, offset);
+		}
+	});
+}
+
+/*! \brief Converts an array of a storage type known at run time!
+ *
+ * Dispatches once to the conversion of the pair of types, see \ref splDispatchTypes.
+ *
+ * \param src The \f$ n \f$ values.
+ * \param srcType The \c SPL_TYPE_* identification number of the values.
+ * \param dst The \f$ n \f$ converted values (output).
+ * \param dstType The \c SPL_TYPE_* identification number of the converted values.
+ * \param n Number of values.
+ * \param scale The factor \f$ a \f$.
+ * \param offset The summand \f$ b \f$.
+ * \param pool The threads.
+ *
+ * \return \c true on success and \c false for types which are not dispatched.
+ */
+inline bool splConvert(const SPLvoid *src, const SPLenum srcType, SPLvoid *dst, const SPLenum dstType, const SPLint64 n,
+					   const SPLieee64 scale = 1.0, const SPLieee64 offset = 0.0, SPLThreadPool &pool = SPLThreadPool::getGlobal()) throw()
+{
+	return splDispatchTypes(srcType, dstType, [&](auto ts, auto td)
+	{
+		typedef typename decltype(ts)::Type S;
+		typedef typename decltype(td)::Type D;
+		splConvert((const S *)src, (D *)dst, n, scale, offset, pool);
+	});
+}
+
+/*! \brief Converts a grid!
+ *
+ * The converted grid has the size and the memory layout of the grid.
+ *
+ * \param src The grid.
+ * \param dst The converted grid, \f$ d = a s + b \f$ (output).
+ * \param scale The factor \f$ a \f$.
+ * \param offset The summand \f$ b \f$.
+ * \param pool The threads.
+ *
+ * \return \c true on success and \c false otherwise.
+ */
+template <class S, class D>
+bool splConvert(const SPLGrid<S> &src, SPLGrid<D> &dst, const SPLieee64 scale = 1.0, const SPLieee64 offset = 0.0,
+				SPLThreadPool &pool = SPLThreadPool::getGlobal()) throw()
+{
+	if ((void *)&src == (void *)&dst)
+	{
+		return false;
+	}
+	if ((dst.getSize() != src.getSize() || dst.getLayout() != src.getLayout() || dst.getBrickSize() != src.getBrickSize()) &&
+		!dst.resize(src.getSize(), src.getLayout(), src.getBrickSize()))
+	{
+		return false;
+	}
+	splConvert(src.getData(), dst.getData(), src.getStorageSize(), scale, offset, pool);
+	return true;
+}
+
+#endif /* _spl_convert_hh_ */
@@ -0,0 +1,17 @@
+#ifndef _spl_cudadefs_hh_
+#define _spl_cudadefs_hh_
+
+/*! \file cudadefs.hh
+ * \brief Definitions for code which is shared by the host and the device.
+ *
+ * \c __CUDACC__ is defined by the CUDA compiler only, i.e. the same headers
+ * compile as plain C++ when no CUDA compiler is available, see \ref launch.hh.
+ * */
+
+#ifdef __CUDACC__
+#define CUDA_CALLABLE_MEMBER __host__ __device__	//!< Marks functions callable on the host and the device.
+#else
+#define CUDA_CALLABLE_MEMBER	//!< Marks functions callable on the host and the device.
+#endif
+
+#endif /* _spl_cudadefs_hh_ */
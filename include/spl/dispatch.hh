@@ -0,0 +1,115 @@
+#ifndef _spl_dispatch_hh_
+#define _spl_dispatch_hh_
+
+#include <spl/typesbase.hh>
+#include <spl/half.hh>
+
+/*! \file dispatch.hh
+ * \brief Maps \c SPL_TYPE_* identification numbers to template instantiations.
+ *
+ * Data whose storage type is only known at run time, e.g. the voxels of
+ * a file, is processed by switching once per operation on the type and
+ * calling a generic lambda with a \ref SPLTypeTag of the storage type,
+ * such that the loops inside the lambda are compiled for the type:
+ * \code
+ * splDispatchType(header.type, [&](auto tag)
+ * {
+ *     typedef typename decltype(tag)::Type T;
+ *     SPLGrid<T> g;
+ *     ...
+ * });
+ * \endcode
+ *
+ * The scalar storage types \ref SPL_TYPE_UINT8 to \ref SPL_TYPE_IEEE128
+ * and the compact types \ref SPL_TYPE_IEEE16, \ref SPL_TYPE_UNORM8 and
+ * \ref SPL_TYPE_UNORM16 are dispatched; \ref SPL_TYPE_VOIDP and the vector
+ * types are not storage types of grids.
+ * */
+
+/*! \class SPLTypeTag
+ * \brief An empty value which carries a storage type.
+ */
+template <class T>
+struct SPLTypeTag
+{
+	typedef T Type;		//!< The storage type.
+};
+
+/*! \brief Calls a function with the tag of a storage type!
+ *
+ * \param type A \c SPL_TYPE_* identification number.
+ * \param f The function, called as \c f(SPLTypeTag<T>()).
+ *
+ * \return \c true if the type is dispatched and \c false otherwise.
+ */
+template <class F>
+inline bool splDispatchType(const SPLenum type, F &&f)
+{
+	switch (type)
+	{
+	case SPL_TYPE_UINT8: f(SPLTypeTag<SPLuint8>()); return true;
+	case SPL_TYPE_INT8: f(SPLTypeTag<SPLint8>()); return true;
+	case SPL_TYPE_UINT16: f(SPLTypeTag<SPLuint16>()); return true;
+	case SPL_TYPE_INT16: f(SPLTypeTag<SPLint16>()); return true;
+	case SPL_TYPE_UINT32: f(SPLTypeTag<SPLuint32>()); return true;
+	case SPL_TYPE_INT32: f(SPLTypeTag<SPLint32>()); return true;
+	case SPL_TYPE_UINT64: f(SPLTypeTag<SPLuint64>()); return true;
+	case SPL_TYPE_INT64: f(SPLTypeTag<SPLint64>()); return true;
+	case SPL_TYPE_IEEE32: f(SPLTypeTag<SPLieee32>()); return true;
+	case SPL_TYPE_IEEE64: f(SPLTypeTag<SPLieee64>()); return true;
+	case SPL_TYPE_IEEE128: f(SPLTypeTag<SPLieee128>()); return true;
+	case SPL_TYPE_IEEE16: f(SPLTypeTag<SPLieee16>()); return true;
+	case SPL_TYPE_UNORM8: f(SPLTypeTag<SPLunorm8>()); return true;
+	case SPL_TYPE_UNORM16: f(SPLTypeTag<SPLunorm16>()); return true;
+	default: return false;
+	}
+}
+
+/*! \brief Calls a function with the tags of two storage types!
+ *
+ * Instantiates the function for every pair of types, e.g. for conversions.
+ *
+ * \param a A \c SPL_TYPE_* identification number.
+ * \param b A \c SPL_TYPE_* identification number.
+ * \param f The function, called as \c f(SPLTypeTag<A>(), SPLTypeTag<B>()).
+ *
+ * \return \c true if both types are dispatched and \c false otherwise.
+ */
+template <class F>
+inline bool splDispatchTypes(const SPLenum a, const SPLenum b, F &&f)
+{
+	bool found = false;
+	const bool first = splDispatchType(a, [&](auto ta)
+	{
+		found = splDispatchType(b, [&](auto tb) { f(ta, tb); });
+	});
+	return first && found;
+}
+
+/*! \brief Calls a function with the tags of all dispatched storage types!
+ *
+ * \param f The function, called as \c f(SPLTypeTag<T>()) in the order of the identification numbers.
+ */
+template <class F>
+inline void splForEachType(F &&f)
+{
+	for (SPLenum type = SPL_TYPE_MIN + 1; type < SPL_TYPE_MAX; type++)
+	{
+		splDispatchType(type, f);
+	}
+}
+
+/*! \brief Returns the size of a storage type!
+ *
+ * \param type A \c SPL_TYPE_* identification number.
+ *
+ * \return Number of bytes or \f$ 0 \f$ if the type is not dispatched.
+ */
+inline SPLsizei splGetTypeSize(const SPLenum type) throw()
+{
+	SPLsizei size = 0;
+	splDispatchType(type, [&](auto tag) { size = SPLsizei(sizeof(typename decltype(tag)::Type)); });
+	return size;
+}
+
+#endif /* _spl_dispatch_hh_ */
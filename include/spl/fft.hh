@@ -0,0 +1,1190 @@
+#ifndef _spl_fft_hh_
+#define _spl_fft_hh_
+
+#include <cmath>
+#include <complex>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <spl/typesbase.hh>
+#include <spl/mathbase.hh>
+#include <spl/threadpool.hh>
+#include <spl/simd.hh>
+#include <spl/vector3.hh>
+#include <spl/grid.hh>
+#include <spl/convolution.hh>
+
+#define SPL_FFT_LANES 16	//!< Number of lines along y and z which are gathered at once.
+
+/*! \file fft.hh
+ * \brief Fast Fourier transforms of lines and grids and the convolution by FFTs.
+ * */
+
+/*! \class SPLFFTPlan
+ * \brief The fast Fourier transform of complex lines of one length.
+ *
+ * Computes the discrete Fourier transform
+ * \f$ X_k = \sum_{j=0}^{n-1} x_j e^{-2 \pi i j k / n} \f$ of lengths
+ * \f$ n = 2^a 3^b 5^c \f$ with the Stockham algorithm, i.e. one pass
+ * per radix 4, 2, 3 or 5 between two buffers without a bit reversal.
+ * The real and the imaginary parts are separate arrays, such that the
+ * butterflies of a pass run over \c SPLSimd<T>::width neighbors per
+ * instruction once the transformed subsequences are that long, or over
+ * \c SPLSimd<T>::width lines in every pass if \ref forwardLines
+ * transforms \ref SPL_FFT_LANES interleaved lines at once. The
+ * twiddle factors are computed once per plan. The inverse transform is
+ * the transform of the swapped real and imaginary parts and is not
+ * scaled by \f$ 1 / n \f$.
+ *
+ * Plans are immutable and shared by all threads, \ref get returns the
+ * plans of a cache keyed by the length and the type.
+ *
+ * Example
+ * \code
+ * std::shared_ptr<const SPLFFTPlan<SPLieee32> > plan = SPLFFTPlan<SPLieee32>::get(360);
+ * std::vector<SPLieee32> re(360), im(360), wr(360), wi(360);
+ * ...
+ * plan->forward(&re[0], &im[0], &wr[0], &wi[0]);
+ * \endcode
+ *
+ * \sa SPLSpectrum
+ */
+template <class T>
+class SPLFFTPlan
+{
+public:
+	/*! \brief Constructor!
+	 *
+	 * Computes the passes and the twiddle factors.
+	 *
+	 * \param n The length, see \ref isSupported.
+	 */
+	explicit SPLFFTPlan(const SPLsizei n) throw();
+
+	/*! \brief Returns the length!
+	 *
+	 * \return The length \f$ n \f$.
+	 */
+	SPLsizei getSize(void) const throw() { return this->size; }
+
+	/*! \brief Transforms a line in place!
+	 *
+	 * \param re The \f$ n \f$ real parts.
+	 * \param im The \f$ n \f$ imaginary parts.
+	 * \param wr Work memory of \f$ n \f$ values.
+	 * \param wi Work memory of \f$ n \f$ values.
+	 */
+	void forward(T *re, T *im, T *wr, T *wi) const throw();
+
+	/*! \brief Transforms a line back in place!
+	 *
+	 * \f$ x_j = \sum_{k=0}^{n-1} X_k e^{2 \pi i j k / n} \f$, i.e. \f$ n \f$ times the inverse.
+	 *
+	 * \param re The \f$ n \f$ real parts.
+	 * \param im The \f$ n \f$ imaginary parts.
+	 * \param wr Work memory of \f$ n \f$ values.
+	 * \param wi Work memory of \f$ n \f$ values.
+	 */
+	void inverse(T *re, T *im, T *wr, T *wi) const throw() { this->forward(im, re, wi, wr); }
+
+	/*! \brief Transforms \ref SPL_FFT_LANES interleaved lines in place!
+	 *
+	 * The value \f$ j \f$ of the line \f$ l \f$ is at
+	 * \f$ j \cdot SPL\_FFT\_LANES + l \f$, i.e. the butterflies run over
+	 * \c SPLSimd<T>::width lines per instruction in every pass.
+	 *
+	 * \param re The \f$ n \cdot SPL\_FFT\_LANES \f$ real parts.
+	 * \param im The \f$ n \cdot SPL\_FFT\_LANES \f$ imaginary parts.
+	 * \param wr Work memory of \f$ n \cdot SPL\_FFT\_LANES \f$ values.
+	 * \param wi Work memory of \f$ n \cdot SPL\_FFT\_LANES \f$ values.
+	 * \param lanes Number of lines, the values of the others are undefined.
+	 */
+	void forwardLines(T *re, T *im, T *wr, T *wi, const SPLsizei lanes = SPL_FFT_LANES) const throw();
+
+	/*! \brief Transforms \ref SPL_FFT_LANES interleaved lines back in place!
+	 *
+	 * \param re The \f$ n \cdot SPL\_FFT\_LANES \f$ real parts.
+	 * \param im The \f$ n \cdot SPL\_FFT\_LANES \f$ imaginary parts.
+	 * \param wr Work memory of \f$ n \cdot SPL\_FFT\_LANES \f$ values.
+	 * \param wi Work memory of \f$ n \cdot SPL\_FFT\_LANES \f$ values.
+	 * \param lanes Number of lines, the values of the others are undefined.
+	 */
+	void inverseLines(T *re, T *im, T *wr, T *wi, const SPLsizei lanes = SPL_FFT_LANES) const throw()
+	{
+		this->forwardLines(im, re, wi, wr, lanes);
+	}
+
+	/*! \brief Returns whether a length is supported!
+	 *
+	 * \param n The length.
+	 *
+	 * \return \c true if \f$ n = 2^a 3^b 5^c \geq 1 \f$.
+	 */
+	static bool isSupported(SPLsizei n) throw();
+
+	/*! \brief Returns the smallest supported length!
+	 *
+	 * \param n A length \f$ \geq 1 \f$.
+	 *
+	 * \return The smallest supported length \f$ \geq n \f$.
+	 */
+	static SPLsizei getGoodSize(const SPLsizei n) throw();
+
+	/*! \brief Returns the plan of a length!
+	 *
+	 * The plan is created by the first call and cached, the calls are
+	 * thread safe.
+	 *
+	 * \param n The length, see \ref isSupported.
+	 *
+	 * \return The plan.
+	 */
+	static std::shared_ptr<const SPLFFTPlan<T> > get(const SPLsizei n) throw();
+
+	/*! \brief Returns the number of cached plans of the type!
+	 *
+	 * \return Number of plans.
+	 */
+	static SPLsizei getCacheSize(void) throw();
+
+	/*! \brief Removes the cached plans of the type!
+	 *
+	 * Plans in use stay valid.
+	 */
+	static void clearCache(void) throw();
+
+private:
+	//! A pass of the radix \c radix over subsequences of the length \c span.
+	struct Pass
+	{
+		SPLsizei radix;			//!< The radix.
+		SPLsizei span;			//!< Length of the transformed subsequences before the pass.
+		std::vector<T> wr;		//!< Real parts of the twiddle factors, \c span per index \f$ r \in [1, radix) \f$.
+		std::vector<T> wi;		//!< Imaginary parts of the twiddle factors.
+	};
+
+	//! The cached plans.
+	struct Cache
+	{
+		std::mutex mutex;											//!< Guards the plans.
+		std::map<SPLsizei, std::shared_ptr<const SPLFFTPlan<T> > > plans;	//!< The plans by length.
+	};
+
+	static Cache& getCache(void) throw();
+	template <SPLsizei L>
+	void transform(T *re, T *im, T *wr, T *wi, const SPLsizei lanes) const throw();
+	template <SPLsizei R, SPLsizei L>
+	void run(const Pass &p, const T *xr, const T *xi, T *yr, T *yi, const SPLsizei lanes) const throw();
+
+	SPLsizei size;				//!< The length.
+	std::vector<Pass> passes;	//!< The passes.
+};
+
+/*! \class SPLSpectrum
+ * \brief The Fourier transform of a grid.
+ *
+ * The transform of a grid of \f$ n_x \times n_y \times n_z \f$ voxels
+ * is computed line by line along x, y and z with the plans of
+ * \ref SPLFFTPlan. The spectrum of a real grid is Hermitian, i.e. only
+ * the coefficients \f$ k_x \in [0, n_x / 2] \f$ are stored, and the
+ * rows of the real grid are transformed in pairs as the real and the
+ * imaginary parts of one complex row. The lines along y and z are
+ * gathered in tiles of \ref SPL_FFT_LANES neighbors along x, which
+ * are interleaved and transformed by \ref SPLFFTPlan::forwardLines. The rows
+ * of the grid and the tiles of its slabs along y and z are
+ * distributed on the threads of a \ref SPLThreadPool.
+ *
+ * The coefficients are stored linear, \f$ k_x \f$ fastest, with the
+ * real and imaginary parts in separate arrays. The inverse transforms
+ * are scaled by \f$ 1 / (n_x n_y n_z) \f$.
+ *
+ * Example
+ * \code
+ * SPLSpectrum<SPLieee32> a, b;
+ * a.forward(image);
+ * b.forward(pattern);
+ * a.multiply(b, true);
+ * a.inverse(correlation);
+ * \endcode
+ *
+ * \sa SPLFFTPlan splConvolve
+ */
+template <class T>
+class SPLSpectrum
+{
+public:
+	/*! \brief Constructor!
+	 *
+	 * Initializes an empty spectrum.
+	 */
+	SPLSpectrum(void) throw() : half(false) {}
+
+	/*! \brief Returns the size of the transformed grid!
+	 *
+	 * \return Number of voxels along x, y and z.
+	 */
+	const SPLVector3i& getSize(void) const throw() { return this->size; }
+
+	/*! \brief Returns the number of stored coefficients!
+	 *
+	 * \return \f$ (n_x / 2 + 1, n_y, n_z) \f$ for real and \f$ (n_x, n_y, n_z) \f$ for complex grids.
+	 */
+	const SPLVector3i& getSpectrumSize(void) const throw() { return this->coefficients; }
+
+	/*! \brief Returns whether the spectrum is the spectrum of a real grid!
+	 *
+	 * \return \c true if half of the coefficients are stored.
+	 */
+	bool isHalf(void) const throw() { return this->half; }
+
+	/*! \brief Returns the real parts!
+	 *
+	 * \return Pointer to the real parts, \f$ k_x \f$ fastest.
+	 */
+	T* getReal(void) throw() { return this->re.empty() ? 0 : &this->re[0]; }
+
+	/*! \brief Returns the real parts!
+	 *
+	 * \return Pointer to the real parts, \f$ k_x \f$ fastest.
+	 */
+	const T* getReal(void) const throw() { return this->re.empty() ? 0 : &this->re[0]; }
+
+	/*! \brief Returns the imaginary parts!
+	 *
+	 * \return Pointer to the imaginary parts, \f$ k_x \f$ fastest.
+	 */
+	T* getImag(void) throw() { return this->im.empty() ? 0 : &this->im[0]; }
+
+	/*! \brief Returns the imaginary parts!
+	 *
+	 * \return Pointer to the imaginary parts, \f$ k_x \f$ fastest.
+	 */
+	const T* getImag(void) const throw() { return this->im.empty() ? 0 : &this->im[0]; }
+
+	/*! \brief Access operator!
+	 *
+	 * \param x Frequency in \f$ [0, n_x) \f$ (in \f$ [0, n_x / 2] \f$ for real grids).
+	 * \param y Frequency in \f$ [0, n_y) \f$.
+	 * \param z Frequency in \f$ [0, n_z) \f$.
+	 *
+	 * \return The coefficient.
+	 */
+	std::complex<T> operator () (const SPLindex x, const SPLindex y, const SPLindex z) const throw();
+
+	/*! \brief Transforms a real grid!
+	 *
+	 * \param g The grid, its size must be supported along every axis, see \ref SPLFFTPlan::isSupported.
+	 * \param pool The threads.
+	 *
+	 * \return \c true on success and \c false otherwise.
+	 */
+	template <class V>
+	bool forward(const SPLGrid<V> &g, SPLThreadPool &pool = SPLThreadPool::getGlobal()) throw();
+
+	/*! \brief Transforms a real grid in linear memory!
+	 *
+	 * \param v The \f$ n_x n_y n_z \f$ voxels, x fastest.
+	 * \param size Number of voxels along x, y and z, supported along every axis.
+	 * \param pool The threads.
+	 *
+	 * \return \c true on success and \c false otherwise.
+	 */
+	bool forward(const T *v, const SPLVector3i &size, SPLThreadPool &pool = SPLThreadPool::getGlobal()) throw();
+
+	/*! \brief Transforms a complex grid in linear memory!
+	 *
+	 * \param re The real parts of the \f$ n_x n_y n_z \f$ voxels, x fastest.
+	 * \param im The imaginary parts.
+	 * \param size Number of voxels along x, y and z, supported along every axis.
+	 * \param pool The threads.
+	 *
+	 * \return \c true on success and \c false otherwise.
+	 */
+	bool forward(const T *re, const T *im, const SPLVector3i &size, SPLThreadPool &pool = SPLThreadPool::getGlobal()) throw();
+
+	/*! \brief Transforms the spectrum of a real grid back!
+	 *
+	 * \param g The grid with the size of the transformed grid (output).
+	 * \param layout \ref SPL_GRID_LINEAR or \ref SPL_GRID_BRICKED.
+	 * \param brick Edge length of the bricks (a power of 2).
+	 * \param pool The threads.
+	 *
+	 * \return \c true on success and \c false otherwise.
+	 */
+	bool inverse(SPLGrid<T> &g, const SPLenum layout = SPL_GRID_LINEAR, const SPLsizei brick = 8,
+				 SPLThreadPool &pool = SPLThreadPool::getGlobal()) const throw();
+
+	/*! \brief Transforms the spectrum of a real grid back into linear memory!
+	 *
+	 * \param v The \f$ n_x n_y n_z \f$ voxels, x fastest (output).
+	 * \param pool The threads.
+	 *
+	 * \return \c true on success and \c false otherwise.
+	 */
+	bool inverse(T *v, SPLThreadPool &pool = SPLThreadPool::getGlobal()) const throw();
+
+	/*! \brief Transforms the spectrum of a complex grid back into linear memory!
+	 *
+	 * \param re The real parts of the \f$ n_x n_y n_z \f$ voxels, x fastest (output).
+	 * \param im The imaginary parts (output).
+	 * \param pool The threads.
+	 *
+	 * \return \c true on success and \c false otherwise.
+	 */
+	bool inverse(T *re, T *im, SPLThreadPool &pool = SPLThreadPool::getGlobal()) const throw();
+
+	/*! \brief Multiplies the coefficients with the coefficients of another spectrum!
+	 *
+	 * The product is the spectrum of the cyclic convolution of the
+	 * grids, the product with the conjugate the spectrum of the cyclic
+	 * correlation.
+	 *
+	 * \param s A spectrum of the same size.
+	 * \param conjugate Set to multiply with the conjugate of \c s.
+	 * \param pool The threads.
+	 */
+	void multiply(const SPLSpectrum<T> &s, const bool conjugate = false, SPLThreadPool &pool = SPLThreadPool::getGlobal()) throw();
+
+private:
+	bool setup(const SPLVector3i &size, const bool half) throw();
+	void transformRows(const T *v, SPLThreadPool &pool) throw();
+	void inverseRows(T *re, T *im, T *v, SPLThreadPool &pool) const throw();
+	static void transformLines(T *re, T *im, const SPLVector3i &size, const SPLindex axis, const bool inverse, SPLThreadPool &pool) throw();
+
+	SPLVector3i size;			//!< Size of the transformed grid.
+	SPLVector3i coefficients;	//!< Number of stored coefficients.
+	bool half;					//!< Set for the spectra of real grids.
+	std::vector<T> re;			//!< Real parts.
+	std::vector<T> im;			//!< Imaginary parts.
+};
+
+/*! \brief Convolves a grid with a kernel!
+ *
+ * Computes \f$ u(p) = \sum_k h(k) \, v(p - k) \f$ for a kernel of
+ * \f$ (2 r_x + 1) \times (2 r_y + 1) \times (2 r_z + 1) \f$ voxels
+ * centered at \f$ (r_x, r_y, r_z) \f$. The voxels outside the grid are
+ * given by the border mode. The direct convolution costs one
+ * multiply-add per tap and voxel. The spectral convolution pads the
+ * grid by the radius of the kernel to the next sizes of
+ * \ref SPLFFTPlan::getGoodSize and multiplies the spectra of the grid
+ * and of the kernel, i.e. costs about \f$ O(\log n) \f$ per voxel for
+ * any kernel. \ref SPL_CONVOLUTION_AUTO takes the spectral path if the
+ * kernel has more than \f$ \max(4, w) \log_2 m \f$ taps per voxel of
+ * the padded grid of \f$ m \f$ voxels, where \f$ w \f$ is the width
+ * of \c SPLSimd<SPLieee32>: the taps run over \f$ w \f$ voxels per
+ * instruction, the transforms gain less from the registers, see
+ * \ref splGetConvolutionMethod.
+ *
+ * \param in The grid.
+ * \param kernel The kernel with an odd number of voxels along every axis.
+ * \param out The convolved grid with the size and layout of the input (output).
+ * \param border A \c SPL_BORDER_* identification number.
+ * \param method A \c SPL_CONVOLUTION_* identification number.
+ * \param pool The threads.
+ *
+ * \return \c true on success and \c false otherwise.
+ *
+ * \sa splConvolveSeparable
+ */
+template <class T>
+bool splConvolve(const SPLGrid<T> &in, const SPLGrid<SPLieee32> &kernel, SPLGrid<SPLieee32> &out, const SPLenum border = SPL_BORDER_CLAMP,
+				 const SPLenum method = SPL_CONVOLUTION_AUTO, SPLThreadPool &pool = SPLThreadPool::getGlobal()) throw();
+
+/*! \brief Correlates a grid with a kernel!
+ *
+ * Computes \f$ u(p) = \sum_k h(k) \, v(p + k) \f$, see \ref splConvolve.
+ *
+ * \param in The grid.
+ * \param kernel The kernel with an odd number of voxels along every axis.
+ * \param out The correlation with the size and layout of the input (output).
+ * \param border A \c SPL_BORDER_* identification number.
+ * \param method A \c SPL_CONVOLUTION_* identification number.
+ * \param pool The threads.
+ *
+ * \return \c true on success and \c false otherwise.
+ */
+template <class T>
+bool splCorrelate(const SPLGrid<T> &in, const SPLGrid<SPLieee32> &kernel, SPLGrid<SPLieee32> &out, const SPLenum border = SPL_BORDER_CLAMP,
+				  const SPLenum method = SPL_CONVOLUTION_AUTO, SPLThreadPool &pool = SPLThreadPool::getGlobal()) throw();
+
+/*! \brief Returns the method of \ref SPL_CONVOLUTION_AUTO!
+ *
+ * \param size Number of voxels of the grid along x, y and z.
+ * \param kernel Number of voxels of the kernel along x, y and z (odd).
+ *
+ * \return \ref SPL_CONVOLUTION_SPECTRAL if the kernel has more taps per
+ * voxel than the transforms cost, see \ref splConvolve, and
+ * \ref SPL_CONVOLUTION_DIRECT otherwise.
+ */
+inline SPLenum splGetConvolutionMethod(const SPLVector3i &size, const SPLVector3i &kernel) throw();
+
+namespace SPLFFTDetail
+{
+	//! Multiplies \f$ (a_r + i a_i) \f$ with \f$ (b_r + i b_i) \f$ in place.
+	template <class S>
+	inline void multiply(typename S::Type &ar, typename S::Type &ai, const typename S::Type br, const typename S::Type bi) throw()
+	{
+		const typename S::Type r = S::sub(S::mul(ar, br), S::mul(ai, bi));
+		ai = S::add(S::mul(ar, bi), S::mul(ai, br));
+		ar = r;
+	}
+
+	//! The discrete Fourier transform of \c R values in place.
+	template <SPLsizei R, class S>
+	inline void dft(typename S::Type *ar, typename S::Type *ai) throw()
+	{
+		typedef typename S::Type V;
+		if constexpr (R == 2)
+		{
+			const V r = S::sub(ar[0], ar[1]), i = S::sub(ai[0], ai[1]);
+			ar[0] = S::add(ar[0], ar[1]);
+			ai[0] = S::add(ai[0], ai[1]);
+			ar[1] = r;
+			ai[1] = i;
+		}
+		else if constexpr (R == 3)
+		{
+			// y1,2 = v0 - (v1 + v2) / 2 -+ i sin(60) (v1 - v2)
+			const V sr = S::add(ar[1], ar[2]), si = S::add(ai[1], ai[2]);
+			const V dr = S::mul(S::set(0.866025403784438647), S::sub(ar[1], ar[2]));
+			const V di = S::mul(S::set(0.866025403784438647), S::sub(ai[1], ai[2]));
+			const V mr = S::sub(ar[0], S::mul(S::set(0.5), sr)), mi = S::sub(ai[0], S::mul(S::set(0.5), si));
+			ar[0] = S::add(ar[0], sr);
+			ai[0] = S::add(ai[0], si);
+			ar[1] = S::add(mr, di);
+			ai[1] = S::sub(mi, dr);
+			ar[2] = S::sub(mr, di);
+			ai[2] = S::add(mi, dr);
+		}
+		else if constexpr (R == 4)
+		{
+			const V pr = S::add(ar[0], ar[2]), pi = S::add(ai[0], ai[2]), qr = S::sub(ar[0], ar[2]), qi = S::sub(ai[0], ai[2]);
+			const V sr = S::add(ar[1], ar[3]), si = S::add(ai[1], ai[3]), dr = S::sub(ar[1], ar[3]), di = S::sub(ai[1], ai[3]);
+			ar[0] = S::add(pr, sr);
+			ai[0] = S::add(pi, si);
+			ar[2] = S::sub(pr, sr);
+			ai[2] = S::sub(pi, si);
+			ar[1] = S::add(qr, di);
+			ai[1] = S::sub(qi, dr);
+			ar[3] = S::sub(qr, di);
+			ai[3] = S::add(qi, dr);
+		}
+		else
+		{
+			// y1,4 = a1 -+ i b1 and y2,3 = a2 -+ i b2
+			const V c1 = S::set(0.309016994374947424), c2 = S::set(-0.809016994374947424);
+			const V s1 = S::set(0.951056516295153572), s2 = S::set(0.587785252292473129);
+			const V t1r = S::add(ar[1], ar[4]), t1i = S::add(ai[1], ai[4]), t2r = S::add(ar[2], ar[3]), t2i = S::add(ai[2], ai[3]);
+			const V t3r = S::sub(ar[1], ar[4]), t3i = S::sub(ai[1], ai[4]), t4r = S::sub(ar[2], ar[3]), t4i = S::sub(ai[2], ai[3]);
+			const V a1r = S::add(ar[0], S::add(S::mul(c1, t1r), S::mul(c2, t2r))), a1i = S::add(ai[0], S::add(S::mul(c1, t1i), S::mul(c2, t2i)));
+			const V a2r = S::add(ar[0], S::add(S::mul(c2, t1r), S::mul(c1, t2r))), a2i = S::add(ai[0], S::add(S::mul(c2, t1i), S::mul(c1, t2i)));
+			const V b1r = S::add(S::mul(s1, t3r), S::mul(s2, t4r)), b1i = S::add(S::mul(s1, t3i), S::mul(s2, t4i));
+			const V b2r = S::sub(S::mul(s2, t3r), S::mul(s1, t4r)), b2i = S::sub(S::mul(s2, t3i), S::mul(s1, t4i));
+			ar[0] = S::add(ar[0], S::add(t1r, t2r));
+			ai[0] = S::add(ai[0], S::add(t1i, t2i));
+			ar[1] = S::add(a1r, b1i);
+			ai[1] = S::sub(a1i, b1r);
+			ar[4] = S::sub(a1r, b1i);
+			ai[4] = S::add(a1i, b1r);
+			ar[2] = S::add(a2r, b2i);
+			ai[2] = S::sub(a2i, b2r);
+			ar[3] = S::sub(a2r, b2i);
+			ai[3] = S::add(a2i, b2r);
+		}
+	}
+
+	//! Copies the lines of a tile into interleaved memory or back, the missing lines of a partial tile are zero.
+	template <class T>
+	inline void copyTile(T *grid, T *tile, const SPLint64 base, const SPLint64 stride, const SPLsizei n, const SPLsizei lanes,
+						 const bool gather) throw()
+	{
+		for (SPLindex j = 0; j < n; j++)
+		{
+			T *g = grid + base + j * stride, *t = tile + j * SPL_FFT_LANES;
+			if (gather)
+			{
+				memcpy(t, g, size_t(lanes) * sizeof(T));
+				memset(t + lanes, 0, size_t(SPL_FFT_LANES - lanes) * sizeof(T));
+			}
+			else
+			{
+				memcpy(g, t, size_t(lanes) * sizeof(T));
+			}
+		}
+	}
+
+	//! Returns the padded size of a direct or spectral convolution.
+	inline SPLVector3i padded(const SPLVector3i &size, const SPLVector3i &radius, const bool spectral) throw()
+	{
+		SPLVector3i m;
+		for (SPLindex a = 0; a < 3; a++)
+		{
+			m[a] = size[a] + 2 * radius[a];
+			m[a] = spectral ? SPLFFTPlan<SPLieee32>::getGoodSize(m[a]) : m[a];
+		}
+		return m;
+	}
+
+	//! Copies a grid into linear memory of a larger size, padded by the radius on the low sides with the border mode.
+	template <class T>
+	void pad(const SPLGrid<T> &g, const SPLVector3i &radius, const SPLenum border, const SPLVector3i &m, SPLieee32 *v,
+			 SPLThreadPool &pool) throw()
+	{
+		const SPLVector3i &n = g.getSize();
+		std::vector<SPLieee32> linear(size_t(n.x) * size_t(n.y) * size_t(n.z));
+		SPLConvolutionDetail::load(g, &linear[0], pool);
+		const SPLint64 rows = SPLint64(m.y) * m.z;
+		pool.parallelFor(0, rows, pool.getGrain(rows, MAX(1, 4096 / m.x)), [&](const SPLint64 first, const SPLint64 last)
+		{
+			for (SPLint64 r = first; r < last; r++)
+			{
+				SPLieee32 *dst = v + r * m.x;
+				const SPLindex y = SPLConvolutionDetail::border(SPLindex(r % m.y) - radius.y, n.y, border);
+				const SPLindex z = SPLConvolutionDetail::border(SPLindex(r / m.y) - radius.z, n.z, border);
+				const bool inside = SPLindex(r % m.y) < n.y + 2 * radius.y && SPLindex(r / m.y) < n.z + 2 * radius.z;
+				for (SPLindex i = 0; i < m.x; i++)
+				{
+					const SPLindex x = (i < n.x + 2 * radius.x) ? SPLConvolutionDetail::border(i - radius.x, n.x, border) : -1;
+					dst[i] = (inside && x >= 0 && y >= 0 && z >= 0) ? linear[size_t((SPLint64(z) * n.y + y) * n.x + x)] : 0.0f;
+				}
+			}
+		});
+	}
+
+	//! Convolves or correlates a padded grid by the taps of the kernel, the SIMD registers run along x.
+	inline void direct(const SPLieee32 *v, const SPLVector3i &m, const SPLGrid<SPLieee32> &kernel, const bool correlate,
+					   const SPLVector3i &n, SPLieee32 *out, SPLThreadPool &pool) throw()
+	{
+		// the taps and their offsets in the padded grid relative to the output voxel
+		const SPLVector3i k = kernel.getSize(), r((k.x - 1) / 2, (k.y - 1) / 2, (k.z - 1) / 2);
+		std::vector<SPLieee32> taps;
+		std::vector<SPLint64> offsets;
+		for (SPLindex c = -r.z; c <= r.z; c++)
+		{
+			for (SPLindex b = -r.y; b <= r.y; b++)
+			{
+				for (SPLindex a = -r.x; a <= r.x; a++)
+				{
+					const SPLieee32 h = kernel(a + r.x, b + r.y, c + r.z);
+					if (h != 0.0f)
+					{
+						const SPLint64 s = correlate ? 1 : -1;
+						taps.push_back(h);
+						offsets.push_back(((s * c + r.z) * SPLint64(m.y) + s * b + r.y) * m.x + s * a + r.x);
+					}
+				}
+			}
+		}
+		const SPLsizei count = SPLsizei(taps.size());
+		const SPLint64 rows = SPLint64(n.y) * n.z;
+		pool.parallelFor(0, rows, pool.getGrain(rows, MAX(1, 4096 / (n.x * MAX(1, count)))), [&](const SPLint64 first, const SPLint64 last)
+		{
+			for (SPLint64 row = first; row < last; row++)
+			{
+				const SPLint64 y = row % n.y, z = row / n.y;
+				const SPLieee32 *src = v + (z * m.y + y) * m.x;
+				SPLieee32 *dst = out + row * n.x;
+				splSimdForEach<SPLieee32>(n.x, [&](auto simd, const SPLindex x)
+				{
+					typedef decltype(simd) S;
+					typename S::Type a = S::set(0.0f);
+					for (SPLindex t = 0; t < count; t++)
+					{
+						a = S::add(a, S::mul(S::set(taps[size_t(t)]), S::load(src + offsets[size_t(t)] + x)));
+					}
+					S::store(dst + x, a);
+				});
+			}
+		});
+	}
+
+	//! Convolves or correlates a grid, see \ref splConvolve.
+	template <class T>
+	bool convolve(const SPLGrid<T> &in, const SPLGrid<SPLieee32> &kernel, SPLGrid<SPLieee32> &out, const SPLenum border,
+				  const SPLenum method, const bool correlate, SPLThreadPool &pool) throw()
+	{
+		assert(border > SPL_BORDER_MIN && border < SPL_BORDER_MAX);
+		assert(method > SPL_CONVOLUTION_MIN && method < SPL_CONVOLUTION_MAX);
+		const SPLVector3i n = in.getSize(), k = kernel.getSize();
+		const SPLenum layout = in.getLayout();
+		const SPLsizei brick = in.getBrickSize();
+		if (n.x <= 0 || n.y <= 0 || n.z <= 0 || k.x % 2 == 0 || k.y % 2 == 0 || k.z % 2 == 0)
+		{
+			return false;
+		}
+
+		const SPLVector3i r((k.x - 1) / 2, (k.y - 1) / 2, (k.z - 1) / 2);
+		const SPLieee64 voxels = SPLieee64(n.x) * n.y * n.z;
+		const bool spectral = (method == SPL_CONVOLUTION_SPECTRAL) ||
+							  (method == SPL_CONVOLUTION_AUTO && splGetConvolutionMethod(n, k) == SPL_CONVOLUTION_SPECTRAL);
+
+		const SPLVector3i m = padded(n, r, spectral);
+		std::vector<SPLieee32> v(size_t(m.x) * size_t(m.y) * size_t(m.z)), result((size_t(voxels)));
+		pad(in, r, border, m, &v[0], pool);
+		if (spectral)
+		{
+			// the kernel with the center at the origin, the voxels at negative positions wrap around
+			std::vector<SPLieee32> h(v.size(), 0.0f);
+			for (SPLindex c = -r.z; c <= r.z; c++)
+			{
+				for (SPLindex b = -r.y; b <= r.y; b++)
+				{
+					for (SPLindex a = -r.x; a <= r.x; a++)
+					{
+						const SPLint64 x = (a + m.x) % m.x, y = (b + m.y) % m.y, z = (c + m.z) % m.z;
+						h[size_t((z * m.y + y) * m.x + x)] = kernel(a + r.x, b + r.y, c + r.z);
+					}
+				}
+			}
+			SPLSpectrum<SPLieee32> sv, sh;
+			if (!sv.forward(&v[0], m, pool) || !sh.forward(&h[0], m, pool))
+			{
+				return false;
+			}
+			sv.multiply(sh, correlate, pool);
+			sv.inverse(&v[0], pool);
+
+			// the voxel p of the result is the voxel p + r of the padded grid
+			const SPLint64 rows = SPLint64(n.y) * n.z;
+			pool.parallelFor(0, rows, pool.getGrain(rows, MAX(1, 4096 / n.x)), [&](const SPLint64 first, const SPLint64 last)
+			{
+				for (SPLint64 row = first; row < last; row++)
+				{
+					const SPLint64 y = row % n.y + r.y, z = row / n.y + r.z;
+					memcpy(&result[size_t(row * n.x)], &v[size_t((z * m.y + y) * m.x + r.x)], size_t(n.x) * sizeof(SPLieee32));
+				}
+			});
+		}
+		else
+		{
+			direct(&v[0], m, kernel, correlate, n, &result[0], pool);
+		}
+		if (!out.resize(n, layout, brick))
+		{
+			return false;
+		}
+		out.fromLinear(&result[0], pool);
+		return true;
+	}
+}
+
+/************************************************************************************************
+ ** SPLFFTPlan class implementation
+ ************************************************************************************************/
+template <class T>
+SPLFFTPlan<T>::SPLFFTPlan(const SPLsizei n) throw() : size(n)
+{
+	assert(isSupported(n));
+	// radix 4 first, then 2, 3 and 5
+	SPLsizei rest = n, span = 1;
+	while (rest > 1)
+	{
+		const SPLsizei radix = (rest % 4 == 0) ? 4 : ((rest % 2 == 0) ? 2 : ((rest % 3 == 0) ? 3 : 5));
+		Pass p;
+		p.radix = radix;
+		p.span = span;
+		p.wr.resize(size_t(span) * size_t(radix - 1));
+		p.wi.resize(size_t(span) * size_t(radix - 1));
+		for (SPLindex r = 1; r < radix; r++)
+		{
+			for (SPLindex k = 0; k < span; k++)
+			{
+				const SPLieee64 angle = -2.0 * PI * SPLieee64(r) * SPLieee64(k) / SPLieee64(span * radix);
+				p.wr[size_t((r - 1) * span + k)] = T(std::cos(angle));
+				p.wi[size_t((r - 1) * span + k)] = T(std::sin(angle));
+			}
+		}
+		this->passes.push_back(p);
+		rest /= radix;
+		span *= radix;
+	}
+}
+
+template <class T>
+void SPLFFTPlan<T>::forward(T *re, T *im, T *wr, T *wi) const throw()
+{
+	this->transform<1>(re, im, wr, wi, 1);
+}
+
+template <class T>
+void SPLFFTPlan<T>::forwardLines(T *re, T *im, T *wr, T *wi, const SPLsizei lanes) const throw()
+{
+	// the lines of full registers
+	const SPLsizei width = SPLSimd<T>::width;
+	assert(lanes >= 0 && lanes <= SPL_FFT_LANES);
+	this->transform<SPL_FFT_LANES>(re, im, wr, wi, MIN(SPLsizei(SPL_FFT_LANES), (lanes + width - 1) / width * width));
+}
+
+template <class T>
+template <SPLsizei L>
+void SPLFFTPlan<T>::transform(T *re, T *im, T *wr, T *wi, const SPLsizei lanes) const throw()
+{
+	T *xr = re, *xi = im, *yr = wr, *yi = wi;
+	for (size_t i = 0; i < this->passes.size(); i++)
+	{
+		const Pass &p = this->passes[i];
+		switch (p.radix)
+		{
+		case 2: this->run<2, L>(p, xr, xi, yr, yi, lanes); break;
+		case 3: this->run<3, L>(p, xr, xi, yr, yi, lanes); break;
+		case 4: this->run<4, L>(p, xr, xi, yr, yi, lanes); break;
+		default: this->run<5, L>(p, xr, xi, yr, yi, lanes); break;
+		}
+		std::swap(xr, yr);
+		std::swap(xi, yi);
+	}
+	if (xr != re)
+	{
+		memcpy(re, xr, size_t(this->size) * L * sizeof(T));
+		memcpy(im, xi, size_t(this->size) * L * sizeof(T));
+	}
+}
+
+template <class T>
+template <SPLsizei R, SPLsizei L>
+void SPLFFTPlan<T>::run(const Pass &p, const T *xr, const T *xi, T *yr, T *yi, const SPLsizei lanes) const throw()
+{
+	// the subsequences g of the length span are combined R at a time into subsequences of the length R span
+	const SPLsizei span = p.span, stride = this->size / R, groups = stride / span;
+	const T *twr = &p.wr[0], *twi = &p.wi[0];
+	for (SPLindex g = 0; g < groups; g++)
+	{
+		if constexpr (L == 1)
+		{
+			const T *sr = xr + g * span, *si = xi + g * span;
+			T *dr = yr + g * span * R, *di = yi + g * span * R;
+			splSimdForEach<T>(span, [&](auto simd, const SPLindex k)
+			{
+				typedef decltype(simd) S;
+				typename S::Type ar[R], ai[R];
+				ar[0] = S::load(sr + k);
+				ai[0] = S::load(si + k);
+				for (SPLindex r = 1; r < R; r++)
+				{
+					ar[r] = S::load(sr + r * stride + k);
+					ai[r] = S::load(si + r * stride + k);
+					SPLFFTDetail::multiply<S>(ar[r], ai[r], S::load(twr + (r - 1) * span + k), S::load(twi + (r - 1) * span + k));
+				}
+				SPLFFTDetail::dft<R, S>(ar, ai);
+				for (SPLindex r = 0; r < R; r++)
+				{
+					S::store(dr + r * span + k, ar[r]);
+					S::store(di + r * span + k, ai[r]);
+				}
+			});
+		}
+		else
+		{
+			// the values of the interleaved lines are neighbors and share the twiddle factor
+			for (SPLindex k = 0; k < span; k++)
+			{
+				const T *sr = xr + (g * span + k) * L, *si = xi + (g * span + k) * L;
+				T *dr = yr + (g * span * R + k) * L, *di = yi + (g * span * R + k) * L;
+				splSimdForEach<T>(lanes, [&](auto simd, const SPLindex l)
+				{
+					typedef decltype(simd) S;
+					typename S::Type ar[R], ai[R];
+					ar[0] = S::load(sr + l);
+					ai[0] = S::load(si + l);
+					for (SPLindex r = 1; r < R; r++)
+					{
+						ar[r] = S::load(sr + r * stride * L + l);
+						ai[r] = S::load(si + r * stride * L + l);
+						SPLFFTDetail::multiply<S>(ar[r], ai[r], S::set(twr[(r - 1) * span + k]), S::set(twi[(r - 1) * span + k]));
+					}
+					SPLFFTDetail::dft<R, S>(ar, ai);
+					for (SPLindex r = 0; r < R; r++)
+					{
+						S::store(dr + r * span * L + l, ar[r]);
+						S::store(di + r * span * L + l, ai[r]);
+					}
+				});
+			}
+		}
+	}
+}
+
+template <class T>
+bool SPLFFTPlan<T>::isSupported(SPLsizei n) throw()
+{
+	if (n < 1)
+	{
+		return false;
+	}
+	const SPLsizei factors[3] = { 2, 3, 5 };
+	for (SPLindex i = 0; i < 3; i++)
+	{
+		while (n % factors[i] == 0)
+		{
+			n /= factors[i];
+		}
+	}
+	return n == 1;
+}
+
+template <class T>
+SPLsizei SPLFFTPlan<T>::getGoodSize(const SPLsizei n) throw()
+{
+	assert(n >= 1);
+	SPLsizei m = n;
+	while (!isSupported(m))
+	{
+		m++;
+	}
+	return m;
+}
+
+template <class T>
+typename SPLFFTPlan<T>::Cache& SPLFFTPlan<T>::getCache(void) throw()
+{
+	static Cache cache;
+	return cache;
+}
+
+template <class T>
+std::shared_ptr<const SPLFFTPlan<T> > SPLFFTPlan<T>::get(const SPLsizei n) throw()
+{
+	Cache &cache = getCache();
+	std::lock_guard<std::mutex> lock(cache.mutex);
+	std::shared_ptr<const SPLFFTPlan<T> > &plan = cache.plans[n];
+	if (!plan)
+	{
+		plan = std::make_shared<const SPLFFTPlan<T> >(n);
+	}
+	return plan;
+}
+
+template <class T>
+SPLsizei SPLFFTPlan<T>::getCacheSize(void) throw()
+{
+	Cache &cache = getCache();
+	std::lock_guard<std::mutex> lock(cache.mutex);
+	return SPLsizei(cache.plans.size());
+}
+
+template <class T>
+void SPLFFTPlan<T>::clearCache(void) throw()
+{
+	Cache &cache = getCache();
+	std::lock_guard<std::mutex> lock(cache.mutex);
+	cache.plans.clear();
+}
+
+/************************************************************************************************
+ ** SPLSpectrum class implementation
+ ************************************************************************************************/
+template <class T>
+std::complex<T> SPLSpectrum<T>::operator () (const SPLindex x, const SPLindex y, const SPLindex z) const throw()
+{
+	const SPLVector3i &c = this->coefficients;
+	assert(x >= 0 && x < c.x && y >= 0 && y < c.y && z >= 0 && z < c.z);
+	const size_t i = size_t((SPLint64(z) * c.y + y) * c.x + x);
+	return std::complex<T>(this->re[i], this->im[i]);
+}
+
+template <class T>
+bool SPLSpectrum<T>::setup(const SPLVector3i &size, const bool half) throw()
+{
+	if (!SPLFFTPlan<T>::isSupported(size.x) || !SPLFFTPlan<T>::isSupported(size.y) || !SPLFFTPlan<T>::isSupported(size.z))
+	{
+		return false;
+	}
+	this->size = size;
+	this->half = half;
+	this->coefficients = SPLVector3i(half ? size.x / 2 + 1 : size.x, size.y, size.z);
+	const size_t n = size_t(this->coefficients.x) * size_t(size.y) * size_t(size.z);
+	this->re.resize(n);
+	this->im.resize(n);
+	return true;
+}
+
+template <class T>
+template <class V>
+bool SPLSpectrum<T>::forward(const SPLGrid<V> &g, SPLThreadPool &pool) throw()
+{
+	const SPLVector3i &n = g.getSize();
+	const SPLint64 count = SPLint64(n.x) * n.y * n.z;
+	if (count <= 0)
+	{
+		return false;
+	}
+	std::vector<V> values((size_t(count)));
+	std::vector<T> v((size_t(count)));
+	g.toLinear(&values[0], pool);
+	splConvert(&values[0], &v[0], count, 1.0, 0.0, pool);
+	return this->forward(&v[0], n, pool);
+}
+
+template <class T>
+bool SPLSpectrum<T>::forward(const T *v, const SPLVector3i &size, SPLThreadPool &pool) throw()
+{
+	if (!this->setup(size, true))
+	{
+		return false;
+	}
+	this->transformRows(v, pool);
+	transformLines(&this->re[0], &this->im[0], this->coefficients, 1, false, pool);
+	transformLines(&this->re[0], &this->im[0], this->coefficients, 2, false, pool);
+	return true;
+}
+
+template <class T>
+bool SPLSpectrum<T>::forward(const T *re, const T *im, const SPLVector3i &size, SPLThreadPool &pool) throw()
+{
+	if (!this->setup(size, false))
+	{
+		return false;
+	}
+	memcpy(&this->re[0], re, this->re.size() * sizeof(T));
+	memcpy(&this->im[0], im, this->im.size() * sizeof(T));
+	for (SPLindex axis = 0; axis < 3; axis++)
+	{
+		transformLines(&this->re[0], &this->im[0], this->coefficients, axis, false, pool);
+	}
+	return true;
+}
+
+template <class T>
+bool SPLSpectrum<T>::inverse(SPLGrid<T> &g, const SPLenum layout, const SPLsizei brick, SPLThreadPool &pool) const throw()
+{
+	std::vector<T> v(size_t(this->size.x) * size_t(this->size.y) * size_t(this->size.z));
+	if (v.empty() || !this->inverse(&v[0], pool) || !g.resize(this->size, layout, brick))
+	{
+		return false;
+	}
+	g.fromLinear(&v[0], pool);
+	return true;
+}
+
+template <class T>
+bool SPLSpectrum<T>::inverse(T *v, SPLThreadPool &pool) const throw()
+{
+	if (!this->half || this->re.empty())
+	{
+		return false;
+	}
+	std::vector<T> re(this->re), im(this->im);
+	transformLines(&re[0], &im[0], this->coefficients, 2, true, pool);
+	transformLines(&re[0], &im[0], this->coefficients, 1, true, pool);
+	this->inverseRows(&re[0], &im[0], v, pool);
+	return true;
+}
+
+template <class T>
+bool SPLSpectrum<T>::inverse(T *re, T *im, SPLThreadPool &pool) const throw()
+{
+	if (this->half || this->re.empty())
+	{
+		return false;
+	}
+	memcpy(re, &this->re[0], this->re.size() * sizeof(T));
+	memcpy(im, &this->im[0], this->im.size() * sizeof(T));
+	for (SPLindex axis = 2; axis >= 0; axis--)
+	{
+		transformLines(re, im, this->coefficients, axis, true, pool);
+	}
+	const SPLint64 n = SPLint64(this->re.size());
+	const T s = T(1) / T(n);
+	pool.parallelFor(0, n, pool.getGrain(n, 4096), [&](const SPLint64 first, const SPLint64 last)
+	{
+		for (SPLint64 i = first; i < last; i++)
+		{
+			re[i] *= s;
+			im[i] *= s;
+		}
+	});
+	return true;
+}
+
+template <class T>
+void SPLSpectrum<T>::multiply(const SPLSpectrum<T> &s, const bool conjugate, SPLThreadPool &pool) throw()
+{
+	assert(s.coefficients == this->coefficients && s.half == this->half);
+	const SPLint64 n = SPLint64(this->re.size());
+	T *ar = &this->re[0], *ai = &this->im[0];
+	const T *br = &s.re[0], *bi = &s.im[0];
+	const T sign = conjugate ? T(-1) : T(1);
+	pool.parallelFor(0, n, pool.getGrain(n, 4096), [&](const SPLint64 first, const SPLint64 last)
+	{
+		splSimdForEach<T>(SPLsizei(last - first), [&](auto simd, const SPLindex i)
+		{
+			typedef decltype(simd) S;
+			typename S::Type r = S::load(ar + first + i), m = S::load(ai + first + i);
+			SPLFFTDetail::multiply<S>(r, m, S::load(br + first + i), S::mul(S::set(sign), S::load(bi + first + i)));
+			S::store(ar + first + i, r);
+			S::store(ai + first + i, m);
+		});
+	});
+}
+
+template <class T>
+void SPLSpectrum<T>::transformRows(const T *v, SPLThreadPool &pool) throw()
+{
+	// two real rows are the real and the imaginary part of one complex row
+	const SPLsizei n = this->size.x, h = this->coefficients.x;
+	const SPLint64 rows = SPLint64(this->size.y) * this->size.z, pairs = (rows + 1) / 2;
+	const std::shared_ptr<const SPLFFTPlan<T> > plan = SPLFFTPlan<T>::get(n);
+	pool.parallelFor(0, pairs, pool.getGrain(pairs, MAX(1, 2048 / n)), [&](const SPLint64 first, const SPLint64 last)
+	{
+		std::vector<T> buffer(size_t(n) * 4);
+		T *zr = &buffer[0], *zi = zr + n, *wr = zi + n, *wi = wr + n;
+		for (SPLint64 p = first; p < last; p++)
+		{
+			const bool two = (2 * p + 1 < rows);
+			memcpy(zr, v + 2 * p * n, size_t(n) * sizeof(T));
+			if (two)
+			{
+				memcpy(zi, v + (2 * p + 1) * n, size_t(n) * sizeof(T));
+			}
+			else
+			{
+				memset(zi, 0, size_t(n) * sizeof(T));
+			}
+			plan->forward(zr, zi, wr, wi);
+
+			// X0 = (Z_k + conj(Z_n-k)) / 2 and X1 = (Z_k - conj(Z_n-k)) / 2i
+			T *x0r = &this->re[size_t(2 * p * h)], *x0i = &this->im[size_t(2 * p * h)];
+			T *x1r = two ? x0r + h : 0, *x1i = two ? x0i + h : 0;
+			for (SPLindex k = 0; k < h; k++)
+			{
+				const SPLindex j = (n - k) % n;
+				const T ar = zr[k], ai = zi[k], br = zr[j], bi = zi[j];
+				x0r[k] = T(0.5) * (ar + br);
+				x0i[k] = T(0.5) * (ai - bi);
+				if (two)
+				{
+					x1r[k] = T(0.5) * (ai + bi);
+					x1i[k] = T(0.5) * (br - ar);
+				}
+			}
+		}
+	});
+}
+
+template <class T>
+void SPLSpectrum<T>::inverseRows(T *re, T *im, T *v, SPLThreadPool &pool) const throw()
+{
+	// the full spectra of two rows are the real and the imaginary part of one complex spectrum
+	const SPLsizei n = this->size.x, h = this->coefficients.x;
+	const SPLint64 rows = SPLint64(this->size.y) * this->size.z, pairs = (rows + 1) / 2;
+	const T s = T(1) / (T(n) * T(this->size.y) * T(this->size.z));
+	const std::shared_ptr<const SPLFFTPlan<T> > plan = SPLFFTPlan<T>::get(n);
+	pool.parallelFor(0, pairs, pool.getGrain(pairs, MAX(1, 2048 / n)), [&](const SPLint64 first, const SPLint64 last)
+	{
+		std::vector<T> buffer(size_t(n) * 4);
+		T *zr = &buffer[0], *zi = zr + n, *wr = zi + n, *wi = wr + n;
+		for (SPLint64 p = first; p < last; p++)
+		{
+			const bool two = (2 * p + 1 < rows);
+			const T *x0r = re + 2 * p * h, *x0i = im + 2 * p * h, *x1r = x0r + h, *x1i = x0i + h;
+			for (SPLindex k = 0; k < n; k++)
+			{
+				// the upper half is conjugate to the lower half
+				const SPLindex j = (k < h) ? k : n - k;
+				const T c = (k < h) ? T(1) : T(-1);
+				const T ar = x0r[j], ai = c * x0i[j], br = two ? x1r[j] : T(0), bi = two ? c * x1i[j] : T(0);
+				zr[k] = ar - bi;
+				zi[k] = ai + br;
+			}
+			plan->inverse(zr, zi, wr, wi);
+			T *d = v + 2 * p * n;
+			for (SPLindex k = 0; k < n; k++)
+			{
+				d[k] = zr[k] * s;
+			}
+			if (two)
+			{
+				for (SPLindex k = 0; k < n; k++)
+				{
+					d[n + k] = zi[k] * s;
+				}
+			}
+		}
+	});
+}
+
+template <class T>
+void SPLSpectrum<T>::transformLines(T *re, T *im, const SPLVector3i &size, const SPLindex axis, const bool inverse,
+									SPLThreadPool &pool) throw()
+{
+	const SPLsizei n = size[axis];
+	if (n == 1)
+	{
+		return;
+	}
+	const std::shared_ptr<const SPLFFTPlan<T> > plan = SPLFFTPlan<T>::get(n);
+	const SPLint64 stride = (axis == 0) ? 1 : ((axis == 1) ? size.x : SPLint64(size.x) * size.y);
+	const SPLsizei width = (axis == 0) ? 1 : SPL_FFT_LANES;
+	const SPLint64 tiles = (axis == 0) ? 1 : (size.x + width - 1) / width;
+	const SPLint64 slices = (axis == 0) ? SPLint64(size.y) * size.z : ((axis == 1) ? size.z : size.y);
+	const SPLint64 blocks = tiles * slices;
+	pool.parallelFor(0, blocks, pool.getGrain(blocks, MAX(1, 2048 / (n * width))), [&](const SPLint64 first, const SPLint64 last)
+	{
+		std::vector<T> buffer(size_t(n) * size_t(4 * width));
+		T *tr = &buffer[0], *ti = tr + n * width, *wr = ti + n * width, *wi = wr + n * width;
+		for (SPLint64 b = first; b < last; b++)
+		{
+			// the rows (x), the tiles of the z slices (y) or the tiles of the y slices (z)
+			const SPLint64 x0 = (b % tiles) * width, slice = b / tiles;
+			const SPLsizei lanes = SPLsizei(MIN(SPLint64(width), size.x - x0));
+			const SPLint64 base = slice * ((axis == 1) ? SPLint64(size.x) * size.y : size.x) + x0;
+			if (axis == 0)
+			{
+				if (inverse)
+				{
+					plan->inverse(re + base, im + base, wr, wi);
+				}
+				else
+				{
+					plan->forward(re + base, im + base, wr, wi);
+				}
+				continue;
+			}
+
+			// the lines of a tile are interleaved, the butterflies run over them
+			SPLFFTDetail::copyTile(re, tr, base, stride, n, lanes, true);
+			SPLFFTDetail::copyTile(im, ti, base, stride, n, lanes, true);
+			if (inverse)
+			{
+				plan->inverseLines(tr, ti, wr, wi, lanes);
+			}
+			else
+			{
+				plan->forwardLines(tr, ti, wr, wi, lanes);
+			}
+			SPLFFTDetail::copyTile(re, tr, base, stride, n, lanes, false);
+			SPLFFTDetail::copyTile(im, ti, base, stride, n, lanes, false);
+		}
+	});
+}
+
+/************************************************************************************************
+ ** Functions
+ ************************************************************************************************/
+inline SPLenum splGetConvolutionMethod(const SPLVector3i &size, const SPLVector3i &kernel) throw()
+{
+	// the taps per voxel of the padded grid against the cost of the transforms, the SIMD width speeds the taps up more
+	const SPLVector3i r((kernel.x - 1) / 2, (kernel.y - 1) / 2, (kernel.z - 1) / 2), m = SPLFFTDetail::padded(size, r, true);
+	const SPLieee64 voxels = SPLieee64(size.x) * size.y * size.z, transformed = SPLieee64(m.x) * m.y * m.z;
+	const SPLieee64 taps = SPLieee64(kernel.x) * kernel.y * kernel.z, width = MAX(4, SPLsizei(SPLSimd<SPLieee32>::width));
+	return (taps * voxels > width * std::log2(transformed) * transformed) ? SPL_CONVOLUTION_SPECTRAL : SPL_CONVOLUTION_DIRECT;
+}
+
+template <class T>
+bool splConvolve(const SPLGrid<T> &in, const SPLGrid<SPLieee32> &kernel, SPLGrid<SPLieee32> &out, const SPLenum border,
+				 const SPLenum method, SPLThreadPool &pool) throw()
+{
+	return SPLFFTDetail::convolve(in, kernel, out, border, method, false, pool);
+}
+
+template <class T>
+bool splCorrelate(const SPLGrid<T> &in, const SPLGrid<SPLieee32> &kernel, SPLGrid<SPLieee32> &out, const SPLenum border,
+				  const SPLenum method, SPLThreadPool &pool) throw()
+{
+	return SPLFFTDetail::convolve(in, kernel, out, border, method, true, pool);
+}
+
+#endif /* _spl_fft_hh_ */
@@ -0,0 +1,849 @@
+#ifndef _spl_filtervariationalsr_hh_
+#define _spl_filtervariationalsr_hh_
+
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#include <spl/typesbase.hh>
+#include <spl/mathbase.hh>
+#include <spl/threadpool.hh>
+#include <spl/vector3.hh>
+#include <spl/grid.hh>
+
+#define SPL_VARIATIONALSR_COUPLING 32.0f	//!< Smallest penalty \f$ \mu \f$ for which the automatic number of levels coarsens.
+
+/*! \file filtervariationalsr.hh
+ * */
+
+namespace SPLFilterVariationalSRDetail
+{
+	//! The channels of a gray value.
+	template <class T>
+	struct Channels
+	{
+		enum { count = 1 };
+		static SPLieee32 get(const T &v, const SPLindex) throw() { return SPLieee32(v); }
+	};
+
+	//! The red, green and blue channels of a color.
+	template <class T>
+	struct Channels<SPLVector3<T> >
+	{
+		enum { count = 3 };
+		static SPLieee32 get(const SPLVector3<T> &v, const SPLindex c) throw() { return SPLieee32((c == 0) ? v.x : ((c == 1) ? v.y : v.z)); }
+	};
+
+	//! A level of the multigrid hierarchy.
+	struct Level
+	{
+		SPLVector3i size;				//!< Number of cells.
+		SPLieee32 coupling;				//!< The penalty over the squared cell size.
+		std::vector<SPLieee32> w;		//!< The solution.
+		std::vector<SPLieee32> b;		//!< The right hand side.
+		std::vector<SPLieee32> r;		//!< The residual.
+	};
+}
+
+/*! \class SPLFilterVariationalSR
+ * \brief Two-region variational segmentation of gray and color images.
+ *
+ * Segments an image \f$ f \f$ into a region \f$ E \f$ with the mean
+ * \f$ c_1 \f$ and the rest with the mean \f$ c_2 \f$ by minimizing the
+ * Chan-Vese energy
+ * \f[
+ * \lambda \, {\rm Per}(E) + \int_E \| f - c_1 \|^2 + \int_{\Omega \setminus E} \| f - c_2 \|^2.
+ * \f]
+ * For fixed means the minimal region is the positive set \f$ \{ w > 0 \} \f$
+ * of the solution of the ROF problem
+ * \f[
+ * \min_w \lambda \int \| \nabla w \| + \frac{1}{2} \int (w - g)^2,
+ * \quad g = \| f - c_2 \|^2 - \| f - c_1 \|^2,
+ * \f]
+ * where \f$ g \f$ is normalized to \f$ [-1, 1] \f$, i.e. \f$ \lambda \f$
+ * is relative to the largest data term. The ROF problem is solved by
+ * split Bregman iterations with the penalty \f$ \mu \f$: every
+ * iteration shrinks the split gradient \f$ d \approx \nabla w \f$
+ * voxel by voxel and approximates the solution of the linear system
+ * \f$ (I - \mu \Delta) w = g - \mu \, {\rm div}(d - b) \f$ by one
+ * multigrid V-cycle (cell-centered, two red-black Gauss-Seidel sweeps
+ * before and after the coarse grid correction, see \ref setLevels).
+ * Solving the system more accurately does not save iterations, but the
+ * iterations are accelerated by the extrapolation of the last two with
+ * a restart whenever the combined residual of \f$ d \f$ and \f$ b \f$
+ * grows (Goldstein et al., "Fast alternating direction optimization
+ * methods", 2014). The relaxation processes the rows of a color on the
+ * threads of a \ref SPLThreadPool. The means are updated whenever the
+ * iterations converged, until the segmentation does not change anymore.
+ *
+ * \ref SPLFilterVariationalSR2d segments every slice \f$ z \f$ of a
+ * grid on its own (a stack of 2D images): the means and the
+ * normalization of \f$ g \f$ belong to the slice and the perimeter
+ * does not couple the slices. A slice with a single region is the rest.
+ * \ref SPLFilterVariationalSR3d segments the volume.
+ *
+ * Example
+ * \code
+ * SPLGrid<SPLVector3<SPLuint8> > image;
+ * SPLGrid<SPLuint8> segmentation;
+ * splReadPNM("image.ppm", image);
+ *
+ * SPLFilterVariationalSR2d filter;
+ * filter.setLambda(0.2f);
+ * filter.apply(image, segmentation);
+ * \endcode
+ *
+ * \sa SPLGrid
+ */
+class SPLFilterVariationalSR
+{
+public:
+	/*! \brief Constructor!
+	 *
+	 * Initializes \f$ \lambda = 0.1 \f$, \f$ \mu = 1 \f$, a
+	 * tolerance of \f$ 10^{-3} \f$, at most 200 iterations and an
+	 * automatic number of levels.
+	 *
+	 * \param dimension 2 (slices) or 3 (volumes).
+	 */
+	explicit SPLFilterVariationalSR(const SPLsizei dimension = 3) throw();
+
+	/*! \brief Returns the dimension!
+	 *
+	 * \return 2 (slices) or 3 (volumes).
+	 */
+	SPLsizei getDimension(void) const throw() { return this->dimension; }
+
+	/*! \brief Sets the weight of the perimeter!
+	 *
+	 * \param lambda The weight \f$ \lambda > 0 \f$ relative to the largest data term.
+	 */
+	void setLambda(const SPLieee32 lambda) throw() { assert(lambda > 0.0f); this->lambda = lambda; }
+
+	/*! \brief Returns the weight of the perimeter!
+	 *
+	 * \return The weight \f$ \lambda \f$.
+	 */
+	SPLieee32 getLambda(void) const throw() { return this->lambda; }
+
+	/*! \brief Sets the penalty of the split Bregman iterations!
+	 *
+	 * Only changes the speed of the convergence, not the solution.
+	 *
+	 * \param mu The penalty \f$ \mu > 0 \f$.
+	 */
+	void setPenalty(const SPLieee32 mu) throw() { assert(mu > 0.0f); this->mu = mu; }
+
+	/*! \brief Returns the penalty of the split Bregman iterations!
+	 *
+	 * \return The penalty \f$ \mu \f$.
+	 */
+	SPLieee32 getPenalty(void) const throw() { return this->mu; }
+
+	/*! \brief Sets the tolerance of the iterations!
+	 *
+	 * The iterations converged if no value of \f$ w \f$ changed by more
+	 * than the tolerance.
+	 *
+	 * \param tolerance The tolerance.
+	 */
+	void setTolerance(const SPLieee32 tolerance) throw() { assert(tolerance > 0.0f); this->tolerance = tolerance; }
+
+	/*! \brief Returns the tolerance of the iterations!
+	 *
+	 * \return The tolerance.
+	 */
+	SPLieee32 getTolerance(void) const throw() { return this->tolerance; }
+
+	/*! \brief Sets the maximum number of iterations!
+	 *
+	 * \param iterations The maximum number of iterations of all updates of the means.
+	 */
+	void setMaxIterations(const SPLsizei iterations) throw() { assert(iterations > 0); this->maxIterations = iterations; }
+
+	/*! \brief Returns the maximum number of iterations!
+	 *
+	 * \return The maximum number of iterations.
+	 */
+	SPLsizei getMaxIterations(void) const throw() { return this->maxIterations; }
+
+	/*! \brief Sets the number of multigrid levels!
+	 *
+	 * The coarse grid correction only pays for large penalties, for
+	 * small ones the identity dominates the linear system and the
+	 * relaxation alone damps the smooth errors.
+	 *
+	 * \param levels The number of levels, \c 1 relaxes the finest level
+	 * only and \c 0 relaxes the finest level only for penalties below
+	 * \ref SPL_VARIATIONALSR_COUPLING, otherwise it coarsens while the
+	 * coupling \f$ \mu / h^2 \f$ of a level is at least 4 and it has at
+	 * least 8 cells along every axis.
+	 */
+	void setLevels(const SPLsizei levels) throw() { assert(levels >= 0); this->levels = levels; }
+
+	/*! \brief Returns the number of multigrid levels!
+	 *
+	 * \return The number of levels or \c 0 (automatic).
+	 */
+	SPLsizei getLevels(void) const throw() { return this->levels; }
+
+	/*! \brief Returns the number of iterations of the last segmentation!
+	 *
+	 * \return Number of V-cycles.
+	 */
+	SPLsizei getIterations(void) const throw() { return this->iterations; }
+
+	/*! \brief Returns the number of updates of the means of the last segmentation!
+	 *
+	 * \return Number of updates.
+	 */
+	SPLsizei getUpdates(void) const throw() { return this->updates; }
+
+	/*! \brief Returns a mean of the last segmentation!
+	 *
+	 * \param region \c 1 for the segmented region and \c 0 for the rest.
+	 * \param channel The channel (0 for gray images).
+	 * \param slice The slice \f$ z \f$ of \ref SPLFilterVariationalSR2d, 0 for volumes.
+	 *
+	 * \return The mean \f$ c_1 \f$ or \f$ c_2 \f$ of the channel.
+	 */
+	SPLieee64 getMean(const SPLindex region, const SPLindex channel = 0, const SPLindex slice = 0) const throw();
+
+	/*! \brief Segments an image!
+	 *
+	 * The segmented region starts as the values above the mean of the
+	 * slice or the volume (the mean of the channels of colors), i.e. is
+	 * the brighter one.
+	 *
+	 * \param image Gray values or colors (\ref SPLVector3).
+	 * \param segmentation The segmentation with the size and layout of
+	 * the image, \c 1 in the segmented region and \c 0 elsewhere.
+	 * \param pool The threads.
+	 *
+	 * \return \c true on success and \c false otherwise.
+	 */
+	template <class T>
+	bool apply(const SPLGrid<T> &image, SPLGrid<SPLuint8> &segmentation, SPLThreadPool &pool = SPLThreadPool::getGlobal()) throw();
+
+private:
+	typedef SPLFilterVariationalSRDetail::Level Level;
+
+	bool setup(const SPLVector3i &size) throw();
+	template <class F>
+	void forRows(const Level &l, SPLThreadPool &pool, const F &f) const throw();
+	void accumulate(const Level &l, const SPLindex x, const SPLindex y, const SPLindex z, const SPLint64 i,
+					SPLieee32 &count, SPLieee32 &sum) const throw();
+	void relax(Level &l, const SPLindex color, SPLThreadPool &pool) const throw();
+	void restrictResidual(Level &fine, Level &coarse, SPLThreadPool &pool) const throw();
+	void prolongate(const Level &coarse, Level &fine, SPLThreadPool &pool) const throw();
+	void cycle(const SPLindex level, SPLThreadPool &pool) throw();
+	template <SPLsizei D>
+	void divergence(SPLThreadPool &pool) throw();
+	template <SPLsizei D>
+	SPLieee32 shrink(SPLThreadPool &pool) throw();
+	void accelerate(const SPLieee64 residual) throw();
+	bool means(const std::vector<SPLieee32> &f, const SPLsizei channels, SPLThreadPool &pool) throw();
+	void data(const std::vector<SPLieee32> &f, const SPLsizei channels, SPLThreadPool &pool) throw();
+	SPLint64 segment(SPLThreadPool &pool) throw();
+
+	SPLsizei dimension;					//!< 2 or 3.
+	SPLieee32 lambda;					//!< Weight of the perimeter.
+	SPLieee32 mu;						//!< Penalty of the split gradient.
+	SPLieee32 tolerance;				//!< Tolerance of the iterations.
+	SPLsizei maxIterations;				//!< Maximum number of iterations.
+	SPLsizei levels;					//!< Number of levels or 0.
+	SPLsizei iterations;				//!< Iterations of the last segmentation.
+	SPLsizei updates;					//!< Updates of the means of the last segmentation.
+	std::vector<SPLieee64> mean;		//!< Means of the channels of the rest and of the region, per slice for 2D.
+	std::vector<Level> hierarchy;		//!< The levels, the finest first.
+	std::vector<SPLieee32> g;			//!< The normalized data term.
+	std::vector<SPLieee32> d;			//!< The split gradient, one component after another.
+	std::vector<SPLieee32> bregman;		//!< The Bregman variable of the split gradient.
+	std::vector<SPLieee32> dLast;		//!< The split gradient of the last iteration.
+	std::vector<SPLieee32> bLast;		//!< The Bregman variable of the last iteration.
+	SPLieee32 extrapolation[2];			//!< The weights of the current and the last iteration in the extrapolation.
+	SPLieee64 step;						//!< The step of the accelerated iterations.
+	SPLieee64 residual;					//!< The combined residual which the next iteration has to reduce.
+	std::vector<SPLieee32> previous;	//!< The solution of the last iteration.
+	std::vector<SPLuint8> mask;			//!< The segmentation.
+	std::vector<SPLieee64> rows;		//!< Partial results of the rows.
+};
+
+/*! \class SPLFilterVariationalSR2d
+ * \brief Two-region variational segmentation of the slices of a grid.
+ *
+ * \sa SPLFilterVariationalSR
+ */
+class SPLFilterVariationalSR2d : public SPLFilterVariationalSR
+{
+public:
+	/*! \brief Constructor!
+	 */
+	SPLFilterVariationalSR2d(void) throw() : SPLFilterVariationalSR(2) {}
+};
+
+/*! \class SPLFilterVariationalSR3d
+ * \brief Two-region variational segmentation of a volume.
+ *
+ * \sa SPLFilterVariationalSR
+ */
+class SPLFilterVariationalSR3d : public SPLFilterVariationalSR
+{
+public:
+	/*! \brief Constructor!
+	 */
+	SPLFilterVariationalSR3d(void) throw() : SPLFilterVariationalSR(3) {}
+};
+
+/************************************************************************************************
+ ** SPLFilterVariationalSR class implementation
+ ************************************************************************************************/
+inline SPLFilterVariationalSR::SPLFilterVariationalSR(const SPLsizei dimension) throw()
+{
+	assert(dimension == 2 || dimension == 3);
+	this->dimension = dimension;
+	this->lambda = 0.1f;
+	this->mu = 1.0f;
+	this->tolerance = 1.0e-3f;
+	this->maxIterations = 200;
+	this->levels = 0;
+	this->iterations = 0;
+	this->updates = 0;
+}
+
+inline SPLieee64 SPLFilterVariationalSR::getMean(const SPLindex region, const SPLindex channel, const SPLindex slice) const throw()
+{
+	assert(region >= 0 && region < 2 && channel >= 0 && channel < 3 && slice >= 0);
+	const size_t i = size_t(slice * 6 + region * 3 + channel);
+	return (i < this->mean.size()) ? this->mean[i] : 0.0;
+}
+
+template <class T>
+bool SPLFilterVariationalSR::apply(const SPLGrid<T> &image, SPLGrid<SPLuint8> &segmentation, SPLThreadPool &pool) throw()
+{
+	typedef SPLFilterVariationalSRDetail::Channels<T> C;
+	const SPLVector3i &size = image.getSize();
+	this->iterations = 0;
+	this->updates = 0;
+	if (size.x <= 0 || size.y <= 0 || size.z <= 0 || !this->setup(size))
+	{
+		return false;
+	}
+
+	// the channels one after another
+	const SPLint64 n = SPLint64(size.x) * size.y * size.z;
+	std::vector<T> values((size_t(n)));
+	std::vector<SPLieee32> f(size_t(n) * C::count, 0.0f);
+	image.toLinear(&values[0], pool);
+	pool.parallelFor(0, n, pool.getGrain(n, 4096), [&](const SPLint64 first, const SPLint64 last)
+	{
+		for (SPLint64 i = first; i < last; i++)
+		{
+			for (SPLindex c = 0; c < C::count; c++)
+			{
+				f[size_t(c * n + i)] = C::get(values[size_t(i)], c);
+			}
+		}
+	});
+
+	// the values above the mean of a slice (2D) or of the volume
+	const SPLsizei slices = (this->dimension == 2) ? size.z : 1;
+	const SPLint64 cells = n / slices;
+	std::vector<SPLieee32> average((size_t(slices)));
+	for (SPLsizei k = 0; k < slices; k++)
+	{
+		SPLieee64 sum = 0.0;
+		for (SPLindex c = 0; c < C::count; c++)
+		{
+			for (SPLint64 i = k * cells; i < (k + 1) * cells; i++)
+			{
+				sum += f[size_t(c * n + i)];
+			}
+		}
+		average[size_t(k)] = SPLieee32(sum / SPLieee64(cells));
+	}
+	pool.parallelFor(0, n, pool.getGrain(n, 4096), [&](const SPLint64 first, const SPLint64 last)
+	{
+		for (SPLint64 i = first; i < last; i++)
+		{
+			SPLieee32 s = 0.0f;
+			for (SPLindex c = 0; c < C::count; c++)
+			{
+				s += f[size_t(c * n + i)];
+			}
+			this->mask[size_t(i)] = (s > average[size_t(i / cells)]) ? 1 : 0;
+		}
+	});
+
+	Level &l = this->hierarchy[0];
+	while (this->iterations < this->maxIterations && this->means(f, C::count, pool))
+	{
+		this->data(f, C::count, pool);
+		if (this->updates++ == 0)
+		{
+			l.w = this->g;
+		}
+		this->extrapolation[0] = 1.0f;
+		this->extrapolation[1] = 0.0f;
+		this->step = 1.0;
+		this->residual = HUGE_VAL;
+		while (this->iterations < this->maxIterations)
+		{
+			(this->dimension == 2) ? this->divergence<2>(pool) : this->divergence<3>(pool);
+			this->cycle(0, pool);
+			this->iterations++;
+			if (((this->dimension == 2) ? this->shrink<2>(pool) : this->shrink<3>(pool)) < this->tolerance)
+			{
+				break;
+			}
+		}
+		if (this->segment(pool) == 0)
+		{
+			break;
+		}
+	}
+
+	if (!segmentation.resize(size, image.getLayout(), image.getBrickSize()))
+	{
+		return false;
+	}
+	segmentation.fromLinear(&this->mask[0], pool);
+	return true;
+}
+
+inline bool SPLFilterVariationalSR::setup(const SPLVector3i &size) throw()
+{
+	// coarsen while a level has at least 8 cells along the axes, the slices are not coarsened along z
+	const bool depth = (this->dimension == 3);
+	SPLsizei count = 1;
+	SPLVector3i s = size;
+	SPLieee32 coupling = this->mu;
+	const bool coarsen = (this->levels == 0 && this->mu >= SPL_VARIATIONALSR_COUPLING);
+	while ((coarsen ? coupling >= 4.0f : count < this->levels) && s.x >= 8 && s.y >= 8 && (!depth || s.z >= 8))
+	{
+		s = SPLVector3i((s.x + 1) / 2, (s.y + 1) / 2, depth ? (s.z + 1) / 2 : s.z);
+		coupling *= 0.25f;
+		count++;
+	}
+
+	this->hierarchy.resize(size_t(count));
+	s = size;
+	coupling = this->mu;
+	for (SPLsizei i = 0; i < count; i++)
+	{
+		Level &l = this->hierarchy[size_t(i)];
+		const size_t n = size_t(s.x) * size_t(s.y) * size_t(s.z);
+		l.size = s;
+		l.coupling = coupling;
+		l.w.assign(n, 0.0f);
+		l.b.assign(n, 0.0f);
+		l.r.assign(n, 0.0f);
+		s = SPLVector3i((s.x + 1) / 2, (s.y + 1) / 2, depth ? (s.z + 1) / 2 : s.z);
+		coupling *= 0.25f;
+	}
+	const size_t n = this->hierarchy[0].w.size();
+	this->g.assign(n, 0.0f);
+	this->d.assign(n * size_t(this->dimension), 0.0f);
+	this->bregman.assign(n * size_t(this->dimension), 0.0f);
+	this->dLast.assign(n * size_t(this->dimension), 0.0f);
+	this->bLast.assign(n * size_t(this->dimension), 0.0f);
+	this->previous.assign(n, 0.0f);
+	this->mask.assign(n, 0);
+	this->rows.assign(size_t(size.y) * size_t(size.z) * 8, 0.0);
+	this->mean.assign(size_t(depth ? 1 : size.z) * 6, 0.0);
+	return true;
+}
+
+template <class F>
+void SPLFilterVariationalSR::forRows(const Level &l, SPLThreadPool &pool, const F &f) const throw()
+{
+	const SPLint64 rows = SPLint64(l.size.y) * l.size.z;
+	pool.parallelFor(0, rows, pool.getGrain(rows, MAX(1, 4096 / l.size.x)), [&](const SPLint64 first, const SPLint64 last)
+	{
+		for (SPLint64 r = first; r < last; r++)
+		{
+			f(r, SPLindex(r % l.size.y), SPLindex(r / l.size.y));
+		}
+	});
+}
+
+inline void SPLFilterVariationalSR::accumulate(const Level &l, const SPLindex x, const SPLindex y, const SPLindex z, const SPLint64 i,
+											   SPLieee32 &count, SPLieee32 &sum) const throw()
+{
+	// the number and the sum of the neighbors (Neumann boundary)
+	const SPLint64 sy = l.size.x, sz = SPLint64(l.size.x) * l.size.y;
+	const SPLieee32 *w = &l.w[0];
+	count = 0.0f;
+	sum = 0.0f;
+	if (x > 0) { count += 1.0f; sum += w[i - 1]; }
+	if (x + 1 < l.size.x) { count += 1.0f; sum += w[i + 1]; }
+	if (y > 0) { count += 1.0f; sum += w[i - sy]; }
+	if (y + 1 < l.size.y) { count += 1.0f; sum += w[i + sy]; }
+	if (this->dimension == 3)
+	{
+		if (z > 0) { count += 1.0f; sum += w[i - sz]; }
+		if (z + 1 < l.size.z) { count += 1.0f; sum += w[i + sz]; }
+	}
+}
+
+inline void SPLFilterVariationalSR::relax(Level &l, const SPLindex color, SPLThreadPool &pool) const throw()
+{
+	// Gauss-Seidel of the cells of one color, which only couple with the other color
+	this->forRows(l, pool, [&](const SPLint64 r, const SPLindex y, const SPLindex z)
+	{
+		const SPLint64 row = r * l.size.x;
+		for (SPLindex x = (y + z + color) & 1; x < l.size.x; x += 2)
+		{
+			SPLieee32 count, sum;
+			this->accumulate(l, x, y, z, row + x, count, sum);
+			l.w[size_t(row + x)] = (l.b[size_t(row + x)] + l.coupling * sum) / (1.0f + l.coupling * count);
+		}
+	});
+}
+
+inline void SPLFilterVariationalSR::restrictResidual(Level &fine, Level &coarse, SPLThreadPool &pool) const throw()
+{
+	this->forRows(fine, pool, [&](const SPLint64 r, const SPLindex y, const SPLindex z)
+	{
+		const SPLint64 row = r * fine.size.x;
+		for (SPLindex x = 0; x < fine.size.x; x++)
+		{
+			SPLieee32 count, sum;
+			const SPLint64 i = row + x;
+			this->accumulate(fine, x, y, z, i, count, sum);
+			fine.r[size_t(i)] = fine.b[size_t(i)] - fine.w[size_t(i)] - fine.coupling * (count * fine.w[size_t(i)] - sum);
+		}
+	});
+
+	// the means of the children
+	const SPLint64 sy = fine.size.x, sz = SPLint64(fine.size.x) * fine.size.y;
+	const SPLindex dz = (coarse.size.z == fine.size.z) ? 1 : 2;
+	this->forRows(coarse, pool, [&](const SPLint64 r, const SPLindex y, const SPLindex z)
+	{
+		const SPLint64 row = r * coarse.size.x;
+		const SPLindex y1 = MIN(2 * y + 2, fine.size.y), z0 = dz * z, z1 = MIN(dz * z + dz, fine.size.z);
+		for (SPLindex x = 0; x < coarse.size.x; x++)
+		{
+			const SPLindex x1 = MIN(2 * x + 2, fine.size.x);
+			SPLieee32 sr = 0.0f, count = 0.0f;
+			for (SPLindex k = z0; k < z1; k++)
+			{
+				for (SPLindex j = 2 * y; j < y1; j++)
+				{
+					for (SPLindex i = 2 * x; i < x1; i++)
+					{
+						const size_t o = size_t(k * sz + j * sy + i);
+						sr += fine.r[o];
+						count += 1.0f;
+					}
+				}
+			}
+			coarse.b[size_t(row + x)] = sr / count;
+			coarse.w[size_t(row + x)] = 0.0f;
+		}
+	});
+}
+
+inline void SPLFilterVariationalSR::prolongate(const Level &coarse, Level &fine, SPLThreadPool &pool) const throw()
+{
+	// piecewise constant
+	const SPLint64 sy = coarse.size.x, sz = SPLint64(coarse.size.x) * coarse.size.y;
+	const SPLindex dz = (coarse.size.z == fine.size.z) ? 1 : 2;
+	this->forRows(fine, pool, [&](const SPLint64 r, const SPLindex y, const SPLindex z)
+	{
+		const SPLint64 row = r * fine.size.x;
+		const SPLieee32 *w = &coarse.w[size_t((z / dz) * sz + (y / 2) * sy)];
+		for (SPLindex x = 0; x < fine.size.x; x++)
+		{
+			fine.w[size_t(row + x)] += w[x / 2];
+		}
+	});
+}
+
+inline void SPLFilterVariationalSR::cycle(const SPLindex level, SPLThreadPool &pool) throw()
+{
+	Level &l = this->hierarchy[size_t(level)];
+	const SPLindex last = SPLindex(this->hierarchy.size()) - 1;
+	if (level == last)
+	{
+		// the coarsest level is relaxed until it is almost solved
+		const SPLsizei sweeps = (last == 0) ? 2 : 16;
+		for (SPLsizei s = 0; s < sweeps; s++)
+		{
+			this->relax(l, 0, pool);
+			this->relax(l, 1, pool);
+		}
+		return;
+	}
+	for (SPLsizei s = 0; s < 2; s++)
+	{
+		this->relax(l, 0, pool);
+		this->relax(l, 1, pool);
+	}
+	this->restrictResidual(l, this->hierarchy[size_t(level + 1)], pool);
+	this->cycle(level + 1, pool);
+	this->prolongate(this->hierarchy[size_t(level + 1)], l, pool);
+	for (SPLsizei s = 0; s < 2; s++)
+	{
+		this->relax(l, 1, pool);
+		this->relax(l, 0, pool);
+	}
+}
+
+template <SPLsizei D>
+void SPLFilterVariationalSR::divergence(SPLThreadPool &pool) throw()
+{
+	// the right hand side g - mu div(d - b) with the backward differences of the forward differences
+	Level &l = this->hierarchy[0];
+	const SPLint64 n = SPLint64(l.w.size()), stride[3] = { 1, l.size.x, SPLint64(l.size.x) * l.size.y };
+	const SPLieee32 *d = &this->d[0], *b = &this->bregman[0], *dl = &this->dLast[0], *bl = &this->bLast[0];
+	const SPLieee32 e0 = this->extrapolation[0], e1 = this->extrapolation[1];
+	this->forRows(l, pool, [&](const SPLint64 r, const SPLindex y, const SPLindex z)
+	{
+		// the differences vanish beyond the borders, the ones along y and z are the same for the row
+		const SPLint64 row = r * l.size.x;
+		const SPLieee32 ahead[3] = { 1.0f, (y + 1 < l.size.y) ? 1.0f : 0.0f, (z + 1 < l.size.z) ? 1.0f : 0.0f };
+		const SPLieee32 behind[3] = { 1.0f, (y > 0) ? 1.0f : 0.0f, (z > 0) ? 1.0f : 0.0f };
+		const SPLint64 back[3] = { 1, (y > 0) ? stride[1] : 0, (z > 0) ? stride[2] : 0 };
+		const auto voxel = [&](const SPLindex x, const SPLieee32 right, const SPLieee32 left)
+		{
+			const SPLint64 i = row + x;
+			SPLieee32 div = 0.0f;
+			for (SPLindex a = 0; a < D; a++)
+			{
+				const SPLint64 o = a * n + i, q = o - ((a == 0) ? SPLint64(left) : back[a]);
+				const SPLieee32 u = e0 * (d[o] - b[o]) + e1 * (dl[o] - bl[o]), v = e0 * (d[q] - b[q]) + e1 * (dl[q] - bl[q]);
+				div += ((a == 0) ? right : ahead[a]) * u - ((a == 0) ? left : behind[a]) * v;
+			}
+			l.b[size_t(i)] = this->g[size_t(i)] - this->mu * div;
+		};
+		voxel(0, (l.size.x > 1) ? 1.0f : 0.0f, 0.0f);
+		for (SPLindex x = 1; x + 1 < l.size.x; x++)
+		{
+			voxel(x, 1.0f, 1.0f);
+		}
+		if (l.size.x > 1)
+		{
+			voxel(l.size.x - 1, 0.0f, 1.0f);
+		}
+	});
+}
+
+template <SPLsizei D>
+SPLieee32 SPLFilterVariationalSR::shrink(SPLThreadPool &pool) throw()
+{
+	// the isotropic shrinkage of the gradient and the largest change since the last call
+	Level &l = this->hierarchy[0];
+	const SPLint64 stride[3] = { 1, l.size.x, SPLint64(l.size.x) * l.size.y };
+	const SPLieee32 threshold = this->lambda / this->mu, extrapolation[2] = { this->extrapolation[0], this->extrapolation[1] };
+	this->forRows(l, pool, [&](const SPLint64 r, const SPLindex y, const SPLindex z)
+	{
+		// the forward differences vanish in the last voxel of an axis, the ones along y and z are the same for the row,
+		// local copies of the constants, which the stores to the arrays may not alias
+		const SPLint64 row = r * l.size.x, n = SPLint64(l.w.size());
+		const SPLint64 ahead[3] = { 1, (y + 1 < l.size.y) ? stride[1] : 0, (z + 1 < l.size.z) ? stride[2] : 0 };
+		const SPLieee32 t = threshold, e0 = extrapolation[0], e1 = extrapolation[1];
+		const SPLieee32 *w = &l.w[0], *d = &this->d[0], *b = &this->bregman[0];
+		SPLieee32 *dl = &this->dLast[0], *bl = &this->bLast[0], *previous = &this->previous[0];
+		SPLieee32 change = 0.0f, residual = 0.0f;
+		const auto voxel = [&](const SPLindex x, const SPLint64 right)
+		{
+			const SPLint64 i = row + x;
+			SPLieee32 s[D], gradient[D], e[D], length = 0.0f;
+			for (SPLindex a = 0; a < D; a++)
+			{
+				// the gradient plus the extrapolated Bregman variable
+				const SPLint64 o = a * n + i;
+				gradient[a] = w[i + ((a == 0) ? right : ahead[a])] - w[i];
+				e[a] = e0 * d[o] + e1 * dl[o];
+				s[a] = gradient[a] + e0 * b[o] + e1 * bl[o];
+				length += s[a] * s[a];
+			}
+			// (length - t) / length or 0 without branches, which the gradients do not predict
+			length = std::sqrt(length);
+			const SPLieee32 f = MAX(length - t, 0.0f) / MAX(length, t);
+			for (SPLindex a = 0; a < D; a++)
+			{
+				// the new iteration replaces the last one, the Bregman variable changes by the gradient minus d
+				const SPLint64 o = a * n + i;
+				const SPLieee32 dn = f * s[a];
+				residual += (dn - e[a]) * (dn - e[a]) + (gradient[a] - dn) * (gradient[a] - dn);
+				dl[o] = dn;
+				bl[o] = s[a] - dn;
+			}
+			change = MAX(change, std::fabs(w[i] - previous[i]));
+			previous[i] = w[i];
+		};
+		for (SPLindex x = 0; x + 1 < l.size.x; x++)
+		{
+			voxel(x, 1);
+		}
+		voxel(l.size.x - 1, 0);
+		this->rows[size_t(2 * r)] = change;
+		this->rows[size_t(2 * r + 1)] = residual;
+	});
+	this->d.swap(this->dLast);
+	this->bregman.swap(this->bLast);
+
+	const SPLint64 rows = SPLint64(l.size.y) * l.size.z;
+	SPLieee64 change = 0.0, residual = 0.0;
+	for (SPLint64 r = 0; r < rows; r++)
+	{
+		change = MAX(change, this->rows[size_t(2 * r)]);
+		residual += this->rows[size_t(2 * r + 1)];
+	}
+	this->accelerate(residual);
+	return SPLieee32(change);
+}
+
+inline void SPLFilterVariationalSR::accelerate(const SPLieee64 residual) throw()
+{
+	// Goldstein, O'Donoghue, Setzer, Baraniuk, "Fast alternating direction optimization methods", 2014:
+	// the next iteration starts from an extrapolation of the last two while the combined residual decreases
+	const SPLieee64 eta = 0.5;
+	if (residual < eta * this->residual)
+	{
+		const SPLieee64 next = 0.5 * (1.0 + std::sqrt(1.0 + 4.0 * this->step * this->step)), beta = (this->step - 1.0) / next;
+		this->extrapolation[0] = SPLieee32(1.0 + beta);
+		this->extrapolation[1] = SPLieee32(-beta);
+		this->step = next;
+		this->residual = residual;
+	}
+	else
+	{
+		// restart from the iteration before the last one
+		this->extrapolation[0] = 0.0f;
+		this->extrapolation[1] = 1.0f;
+		this->step = 1.0;
+		this->residual /= eta;
+	}
+}
+
+inline bool SPLFilterVariationalSR::means(const std::vector<SPLieee32> &f, const SPLsizei channels, SPLThreadPool &pool) throw()
+{
+	// the counts and sums of the channels of both regions per row
+	const Level &l = this->hierarchy[0];
+	const SPLint64 n = SPLint64(l.w.size());
+	this->forRows(l, pool, [&](const SPLint64 r, const SPLindex, const SPLindex)
+	{
+		SPLieee64 *s = &this->rows[size_t(r * 8)];
+		for (SPLindex k = 0; k < 8; k++)
+		{
+			s[k] = 0.0;
+		}
+		for (SPLint64 i = r * l.size.x; i < (r + 1) * l.size.x; i++)
+		{
+			const SPLindex region = this->mask[size_t(i)];
+			s[region * 4] += 1.0;
+			for (SPLindex c = 0; c < channels; c++)
+			{
+				s[region * 4 + 1 + c] += f[size_t(c * n + i)];
+			}
+		}
+	});
+
+	// the sums of the rows of a slice (2D) or of the volume, a slice with one region gets its mean for both
+	const SPLsizei slices = SPLsizei(this->mean.size() / 6);
+	const SPLint64 rows = SPLint64(l.size.y) * l.size.z / slices;
+	bool two = false;
+	for (SPLsizei k = 0; k < slices; k++)
+	{
+		SPLieee64 s[8] = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+		for (SPLint64 r = k * rows; r < (k + 1) * rows; r++)
+		{
+			for (SPLindex j = 0; j < 8; j++)
+			{
+				s[j] += this->rows[size_t(r * 8 + j)];
+			}
+		}
+		two = two || (s[0] > 0.0 && s[4] > 0.0);
+		for (SPLindex region = 0; region < 2; region++)
+		{
+			const SPLindex present = (s[region * 4] > 0.0) ? region : 1 - region;
+			for (SPLindex c = 0; c < 3; c++)
+			{
+				this->mean[size_t(k * 6 + region * 3 + c)] = (c < channels) ? s[present * 4 + 1 + c] / s[present * 4] : 0.0;
+			}
+		}
+	}
+	return two;
+}
+
+inline void SPLFilterVariationalSR::data(const std::vector<SPLieee32> &f, const SPLsizei channels, SPLThreadPool &pool) throw()
+{
+	Level &l = this->hierarchy[0];
+	const SPLint64 n = SPLint64(l.w.size());
+	const SPLsizei slices = SPLsizei(this->mean.size() / 6);
+	this->forRows(l, pool, [&](const SPLint64 r, const SPLindex, const SPLindex z)
+	{
+		const SPLieee64 *mean = &this->mean[size_t((slices > 1) ? z * 6 : 0)];
+		SPLieee32 m[2][3];
+		for (SPLindex region = 0; region < 2; region++)
+		{
+			for (SPLindex c = 0; c < 3; c++)
+			{
+				m[region][c] = SPLieee32(mean[region * 3 + c]);
+			}
+		}
+		SPLieee32 largest = 0.0f;
+		for (SPLint64 i = r * l.size.x; i < (r + 1) * l.size.x; i++)
+		{
+			SPLieee32 g = 0.0f;
+			for (SPLindex c = 0; c < channels; c++)
+			{
+				const SPLieee32 v = f[size_t(c * n + i)], d0 = v - m[0][c], d1 = v - m[1][c];
+				g += d0 * d0 - d1 * d1;
+			}
+			this->g[size_t(i)] = g;
+			largest = MAX(largest, ABS(g));
+		}
+		this->rows[size_t(r)] = largest;
+	});
+
+	// every slice (2D) or the volume normalized to [-1, 1]
+	const SPLint64 rows = SPLint64(l.size.y) * l.size.z / slices;
+	std::vector<SPLieee32> scale((size_t(slices)));
+	for (SPLsizei k = 0; k < slices; k++)
+	{
+		SPLieee64 largest = 0.0;
+		for (SPLint64 r = k * rows; r < (k + 1) * rows; r++)
+		{
+			largest = MAX(largest, this->rows[size_t(r)]);
+		}
+		scale[size_t(k)] = (largest > 0.0) ? SPLieee32(1.0 / largest) : 0.0f;
+	}
+	this->forRows(l, pool, [&](const SPLint64 r, const SPLindex, const SPLindex z)
+	{
+		const SPLieee32 s = scale[size_t((slices > 1) ? z : 0)];
+		for (SPLint64 i = r * l.size.x; i < (r + 1) * l.size.x; i++)
+		{
+			this->g[size_t(i)] *= s;
+		}
+	});
+}
+
+inline SPLint64 SPLFilterVariationalSR::segment(SPLThreadPool &pool) throw()
+{
+	const Level &l = this->hierarchy[0];
+	this->forRows(l, pool, [&](const SPLint64 r, const SPLindex, const SPLindex)
+	{
+		SPLint64 changed = 0;
+		for (SPLint64 i = r * l.size.x; i < (r + 1) * l.size.x; i++)
+		{
+			const SPLuint8 m = (l.w[size_t(i)] > 0.0f) ? 1 : 0;
+			changed += (m != this->mask[size_t(i)]) ? 1 : 0;
+			this->mask[size_t(i)] = m;
+		}
+		this->rows[size_t(r)] = SPLieee64(changed);
+	});
+
+	const SPLint64 rows = SPLint64(l.size.y) * l.size.z;
+	SPLint64 changed = 0;
+	for (SPLint64 r = 0; r < rows; r++)
+	{
+		changed += SPLint64(this->rows[size_t(r)]);
+	}
+	return changed;
+}
+
+#endif /* _spl_filtervariationalsr_hh_ */
@@ -0,0 +1,415 @@
+#ifndef _spl_gradient_hh_
+#define _spl_gradient_hh_
+
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#include <spl/typesbase.hh>
+#include <spl/mathbase.hh>
+#include <spl/threadpool.hh>
+#include <spl/simd.hh>
+#include <spl/vector3.hh>
+#include <spl/grid.hh>
+
+/*! \file gradient.hh
+ * */
+
+/*! \class SPLGradientVolume
+ * \brief The gradients of a volume for shading.
+ *
+ * The gradient of the voxel \f$ (x, y, z) \f$ is the central difference
+ * \f$ \frac{1}{2} (v_{x+1} - v_{x-1}, v_{y+1} - v_{y-1}, v_{z+1} - v_{z-1}) \f$,
+ * where the neighbors outside the volume are clamped to the border, and
+ * the gradient between voxels is the trilinear interpolation of the
+ * gradients of the 8 surrounding voxels. Three modes trade memory for
+ * speed:
+ *
+ * - \ref SPL_GRADIENT_ONTHEFLY: no memory, every gradient reads the
+ *   neighbors of the voxels in the volume (32 reads between voxels).
+ * - \ref SPL_GRADIENT_FLOAT: 12 bytes per voxel, exact.
+ * - \ref SPL_GRADIENT_QUANTIZED: 4 bytes per voxel, the unit normal in
+ *   octahedral encoding with 12 bits per coordinate (an angular error
+ *   below \f$ 0.1^\circ \f$) and the magnitude with 8 bits relative to
+ *   the maximum magnitude of the volume. The magnitude is the sum of the
+ *   absolute components, which decodes without a square root.
+ *
+ * The precomputed gradients have the memory layout of the volume and
+ * are computed brick by brick (block by block, see
+ * \ref SPLGrid::getBlockCount) on the threads of a \ref SPLThreadPool
+ * with the batch kernels of \ref simd.hh along the rows of a brick.
+ *
+ * Example
+ * \code
+ * SPLGradientVolume<SPLuint16> g;
+ * g.build(volume, SPL_GRADIENT_QUANTIZED);
+ *
+ * SPLRayCaster<SPLuint16> r;
+ * r.setGradients(&g);
+ * \endcode
+ *
+ * \sa SPLGrid SPLRayCaster
+ */
+template <class T>
+class SPLGradientVolume
+{
+public:
+	/*! \brief Constructor!
+	 *
+	 * Initializes an empty gradient volume.
+	 */
+	SPLGradientVolume(void) throw() : volume(NULL), mode(SPL_GRADIENT_ONTHEFLY), scale(0.0f) {}
+
+	/*! \brief Computes the gradients of a volume!
+	 *
+	 * The volume must stay valid as long as the gradients of the mode
+	 * \ref SPL_GRADIENT_ONTHEFLY are used.
+	 *
+	 * \param volume The volume.
+	 * \param mode A \c SPL_GRADIENT_* identification number.
+	 * \param pool The threads.
+	 *
+	 * \return \c true on success and \c false otherwise.
+	 */
+	bool build(const SPLGrid<T> &volume, const SPLenum mode = SPL_GRADIENT_QUANTIZED,
+			   SPLThreadPool &pool = SPLThreadPool::getGlobal()) throw();
+
+	/*! \brief Returns the mode!
+	 *
+	 * \return A \c SPL_GRADIENT_* identification number.
+	 */
+	SPLenum getMode(void) const throw() { return this->mode; }
+
+	/*! \brief Returns the size of the volume!
+	 *
+	 * \return Number of voxels along x, y and z.
+	 */
+	const SPLVector3i& getSize(void) const throw() { return this->size; }
+
+	/*! \brief Returns the memory of the precomputed gradients!
+	 *
+	 * \return Number of bytes.
+	 */
+	SPLint64 getMemorySize(void) const throw();
+
+	/*! \brief Returns the maximum magnitude!
+	 *
+	 * \return The maximum sum of the absolute components of the quantized gradients, otherwise \f$ 0 \f$.
+	 */
+	SPLieee32 getMaxMagnitude(void) const throw() { return this->scale * 255.0f; }
+
+	/*! \brief Returns the gradient of a voxel!
+	 *
+	 * \param x Coordinate in \f$ [0, n_x) \f$.
+	 * \param y Coordinate in \f$ [0, n_y) \f$.
+	 * \param z Coordinate in \f$ [0, n_z) \f$.
+	 *
+	 * \return The gradient.
+	 */
+	SPLVector3f getGradient(const SPLindex x, const SPLindex y, const SPLindex z) const throw();
+
+	/*! \brief Returns the interpolated gradient at a point!
+	 *
+	 * \param p A point in \f$ [0, n_x - 1] \times [0, n_y - 1] \times [0, n_z - 1] \f$.
+	 *
+	 * \return The trilinear interpolation of the gradients of the surrounding voxels.
+	 */
+	SPLVector3f getGradient(const SPLVector3f &p) const throw();
+
+	/*! \brief Encodes a gradient!
+	 *
+	 * \param g The gradient.
+	 * \param scale The sum of the absolute components of one step of the 8 bit magnitude.
+	 *
+	 * \return Bits 0-11 and 12-23 are the octahedral coordinates of the
+	 * normal and bits 24-31 the magnitude.
+	 */
+	static SPLuint32 encode(const SPLVector3f &g, const SPLieee32 scale) throw();
+
+	/*! \brief Decodes a gradient!
+	 *
+	 * \param q A gradient of \ref encode.
+	 * \param scale The sum of the absolute components of one step of the 8 bit magnitude.
+	 *
+	 * \return The gradient.
+	 */
+	static SPLVector3f decode(const SPLuint32 q, const SPLieee32 scale) throw();
+
+private:
+	/*! \brief Computes the gradients of the rows of all blocks!
+	 *
+	 * Calls \c f(offset, n, gx, gy, gz) for every row of a block, where
+	 * \c offset is the position of every voxel of the row in memory.
+	 */
+	template <class F>
+	static void forEachRow(const SPLGrid<T> &volume, SPLThreadPool &pool, const F &f) throw();
+
+	/*! \brief Returns the central difference of a voxel in the volume!
+	 */
+	SPLVector3f getDifference(const SPLint64 *ox, const SPLint64 *oy, const SPLint64 *oz, const SPLindex x, const SPLindex y,
+							  const SPLindex z) const throw();
+
+	const SPLGrid<T> *volume;		//!< The volume.
+	SPLenum mode;					//!< A SPL_GRADIENT_* identification number.
+	SPLVector3i size;				//!< Size of the volume.
+	SPLGrid<SPLVector3f> exact;		//!< Float gradients.
+	SPLGrid<SPLuint32> quantized;	//!< Quantized gradients.
+	SPLieee32 scale;				//!< Magnitude of one step of the quantized magnitude.
+};
+
+/************************************************************************************************
+ ** SPLGradientVolume class implementation
+ ************************************************************************************************/
+template <class T>
+bool SPLGradientVolume<T>::build(const SPLGrid<T> &volume, const SPLenum mode, SPLThreadPool &pool) throw()
+{
+	assert(mode > SPL_GRADIENT_MIN && mode < SPL_GRADIENT_MAX);
+	const SPLVector3i &n = volume.getSize();
+	if (n.x <= 0 || n.y <= 0 || n.z <= 0)
+	{
+		return false;
+	}
+	this->volume = &volume;
+	this->size = n;
+	this->mode = mode;
+	this->scale = 0.0f;
+	this->exact = SPLGrid<SPLVector3f>();
+	this->quantized = SPLGrid<SPLuint32>();
+
+	if (mode == SPL_GRADIENT_FLOAT)
+	{
+		if (!this->exact.resize(n, volume.getLayout(), MAX(volume.getBrickSize(), 2)))
+		{
+			return false;
+		}
+		SPLVector3f *data = this->exact.getData();
+		forEachRow(volume, pool, [&](const SPLint64 *offset, const SPLindex count, const SPLieee32 *gx, const SPLieee32 *gy,
+									 const SPLieee32 *gz)
+		{
+			for (SPLindex i = 0; i < count; i++)
+			{
+				data[offset[i]] = SPLVector3f(gx[i], gy[i], gz[i]);
+			}
+		});
+	}
+	else if (mode == SPL_GRADIENT_QUANTIZED)
+	{
+		if (!this->quantized.resize(n, volume.getLayout(), MAX(volume.getBrickSize(), 2)))
+		{
+			return false;
+		}
+		// the maximum magnitude is the scale of the magnitudes
+		std::atomic<SPLuint32> maximum(0);
+		forEachRow(volume, pool, [&](const SPLint64 *, const SPLindex count, const SPLieee32 *gx, const SPLieee32 *gy,
+									 const SPLieee32 *gz)
+		{
+			SPLieee32 r = 0.0f;
+			for (SPLindex i = 0; i < count; i++)
+			{
+				r = MAX(r, std::fabs(gx[i]) + std::fabs(gy[i]) + std::fabs(gz[i]));
+			}
+			// the bits of non-negative floats are ordered like the floats
+			SPLuint32 bits, old = maximum;
+			memcpy(&bits, &r, sizeof(bits));
+			while (bits > old && !maximum.compare_exchange_weak(old, bits))
+			{
+			}
+		});
+		const SPLuint32 bits = maximum;
+		SPLieee32 max;
+		memcpy(&max, &bits, sizeof(max));
+		this->scale = max / 255.0f;
+
+		SPLuint32 *data = this->quantized.getData();
+		const SPLieee32 scale = this->scale;
+		forEachRow(volume, pool, [&](const SPLint64 *offset, const SPLindex count, const SPLieee32 *gx, const SPLieee32 *gy,
+									 const SPLieee32 *gz)
+		{
+			for (SPLindex i = 0; i < count; i++)
+			{
+				data[offset[i]] = encode(SPLVector3f(gx[i], gy[i], gz[i]), scale);
+			}
+		});
+	}
+	return true;
+}
+
+template <class T>
+SPLint64 SPLGradientVolume<T>::getMemorySize(void) const throw()
+{
+	if (this->mode == SPL_GRADIENT_FLOAT)
+	{
+		return this->exact.getStorageSize() * SPLint64(sizeof(SPLVector3f));
+	}
+	if (this->mode == SPL_GRADIENT_QUANTIZED)
+	{
+		return this->quantized.getStorageSize() * SPLint64(sizeof(SPLuint32));
+	}
+	return 0;
+}
+
+template <class T>
+SPLVector3f SPLGradientVolume<T>::getGradient(const SPLindex x, const SPLindex y, const SPLindex z) const throw()
+{
+	assert(this->volume);
+	if (this->mode == SPL_GRADIENT_FLOAT)
+	{
+		return this->exact(x, y, z);
+	}
+	if (this->mode == SPL_GRADIENT_QUANTIZED)
+	{
+		return decode(this->quantized(x, y, z), this->scale);
+	}
+	return this->getDifference(this->volume->getOffsets(0), this->volume->getOffsets(1), this->volume->getOffsets(2), x, y, z);
+}
+
+template <class T>
+SPLVector3f SPLGradientVolume<T>::getGradient(const SPLVector3f &p) const throw()
+{
+	assert(this->volume);
+	assert(p.x >= 0.0f && p.y >= 0.0f && p.z >= 0.0f);
+	const SPLVector3i &n = this->size;
+	const SPLindex x0 = MIN(SPLindex(p.x), n.x - 1), y0 = MIN(SPLindex(p.y), n.y - 1), z0 = MIN(SPLindex(p.z), n.z - 1);
+	const SPLindex x1 = MIN(x0 + 1, n.x - 1), y1 = MIN(y0 + 1, n.y - 1), z1 = MIN(z0 + 1, n.z - 1);
+	const SPLieee32 fx = p.x - SPLieee32(x0), fy = p.y - SPLieee32(y0), fz = p.z - SPLieee32(z0);
+
+	SPLVector3f g[8];
+	if (this->mode == SPL_GRADIENT_ONTHEFLY)
+	{
+		const SPLint64 *ox = this->volume->getOffsets(0), *oy = this->volume->getOffsets(1), *oz = this->volume->getOffsets(2);
+		for (SPLindex i = 0; i < 8; i++)
+		{
+			g[i] = this->getDifference(ox, oy, oz, (i & 1) ? x1 : x0, (i & 2) ? y1 : y0, (i & 4) ? z1 : z0);
+		}
+	}
+	else
+	{
+		const bool exact = (this->mode == SPL_GRADIENT_FLOAT);
+		const SPLint64 *ox = exact ? this->exact.getOffsets(0) : this->quantized.getOffsets(0);
+		const SPLint64 *oy = exact ? this->exact.getOffsets(1) : this->quantized.getOffsets(1);
+		const SPLint64 *oz = exact ? this->exact.getOffsets(2) : this->quantized.getOffsets(2);
+		for (SPLindex i = 0; i < 8; i++)
+		{
+			const SPLint64 o = ox[(i & 1) ? x1 : x0] + oy[(i & 2) ? y1 : y0] + oz[(i & 4) ? z1 : z0];
+			g[i] = exact ? this->exact.getData()[o] : decode(this->quantized.getData()[o], this->scale);
+		}
+	}
+	const SPLVector3f a = g[0] + (g[1] - g[0]) * fx, b = g[2] + (g[3] - g[2]) * fx;
+	const SPLVector3f c = g[4] + (g[5] - g[4]) * fx, d = g[6] + (g[7] - g[6]) * fx;
+	const SPLVector3f e = a + (b - a) * fy, f = c + (d - c) * fy;
+	return e + (f - e) * fz;
+}
+
+template <class T>
+SPLuint32 SPLGradientVolume<T>::encode(const SPLVector3f &g, const SPLieee32 scale) throw()
+{
+	const SPLieee32 l1 = std::fabs(g.x) + std::fabs(g.y) + std::fabs(g.z);
+	if (!(l1 > 0.0f))
+	{
+		return SPLuint32(2047) | (SPLuint32(2047) << 12);
+	}
+	SPLieee32 u = g.x / l1, v = g.y / l1;
+	if (g.z < 0.0f)
+	{
+		// fold the lower hemisphere over the diagonals
+		const SPLieee32 fu = (1.0f - std::fabs(v)) * ((u >= 0.0f) ? 1.0f : -1.0f), fv = (1.0f - std::fabs(u)) * ((v >= 0.0f) ? 1.0f : -1.0f);
+		u = fu;
+		v = fv;
+	}
+	const SPLuint32 qu = SPLuint32(CLAMP(u * 0.5f + 0.5f, 0.0f, 1.0f) * 4094.0f + 0.5f);
+	const SPLuint32 qv = SPLuint32(CLAMP(v * 0.5f + 0.5f, 0.0f, 1.0f) * 4094.0f + 0.5f);
+	// a small non-zero gradient keeps its direction
+	const SPLuint32 qm = SPLuint32(CLAMP(l1 / scale + 0.5f, 1.0f, 255.0f));
+	return qu | (qv << 12) | (qm << 24);
+}
+
+template <class T>
+SPLVector3f SPLGradientVolume<T>::decode(const SPLuint32 q, const SPLieee32 scale) throw()
+{
+	const SPLuint32 qm = q >> 24;
+	if (qm == 0)
+	{
+		return SPLVector3f(0.0f, 0.0f, 0.0f);
+	}
+	SPLieee32 u = SPLieee32(q & 4095) * (2.0f / 4094.0f) - 1.0f, v = SPLieee32((q >> 12) & 4095) * (2.0f / 4094.0f) - 1.0f;
+	const SPLieee32 w = 1.0f - std::fabs(u) - std::fabs(v);
+	if (w < 0.0f)
+	{
+		const SPLieee32 fu = (1.0f - std::fabs(v)) * ((u >= 0.0f) ? 1.0f : -1.0f), fv = (1.0f - std::fabs(u)) * ((v >= 0.0f) ? 1.0f : -1.0f);
+		u = fu;
+		v = fv;
+	}
+	// the octahedral coordinates have a sum of absolute values of 1
+	const SPLieee32 m = SPLieee32(qm) * scale;
+	return SPLVector3f(u * m, v * m, w * m);
+}
+
+template <class T>
+template <class F>
+void SPLGradientVolume<T>::forEachRow(const SPLGrid<T> &volume, SPLThreadPool &pool, const F &f) throw()
+{
+	const SPLint64 *ox = volume.getOffsets(0), *oy = volume.getOffsets(1), *oz = volume.getOffsets(2);
+	const T *data = volume.getData();
+	const SPLindex width = (volume.getLayout() == SPL_GRID_LINEAR) ? volume.getSize().x : volume.getBrickSize();
+	pool.parallelFor(0, volume.getBlockCount(), 1, [&](const SPLint64 first, const SPLint64 last)
+	{
+		// the row with its two neighbors along x, the 4 neighboring rows and the gradients
+		std::vector<SPLieee32> buffer(size_t(width) * 8 + 2, 0.0f);
+		std::vector<SPLint64> offset(size_t(width), 0);
+		SPLieee32 *c = &buffer[0], *ym = c + width + 2, *yp = ym + width, *zm = yp + width, *zp = zm + width;
+		SPLieee32 *gx = zp + width, *gy = gx + width, *gz = gy + width;
+		SPLVector3i lo, hi;
+		for (SPLindex b = SPLindex(first); b < SPLindex(last); b++)
+		{
+			volume.getBlock(b, lo, hi);
+			const SPLindex count = hi.x - lo.x;
+			for (SPLindex z = lo.z; z < hi.z; z++)
+			{
+				for (SPLindex y = lo.y; y < hi.y; y++)
+				{
+					// gather the rows (the offsets of -1 and n are clamped to the border)
+					const SPLint64 r = oy[y] + oz[z], rym = oy[y - 1] + oz[z], ryp = oy[y + 1] + oz[z];
+					const SPLint64 rzm = oy[y] + oz[z - 1], rzp = oy[y] + oz[z + 1];
+					c[0] = SPLieee32(data[r + ox[lo.x - 1]]);
+					for (SPLindex i = 0; i <= count; i++)
+					{
+						c[i + 1] = SPLieee32(data[r + ox[lo.x + i]]);
+					}
+					for (SPLindex i = 0; i < count; i++)
+					{
+						const SPLint64 o = ox[lo.x + i];
+						offset[size_t(i)] = r + o;
+						ym[i] = SPLieee32(data[rym + o]);
+						yp[i] = SPLieee32(data[ryp + o]);
+						zm[i] = SPLieee32(data[rzm + o]);
+						zp[i] = SPLieee32(data[rzp + o]);
+					}
+
+					splSimdForEach<SPLieee32>(count, [&](auto simd, const SPLindex i)
+					{
+						typedef decltype(simd) S;
+						const typename S::Type h = S::set(0.5f);
+						S::store(gx + i, S::mul(h, S::sub(S::load(c + i + 2), S::load(c + i))));
+						S::store(gy + i, S::mul(h, S::sub(S::load(yp + i), S::load(ym + i))));
+						S::store(gz + i, S::mul(h, S::sub(S::load(zp + i), S::load(zm + i))));
+					});
+					f(&offset[0], count, gx, gy, gz);
+				}
+			}
+		}
+	});
+}
+
+template <class T>
+SPLVector3f SPLGradientVolume<T>::getDifference(const SPLint64 *ox, const SPLint64 *oy, const SPLint64 *oz, const SPLindex x,
+												const SPLindex y, const SPLindex z) const throw()
+{
+	const T *data = this->volume->getData();
+	const SPLint64 r = oy[y] + oz[z], o = ox[x];
+	return SPLVector3f(0.5f * (SPLieee32(data[r + ox[x + 1]]) - SPLieee32(data[r + ox[x - 1]])),
+					   0.5f * (SPLieee32(data[o + oy[y + 1] + oz[z]]) - SPLieee32(data[o + oy[y - 1] + oz[z]])),
+					   0.5f * (SPLieee32(data[o + oy[y] + oz[z + 1]]) - SPLieee32(data[o + oy[y] + oz[z - 1]])));
+}
+
+#endif /* _spl_gradient_hh_ */
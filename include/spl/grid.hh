@@ -0,0 +1,999 @@
+#ifndef _spl_grid_hh_
+#define _spl_grid_hh_
+
+#include <algorithm> // for std::fill(), std::swap()
+#include <cstring>   // for memcpy(), memset()
+#include <vector>
+
+#include <spl/typesbase.hh>
+#include <spl/mathbase.hh>
+#include <spl/simd.hh>
+#include <spl/threadpool.hh>
+#include <spl/allocator.hh>
+#include <spl/vector3.hh>
+
+template <class T> class SPLGrid;
+template <class T, class V> class SPLGridIterator;
+
+typedef SPLGrid<SPLuint8> SPLGridub;	//!< Grid with SPLuint8 (8bit) voxels!
+typedef SPLGrid<SPLuint16> SPLGridus;	//!< Grid with SPLuint16 (16bit) voxels!
+typedef SPLGrid<SPLint32> SPLGridi;		//!< Grid with SPLint32 (32bit) voxels!
+typedef SPLGrid<SPLieee32> SPLGridf;	//!< Grid with SPLieee32 (32bit) voxels!
+typedef SPLGrid<SPLieee64> SPLGridd;	//!< Grid with SPLieee64 (64bit) voxels!
+
+/*! \file grid.hh
+ * */
+
+/*! \class SPLGrid
+ * \brief A regular 3 dimensional grid of voxels (a volume).
+ *
+ * The grid stores \f$ n_x \times n_y \times n_z \f$ voxels of the storage
+ * type \c T, see \ref getType, in one of two memory layouts:
+ *
+ * - \ref SPL_GRID_LINEAR: the voxel \f$ (x, y, z) \f$ is stored at
+ *   \f$ x + n_x (y + n_y z) \f$, i.e. x fastest as in the files.
+ * - \ref SPL_GRID_BRICKED: the grid is split into cubic bricks with an
+ *   edge length \f$ B \f$ (a power of 2, e.g. 8 or 16). The voxels of a
+ *   brick are contiguous and Morton (Z-order) ordered, and the bricks
+ *   are stored x fastest. The grid is padded to whole bricks.
+ *
+ * In the linear layout a step along z skips \f$ n_x n_y \f$ voxels, such
+ * that a ray or a neighborhood which is not aligned to x touches a new
+ * cache line (and page) for almost every voxel. In the bricked layout the
+ * \f$ 2^3 \f$, \f$ 4^3 \f$, ... neighbors around a voxel share a few cache
+ * lines in every direction, e.g. an \f$ 8^3 \f$ brick of \ref SPLieee32
+ * is 2 kB, such that sampling costs about the same for all view directions.
+ *
+ * The address of a voxel is the sum of three per-axis offsets, see
+ * \ref getOffsets, which are tabulated for the coordinates \f$ -1 \f$ to
+ * \f$ n \f$ (clamped to the border). This makes the access in both
+ * layouts three table lookups and two additions, and the 26 neighbors
+ * of every voxel addressable without a branch, see \ref SPLGridIterator.
+ *
+ * Example
+ * \code
+ * SPLGridf g(SPLVector3i(512, 512, 512), SPL_GRID_BRICKED, 8);
+ * g.fromLinear(raw);
+ *
+ * // 6-neighbor Laplacian, one brick per task
+ * SPLThreadPool::getGlobal().parallelFor(0, g.getBlockCount(), 1, [&](const SPLint64 first, const SPLint64 last)
+ * {
+ *     for (SPLGridf::ConstIterator it = g.begin(first, last); it != g.end(first, last); ++it)
+ *     {
+ *         out[it.getPosition()] = it.getNeighbor(-1, 0, 0) + it.getNeighbor(1, 0, 0) + ... - 6.0f * (*it);
+ *     }
+ * });
+ * \endcode
+ *
+ * A grid either owns its memory, allocated with \ref splMemoryAlloc or
+ * recycled by an \ref SPLMemoryPool, or wraps external memory (e.g. a
+ * mapped file or the chunk of an \ref SPLArena), see \ref setExternal.
+ *
+ * \sa SPLGridIterator SPLVector3
+ */
+template <class T>
+class SPLGrid
+{
+public:
+	typedef SPLGridIterator<T, T> Iterator;				//!< Iterator over writable voxels.
+	typedef SPLGridIterator<T, const T> ConstIterator;	//!< Iterator over read-only voxels.
+
+	/*! \brief Constructor!
+	 *
+	 * Initializes an empty grid.
+	 */
+	SPLGrid(void) throw();
+
+	/*! \brief Constructor!
+	 *
+	 * Allocates a grid of zero voxels, see \ref resize.
+	 *
+	 * \param size Number of voxels along x, y and z.
+	 * \param layout \ref SPL_GRID_LINEAR or \ref SPL_GRID_BRICKED.
+	 * \param brick Edge length of the bricks (a power of 2).
+	 */
+	explicit SPLGrid(const SPLVector3i &size, const SPLenum layout = SPL_GRID_LINEAR, const SPLsizei brick = 8) throw();
+
+	/*! \brief Constructor!
+	 *
+	 * Deep copy of another grid with the same layout. The copy of a grid
+	 * with external memory owns its memory.
+	 *
+	 * \param g Another grid.
+	 */
+	SPLGrid(const SPLGrid<T> &g) throw();
+
+	/*! \brief Destructor!
+	 *
+	 * Frees all previously alloced space, but not external memory.
+	 */
+	~SPLGrid(void) throw();
+
+	/*! \brief Assigment operator!
+	 *
+	 * Deep copy of another grid with the same layout.
+	 *
+	 * \param g Another grid.
+	 *
+	 * \return Reference of this grid.
+	 */
+	SPLGrid<T>& operator = (const SPLGrid<T> &g) throw();
+
+	/*! \brief Allocates a new grid!
+	 *
+	 * All voxels (and the padding) are zero. Iterators of this grid
+	 * become invalid.
+	 *
+	 * \param size Number of voxels along x, y and z.
+	 * \param layout \ref SPL_GRID_LINEAR or \ref SPL_GRID_BRICKED.
+	 * \param brick Edge length of the bricks, a power of 2 in \f$ [2, 1024] \f$
+	 * (ignored for the linear layout).
+	 *
+	 * \return \c true on success and \c false otherwise.
+	 */
+	bool resize(const SPLVector3i &size, const SPLenum layout = SPL_GRID_LINEAR, const SPLsizei brick = 8) throw();
+
+	/*! \brief Allocates a new grid from a pool!
+	 *
+	 * Like \ref resize(const SPLVector3i&, const SPLenum, const SPLsizei),
+	 * but the memory is taken from the pool and returned to it when the
+	 * grid is destroyed or resized. The pool must outlive the grid.
+	 *
+	 * \param size Number of voxels along x, y and z.
+	 * \param layout \ref SPL_GRID_LINEAR or \ref SPL_GRID_BRICKED.
+	 * \param brick Edge length of the bricks.
+	 * \param memory The pool.
+	 *
+	 * \return \c true on success and \c false otherwise.
+	 */
+	bool resize(const SPLVector3i &size, const SPLenum layout, const SPLsizei brick, SPLMemoryPool &memory) throw();
+
+	/*! \brief Allocates a new grid from an arena!
+	 *
+	 * Like \ref resize(const SPLVector3i&, const SPLenum, const SPLsizei),
+	 * but the memory is external memory of the arena, which is freed by
+	 * \ref SPLArena::reset.
+	 *
+	 * \param size Number of voxels along x, y and z.
+	 * \param layout \ref SPL_GRID_LINEAR or \ref SPL_GRID_BRICKED.
+	 * \param brick Edge length of the bricks.
+	 * \param arena The arena.
+	 *
+	 * \return \c true on success and \c false otherwise.
+	 */
+	bool resize(const SPLVector3i &size, const SPLenum layout, const SPLsizei brick, SPLArena &arena) throw();
+
+	/*! \brief Wraps external memory!
+	 *
+	 * The memory must hold \ref getStorageSize(const SPLVector3i&, const SPLenum, const SPLsizei)
+	 * voxels in the given layout and must stay valid as long as this grid
+	 * uses it. It is never freed by the grid.
+	 *
+	 * \param data The voxels.
+	 * \param size Number of voxels along x, y and z.
+	 * \param layout \ref SPL_GRID_LINEAR or \ref SPL_GRID_BRICKED.
+	 * \param brick Edge length of the bricks (a power of 2).
+	 *
+	 * \return \c true on success and \c false otherwise.
+	 */
+	bool setExternal(T *data, const SPLVector3i &size, const SPLenum layout = SPL_GRID_LINEAR, const SPLsizei brick = 8) throw();
+
+	/*! \brief Changes the memory layout!
+	 *
+	 * The voxels are reordered into newly allocated memory, i.e. a grid
+	 * with external memory owns its memory afterwards.
+	 *
+	 * \param layout \ref SPL_GRID_LINEAR or \ref SPL_GRID_BRICKED.
+	 * \param brick Edge length of the bricks (a power of 2).
+	 * \param pool The threads.
+	 *
+	 * \return \c true on success and \c false otherwise (the grid is unchanged).
+	 */
+	bool setLayout(const SPLenum layout, const SPLsizei brick = 8, SPLThreadPool &pool = SPLThreadPool::getGlobal()) throw();
+
+	/*! \brief Returns the number of voxels in memory of a grid!
+	 *
+	 * \param size Number of voxels along x, y and z.
+	 * \param layout \ref SPL_GRID_LINEAR or \ref SPL_GRID_BRICKED.
+	 * \param brick Edge length of the bricks (a power of 2).
+	 *
+	 * \return Number of voxels including the padding of the bricks, or
+	 * \f$ -1 \f$ if the parameters are invalid.
+	 */
+	static SPLint64 getStorageSize(const SPLVector3i &size, const SPLenum layout, const SPLsizei brick) throw();
+
+	/*! \brief Returns the number of voxels in memory!
+	 *
+	 * \return Number of voxels including the padding of the bricks.
+	 */
+	SPLint64 getStorageSize(void) const throw() { return this->count; }
+
+	/*! \brief Returns the identification number of the voxel type!
+	 *
+	 * \return The \c SPL_TYPE_* constant of \c T, see \ref SPLTypeId.
+	 */
+	static SPLenum getType(void) throw() { return SPLTypeId<T>::value; }
+
+	/*! \brief Returns the number of voxels along x, y and z!
+	 *
+	 * \return The size.
+	 */
+	const SPLVector3i& getSize(void) const throw() { return this->size; }
+
+	/*! \brief Returns the memory layout!
+	 *
+	 * \return \ref SPL_GRID_LINEAR or \ref SPL_GRID_BRICKED.
+	 */
+	SPLenum getLayout(void) const throw() { return this->layout; }
+
+	/*! \brief Returns the edge length of the bricks!
+	 *
+	 * \return The edge length, or \f$ 0 \f$ for the linear layout.
+	 */
+	SPLsizei getBrickSize(void) const throw() { return this->brick; }
+
+	/*! \brief Returns the memory of the voxels!
+	 *
+	 * \return Pointer to \ref getStorageSize voxels in the layout of the grid.
+	 */
+	T* getData(void) throw() { return this->data; }
+
+	/*! \brief Returns the memory of the voxels!
+	 *
+	 * \return Pointer to \ref getStorageSize voxels in the layout of the grid.
+	 */
+	const T* getData(void) const throw() { return this->data; }
+
+	/*! \brief Returns whether the grid wraps external memory!
+	 *
+	 * \return \c true if the memory has been set with \ref setExternal.
+	 */
+	bool isExternal(void) const throw() { return !this->owner; }
+
+	/*! \brief Returns the per-axis offsets!
+	 *
+	 * The voxel \f$ (x, y, z) \f$ is stored at \f$ o_x[x] + o_y[y] + o_z[z] \f$
+	 * for the coordinates \f$ [-1, n] \f$ of each axis, where \f$ -1 \f$ and
+	 * \f$ n \f$ address the border voxels \f$ 0 \f$ and \f$ n - 1 \f$.
+	 *
+	 * \param axis \f$ 0 \f$ (x), \f$ 1 \f$ (y) or \f$ 2 \f$ (z).
+	 *
+	 * \return Pointer to the offset of the coordinate \f$ 0 \f$.
+	 */
+	const SPLint64* getOffsets(const SPLindex axis) const throw();
+
+	/*! \brief Returns the position of a voxel in memory!
+	 *
+	 * \param x Coordinate in \f$ [-1, n_x] \f$.
+	 * \param y Coordinate in \f$ [-1, n_y] \f$.
+	 * \param z Coordinate in \f$ [-1, n_z] \f$.
+	 *
+	 * \return Index into \ref getData.
+	 */
+	SPLint64 getOffset(const SPLindex x, const SPLindex y, const SPLindex z) const throw();
+
+	/*! \brief Access operator!
+	 *
+	 * \param x Coordinate in \f$ [0, n_x) \f$.
+	 * \param y Coordinate in \f$ [0, n_y) \f$.
+	 * \param z Coordinate in \f$ [0, n_z) \f$.
+	 *
+	 * \return Reference of a voxel.
+	 */
+	T& operator () (const SPLindex x, const SPLindex y, const SPLindex z) throw();
+
+	/*! \brief Access operator!
+	 *
+	 * \param x Coordinate in \f$ [0, n_x) \f$.
+	 * \param y Coordinate in \f$ [0, n_y) \f$.
+	 * \param z Coordinate in \f$ [0, n_z) \f$.
+	 *
+	 * \return Reference of a voxel.
+	 */
+	const T& operator () (const SPLindex x, const SPLindex y, const SPLindex z) const throw();
+
+	/*! \brief Access operator!
+	 *
+	 * \param p Coordinates of a voxel.
+	 *
+	 * \return Reference of a voxel.
+	 */
+	T& operator [] (const SPLVector3i &p) throw();
+
+	/*! \brief Access operator!
+	 *
+	 * \param p Coordinates of a voxel.
+	 *
+	 * \return Reference of a voxel.
+	 */
+	const T& operator [] (const SPLVector3i &p) const throw();
+
+	/*! \brief Returns a voxel, clamped to the border!
+	 *
+	 * \param x Any coordinate.
+	 * \param y Any coordinate.
+	 * \param z Any coordinate.
+	 *
+	 * \return The value of the nearest voxel inside the grid.
+	 */
+	T getClamped(const SPLindex x, const SPLindex y, const SPLindex z) const throw();
+
+	/*! \brief Sets all voxels to the same value!
+	 *
+	 * \param v The value.
+	 */
+	void fill(const T &v) throw();
+
+	/*! \brief Copies voxels in linear order into the grid!
+	 *
+	 * \param v Array of \f$ n_x n_y n_z \f$ voxels, x fastest.
+	 * \param pool The threads.
+	 */
+	void fromLinear(const T *v, SPLThreadPool &pool = SPLThreadPool::getGlobal()) throw();
+
+	/*! \brief Copies the voxels of the grid in linear order!
+	 *
+	 * \param v Array of \f$ n_x n_y n_z \f$ voxels, x fastest.
+	 * \param pool The threads.
+	 */
+	void toLinear(T *v, SPLThreadPool &pool = SPLThreadPool::getGlobal()) const throw();
+
+	/*! \brief Returns the number of blocks!
+	 *
+	 * A block is a box of voxels which is contiguous in memory, i.e. a
+	 * brick in the bricked layout and a z slice in the linear layout.
+	 * The blocks are the units of parallel work.
+	 *
+	 * \return Number of blocks.
+	 */
+	SPLsizei getBlockCount(void) const throw() { return this->blocks; }
+
+	/*! \brief Returns the voxels of a block!
+	 *
+	 * \param b Index of the block in \f$ [0, \f$ \ref getBlockCount \f$ ) \f$.
+	 * \param lo First voxel of the block.
+	 * \param hi Last voxel of the block plus one.
+	 */
+	void getBlock(const SPLindex b, SPLVector3i &lo, SPLVector3i &hi) const throw();
+
+	/*! \brief Returns an iterator to the first voxel!
+	 *
+	 * \return Iterator over all voxels, block by block.
+	 */
+	Iterator begin(void) throw() { return Iterator(this, this->data, 0, this->blocks); }
+
+	/*! \brief Returns an iterator past the last voxel!
+	 *
+	 * \return End iterator of \ref begin(void).
+	 */
+	Iterator end(void) throw() { return Iterator(this, this->data, this->blocks, this->blocks); }
+
+	/*! \brief Returns an iterator to the first voxel!
+	 *
+	 * \return Iterator over all voxels, block by block.
+	 */
+	ConstIterator begin(void) const throw() { return ConstIterator(this, this->data, 0, this->blocks); }
+
+	/*! \brief Returns an iterator past the last voxel!
+	 *
+	 * \return End iterator of \ref begin(void) const.
+	 */
+	ConstIterator end(void) const throw() { return ConstIterator(this, this->data, this->blocks, this->blocks); }
+
+	/*! \brief Returns an iterator to the first voxel of a range of blocks!
+	 *
+	 * \param first Index of the first block.
+	 * \param last Index of the last block plus one.
+	 *
+	 * \return Iterator over the voxels of the blocks \f$ [first, last) \f$.
+	 */
+	Iterator begin(const SPLint64 first, const SPLint64 last) throw() { return Iterator(this, this->data, SPLindex(first), SPLindex(last)); }
+
+	/*! \brief Returns an iterator past the last voxel of a range of blocks!
+	 *
+	 * \param first Index of the first block.
+	 * \param last Index of the last block plus one.
+	 *
+	 * \return End iterator of \ref begin(const SPLint64, const SPLint64).
+	 */
+	Iterator end(const SPLint64 first, const SPLint64 last) throw() { (void)first; return Iterator(this, this->data, SPLindex(last), SPLindex(last)); }
+
+	/*! \brief Returns an iterator to the first voxel of a range of blocks!
+	 *
+	 * \param first Index of the first block.
+	 * \param last Index of the last block plus one.
+	 *
+	 * \return Iterator over the voxels of the blocks \f$ [first, last) \f$.
+	 */
+	ConstIterator begin(const SPLint64 first, const SPLint64 last) const throw() { return ConstIterator(this, this->data, SPLindex(first), SPLindex(last)); }
+
+	/*! \brief Returns an iterator past the last voxel of a range of blocks!
+	 *
+	 * \param first Index of the first block.
+	 * \param last Index of the last block plus one.
+	 *
+	 * \return End iterator of \ref begin(const SPLint64, const SPLint64) const.
+	 */
+	ConstIterator end(const SPLint64 first, const SPLint64 last) const throw() { (void)first; return ConstIterator(this, this->data, SPLindex(last), SPLindex(last)); }
+
+private:
+	bool setup(const SPLVector3i &size, const SPLenum layout, const SPLsizei brick) throw();
+	bool adopt(T *data, const SPLint64 count, const bool owner, SPLMemoryPool *memory,
+			   const SPLVector3i &size, const SPLenum layout, const SPLsizei brick) throw();
+	void release(void) throw();
+	void swap(SPLGrid<T> &g) throw();
+
+	SPLVector3i size;		//!< Number of voxels along x, y and z.
+	SPLenum layout;			//!< Memory layout.
+	SPLsizei brick;			//!< Edge length of the bricks (0 for the linear layout).
+	SPLVector3i bricks;		//!< Number of blocks along x, y and z.
+	SPLsizei blocks;		//!< Number of blocks.
+	SPLint64 count;			//!< Number of voxels in memory.
+	T *data;				//!< The voxels.
+	bool owner;				//!< Set if the memory is freed by this grid.
+	SPLMemoryPool *memory;	//!< The pool of the memory, or 0 for \ref splMemoryAlloc.
+	std::vector<SPLint64> offsets[3];	//!< Per-axis offsets of the coordinates -1 to n.
+};
+
+/*! \class SPLGridIterator
+ * \brief Iterator over the voxels of a \ref SPLGrid.
+ *
+ * The voxels are visited in memory order, i.e. block by block and x
+ * fastest within a block (see \ref SPLGrid::getBlockCount). Besides the
+ * current voxel the iterator provides its coordinates and its 26
+ * neighbors, which are clamped to the border of the grid.
+ *
+ * \sa SPLGrid
+ */
+template <class T, class V>
+class SPLGridIterator
+{
+public:
+	/*! \brief Constructor!
+	 *
+	 * \param grid The grid.
+	 * \param data The voxels of the grid.
+	 * \param block Index of the first block.
+	 * \param last Index of the last block plus one.
+	 */
+	SPLGridIterator(const SPLGrid<T> *grid, V *data, const SPLindex block, const SPLindex last) throw();
+
+	/*! \brief Access operator!
+	 *
+	 * \return Reference of the current voxel.
+	 */
+	V& operator * (void) const throw() { return this->data[this->row + this->ox[this->pos.x]]; }
+
+	/*! \brief Returns a neighbor of the current voxel!
+	 *
+	 * \param dx Offset along x in \f$ [-1, 1] \f$.
+	 * \param dy Offset along y in \f$ [-1, 1] \f$.
+	 * \param dz Offset along z in \f$ [-1, 1] \f$.
+	 *
+	 * \return Reference of the voxel at \f$ (x + dx, y + dy, z + dz) \f$,
+	 * clamped to the border.
+	 */
+	V& getNeighbor(const SPLindex dx, const SPLindex dy, const SPLindex dz) const throw();
+
+	/*! \brief Returns the coordinates of the current voxel!
+	 *
+	 * \return The coordinates.
+	 */
+	const SPLVector3i& getPosition(void) const throw() { return this->pos; }
+
+	/*! \brief Returns the position of the current voxel in memory!
+	 *
+	 * \return Index into \ref SPLGrid::getData.
+	 */
+	SPLint64 getOffset(void) const throw() { return this->row + this->ox[this->pos.x]; }
+
+	/*! \brief Moves to the next voxel!
+	 *
+	 * \return Reference of this iterator.
+	 */
+	SPLGridIterator<T, V>& operator ++ (void) throw();
+
+	/*! \brief Comparison operator!
+	 *
+	 * \param it Another iterator of the same grid.
+	 *
+	 * \return \c true if both iterators point to the same voxel.
+	 */
+	bool operator == (const SPLGridIterator<T, V> &it) const throw() { return this->block == it.block && this->pos == it.pos; }
+
+	/*! \brief Comparison operator!
+	 *
+	 * \param it Another iterator of the same grid.
+	 *
+	 * \return \c true if the iterators point to different voxels.
+	 */
+	bool operator != (const SPLGridIterator<T, V> &it) const throw() { return !(this->operator == (it)); }
+
+private:
+	void setBlock(void) throw();
+
+	const SPLGrid<T> *grid;	//!< The grid.
+	V *data;				//!< The voxels.
+	const SPLint64 *ox;		//!< Offsets along x.
+	const SPLint64 *oy;		//!< Offsets along y.
+	const SPLint64 *oz;		//!< Offsets along z.
+	SPLindex block;			//!< Current block.
+	SPLindex last;			//!< Last block plus one.
+	SPLVector3i lo;			//!< First voxel of the current block.
+	SPLVector3i hi;			//!< Last voxel of the current block plus one.
+	SPLVector3i pos;		//!< Current voxel.
+	SPLint64 row;			//!< Offset of the current row, i.e. oy[y] + oz[z].
+};
+
+namespace SPLGridDetail
+{
+	//! Spreads the bits of \c v to every 3rd bit, i.e. the Morton code of \f$ (v, 0, 0) \f$.
+	inline SPLint64 spread(const SPLint64 v) throw()
+	{
+		SPLint64 r = 0;
+		for (SPLindex b = 0; (v >> b) != 0; b++)
+		{
+			r |= ((v >> b) & 1) << (3 * b);
+		}
+		return r;
+	}
+
+	//! Returns \f$ \log_2 \f$ of a power of 2, or \f$ -1 \f$ otherwise.
+	inline SPLindex log2(const SPLsizei v) throw()
+	{
+		for (SPLindex s = 0; s < 31; s++)
+		{
+			if (v == (SPLsizei(1) << s))
+			{
+				return s;
+			}
+		}
+		return -1;
+	}
+}
+
+/************************************************************************************************
+ ** SPLGrid class implementation
+ ************************************************************************************************/
+template <class T>
+SPLGrid<T>::SPLGrid(void) throw()
+{
+	this->data = 0;
+	this->owner = true;
+	this->memory = 0;
+	this->setup(SPLVector3i(0, 0, 0), SPL_GRID_LINEAR, 0);
+}
+
+template <class T>
+SPLGrid<T>::SPLGrid(const SPLVector3i &size, const SPLenum layout, const SPLsizei brick) throw()
+{
+	this->data = 0;
+	this->owner = true;
+	this->memory = 0;
+	this->setup(SPLVector3i(0, 0, 0), SPL_GRID_LINEAR, 0);
+	this->resize(size, layout, brick);
+}
+
+template <class T>
+SPLGrid<T>::SPLGrid(const SPLGrid<T> &g) throw()
+{
+	this->data = 0;
+	this->owner = true;
+	this->memory = 0;
+	this->setup(SPLVector3i(0, 0, 0), SPL_GRID_LINEAR, 0);
+	this->operator = (g);
+}
+
+template <class T>
+SPLGrid<T>::~SPLGrid(void) throw()
+{
+	this->release();
+}
+
+template <class T>
+SPLGrid<T>& SPLGrid<T>::operator = (const SPLGrid<T> &g) throw()
+{
+	if (this != &g && this->resize(g.size, g.layout, g.brick) && this->count > 0)
+	{
+		memcpy((void *)this->data, (const void *)g.data, size_t(this->count) * sizeof(T));
+	}
+	return (*this);
+}
+
+template <class T>
+bool SPLGrid<T>::resize(const SPLVector3i &size, const SPLenum layout, const SPLsizei brick) throw()
+{
+	const SPLint64 count = getStorageSize(size, layout, brick);
+	if (count < 0)
+	{
+		return false;
+	}
+	T *data = 0;
+	if (count > 0)
+	{
+		data = (T *)splMemoryAlloc(count * SPLint64(sizeof(T)));
+		if (data == 0)
+		{
+			return false;
+		}
+	}
+	return this->adopt(data, count, true, 0, size, layout, brick);
+}
+
+template <class T>
+bool SPLGrid<T>::resize(const SPLVector3i &size, const SPLenum layout, const SPLsizei brick, SPLMemoryPool &memory) throw()
+{
+	const SPLint64 count = getStorageSize(size, layout, brick);
+	if (count < 0)
+	{
+		return false;
+	}
+	T *data = 0;
+	if (count > 0)
+	{
+		data = (T *)memory.allocate(count * SPLint64(sizeof(T)));
+		if (data == 0)
+		{
+			return false;
+		}
+	}
+	return this->adopt(data, count, true, &memory, size, layout, brick);
+}
+
+template <class T>
+bool SPLGrid<T>::resize(const SPLVector3i &size, const SPLenum layout, const SPLsizei brick, SPLArena &arena) throw()
+{
+	const SPLint64 count = getStorageSize(size, layout, brick);
+	if (count < 0)
+	{
+		return false;
+	}
+	T *data = 0;
+	if (count > 0)
+	{
+		data = arena.allocate<T>(count);
+		if (data == 0)
+		{
+			return false;
+		}
+	}
+	return this->adopt(data, count, false, 0, size, layout, brick);
+}
+
+template <class T>
+bool SPLGrid<T>::setExternal(T *data, const SPLVector3i &size, const SPLenum layout, const SPLsizei brick) throw()
+{
+	const SPLint64 count = getStorageSize(size, layout, brick);
+	if (count < 0 || (count > 0 && data == 0))
+	{
+		return false;
+	}
+	this->release();
+	this->data = data;
+	this->owner = false;
+	return this->setup(size, layout, brick);
+}
+
+template <class T>
+bool SPLGrid<T>::setLayout(const SPLenum layout, const SPLsizei brick, SPLThreadPool &pool) throw()
+{
+	if (layout == this->layout && (layout == SPL_GRID_LINEAR || brick == this->brick))
+	{
+		return true;
+	}
+	SPLGrid<T> g;
+	if (!g.resize(this->size, layout, brick))
+	{
+		return false;
+	}
+	const SPLGrid<T> &src = *this;
+	pool.parallelFor(0, g.blocks, 1, [&](const SPLint64 first, const SPLint64 last)
+	{
+		for (Iterator it = g.begin(first, last); it != g.end(first, last); ++it)
+		{
+			*it = src[it.getPosition()];
+		}
+	});
+	this->swap(g);
+	return true;
+}
+
+template <class T>
+SPLint64 SPLGrid<T>::getStorageSize(const SPLVector3i &size, const SPLenum layout, const SPLsizei brick) throw()
+{
+	if (size.x < 0 || size.y < 0 || size.z < 0)
+	{
+		return -1;
+	}
+	if (layout == SPL_GRID_LINEAR)
+	{
+		return SPLint64(size.x) * SPLint64(size.y) * SPLint64(size.z);
+	}
+	const SPLindex s = SPLGridDetail::log2(brick);
+	if (layout != SPL_GRID_BRICKED || s < 1 || s > 10)
+	{
+		return -1;
+	}
+	const SPLint64 bx = (size.x + brick - 1) >> s, by = (size.y + brick - 1) >> s, bz = (size.z + brick - 1) >> s;
+	return bx * by * bz * (SPLint64(1) << (3 * s));
+}
+
+template <class T>
+const SPLint64* SPLGrid<T>::getOffsets(const SPLindex axis) const throw()
+{
+	assert(axis >= 0 && axis <= 2);
+	return &this->offsets[axis][1];
+}
+
+template <class T>
+SPLint64 SPLGrid<T>::getOffset(const SPLindex x, const SPLindex y, const SPLindex z) const throw()
+{
+	assert(x >= -1 && x <= this->size.x && y >= -1 && y <= this->size.y && z >= -1 && z <= this->size.z);
+	return this->offsets[0][x + 1] + this->offsets[1][y + 1] + this->offsets[2][z + 1];
+}
+
+template <class T>
+T& SPLGrid<T>::operator () (const SPLindex x, const SPLindex y, const SPLindex z) throw()
+{
+	assert(x >= 0 && x < this->size.x && y >= 0 && y < this->size.y && z >= 0 && z < this->size.z);
+	return this->data[this->getOffset(x, y, z)];
+}
+
+template <class T>
+const T& SPLGrid<T>::operator () (const SPLindex x, const SPLindex y, const SPLindex z) const throw()
+{
+	assert(x >= 0 && x < this->size.x && y >= 0 && y < this->size.y && z >= 0 && z < this->size.z);
+	return this->data[this->getOffset(x, y, z)];
+}
+
+template <class T>
+T& SPLGrid<T>::operator [] (const SPLVector3i &p) throw()
+{
+	return this->operator () (p.x, p.y, p.z);
+}
+
+template <class T>
+const T& SPLGrid<T>::operator [] (const SPLVector3i &p) const throw()
+{
+	return this->operator () (p.x, p.y, p.z);
+}
+
+template <class T>
+T SPLGrid<T>::getClamped(const SPLindex x, const SPLindex y, const SPLindex z) const throw()
+{
+	assert(this->count > 0);
+	return this->operator () (CLAMP(x, 0, this->size.x - 1), CLAMP(y, 0, this->size.y - 1), CLAMP(z, 0, this->size.z - 1));
+}
+
+template <class T>
+void SPLGrid<T>::fill(const T &v) throw()
+{
+	std::fill(this->data, this->data + this->count, v);
+}
+
+template <class T>
+void SPLGrid<T>::fromLinear(const T *v, SPLThreadPool &pool) throw()
+{
+	const SPLint64 *ox = this->getOffsets(0), *oy = this->getOffsets(1), *oz = this->getOffsets(2);
+	pool.parallelFor(0, this->blocks, 1, [&](const SPLint64 first, const SPLint64 last)
+	{
+		SPLVector3i lo, hi;
+		for (SPLindex b = SPLindex(first); b < SPLindex(last); b++)
+		{
+			this->getBlock(b, lo, hi);
+			for (SPLindex z = lo.z; z < hi.z; z++)
+			{
+				for (SPLindex y = lo.y; y < hi.y; y++)
+				{
+					const T *src = v + (SPLint64(z) * this->size.y + y) * this->size.x;
+					T *dst = this->data + oy[y] + oz[z];
+					for (SPLindex x = lo.x; x < hi.x; x++)
+					{
+						dst[ox[x]] = src[x];
+					}
+				}
+			}
+		}
+	});
+}
+
+template <class T>
+void SPLGrid<T>::toLinear(T *v, SPLThreadPool &pool) const throw()
+{
+	const SPLint64 *ox = this->getOffsets(0), *oy = this->getOffsets(1), *oz = this->getOffsets(2);
+	pool.parallelFor(0, this->blocks, 1, [&](const SPLint64 first, const SPLint64 last)
+	{
+		SPLVector3i lo, hi;
+		for (SPLindex b = SPLindex(first); b < SPLindex(last); b++)
+		{
+			this->getBlock(b, lo, hi);
+			for (SPLindex z = lo.z; z < hi.z; z++)
+			{
+				for (SPLindex y = lo.y; y < hi.y; y++)
+				{
+					T *dst = v + (SPLint64(z) * this->size.y + y) * this->size.x;
+					const T *src = this->data + oy[y] + oz[z];
+					for (SPLindex x = lo.x; x < hi.x; x++)
+					{
+						dst[x] = src[ox[x]];
+					}
+				}
+			}
+		}
+	});
+}
+
+template <class T>
+void SPLGrid<T>::getBlock(const SPLindex b, SPLVector3i &lo, SPLVector3i &hi) const throw()
+{
+	assert(b >= 0 && b < this->blocks);
+	if (this->layout == SPL_GRID_LINEAR)
+	{
+		lo = SPLVector3i(0, 0, b);
+		hi = SPLVector3i(this->size.x, this->size.y, b + 1);
+		return;
+	}
+	const SPLindex bx = b % this->bricks.x, by = (b / this->bricks.x) % this->bricks.y, bz = b / (this->bricks.x * this->bricks.y);
+	lo = SPLVector3i(bx * this->brick, by * this->brick, bz * this->brick);
+	hi = SPLVector3i(MIN(lo.x + this->brick, this->size.x), MIN(lo.y + this->brick, this->size.y), MIN(lo.z + this->brick, this->size.z));
+}
+
+template <class T>
+bool SPLGrid<T>::setup(const SPLVector3i &size, const SPLenum layout, const SPLsizei brick) throw()
+{
+	this->size = size;
+	this->layout = layout;
+	this->brick = (layout == SPL_GRID_BRICKED) ? brick : 0;
+	this->count = getStorageSize(size, layout, brick);
+	const bool empty = (size.x == 0 || size.y == 0 || size.z == 0);
+	if (layout == SPL_GRID_LINEAR)
+	{
+		this->bricks = SPLVector3i(1, 1, size.z);
+	}
+	else
+	{
+		this->bricks = SPLVector3i((size.x + brick - 1) / brick, (size.y + brick - 1) / brick, (size.z + brick - 1) / brick);
+	}
+	this->blocks = empty ? 0 : this->bricks.x * this->bricks.y * this->bricks.z;
+
+	// o[c + 1] is the offset of the coordinate c, the ends are clamped to the border
+	const SPLint64 n[3] = { size.x, size.y, size.z };
+	const SPLindex s = SPLGridDetail::log2(brick);
+	for (SPLindex a = 0; a < 3; a++)
+	{
+		std::vector<SPLint64> &o = this->offsets[a];
+		o.assign(size_t(n[a] + 2), 0);
+		for (SPLint64 c = 0; c < n[a]; c++)
+		{
+			if (layout == SPL_GRID_LINEAR)
+			{
+				o[c + 1] = c * (a == 0 ? 1 : (a == 1 ? n[0] : n[0] * n[1]));
+			}
+			else
+			{
+				// brick index x fastest, Morton code within the brick
+				const SPLint64 volume = SPLint64(1) << (3 * s);
+				const SPLint64 stride = (a == 0 ? 1 : (a == 1 ? this->bricks.x : SPLint64(this->bricks.x) * this->bricks.y));
+				o[c + 1] = (c >> s) * stride * volume + (SPLGridDetail::spread(c & (brick - 1)) << a);
+			}
+		}
+		if (n[a] > 0)
+		{
+			o[0] = o[1];
+			o[size_t(n[a] + 1)] = o[size_t(n[a])];
+		}
+	}
+	return true;
+}
+
+template <class T>
+bool SPLGrid<T>::adopt(T *data, const SPLint64 count, const bool owner, SPLMemoryPool *memory,
+					   const SPLVector3i &size, const SPLenum layout, const SPLsizei brick) throw()
+{
+	this->release();
+	splMemoryZero(data, count * SPLint64(sizeof(T)));
+	this->data = data;
+	this->owner = owner;
+	this->memory = memory;
+	return this->setup(size, layout, brick);
+}
+
+template <class T>
+void SPLGrid<T>::release(void) throw()
+{
+	if (this->owner)
+	{
+		if (this->memory != 0)
+		{
+			this->memory->deallocate(this->data);
+		}
+		else
+		{
+			splMemoryFree(this->data);
+		}
+	}
+	this->data = 0;
+	this->owner = true;
+	this->memory = 0;
+}
+
+template <class T>
+void SPLGrid<T>::swap(SPLGrid<T> &g) throw()
+{
+	std::swap(this->size, g.size);
+	std::swap(this->layout, g.layout);
+	std::swap(this->brick, g.brick);
+	std::swap(this->bricks, g.bricks);
+	std::swap(this->blocks, g.blocks);
+	std::swap(this->count, g.count);
+	std::swap(this->data, g.data);
+	std::swap(this->owner, g.owner);
+	std::swap(this->memory, g.memory);
+	for (SPLindex a = 0; a < 3; a++)
+	{
+		this->offsets[a].swap(g.offsets[a]);
+	}
+}
+
+/************************************************************************************************
+ ** SPLGridIterator class implementation
+ ************************************************************************************************/
+template <class T, class V>
+SPLGridIterator<T, V>::SPLGridIterator(const SPLGrid<T> *grid, V *data, const SPLindex block, const SPLindex last) throw()
+{
+	this->grid = grid;
+	this->data = data;
+	this->ox = grid->getOffsets(0);
+	this->oy = grid->getOffsets(1);
+	this->oz = grid->getOffsets(2);
+	this->block = block;
+	this->last = last;
+	this->row = 0;
+	this->setBlock();
+}
+
+template <class T, class V>
+V& SPLGridIterator<T, V>::getNeighbor(const SPLindex dx, const SPLindex dy, const SPLindex dz) const throw()
+{
+	assert(dx >= -1 && dx <= 1 && dy >= -1 && dy <= 1 && dz >= -1 && dz <= 1);
+	return this->data[this->ox[this->pos.x + dx] + this->oy[this->pos.y + dy] + this->oz[this->pos.z + dz]];
+}
+
+template <class T, class V>
+SPLGridIterator<T, V>& SPLGridIterator<T, V>::operator ++ (void) throw()
+{
+	if (++this->pos.x < this->hi.x)
+	{
+		return (*this);
+	}
+	this->pos.x = this->lo.x;
+	if (++this->pos.y >= this->hi.y)
+	{
+		this->pos.y = this->lo.y;
+		if (++this->pos.z >= this->hi.z)
+		{
+			this->block++;
+			this->setBlock();
+			return (*this);
+		}
+	}
+	this->row = this->oy[this->pos.y] + this->oz[this->pos.z];
+	return (*this);
+}
+
+template <class T, class V>
+void SPLGridIterator<T, V>::setBlock(void) throw()
+{
+	if (this->block >= this->last)
+	{
+		// the end iterator of every range
+		this->block = this->last;
+		this->lo = this->hi = this->pos = SPLVector3i(0, 0, 0);
+		return;
+	}
+	this->grid->getBlock(this->block, this->lo, this->hi);
+	this->pos = this->lo;
+	this->row = this->oy[this->pos.y] + this->oz[this->pos.z];
+}
+
+#endif /*_spl_grid_hh_*/
@@ -0,0 +1,374 @@
+#ifndef _spl_half_hh_
+#define _spl_half_hh_
+
+#include <cmath>
+#include <cstring>
+
+#include <spl/typesbase.hh>
+#include <spl/mathbase.hh>
+#include <spl/cudadefs.hh>
+#include <spl/precision.hh>
+#include <spl/simd.hh>
+
+#if !defined(__CUDA_ARCH__) && defined(__F16C__)
+#define SPL_HALF_F16C
+#endif
+
+#if defined(SPL_SIMD_AVX512) || (defined(SPL_SIMD_AVX2) && defined(SPL_HALF_F16C))
+#define SPL_HALF_SIMD
+#endif
+
+// without F16C at compile time the arrays are converted with F16C if the processor has it
+#if !defined(SPL_HALF_SIMD) && !defined(__CUDACC__) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SPL_HALF_DISPATCH
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
+/*! \file half.hh
+ * \brief Storage types of 16 and 8 bits for floating point data.
+ *
+ * The types halve (or quarter) the memory and the bandwidth of grids of
+ * \ref SPLieee32, the arithmetic is done in \ref SPLieee32, i.e. the
+ * values convert implicitly from and to \ref SPLieee32:
+ * - \ref SPLieee16: IEEE 754 half precision, 11 significant bits in
+ *   \f$ [-65504, 65504] \f$, conversions round to the nearest value (ties to even),
+ * - \ref SPLunorm8 and \ref SPLunorm16: \f$ [0, 1] \f$ in 255 or 65535
+ *   steps, conversions saturate and round to the nearest step (ties to even).
+ *
+ * Arrays and grids are converted with \ref splConvert, which uses the
+ * F16C instructions and the registers of \ref SPLSimd. Builds without
+ * F16C (e.g. without \c -mf16c or \c -march) check the processor at run
+ * time and convert arrays of \ref SPLieee16 with F16C if it is available,
+ * and in software otherwise (about 4 times slower than the same pass
+ * over \ref SPLieee32). Single values always convert in software in
+ * such builds.
+ * */
+
+namespace SPLHalfDetail
+{
+	//! Converts a float to half precision bits (round to nearest even, NaNs become quiet NaNs).
+	CUDA_CALLABLE_MEMBER inline SPLuint16 fromFloat(const SPLieee32 v) throw()
+	{
+		SPLuint32 f, o;
+		memcpy(&f, &v, 4);
+		const SPLuint32 sign = f & 0x80000000u;
+		f ^= sign;
+		if (f >= (143u << 23))
+		{
+			// beyond the largest half, infinity or NaN
+			o = (f > (255u << 23)) ? 0x7e00u : 0x7c00u;
+		}
+		else if (f < (113u << 23))
+		{
+			// subnormal halfs are rounded by the float addition of 0.5
+			const SPLuint32 magic = 126u << 23;
+			SPLieee32 a, b;
+			memcpy(&a, &f, 4);
+			memcpy(&b, &magic, 4);
+			a += b;
+			memcpy(&o, &a, 4);
+			o -= magic;
+		}
+		else
+		{
+			const SPLuint32 odd = (f >> 13) & 1u;
+			f += 0xc8000fffu + odd;
+			o = f >> 13;
+		}
+		return SPLuint16(o | (sign >> 16));
+	}
+
+	//! Converts half precision bits to a float.
+	CUDA_CALLABLE_MEMBER inline SPLieee32 toFloat(const SPLuint16 h) throw()
+	{
+		const SPLuint32 exponent = 0x7c00u << 13;
+		SPLuint32 o = SPLuint32(h & 0x7fffu) << 13;
+		const SPLuint32 e = o & exponent;
+		o += (127u - 15u) << 23;
+		if (e == exponent)
+		{
+			o += (128u - 16u) << 23;
+		}
+		else if (e == 0)
+		{
+			// subnormal, renormalized by a float subtraction
+			const SPLuint32 magic = 113u << 23;
+			SPLieee32 a, b;
+			o += 1u << 23;
+			memcpy(&a, &o, 4);
+			memcpy(&b, &magic, 4);
+			a -= b;
+			memcpy(&o, &a, 4);
+		}
+		o |= SPLuint32(h & 0x8000u) << 16;
+		SPLieee32 v;
+		memcpy(&v, &o, 4);
+		return v;
+	}
+
+#if defined(SPL_HALF_DISPATCH)
+	//! Returns whether the processor and the operating system support F16C (which uses the AVX registers).
+	inline bool hasF16C(void) throw()
+	{
+		static const bool f16c = []()
+		{
+			unsigned int a, b, c, d;
+			if (!__get_cpuid(1, &a, &b, &c, &d) || (c & (bit_OSXSAVE | bit_AVX | bit_F16C)) != (bit_OSXSAVE | bit_AVX | bit_F16C))
+			{
+				return false;
+			}
+			// the operating system saves the SSE and AVX registers
+			unsigned int lo, hi;
+			__asm__ ("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+			return (lo & 6u) == 6u;
+		}();
+		return f16c;
+	}
+
+	//! Converts half precision bits to floats with F16C.
+	__attribute__((target("avx,f16c"))) inline void toFloatF16C(const SPLuint16 *src, SPLieee32 *dst, const SPLint64 n) throw()
+	{
+		SPLint64 i = 0;
+		for (; i + 8 <= n; i += 8)
+		{
+			_mm256_storeu_ps(dst + i, _mm256_cvtph_ps(_mm_loadu_si128((const __m128i *)(src + i))));
+		}
+		for (; i < n; i++)
+		{
+			dst[i] = _cvtsh_ss(src[i]);
+		}
+	}
+
+	//! Converts floats to half precision bits with F16C (round to nearest even).
+	__attribute__((target("avx,f16c"))) inline void fromFloatF16C(const SPLieee32 *src, SPLuint16 *dst, const SPLint64 n) throw()
+	{
+		SPLint64 i = 0;
+		for (; i + 8 <= n; i += 8)
+		{
+			_mm_storeu_si128((__m128i *)(dst + i), _mm256_cvtps_ph(_mm256_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC));
+		}
+		for (; i < n; i++)
+		{
+			dst[i] = SPLuint16(_cvtss_sh(src[i], _MM_FROUND_TO_NEAREST_INT));
+		}
+	}
+#endif
+
+	//! Converts an array of half precision bits to floats, with F16C if the processor has it.
+	inline void toFloat(const SPLuint16 *src, SPLieee32 *dst, const SPLint64 n) throw()
+	{
+#if defined(SPL_HALF_DISPATCH)
+		if (hasF16C())
+		{
+			toFloatF16C(src, dst, n);
+			return;
+		}
+#endif
+		for (SPLint64 i = 0; i < n; i++)
+		{
+			dst[i] = toFloat(src[i]);
+		}
+	}
+
+	//! Converts an array of floats to half precision bits, with F16C if the processor has it.
+	inline void fromFloat(const SPLieee32 *src, SPLuint16 *dst, const SPLint64 n) throw()
+	{
+#if defined(SPL_HALF_DISPATCH)
+		if (hasF16C())
+		{
+			fromFloatF16C(src, dst, n);
+			return;
+		}
+#endif
+		for (SPLint64 i = 0; i < n; i++)
+		{
+			dst[i] = fromFloat(src[i]);
+		}
+	}
+}
+
+/*! \class SPLieee16
+ * \brief IEEE 754 floating point with 16 bit (half precision).
+ *
+ * Example
+ * \code
+ * SPLGrid<SPLieee16> g(SPLVector3i(512, 512, 512));
+ * g(1, 2, 3) = 0.25f;
+ * const SPLieee32 v = 2.0f * g(1, 2, 3);
+ * \endcode
+ */
+class SPLieee16
+{
+public:
+	/*! \brief Constructor!
+	 *
+	 * The value is not initialized, like the values of the built-in types.
+	 */
+	SPLieee16(void) throw() = default;
+
+	/*! \brief Constructor!
+	 *
+	 * \param v The value, rounded to the nearest half.
+	 */
+	CUDA_CALLABLE_MEMBER SPLieee16(const SPLieee32 v) throw();
+
+	/*! \brief Conversion operator!
+	 *
+	 * \return The value as \ref SPLieee32 (exact).
+	 */
+	CUDA_CALLABLE_MEMBER operator SPLieee32 (void) const throw();
+
+	/*! \brief Returns the bits!
+	 *
+	 * \return Sign (bit 15), exponent (bits 10-14) and mantissa (bits 0-9).
+	 */
+	CUDA_CALLABLE_MEMBER SPLuint16 getBits(void) const throw() { return this->bits; }
+
+	/*! \brief Initializes a value with its bits!
+	 *
+	 * \param bits Sign (bit 15), exponent (bits 10-14) and mantissa (bits 0-9).
+	 *
+	 * \return The value.
+	 */
+	CUDA_CALLABLE_MEMBER static SPLieee16 fromBits(const SPLuint16 bits) throw() { SPLieee16 h; h.bits = bits; return h; }
+
+	CUDA_CALLABLE_MEMBER SPLieee16& operator += (const SPLieee32 v) throw() { return *this = SPLieee32(*this) + v; }	//!< Addition in float.
+	CUDA_CALLABLE_MEMBER SPLieee16& operator -= (const SPLieee32 v) throw() { return *this = SPLieee32(*this) - v; }	//!< Subtraction in float.
+	CUDA_CALLABLE_MEMBER SPLieee16& operator *= (const SPLieee32 v) throw() { return *this = SPLieee32(*this) * v; }	//!< Multiplication in float.
+	CUDA_CALLABLE_MEMBER SPLieee16& operator /= (const SPLieee32 v) throw() { return *this = SPLieee32(*this) / v; }	//!< Division in float.
+
+private:
+	SPLuint16 bits;	//!< The bits.
+};
+
+/*! \class SPLunorm
+ * \brief Fixed point value in \f$ [0, 1] \f$ with \f$ 2^B - 1 \f$ steps.
+ *
+ * \sa SPLunorm8 SPLunorm16
+ */
+template <class U>
+class SPLunorm
+{
+public:
+	/*! \brief Constructor!
+	 *
+	 * The value is not initialized, like the values of the built-in types.
+	 */
+	SPLunorm(void) throw() = default;
+
+	/*! \brief Constructor!
+	 *
+	 * \param v The value, saturated to \f$ [0, 1] \f$ and rounded to the nearest step.
+	 */
+	CUDA_CALLABLE_MEMBER SPLunorm(const SPLieee32 v) throw() : bits(U(nearbyintf((v > 0.0f) ? MIN(v, 1.0f) * getSteps() : 0.0f))) {}
+
+	/*! \brief Conversion operator!
+	 *
+	 * \return The value as \ref SPLieee32.
+	 */
+	CUDA_CALLABLE_MEMBER operator SPLieee32 (void) const throw() { return SPLieee32(this->bits) / getSteps(); }
+
+	/*! \brief Returns the bits!
+	 *
+	 * \return The number of steps.
+	 */
+	CUDA_CALLABLE_MEMBER U getBits(void) const throw() { return this->bits; }
+
+	/*! \brief Initializes a value with its bits!
+	 *
+	 * \param bits The number of steps.
+	 *
+	 * \return The value.
+	 */
+	CUDA_CALLABLE_MEMBER static SPLunorm<U> fromBits(const U bits) throw() { SPLunorm<U> u; u.bits = bits; return u; }
+
+	/*! \brief Returns the number of steps!
+	 *
+	 * \return \f$ 2^B - 1 \f$ as \ref SPLieee32.
+	 */
+	CUDA_CALLABLE_MEMBER static SPLieee32 getSteps(void) throw() { return SPLieee32(U(~U(0))); }
+
+	CUDA_CALLABLE_MEMBER SPLunorm<U>& operator += (const SPLieee32 v) throw() { return *this = SPLieee32(*this) + v; }	//!< Saturated addition in float.
+	CUDA_CALLABLE_MEMBER SPLunorm<U>& operator -= (const SPLieee32 v) throw() { return *this = SPLieee32(*this) - v; }	//!< Saturated subtraction in float.
+	CUDA_CALLABLE_MEMBER SPLunorm<U>& operator *= (const SPLieee32 v) throw() { return *this = SPLieee32(*this) * v; }	//!< Saturated multiplication in float.
+	CUDA_CALLABLE_MEMBER SPLunorm<U>& operator /= (const SPLieee32 v) throw() { return *this = SPLieee32(*this) / v; }	//!< Saturated division in float.
+
+private:
+	U bits;	//!< The number of steps.
+};
+
+typedef SPLunorm<SPLuint8> SPLunorm8;	//!< Fixed point value in \f$ [0, 1] \f$ with 8 bit!
+typedef SPLunorm<SPLuint16> SPLunorm16;	//!< Fixed point value in \f$ [0, 1] \f$ with 16 bit!
+
+template <> struct SPLTypeId<SPLieee16> { static const SPLenum value = SPL_TYPE_IEEE16; };
+template <> struct SPLTypeId<SPLunorm8> { static const SPLenum value = SPL_TYPE_UNORM8; };
+template <> struct SPLTypeId<SPLunorm16> { static const SPLenum value = SPL_TYPE_UNORM16; };
+
+template <> struct SPLPrecisionReal<SPLieee16> { typedef SPLieee32 Type; };
+template <> struct SPLPrecisionReal<SPLunorm8> { typedef SPLieee32 Type; };
+template <> struct SPLPrecisionReal<SPLunorm16> { typedef SPLieee32 Type; };
+
+#if defined(SPL_HALF_SIMD)
+
+template <>
+struct SPLSimdConvert<SPLieee16>
+{
+#if defined(SPL_SIMD_AVX512)
+	static inline SPLSimd<SPLieee32>::Type load(const SPLieee16 *p) throw() { return _mm512_cvtph_ps(_mm256_loadu_si256((const __m256i *)p)); }
+	static inline void store(SPLieee16 *p, const SPLSimd<SPLieee32>::Type a) throw()
+	{
+		_mm256_storeu_si256((__m256i *)p, _mm512_cvtps_ph(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC));
+	}
+#else
+	static inline SPLSimd<SPLieee32>::Type load(const SPLieee16 *p) throw() { return _mm256_cvtph_ps(_mm_loadu_si128((const __m128i *)p)); }
+	static inline void store(SPLieee16 *p, const SPLSimd<SPLieee32>::Type a) throw()
+	{
+		_mm_storeu_si128((__m128i *)p, _mm256_cvtps_ph(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC));
+	}
+#endif
+};
+
+#endif
+
+#if defined(SPL_SIMD_AVX512) || defined(SPL_SIMD_AVX2)
+
+template <class U>
+struct SPLSimdConvert<SPLunorm<U> >
+{
+	typedef SPLSimd<SPLieee32> S;
+
+	static inline S::Type load(const SPLunorm<U> *p) throw()
+	{
+		return S::div(SPLSimdConvert<U>::load((const U *)p), S::set(SPLunorm<U>::getSteps()));
+	}
+	static inline void store(SPLunorm<U> *p, const S::Type a) throw()
+	{
+		SPLSimdConvert<U>::store((U *)p, S::mul(S::min(S::max(a, S::set(0.0f)), S::set(1.0f)), S::set(SPLunorm<U>::getSteps())));
+	}
+};
+
+#endif
+
+/************************************************************************************************
+ ** SPLieee16 class implementation
+ ************************************************************************************************/
+inline SPLieee16::SPLieee16(const SPLieee32 v) throw()
+{
+#if defined(SPL_HALF_F16C)
+	this->bits = SPLuint16(_cvtss_sh(v, _MM_FROUND_TO_NEAREST_INT));
+#else
+	this->bits = SPLHalfDetail::fromFloat(v);
+#endif
+}
+
+inline SPLieee16::operator SPLieee32 (void) const throw()
+{
+#if defined(SPL_HALF_F16C)
+	return _cvtsh_ss(this->bits);
+#else
+	return SPLHalfDetail::toFloat(this->bits);
+#endif
+}
+
+#endif /* _spl_half_hh_ */
@@ -0,0 +1,183 @@
+#ifndef _spl_launch_hh_
+#define _spl_launch_hh_
+
+#include <spl/typesbase.hh>
+#include <spl/cudadefs.hh>
+#include <spl/simd.hh>
+#include <spl/threadpool.hh>
+#include <spl/allocator.hh>
+
+#ifdef __CUDACC__
+#include <cuda_runtime.h>
+#endif
+
+/*! \file launch.hh
+ * \brief Execution of CUDA-style kernels on the device or on the host.
+ *
+ * A kernel is a functor with the member
+ * \code
+ * CUDA_CALLABLE_MEMBER void operator () (const SPLindex i) const;
+ * \endcode
+ * which processes the element \c i of \f$ [0, n) \f$. It is launched with
+ * the usual grid/block shape by \ref splLaunch, either on the GPU as a
+ * grid-stride loop or on the host, where the range is split among the
+ * threads of \ref SPLThreadPool and each thread runs a contiguous SIMD
+ * loop. As with CUDA, the elements must be independent of each other.
+ *
+ * Example
+ * \code
+ * struct AddKernel
+ * {
+ * 	const SPLVector3f *a, *b;
+ * 	SPLVector3f *c;
+ * 	CUDA_CALLABLE_MEMBER void operator () (const SPLindex i) const { c[i] = a[i] + b[i]; }
+ * };
+ *
+ * AddKernel k = { a, b, c };
+ * splLaunch(SPLDim3((n + 255) / 256), SPLDim3(256), n, k);
+ * \endcode
+ *
+ * Without a CUDA compiler (or without a CUDA device at runtime) all
+ * kernels run on the host, such that the same code serves GPU and
+ * CPU-only machines. Memory accessed by a kernel on both backends is
+ * allocated with \ref splLaunchMalloc.
+ * */
+
+#if defined(__GNUC__) && !defined(__clang__)
+#define SPL_PRAGMA_SIMD _Pragma("GCC ivdep")	//!< Independent iterations, i.e. the loop may be vectorized.
+#elif defined(__clang__)
+#define SPL_PRAGMA_SIMD _Pragma("clang loop vectorize(enable)")
+#elif defined(_MSC_VER)
+#define SPL_PRAGMA_SIMD __pragma(loop(ivdep))
+#else
+#define SPL_PRAGMA_SIMD
+#endif
+
+#ifdef __CUDACC__
+typedef dim3 SPLDim3;	//!< Launch shape of a grid or a block.
+#else
+/*! \class SPLDim3
+ * \brief Launch shape of a grid or a block (\c dim3 on CUDA).
+ */
+struct SPLDim3
+{
+	SPLDim3(const SPLuint32 x = 1, const SPLuint32 y = 1, const SPLuint32 z = 1) throw() : x(x), y(y), z(z) {}
+	SPLuint32 x;	//!< 1st dimension.
+	SPLuint32 y;	//!< 2nd dimension.
+	SPLuint32 z;	//!< 3rd dimension.
+};
+#endif
+
+#ifdef __CUDACC__
+/*! \brief Device grid-stride loop of \ref splLaunch. */
+template <class F>
+__global__ void splLaunchKernel(const F kernel, const SPLsizei n)
+{
+	const SPLint64 block = SPLint64(blockIdx.x) + SPLint64(gridDim.x) * (blockIdx.y + SPLint64(gridDim.y) * blockIdx.z);
+	const SPLint64 thread = SPLint64(threadIdx.x) + SPLint64(blockDim.x) * (threadIdx.y + SPLint64(blockDim.y) * threadIdx.z);
+	const SPLint64 threads = SPLint64(blockDim.x) * blockDim.y * blockDim.z;
+	const SPLint64 stride = threads * gridDim.x * gridDim.y * gridDim.z;
+	for (SPLint64 i = block * threads + thread; i < n; i += stride)
+	{
+		kernel(SPLindex(i));
+	}
+}
+#endif
+
+/*! \brief Returns \c true if kernels are executed on a CUDA device!
+ *
+ * \return \c true if the library was compiled with CUDA and a device exists.
+ */
+inline bool splLaunchHasDevice(void) throw()
+{
+#ifdef __CUDACC__
+	static const bool device = []()
+	{
+		int count = 0;
+		return cudaGetDeviceCount(&count) == cudaSuccess && count > 0;
+	}();
+	return device;
+#else
+	return false;
+#endif
+}
+
+/*! \brief Allocates memory accessible by kernels on both backends!
+ *
+ * Uses managed memory on CUDA devices and \ref splMemoryAlloc otherwise.
+ *
+ * \param size Number of bytes.
+ *
+ * \return Pointer to the memory or \c 0 on failure.
+ */
+inline SPLvoidp splLaunchMalloc(const size_t size) throw()
+{
+#ifdef __CUDACC__
+	if (splLaunchHasDevice())
+	{
+		SPLvoidp p = 0;
+		return (cudaMallocManaged(&p, size) == cudaSuccess) ? p : 0;
+	}
+#endif
+	return splMemoryAlloc(SPLint64(size));
+}
+
+/*! \brief Frees memory allocated with \ref splLaunchMalloc!
+ *
+ * \param p Pointer to the memory (may be \c 0).
+ */
+inline void splLaunchFree(SPLvoidp p) throw()
+{
+#ifdef __CUDACC__
+	if (splLaunchHasDevice())
+	{
+		cudaFree(p);
+		return;
+	}
+#endif
+	splMemoryFree(p);
+}
+
+/*! \brief Launches a kernel for the elements \f$ [0, n) \f$!
+ *
+ * On the device the kernel runs as a grid-stride loop with the given
+ * shape and the call waits for its completion. On the host the range is
+ * split into chunks of at least one block which are processed by the
+ * threads of \c pool, each as a contiguous loop that the compiler may
+ * vectorize.
+ *
+ * \param grid Number of blocks.
+ * \param block Number of threads per block.
+ * \param n Number of elements.
+ * \param kernel The kernel functor.
+ * \param pool The threads of the host backend.
+ *
+ * \return \c true on success and \c false if the device launch failed.
+ */
+template <class F>
+bool splLaunch(const SPLDim3 grid, const SPLDim3 block, const SPLsizei n, const F &kernel,
+			   SPLThreadPool &pool = SPLThreadPool::getGlobal()) throw()
+{
+	assert(n >= 0);
+#ifdef __CUDACC__
+	if (splLaunchHasDevice())
+	{
+		splLaunchKernel<F><<<grid, block>>>(kernel, n);
+		return cudaDeviceSynchronize() == cudaSuccess;
+	}
+#endif
+	(void)grid;
+	const SPLint64 threads = SPLint64(block.x) * block.y * block.z;
+	pool.parallelFor(0, n, pool.getGrain(n, threads), [&kernel](const SPLint64 first, const SPLint64 last)
+	{
+		const SPLindex end = SPLindex(last);
+		SPL_PRAGMA_SIMD
+		for (SPLindex i = SPLindex(first); i < end; i++)
+		{
+			kernel(i);
+		}
+	});
+	return true;
+}
+
+#endif /* _spl_launch_hh_ */
@@ -0,0 +1,257 @@
+#ifndef _spl_light_hh_
+#define _spl_light_hh_
+
+#include <cmath>
+
+#include <spl/typesbase.hh>
+#include <spl/mathbase.hh>
+#include <spl/vector3.hh>
+#include <spl/matrix4.hh>
+#include <spl/material.hh>
+
+/*! \file light.hh
+ * */
+
+/*! \class SPLLight
+ * \brief A point (\ref SPL_LIGHT_POIN), directional (\ref SPL_LIGHT_DIRE)
+ * or spot (\ref SPL_LIGHT_SPOT) light source.
+ *
+ * Positions and directions are given in world coordinates. A spot light
+ * has the intensity \f$ \cos^e \phi \f$ inside its cone of the angle
+ * \f$ \phi_c \f$, where \f$ \phi \f$ is the angle to its direction. The
+ * intensity does not decrease with the distance.
+ *
+ * \sa SPLMaterial splShadePhong SPLRayCaster
+ */
+class SPLLight
+{
+public:
+	/*! \brief Constructor!
+	 *
+	 * Initializes a white directional light along \f$ -z \f$.
+	 *
+	 * \param type \ref SPL_LIGHT_POIN, \ref SPL_LIGHT_DIRE or \ref SPL_LIGHT_SPOT.
+	 */
+	explicit SPLLight(const SPLenum type = SPL_LIGHT_DIRE) throw();
+
+	/*! \brief Returns the type!
+	 *
+	 * \return \ref SPL_LIGHT_POIN, \ref SPL_LIGHT_DIRE or \ref SPL_LIGHT_SPOT.
+	 */
+	SPLenum getType(void) const throw() { return this->type; }
+
+	/*! \brief Sets the position (point and spot lights)!
+	 *
+	 * \param p The position.
+	 */
+	void setPosition(const SPLVector3f &p) throw() { this->position = p; }
+
+	/*! \brief Returns the position!
+	 *
+	 * \return The position.
+	 */
+	const SPLVector3f& getPosition(void) const throw() { return this->position; }
+
+	/*! \brief Sets the direction the light travels (directional and spot lights)!
+	 *
+	 * \param d The direction (non zero).
+	 */
+	void setDirection(const SPLVector3f &d) throw() { this->direction = d.getNormalized(1.0f); }
+
+	/*! \brief Returns the direction the light travels!
+	 *
+	 * \return The unit direction.
+	 */
+	const SPLVector3f& getDirection(void) const throw() { return this->direction; }
+
+	/*! \brief Sets the color!
+	 *
+	 * \param c The red, green and blue intensity.
+	 */
+	void setColor(const SPLVector3f &c) throw() { this->color = c; }
+
+	/*! \brief Returns the color!
+	 *
+	 * \return The red, green and blue intensity.
+	 */
+	const SPLVector3f& getColor(void) const throw() { return this->color; }
+
+	/*! \brief Sets the cone of a spot light!
+	 *
+	 * \param cutoff The angle \f$ \phi_c \f$ in degrees in \f$ [0, 90] \f$.
+	 * \param exponent The exponent \f$ e \f$.
+	 */
+	void setSpot(const SPLieee32 cutoff, const SPLieee32 exponent) throw();
+
+	/*! \brief Returns the cone of a spot light!
+	 *
+	 * \return The cosine \f$ \cos \phi_c \f$ of the cone angle.
+	 */
+	SPLieee32 getCutoff(void) const throw() { return this->cutoff; }
+
+	/*! \brief Returns the exponent of a spot light!
+	 *
+	 * \return The exponent \f$ e \f$.
+	 */
+	SPLieee32 getExponent(void) const throw() { return this->exponent; }
+
+	/*! \brief Returns the light at a point!
+	 *
+	 * \param p The point.
+	 * \param l The unit direction from the point to the light.
+	 *
+	 * \return The incident intensity.
+	 */
+	SPLVector3f illuminate(const SPLVector3f &p, SPLVector3f &l) const throw();
+
+	/*! \brief Returns the light in other coordinates!
+	 *
+	 * \param m A transformation.
+	 *
+	 * \return The light with the transformed position and direction.
+	 */
+	SPLLight getTransformed(const SPLMatrix4f &m) const throw();
+
+private:
+	SPLenum type;			//!< The type.
+	SPLVector3f position;	//!< The position.
+	SPLVector3f direction;	//!< The unit direction of the light.
+	SPLVector3f color;		//!< The intensity.
+	SPLieee32 cutoff;		//!< Cosine of the cone angle.
+	SPLieee32 exponent;		//!< Exponent of the spot.
+};
+
+/*! \brief Phong shading of a voxel!
+ *
+ * Computes \f$ k_a \sum c_i + \sum c_i (k_d \max(0, n \cdot l_i) + k_s \max(0, n \cdot h_i)^{k_e}) \f$
+ * with the halfway vector \f$ h_i \f$ (Blinn-Phong) for the ambient,
+ * diffuse, specular and shininess channels of the material. Normals
+ * pointing away from the viewer are flipped (two-sided lighting).
+ *
+ * \param material The material.
+ * \param s The normalized voxel value.
+ * \param p The position.
+ * \param n The unit normal.
+ * \param v The unit direction from the position to the viewer.
+ * \param lights Array of lights.
+ * \param count Number of lights.
+ *
+ * \return The reflected red, green and blue light.
+ *
+ * \sa SPLMaterial SPLLight
+ */
+inline SPLVector3f splShadePhong(const SPLMaterial &material, const SPLieee32 s, const SPLVector3f &p, const SPLVector3f &n,
+								 const SPLVector3f &v, const SPLLight *lights, const SPLsizei count) throw();
+
+/*! \brief Computes the Phong shading of given reflection coefficients!
+ *
+ * Same as \ref splShadePhong of a material, for coefficients which are
+ * already evaluated, e.g. gathered from a \ref SPLMaterialTable.
+ *
+ * \param ka The ambient reflection.
+ * \param kd The diffuse reflection.
+ * \param ks The specular reflection.
+ * \param shininess The specular exponent.
+ * \param p The position.
+ * \param n The unit normal.
+ * \param v The unit direction from the position to the viewer.
+ * \param lights Array of lights.
+ * \param count Number of lights.
+ *
+ * \return The reflected red, green and blue light.
+ */
+inline SPLVector3f splShadePhong(const SPLVector3f &ka, const SPLVector3f &kd, const SPLVector3f &ks, const SPLieee32 shininess,
+								 const SPLVector3f &p, const SPLVector3f &n, const SPLVector3f &v, const SPLLight *lights,
+								 const SPLsizei count) throw();
+
+/************************************************************************************************
+ ** SPLLight class implementation
+ ************************************************************************************************/
+inline SPLLight::SPLLight(const SPLenum type) throw()
+{
+	assert(type > SPL_LIGHT_MIN && type < SPL_LIGHT_MAX);
+	this->type = type;
+	this->position = SPLVector3f(0.0f, 0.0f, 0.0f);
+	this->direction = SPLVector3f(0.0f, 0.0f, -1.0f);
+	this->color = SPLVector3f(1.0f, 1.0f, 1.0f);
+	this->setSpot(30.0f, 0.0f);
+}
+
+inline void SPLLight::setSpot(const SPLieee32 cutoff, const SPLieee32 exponent) throw()
+{
+	this->cutoff = std::cos(CLAMP(cutoff, 0.0f, 90.0f) * 3.14159265358979f / 180.0f);
+	this->exponent = exponent;
+}
+
+inline SPLVector3f SPLLight::illuminate(const SPLVector3f &p, SPLVector3f &l) const throw()
+{
+	if (this->type == SPL_LIGHT_DIRE)
+	{
+		l = -this->direction;
+		return this->color;
+	}
+	l = this->position - p;
+	const SPLieee32 d = SPLieee32(l.length());
+	if (d <= 0.0f)
+	{
+		l = -this->direction;
+		return this->color;
+	}
+	l /= d;
+	if (this->type == SPL_LIGHT_POIN)
+	{
+		return this->color;
+	}
+	const SPLieee32 c = -(l * this->direction);
+	if (c < this->cutoff)
+	{
+		return SPLVector3f(0.0f, 0.0f, 0.0f);
+	}
+	return this->color * ((this->exponent > 0.0f) ? std::pow(c, this->exponent) : 1.0f);
+}
+
+inline SPLLight SPLLight::getTransformed(const SPLMatrix4f &m) const throw()
+{
+	SPLLight r(*this);
+	r.position = m.transformPoint(this->position);
+	r.direction = m.transformVector(this->direction).getNormalized(1.0f);
+	return r;
+}
+
+/************************************************************************************************
+ ** Functions
+ ************************************************************************************************/
+inline SPLVector3f splShadePhong(const SPLMaterial &material, const SPLieee32 s, const SPLVector3f &p, const SPLVector3f &n,
+								 const SPLVector3f &v, const SPLLight *lights, const SPLsizei count) throw()
+{
+	const SPLVector3f ka(material.getChannel(SPL_MATERIAL_AMBIENT_RED, s), material.getChannel(SPL_MATERIAL_AMBIENT_GREEN, s),
+						 material.getChannel(SPL_MATERIAL_AMBIENT_BLUE, s));
+	const SPLVector3f kd(material.getChannel(SPL_MATERIAL_DIFFUSE_RED, s), material.getChannel(SPL_MATERIAL_DIFFUSE_GREEN, s),
+						 material.getChannel(SPL_MATERIAL_DIFFUSE_BLUE, s));
+	const SPLVector3f ks(material.getChannel(SPL_MATERIAL_SPECULAR_RED, s), material.getChannel(SPL_MATERIAL_SPECULAR_GREEN, s),
+						 material.getChannel(SPL_MATERIAL_SPECULAR_BLUE, s));
+	return splShadePhong(ka, kd, ks, material.getChannel(SPL_MATERIAL_SHININESS, s), p, n, v, lights, count);
+}
+
+inline SPLVector3f splShadePhong(const SPLVector3f &ka, const SPLVector3f &kd, const SPLVector3f &ks, const SPLieee32 shininess,
+								 const SPLVector3f &p, const SPLVector3f &n, const SPLVector3f &v, const SPLLight *lights,
+								 const SPLsizei count) throw()
+{
+	const SPLVector3f m = (n * v < 0.0f) ? -n : n;
+
+	SPLVector3f r(0.0f, 0.0f, 0.0f);
+	for (SPLsizei i = 0; i < count; i++)
+	{
+		SPLVector3f l;
+		const SPLVector3f c = lights[i].illuminate(p, l);
+		const SPLieee32 diffuse = MAX(m * l, 0.0f);
+		const SPLVector3f h = (l + v).getNormalized(1.0f);
+		const SPLieee32 specular = (diffuse > 0.0f) ? std::pow(MAX(m * h, 0.0f), shininess) : 0.0f;
+		r += SPLVector3f(c.x * (ka.x + kd.x * diffuse + ks.x * specular),
+						 c.y * (ka.y + kd.y * diffuse + ks.y * specular),
+						 c.z * (ka.z + kd.z * diffuse + ks.z * specular));
+	}
+	return r;
+}
+
+#endif /* _spl_light_hh_ */
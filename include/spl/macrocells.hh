@@ -0,0 +1,487 @@
+#ifndef _spl_macrocells_hh_
+#define _spl_macrocells_hh_
+
+#include <vector>
+
+#include <spl/typesbase.hh>
+#include <spl/mathbase.hh>
+#include <spl/threadpool.hh>
+#include <spl/vector3.hh>
+#include <spl/grid.hh>
+#include <spl/material.hh>
+#include <spl/materialtable.hh>
+
+/*! \file macrocells.hh
+ * */
+
+/*! \class SPLMacroCells
+ * \brief A min-max hierarchy of macrocells for empty space skipping.
+ *
+ * The macrocell \f$ (x, y, z) \f$ of level \f$ 0 \f$ covers the voxels
+ * \f$ [x s, x s + s] \times [y s, y s + s] \times [z s, z s + s] \f$ of
+ * a volume, where \f$ s \f$ is the cell size. Neighboring cells share a
+ * layer of voxels, such that every trilinear interpolation inside a cell
+ * lies in the range of its minimum and maximum. Every cell of level
+ * \f$ l + 1 \f$ combines \f$ 2 \times 2 \times 2 \f$ cells of level
+ * \f$ l \f$, the last level has a single cell, i.e. the hierarchy is a
+ * min-max octree.
+ *
+ * A cell can be skipped by a ray if the opacity of the material is zero
+ * in its range (\ref isVisible) and by an isosurface extraction if the
+ * isovalue is outside its range (\ref containsIsovalue).
+ *
+ * Example
+ * \code
+ * SPLMacroCells<SPLuint16> m;
+ * m.build(volume);
+ * ...
+ * volume(x, y, z) = v;
+ * m.update(volume, SPLVector3i(x, y, z), SPLVector3i(x, y, z));
+ *
+ * // the isovalue of an isosurface is the constant of SPL_MATERIAL_ISOSURFACE
+ * const SPLieee32 iso = material.getChannel(SPL_MATERIAL_ISOSURFACE, 0.0f);
+ * for (SPLindex z = 0; z < m.getCellCount(0).z; z++)
+ *   ...
+ *     if (m.containsIsovalue(0, x, y, z, iso))
+ *       ...
+ * \endcode
+ *
+ * \sa SPLRayCaster SPLGrid
+ */
+template <class T>
+class SPLMacroCells
+{
+public:
+	/*! \brief Constructor!
+	 *
+	 * Initializes an empty hierarchy.
+	 */
+	SPLMacroCells(void) throw() : cell(0) {}
+
+	/*! \brief Builds the hierarchy of a volume!
+	 *
+	 * \param volume The volume.
+	 * \param cell Edge length of the cells of level \f$ 0 \f$ in voxels (positive).
+	 * \param pool The threads.
+	 *
+	 * \return \c true on success and \c false otherwise.
+	 */
+	bool build(const SPLGrid<T> &volume, const SPLsizei cell = 8, SPLThreadPool &pool = SPLThreadPool::getGlobal()) throw();
+
+	/*! \brief Updates the cells of a changed region!
+	 *
+	 * \param volume The volume of \ref build with changed voxels.
+	 * \param lo The first changed voxel.
+	 * \param hi The last changed voxel.
+	 * \param pool The threads.
+	 *
+	 * \return \c true on success and \c false otherwise.
+	 */
+	bool update(const SPLGrid<T> &volume, const SPLVector3i &lo, const SPLVector3i &hi,
+				SPLThreadPool &pool = SPLThreadPool::getGlobal()) throw();
+
+	/*! \brief Returns the edge length of the cells of level \f$ 0 \f$!
+	 *
+	 * \return Edge length in voxels or \f$ 0 \f$ if the hierarchy is empty.
+	 */
+	SPLsizei getCellSize(void) const throw() { return this->cell; }
+
+	/*! \brief Returns the edge length of the cells of a level!
+	 *
+	 * \param level The level.
+	 *
+	 * \return Edge length in voxels.
+	 */
+	SPLsizei getCellSize(const SPLindex level) const throw() { return this->cell << level; }
+
+	/*! \brief Returns the size of the volume!
+	 *
+	 * \return Number of voxels along x, y and z.
+	 */
+	const SPLVector3i& getSize(void) const throw() { return this->size; }
+
+	/*! \brief Returns the number of levels!
+	 *
+	 * \return Number of levels.
+	 */
+	SPLindex getLevelCount(void) const throw() { return SPLindex(this->levels.size()); }
+
+	/*! \brief Returns the number of cells of a level!
+	 *
+	 * \param level The level.
+	 *
+	 * \return Number of cells along x, y and z.
+	 */
+	const SPLVector3i& getCellCount(const SPLindex level) const throw() { return this->levels[level].count; }
+
+	/*! \brief Returns the minimum of a cell!
+	 *
+	 * \param level The level.
+	 * \param x The cell along x.
+	 * \param y The cell along y.
+	 * \param z The cell along z.
+	 *
+	 * \return The minimum voxel.
+	 */
+	T getMin(const SPLindex level, const SPLindex x, const SPLindex y, const SPLindex z) const throw() { return this->levels[level].min[this->getIndex(level, x, y, z)]; }
+
+	/*! \brief Returns the maximum of a cell!
+	 *
+	 * \param level The level.
+	 * \param x The cell along x.
+	 * \param y The cell along y.
+	 * \param z The cell along z.
+	 *
+	 * \return The maximum voxel.
+	 */
+	T getMax(const SPLindex level, const SPLindex x, const SPLindex y, const SPLindex z) const throw() { return this->levels[level].max[this->getIndex(level, x, y, z)]; }
+
+	/*! \brief Returns whether a cell has voxels in a range!
+	 *
+	 * \param level The level.
+	 * \param x The cell along x.
+	 * \param y The cell along y.
+	 * \param z The cell along z.
+	 * \param lo The lower bound of the range.
+	 * \param hi The upper bound of the range.
+	 *
+	 * \return \c true if the range of the cell intersects \f$ [lo, hi] \f$.
+	 */
+	bool intersects(const SPLindex level, const SPLindex x, const SPLindex y, const SPLindex z, const T lo, const T hi) const throw();
+
+	/*! \brief Returns whether an isosurface may pass a cell!
+	 *
+	 * \param level The level.
+	 * \param x The cell along x.
+	 * \param y The cell along y.
+	 * \param z The cell along z.
+	 * \param iso The isovalue.
+	 *
+	 * \return \c true if the isovalue is in the range of the cell.
+	 */
+	bool containsIsovalue(const SPLindex level, const SPLindex x, const SPLindex y, const SPLindex z, const SPLieee32 iso) const throw();
+
+	/*! \brief Returns whether a cell is not transparent!
+	 *
+	 * \param level The level.
+	 * \param x The cell along x.
+	 * \param y The cell along y.
+	 * \param z The cell along z.
+	 * \param material The material.
+	 *
+	 * \return \c true if the opacity is positive somewhere in the range of the cell.
+	 */
+	bool isVisible(const SPLindex level, const SPLindex x, const SPLindex y, const SPLindex z, const SPLMaterial &material) const throw();
+
+	/*! \brief Returns whether a cell is not transparent in the lookup tables!
+	 *
+	 * Unlike \ref isVisible(const SPLindex, const SPLindex, const SPLindex, const SPLindex, const SPLMaterial&) const
+	 * this is exact for samplers which look up the nearest entry of \c table.
+	 *
+	 * \param level The level.
+	 * \param x The cell along x.
+	 * \param y The cell along y.
+	 * \param z The cell along z.
+	 * \param table The lookup tables of the material.
+	 *
+	 * \return \c true if an entry in the range of the cell has a positive opacity.
+	 */
+	bool isVisible(const SPLindex level, const SPLindex x, const SPLindex y, const SPLindex z, const SPLMaterialTable &table) const throw();
+
+	/*! \brief Classifies all cells of a level!
+	 *
+	 * \param level The level.
+	 * \param material The material.
+	 * \param visible One flag per cell (x fastest) of \ref isVisible.
+	 * \param pool The threads.
+	 *
+	 * \return Number of visible cells.
+	 */
+	SPLint64 classify(const SPLindex level, const SPLMaterial &material, std::vector<SPLuint8> &visible,
+					  SPLThreadPool &pool = SPLThreadPool::getGlobal()) const throw();
+
+	/*! \brief Classifies all cells of a level with lookup tables!
+	 *
+	 * \param level The level.
+	 * \param table The lookup tables of the material.
+	 * \param visible One flag per cell (x fastest) of \ref isVisible.
+	 * \param pool The threads.
+	 *
+	 * \return Number of visible cells.
+	 */
+	SPLint64 classify(const SPLindex level, const SPLMaterialTable &table, std::vector<SPLuint8> &visible,
+					  SPLThreadPool &pool = SPLThreadPool::getGlobal()) const throw();
+
+	/*! \brief Returns the index of a cell!
+	 *
+	 * \param level The level.
+	 * \param x The cell along x.
+	 * \param y The cell along y.
+	 * \param z The cell along z.
+	 *
+	 * \return \f$ x + n_x (y + n_y z) \f$.
+	 */
+	SPLint64 getIndex(const SPLindex level, const SPLindex x, const SPLindex y, const SPLindex z) const throw();
+
+private:
+	/*! \brief The cells of one level!
+	 */
+	struct Level
+	{
+		SPLVector3i count;		//!< Number of cells.
+		std::vector<T> min;		//!< Minimum of every cell.
+		std::vector<T> max;		//!< Maximum of every cell.
+	};
+
+	/*! \brief Classifies all cells of a level with a predicate!
+	 */
+	template <class F>
+	SPLint64 classifyIf(const SPLindex level, const F &visibleIf, std::vector<SPLuint8> &visible, SPLThreadPool &pool) const throw();
+
+	/*! \brief Computes the cells of level 0 in a box of cells!
+	 */
+	void reduceVoxels(const SPLGrid<T> &volume, const SPLVector3i &lo, const SPLVector3i &hi, SPLThreadPool &pool) throw();
+
+	/*! \brief Computes the cells of a level from the level below in a box of cells!
+	 */
+	void reduceCells(const SPLindex level, const SPLVector3i &lo, const SPLVector3i &hi, SPLThreadPool &pool) throw();
+
+	SPLsizei cell;					//!< Edge length of the cells of level 0.
+	SPLVector3i size;				//!< Size of the volume.
+	std::vector<Level> levels;		//!< The levels.
+};
+
+/************************************************************************************************
+ ** SPLMacroCells class implementation
+ ************************************************************************************************/
+template <class T>
+bool SPLMacroCells<T>::build(const SPLGrid<T> &volume, const SPLsizei cell, SPLThreadPool &pool) throw()
+{
+	const SPLVector3i &n = volume.getSize();
+	if (cell <= 0 || n.x <= 0 || n.y <= 0 || n.z <= 0)
+	{
+		return false;
+	}
+	this->cell = cell;
+	this->size = n;
+	this->levels.clear();
+
+	// the cells share their last voxel layer, i.e. n voxels need (n - 1) / s cells
+	SPLVector3i count(MAX((n.x - 2) / cell + 1, 1), MAX((n.y - 2) / cell + 1, 1), MAX((n.z - 2) / cell + 1, 1));
+	for (;;)
+	{
+		Level l;
+		l.count = count;
+		l.min.resize(size_t(count.x) * count.y * count.z);
+		l.max.resize(l.min.size());
+		this->levels.push_back(l);
+		if (count.x == 1 && count.y == 1 && count.z == 1)
+		{
+			break;
+		}
+		count = SPLVector3i((count.x + 1) / 2, (count.y + 1) / 2, (count.z + 1) / 2);
+	}
+
+	this->reduceVoxels(volume, SPLVector3i(0, 0, 0), this->levels[0].count - SPLVector3i(1, 1, 1), pool);
+	for (SPLindex i = 1; i < this->getLevelCount(); i++)
+	{
+		this->reduceCells(i, SPLVector3i(0, 0, 0), this->levels[i].count - SPLVector3i(1, 1, 1), pool);
+	}
+	return true;
+}
+
+template <class T>
+bool SPLMacroCells<T>::update(const SPLGrid<T> &volume, const SPLVector3i &lo, const SPLVector3i &hi, SPLThreadPool &pool) throw()
+{
+	if (this->levels.empty() || volume.getSize() != this->size)
+	{
+		return false;
+	}
+	const SPLVector3i a(MAX(lo.x, 0), MAX(lo.y, 0), MAX(lo.z, 0));
+	const SPLVector3i b(MIN(hi.x, this->size.x - 1), MIN(hi.y, this->size.y - 1), MIN(hi.z, this->size.z - 1));
+	if (a.x > b.x || a.y > b.y || a.z > b.z)
+	{
+		return true;
+	}
+
+	// a voxel on a cell border belongs to both cells
+	const SPLVector3i &count = this->levels[0].count;
+	SPLVector3i c0(MAX(a.x - 1, 0) / this->cell, MAX(a.y - 1, 0) / this->cell, MAX(a.z - 1, 0) / this->cell);
+	SPLVector3i c1(MIN(b.x / this->cell, count.x - 1), MIN(b.y / this->cell, count.y - 1), MIN(b.z / this->cell, count.z - 1));
+	this->reduceVoxels(volume, c0, c1, pool);
+	for (SPLindex i = 1; i < this->getLevelCount(); i++)
+	{
+		c0 = SPLVector3i(c0.x / 2, c0.y / 2, c0.z / 2);
+		c1 = SPLVector3i(c1.x / 2, c1.y / 2, c1.z / 2);
+		this->reduceCells(i, c0, c1, pool);
+	}
+	return true;
+}
+
+template <class T>
+SPLint64 SPLMacroCells<T>::getIndex(const SPLindex level, const SPLindex x, const SPLindex y, const SPLindex z) const throw()
+{
+	assert(level >= 0 && level < this->getLevelCount());
+	const SPLVector3i &n = this->levels[level].count;
+	assert(x >= 0 && x < n.x && y >= 0 && y < n.y && z >= 0 && z < n.z);
+	return x + SPLint64(n.x) * (y + SPLint64(n.y) * z);
+}
+
+template <class T>
+bool SPLMacroCells<T>::intersects(const SPLindex level, const SPLindex x, const SPLindex y, const SPLindex z, const T lo, const T hi) const throw()
+{
+	const SPLint64 i = this->getIndex(level, x, y, z);
+	return !(this->levels[level].max[i] < lo || hi < this->levels[level].min[i]);
+}
+
+template <class T>
+bool SPLMacroCells<T>::containsIsovalue(const SPLindex level, const SPLindex x, const SPLindex y, const SPLindex z, const SPLieee32 iso) const throw()
+{
+	const SPLint64 i = this->getIndex(level, x, y, z);
+	return SPLieee32(this->levels[level].min[i]) <= iso && iso <= SPLieee32(this->levels[level].max[i]);
+}
+
+template <class T>
+bool SPLMacroCells<T>::isVisible(const SPLindex level, const SPLindex x, const SPLindex y, const SPLindex z, const SPLMaterial &material) const throw()
+{
+	const SPLint64 i = this->getIndex(level, x, y, z);
+	const SPLieee32 s0 = material.getNormalized(SPLieee32(this->levels[level].min[i]));
+	const SPLieee32 s1 = material.getNormalized(SPLieee32(this->levels[level].max[i]));
+	return material.getMaxOpacity(MIN(s0, s1), MAX(s0, s1)) > 0.0f;
+}
+
+template <class T>
+bool SPLMacroCells<T>::isVisible(const SPLindex level, const SPLindex x, const SPLindex y, const SPLindex z, const SPLMaterialTable &table) const throw()
+{
+	const SPLint64 i = this->getIndex(level, x, y, z);
+	const SPLindex i0 = table.getIndex(SPLieee32(this->levels[level].min[i])), i1 = table.getIndex(SPLieee32(this->levels[level].max[i]));
+	return table.isVisible(MIN(i0, i1), MAX(i0, i1));
+}
+
+template <class T>
+SPLint64 SPLMacroCells<T>::classify(const SPLindex level, const SPLMaterial &material, std::vector<SPLuint8> &visible, SPLThreadPool &pool) const throw()
+{
+	return this->classifyIf(level, [&](const SPLindex x, const SPLindex y, const SPLindex z)
+	{
+		return this->isVisible(level, x, y, z, material);
+	}, visible, pool);
+}
+
+template <class T>
+SPLint64 SPLMacroCells<T>::classify(const SPLindex level, const SPLMaterialTable &table, std::vector<SPLuint8> &visible, SPLThreadPool &pool) const throw()
+{
+	return this->classifyIf(level, [&](const SPLindex x, const SPLindex y, const SPLindex z)
+	{
+		return this->isVisible(level, x, y, z, table);
+	}, visible, pool);
+}
+
+template <class T>
+template <class F>
+SPLint64 SPLMacroCells<T>::classifyIf(const SPLindex level, const F &visibleIf, std::vector<SPLuint8> &visible, SPLThreadPool &pool) const throw()
+{
+	assert(level >= 0 && level < this->getLevelCount());
+	const SPLVector3i &n = this->levels[level].count;
+	visible.resize(this->levels[level].min.size());
+	std::vector<SPLint64> counts(size_t(n.z), 0);
+	pool.parallelFor(0, n.z, 1, [&](const SPLint64 first, const SPLint64 last)
+	{
+		for (SPLindex z = SPLindex(first); z < SPLindex(last); z++)
+		{
+			for (SPLindex y = 0; y < n.y; y++)
+			{
+				for (SPLindex x = 0; x < n.x; x++)
+				{
+					const bool v = visibleIf(x, y, z);
+					visible[size_t(this->getIndex(level, x, y, z))] = v ? 1 : 0;
+					counts[size_t(z)] += v ? 1 : 0;
+				}
+			}
+		}
+	});
+	SPLint64 ret = 0;
+	for (size_t i = 0; i < counts.size(); i++)
+	{
+		ret += counts[i];
+	}
+	return ret;
+}
+
+template <class T>
+void SPLMacroCells<T>::reduceVoxels(const SPLGrid<T> &volume, const SPLVector3i &lo, const SPLVector3i &hi, SPLThreadPool &pool) throw()
+{
+	const SPLVector3i &n = this->size;
+	const SPLint64 *ox = volume.getOffsets(0), *oy = volume.getOffsets(1), *oz = volume.getOffsets(2);
+	const T *data = volume.getData();
+	Level &l = this->levels[0];
+	const SPLindex rows = hi.y - lo.y + 1;
+
+	// one task per row of cells
+	pool.parallelFor(0, SPLint64(rows) * (hi.z - lo.z + 1), 1, [&](const SPLint64 first, const SPLint64 last)
+	{
+		for (SPLint64 r = first; r < last; r++)
+		{
+			const SPLindex cy = lo.y + SPLindex(r % rows), cz = lo.z + SPLindex(r / rows);
+			const SPLindex y0 = cy * this->cell, y1 = MIN(y0 + this->cell, n.y - 1);
+			const SPLindex z0 = cz * this->cell, z1 = MIN(z0 + this->cell, n.z - 1);
+			for (SPLindex cx = lo.x; cx <= hi.x; cx++)
+			{
+				const SPLindex x0 = cx * this->cell, x1 = MIN(x0 + this->cell, n.x - 1);
+				T a = data[ox[x0] + oy[y0] + oz[z0]], b = a;
+				for (SPLindex z = z0; z <= z1; z++)
+				{
+					for (SPLindex y = y0; y <= y1; y++)
+					{
+						const SPLint64 o = oy[y] + oz[z];
+						for (SPLindex x = x0; x <= x1; x++)
+						{
+							const T v = data[ox[x] + o];
+							a = (v < a) ? v : a;
+							b = (b < v) ? v : b;
+						}
+					}
+				}
+				const SPLint64 i = this->getIndex(0, cx, cy, cz);
+				l.min[size_t(i)] = a;
+				l.max[size_t(i)] = b;
+			}
+		}
+	});
+}
+
+template <class T>
+void SPLMacroCells<T>::reduceCells(const SPLindex level, const SPLVector3i &lo, const SPLVector3i &hi, SPLThreadPool &pool) throw()
+{
+	const Level &s = this->levels[level - 1];
+	Level &l = this->levels[level];
+	const SPLindex rows = hi.y - lo.y + 1;
+	pool.parallelFor(0, SPLint64(rows) * (hi.z - lo.z + 1), 16, [&](const SPLint64 first, const SPLint64 last)
+	{
+		for (SPLint64 r = first; r < last; r++)
+		{
+			const SPLindex cy = lo.y + SPLindex(r % rows), cz = lo.z + SPLindex(r / rows);
+			for (SPLindex cx = lo.x; cx <= hi.x; cx++)
+			{
+				const SPLint64 c = this->getIndex(level - 1, 2 * cx, 2 * cy, 2 * cz);
+				T a = s.min[size_t(c)], b = s.max[size_t(c)];
+				for (SPLindex z = 2 * cz; z <= MIN(2 * cz + 1, s.count.z - 1); z++)
+				{
+					for (SPLindex y = 2 * cy; y <= MIN(2 * cy + 1, s.count.y - 1); y++)
+					{
+						for (SPLindex x = 2 * cx; x <= MIN(2 * cx + 1, s.count.x - 1); x++)
+						{
+							const SPLint64 i = this->getIndex(level - 1, x, y, z);
+							a = (s.min[size_t(i)] < a) ? s.min[size_t(i)] : a;
+							b = (b < s.max[size_t(i)]) ? s.max[size_t(i)] : b;
+						}
+					}
+				}
+				const SPLint64 i = this->getIndex(level, cx, cy, cz);
+				l.min[size_t(i)] = a;
+				l.max[size_t(i)] = b;
+			}
+		}
+	});
+}
+
+#endif /* _spl_macrocells_hh_ */
@@ -0,0 +1,287 @@
+#ifndef _spl_mappedfile_hh_
+#define _spl_mappedfile_hh_
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>     // for open()
+#include <sys/mman.h>  // for mmap(), madvise()
+#include <sys/stat.h>  // for fstat()
+#include <unistd.h>    // for close(), sysconf()
+#endif
+
+#include <spl/typesbase.hh>
+
+/*! \file mappedfile.hh
+ * */
+
+/*! \class SPLMappedFile
+ * \brief A read-only memory mapping of a whole file.
+ *
+ * The file is mapped shared and read-only, i.e. opening it costs a few
+ * system calls independent of its size, the pages are read on the first
+ * access, and all processes which map the same file share its pages in
+ * the page cache. Writing into the mapping is not allowed.
+ *
+ * The access pattern hints (\ref SPL_FILEIO_ACCESS_NORMAL,
+ * \ref SPL_FILEIO_ACCESS_SEQUENTIAL and \ref SPL_FILEIO_ACCESS_RANDOM)
+ * control the read ahead of the kernel, i.e. \c madvise() on POSIX
+ * systems and the \c FILE_FLAG_SEQUENTIAL_SCAN / \c FILE_FLAG_RANDOM_ACCESS
+ * flags on Windows.
+ *
+ * Example
+ * \code
+ * SPLMappedFile f;
+ * if (f.open("ct.raw", SPL_FILEIO_ACCESS_RANDOM))
+ * {
+ *     const SPLuint16 *v = (const SPLuint16 *)f.getData();
+ *     ...
+ * }
+ * \endcode
+ *
+ * \sa SPLMappedGrid
+ */
+class SPLMappedFile
+{
+public:
+	/*! \brief Constructor!
+	 *
+	 * Initializes an empty mapping.
+	 */
+	SPLMappedFile(void) throw();
+
+	/*! \brief Destructor!
+	 *
+	 * Unmaps the file.
+	 */
+	~SPLMappedFile(void) throw();
+
+	/*! \brief Maps a file!
+	 *
+	 * A previously mapped file is unmapped.
+	 *
+	 * \param path The file.
+	 * \param access The access pattern hint, see \ref advise.
+	 *
+	 * \return \c true on success and \c false otherwise, e.g. if the file
+	 * does not exist or is empty.
+	 */
+	bool open(const char *path, const SPLenum access = SPL_FILEIO_ACCESS_NORMAL) throw();
+
+	/*! \brief Unmaps the file!
+	 *
+	 * Pointers into the mapping become invalid.
+	 */
+	void close(void) throw();
+
+	/*! \brief Changes the access pattern hint of a range of the file!
+	 *
+	 * The hint is only supported on POSIX systems, where it is passed to
+	 * \c madvise().
+	 *
+	 * \param access \ref SPL_FILEIO_ACCESS_NORMAL, \ref SPL_FILEIO_ACCESS_SEQUENTIAL
+	 * or \ref SPL_FILEIO_ACCESS_RANDOM.
+	 * \param offset First byte of the range.
+	 * \param bytes Number of bytes of the range, or \f$ -1 \f$ for the rest of the file.
+	 *
+	 * \return \c true on success and \c false otherwise.
+	 */
+	bool advise(const SPLenum access, const SPLint64 offset = 0, const SPLint64 bytes = -1) throw();
+
+	/*! \brief Starts to read a range of the file in the background!
+	 *
+	 * E.g. the next bricks or slices which will be accessed.
+	 *
+	 * \param offset First byte of the range.
+	 * \param bytes Number of bytes of the range.
+	 *
+	 * \return \c true on success and \c false otherwise.
+	 */
+	bool prefetch(const SPLint64 offset, const SPLint64 bytes) throw();
+
+	/*! \brief Returns whether a file is mapped!
+	 *
+	 * \return \c true if a file is mapped.
+	 */
+	bool isOpen(void) const throw() { return this->data != 0; }
+
+	/*! \brief Returns the mapped file!
+	 *
+	 * \return Pointer to the first byte, or \c 0 if no file is mapped.
+	 */
+	const SPLuint8* getData(void) const throw() { return this->data; }
+
+	/*! \brief Returns the size of the mapped file!
+	 *
+	 * \return Number of bytes.
+	 */
+	SPLint64 getSize(void) const throw() { return this->size; }
+
+private:
+	SPLMappedFile(const SPLMappedFile &);
+	SPLMappedFile& operator = (const SPLMappedFile &);
+
+	bool range(SPLint64 &offset, SPLint64 &bytes) const throw();
+
+	const SPLuint8 *data;	//!< The mapping.
+	SPLint64 size;			//!< Size of the file in bytes.
+#ifdef _WIN32
+	HANDLE file;			//!< The file.
+	HANDLE mapping;			//!< The file mapping object.
+#endif
+};
+
+/************************************************************************************************
+ ** SPLMappedFile class implementation
+ ************************************************************************************************/
+inline SPLMappedFile::SPLMappedFile(void) throw()
+{
+	this->data = 0;
+	this->size = 0;
+#ifdef _WIN32
+	this->file = INVALID_HANDLE_VALUE;
+	this->mapping = 0;
+#endif
+}
+
+inline SPLMappedFile::~SPLMappedFile(void) throw()
+{
+	this->close();
+}
+
+inline bool SPLMappedFile::open(const char *path, const SPLenum access) throw()
+{
+	this->close();
+#ifdef _WIN32
+	const DWORD flags = (access == SPL_FILEIO_ACCESS_SEQUENTIAL) ? FILE_FLAG_SEQUENTIAL_SCAN :
+		((access == SPL_FILEIO_ACCESS_RANDOM) ? FILE_FLAG_RANDOM_ACCESS : FILE_ATTRIBUTE_NORMAL);
+	this->file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, flags, 0);
+	LARGE_INTEGER size;
+	if (this->file == INVALID_HANDLE_VALUE || !GetFileSizeEx(this->file, &size) || size.QuadPart <= 0)
+	{
+		this->close();
+		return false;
+	}
+	this->mapping = CreateFileMappingA(this->file, 0, PAGE_READONLY, 0, 0, 0);
+	this->data = this->mapping ? (const SPLuint8 *)MapViewOfFile(this->mapping, FILE_MAP_READ, 0, 0, 0) : 0;
+	if (this->data == 0)
+	{
+		this->close();
+		return false;
+	}
+	this->size = SPLint64(size.QuadPart);
+	return true;
+#else
+	const int fd = ::open(path, O_RDONLY);
+	if (fd < 0)
+	{
+		return false;
+	}
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size <= 0)
+	{
+		::close(fd);
+		return false;
+	}
+	void *p = mmap(0, size_t(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+	// the mapping keeps the file open
+	::close(fd);
+	if (p == MAP_FAILED)
+	{
+		return false;
+	}
+	this->data = (const SPLuint8 *)p;
+	this->size = SPLint64(st.st_size);
+	this->advise(access);
+	return true;
+#endif
+}
+
+inline void SPLMappedFile::close(void) throw()
+{
+#ifdef _WIN32
+	if (this->data != 0)
+	{
+		UnmapViewOfFile((LPCVOID)this->data);
+	}
+	if (this->mapping != 0)
+	{
+		CloseHandle(this->mapping);
+	}
+	if (this->file != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(this->file);
+	}
+	this->file = INVALID_HANDLE_VALUE;
+	this->mapping = 0;
+#else
+	if (this->data != 0)
+	{
+		munmap((void *)this->data, size_t(this->size));
+	}
+#endif
+	this->data = 0;
+	this->size = 0;
+}
+
+inline bool SPLMappedFile::range(SPLint64 &offset, SPLint64 &bytes) const throw()
+{
+	if (this->data == 0 || offset < 0 || offset >= this->size)
+	{
+		return false;
+	}
+	if (bytes < 0 || bytes > this->size - offset)
+	{
+		bytes = this->size - offset;
+	}
+#ifndef _WIN32
+	// madvise() needs a page aligned address
+	const SPLint64 page = SPLint64(sysconf(_SC_PAGESIZE));
+	bytes += offset % page;
+	offset -= offset % page;
+#endif
+	return bytes > 0;
+}
+
+inline bool SPLMappedFile::advise(const SPLenum access, const SPLint64 offset, const SPLint64 bytes) throw()
+{
+	SPLint64 first = offset, count = bytes;
+	if (!this->range(first, count))
+	{
+		return false;
+	}
+#ifdef _WIN32
+	(void)access;
+	return true;
+#else
+	const int advice = (access == SPL_FILEIO_ACCESS_SEQUENTIAL) ? MADV_SEQUENTIAL :
+		((access == SPL_FILEIO_ACCESS_RANDOM) ? MADV_RANDOM : MADV_NORMAL);
+	return madvise((void *)(this->data + first), size_t(count), advice) == 0;
+#endif
+}
+
+inline bool SPLMappedFile::prefetch(const SPLint64 offset, const SPLint64 bytes) throw()
+{
+	SPLint64 first = offset, count = bytes;
+	if (!this->range(first, count))
+	{
+		return false;
+	}
+#ifdef _WIN32
+#if _WIN32_WINNT >= 0x0602
+	WIN32_MEMORY_RANGE_ENTRY entry;
+	entry.VirtualAddress = (PVOID)(this->data + first);
+	entry.NumberOfBytes = SIZE_T(count);
+	return PrefetchVirtualMemory(GetCurrentProcess(), 1, &entry, 0) != 0;
+#else
+	return true;
+#endif
+#else
+	return madvise((void *)(this->data + first), size_t(count), MADV_WILLNEED) == 0;
+#endif
+}
+
+#endif /* _spl_mappedfile_hh_ */
@@ -0,0 +1,208 @@
+#ifndef _spl_mappedgrid_hh_
+#define _spl_mappedgrid_hh_
+
+#include <string>
+
+#include <spl/typesbase.hh>
+#include <spl/vector3.hh>
+#include <spl/grid.hh>
+#include <spl/mappedfile.hh>
+#include <spl/nifti.hh>
+
+/*! \file mappedgrid.hh
+ * */
+
+/*! \class SPLMappedGrid
+ * \brief A read-only grid onto the voxels of a memory mapped volume file.
+ *
+ * The voxels of a RAW (\ref SPL_FILEIO_RAW_ID) or NIfTI-1
+ * (\ref SPL_FILEIO_NII_ID) file are stored in linear order, i.e. the
+ * mapped file is used as the memory of a linear \ref SPLGrid without
+ * reading or copying it (zero-copy). Opening a volume of several
+ * gigabytes therefore takes about as long as opening a small one, the
+ * voxels are paged in on the first access, and processes which open the
+ * same volume share the page cache. See \ref SPLMappedFile for the
+ * access pattern hints.
+ *
+ * The type \c T must match the data type of the file. Files with another
+ * byte order than the host can only be mapped for 1 byte voxels, and
+ * compressed (.nii.gz) files cannot be mapped at all.
+ *
+ * Example
+ * \code
+ * SPLNIfTIHeader h;
+ * SPLMappedGrid<SPLint16> ct;
+ * if (splReadNIfTIHeader("ct.nii", h) && h.type == SPL_TYPE_INT16 && ct.openNIfTI("ct.nii", SPL_FILEIO_ACCESS_RANDOM))
+ * {
+ *     const SPLGrid<SPLint16> &g = ct.getGrid();
+ *     ...
+ *     // a writable, bricked copy for repeated sampling
+ *     SPLGrid<SPLint16> bricked(g);
+ *     bricked.setLayout(SPL_GRID_BRICKED);
+ * }
+ * \endcode
+ *
+ * \sa SPLGrid SPLMappedFile SPLNIfTIHeader
+ */
+template <class T>
+class SPLMappedGrid
+{
+public:
+	/*! \brief Constructor!
+	 *
+	 * Initializes an empty grid.
+	 */
+	SPLMappedGrid(void) throw();
+
+	/*! \brief Maps a RAW file!
+	 *
+	 * \param path The file.
+	 * \param size Number of voxels along x, y and z.
+	 * \param offset Byte offset of the first voxel, e.g. the size of a header.
+	 * \param access The access pattern hint, see \ref SPLMappedFile::advise.
+	 *
+	 * \return \c true on success and \c false otherwise, e.g. if the file
+	 * is too small.
+	 */
+	bool openRAW(const char *path, const SPLVector3i &size, const SPLint64 offset = 0, const SPLenum access = SPL_FILEIO_ACCESS_NORMAL) throw();
+
+	/*! \brief Maps a NIfTI-1 file!
+	 *
+	 * The dimensions, the spacing and the data type are read from the
+	 * header. For a .hdr/.img pair the path of either file can be given.
+	 *
+	 * \param path The .nii, .hdr or .img file.
+	 * \param access The access pattern hint, see \ref SPLMappedFile::advise.
+	 * \param volume Index of the volume of a 4 dimensional file.
+	 *
+	 * \return \c true on success and \c false otherwise, e.g. if the data
+	 * type differs from \c T.
+	 */
+	bool openNIfTI(const char *path, const SPLenum access = SPL_FILEIO_ACCESS_NORMAL, const SPLindex volume = 0) throw();
+
+	/*! \brief Unmaps the file!
+	 *
+	 * The grid becomes empty.
+	 */
+	void close(void) throw();
+
+	/*! \brief Returns the grid!
+	 *
+	 * \return The grid in the linear layout onto the mapped voxels.
+	 */
+	const SPLGrid<T>& getGrid(void) const throw() { return this->grid; }
+
+	/*! \brief Returns the voxel spacing!
+	 *
+	 * \return The spacing along x, y and z (1 for RAW files).
+	 */
+	const SPLVector3d& getSpacing(void) const throw() { return this->spacing; }
+
+	/*! \brief Returns the file format!
+	 *
+	 * \return \ref SPL_FILEIO_RAW_ID, \ref SPL_FILEIO_NII_ID or
+	 * \ref SPL_FILEIO_MIN if no file is mapped.
+	 */
+	SPLenum getFormat(void) const throw() { return this->format; }
+
+	/*! \brief Returns the mapped file!
+	 *
+	 * E.g. to change the access pattern hint or to prefetch slices.
+	 *
+	 * \return The mapping.
+	 */
+	SPLMappedFile& getFile(void) throw() { return this->file; }
+
+private:
+	bool wrap(const SPLint64 offset, const SPLVector3i &size) throw();
+
+	SPLMappedFile file;		//!< The mapped file.
+	SPLGrid<T> grid;		//!< Grid onto the mapped voxels.
+	SPLVector3d spacing;	//!< Voxel spacing.
+	SPLenum format;			//!< File format.
+};
+
+/************************************************************************************************
+ ** SPLMappedGrid class implementation
+ ************************************************************************************************/
+template <class T>
+SPLMappedGrid<T>::SPLMappedGrid(void) throw()
+{
+	this->spacing = SPLVector3d(1.0, 1.0, 1.0);
+	this->format = SPL_FILEIO_MIN;
+}
+
+template <class T>
+bool SPLMappedGrid<T>::openRAW(const char *path, const SPLVector3i &size, const SPLint64 offset, const SPLenum access) throw()
+{
+	this->close();
+	if (!this->file.open(path, access) || !this->wrap(offset, size))
+	{
+		this->close();
+		return false;
+	}
+	this->format = SPL_FILEIO_RAW_ID;
+	return true;
+}
+
+template <class T>
+bool SPLMappedGrid<T>::openNIfTI(const char *path, const SPLenum access, const SPLindex volume) throw()
+{
+	this->close();
+	// a .hdr/.img pair is opened by the names of both files
+	std::string hdr(path), img(path);
+	const size_t n = hdr.size();
+	if (n > 4 && (hdr.compare(n - 4, 4, ".img") == 0 || hdr.compare(n - 4, 4, ".hdr") == 0))
+	{
+		hdr.replace(n - 4, 4, ".hdr");
+		img.replace(n - 4, 4, ".img");
+	}
+	SPLNIfTIHeader h;
+	if (!splReadNIfTIHeader(hdr.c_str(), h) || h.type != SPLTypeId<T>::value || SPLint32(sizeof(T)) != h.bytes)
+	{
+		return false;
+	}
+	// swapping the bytes would need a copy
+	if ((h.swapped && sizeof(T) > 1) || volume < 0 || volume >= h.volumes)
+	{
+		return false;
+	}
+	const SPLint64 voxels = SPLint64(h.size.x) * h.size.y * h.size.z;
+	const SPLint64 offset = h.offset + SPLint64(volume) * voxels * SPLint64(sizeof(T));
+	if (!this->file.open(h.pair ? img.c_str() : hdr.c_str(), access) || !this->wrap(offset, h.size))
+	{
+		this->close();
+		return false;
+	}
+	this->spacing = h.spacing;
+	this->format = SPL_FILEIO_NII_ID;
+	return true;
+}
+
+template <class T>
+void SPLMappedGrid<T>::close(void) throw()
+{
+	this->grid.resize(SPLVector3i(0, 0, 0));
+	this->file.close();
+	this->spacing = SPLVector3d(1.0, 1.0, 1.0);
+	this->format = SPL_FILEIO_MIN;
+}
+
+template <class T>
+bool SPLMappedGrid<T>::wrap(const SPLint64 offset, const SPLVector3i &size) throw()
+{
+	const SPLint64 bytes = SPLGrid<T>::getStorageSize(size, SPL_GRID_LINEAR, 0) * SPLint64(sizeof(T));
+	if (bytes < 0 || offset < 0 || offset + bytes > this->file.getSize())
+	{
+		return false;
+	}
+	// the mapping is page aligned, the voxels must be aligned to their size
+	const SPLuint8 *p = this->file.getData() + offset;
+	if (SPLuint64(p) % alignof(T) != 0)
+	{
+		return false;
+	}
+	return this->grid.setExternal((T *)p, size, SPL_GRID_LINEAR);
+}
+
+#endif /* _spl_mappedgrid_hh_ */
@@ -0,0 +1,410 @@
+#ifndef _spl_marchingcubes_hh_
+#define _spl_marchingcubes_hh_
+
+#include <vector>
+
+#include <spl/typesbase.hh>
+#include <spl/mathbase.hh>
+#include <spl/threadpool.hh>
+#include <spl/vector3.hh>
+#include <spl/vector3array.hh>
+#include <spl/grid.hh>
+
+/*! \file marchingcubes.hh
+ * */
+
+namespace SPLMarchingCubesDetail
+{
+	/*! \brief The triangles of the 256 cases of a cube!
+	 *
+	 * Corner \f$ c \f$ of a cube is the voxel \f$ (c \& 1, (c \gg 1) \& 1, c \gg 2) \f$,
+	 * edge \f$ 4 a + j \f$ is the edge along axis \f$ a \f$ whose corners
+	 * have the other two coordinates \f$ (j \& 1, j \gg 1) \f$ in the
+	 * order x, y, z. The case is the mask of the corners inside the surface.
+	 *
+	 * Instead of a hand written table, the polygons are traced from the
+	 * segments on the six faces of the cube, where every segment cuts off
+	 * an inside corner region. An ambiguous face (two diagonal inside
+	 * corners) thus separates its inside corners in both cubes sharing it,
+	 * which makes the surface watertight. The polygons are triangulated
+	 * as fans, whose apex avoids chords across an ambiguous face.
+	 */
+	struct Table
+	{
+		SPLuint8 count[256];		//!< Number of triangles of every case.
+		SPLuint8 edges[256][36];	//!< Three edges per triangle of every case.
+
+		Table(void) throw()
+		{
+			// the corners of the faces counterclockwise as seen from outside
+			static const SPLuint8 faces[6][4] = { { 0, 4, 6, 2 }, { 1, 3, 7, 5 }, { 0, 1, 5, 4 },
+												 { 2, 6, 7, 3 }, { 0, 2, 3, 1 }, { 4, 5, 7, 6 } };
+			for (SPLindex c = 0; c < 256; c++)
+			{
+				SPLindex next[12];
+				for (SPLindex e = 0; e < 12; e++)
+				{
+					next[e] = -1;
+				}
+				for (SPLindex f = 0; f < 6; f++)
+				{
+					for (SPLindex k = 0; k < 4; k++)
+					{
+						// an outside to inside crossing is closed by the next inside to outside crossing
+						if (inside(c, faces[f][k]) || !inside(c, faces[f][(k + 1) & 3]))
+						{
+							continue;
+						}
+						SPLindex m = (k + 1) & 3;
+						while (!inside(c, faces[f][m]) || inside(c, faces[f][(m + 1) & 3]))
+						{
+							m = (m + 1) & 3;
+						}
+						next[edge(faces[f][m], faces[f][(m + 1) & 3])] = edge(faces[f][k], faces[f][(k + 1) & 3]);
+					}
+				}
+
+				SPLindex n = 0;
+				for (SPLindex e = 0; e < 12; e++)
+				{
+					if (next[e] < 0)
+					{
+						continue;
+					}
+					SPLindex polygon[12], k = 0, visits[6] = { 0, 0, 0, 0, 0, 0 };
+					for (SPLindex a = e; next[a] >= 0; k++)
+					{
+						polygon[k] = a;
+						visits[face(a, next[a])]++;
+						const SPLindex t = next[a];
+						next[a] = -1;
+						a = t;
+					}
+
+					// a fan from a corner on two faces passed once has no chord across a face shared with another cube
+					SPLindex apex = 0;
+					for (SPLindex i = 0; i < k; i++)
+					{
+						if (visits[face(polygon[i], polygon[(i + 1) % k])] < 2 && visits[face(polygon[i], polygon[(i + k - 1) % k])] < 2)
+						{
+							apex = i;
+							break;
+						}
+					}
+					for (SPLindex i = 1; i + 1 < k; i++)
+					{
+						this->edges[c][3 * n + 0] = SPLuint8(polygon[apex]);
+						this->edges[c][3 * n + 1] = SPLuint8(polygon[(apex + i + 1) % k]);
+						this->edges[c][3 * n + 2] = SPLuint8(polygon[(apex + i) % k]);
+						n++;
+					}
+				}
+				this->count[c] = SPLuint8(n);
+			}
+		}
+
+		static SPLindex face(const SPLindex a, const SPLindex b) throw()
+		{
+			// the faces 2 axis + side of both edges, of which one is shared
+			const SPLindex fa[2] = { faceOf(a, 0), faceOf(a, 1) }, fb[2] = { faceOf(b, 0), faceOf(b, 1) };
+			return (fa[0] == fb[0] || fa[0] == fb[1]) ? fa[0] : fa[1];
+		}
+
+		static SPLindex faceOf(const SPLindex e, const SPLindex i) throw()
+		{
+			const SPLindex a = e >> 2, j = e & 3;
+			const SPLindex axis = (i == 0) ? ((a == 0) ? 1 : 0) : ((a == 2) ? 1 : 2);
+			return 2 * axis + ((i == 0) ? (j & 1) : (j >> 1));
+		}
+
+		static bool inside(const SPLindex c, const SPLindex corner) throw() { return ((c >> corner) & 1) != 0; }
+
+		static SPLindex edge(const SPLindex a, const SPLindex b) throw()
+		{
+			const SPLindex lo = MIN(a, b), axis = ((a ^ b) == 1) ? 0 : (((a ^ b) == 2) ? 1 : 2);
+			const SPLindex j = (axis == 0) ? (lo >> 1) : ((axis == 1) ? ((lo & 1) | ((lo >> 1) & 2)) : (lo & 3));
+			return 4 * axis + j;
+		}
+	};
+
+	/*! \brief Returns the table of the cases!
+	 */
+	inline const Table& getTable(void) throw()
+	{
+		static const Table table;
+		return table;
+	}
+
+	/*! \brief Number of set bits of the three edge bits of a voxel!
+	 */
+	inline SPLindex count(const SPLuint8 mask) throw()
+	{
+		return ((mask >> 1) & 1) + ((mask >> 2) & 1) + ((mask >> 3) & 1);
+	}
+}
+
+/*! \class SPLMarchingCubes
+ * \brief Parallel marching cubes extraction of isosurfaces.
+ *
+ * Extracts the surface \f$ v = iso \f$ of a scalar \ref SPLGrid as a
+ * triangle mesh with shared vertices. Every vertex lies on an edge of
+ * the voxel lattice, is owned by the lower voxel of the edge and is
+ * created exactly once, such that the mesh is watertight inside the
+ * volume. Voxels greater than the isovalue are inside, the triangles are
+ * counterclockwise as seen from outside and the normals point outside
+ * (against the gradient).
+ *
+ * The extraction runs in two passes over slabs of voxels: the first one
+ * classifies the voxels and counts the vertices and triangles of every
+ * row, whose prefix sums give every row its own range of the output
+ * buffers. The second one writes the vertices and triangles of every row
+ * into its range, which merges the vertices without locks.
+ *
+ * The positions are in voxel coordinates, i.e. voxel \f$ (x, y, z) \f$ is
+ * the point \f$ (x, y, z) \f$, see \ref SPLMatrix4::transformPoints.
+ *
+ * Example
+ * \code
+ * SPLMarchingCubes<SPLuint16> mc;
+ * mc.extract(volume, material.getChannel(SPL_MATERIAL_ISOSURFACE, 0.0f));
+ *
+ * const SPLVector3Arrayf &p = mc.getPositions();
+ * const std::vector<SPLuint32> &i = mc.getIndices();	// 3 per triangle
+ * \endcode
+ *
+ * \sa SPLMacroCells SPLVector3Array
+ */
+template <class T>
+class SPLMarchingCubes
+{
+public:
+	/*! \brief Extracts an isosurface!
+	 *
+	 * \param volume The volume.
+	 * \param iso The isovalue.
+	 * \param pool The threads.
+	 *
+	 * \return \c true on success and \c false otherwise.
+	 */
+	bool extract(const SPLGrid<T> &volume, const SPLieee32 iso, SPLThreadPool &pool = SPLThreadPool::getGlobal()) throw();
+
+	/*! \brief Returns the positions of the vertices!
+	 *
+	 * \return One position per vertex in voxel coordinates.
+	 */
+	const SPLVector3Arrayf& getPositions(void) const throw() { return this->positions; }
+
+	/*! \brief Returns the normals of the vertices!
+	 *
+	 * \return One unit normal per vertex.
+	 */
+	const SPLVector3Arrayf& getNormals(void) const throw() { return this->normals; }
+
+	/*! \brief Returns the indices of the triangles!
+	 *
+	 * \return Three vertices per triangle.
+	 */
+	const std::vector<SPLuint32>& getIndices(void) const throw() { return this->indices; }
+
+	/*! \brief Returns the number of vertices!
+	 *
+	 * \return Number of vertices.
+	 */
+	SPLsizei getVertexCount(void) const throw() { return this->positions.size(); }
+
+	/*! \brief Returns the number of triangles!
+	 *
+	 * \return Number of triangles.
+	 */
+	SPLint64 getTriangleCount(void) const throw() { return SPLint64(this->indices.size() / 3); }
+
+private:
+	SPLVector3Arrayf positions;			//!< The positions.
+	SPLVector3Arrayf normals;			//!< The normals.
+	std::vector<SPLuint32> indices;		//!< The triangles.
+};
+
+/************************************************************************************************
+ ** SPLMarchingCubes class implementation
+ ************************************************************************************************/
+template <class T>
+bool SPLMarchingCubes<T>::extract(const SPLGrid<T> &volume, const SPLieee32 iso, SPLThreadPool &pool) throw()
+{
+	const SPLMarchingCubesDetail::Table &table = SPLMarchingCubesDetail::getTable();
+	const SPLVector3i n = volume.getSize();
+	if (n.x <= 0 || n.y <= 0 || n.z <= 0)
+	{
+		return false;
+	}
+	const SPLint64 *ox = volume.getOffsets(0), *oy = volume.getOffsets(1), *oz = volume.getOffsets(2);
+	const T *data = volume.getData();
+	const SPLint64 sy = n.x, sz = SPLint64(n.x) * n.y;
+
+	// bit 0: voxel inside, bits 1 to 3: the edges along x, y and z cross the surface
+	std::vector<SPLuint8> masks(size_t(sz * n.z));
+	std::vector<SPLint64> vertices(size_t(sz / n.x * n.z) + 1, 0), triangles(vertices.size(), 0);
+	pool.parallelFor(0, n.z, 1, [&](const SPLint64 first, const SPLint64 last)
+	{
+		for (SPLindex z = SPLindex(first); z < SPLindex(last); z++)
+		{
+			for (SPLindex y = 0; y < n.y; y++)
+			{
+				SPLuint8 *m = &masks[size_t(z * sz + y * sy)];
+				const SPLint64 o = oy[y] + oz[z];
+				SPLint64 count = 0;
+				for (SPLindex x = 0; x < n.x; x++)
+				{
+					const bool in = SPLieee32(data[ox[x] + o]) > iso;
+					SPLuint8 bits = in ? 1 : 0;
+					if (x + 1 < n.x && (SPLieee32(data[ox[x + 1] + o]) > iso) != in)
+					{
+						bits |= 2;
+					}
+					if (y + 1 < n.y && (SPLieee32(data[ox[x] + oy[y + 1] + oz[z]]) > iso) != in)
+					{
+						bits |= 4;
+					}
+					if (z + 1 < n.z && (SPLieee32(data[ox[x] + oy[y] + oz[z + 1]]) > iso) != in)
+					{
+						bits |= 8;
+					}
+					m[x] = bits;
+					count += SPLMarchingCubesDetail::count(bits);
+				}
+				vertices[size_t(z * n.y + y)] = count;
+			}
+		}
+	});
+
+	pool.parallelFor(0, n.z - 1, 1, [&](const SPLint64 first, const SPLint64 last)
+	{
+		for (SPLindex z = SPLindex(first); z < SPLindex(last); z++)
+		{
+			for (SPLindex y = 0; y + 1 < n.y; y++)
+			{
+				const SPLuint8 *m = &masks[size_t(z * sz + y * sy)];
+				SPLint64 count = 0;
+				for (SPLindex x = 0; x + 1 < n.x; x++)
+				{
+					const SPLindex c = (m[x] & 1) | ((m[x + 1] & 1) << 1) | ((m[x + sy] & 1) << 2) | ((m[x + sy + 1] & 1) << 3) |
+						((m[x + sz] & 1) << 4) | ((m[x + sz + 1] & 1) << 5) | ((m[x + sz + sy] & 1) << 6) | ((m[x + sz + sy + 1] & 1) << 7);
+					count += table.count[c];
+				}
+				triangles[size_t(z * n.y + y)] = count;
+			}
+		}
+	});
+
+	// exclusive prefix sums give the first vertex and triangle of every row
+	SPLint64 nv = 0, nt = 0;
+	for (size_t r = 0; r < vertices.size(); r++)
+	{
+		const SPLint64 v = vertices[r], t = triangles[r];
+		vertices[r] = nv;
+		triangles[r] = nt;
+		nv += v;
+		nt += t;
+	}
+	if (nv > 0x7fffffff || 3 * nt > SPLint64(this->indices.max_size()) ||
+		!this->positions.resize(SPLsizei(nv)) || !this->normals.resize(SPLsizei(nv)))
+	{
+		this->positions.resize(0);
+		this->normals.resize(0);
+		this->indices.clear();
+		return false;
+	}
+	this->indices.resize(size_t(3 * nt));
+
+	// the owner voxel of every cube edge relative to the cube: x offset, row (y + 2 z) and lower edge bits
+	SPLindex edgeX[12], edgeRow[12];
+	SPLuint8 edgeBits[12];
+	for (SPLindex e = 0; e < 12; e++)
+	{
+		const SPLindex a = e >> 2, j = e & 3;
+		edgeX[e] = (a == 0) ? 0 : (j & 1);
+		edgeRow[e] = (a == 0) ? j : ((a == 1) ? (j & 2) : (j >> 1));
+		edgeBits[e] = SPLuint8((2 << a) - 2);
+	}
+
+	SPLVector3Arrayf &p = this->positions, &nrm = this->normals;
+	SPLuint32 *ind = this->indices.empty() ? NULL : &this->indices[0];
+	pool.parallelFor(0, n.z, 1, [&](const SPLint64 first, const SPLint64 last)
+	{
+		const auto value = [&](const SPLindex x, const SPLindex y, const SPLindex z) -> SPLieee32
+		{
+			return SPLieee32(data[ox[x] + oy[y] + oz[z]]);
+		};
+		const auto gradient = [&](const SPLindex x, const SPLindex y, const SPLindex z) -> SPLVector3f
+		{
+			const SPLindex x0 = MAX(x - 1, 0), x1 = MIN(x + 1, n.x - 1), y0 = MAX(y - 1, 0), y1 = MIN(y + 1, n.y - 1);
+			const SPLindex z0 = MAX(z - 1, 0), z1 = MIN(z + 1, n.z - 1);
+			return SPLVector3f((value(x1, y, z) - value(x0, y, z)) / SPLieee32(MAX(x1 - x0, 1)),
+							   (value(x, y1, z) - value(x, y0, z)) / SPLieee32(MAX(y1 - y0, 1)),
+							   (value(x, y, z1) - value(x, y, z0)) / SPLieee32(MAX(z1 - z0, 1)));
+		};
+
+		for (SPLindex z = SPLindex(first); z < SPLindex(last); z++)
+		{
+			for (SPLindex y = 0; y < n.y; y++)
+			{
+				// the vertices of a row
+				const SPLuint8 *m = &masks[size_t(z * sz + y * sy)];
+				SPLint64 id = vertices[size_t(z * n.y + y)];
+				for (SPLindex x = 0; x < n.x; x++)
+				{
+					if (m[x] <= 1)
+					{
+						continue;
+					}
+					const SPLieee32 v0 = value(x, y, z);
+					const SPLVector3f g0 = gradient(x, y, z);
+					for (SPLindex a = 0; a < 3; a++)
+					{
+						if (!(m[x] & (2 << a)))
+						{
+							continue;
+						}
+						const SPLindex x1 = x + (a == 0), y1 = y + (a == 1), z1 = z + (a == 2);
+						const SPLieee32 t = (iso - v0) / (value(x1, y1, z1) - v0);
+						SPLVector3f q = SPLVector3f(SPLieee32(x), SPLieee32(y), SPLieee32(z));
+						q[a] += t;
+						const SPLVector3f g1 = gradient(x1, y1, z1);
+						p.set(SPLindex(id), q);
+						nrm.set(SPLindex(id), -(g0 + (g1 - g0) * t).getNormalized(1.0f));
+						id++;
+					}
+				}
+
+				// the triangles of the cubes between this row and the next rows
+				if (y + 1 >= n.y || z + 1 >= n.z)
+				{
+					continue;
+				}
+				const SPLuint8 *r[4] = { m, m + sy, m + sz, m + sz + sy };
+				SPLint64 base[4] = { vertices[size_t(z * n.y + y)], vertices[size_t(z * n.y + y + 1)],
+									 vertices[size_t((z + 1) * n.y + y)], vertices[size_t((z + 1) * n.y + y + 1)] };
+				SPLuint32 *out = ind + 3 * triangles[size_t(z * n.y + y)];
+				for (SPLindex x = 0; x + 1 < n.x; x++)
+				{
+					const SPLindex c = (r[0][x] & 1) | ((r[0][x + 1] & 1) << 1) | ((r[1][x] & 1) << 2) | ((r[1][x + 1] & 1) << 3) |
+						((r[2][x] & 1) << 4) | ((r[2][x + 1] & 1) << 5) | ((r[3][x] & 1) << 6) | ((r[3][x + 1] & 1) << 7);
+					const SPLint64 next[4] = { base[0] + SPLMarchingCubesDetail::count(r[0][x]), base[1] + SPLMarchingCubesDetail::count(r[1][x]),
+											   base[2] + SPLMarchingCubesDetail::count(r[2][x]), base[3] + SPLMarchingCubesDetail::count(r[3][x]) };
+					for (SPLindex i = 0; i < 3 * table.count[c]; i++)
+					{
+						const SPLindex e = table.edges[c][i], j = edgeRow[e];
+						const SPLuint8 owner = r[j][x + edgeX[e]];
+						*out++ = SPLuint32((edgeX[e] ? next[j] : base[j]) + SPLMarchingCubesDetail::count(owner & edgeBits[e]));
+					}
+					for (SPLindex j = 0; j < 4; j++)
+					{
+						base[j] = next[j];
+					}
+				}
+			}
+		}
+	});
+	return true;
+}
+
+#endif /* _spl_marchingcubes_hh_ */
@@ -0,0 +1,231 @@
+#ifndef _spl_material_hh_
+#define _spl_material_hh_
+
+#include <spl/typesbase.hh>
+#include <spl/mathbase.hh>
+#include <spl/vector3.hh>
+
+/*! \file material.hh
+ * */
+
+/*! \class SPLMaterial
+ * \brief The optical properties of a volume as functions of the voxel value.
+ *
+ * A material has one channel per \c SPL_MATERIAL_* identification number,
+ * e.g. \ref SPL_MATERIAL_OPACITY or \ref SPL_MATERIAL_DIFFUSE_RED. Every
+ * channel is a polynomial of the normalized voxel value
+ * \f$ s = (v - v_{lo}) / (v_{hi} - v_{lo}) \f$, see \ref setRange, whose
+ * degree is given by the approximation:
+ *
+ * - \ref SPL_MATERIAL_APPROX_CONSTANT: \f$ c_0 \f$
+ * - \ref SPL_MATERIAL_APPROX_LINEAR: \f$ c_0 + c_1 s \f$
+ * - \ref SPL_MATERIAL_APPROX_QUADRATIC: \f$ c_0 + c_1 s + c_2 s^2 \f$
+ *
+ * The opacity is the opacity of a segment of one voxel length and is
+ * clamped to \f$ [0, 1] \f$. The default material is a linear opacity
+ * ramp with a white emission, i.e. an unshaded emission-absorption model.
+ *
+ * Example
+ * \code
+ * SPLMaterial m;
+ * m.setRange(100.0f, 3000.0f);
+ * m.setChannel(SPL_MATERIAL_OPACITY, SPL_MATERIAL_APPROX_QUADRATIC, 0.0f, 0.0f, 0.5f);
+ * m.setChannel(SPL_MATERIAL_DIFFUSE_RED, 0.8f);
+ * ...
+ * \endcode
+ *
+ * \sa SPLLight SPLRayCaster
+ */
+class SPLMaterial
+{
+public:
+	/*! \brief Constructor!
+	 *
+	 * Initializes the opacity \f$ s \f$, the emission \f$ 1 \f$, the
+	 * shininess \f$ 32 \f$, all other channels \f$ 0 \f$ and the range \f$ [0, 1] \f$.
+	 */
+	SPLMaterial(void) throw();
+
+	/*! \brief Sets a channel!
+	 *
+	 * \param channel A \c SPL_MATERIAL_* identification number.
+	 * \param approx A \c SPL_MATERIAL_APPROX_* identification number.
+	 * \param c0 Constant coefficient.
+	 * \param c1 Linear coefficient.
+	 * \param c2 Quadratic coefficient.
+	 */
+	void setChannel(const SPLenum channel, const SPLenum approx, const SPLieee32 c0, const SPLieee32 c1 = 0.0f, const SPLieee32 c2 = 0.0f) throw();
+
+	/*! \brief Sets a constant channel!
+	 *
+	 * \param channel A \c SPL_MATERIAL_* identification number.
+	 * \param c The value.
+	 */
+	void setChannel(const SPLenum channel, const SPLieee32 c) throw() { this->setChannel(channel, SPL_MATERIAL_APPROX_CONSTANT, c); }
+
+	/*! \brief Returns the approximation of a channel!
+	 *
+	 * \param channel A \c SPL_MATERIAL_* identification number.
+	 *
+	 * \return A \c SPL_MATERIAL_APPROX_* identification number.
+	 */
+	SPLenum getApproximation(const SPLenum channel) const throw();
+
+	/*! \brief Returns the coefficients of a channel!
+	 *
+	 * \param channel A \c SPL_MATERIAL_* identification number.
+	 *
+	 * \return The constant, linear and quadratic coefficient (zero if unused).
+	 */
+	const SPLieee32* getCoefficients(const SPLenum channel) const throw();
+
+	/*! \brief Returns a channel!
+	 *
+	 * \param channel A \c SPL_MATERIAL_* identification number.
+	 * \param s The normalized voxel value, see \ref getNormalized.
+	 *
+	 * \return The value of the channel.
+	 */
+	SPLieee32 getChannel(const SPLenum channel, const SPLieee32 s) const throw();
+
+	/*! \brief Returns the maximum opacity in a range!
+	 *
+	 * \param s0 The lower normalized voxel value.
+	 * \param s1 The upper normalized voxel value.
+	 *
+	 * \return The maximum of the opacity channel in \f$ [s_0, s_1] \f$.
+	 */
+	SPLieee32 getMaxOpacity(const SPLieee32 s0, const SPLieee32 s1) const throw();
+
+	/*! \brief Returns the emission!
+	 *
+	 * \param s The normalized voxel value.
+	 *
+	 * \return The red, green and blue emission.
+	 */
+	SPLVector3f getEmission(const SPLieee32 s) const throw();
+
+	/*! \brief Sets the range of the voxel values!
+	 *
+	 * \param lo The value which is normalized to \f$ 0 \f$.
+	 * \param hi The value which is normalized to \f$ 1 \f$ (different from \c lo).
+	 */
+	void setRange(const SPLieee32 lo, const SPLieee32 hi) throw();
+
+	/*! \brief Returns the normalized voxel value!
+	 *
+	 * \param v A voxel value.
+	 *
+	 * \return \f$ s \f$, clamped to \f$ [0, 1] \f$.
+	 */
+	SPLieee32 getNormalized(const SPLieee32 v) const throw() { return CLAMP((v - this->lo) * this->scale, 0.0f, 1.0f); }
+
+	/*! \brief Returns whether the material reflects light!
+	 *
+	 * \return \c true if an ambient, diffuse or specular channel is not zero.
+	 */
+	bool isShaded(void) const throw();
+
+private:
+	static const SPLindex CHANNELS = SPL_MATERIAL_MAX - SPL_MATERIAL_MIN - 1;
+
+	SPLenum approx[CHANNELS];		//!< The approximation of every channel.
+	SPLieee32 c[CHANNELS][3];		//!< The coefficients of every channel.
+	SPLieee32 lo;					//!< Voxel value of \f$ s = 0 \f$.
+	SPLieee32 scale;				//!< \f$ 1 / (v_{hi} - v_{lo}) \f$.
+};
+
+/************************************************************************************************
+ ** SPLMaterial class implementation
+ ************************************************************************************************/
+inline SPLMaterial::SPLMaterial(void) throw()
+{
+	for (SPLenum ch = SPL_MATERIAL_MIN + 1; ch < SPL_MATERIAL_MAX; ch++)
+	{
+		this->setChannel(ch, 0.0f);
+	}
+	this->setChannel(SPL_MATERIAL_OPACITY, SPL_MATERIAL_APPROX_LINEAR, 0.0f, 1.0f);
+	this->setChannel(SPL_MATERIAL_EMISSION_RED, 1.0f);
+	this->setChannel(SPL_MATERIAL_EMISSION_GREEN, 1.0f);
+	this->setChannel(SPL_MATERIAL_EMISSION_BLUE, 1.0f);
+	this->setChannel(SPL_MATERIAL_SHININESS, 32.0f);
+	this->setRange(0.0f, 1.0f);
+}
+
+inline void SPLMaterial::setChannel(const SPLenum channel, const SPLenum approx, const SPLieee32 c0, const SPLieee32 c1, const SPLieee32 c2) throw()
+{
+	assert(channel > SPL_MATERIAL_MIN && channel < SPL_MATERIAL_MAX);
+	assert(approx > SPL_MATERIAL_APPROX_MIN && approx < SPL_MATERIAL_APPROX_MAX);
+	const SPLindex i = channel - SPL_MATERIAL_MIN - 1;
+	this->approx[i] = approx;
+	this->c[i][0] = c0;
+	this->c[i][1] = (approx == SPL_MATERIAL_APPROX_CONSTANT) ? 0.0f : c1;
+	this->c[i][2] = (approx == SPL_MATERIAL_APPROX_QUADRATIC) ? c2 : 0.0f;
+}
+
+inline SPLenum SPLMaterial::getApproximation(const SPLenum channel) const throw()
+{
+	assert(channel > SPL_MATERIAL_MIN && channel < SPL_MATERIAL_MAX);
+	return this->approx[channel - SPL_MATERIAL_MIN - 1];
+}
+
+inline const SPLieee32* SPLMaterial::getCoefficients(const SPLenum channel) const throw()
+{
+	assert(channel > SPL_MATERIAL_MIN && channel < SPL_MATERIAL_MAX);
+	return this->c[channel - SPL_MATERIAL_MIN - 1];
+}
+
+inline SPLieee32 SPLMaterial::getChannel(const SPLenum channel, const SPLieee32 s) const throw()
+{
+	assert(channel > SPL_MATERIAL_MIN && channel < SPL_MATERIAL_MAX);
+	// the unused coefficients are zero, i.e. all approximations are evaluated alike
+	const SPLieee32 *k = this->c[channel - SPL_MATERIAL_MIN - 1];
+	const SPLieee32 v = k[0] + s * (k[1] + s * k[2]);
+	return (channel == SPL_MATERIAL_OPACITY) ? CLAMP(v, 0.0f, 1.0f) : v;
+}
+
+inline SPLieee32 SPLMaterial::getMaxOpacity(const SPLieee32 s0, const SPLieee32 s1) const throw()
+{
+	assert(s0 <= s1);
+	SPLieee32 ret = MAX(this->getChannel(SPL_MATERIAL_OPACITY, s0), this->getChannel(SPL_MATERIAL_OPACITY, s1));
+
+	// the vertex of a concave parabola
+	const SPLieee32 *k = this->c[SPL_MATERIAL_OPACITY - SPL_MATERIAL_MIN - 1];
+	if (k[2] < 0.0f)
+	{
+		const SPLieee32 s = -k[1] / (2.0f * k[2]);
+		if (s > s0 && s < s1)
+		{
+			ret = MAX(ret, this->getChannel(SPL_MATERIAL_OPACITY, s));
+		}
+	}
+	return ret;
+}
+
+inline SPLVector3f SPLMaterial::getEmission(const SPLieee32 s) const throw()
+{
+	return SPLVector3f(this->getChannel(SPL_MATERIAL_EMISSION_RED, s), this->getChannel(SPL_MATERIAL_EMISSION_GREEN, s),
+					   this->getChannel(SPL_MATERIAL_EMISSION_BLUE, s));
+}
+
+inline void SPLMaterial::setRange(const SPLieee32 lo, const SPLieee32 hi) throw()
+{
+	assert(hi != lo);
+	this->lo = lo;
+	this->scale = 1.0f / (hi - lo);
+}
+
+inline bool SPLMaterial::isShaded(void) const throw()
+{
+	for (SPLenum ch = SPL_MATERIAL_AMBIENT_RED; ch <= SPL_MATERIAL_SPECULAR_BLUE; ch++)
+	{
+		const SPLieee32 *k = this->c[ch - SPL_MATERIAL_MIN - 1];
+		if (k[0] != 0.0f || k[1] != 0.0f || k[2] != 0.0f)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+#endif /* _spl_material_hh_ */
@@ -0,0 +1,275 @@
+#ifndef _spl_materialtable_hh_
+#define _spl_materialtable_hh_
+
+#include <cmath>
+#include <vector>
+
+#include <spl/typesbase.hh>
+#include <spl/mathbase.hh>
+#include <spl/threadpool.hh>
+#include <spl/vector3.hh>
+#include <spl/vector4.hh>
+#include <spl/material.hh>
+
+/*! \file materialtable.hh
+ * */
+
+/*! \class SPLMaterialTable
+ * \brief Lookup tables of a material.
+ *
+ * Compiles the channel polynomials of a \ref SPLMaterial into dense
+ * tables of \f$ N \f$ entries at the normalized voxel values
+ * \f$ s_i = i / (N - 1) \f$, such that a sampler replaces the evaluation
+ * of all channels by one gather:
+ *
+ * - one table per channel, see \ref getChannel,
+ * - the premultiplied RGBA \f$ (\alpha c, \alpha) \f$ of one ray step
+ *   with the opacity corrected to the step size, see \ref getSample,
+ * - optionally the pre-integrated RGBA of a ray segment between a front
+ *   and a back value, see \ref getSegment. The opacity integrates the
+ *   extinction \f$ \tau = -\ln(1 - \alpha) \f$ along a linear change of
+ *   the value and the color is the extinction weighted mean emission.
+ *
+ * \ref update compares the material with the one of the last update and
+ * rebuilds the tables of the changed channels only. The step and segment
+ * tables are rebuilt if the opacity, the emission or the step changed.
+ *
+ * Example
+ * \code
+ * SPLMaterialTable t;
+ * t.update(material, 0.5f);
+ * ...
+ * const SPLVector4f &rgba = t.getSample(t.getIndex(v));
+ * \endcode
+ *
+ * \sa SPLMaterial SPLRayCaster SPLMacroCells
+ */
+class SPLMaterialTable
+{
+public:
+	/*! \brief Constructor!
+	 *
+	 * \param size Number of entries \f$ N \geq 2 \f$ per table.
+	 */
+	explicit SPLMaterialTable(const SPLsizei size = 256) throw();
+
+	/*! \brief Updates the tables to a material!
+	 *
+	 * \param material The material.
+	 * \param step Length of a ray step in voxels.
+	 * \param preintegrated Whether to build the pre-integrated table.
+	 * \param pool The threads.
+	 *
+	 * \return Number of rebuilt channel tables.
+	 */
+	SPLsizei update(const SPLMaterial &material, const SPLieee32 step = 1.0f, const bool preintegrated = false,
+					SPLThreadPool &pool = SPLThreadPool::getGlobal()) throw();
+
+	/*! \brief Returns the number of entries per table!
+	 *
+	 * \return \f$ N \f$.
+	 */
+	SPLsizei getSize(void) const throw() { return this->size; }
+
+	/*! \brief Returns the material of the last update!
+	 *
+	 * \return The material.
+	 */
+	const SPLMaterial& getMaterial(void) const throw() { return this->material; }
+
+	/*! \brief Returns the step of the last update!
+	 *
+	 * \return Length of a ray step in voxels.
+	 */
+	SPLieee32 getStepSize(void) const throw() { return this->step; }
+
+	/*! \brief Returns whether the pre-integrated table exists!
+	 *
+	 * \return \c true if \ref getSegment may be used.
+	 */
+	bool isPreIntegrated(void) const throw() { return !this->segments.empty(); }
+
+	/*! \brief Returns the entry of a voxel value!
+	 *
+	 * \param v A voxel value.
+	 *
+	 * \return The nearest entry of the normalized value.
+	 */
+	SPLindex getIndex(const SPLieee32 v) const throw() { return SPLindex(this->material.getNormalized(v) * this->last + 0.5f); }
+
+	/*! \brief Returns the table of a channel!
+	 *
+	 * \param channel A \c SPL_MATERIAL_* identification number.
+	 *
+	 * \return \f$ N \f$ values of the channel.
+	 */
+	const SPLieee32* getChannel(const SPLenum channel) const throw();
+
+	/*! \brief Returns the premultiplied RGBA of a ray step!
+	 *
+	 * \param i An entry.
+	 *
+	 * \return Emission times opacity and the opacity corrected to the step.
+	 */
+	const SPLVector4f& getSample(const SPLindex i) const throw() { assert(i >= 0 && i < this->size); return this->samples[i]; }
+
+	/*! \brief Returns the pre-integrated premultiplied RGBA of a ray segment!
+	 *
+	 * \param front The entry at the start of the segment.
+	 * \param back The entry at the end of the segment.
+	 *
+	 * \return Emission times opacity and the opacity of the segment.
+	 */
+	const SPLVector4f& getSegment(const SPLindex front, const SPLindex back) const throw();
+
+	/*! \brief Returns whether a range of entries has a positive opacity!
+	 *
+	 * \param first The first entry.
+	 * \param last The last entry (inclusive).
+	 *
+	 * \return \c true if one of the entries is not transparent.
+	 */
+	bool isVisible(const SPLindex first, const SPLindex last) const throw();
+
+private:
+	static const SPLindex CHANNELS = SPL_MATERIAL_MAX - SPL_MATERIAL_MIN - 1;
+
+	/*! \brief Builds the step, visibility and segment tables!
+	 */
+	void buildSamples(const bool preintegrated, SPLThreadPool &pool) throw();
+
+	SPLsizei size;						//!< Entries per table.
+	SPLieee32 last;						//!< \f$ N - 1 \f$.
+	SPLieee32 step;						//!< Step of the last update.
+	bool valid;							//!< Whether the tables belong to the material.
+	SPLMaterial material;				//!< Material of the last update.
+	std::vector<SPLieee32> channels;	//!< The channel tables, one after another.
+	std::vector<SPLVector4f> samples;	//!< RGBA of a step.
+	std::vector<SPLint32> visible;		//!< Number of non-transparent entries before every entry.
+	std::vector<SPLVector4f> segments;	//!< RGBA of a segment, front major.
+};
+
+/************************************************************************************************
+ ** SPLMaterialTable class implementation
+ ************************************************************************************************/
+inline SPLMaterialTable::SPLMaterialTable(const SPLsizei size) throw()
+{
+	assert(size >= 2);
+	this->size = size;
+	this->last = SPLieee32(size - 1);
+	this->step = 1.0f;
+	this->valid = false;
+	this->channels.resize(size_t(CHANNELS) * size);
+	this->samples.resize(size_t(size));
+	this->visible.resize(size_t(size) + 1);
+}
+
+inline SPLsizei SPLMaterialTable::update(const SPLMaterial &material, const SPLieee32 step, const bool preintegrated, SPLThreadPool &pool) throw()
+{
+	assert(step > 0.0f);
+	SPLsizei rebuilt = 0;
+	bool samples = !this->valid || step != this->step || preintegrated != this->isPreIntegrated();
+	for (SPLenum ch = SPL_MATERIAL_MIN + 1; ch < SPL_MATERIAL_MAX; ch++)
+	{
+		const SPLieee32 *a = material.getCoefficients(ch), *b = this->material.getCoefficients(ch);
+		if (this->valid && a[0] == b[0] && a[1] == b[1] && a[2] == b[2])
+		{
+			continue;
+		}
+		SPLieee32 *t = &this->channels[size_t(ch - SPL_MATERIAL_MIN - 1) * this->size];
+		for (SPLindex i = 0; i < this->size; i++)
+		{
+			t[i] = material.getChannel(ch, SPLieee32(i) / this->last);
+		}
+		samples = samples || ch <= SPL_MATERIAL_EMISSION_BLUE;
+		rebuilt++;
+	}
+	this->material = material;
+	this->step = step;
+	this->valid = true;
+	if (samples)
+	{
+		this->buildSamples(preintegrated, pool);
+	}
+	return rebuilt;
+}
+
+inline const SPLieee32* SPLMaterialTable::getChannel(const SPLenum channel) const throw()
+{
+	assert(channel > SPL_MATERIAL_MIN && channel < SPL_MATERIAL_MAX);
+	return &this->channels[size_t(channel - SPL_MATERIAL_MIN - 1) * this->size];
+}
+
+inline const SPLVector4f& SPLMaterialTable::getSegment(const SPLindex front, const SPLindex back) const throw()
+{
+	assert(this->isPreIntegrated());
+	assert(front >= 0 && front < this->size && back >= 0 && back < this->size);
+	return this->segments[size_t(front) * this->size + back];
+}
+
+inline bool SPLMaterialTable::isVisible(const SPLindex first, const SPLindex last) const throw()
+{
+	assert(first >= 0 && first <= last && last < this->size);
+	return this->visible[size_t(last) + 1] > this->visible[size_t(first)];
+}
+
+inline void SPLMaterialTable::buildSamples(const bool preintegrated, SPLThreadPool &pool) throw()
+{
+	const SPLieee32 *alpha = this->getChannel(SPL_MATERIAL_OPACITY), *r = this->getChannel(SPL_MATERIAL_EMISSION_RED);
+	const SPLieee32 *g = this->getChannel(SPL_MATERIAL_EMISSION_GREEN), *b = this->getChannel(SPL_MATERIAL_EMISSION_BLUE);
+	const SPLsizei n = this->size;
+
+	// the extinction and its integrals over s with the trapezoidal rule
+	std::vector<SPLieee64> tau(size_t(n), 0.0), T(size_t(n), 0.0);
+	std::vector<SPLVector3d> K(size_t(n), SPLVector3d(0.0, 0.0, 0.0));
+	this->visible[0] = 0;
+	for (SPLindex i = 0; i < n; i++)
+	{
+		const SPLieee32 a = (this->step == 1.0f) ? alpha[i] : 1.0f - std::pow(1.0f - alpha[i], this->step);
+		this->samples[i] = SPLVector4f(a * r[i], a * g[i], a * b[i], a);
+		this->visible[size_t(i) + 1] = this->visible[size_t(i)] + ((alpha[i] > 0.0f) ? 1 : 0);
+		tau[i] = -std::log(1.0 - MIN(SPLieee64(alpha[i]), 1.0 - 1.0e-6));
+		if (i > 0)
+		{
+			const SPLieee64 h = 0.5 / SPLieee64(n - 1);
+			T[i] = T[i - 1] + h * (tau[i - 1] + tau[i]);
+			K[i] = K[i - 1] + SPLVector3d(tau[i - 1] * r[i - 1] + tau[i] * r[i], tau[i - 1] * g[i - 1] + tau[i] * g[i],
+										  tau[i - 1] * b[i - 1] + tau[i] * b[i]) * h;
+		}
+	}
+
+	if (!preintegrated)
+	{
+		this->segments.clear();
+		return;
+	}
+	this->segments.resize(size_t(n) * n);
+	const SPLieee64 d = this->step;
+	pool.parallelFor(0, n, 16, [&](const SPLint64 first, const SPLint64 last)
+	{
+		for (SPLindex f = SPLindex(first); f < SPLindex(last); f++)
+		{
+			for (SPLindex k = 0; k < n; k++)
+			{
+				const SPLieee64 ds = SPLieee64(k - f) / SPLieee64(n - 1);
+				const SPLieee64 dt = T[k] - T[f];
+				SPLieee64 a;
+				SPLVector3d c;
+				if (f == k || std::fabs(dt) < 1.0e-12)
+				{
+					// a constant value or no extinction
+					a = 1.0 - std::exp(-d * ((f == k) ? tau[f] : 0.0));
+					c = SPLVector3d(0.5 * (r[f] + r[k]), 0.5 * (g[f] + g[k]), 0.5 * (b[f] + b[k]));
+				}
+				else
+				{
+					a = 1.0 - std::exp(-d * dt / ds);
+					c = (K[k] - K[f]) / dt;
+				}
+				this->segments[size_t(f) * n + k] = SPLVector4f(SPLieee32(a * c.x), SPLieee32(a * c.y), SPLieee32(a * c.z), SPLieee32(a));
+			}
+		}
+	});
+}
+
+#endif /* _spl_materialtable_hh_ */
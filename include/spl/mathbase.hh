@@ -0,0 +1,29 @@
+#ifndef _spl_mathbase_hh_
+#define _spl_mathbase_hh_
+
+#include <cmath>
+
+#include <spl/typesbase.hh>
+
+/*! \file mathbase.hh
+ * \brief Basic mathematical constants and macros.
+ *
+ * The macros are used throughout the library, e.g. by \ref SPLVector3,
+ * and map onto the standard math functions such that they can be used
+ * on the host and on the device.
+ * */
+
+#define EPS				1.0e-5	//!< Tolerance for floating point comparisons.
+#define PI				3.14159265358979323846	//!< The constant \f$ \pi \f$.
+
+#define POW2(x)			((x)*(x))	//!< Square of \c x.
+#define SQRT(x)			sqrt(x)		//!< Square root of \c x.
+#define FLOOR(x)		floor(x)	//!< Largest integral value not greater than \c x.
+#define CEIL(x)			ceil(x)		//!< Smallest integral value not less than \c x.
+#define RINT(x)			rint(x)		//!< Nearest integral value of \c x.
+#define ABS(x)			(((x) < 0) ? -(x) : (x))	//!< Absolute value of \c x.
+#define MIN(a, b)		(((a) < (b)) ? (a) : (b))	//!< Minimum of \c a and \c b.
+#define MAX(a, b)		(((a) > (b)) ? (a) : (b))	//!< Maximum of \c a and \c b.
+#define CLAMP(x, a, b)	MIN(MAX((x), (a)), (b))		//!< Clamps \c x to the range \f$ [a, b] \f$.
+
+#endif /* _spl_mathbase_hh_ */
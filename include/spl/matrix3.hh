@@ -0,0 +1,371 @@
+#ifndef _spl_matrix3_hh_
+#define _spl_matrix3_hh_
+
+#ifdef __DEBUG__
+#include <cstdio>
+#endif
+
+#include <spl/typesbase.hh>
+#include <spl/mathbase.hh>
+#include <spl/cudadefs.hh>
+#include <spl/vector3.hh>
+
+template <class T> class SPLMatrix3;
+
+typedef SPLMatrix3<SPLieee32> SPLMatrix3f;	//!< Matrix type with SPLieee32 (32bit) resolution for each element!
+typedef SPLMatrix3<SPLieee64> SPLMatrix3d;	//!< Matrix type with SPLieee64 (64bit) resolution for each element!
+
+/*! \file matrix3.hh
+ * */
+
+/*! \class SPLMatrix3
+ * \brief A \f$ 3 \times 3 \f$ matrix class.
+ *
+ * The matrix is stored column by column (column-major like OpenGL), i.e.
+ * the columns are the vectors \c x, \c y and \c z and the element in row
+ * \f$ r \f$ and column \f$ c \f$ is \c M[c][r] or \c M(r, c):
+ * \f[
+ * {\bf M} =
+ * \left(
+ * \begin{array}{rrr}
+ * {\bf M}.x.x & {\bf M}.y.x & {\bf M}.z.x \\
+ * {\bf M}.x.y & {\bf M}.y.y & {\bf M}.z.y \\
+ * {\bf M}.x.z & {\bf M}.y.z & {\bf M}.z.z
+ * \end{array}
+ * \right)
+ * \f]
+ * It is used for rotations, scalings and the transformation of normals,
+ * see \ref SPLMatrix4::getNormalMatrix.
+ *
+ * \sa SPLMatrix4 SPLVector3
+*/
+template <class T>
+class SPLMatrix3
+{
+public:
+	/*! \brief Constructor!
+	 *
+	 * Initializes the matrix to the identity.
+	 */
+	CUDA_CALLABLE_MEMBER SPLMatrix3(void) throw();
+
+	/*! \brief Constructor!
+	 *
+	 * Initializes the matrix with its columns.
+	 *
+	 * \param x 1st column.
+	 * \param y 2nd column.
+	 * \param z 3rd column.
+	 */
+	CUDA_CALLABLE_MEMBER SPLMatrix3(const SPLVector3<T> &x, const SPLVector3<T> &y, const SPLVector3<T> &z) throw();
+
+	/*! \brief Constructor!
+	 *
+	 * Initializes the matrix with its elements given row by row, i.e. in
+	 * the order they are written down.
+	 *
+	 * Example
+	 * \code
+	 * SPLMatrix3f M(1.0f, 0.0f, 0.0f,
+	 *               0.0f, 0.0f, -1.0f,
+	 *               0.0f, 1.0f, 0.0f); // rotation about x by 90 degrees
+	 *
+	 * \endcode
+	 */
+	CUDA_CALLABLE_MEMBER SPLMatrix3(const T m00, const T m01, const T m02,
+									const T m10, const T m11, const T m12,
+									const T m20, const T m21, const T m22) throw();
+
+	/*! \brief Comparison operator!
+	 *
+	 * \param m Another matrix.
+	 *
+	 * \return \c true if all elements are equal and \c false ontherwise.
+	 */
+	CUDA_CALLABLE_MEMBER bool operator == (const SPLMatrix3<T> &m) const throw();
+
+	/*! \brief Comparison operator!
+	 *
+	 * \param m Another matrix.
+	 *
+	 * \return \c true if any element differs and \c false ontherwise.
+	 */
+	CUDA_CALLABLE_MEMBER bool operator != (const SPLMatrix3<T> &m) const throw();
+
+	/*! \brief Access operator!
+	 *
+	 * \param c Index of the column \f$ [0, 2] \f$.
+	 *
+	 * \return Reference of the column.
+	 */
+	CUDA_CALLABLE_MEMBER SPLVector3<T>& operator [] (const SPLindex c) throw();
+
+	/*! \brief Access operator!
+	 *
+	 * \param c Index of the column \f$ [0, 2] \f$.
+	 *
+	 * \return Reference of the column.
+	 */
+	CUDA_CALLABLE_MEMBER const SPLVector3<T>& operator [] (const SPLindex c) const throw();
+
+	/*! \brief Access operator!
+	 *
+	 * \param r Index of the row \f$ [0, 2] \f$.
+	 * \param c Index of the column \f$ [0, 2] \f$.
+	 *
+	 * \return Reference of the element \f$ {\bf M}_{rc} \f$.
+	 */
+	CUDA_CALLABLE_MEMBER T& operator () (const SPLindex r, const SPLindex c) throw();
+
+	/*! \brief Access operator!
+	 *
+	 * \param r Index of the row \f$ [0, 2] \f$.
+	 * \param c Index of the column \f$ [0, 2] \f$.
+	 *
+	 * \return Reference of the element \f$ {\bf M}_{rc} \f$.
+	 */
+	CUDA_CALLABLE_MEMBER const T& operator () (const SPLindex r, const SPLindex c) const throw();
+
+	/*! \brief Multiplication operator!
+	 *
+	 * \param m Another matrix.
+	 *
+	 * \return New matrix \f$ {\bf M} * {\bf m} \f$.
+	 */
+	CUDA_CALLABLE_MEMBER SPLMatrix3<T> operator * (const SPLMatrix3<T> &m) const throw();
+
+	/*! \brief Multiplication operator!
+	 *
+	 * \param v A vector.
+	 *
+	 * \return New vector \f$ {\bf M} * {\bf v} \f$.
+	 */
+	CUDA_CALLABLE_MEMBER SPLVector3<T> operator * (const SPLVector3<T> &v) const throw();
+
+	/*! \brief Multiplication operator!
+	 *
+	 * \param s A scalar value.
+	 *
+	 * \return New matrix \f$ s * {\bf M} \f$.
+	 */
+	CUDA_CALLABLE_MEMBER SPLMatrix3<T> operator * (const T s) const throw();
+
+	/*! \brief Addition operator!
+	 *
+	 * \param m Another matrix.
+	 *
+	 * \return New matrix \f$ {\bf M} + {\bf m} \f$.
+	 */
+	CUDA_CALLABLE_MEMBER SPLMatrix3<T> operator + (const SPLMatrix3<T> &m) const throw();
+
+	/*! \brief Subtraction operator!
+	 *
+	 * \param m Another matrix.
+	 *
+	 * \return New matrix \f$ {\bf M} - {\bf m} \f$.
+	 */
+	CUDA_CALLABLE_MEMBER SPLMatrix3<T> operator - (const SPLMatrix3<T> &m) const throw();
+
+	/*! \brief Returns the determinant!
+	 *
+	 * \return \f$ \det {\bf M} = {\bf M}.x \cdot ({\bf M}.y \times {\bf M}.z) \f$.
+	 */
+	CUDA_CALLABLE_MEMBER T determinant(void) const throw();
+
+	/*! \brief Transposes the matrix (inplace)!
+	 *
+	 * \return Reference of this matrix.
+	 */
+	CUDA_CALLABLE_MEMBER SPLMatrix3<T>& transpose(void) throw();
+
+	/*! \brief Returns the transposed matrix!
+	 *
+	 * \return New matrix \f$ {\bf M}^T \f$.
+	 */
+	CUDA_CALLABLE_MEMBER SPLMatrix3<T> getTransposed(void) const throw();
+
+	/*! \brief Inverts the matrix (inplace)!
+	 *
+	 * The matrix is not changed if it is singular.
+	 *
+	 * \return \c true on success and \c false if the matrix is singular.
+	 */
+	CUDA_CALLABLE_MEMBER bool invert(void) throw();
+
+	/*! \brief Returns the inverse matrix!
+	 *
+	 * The matrix must not be singular.
+	 *
+	 * \return New matrix \f$ {\bf M}^{-1} \f$.
+	 */
+	CUDA_CALLABLE_MEMBER SPLMatrix3<T> getInverse(void) const throw();
+
+	/*! \brief Print the elements to standard output!
+	 *
+	 * The elements are printed only in debugging mode,
+	 * i.e. when the library has been compiled with the flag -D__DEBUG__.
+	 */
+	CUDA_CALLABLE_MEMBER void print(void) const throw();
+
+	SPLVector3<T> x;	//!< 1st column of the matrix.
+	SPLVector3<T> y;	//!< 2nd column of the matrix.
+	SPLVector3<T> z;	//!< 3rd column of the matrix.
+};
+
+/************************************************************************************************
+ ** SPLMatrix3 class implementation
+ ************************************************************************************************/
+template <class T>
+SPLMatrix3<T>::SPLMatrix3(void) throw()
+	: x(T(1), T(0), T(0)), y(T(0), T(1), T(0)), z(T(0), T(0), T(1))
+{
+}
+
+template <class T>
+SPLMatrix3<T>::SPLMatrix3(const SPLVector3<T> &x, const SPLVector3<T> &y, const SPLVector3<T> &z) throw()
+	: x(x), y(y), z(z)
+{
+}
+
+template <class T>
+SPLMatrix3<T>::SPLMatrix3(const T m00, const T m01, const T m02,
+						  const T m10, const T m11, const T m12,
+						  const T m20, const T m21, const T m22) throw()
+	: x(m00, m10, m20), y(m01, m11, m21), z(m02, m12, m22)
+{
+}
+
+template <class T>
+bool SPLMatrix3<T>::operator == (const SPLMatrix3<T> &m) const throw()
+{
+	return (this->x == m.x && this->y == m.y && this->z == m.z);
+}
+
+template <class T>
+bool SPLMatrix3<T>::operator != (const SPLMatrix3<T> &m) const throw()
+{
+	return !(this->operator == (m));
+}
+
+template <class T>
+SPLVector3<T>& SPLMatrix3<T>::operator [] (const SPLindex c) throw()
+{
+	assert (c >= 0 && c <= 2);
+	return (&x)[c];
+}
+
+template <class T>
+const SPLVector3<T>& SPLMatrix3<T>::operator [] (const SPLindex c) const throw()
+{
+	assert (c >= 0 && c <= 2);
+	return (&x)[c];
+}
+
+template <class T>
+T& SPLMatrix3<T>::operator () (const SPLindex r, const SPLindex c) throw()
+{
+	return (*this)[c][r];
+}
+
+template <class T>
+const T& SPLMatrix3<T>::operator () (const SPLindex r, const SPLindex c) const throw()
+{
+	return (*this)[c][r];
+}
+
+template <class T>
+SPLMatrix3<T> SPLMatrix3<T>::operator * (const SPLMatrix3<T> &m) const throw()
+{
+	return SPLMatrix3<T>((*this) * m.x, (*this) * m.y, (*this) * m.z);
+}
+
+template <class T>
+SPLVector3<T> SPLMatrix3<T>::operator * (const SPLVector3<T> &v) const throw()
+{
+	return SPLVector3<T>(this->x.x * v.x + this->y.x * v.y + this->z.x * v.z,
+						 this->x.y * v.x + this->y.y * v.y + this->z.y * v.z,
+						 this->x.z * v.x + this->y.z * v.y + this->z.z * v.z);
+}
+
+template <class T>
+SPLMatrix3<T> SPLMatrix3<T>::operator * (const T s) const throw()
+{
+	return SPLMatrix3<T>(this->x * s, this->y * s, this->z * s);
+}
+
+template <class T>
+SPLMatrix3<T> SPLMatrix3<T>::operator + (const SPLMatrix3<T> &m) const throw()
+{
+	return SPLMatrix3<T>(this->x + m.x, this->y + m.y, this->z + m.z);
+}
+
+template <class T>
+SPLMatrix3<T> SPLMatrix3<T>::operator - (const SPLMatrix3<T> &m) const throw()
+{
+	return SPLMatrix3<T>(this->x - m.x, this->y - m.y, this->z - m.z);
+}
+
+template <class T>
+T SPLMatrix3<T>::determinant(void) const throw()
+{
+	return this->x * this->y.crossProduct(this->z);
+}
+
+template <class T>
+SPLMatrix3<T>& SPLMatrix3<T>::transpose(void) throw()
+{
+	*this = this->getTransposed();
+	return *this;
+}
+
+template <class T>
+SPLMatrix3<T> SPLMatrix3<T>::getTransposed(void) const throw()
+{
+	// the columns become the rows
+	return SPLMatrix3<T>(this->x.x, this->x.y, this->x.z,
+						 this->y.x, this->y.y, this->y.z,
+						 this->z.x, this->z.y, this->z.z);
+}
+
+template <class T>
+bool SPLMatrix3<T>::invert(void) throw()
+{
+	// the rows of the inverse are the cross products of the columns
+	const SPLVector3<T> r0 = this->y.crossProduct(this->z);
+	const SPLVector3<T> r1 = this->z.crossProduct(this->x);
+	const SPLVector3<T> r2 = this->x.crossProduct(this->y);
+	const T det = this->x * r0;
+	if (det == T(0))
+	{
+		return false;
+	}
+	const T f = T(1) / det;
+	*this = SPLMatrix3<T>(r0.x * f, r0.y * f, r0.z * f,
+						  r1.x * f, r1.y * f, r1.z * f,
+						  r2.x * f, r2.y * f, r2.z * f);
+	return true;
+}
+
+template <class T>
+SPLMatrix3<T> SPLMatrix3<T>::getInverse(void) const throw()
+{
+	SPLMatrix3<T> ret(*this);
+	const bool ok = ret.invert();
+	assert(ok);
+	(void)ok;
+	return ret;
+}
+
+template <class T>
+void SPLMatrix3<T>::print(void) const throw()
+{
+#ifdef __DEBUG__
+	printf("SPLMatrix3:\n");
+	for (SPLindex r = 0; r < 3; r++)
+	{
+		printf("%10.9f %10.9f %10.9f\n", double((*this)(r, 0)), double((*this)(r, 1)), double((*this)(r, 2)));
+	}
+#endif
+}
+
+#endif /*_spl_matrix3_hh_*/
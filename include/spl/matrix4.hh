@@ -0,0 +1,907 @@
+#ifndef _spl_matrix4_hh_
+#define _spl_matrix4_hh_
+
+#ifdef __DEBUG__
+#include <cstdio>
+#endif
+#include <limits>
+#include <type_traits>
+
+#include <spl/typesbase.hh>
+#include <spl/mathbase.hh>
+#include <spl/cudadefs.hh>
+#include <spl/vector3.hh>
+#include <spl/vector4.hh>
+#include <spl/matrix3.hh>
+#include <spl/vector3array.hh>
+#include <spl/simd.hh>
+#include <spl/simd4.hh>
+#include <spl/threadpool.hh>
+
+#ifdef SPL_SIMD4_SSE
+#include <emmintrin.h>
+#define SPL_MATRIX4_SSE
+#endif
+#if !defined(__CUDA_ARCH__) && defined(__AVX__)
+#include <immintrin.h>
+#define SPL_MATRIX4_AVX
+#endif
+
+template <class T> class SPLMatrix4;
+
+typedef SPLMatrix4<SPLieee32> SPLMatrix4f;	//!< Matrix type with SPLieee32 (32bit) resolution for each element!
+typedef SPLMatrix4<SPLieee64> SPLMatrix4d;	//!< Matrix type with SPLieee64 (64bit) resolution for each element!
+
+/*! \file matrix4.hh
+ * \brief Homogeneous \f$ 4 \times 4 \f$ matrices and batched transformations.
+ *
+ * The matrix product, the transpose and the inverse of \ref SPLMatrix4f
+ * use SSE, the matrix product of \ref SPLMatrix4d uses AVX if available.
+ * Large arrays of points and normals are transformed in one streaming
+ * pass by \ref SPLMatrix4::transformPoints and
+ * \ref SPLMatrix4::transformNormals, which split the array among the
+ * threads of \ref SPLThreadPool. The overloads for \ref SPLVector3ArrayView
+ * process whole SIMD registers of vectors, see \ref SPLSimd.
+ * */
+
+/*! \class SPLMatrix4
+ * \brief A \f$ 4 \times 4 \f$ matrix class for homogeneous coordinates.
+ *
+ * The matrix is stored column by column (column-major like OpenGL), i.e.
+ * the columns are the vectors \c x, \c y, \c z and \c w, where \c w holds
+ * the translation of an affine transformation, and the element in row
+ * \f$ r \f$ and column \f$ c \f$ is \c M[c][r] or \c M(r, c):
+ * \f[
+ * {\bf M} =
+ * \left(
+ * \begin{array}{rrrr}
+ * {\bf M}.x.x & {\bf M}.y.x & {\bf M}.z.x & {\bf M}.w.x \\
+ * {\bf M}.x.y & {\bf M}.y.y & {\bf M}.z.y & {\bf M}.w.y \\
+ * {\bf M}.x.z & {\bf M}.y.z & {\bf M}.z.z & {\bf M}.w.z \\
+ * {\bf M}.x.w & {\bf M}.y.w & {\bf M}.z.w & {\bf M}.w.w
+ * \end{array}
+ * \right)
+ * \f]
+ *
+ * Example
+ * \code
+ * const SPLMatrix4f M = SPLMatrix4f::getTranslation(SPLVector3f(1.0f, 0.0f, 0.0f)) *
+ *                       SPLMatrix4f::getRotation(SPLVector3f(0.0f, 0.0f, 1.0f), 0.5f);
+ * std::vector<SPLVector3f> points(n), normals(n);
+ *
+ * M.transformPoints(&points[0], &points[0], n);	// inplace, all threads
+ * M.transformNormals(&normals[0], &normals[0], n);
+ * \endcode
+ *
+ * \sa SPLMatrix3 SPLVector4
+*/
+template <class T>
+class SPLMatrix4
+{
+public:
+	/*! \brief Constructor!
+	 *
+	 * Initializes the matrix to the identity.
+	 */
+	CUDA_CALLABLE_MEMBER SPLMatrix4(void) throw();
+
+	/*! \brief Constructor!
+	 *
+	 * Initializes the matrix with its columns.
+	 *
+	 * \param x 1st column.
+	 * \param y 2nd column.
+	 * \param z 3rd column.
+	 * \param w 4th column.
+	 */
+	CUDA_CALLABLE_MEMBER SPLMatrix4(const SPLVector4<T> &x, const SPLVector4<T> &y, const SPLVector4<T> &z, const SPLVector4<T> &w) throw();
+
+	/*! \brief Constructor!
+	 *
+	 * Initializes the matrix with its elements given row by row, i.e. in
+	 * the order they are written down.
+	 */
+	CUDA_CALLABLE_MEMBER SPLMatrix4(const T m00, const T m01, const T m02, const T m03,
+									const T m10, const T m11, const T m12, const T m13,
+									const T m20, const T m21, const T m22, const T m23,
+									const T m30, const T m31, const T m32, const T m33) throw();
+
+	/*! \brief Constructor!
+	 *
+	 * Initializes the affine transformation \f$ {\bf p} \mapsto {\bf m} {\bf p} + {\bf t} \f$.
+	 *
+	 * \param m The linear part (upper left \f$ 3 \times 3 \f$ block).
+	 * \param t The translation.
+	 */
+	CUDA_CALLABLE_MEMBER SPLMatrix4(const SPLMatrix3<T> &m, const SPLVector3<T> &t = SPLVector3<T>()) throw();
+
+	/*! \brief Comparison operator!
+	 *
+	 * \param m Another matrix.
+	 *
+	 * \return \c true if all elements are equal and \c false ontherwise.
+	 */
+	CUDA_CALLABLE_MEMBER bool operator == (const SPLMatrix4<T> &m) const throw();
+
+	/*! \brief Comparison operator!
+	 *
+	 * \param m Another matrix.
+	 *
+	 * \return \c true if any element differs and \c false ontherwise.
+	 */
+	CUDA_CALLABLE_MEMBER bool operator != (const SPLMatrix4<T> &m) const throw();
+
+	/*! \brief Access operator!
+	 *
+	 * \param c Index of the column \f$ [0, 3] \f$.
+	 *
+	 * \return Reference of the column.
+	 */
+	CUDA_CALLABLE_MEMBER SPLVector4<T>& operator [] (const SPLindex c) throw();
+
+	/*! \brief Access operator!
+	 *
+	 * \param c Index of the column \f$ [0, 3] \f$.
+	 *
+	 * \return Reference of the column.
+	 */
+	CUDA_CALLABLE_MEMBER const SPLVector4<T>& operator [] (const SPLindex c) const throw();
+
+	/*! \brief Access operator!
+	 *
+	 * \param r Index of the row \f$ [0, 3] \f$.
+	 * \param c Index of the column \f$ [0, 3] \f$.
+	 *
+	 * \return Reference of the element \f$ {\bf M}_{rc} \f$.
+	 */
+	CUDA_CALLABLE_MEMBER T& operator () (const SPLindex r, const SPLindex c) throw();
+
+	/*! \brief Access operator!
+	 *
+	 * \param r Index of the row \f$ [0, 3] \f$.
+	 * \param c Index of the column \f$ [0, 3] \f$.
+	 *
+	 * \return Reference of the element \f$ {\bf M}_{rc} \f$.
+	 */
+	CUDA_CALLABLE_MEMBER const T& operator () (const SPLindex r, const SPLindex c) const throw();
+
+	/*! \brief Multiplication operator!
+	 *
+	 * Concatenates two transformations, i.e. \f$ ({\bf M} * {\bf m}) {\bf p} = {\bf M} ({\bf m} {\bf p}) \f$.
+	 *
+	 * \param m Another matrix.
+	 *
+	 * \return New matrix \f$ {\bf M} * {\bf m} \f$.
+	 */
+	CUDA_CALLABLE_MEMBER SPLMatrix4<T> operator * (const SPLMatrix4<T> &m) const throw();
+
+	/*! \brief Multiplication operator!
+	 *
+	 * \param v A vector.
+	 *
+	 * \return New vector \f$ {\bf M} * {\bf v} \f$.
+	 */
+	CUDA_CALLABLE_MEMBER SPLVector4<T> operator * (const SPLVector4<T> &v) const throw();
+
+	/*! \brief Multiplication operator!
+	 *
+	 * \param s A scalar value.
+	 *
+	 * \return New matrix \f$ s * {\bf M} \f$.
+	 */
+	CUDA_CALLABLE_MEMBER SPLMatrix4<T> operator * (const T s) const throw();
+
+	/*! \brief Addition operator!
+	 *
+	 * \param m Another matrix.
+	 *
+	 * \return New matrix \f$ {\bf M} + {\bf m} \f$.
+	 */
+	CUDA_CALLABLE_MEMBER SPLMatrix4<T> operator + (const SPLMatrix4<T> &m) const throw();
+
+	/*! \brief Subtraction operator!
+	 *
+	 * \param m Another matrix.
+	 *
+	 * \return New matrix \f$ {\bf M} - {\bf m} \f$.
+	 */
+	CUDA_CALLABLE_MEMBER SPLMatrix4<T> operator - (const SPLMatrix4<T> &m) const throw();
+
+	/*! \brief Returns the determinant!
+	 *
+	 * \return \f$ \det {\bf M} \f$.
+	 */
+	CUDA_CALLABLE_MEMBER T determinant(void) const throw();
+
+	/*! \brief Transposes the matrix (inplace)!
+	 *
+	 * \return Reference of this matrix.
+	 */
+	CUDA_CALLABLE_MEMBER SPLMatrix4<T>& transpose(void) throw();
+
+	/*! \brief Returns the transposed matrix!
+	 *
+	 * \return New matrix \f$ {\bf M}^T \f$.
+	 */
+	CUDA_CALLABLE_MEMBER SPLMatrix4<T> getTransposed(void) const throw();
+
+	/*! \brief Inverts the matrix (inplace)!
+	 *
+	 * The matrix is not changed if it is singular.
+	 *
+	 * \return \c true on success and \c false if the matrix is singular.
+	 */
+	CUDA_CALLABLE_MEMBER bool invert(void) throw();
+
+	/*! \brief Returns the inverse matrix!
+	 *
+	 * The matrix must not be singular.
+	 *
+	 * \return New matrix \f$ {\bf M}^{-1} \f$.
+	 */
+	CUDA_CALLABLE_MEMBER SPLMatrix4<T> getInverse(void) const throw();
+
+	/*! \brief Returns the upper left \f$ 3 \times 3 \f$ block!
+	 *
+	 * \return New matrix with the linear part of the transformation.
+	 */
+	CUDA_CALLABLE_MEMBER SPLMatrix3<T> getMatrix3(void) const throw();
+
+	/*! \brief Returns the matrix which transforms normals!
+	 *
+	 * Normals are transformed by the inverse transpose of the linear part,
+	 * such that they stay perpendicular to transformed surfaces under
+	 * non-uniform scalings. A singular linear part yields its transpose
+	 * of cofactors, i.e. the normal matrix up to a factor.
+	 *
+	 * \return New matrix \f$ ({\bf M}_{3 \times 3}^{-1})^T \f$.
+	 */
+	CUDA_CALLABLE_MEMBER SPLMatrix3<T> getNormalMatrix(void) const throw();
+
+	/*! \brief Transforms a point!
+	 *
+	 * Applies the matrix to \f$ ({\bf p}, 1)^T \f$ followed by the
+	 * homogeneous division, which is skipped for affine matrices.
+	 *
+	 * \param p A point.
+	 *
+	 * \return New point.
+	 */
+	CUDA_CALLABLE_MEMBER SPLVector3<T> transformPoint(const SPLVector3<T> &p) const throw();
+
+	/*! \brief Transforms a direction!
+	 *
+	 * Applies the linear part only, i.e. the translation is ignored.
+	 *
+	 * \param v A direction.
+	 *
+	 * \return New direction.
+	 */
+	CUDA_CALLABLE_MEMBER SPLVector3<T> transformVector(const SPLVector3<T> &v) const throw();
+
+	/*! \brief Transforms an array of points!
+	 *
+	 * Computes \c out[i] = \ref transformPoint(\c in[i]) for all points in
+	 * one streaming pass. The array is split among the threads of \c pool
+	 * and the matrix is hoisted out of the loop, which the compiler
+	 * vectorizes. \c in and \c out may be the same array.
+	 *
+	 * \param in Array of \c n points.
+	 * \param out Array of \c n points.
+	 * \param n Number of points.
+	 * \param pool The threads.
+	 */
+	void transformPoints(const SPLVector3<T> *in, SPLVector3<T> *out, const SPLsizei n,
+						 SPLThreadPool &pool = SPLThreadPool::getGlobal()) const throw();
+
+	/*! \brief Transforms an array of points in SoA layout!
+	 *
+	 * Like \ref transformPoints(const SPLVector3<T>*, SPLVector3<T>*, const SPLsizei, SPLThreadPool&) const
+	 * without the conversion of the layout.
+	 *
+	 * \param in The points.
+	 * \param out View of the same size (may be \c in).
+	 * \param pool The threads.
+	 */
+	void transformPoints(const SPLVector3ArrayView<T> &in, const SPLVector3ArrayView<T> &out,
+						 SPLThreadPool &pool = SPLThreadPool::getGlobal()) const throw();
+
+	/*! \brief Transforms an array of normals!
+	 *
+	 * Computes \c out[i] = \ref getNormalMatrix() * \c in[i] normalized to
+	 * unit length (zero normals stay zero) in one streaming pass, see
+	 * \ref transformPoints. \c in and \c out may be the same array.
+	 *
+	 * \param in Array of \c n normals.
+	 * \param out Array of \c n normals.
+	 * \param n Number of normals.
+	 * \param pool The threads.
+	 */
+	void transformNormals(const SPLVector3<T> *in, SPLVector3<T> *out, const SPLsizei n,
+						  SPLThreadPool &pool = SPLThreadPool::getGlobal()) const throw();
+
+	/*! \brief Transforms an array of normals in SoA layout!
+	 *
+	 * \param in The normals.
+	 * \param out View of the same size (may be \c in).
+	 * \param pool The threads.
+	 */
+	void transformNormals(const SPLVector3ArrayView<T> &in, const SPLVector3ArrayView<T> &out,
+						  SPLThreadPool &pool = SPLThreadPool::getGlobal()) const throw();
+
+	/*! \brief Print the elements to standard output!
+	 *
+	 * The elements are printed only in debugging mode,
+	 * i.e. when the library has been compiled with the flag -D__DEBUG__.
+	 */
+	CUDA_CALLABLE_MEMBER void print(void) const throw();
+
+	/*! \brief Returns a translation matrix!
+	 *
+	 * \param t The translation.
+	 *
+	 * \return New matrix.
+	 */
+	CUDA_CALLABLE_MEMBER static SPLMatrix4<T> getTranslation(const SPLVector3<T> &t) throw();
+
+	/*! \brief Returns a scaling matrix!
+	 *
+	 * \param s The scaling factors along the axes.
+	 *
+	 * \return New matrix.
+	 */
+	CUDA_CALLABLE_MEMBER static SPLMatrix4<T> getScaling(const SPLVector3<T> &s) throw();
+
+	/*! \brief Returns a rotation matrix!
+	 *
+	 * Rotates counterclockwise about an axis through the origin.
+	 *
+	 * \param axis The axis (non zero, need not be normalized).
+	 * \param angle The angle in radians.
+	 *
+	 * \return New matrix.
+	 */
+	CUDA_CALLABLE_MEMBER static SPLMatrix4<T> getRotation(const SPLVector3<T> &axis, const T angle) throw();
+
+	SPLVector4<T> x;	//!< 1st column of the matrix.
+	SPLVector4<T> y;	//!< 2nd column of the matrix.
+	SPLVector4<T> z;	//!< 3rd column of the matrix.
+	SPLVector4<T> w;	//!< 4th column of the matrix (translation).
+
+private:
+	template <bool Normal>
+	void transform(const SPLVector3ArrayView<T> &in, const SPLVector3ArrayView<T> &out, SPLThreadPool &pool) const throw();
+
+	template <bool Normal>
+	void transform(const SPLVector3<T> *in, SPLVector3<T> *out, const SPLsizei n, SPLThreadPool &pool) const throw();
+};
+
+/************************************************************************************************
+ ** SIMD helpers
+ ************************************************************************************************/
+namespace SPLMatrix4Detail
+{
+#ifdef SPL_MATRIX4_SSE
+	//! Computes \c r = \c a * \c b for column-major matrices.
+	inline void multiply(const SPLieee32 *a, const SPLieee32 *b, SPLieee32 *r) throw()
+	{
+		const __m128 a0 = _mm_loadu_ps(a), a1 = _mm_loadu_ps(a + 4), a2 = _mm_loadu_ps(a + 8), a3 = _mm_loadu_ps(a + 12);
+		for (int c = 0; c < 4; c++)
+		{
+			const __m128 bc = _mm_loadu_ps(b + 4 * c);
+			const __m128 s = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a0, SPLSimd4f::splat<0>(bc)), _mm_mul_ps(a1, SPLSimd4f::splat<1>(bc))),
+										_mm_add_ps(_mm_mul_ps(a2, SPLSimd4f::splat<2>(bc)), _mm_mul_ps(a3, SPLSimd4f::splat<3>(bc))));
+			_mm_storeu_ps(r + 4 * c, s);
+		}
+	}
+
+	//! Computes \c r = \c a * \c v for a column-major matrix.
+	inline void multiplyVector(const SPLieee32 *a, const SPLieee32 *v, SPLieee32 *r) throw()
+	{
+		const __m128 b = _mm_loadu_ps(v);
+		const __m128 s = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_loadu_ps(a), SPLSimd4f::splat<0>(b)), _mm_mul_ps(_mm_loadu_ps(a + 4), SPLSimd4f::splat<1>(b))),
+									_mm_add_ps(_mm_mul_ps(_mm_loadu_ps(a + 8), SPLSimd4f::splat<2>(b)), _mm_mul_ps(_mm_loadu_ps(a + 12), SPLSimd4f::splat<3>(b))));
+		_mm_storeu_ps(r, s);
+	}
+
+	//! Computes \c r = \c a^T.
+	inline void transpose(const SPLieee32 *a, SPLieee32 *r) throw()
+	{
+		__m128 a0 = _mm_loadu_ps(a), a1 = _mm_loadu_ps(a + 4), a2 = _mm_loadu_ps(a + 8), a3 = _mm_loadu_ps(a + 12);
+		_MM_TRANSPOSE4_PS(a0, a1, a2, a3);
+		_mm_storeu_ps(r, a0);
+		_mm_storeu_ps(r + 4, a1);
+		_mm_storeu_ps(r + 8, a2);
+		_mm_storeu_ps(r + 12, a3);
+	}
+
+	/*! Computes \c r = \c a^{-1}, see \ref SPLMatrix4::invert.
+	 *
+	 * \return \c false if \c a is singular (\c r is not changed).
+	 */
+	inline bool invert(const SPLieee32 *a, SPLieee32 *r) throw()
+	{
+		const __m128 c0 = _mm_loadu_ps(a), c1 = _mm_loadu_ps(a + 4), c2 = _mm_loadu_ps(a + 8), c3 = _mm_loadu_ps(a + 12);
+		const __m128 x = SPLSimd4f::splat<3>(c0), y = SPLSimd4f::splat<3>(c1), z = SPLSimd4f::splat<3>(c2), w = SPLSimd4f::splat<3>(c3);
+		// the 4th lanes of s, t, u and v are zero
+		__m128 s = SPLSimd4f::cross(c0, c1), t = SPLSimd4f::cross(c2, c3);
+		__m128 u = _mm_sub_ps(_mm_mul_ps(c0, y), _mm_mul_ps(c1, x));
+		__m128 v = _mm_sub_ps(_mm_mul_ps(c2, w), _mm_mul_ps(c3, z));
+		const __m128 det = _mm_add_ps(SPLSimd4f::dot4(s, v), SPLSimd4f::dot4(t, u));
+		if (_mm_cvtss_f32(det) == 0.0f)
+		{
+			return false;
+		}
+		const __m128 f = _mm_div_ps(_mm_set1_ps(1.0f), det);
+		s = _mm_mul_ps(s, f);
+		t = _mm_mul_ps(t, f);
+		u = _mm_mul_ps(u, f);
+		v = _mm_mul_ps(v, f);
+		// rows of the inverse, the 4th lane is inserted by the mask
+		const __m128 mask = _mm_castsi128_ps(_mm_set_epi32(-1, 0, 0, 0));
+		const __m128 zero = _mm_setzero_ps();
+		__m128 r0 = _mm_add_ps(_mm_add_ps(SPLSimd4f::cross(c1, v), _mm_mul_ps(t, y)), _mm_and_ps(mask, _mm_sub_ps(zero, SPLSimd4f::dot4(c1, t))));
+		__m128 r1 = _mm_add_ps(_mm_sub_ps(SPLSimd4f::cross(v, c0), _mm_mul_ps(t, x)), _mm_and_ps(mask, SPLSimd4f::dot4(c0, t)));
+		__m128 r2 = _mm_add_ps(_mm_add_ps(SPLSimd4f::cross(c3, u), _mm_mul_ps(s, w)), _mm_and_ps(mask, _mm_sub_ps(zero, SPLSimd4f::dot4(c3, s))));
+		__m128 r3 = _mm_add_ps(_mm_sub_ps(SPLSimd4f::cross(u, c2), _mm_mul_ps(s, z)), _mm_and_ps(mask, SPLSimd4f::dot4(c2, s)));
+		_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+		_mm_storeu_ps(r, r0);
+		_mm_storeu_ps(r + 4, r1);
+		_mm_storeu_ps(r + 8, r2);
+		_mm_storeu_ps(r + 12, r3);
+		return true;
+	}
+#endif
+
+#ifdef SPL_MATRIX4_AVX
+	//! Computes \c r = \c a * \c b for column-major matrices.
+	inline void multiply(const SPLieee64 *a, const SPLieee64 *b, SPLieee64 *r) throw()
+	{
+		const __m256d a0 = _mm256_loadu_pd(a), a1 = _mm256_loadu_pd(a + 4), a2 = _mm256_loadu_pd(a + 8), a3 = _mm256_loadu_pd(a + 12);
+		for (int c = 0; c < 4; c++)
+		{
+			const SPLieee64 *bc = b + 4 * c;
+			const __m256d s = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(a0, _mm256_broadcast_sd(bc)), _mm256_mul_pd(a1, _mm256_broadcast_sd(bc + 1))),
+											_mm256_add_pd(_mm256_mul_pd(a2, _mm256_broadcast_sd(bc + 2)), _mm256_mul_pd(a3, _mm256_broadcast_sd(bc + 3))));
+			_mm256_storeu_pd(r + 4 * c, s);
+		}
+	}
+#endif
+
+	/*! \brief Batch kernel of the transformations.
+	 *
+	 * Holds the matrix in broadcast form: the linear part \c m (row by
+	 * row), the translation \c t and the projective row \c p.
+	 */
+	template <class T>
+	struct Kernel
+	{
+		T m[9];				//!< Linear part, row by row.
+		T t[3];				//!< Translation.
+		T p[4];				//!< 4th row.
+		bool projective;	//!< Set if the 4th row is not \f$ (0, 0, 0, 1) \f$.
+		bool normalize;		//!< Set for normals.
+
+		//! Returns \f$ {\bf m} {\bf v} + {\bf t} \f$.
+		SPLVector3<T> affine(const SPLVector3<T> &v) const throw()
+		{
+			return SPLVector3<T>(m[0] * v.x + m[1] * v.y + m[2] * v.z + t[0],
+								 m[3] * v.x + m[4] * v.y + m[5] * v.z + t[1],
+								 m[6] * v.x + m[7] * v.y + m[8] * v.z + t[2]);
+		}
+
+		//! Transforms the vectors \f$ [i, i + S::width) \f$.
+		template <class S>
+		void apply(const T *x, const T *y, const T *z, T *ox, T *oy, T *oz, const SPLindex i) const throw()
+		{
+			typedef typename S::Type R;
+			const R vx = S::load(x + i), vy = S::load(y + i), vz = S::load(z + i);
+			R rx = S::add(S::add(S::mul(S::set(m[0]), vx), S::mul(S::set(m[1]), vy)), S::add(S::mul(S::set(m[2]), vz), S::set(t[0])));
+			R ry = S::add(S::add(S::mul(S::set(m[3]), vx), S::mul(S::set(m[4]), vy)), S::add(S::mul(S::set(m[5]), vz), S::set(t[1])));
+			R rz = S::add(S::add(S::mul(S::set(m[6]), vx), S::mul(S::set(m[7]), vy)), S::add(S::mul(S::set(m[8]), vz), S::set(t[2])));
+			if (this->projective)
+			{
+				const R rw = S::add(S::add(S::mul(S::set(p[0]), vx), S::mul(S::set(p[1]), vy)), S::add(S::mul(S::set(p[2]), vz), S::set(p[3])));
+				const R f = S::div(S::set(T(1)), rw);
+				rx = S::mul(rx, f);
+				ry = S::mul(ry, f);
+				rz = S::mul(rz, f);
+			}
+			else if (this->normalize)
+			{
+				const R sq = S::add(S::add(S::mul(rx, rx), S::mul(ry, ry)), S::mul(rz, rz));
+				// zero normals stay zero
+				const R f = S::selectZero(sq, sq, S::div(S::set(T(1)), S::sqrt(sq)));
+				rx = S::mul(rx, f);
+				ry = S::mul(ry, f);
+				rz = S::mul(rz, f);
+			}
+			S::store(ox + i, rx);
+			S::store(oy + i, ry);
+			S::store(oz + i, rz);
+		}
+	};
+
+	//! Minimum number of vectors per thread of the batched transformations.
+	static const SPLsizei GRAIN = 4096;
+}
+
+/************************************************************************************************
+ ** SPLMatrix4 class implementation
+ ************************************************************************************************/
+template <class T>
+SPLMatrix4<T>::SPLMatrix4(void) throw()
+	: x(T(1), T(0), T(0), T(0)), y(T(0), T(1), T(0), T(0)), z(T(0), T(0), T(1), T(0)), w(T(0), T(0), T(0), T(1))
+{
+}
+
+template <class T>
+SPLMatrix4<T>::SPLMatrix4(const SPLVector4<T> &x, const SPLVector4<T> &y, const SPLVector4<T> &z, const SPLVector4<T> &w) throw()
+	: x(x), y(y), z(z), w(w)
+{
+}
+
+template <class T>
+SPLMatrix4<T>::SPLMatrix4(const T m00, const T m01, const T m02, const T m03,
+						  const T m10, const T m11, const T m12, const T m13,
+						  const T m20, const T m21, const T m22, const T m23,
+						  const T m30, const T m31, const T m32, const T m33) throw()
+	: x(m00, m10, m20, m30), y(m01, m11, m21, m31), z(m02, m12, m22, m32), w(m03, m13, m23, m33)
+{
+}
+
+template <class T>
+SPLMatrix4<T>::SPLMatrix4(const SPLMatrix3<T> &m, const SPLVector3<T> &t) throw()
+	: x(m.x, T(0)), y(m.y, T(0)), z(m.z, T(0)), w(t, T(1))
+{
+}
+
+template <class T>
+bool SPLMatrix4<T>::operator == (const SPLMatrix4<T> &m) const throw()
+{
+	return (this->x == m.x && this->y == m.y && this->z == m.z && this->w == m.w);
+}
+
+template <class T>
+bool SPLMatrix4<T>::operator != (const SPLMatrix4<T> &m) const throw()
+{
+	return !(this->operator == (m));
+}
+
+template <class T>
+SPLVector4<T>& SPLMatrix4<T>::operator [] (const SPLindex c) throw()
+{
+	assert (c >= 0 && c <= 3);
+	return (&x)[c];
+}
+
+template <class T>
+const SPLVector4<T>& SPLMatrix4<T>::operator [] (const SPLindex c) const throw()
+{
+	assert (c >= 0 && c <= 3);
+	return (&x)[c];
+}
+
+template <class T>
+T& SPLMatrix4<T>::operator () (const SPLindex r, const SPLindex c) throw()
+{
+	return (*this)[c][r];
+}
+
+template <class T>
+const T& SPLMatrix4<T>::operator () (const SPLindex r, const SPLindex c) const throw()
+{
+	return (*this)[c][r];
+}
+
+template <class T>
+SPLMatrix4<T> SPLMatrix4<T>::operator * (const SPLMatrix4<T> &m) const throw()
+{
+#ifdef SPL_MATRIX4_SSE
+	if constexpr (std::is_same<T, SPLieee32>::value)
+	{
+		SPLMatrix4<T> ret;
+		SPLMatrix4Detail::multiply(&this->x.x, &m.x.x, &ret.x.x);
+		return ret;
+	}
+#endif
+#ifdef SPL_MATRIX4_AVX
+	if constexpr (std::is_same<T, SPLieee64>::value)
+	{
+		SPLMatrix4<T> ret;
+		SPLMatrix4Detail::multiply(&this->x.x, &m.x.x, &ret.x.x);
+		return ret;
+	}
+#endif
+	return SPLMatrix4<T>((*this) * m.x, (*this) * m.y, (*this) * m.z, (*this) * m.w);
+}
+
+template <class T>
+SPLVector4<T> SPLMatrix4<T>::operator * (const SPLVector4<T> &v) const throw()
+{
+#ifdef SPL_MATRIX4_SSE
+	if constexpr (std::is_same<T, SPLieee32>::value)
+	{
+		SPLVector4<T> ret;
+		SPLMatrix4Detail::multiplyVector(&this->x.x, &v.x, &ret.x);
+		return ret;
+	}
+#endif
+	return this->x * v.x + this->y * v.y + this->z * v.z + this->w * v.w;
+}
+
+template <class T>
+SPLMatrix4<T> SPLMatrix4<T>::operator * (const T s) const throw()
+{
+	return SPLMatrix4<T>(this->x * s, this->y * s, this->z * s, this->w * s);
+}
+
+template <class T>
+SPLMatrix4<T> SPLMatrix4<T>::operator + (const SPLMatrix4<T> &m) const throw()
+{
+	return SPLMatrix4<T>(this->x + m.x, this->y + m.y, this->z + m.z, this->w + m.w);
+}
+
+template <class T>
+SPLMatrix4<T> SPLMatrix4<T>::operator - (const SPLMatrix4<T> &m) const throw()
+{
+	return SPLMatrix4<T>(this->x - m.x, this->y - m.y, this->z - m.z, this->w - m.w);
+}
+
+template <class T>
+T SPLMatrix4<T>::determinant(void) const throw()
+{
+	// see invert()
+	const SPLVector3<T> a(this->x), b(this->y), c(this->z), d(this->w);
+	const SPLVector3<T> s = a.crossProduct(b), t = c.crossProduct(d);
+	const SPLVector3<T> u = a * this->y.w - b * this->x.w, v = c * this->w.w - d * this->z.w;
+	return s * v + t * u;
+}
+
+template <class T>
+SPLMatrix4<T>& SPLMatrix4<T>::transpose(void) throw()
+{
+	*this = this->getTransposed();
+	return *this;
+}
+
+template <class T>
+SPLMatrix4<T> SPLMatrix4<T>::getTransposed(void) const throw()
+{
+#ifdef SPL_MATRIX4_SSE
+	if constexpr (std::is_same<T, SPLieee32>::value)
+	{
+		SPLMatrix4<T> ret;
+		SPLMatrix4Detail::transpose(&this->x.x, &ret.x.x);
+		return ret;
+	}
+#endif
+	// the columns become the rows
+	return SPLMatrix4<T>(this->x.x, this->x.y, this->x.z, this->x.w,
+						 this->y.x, this->y.y, this->y.z, this->y.w,
+						 this->z.x, this->z.y, this->z.z, this->z.w,
+						 this->w.x, this->w.y, this->w.z, this->w.w);
+}
+
+template <class T>
+bool SPLMatrix4<T>::invert(void) throw()
+{
+#ifdef SPL_MATRIX4_SSE
+	if constexpr (std::is_same<T, SPLieee32>::value)
+	{
+		return SPLMatrix4Detail::invert(&this->x.x, &this->x.x);
+	}
+#endif
+	// Cramer's rule with cross products of the 3 dimensional parts of the
+	// columns a, b, c, d and the 4th row (x, y, z, w)
+	const SPLVector3<T> a(this->x), b(this->y), c(this->z), d(this->w);
+	const T x = this->x.w, y = this->y.w, z = this->z.w, w = this->w.w;
+	SPLVector3<T> s = a.crossProduct(b), t = c.crossProduct(d);
+	SPLVector3<T> u = a * y - b * x, v = c * w - d * z;
+	const T det = s * v + t * u;
+	if (det == T(0))
+	{
+		return false;
+	}
+	const T f = T(1) / det;
+	s *= f;
+	t *= f;
+	u *= f;
+	v *= f;
+	const SPLVector3<T> r0 = b.crossProduct(v) + t * y;
+	const SPLVector3<T> r1 = v.crossProduct(a) - t * x;
+	const SPLVector3<T> r2 = d.crossProduct(u) + s * w;
+	const SPLVector3<T> r3 = u.crossProduct(c) - s * z;
+	*this = SPLMatrix4<T>(r0.x, r0.y, r0.z, -(b * t),
+						  r1.x, r1.y, r1.z, a * t,
+						  r2.x, r2.y, r2.z, -(d * s),
+						  r3.x, r3.y, r3.z, c * s);
+	return true;
+}
+
+template <class T>
+SPLMatrix4<T> SPLMatrix4<T>::getInverse(void) const throw()
+{
+	SPLMatrix4<T> ret(*this);
+	const bool ok = ret.invert();
+	assert(ok);
+	(void)ok;
+	return ret;
+}
+
+template <class T>
+SPLMatrix3<T> SPLMatrix4<T>::getMatrix3(void) const throw()
+{
+	return SPLMatrix3<T>(SPLVector3<T>(this->x), SPLVector3<T>(this->y), SPLVector3<T>(this->z));
+}
+
+template <class T>
+SPLMatrix3<T> SPLMatrix4<T>::getNormalMatrix(void) const throw()
+{
+	// the inverse transpose is the matrix of cofactors over the determinant
+	const SPLVector3<T> a(this->x), b(this->y), c(this->z);
+	SPLMatrix3<T> ret(b.crossProduct(c), c.crossProduct(a), a.crossProduct(b));
+	const T det = a * ret.x;
+	return (det != T(0)) ? ret * (T(1) / det) : ret;
+}
+
+template <class T>
+SPLVector3<T> SPLMatrix4<T>::transformPoint(const SPLVector3<T> &p) const throw()
+{
+	const SPLVector4<T> r = (*this) * SPLVector4<T>(p, T(1));
+	return (r.w == T(1)) ? SPLVector3<T>(r) : r.getHomogenized();
+}
+
+template <class T>
+SPLVector3<T> SPLMatrix4<T>::transformVector(const SPLVector3<T> &v) const throw()
+{
+	return SPLVector3<T>(this->x.x * v.x + this->y.x * v.y + this->z.x * v.z,
+						 this->x.y * v.x + this->y.y * v.y + this->z.y * v.z,
+						 this->x.z * v.x + this->y.z * v.y + this->z.z * v.z);
+}
+
+template <class T>
+void SPLMatrix4<T>::transformPoints(const SPLVector3<T> *in, SPLVector3<T> *out, const SPLsizei n, SPLThreadPool &pool) const throw()
+{
+	this->template transform<false>(in, out, n, pool);
+}
+
+template <class T>
+void SPLMatrix4<T>::transformPoints(const SPLVector3ArrayView<T> &in, const SPLVector3ArrayView<T> &out, SPLThreadPool &pool) const throw()
+{
+	this->template transform<false>(in, out, pool);
+}
+
+template <class T>
+void SPLMatrix4<T>::transformNormals(const SPLVector3<T> *in, SPLVector3<T> *out, const SPLsizei n, SPLThreadPool &pool) const throw()
+{
+	this->template transform<true>(in, out, n, pool);
+}
+
+template <class T>
+void SPLMatrix4<T>::transformNormals(const SPLVector3ArrayView<T> &in, const SPLVector3ArrayView<T> &out, SPLThreadPool &pool) const throw()
+{
+	this->template transform<true>(in, out, pool);
+}
+
+namespace SPLMatrix4Detail
+{
+	//! Returns the batch kernel of a matrix for points or normals.
+	template <class T>
+	Kernel<T> getKernel(const SPLMatrix4<T> &mat, const bool normal) throw()
+	{
+		static_assert(!std::numeric_limits<T>::is_integer, "batched transformations need a floating point type");
+		Kernel<T> k;
+		const SPLMatrix3<T> m = normal ? mat.getNormalMatrix() : mat.getMatrix3();
+		for (SPLindex r = 0; r < 3; r++)
+		{
+			for (SPLindex c = 0; c < 3; c++)
+			{
+				k.m[3 * r + c] = m(r, c);
+			}
+			k.t[r] = normal ? T(0) : mat(r, 3);
+			k.p[r] = mat(3, r);
+		}
+		k.p[3] = mat(3, 3);
+		k.projective = !normal && (k.p[0] != T(0) || k.p[1] != T(0) || k.p[2] != T(0) || k.p[3] != T(1));
+		k.normalize = normal;
+		return k;
+	}
+}
+
+template <class T>
+template <bool Normal>
+void SPLMatrix4<T>::transform(const SPLVector3ArrayView<T> &in, const SPLVector3ArrayView<T> &out, SPLThreadPool &pool) const throw()
+{
+	assert(in.size() == out.size());
+	const SPLMatrix4Detail::Kernel<T> k = SPLMatrix4Detail::getKernel(*this, Normal);
+	const SPLsizei n = in.size();
+	pool.parallelFor(0, n, pool.getGrain(n, SPLMatrix4Detail::GRAIN), [&](const SPLint64 first, const SPLint64 last)
+	{
+		const SPLVector3ArrayView<T> a = in.getView(SPLindex(first), SPLsizei(last - first));
+		const SPLVector3ArrayView<T> b = out.getView(SPLindex(first), SPLsizei(last - first));
+		splSimdForEach<T>(a.size(), [&](auto simd, const SPLindex i)
+		{
+			k.template apply<decltype(simd)>(a.x, a.y, a.z, b.x, b.y, b.z, i);
+		});
+	});
+}
+
+template <class T>
+template <bool Normal>
+void SPLMatrix4<T>::transform(const SPLVector3<T> *in, SPLVector3<T> *out, const SPLsizei n, SPLThreadPool &pool) const throw()
+{
+	assert(n >= 0 && (n == 0 || (in != 0 && out != 0)));
+	const SPLMatrix4Detail::Kernel<T> k = SPLMatrix4Detail::getKernel(*this, Normal);
+	// A direct loop over the structures streams better than a conversion
+	// into SIMD lanes, the compiler vectorizes it for the target. Each
+	// vector is read before it is written, i.e. in and out may alias.
+	pool.parallelFor(0, n, pool.getGrain(n, SPLMatrix4Detail::GRAIN), [&](const SPLint64 first, const SPLint64 last)
+	{
+		const SPLindex end = SPLindex(last);
+		if (k.projective)
+		{
+			for (SPLindex i = SPLindex(first); i < end; i++)
+			{
+				const SPLVector3<T> v = in[i];
+				const T f = T(1) / (k.p[0] * v.x + k.p[1] * v.y + k.p[2] * v.z + k.p[3]);
+				out[i] = k.affine(v) * f;
+			}
+		}
+		else if (k.normalize)
+		{
+			for (SPLindex i = SPLindex(first); i < end; i++)
+			{
+				const SPLVector3<T> r = k.affine(in[i]);
+				const T sq = r.x * r.x + r.y * r.y + r.z * r.z;
+				out[i] = (sq > T(0)) ? r * (T(1) / T(std::sqrt(sq))) : r;
+			}
+		}
+		else
+		{
+			for (SPLindex i = SPLindex(first); i < end; i++)
+			{
+				out[i] = k.affine(in[i]);
+			}
+		}
+	});
+}
+
+template <class T>
+void SPLMatrix4<T>::print(void) const throw()
+{
+#ifdef __DEBUG__
+	printf("SPLMatrix4:\n");
+	for (SPLindex r = 0; r < 4; r++)
+	{
+		printf("%10.9f %10.9f %10.9f %10.9f\n", double((*this)(r, 0)), double((*this)(r, 1)), double((*this)(r, 2)), double((*this)(r, 3)));
+	}
+#endif
+}
+
+template <class T>
+SPLMatrix4<T> SPLMatrix4<T>::getTranslation(const SPLVector3<T> &t) throw()
+{
+	return SPLMatrix4<T>(SPLMatrix3<T>(), t);
+}
+
+template <class T>
+SPLMatrix4<T> SPLMatrix4<T>::getScaling(const SPLVector3<T> &s) throw()
+{
+	return SPLMatrix4<T>(SPLMatrix3<T>(s.x, T(0), T(0),
+									   T(0), s.y, T(0),
+									   T(0), T(0), s.z));
+}
+
+template <class T>
+SPLMatrix4<T> SPLMatrix4<T>::getRotation(const SPLVector3<T> &axis, const T angle) throw()
+{
+	// Rodrigues' rotation formula
+	const SPLVector3<T> a = axis.getNormalized();
+	const T c = T(cos(angle)), s = T(sin(angle)), t = T(1) - c;
+	return SPLMatrix4<T>(SPLMatrix3<T>(t * a.x * a.x + c,       t * a.x * a.y - s * a.z, t * a.x * a.z + s * a.y,
+									   t * a.x * a.y + s * a.z, t * a.y * a.y + c,       t * a.y * a.z - s * a.x,
+									   t * a.x * a.z - s * a.y, t * a.y * a.z + s * a.x, t * a.z * a.z + c));
+}
+
+#endif /*_spl_matrix4_hh_*/
@@ -0,0 +1,211 @@
+#ifndef _spl_nifti_hh_
+#define _spl_nifti_hh_
+
+#include <cstdio>    // for fopen()
+#include <cstring>   // for memcpy()
+#include <limits>
+#include <string>
+
+#include <spl/typesbase.hh>
+#include <spl/vector3.hh>
+
+/*! \file nifti.hh
+ * \brief The header of NIfTI-1 files.
+ *
+ * A NIfTI-1 file (\ref SPL_FILEIO_NII_ID) starts with a header of 348
+ * bytes, which describes the dimensions, the voxel spacing and the data
+ * type of the voxels, followed by the voxels in linear order (x fastest)
+ * at the byte offset \c vox_offset. Only the fields needed to address
+ * the voxels are parsed, see \ref SPLNIfTIHeader.
+ * */
+
+/*! \struct SPLNIfTIHeader
+ * \brief The parsed header of a NIfTI-1 file.
+ */
+struct SPLNIfTIHeader
+{
+	SPLVector3i size;		//!< Number of voxels along x, y and z (\c dim[1..3]).
+	SPLVector3d spacing;	//!< Voxel spacing along x, y and z (\c pixdim[1..3]).
+	SPLint32 volumes;		//!< Number of volumes, i.e. the product of \c dim[4..7].
+	SPLenum type;			//!< Storage type of the voxels (\c SPL_TYPE_*).
+	SPLint32 bytes;			//!< Bytes per voxel.
+	SPLint64 offset;		//!< Byte offset of the voxels (\c vox_offset).
+	SPLieee64 slope;		//!< Intensity scaling, i.e. \f$ v' = slope * v + intercept \f$ (\c scl_slope, 0 if unused).
+	SPLieee64 intercept;	//!< Intensity offset (\c scl_inter).
+	bool swapped;			//!< Set if the byte order of the file differs from the host.
+	bool pair;				//!< Set for a .hdr/.img pair (magic "ni1"), i.e. the voxels are in the .img file.
+};
+
+namespace SPLNIfTIDetail
+{
+	//! Reads a value of the header at a byte offset.
+	template <class T>
+	inline T get(const SPLuint8 *h, const SPLint32 offset, const bool swapped) throw()
+	{
+		SPLuint8 b[sizeof(T)];
+		memcpy(b, h + offset, sizeof(T));
+		if (swapped)
+		{
+			for (size_t i = 0; i < sizeof(T) / 2; i++)
+			{
+				const SPLuint8 t = b[i];
+				b[i] = b[sizeof(T) - 1 - i];
+				b[sizeof(T) - 1 - i] = t;
+			}
+		}
+		T v;
+		memcpy(&v, b, sizeof(T));
+		return v;
+	}
+
+	//! Returns the size of a file in bytes, or -1 if it cannot be opened.
+	inline SPLint64 getFileSize(const char *path) throw()
+	{
+		FILE *f = fopen(path, "rb");
+		if (f == 0)
+		{
+			return -1;
+		}
+#ifdef _WIN32
+		const SPLint64 size = (_fseeki64(f, 0, SEEK_END) == 0) ? SPLint64(_ftelli64(f)) : -1;
+#else
+		const SPLint64 size = (fseeko(f, 0, SEEK_END) == 0) ? SPLint64(ftello(f)) : -1;
+#endif
+		fclose(f);
+		return size;
+	}
+}
+
+/*! \fn bool splParseNIfTIHeader(const SPLuint8 *data, const SPLint64 size, SPLNIfTIHeader &header)
+ * \brief Parses the header of a NIfTI-1 file!
+ *
+ * \param data The first bytes of the file.
+ * \param size Number of bytes of \c data (at least 348).
+ * \param header The parsed header.
+ *
+ * \return \c true on success and \c false otherwise, e.g. for an unknown
+ * data type, a missing magic, more than 7 dimensions, or more volumes or
+ * bytes of voxels than fit into \ref SPLNIfTIHeader::volumes or an
+ * \ref SPLint64.
+ */
+inline bool splParseNIfTIHeader(const SPLuint8 *data, const SPLint64 size, SPLNIfTIHeader &header) throw()
+{
+	using SPLNIfTIDetail::get;
+	if (data == 0 || size < 348)
+	{
+		return false;
+	}
+	const SPLint32 sizeofHdr = get<SPLint32>(data, 0, false);
+	bool swapped = false;
+	if (sizeofHdr != 348)
+	{
+		swapped = true;
+		if (get<SPLint32>(data, 0, true) != 348)
+		{
+			return false;
+		}
+	}
+	const bool single = (memcmp(data + 344, "n+1\0", 4) == 0);
+	if (!single && memcmp(data + 344, "ni1\0", 4) != 0)
+	{
+		return false;
+	}
+
+	// data type code, storage type, bytes per voxel
+	static const SPLint32 codes[][3] =
+	{
+		{ 2, SPL_TYPE_UINT8, 1 }, { 256, SPL_TYPE_INT8, 1 },
+		{ 4, SPL_TYPE_INT16, 2 }, { 512, SPL_TYPE_UINT16, 2 },
+		{ 8, SPL_TYPE_INT32, 4 }, { 768, SPL_TYPE_UINT32, 4 },
+		{ 1024, SPL_TYPE_INT64, 8 }, { 1280, SPL_TYPE_UINT64, 8 },
+		{ 16, SPL_TYPE_IEEE32, 4 }, { 64, SPL_TYPE_IEEE64, 8 }
+	};
+	const SPLint32 datatype = get<SPLint16>(data, 70, swapped);
+	header.type = SPL_TYPE_MIN;
+	header.bytes = 0;
+	for (size_t i = 0; i < sizeof(codes) / sizeof(codes[0]); i++)
+	{
+		if (codes[i][0] == datatype)
+		{
+			header.type = codes[i][1];
+			header.bytes = codes[i][2];
+			break;
+		}
+	}
+	const SPLint32 ndim = get<SPLint16>(data, 40, swapped);
+	if (header.type == SPL_TYPE_MIN || ndim < 1 || ndim > 7)
+	{
+		return false;
+	}
+
+	SPLint32 dim[8] = { ndim, 1, 1, 1, 1, 1, 1, 1 };
+	SPLieee64 pixdim[8] = { 1.0, 1.0, 1.0, 1.0, 1.0, 1.0, 1.0, 1.0 };
+	for (SPLindex i = 1; i <= ndim; i++)
+	{
+		dim[i] = get<SPLint16>(data, 40 + 2 * i, swapped);
+		pixdim[i] = SPLieee64(get<SPLieee32>(data, 76 + 4 * i, swapped));
+		if (dim[i] < 1)
+		{
+			return false;
+		}
+	}
+	header.size = SPLVector3i(dim[1], dim[2], dim[3]);
+	// a spacing of 0 is common for unused dimensions
+	header.spacing = SPLVector3d(pixdim[1] > 0.0 ? pixdim[1] : 1.0, pixdim[2] > 0.0 ? pixdim[2] : 1.0, pixdim[3] > 0.0 ? pixdim[3] : 1.0);
+	// the dimensions are below 2^15, i.e. the product of four of them fits into 64 bits
+	const SPLint64 volumes = SPLint64(dim[4]) * dim[5] * dim[6] * dim[7];
+	const SPLint64 volume = SPLint64(dim[1]) * dim[2] * dim[3] * header.bytes;
+	const SPLieee32 offset = get<SPLieee32>(data, 108, swapped);
+	if (volumes > std::numeric_limits<SPLint32>::max() || !(offset >= 0.0f && offset < 1.0e15f) ||
+		volumes > (std::numeric_limits<SPLint64>::max() - SPLint64(offset)) / volume)
+	{
+		return false;
+	}
+	header.volumes = SPLint32(volumes);
+	header.offset = SPLint64(offset);
+	header.slope = SPLieee64(get<SPLieee32>(data, 112, swapped));
+	header.intercept = SPLieee64(get<SPLieee32>(data, 116, swapped));
+	header.swapped = swapped;
+	header.pair = !single;
+	return !single || header.offset >= 348;
+}
+
+/*! \fn bool splReadNIfTIHeader(const char *path, SPLNIfTIHeader &header)
+ * \brief Reads the header of a NIfTI-1 file!
+ *
+ * E.g. to select the voxel type of a \ref SPLMappedGrid before the file
+ * is mapped.
+ *
+ * \param path The .nii or .hdr file.
+ * \param header The parsed header.
+ *
+ * \return \c true on success and \c false otherwise, e.g. if the voxels
+ * of all volumes do not fit into the file (the .img file of a pair).
+ */
+inline bool splReadNIfTIHeader(const char *path, SPLNIfTIHeader &header) throw()
+{
+	FILE *f = fopen(path, "rb");
+	if (f == 0)
+	{
+		return false;
+	}
+	SPLuint8 data[348];
+	const bool ok = (fread(data, 1, sizeof(data), f) == sizeof(data));
+	fclose(f);
+	if (!ok || !splParseNIfTIHeader(data, SPLint64(sizeof(data)), header))
+	{
+		return false;
+	}
+
+	// the voxels of a pair are in the .img file of the same name
+	std::string file(path);
+	const size_t n = file.size();
+	if (header.pair && n > 4 && file.compare(n - 4, 4, ".hdr") == 0)
+	{
+		file.replace(n - 4, 4, ".img");
+	}
+	const SPLint64 volume = SPLint64(header.size.x) * header.size.y * header.size.z * header.bytes;
+	return header.offset + SPLint64(header.volumes) * volume <= SPLNIfTIDetail::getFileSize(file.c_str());
+}
+
+#endif /* _spl_nifti_hh_ */
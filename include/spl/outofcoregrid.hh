@@ -0,0 +1,1556 @@
+#ifndef _spl_outofcoregrid_hh_
+#define _spl_outofcoregrid_hh_
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>     // for open(), posix_fadvise()
+#include <sys/stat.h>  // for fstat()
+#include <unistd.h>    // for pread(), pwrite(), ftruncate()
+#endif
+
+#include <condition_variable>
+#include <cstring>   // for memcpy(), memset()
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <vector>
+
+#include <spl/typesbase.hh>
+#include <spl/mathbase.hh>
+#include <spl/simd.hh>
+#include <spl/threadpool.hh>
+#include <spl/allocator.hh>
+#include <spl/vector3.hh>
+#include <spl/grid.hh>
+
+/*! \file outofcoregrid.hh
+ * */
+
+template <class T> class SPLOutOfCoreGrid;
+template <class T, class V> class SPLOutOfCoreGridIterator;
+
+/*! \struct SPLOutOfCoreStats
+ * \brief Counters of the brick cache of a \ref SPLOutOfCoreGrid.
+ */
+struct SPLOutOfCoreStats
+{
+	SPLint64 hits;			//!< Bricks which were resident.
+	SPLint64 misses;		//!< Bricks which were read from the file.
+	SPLint64 evictions;		//!< Bricks which were dropped from the cache.
+	SPLint64 writes;		//!< Modified bricks which were written back.
+	SPLint64 errors;		//!< Failed reads and writes.
+
+	/*! \brief Returns the fraction of the accesses to resident bricks!
+	 *
+	 * \return The hit rate in \f$ [0, 1] \f$.
+	 */
+	SPLieee64 getHitRate(void) const throw() { return (hits + misses > 0) ? SPLieee64(hits) / SPLieee64(hits + misses) : 0.0; }
+};
+
+/*! \class SPLOutOfCoreGrid
+ * \brief A bricked grid in a tiled file, paged through a bounded cache.
+ *
+ * For volumes larger than the memory the voxels stay in a file, which
+ * holds the bricks of the \ref SPL_GRID_BRICKED layout of \ref SPLGrid
+ * (Morton order within a brick, bricks x fastest) after a header of 4 kB.
+ * The bricks are read on demand into a cache with a fixed memory budget,
+ * which evicts the least recently used brick and writes it back if it
+ * has been modified. A brick in use is pinned, i.e. it is never evicted.
+ *
+ * The accessor interface matches \ref SPLGrid: \ref getSize,
+ * \ref getBlockCount, \ref getBlock, the voxel access with
+ * \ref operator()() and \ref getClamped, and the iterators over ranges of
+ * blocks with \ref SPLOutOfCoreGridIterator::getPosition and
+ * \ref SPLOutOfCoreGridIterator::getNeighbor. Code which is a template
+ * of the grid type and uses only this interface runs on both grids, and
+ * with one block per task only a few bricks per thread have to be
+ * resident. The algorithms of the library take a \ref SPLGrid and work
+ * on its data and offsets, i.e. they do not run on this grid. They can
+ * be run per brick on the view of \ref Brick::getGrid, without the
+ * neighbors across the faces of the brick.
+ *
+ * The random voxel access of \ref operator()() looks up the brick for
+ * every voxel and takes the lock of the cache once (a resident brick is
+ * not pinned). Loops should use the iterators, an \ref Accessor per
+ * thread (which keeps the last brick without locking), or \ref getBrick.
+ *
+ * \ref prefetch lets the operating system read bricks in the background
+ * before they are needed, e.g. the next bricks along the rays of a ray
+ * caster. The iterators prefetch the next block of their range.
+ *
+ * Example
+ * \code
+ * // a 16 GB volume with a cache of 1 GB
+ * SPLMappedGrid<SPLieee32> raw;
+ * raw.openRAW("ct.raw", SPLVector3i(2048, 2048, 1024));
+ * splWriteOutOfCoreGrid("ct.brk", raw.getGrid(), 32);
+ *
+ * SPLOutOfCoreGrid<SPLieee32> g;
+ * g.open("ct.brk", SPLint64(1) << 30);
+ * SPLThreadPool::getGlobal().parallelFor(0, g.getBlockCount(), 1, [&](const SPLint64 first, const SPLint64 last)
+ * {
+ *     for (SPLOutOfCoreGrid<SPLieee32>::ConstIterator it = g.begin(first, last); it != g.end(first, last); ++it)
+ *     {
+ *         ... it.getNeighbor(-1, 0, 0) ...
+ *     }
+ * });
+ * \endcode
+ *
+ * The file is stored in the byte order of the host.
+ *
+ * \sa SPLGrid SPLOutOfCoreGridIterator
+ */
+template <class T>
+class SPLOutOfCoreGrid
+{
+private:
+	struct Slot;
+
+public:
+	typedef SPLOutOfCoreGridIterator<T, T> Iterator;			//!< Iterator over writable voxels.
+	typedef SPLOutOfCoreGridIterator<T, const T> ConstIterator;	//!< Iterator over read-only voxels.
+
+	/*! \class Brick
+	 * \brief A pinned brick of the cache.
+	 *
+	 * The brick stays resident as long as a handle refers to it.
+	 */
+	class Brick
+	{
+	public:
+		/*! \brief Constructor!
+		 *
+		 * Initializes an invalid handle.
+		 */
+		Brick(void) throw() : grid(0), slot(-1), entry(0) {}
+
+		/*! \brief Constructor!
+		 *
+		 * Pins the brick of another handle again.
+		 *
+		 * \param b Another handle.
+		 */
+		Brick(const Brick &b) throw();
+
+		/*! \brief Constructor!
+		 *
+		 * Takes over the pin of another handle.
+		 *
+		 * \param b Another handle, which becomes invalid.
+		 */
+		Brick(Brick &&b) throw() : grid(b.grid), slot(b.slot), entry(b.entry) { b.slot = -1; }
+
+		/*! \brief Destructor!
+		 *
+		 * Unpins the brick.
+		 */
+		~Brick(void) throw() { if (this->slot >= 0) { this->release(); } }
+
+		/*! \brief Assignment operator!
+		 *
+		 * \param b Another handle.
+		 *
+		 * \return Reference of this handle.
+		 */
+		Brick& operator = (const Brick &b) throw();
+
+		/*! \brief Move assignment operator!
+		 *
+		 * \param b Another handle, which becomes invalid.
+		 *
+		 * \return Reference of this handle.
+		 */
+		Brick& operator = (Brick &&b) throw();
+
+		/*! \brief Unpins the brick!
+		 *
+		 * The handle becomes invalid.
+		 */
+		void release(void) throw();
+
+		/*! \brief Returns whether the handle refers to a brick!
+		 *
+		 * \return \c true if the brick is pinned.
+		 */
+		bool isValid(void) const throw() { return this->slot >= 0; }
+
+		/*! \brief Returns the index of the brick!
+		 *
+		 * \return The block index, or \f$ -1 \f$ for an invalid handle.
+		 */
+		SPLint64 getIndex(void) const throw();
+
+		/*! \brief Returns the voxels of the brick!
+		 *
+		 * The voxels must only be modified if the brick has been pinned for writing.
+		 *
+		 * \return Pointer to \f$ B^3 \f$ voxels in Morton order.
+		 */
+		T* getData(void) const throw();
+
+		/*! \brief Returns the brick as a grid!
+		 *
+		 * \return A grid with external memory of the size of the block,
+		 * see \ref SPLOutOfCoreGrid::getBlock.
+		 */
+		SPLGrid<T>& getGrid(void) const throw();
+
+	private:
+		friend class SPLOutOfCoreGrid<T>;
+
+		Brick(const SPLOutOfCoreGrid<T> *grid, const SPLint32 slot, Slot *entry) throw() : grid(grid), slot(slot), entry(entry) {}
+
+		const SPLOutOfCoreGrid<T> *grid;	//!< The grid.
+		SPLint32 slot;						//!< Pinned slot of the cache, or -1.
+		Slot *entry;						//!< The pinned slot.
+	};
+
+	/*! \class Accessor
+	 * \brief Random voxel access, which keeps the last brick pinned.
+	 *
+	 * An accessor must only be used by one thread.
+	 */
+	class Accessor
+	{
+	public:
+		/*! \brief Constructor!
+		 *
+		 * \param grid The grid.
+		 * \param write Pins the bricks for writing, see \ref set.
+		 */
+		explicit Accessor(const SPLOutOfCoreGrid<T> &grid, const bool write = false) throw() : grid(&grid), write(write) {}
+
+		/*! \brief Returns a voxel!
+		 *
+		 * \param x Coordinate in \f$ [0, n_x) \f$.
+		 * \param y Coordinate in \f$ [0, n_y) \f$.
+		 * \param z Coordinate in \f$ [0, n_z) \f$.
+		 *
+		 * \return The value, or \c T() if the brick cannot be read.
+		 */
+		T get(const SPLindex x, const SPLindex y, const SPLindex z) throw();
+
+		/*! \brief Returns a voxel, clamped to the border!
+		 *
+		 * \param x Any coordinate.
+		 * \param y Any coordinate.
+		 * \param z Any coordinate.
+		 *
+		 * \return The value of the nearest voxel inside the grid.
+		 */
+		T getClamped(const SPLindex x, const SPLindex y, const SPLindex z) throw();
+
+		/*! \brief Sets a voxel!
+		 *
+		 * Requires an accessor for writing.
+		 *
+		 * \param x Coordinate in \f$ [0, n_x) \f$.
+		 * \param y Coordinate in \f$ [0, n_y) \f$.
+		 * \param z Coordinate in \f$ [0, n_z) \f$.
+		 * \param v The value.
+		 *
+		 * \return \c true on success and \c false if the brick cannot be read.
+		 */
+		bool set(const SPLindex x, const SPLindex y, const SPLindex z, const T &v) throw();
+
+		/*! \brief Unpins the last brick!
+		 */
+		void release(void) throw() { this->brick.release(); }
+
+	private:
+		T* find(const SPLindex x, const SPLindex y, const SPLindex z) throw();
+
+		const SPLOutOfCoreGrid<T> *grid;	//!< The grid.
+		bool write;							//!< Set if the bricks are pinned for writing.
+		Brick brick;						//!< The last brick.
+	};
+
+	/*! \brief Constructor!
+	 *
+	 * Initializes a closed grid.
+	 */
+	SPLOutOfCoreGrid(void) throw();
+
+	/*! \brief Destructor!
+	 *
+	 * Writes the modified bricks back and closes the file.
+	 */
+	~SPLOutOfCoreGrid(void) throw() { this->close(); }
+
+	/*! \brief Creates a new file!
+	 *
+	 * All voxels are zero. The file is writable.
+	 *
+	 * \param path The file.
+	 * \param size Number of voxels along x, y and z.
+	 * \param brick Edge length of the bricks, a power of 2 in \f$ [2, 1024] \f$.
+	 * \param budget Memory of the cache in bytes.
+	 *
+	 * \return \c true on success and \c false otherwise.
+	 */
+	bool create(const char *path, const SPLVector3i &size, const SPLsizei brick = 32, const SPLint64 budget = SPLint64(256) << 20) throw();
+
+	/*! \brief Opens a file!
+	 *
+	 * \param path The file, see \ref splWriteOutOfCoreGrid.
+	 * \param budget Memory of the cache in bytes.
+	 * \param writable Set to modify the voxels.
+	 *
+	 * \return \c true on success and \c false otherwise, e.g. if the voxel
+	 * type of the file differs from \c T.
+	 */
+	bool open(const char *path, const SPLint64 budget = SPLint64(256) << 20, const bool writable = false) throw();
+
+	/*! \brief Writes all modified bricks back!
+	 *
+	 * \return \c true on success and \c false if a read or write has failed.
+	 */
+	bool flush(void) throw();
+
+	/*! \brief Closes the file!
+	 *
+	 * All handles of bricks must be released before.
+	 *
+	 * \return \c true on success and \c false if a read or write has failed.
+	 */
+	bool close(void) throw();
+
+	/*! \brief Returns whether a file is open!
+	 *
+	 * \return \c true if a file is open.
+	 */
+	bool isOpen(void) const throw() { return !this->slots.empty(); }
+
+	/*! \brief Returns whether the voxels may be modified!
+	 *
+	 * \return \c true if the file has been created or opened for writing.
+	 */
+	bool isWritable(void) const throw() { return this->writable; }
+
+	/*! \brief Returns the identification number of the voxel type!
+	 *
+	 * \return The \c SPL_TYPE_* constant of \c T, see \ref SPLTypeId.
+	 */
+	static SPLenum getType(void) throw() { return SPLTypeId<T>::value; }
+
+	/*! \brief Returns the number of voxels along x, y and z!
+	 *
+	 * \return The size.
+	 */
+	const SPLVector3i& getSize(void) const throw() { return this->size; }
+
+	/*! \brief Returns the memory layout!
+	 *
+	 * \return \ref SPL_GRID_BRICKED.
+	 */
+	SPLenum getLayout(void) const throw() { return SPL_GRID_BRICKED; }
+
+	/*! \brief Returns the edge length of the bricks!
+	 *
+	 * \return The edge length.
+	 */
+	SPLsizei getBrickSize(void) const throw() { return this->brick; }
+
+	/*! \brief Returns the number of bricks the cache holds!
+	 *
+	 * The budget divided by the bytes per brick, at least one brick. The
+	 * cache only grows beyond if all of its bricks are pinned at the same
+	 * time, see \ref getBrick.
+	 *
+	 * \return Number of bricks.
+	 */
+	SPLsizei getCapacity(void) const throw();
+
+	/*! \brief Returns the counters of the cache!
+	 *
+	 * \return The counters since opening the file or \ref resetStats.
+	 */
+	SPLOutOfCoreStats getStats(void) const throw();
+
+	/*! \brief Resets the counters of the cache!
+	 */
+	void resetStats(void) throw();
+
+	/*! \brief Returns the number of blocks (bricks)!
+	 *
+	 * \return Number of blocks.
+	 */
+	SPLsizei getBlockCount(void) const throw() { return this->blocks; }
+
+	/*! \brief Returns the voxels of a block!
+	 *
+	 * \param b Index of the block in \f$ [0, \f$ \ref getBlockCount \f$ ) \f$.
+	 * \param lo First voxel of the block.
+	 * \param hi Last voxel of the block plus one.
+	 */
+	void getBlock(const SPLindex b, SPLVector3i &lo, SPLVector3i &hi) const throw();
+
+	/*! \brief Returns the block of a voxel!
+	 *
+	 * \param x Coordinate in \f$ [0, n_x) \f$.
+	 * \param y Coordinate in \f$ [0, n_y) \f$.
+	 * \param z Coordinate in \f$ [0, n_z) \f$.
+	 *
+	 * \return Index of the block.
+	 */
+	SPLindex getBlockIndex(const SPLindex x, const SPLindex y, const SPLindex z) const throw();
+
+	/*! \brief Pins a brick!
+	 *
+	 * The brick is read if it is not resident. If all bricks of the cache
+	 * are pinned, the cache grows beyond the budget, i.e. a thread never
+	 * waits for the pins of other threads. A modified brick which is
+	 * evicted is written back before the brick is read, without holding
+	 * the lock of the cache.
+	 *
+	 * \param b Index of the block.
+	 * \param write Set to modify the voxels (requires a writable file).
+	 *
+	 * \return A handle of the brick, which is invalid if the brick cannot be read.
+	 */
+	Brick getBrick(const SPLindex b, const bool write = false) const throw();
+
+	/*! \brief Reads blocks in the background!
+	 *
+	 * A hint for the operating system, the call does not wait.
+	 *
+	 * \param first Index of the first block.
+	 * \param last Index of the last block plus one.
+	 *
+	 * \return \c true on success and \c false otherwise.
+	 */
+	bool prefetch(const SPLint64 first, const SPLint64 last) const throw();
+
+	/*! \brief Reads the blocks of a box in the background!
+	 *
+	 * \param lo First voxel of the box.
+	 * \param hi Last voxel of the box plus one.
+	 *
+	 * \return \c true on success and \c false otherwise.
+	 */
+	bool prefetch(const SPLVector3i &lo, const SPLVector3i &hi) const throw();
+
+	/*! \brief Access operator!
+	 *
+	 * \param x Coordinate in \f$ [0, n_x) \f$.
+	 * \param y Coordinate in \f$ [0, n_y) \f$.
+	 * \param z Coordinate in \f$ [0, n_z) \f$.
+	 *
+	 * \return The value of a voxel.
+	 */
+	T operator () (const SPLindex x, const SPLindex y, const SPLindex z) const throw() { return this->load(x, y, z); }
+
+	/*! \brief Access operator!
+	 *
+	 * \param p Coordinates of a voxel.
+	 *
+	 * \return The value of a voxel.
+	 */
+	T operator [] (const SPLVector3i &p) const throw() { return this->load(p.x, p.y, p.z); }
+
+	/*! \brief Returns a voxel, clamped to the border!
+	 *
+	 * \param x Any coordinate.
+	 * \param y Any coordinate.
+	 * \param z Any coordinate.
+	 *
+	 * \return The value of the nearest voxel inside the grid.
+	 */
+	T getClamped(const SPLindex x, const SPLindex y, const SPLindex z) const throw()
+	{
+		return this->load(CLAMP(x, 0, this->size.x - 1), CLAMP(y, 0, this->size.y - 1), CLAMP(z, 0, this->size.z - 1));
+	}
+
+	/*! \brief Sets a voxel!
+	 *
+	 * \param x Coordinate in \f$ [0, n_x) \f$.
+	 * \param y Coordinate in \f$ [0, n_y) \f$.
+	 * \param z Coordinate in \f$ [0, n_z) \f$.
+	 * \param v The value.
+	 *
+	 * \return \c true on success and \c false otherwise.
+	 */
+	bool set(const SPLindex x, const SPLindex y, const SPLindex z, const T &v) throw();
+
+	/*! \brief Returns an iterator to the first voxel!
+	 *
+	 * \return Iterator over all voxels, block by block.
+	 */
+	Iterator begin(void) throw() { return Iterator(this, 0, this->blocks); }
+
+	/*! \brief Returns an iterator past the last voxel!
+	 *
+	 * \return End iterator of \ref begin(void).
+	 */
+	Iterator end(void) throw() { return Iterator(this, this->blocks, this->blocks); }
+
+	/*! \brief Returns an iterator to the first voxel!
+	 *
+	 * \return Iterator over all voxels, block by block.
+	 */
+	ConstIterator begin(void) const throw() { return ConstIterator(this, 0, this->blocks); }
+
+	/*! \brief Returns an iterator past the last voxel!
+	 *
+	 * \return End iterator of \ref begin(void) const.
+	 */
+	ConstIterator end(void) const throw() { return ConstIterator(this, this->blocks, this->blocks); }
+
+	/*! \brief Returns an iterator to the first voxel of a range of blocks!
+	 *
+	 * \param first Index of the first block.
+	 * \param last Index of the last block plus one.
+	 *
+	 * \return Iterator over the voxels of the blocks \f$ [first, last) \f$.
+	 */
+	Iterator begin(const SPLint64 first, const SPLint64 last) throw() { return Iterator(this, SPLindex(first), SPLindex(last)); }
+
+	/*! \brief Returns an iterator past the last voxel of a range of blocks!
+	 *
+	 * \param first Index of the first block.
+	 * \param last Index of the last block plus one.
+	 *
+	 * \return End iterator of \ref begin(const SPLint64, const SPLint64).
+	 */
+	Iterator end(const SPLint64 first, const SPLint64 last) throw() { (void)first; return Iterator(this, SPLindex(last), SPLindex(last)); }
+
+	/*! \brief Returns an iterator to the first voxel of a range of blocks!
+	 *
+	 * \param first Index of the first block.
+	 * \param last Index of the last block plus one.
+	 *
+	 * \return Iterator over the voxels of the blocks \f$ [first, last) \f$.
+	 */
+	ConstIterator begin(const SPLint64 first, const SPLint64 last) const throw() { return ConstIterator(this, SPLindex(first), SPLindex(last)); }
+
+	/*! \brief Returns an iterator past the last voxel of a range of blocks!
+	 *
+	 * \param first Index of the first block.
+	 * \param last Index of the last block plus one.
+	 *
+	 * \return End iterator of \ref begin(const SPLint64, const SPLint64) const.
+	 */
+	ConstIterator end(const SPLint64 first, const SPLint64 last) const throw() { (void)first; return ConstIterator(this, SPLindex(last), SPLindex(last)); }
+
+private:
+	template <class, class> friend class SPLOutOfCoreGridIterator;
+
+	SPLOutOfCoreGrid(const SPLOutOfCoreGrid<T> &);
+	SPLOutOfCoreGrid<T>& operator = (const SPLOutOfCoreGrid<T> &);
+
+	//! A brick of the cache.
+	struct Slot
+	{
+		T *data;			//!< The voxels.
+		SPLGrid<T> view;	//!< Grid onto the voxels.
+		SPLint64 block;		//!< Index of the brick, or -1.
+		SPLint32 pins;		//!< Number of handles.
+		bool dirty;			//!< Set if the brick has been pinned for writing.
+		bool ready;			//!< Cleared while the brick is read.
+		SPLint32 prev;		//!< Next more recently used slot.
+		SPLint32 next;		//!< Next less recently used slot.
+	};
+
+	bool setup(const SPLVector3i &size, const SPLsizei brick, const SPLint64 budget) throw();
+	void grow(void) const throw();
+	SPLint32 pin(const SPLindex b, const bool write, Slot *&entry) const throw();
+	void repin(const SPLint32 s) const throw();
+	void unpin(const SPLint32 s) const throw();
+	void link(const SPLint32 s) const throw();
+	void unlink(const SPLint32 s) const throw();
+	bool store(const Slot &slot) const throw();
+	SPLint32 touch(const SPLindex b) const throw();
+	T load(const SPLindex x, const SPLindex y, const SPLindex z) const throw();
+	SPLint64 getLocal(const SPLindex x, const SPLindex y, const SPLindex z) const throw();
+	SPLint64 getPosition(const SPLint64 b) const throw() { return 4096 + b * this->bytes; }
+
+	bool readFile(const SPLint64 offset, const SPLint64 bytes, void *dst) const throw();
+	bool writeFile(const SPLint64 offset, const SPLint64 bytes, const void *src) const throw();
+	bool adviseFile(const SPLint64 offset, const SPLint64 bytes) const throw();
+	void closeFile(void) throw();
+
+	SPLVector3i size;		//!< Number of voxels along x, y and z.
+	SPLsizei brick;			//!< Edge length of the bricks.
+	SPLindex shift;			//!< \f$ \log_2 \f$ of the edge length.
+	SPLVector3i bricks;		//!< Number of bricks along x, y and z.
+	SPLsizei blocks;		//!< Number of bricks.
+	SPLint64 bytes;			//!< Bytes per brick.
+	bool writable;			//!< Set if the voxels may be modified.
+	std::vector<SPLint64> local[3];		//!< Per-axis offsets within a brick.
+#ifdef _WIN32
+	HANDLE file;			//!< The file.
+#else
+	int file;				//!< The file.
+#endif
+
+	mutable std::mutex mutex;					//!< Guards the cache.
+	mutable std::condition_variable changed;	//!< Signals read bricks.
+	mutable std::vector<std::unique_ptr<Slot> > slots;	//!< The cached bricks.
+	mutable std::vector<SPLint32> table;		//!< Slot of every brick, or -1.
+	mutable std::vector<SPLint32> unused;		//!< Slots without a brick.
+	mutable SPLint32 head;						//!< Most recently used unpinned slot.
+	mutable SPLint32 tail;						//!< Least recently used unpinned slot.
+	mutable SPLOutOfCoreStats stats;			//!< Counters.
+};
+
+/*! \class SPLOutOfCoreGridIterator
+ * \brief Iterator over the voxels of a \ref SPLOutOfCoreGrid.
+ *
+ * The voxels are visited brick by brick as with \ref SPLGridIterator.
+ * The current brick is pinned and the next block of the range is
+ * prefetched. Neighbors inside the current brick are read directly,
+ * the others through an \ref SPLOutOfCoreGrid::Accessor.
+ *
+ * \sa SPLOutOfCoreGrid
+ */
+template <class T, class V>
+class SPLOutOfCoreGridIterator
+{
+public:
+	/*! \brief Constructor!
+	 *
+	 * \param grid The grid.
+	 * \param block Index of the first block.
+	 * \param last Index of the last block plus one.
+	 */
+	SPLOutOfCoreGridIterator(const SPLOutOfCoreGrid<T> *grid, const SPLindex block, const SPLindex last) throw();
+
+	/*! \brief Dereference operator!
+	 *
+	 * \return Reference of the current voxel.
+	 */
+	V& operator * (void) const throw() { return this->data[this->lx[this->pos.x - this->lo.x] + this->row]; }
+
+	/*! \brief Returns a neighbor of the current voxel!
+	 *
+	 * \param dx Offset along x in \f$ [-1, 1] \f$.
+	 * \param dy Offset along y in \f$ [-1, 1] \f$.
+	 * \param dz Offset along z in \f$ [-1, 1] \f$.
+	 *
+	 * \return The value of the neighbor, clamped to the border of the grid.
+	 */
+	T getNeighbor(const SPLindex dx, const SPLindex dy, const SPLindex dz) const throw();
+
+	/*! \brief Returns the coordinates of the current voxel!
+	 *
+	 * \return The position.
+	 */
+	const SPLVector3i& getPosition(void) const throw() { return this->pos; }
+
+	/*! \brief Returns the current block!
+	 *
+	 * \return Index of the block.
+	 */
+	SPLindex getBlock(void) const throw() { return this->block; }
+
+	/*! \brief Increment operator!
+	 *
+	 * \return Reference of this iterator.
+	 */
+	SPLOutOfCoreGridIterator<T, V>& operator ++ (void) throw();
+
+	/*! \brief Equal operator!
+	 *
+	 * \param it Another iterator.
+	 *
+	 * \return \c true if both iterators point to the same voxel.
+	 */
+	bool operator == (const SPLOutOfCoreGridIterator<T, V> &it) const throw() { return this->block == it.block && this->pos == it.pos; }
+
+	/*! \brief Not equal operator!
+	 *
+	 * \param it Another iterator.
+	 *
+	 * \return \c true if the iterators point to different voxels.
+	 */
+	bool operator != (const SPLOutOfCoreGridIterator<T, V> &it) const throw() { return !(*this == it); }
+
+private:
+	void setBlock(void) throw();
+
+	const SPLOutOfCoreGrid<T> *grid;	//!< The grid.
+	typename SPLOutOfCoreGrid<T>::Brick brick;	//!< The current brick.
+	mutable typename SPLOutOfCoreGrid<T>::Accessor neighbors;	//!< Neighbors in other bricks.
+	V *data;							//!< Voxels of the current brick.
+	const SPLint64 *lx;					//!< Offsets within a brick along x.
+	const SPLint64 *ly;					//!< Offsets within a brick along y.
+	const SPLint64 *lz;					//!< Offsets within a brick along z.
+	SPLindex block;						//!< Current block.
+	SPLindex last;						//!< Last block plus one.
+	SPLVector3i lo;						//!< First voxel of the current block.
+	SPLVector3i hi;						//!< Last voxel of the current block plus one.
+	SPLVector3i pos;					//!< Current voxel.
+	SPLint64 row;						//!< Offset of the current row within the brick.
+};
+
+/*! \brief Writes a grid into a tiled file!
+ *
+ * The grid may use any layout, e.g. a memory mapped RAW file (see
+ * \ref SPLMappedGrid), which is read brick by brick.
+ *
+ * \param path The file.
+ * \param grid The grid.
+ * \param brick Edge length of the bricks, a power of 2 in \f$ [2, 1024] \f$.
+ * \param pool The threads.
+ *
+ * \return \c true on success and \c false otherwise.
+ *
+ * \sa SPLOutOfCoreGrid
+ */
+template <class T>
+bool splWriteOutOfCoreGrid(const char *path, const SPLGrid<T> &grid, const SPLsizei brick = 32, SPLThreadPool &pool = SPLThreadPool::getGlobal()) throw();
+
+namespace SPLOutOfCoreDetail
+{
+	//! The header at the beginning of a tiled file (4 kB).
+	struct Header
+	{
+		char magic[8];		//!< "SPLBRICK".
+		SPLint32 version;	//!< Version of the format.
+		SPLint32 type;		//!< \c SPL_TYPE_* constant of the voxels.
+		SPLint32 bytes;		//!< Bytes per voxel.
+		SPLint32 size[3];	//!< Number of voxels along x, y and z.
+		SPLint32 brick;		//!< Edge length of the bricks.
+	};
+
+	static const char MAGIC[8] = { 'S', 'P', 'L', 'B', 'R', 'I', 'C', 'K' };
+}
+
+/************************************************************************************************
+ ** SPLOutOfCoreGrid class implementation
+ ************************************************************************************************/
+template <class T>
+SPLOutOfCoreGrid<T>::SPLOutOfCoreGrid(void) throw()
+{
+#ifdef _WIN32
+	this->file = INVALID_HANDLE_VALUE;
+#else
+	this->file = -1;
+#endif
+	this->writable = false;
+	this->setup(SPLVector3i(0, 0, 0), 2, 0);
+}
+
+template <class T>
+bool SPLOutOfCoreGrid<T>::create(const char *path, const SPLVector3i &size, const SPLsizei brick, const SPLint64 budget) throw()
+{
+	this->close();
+	if (SPLGrid<T>::getStorageSize(size, SPL_GRID_BRICKED, brick) < 0)
+	{
+		return false;
+	}
+#ifdef _WIN32
+	this->file = CreateFileA(path, GENERIC_READ | GENERIC_WRITE, 0, 0, CREATE_ALWAYS, FILE_FLAG_RANDOM_ACCESS, 0);
+	if (this->file == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+#else
+	this->file = ::open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (this->file < 0)
+	{
+		return false;
+	}
+#endif
+	SPLOutOfCoreDetail::Header h;
+	memset(&h, 0, sizeof(h));
+	memcpy(h.magic, SPLOutOfCoreDetail::MAGIC, sizeof(h.magic));
+	h.version = 1;
+	h.type = SPLint32(getType());
+	h.bytes = SPLint32(sizeof(T));
+	h.size[0] = size.x;
+	h.size[1] = size.y;
+	h.size[2] = size.z;
+	h.brick = brick;
+	this->writable = true;
+	this->setup(size, brick, budget);
+
+	// the bricks of zeros are sparse
+	const SPLint64 total = this->getPosition(this->blocks);
+	bool ok = this->writeFile(0, sizeof(h), &h);
+#ifdef _WIN32
+	LARGE_INTEGER end;
+	end.QuadPart = total;
+	ok = ok && SetFilePointerEx(this->file, end, 0, FILE_BEGIN) && SetEndOfFile(this->file);
+#else
+	ok = ok && ftruncate(this->file, off_t(total)) == 0;
+#endif
+	if (!ok)
+	{
+		this->close();
+	}
+	return ok;
+}
+
+template <class T>
+bool SPLOutOfCoreGrid<T>::open(const char *path, const SPLint64 budget, const bool writable) throw()
+{
+	this->close();
+#ifdef _WIN32
+	this->file = CreateFileA(path, writable ? (GENERIC_READ | GENERIC_WRITE) : GENERIC_READ, writable ? 0 : FILE_SHARE_READ,
+		0, OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, 0);
+	LARGE_INTEGER length;
+	if (this->file == INVALID_HANDLE_VALUE || !GetFileSizeEx(this->file, &length))
+	{
+		this->closeFile();
+		return false;
+	}
+	const SPLint64 total = SPLint64(length.QuadPart);
+#else
+	this->file = ::open(path, writable ? O_RDWR : O_RDONLY);
+	struct stat st;
+	if (this->file < 0 || fstat(this->file, &st) != 0)
+	{
+		this->closeFile();
+		return false;
+	}
+	const SPLint64 total = SPLint64(st.st_size);
+#endif
+	SPLOutOfCoreDetail::Header h;
+	if (!this->readFile(0, sizeof(h), &h) || memcmp(h.magic, SPLOutOfCoreDetail::MAGIC, sizeof(h.magic)) != 0 || h.version != 1 ||
+		h.type != SPLint32(getType()) || h.bytes != SPLint32(sizeof(T)) ||
+		SPLGrid<T>::getStorageSize(SPLVector3i(h.size[0], h.size[1], h.size[2]), SPL_GRID_BRICKED, h.brick) < 0)
+	{
+		this->closeFile();
+		return false;
+	}
+	this->writable = writable;
+	this->setup(SPLVector3i(h.size[0], h.size[1], h.size[2]), h.brick, budget);
+	if (total < this->getPosition(this->blocks))
+	{
+		this->close();
+		return false;
+	}
+	return true;
+}
+
+template <class T>
+bool SPLOutOfCoreGrid<T>::flush(void) throw()
+{
+	std::unique_lock<std::mutex> lock(this->mutex);
+	for (size_t s = 0; s < this->slots.size(); s++)
+	{
+		// a slot in flight writes back its evicted brick
+		Slot &slot = *this->slots[s];
+		while (!slot.ready)
+		{
+			this->changed.wait(lock);
+		}
+		if (slot.dirty && slot.block >= 0)
+		{
+			this->store(slot);
+			slot.dirty = (slot.pins > 0);
+		}
+	}
+	return this->stats.errors == 0;
+}
+
+template <class T>
+bool SPLOutOfCoreGrid<T>::close(void) throw()
+{
+	const bool ok = !this->isOpen() || this->flush();
+	for (size_t s = 0; s < this->slots.size(); s++)
+	{
+		assert(this->slots[s]->pins == 0);
+		splMemoryFree(this->slots[s]->data);
+	}
+	this->closeFile();
+	this->writable = false;
+	this->setup(SPLVector3i(0, 0, 0), 2, 0);
+	return ok;
+}
+
+template <class T>
+SPLOutOfCoreStats SPLOutOfCoreGrid<T>::getStats(void) const throw()
+{
+	std::lock_guard<std::mutex> lock(this->mutex);
+	return this->stats;
+}
+
+template <class T>
+void SPLOutOfCoreGrid<T>::resetStats(void) throw()
+{
+	std::lock_guard<std::mutex> lock(this->mutex);
+	memset(&this->stats, 0, sizeof(this->stats));
+}
+
+template <class T>
+void SPLOutOfCoreGrid<T>::getBlock(const SPLindex b, SPLVector3i &lo, SPLVector3i &hi) const throw()
+{
+	assert(b >= 0 && b < this->blocks);
+	const SPLindex bx = b % this->bricks.x, by = (b / this->bricks.x) % this->bricks.y, bz = b / (this->bricks.x * this->bricks.y);
+	lo = SPLVector3i(bx << this->shift, by << this->shift, bz << this->shift);
+	hi = SPLVector3i(MIN(lo.x + this->brick, this->size.x), MIN(lo.y + this->brick, this->size.y), MIN(lo.z + this->brick, this->size.z));
+}
+
+template <class T>
+SPLindex SPLOutOfCoreGrid<T>::getBlockIndex(const SPLindex x, const SPLindex y, const SPLindex z) const throw()
+{
+	assert(x >= 0 && x < this->size.x && y >= 0 && y < this->size.y && z >= 0 && z < this->size.z);
+	return (x >> this->shift) + this->bricks.x * ((y >> this->shift) + this->bricks.y * (z >> this->shift));
+}
+
+template <class T>
+typename SPLOutOfCoreGrid<T>::Brick SPLOutOfCoreGrid<T>::getBrick(const SPLindex b, const bool write) const throw()
+{
+	assert(b >= 0 && b < this->blocks && (this->writable || !write));
+	Slot *entry = 0;
+	const SPLint32 s = this->pin(b, write, entry);
+	return Brick(this, s, entry);
+}
+
+template <class T>
+bool SPLOutOfCoreGrid<T>::prefetch(const SPLint64 first, const SPLint64 last) const throw()
+{
+	const SPLint64 a = MAX(first, SPLint64(0)), b = MIN(last, SPLint64(this->blocks));
+	if (a >= b)
+	{
+		return a == b;
+	}
+	// the bricks of a range are contiguous in the file
+	return this->adviseFile(this->getPosition(a), (b - a) * this->bytes);
+}
+
+template <class T>
+bool SPLOutOfCoreGrid<T>::prefetch(const SPLVector3i &lo, const SPLVector3i &hi) const throw()
+{
+	const SPLVector3i a(MAX(lo.x, 0), MAX(lo.y, 0), MAX(lo.z, 0));
+	const SPLVector3i b(MIN(hi.x, this->size.x), MIN(hi.y, this->size.y), MIN(hi.z, this->size.z));
+	if (a.x >= b.x || a.y >= b.y || a.z >= b.z)
+	{
+		return true;
+	}
+	bool ok = true;
+	for (SPLindex z = a.z >> this->shift; z <= (b.z - 1) >> this->shift; z++)
+	{
+		for (SPLindex y = a.y >> this->shift; y <= (b.y - 1) >> this->shift; y++)
+		{
+			// one run of bricks along x
+			const SPLint64 row = SPLint64(this->bricks.x) * (y + SPLint64(this->bricks.y) * z);
+			ok = this->prefetch(row + (a.x >> this->shift), row + ((b.x - 1) >> this->shift) + 1) && ok;
+		}
+	}
+	return ok;
+}
+
+template <class T>
+bool SPLOutOfCoreGrid<T>::setup(const SPLVector3i &size, const SPLsizei brick, const SPLint64 budget) throw()
+{
+	this->size = size;
+	this->brick = brick;
+	this->shift = SPLGridDetail::log2(brick);
+	this->bricks = SPLVector3i((size.x + brick - 1) / brick, (size.y + brick - 1) / brick, (size.z + brick - 1) / brick);
+	const bool empty = (size.x == 0 || size.y == 0 || size.z == 0);
+	this->blocks = empty ? 0 : this->bricks.x * this->bricks.y * this->bricks.z;
+	this->bytes = (SPLint64(1) << (3 * this->shift)) * SPLint64(sizeof(T));
+	for (SPLindex a = 0; a < 3; a++)
+	{
+		this->local[a].resize(size_t(brick));
+		for (SPLindex c = 0; c < brick; c++)
+		{
+			this->local[a][size_t(c)] = SPLGridDetail::spread(c) << a;
+		}
+	}
+
+	// more bricks are only added while all are pinned, see pin()
+	const SPLint64 capacity = (budget > 0 && this->blocks > 0) ? MIN(MAX(budget / this->bytes, SPLint64(1)), SPLint64(this->blocks)) : 0;
+	this->slots.clear();
+	this->unused.clear();
+	for (SPLint64 s = 0; s < capacity; s++)
+	{
+		this->grow();
+	}
+	this->table.assign(size_t(this->blocks), -1);
+	this->head = this->tail = -1;
+	memset(&this->stats, 0, sizeof(this->stats));
+	return true;
+}
+
+template <class T>
+SPLsizei SPLOutOfCoreGrid<T>::getCapacity(void) const throw()
+{
+	std::lock_guard<std::mutex> lock(this->mutex);
+	return SPLsizei(this->slots.size());
+}
+
+template <class T>
+void SPLOutOfCoreGrid<T>::grow(void) const throw()
+{
+	std::unique_ptr<Slot> slot(new Slot);
+	slot->data = (T *)splMemoryAlloc(this->bytes);
+	slot->block = -1;
+	slot->pins = 0;
+	slot->dirty = false;
+	slot->ready = true;
+	slot->prev = slot->next = -1;
+	this->unused.push_back(SPLint32(this->slots.size()));
+	this->slots.push_back(std::move(slot));
+}
+
+template <class T>
+SPLint32 SPLOutOfCoreGrid<T>::pin(const SPLindex b, const bool write, Slot *&entry) const throw()
+{
+	std::unique_lock<std::mutex> lock(this->mutex);
+	for (;;)
+	{
+		SPLint32 s = this->table[size_t(b)];
+		if (s >= 0)
+		{
+			Slot &slot = *this->slots[size_t(s)];
+			if (!slot.ready)
+			{
+				// another thread reads the brick
+				this->changed.wait(lock);
+				continue;
+			}
+			if (slot.pins++ == 0)
+			{
+				this->unlink(s);
+			}
+			slot.dirty = slot.dirty || write;
+			this->stats.hits++;
+			entry = &slot;
+			return s;
+		}
+
+		// an unused slot, the least recently used brick, or a new slot if all are pinned
+		if (this->unused.empty() && this->tail < 0)
+		{
+			this->grow();
+		}
+		if (!this->unused.empty())
+		{
+			s = this->unused.back();
+			this->unused.pop_back();
+		}
+		else
+		{
+			s = this->tail;
+			this->unlink(s);
+		}
+		Slot &slot = *this->slots[size_t(s)];
+		SPLint64 evicted = -1;
+		if (slot.block >= 0)
+		{
+			// a modified brick stays in the table until it is written back, i.e. its readers wait
+			if (slot.dirty)
+			{
+				evicted = slot.block;
+			}
+			else
+			{
+				this->table[size_t(slot.block)] = -1;
+			}
+			this->stats.evictions++;
+		}
+		slot.block = b;
+		slot.pins = 1;
+		slot.dirty = write;
+		slot.ready = false;
+		this->table[size_t(b)] = s;
+		this->stats.misses++;
+
+		// other bricks are accessible while writing and reading
+		lock.unlock();
+		const bool stored = (evicted < 0) || this->writeFile(this->getPosition(evicted), this->bytes, slot.data);
+		SPLVector3i lo, hi;
+		this->getBlock(b, lo, hi);
+		const bool ok = this->readFile(this->getPosition(b), this->bytes, slot.data) &&
+			slot.view.setExternal(slot.data, hi - lo, SPL_GRID_BRICKED, this->brick);
+		lock.lock();
+		if (evicted >= 0)
+		{
+			this->table[size_t(evicted)] = -1;
+			this->stats.writes++;
+			if (!stored)
+			{
+				this->stats.errors++;
+			}
+		}
+		slot.ready = true;
+		if (!ok)
+		{
+			this->table[size_t(b)] = -1;
+			slot.block = -1;
+			slot.pins = 0;
+			slot.dirty = false;
+			this->unused.push_back(s);
+			this->stats.errors++;
+			s = -1;
+		}
+		this->changed.notify_all();
+		entry = (s >= 0) ? &slot : 0;
+		return s;
+	}
+}
+
+template <class T>
+void SPLOutOfCoreGrid<T>::repin(const SPLint32 s) const throw()
+{
+	std::lock_guard<std::mutex> lock(this->mutex);
+	assert(this->slots[size_t(s)]->pins > 0);
+	this->slots[size_t(s)]->pins++;
+}
+
+template <class T>
+void SPLOutOfCoreGrid<T>::unpin(const SPLint32 s) const throw()
+{
+	std::lock_guard<std::mutex> lock(this->mutex);
+	Slot &slot = *this->slots[size_t(s)];
+	assert(slot.pins > 0);
+	if (--slot.pins == 0)
+	{
+		this->link(s);
+	}
+}
+
+template <class T>
+void SPLOutOfCoreGrid<T>::link(const SPLint32 s) const throw()
+{
+	Slot &slot = *this->slots[size_t(s)];
+	slot.prev = -1;
+	slot.next = this->head;
+	if (this->head >= 0)
+	{
+		this->slots[size_t(this->head)]->prev = s;
+	}
+	this->head = s;
+	if (this->tail < 0)
+	{
+		this->tail = s;
+	}
+}
+
+template <class T>
+void SPLOutOfCoreGrid<T>::unlink(const SPLint32 s) const throw()
+{
+	Slot &slot = *this->slots[size_t(s)];
+	if (slot.prev >= 0)
+	{
+		this->slots[size_t(slot.prev)]->next = slot.next;
+	}
+	else
+	{
+		this->head = slot.next;
+	}
+	if (slot.next >= 0)
+	{
+		this->slots[size_t(slot.next)]->prev = slot.prev;
+	}
+	else
+	{
+		this->tail = slot.prev;
+	}
+	slot.prev = slot.next = -1;
+}
+
+template <class T>
+bool SPLOutOfCoreGrid<T>::store(const Slot &slot) const throw()
+{
+	const bool ok = this->writeFile(this->getPosition(slot.block), this->bytes, slot.data);
+	this->stats.writes++;
+	if (!ok)
+	{
+		this->stats.errors++;
+	}
+	return ok;
+}
+
+template <class T>
+T SPLOutOfCoreGrid<T>::load(const SPLindex x, const SPLindex y, const SPLindex z) const throw()
+{
+	const SPLindex b = this->getBlockIndex(x, y, z);
+	const SPLint64 o = this->getLocal(x, y, z);
+	{
+		// a resident brick is read under the lock, without a pin
+		std::lock_guard<std::mutex> lock(this->mutex);
+		const SPLint32 s = this->touch(b);
+		if (s >= 0)
+		{
+			return this->slots[size_t(s)]->data[o];
+		}
+	}
+	const Brick brick = this->getBrick(b);
+	return brick.isValid() ? brick.getData()[o] : T();
+}
+
+template <class T>
+bool SPLOutOfCoreGrid<T>::set(const SPLindex x, const SPLindex y, const SPLindex z, const T &v) throw()
+{
+	assert(this->writable);
+	const SPLindex b = this->getBlockIndex(x, y, z);
+	const SPLint64 o = this->getLocal(x, y, z);
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		const SPLint32 s = this->touch(b);
+		if (s >= 0)
+		{
+			this->slots[size_t(s)]->dirty = true;
+			this->slots[size_t(s)]->data[o] = v;
+			return true;
+		}
+	}
+	const Brick brick = this->getBrick(b, true);
+	if (!brick.isValid())
+	{
+		return false;
+	}
+	brick.getData()[o] = v;
+	return true;
+}
+
+template <class T>
+SPLint32 SPLOutOfCoreGrid<T>::touch(const SPLindex b) const throw()
+{
+	// the lock is held by the caller
+	const SPLint32 s = this->table[size_t(b)];
+	if (s < 0 || !this->slots[size_t(s)]->ready)
+	{
+		return -1;
+	}
+	if (this->slots[size_t(s)]->pins == 0 && s != this->head)
+	{
+		this->unlink(s);
+		this->link(s);
+	}
+	this->stats.hits++;
+	return s;
+}
+
+template <class T>
+SPLint64 SPLOutOfCoreGrid<T>::getLocal(const SPLindex x, const SPLindex y, const SPLindex z) const throw()
+{
+	const SPLindex m = this->brick - 1;
+	return this->local[0][size_t(x & m)] + this->local[1][size_t(y & m)] + this->local[2][size_t(z & m)];
+}
+
+template <class T>
+bool SPLOutOfCoreGrid<T>::readFile(const SPLint64 offset, const SPLint64 bytes, void *dst) const throw()
+{
+#ifdef _WIN32
+	OVERLAPPED o;
+	memset(&o, 0, sizeof(o));
+	o.Offset = DWORD(offset & 0xFFFFFFFF);
+	o.OffsetHigh = DWORD(offset >> 32);
+	DWORD n = 0;
+	return ReadFile(this->file, dst, DWORD(bytes), &n, &o) && SPLint64(n) == bytes;
+#else
+	SPLint64 done = 0;
+	while (done < bytes)
+	{
+		const ssize_t n = pread(this->file, (char *)dst + done, size_t(bytes - done), off_t(offset + done));
+		if (n <= 0)
+		{
+			return false;
+		}
+		done += n;
+	}
+	return true;
+#endif
+}
+
+template <class T>
+bool SPLOutOfCoreGrid<T>::writeFile(const SPLint64 offset, const SPLint64 bytes, const void *src) const throw()
+{
+#ifdef _WIN32
+	OVERLAPPED o;
+	memset(&o, 0, sizeof(o));
+	o.Offset = DWORD(offset & 0xFFFFFFFF);
+	o.OffsetHigh = DWORD(offset >> 32);
+	DWORD n = 0;
+	return WriteFile(this->file, src, DWORD(bytes), &n, &o) && SPLint64(n) == bytes;
+#else
+	SPLint64 done = 0;
+	while (done < bytes)
+	{
+		const ssize_t n = pwrite(this->file, (const char *)src + done, size_t(bytes - done), off_t(offset + done));
+		if (n <= 0)
+		{
+			return false;
+		}
+		done += n;
+	}
+	return true;
+#endif
+}
+
+template <class T>
+bool SPLOutOfCoreGrid<T>::adviseFile(const SPLint64 offset, const SPLint64 bytes) const throw()
+{
+#ifdef _WIN32
+	// no read ahead hint for handles, the reads are cached by the system
+	(void)offset;
+	(void)bytes;
+	return this->file != INVALID_HANDLE_VALUE;
+#else
+	return this->file >= 0 && posix_fadvise(this->file, off_t(offset), off_t(bytes), POSIX_FADV_WILLNEED) == 0;
+#endif
+}
+
+template <class T>
+void SPLOutOfCoreGrid<T>::closeFile(void) throw()
+{
+#ifdef _WIN32
+	if (this->file != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(this->file);
+	}
+	this->file = INVALID_HANDLE_VALUE;
+#else
+	if (this->file >= 0)
+	{
+		::close(this->file);
+	}
+	this->file = -1;
+#endif
+}
+
+/************************************************************************************************
+ ** SPLOutOfCoreGrid::Brick class implementation
+ ************************************************************************************************/
+template <class T>
+SPLOutOfCoreGrid<T>::Brick::Brick(const Brick &b) throw()
+{
+	this->grid = b.grid;
+	this->slot = b.slot;
+	this->entry = b.entry;
+	if (this->slot >= 0)
+	{
+		this->grid->repin(this->slot);
+	}
+}
+
+template <class T>
+typename SPLOutOfCoreGrid<T>::Brick& SPLOutOfCoreGrid<T>::Brick::operator = (const Brick &b) throw()
+{
+	if (this != &b)
+	{
+		if (b.slot >= 0)
+		{
+			b.grid->repin(b.slot);
+		}
+		this->release();
+		this->grid = b.grid;
+		this->slot = b.slot;
+		this->entry = b.entry;
+	}
+	return (*this);
+}
+
+template <class T>
+typename SPLOutOfCoreGrid<T>::Brick& SPLOutOfCoreGrid<T>::Brick::operator = (Brick &&b) throw()
+{
+	if (this != &b)
+	{
+		this->release();
+		this->grid = b.grid;
+		this->slot = b.slot;
+		this->entry = b.entry;
+		b.slot = -1;
+	}
+	return (*this);
+}
+
+template <class T>
+void SPLOutOfCoreGrid<T>::Brick::release(void) throw()
+{
+	if (this->slot >= 0)
+	{
+		this->grid->unpin(this->slot);
+	}
+	this->slot = -1;
+}
+
+template <class T>
+SPLint64 SPLOutOfCoreGrid<T>::Brick::getIndex(void) const throw()
+{
+	// the slot keeps its brick while it is pinned
+	return (this->slot >= 0) ? this->entry->block : -1;
+}
+
+template <class T>
+T* SPLOutOfCoreGrid<T>::Brick::getData(void) const throw()
+{
+	assert(this->slot >= 0);
+	return this->entry->data;
+}
+
+template <class T>
+SPLGrid<T>& SPLOutOfCoreGrid<T>::Brick::getGrid(void) const throw()
+{
+	assert(this->slot >= 0);
+	return this->entry->view;
+}
+
+/************************************************************************************************
+ ** SPLOutOfCoreGrid::Accessor class implementation
+ ************************************************************************************************/
+template <class T>
+T* SPLOutOfCoreGrid<T>::Accessor::find(const SPLindex x, const SPLindex y, const SPLindex z) throw()
+{
+	const SPLindex b = this->grid->getBlockIndex(x, y, z);
+	if (this->brick.getIndex() != b)
+	{
+		this->brick = this->grid->getBrick(b, this->write);
+		if (!this->brick.isValid())
+		{
+			return 0;
+		}
+	}
+	return this->brick.getData() + this->grid->getLocal(x, y, z);
+}
+
+template <class T>
+T SPLOutOfCoreGrid<T>::Accessor::get(const SPLindex x, const SPLindex y, const SPLindex z) throw()
+{
+	const T *v = this->find(x, y, z);
+	return (v != 0) ? *v : T();
+}
+
+template <class T>
+T SPLOutOfCoreGrid<T>::Accessor::getClamped(const SPLindex x, const SPLindex y, const SPLindex z) throw()
+{
+	const SPLVector3i &n = this->grid->getSize();
+	return this->get(CLAMP(x, 0, n.x - 1), CLAMP(y, 0, n.y - 1), CLAMP(z, 0, n.z - 1));
+}
+
+template <class T>
+bool SPLOutOfCoreGrid<T>::Accessor::set(const SPLindex x, const SPLindex y, const SPLindex z, const T &v) throw()
+{
+	assert(this->write);
+	T *p = this->find(x, y, z);
+	if (p == 0)
+	{
+		return false;
+	}
+	*p = v;
+	return true;
+}
+
+/************************************************************************************************
+ ** SPLOutOfCoreGridIterator class implementation
+ ************************************************************************************************/
+template <class T, class V>
+SPLOutOfCoreGridIterator<T, V>::SPLOutOfCoreGridIterator(const SPLOutOfCoreGrid<T> *grid, const SPLindex block, const SPLindex last) throw()
+	: neighbors(*grid)
+{
+	this->grid = grid;
+	this->data = 0;
+	this->lx = &grid->local[0][0];
+	this->ly = &grid->local[1][0];
+	this->lz = &grid->local[2][0];
+	this->block = block;
+	this->last = last;
+	this->row = 0;
+	this->setBlock();
+}
+
+template <class T, class V>
+T SPLOutOfCoreGridIterator<T, V>::getNeighbor(const SPLindex dx, const SPLindex dy, const SPLindex dz) const throw()
+{
+	assert(dx >= -1 && dx <= 1 && dy >= -1 && dy <= 1 && dz >= -1 && dz <= 1);
+	// coordinates within the brick, unsigned such that -1 is outside as well
+	const SPLuint32 x = SPLuint32(this->pos.x + dx - this->lo.x), y = SPLuint32(this->pos.y + dy - this->lo.y), z = SPLuint32(this->pos.z + dz - this->lo.z);
+	if (x < SPLuint32(this->hi.x - this->lo.x) && y < SPLuint32(this->hi.y - this->lo.y) && z < SPLuint32(this->hi.z - this->lo.z))
+	{
+		return this->data[this->lx[x] + this->ly[y] + this->lz[z]];
+	}
+	return this->neighbors.getClamped(this->pos.x + dx, this->pos.y + dy, this->pos.z + dz);
+}
+
+template <class T, class V>
+SPLOutOfCoreGridIterator<T, V>& SPLOutOfCoreGridIterator<T, V>::operator ++ (void) throw()
+{
+	if (++this->pos.x < this->hi.x)
+	{
+		return (*this);
+	}
+	this->pos.x = this->lo.x;
+	if (++this->pos.y >= this->hi.y)
+	{
+		this->pos.y = this->lo.y;
+		if (++this->pos.z >= this->hi.z)
+		{
+			this->block++;
+			this->setBlock();
+			return (*this);
+		}
+	}
+	this->row = this->ly[this->pos.y - this->lo.y] + this->lz[this->pos.z - this->lo.z];
+	return (*this);
+}
+
+template <class T, class V>
+void SPLOutOfCoreGridIterator<T, V>::setBlock(void) throw()
+{
+	if (this->block >= this->last)
+	{
+		// the end iterator of every range
+		this->block = this->last;
+		this->brick.release();
+		this->neighbors.release();
+		this->data = 0;
+		this->lo = this->hi = this->pos = SPLVector3i(0, 0, 0);
+		return;
+	}
+	this->grid->getBlock(this->block, this->lo, this->hi);
+	this->brick = this->grid->getBrick(this->block, !std::is_const<V>::value);
+	if (this->block + 1 < this->last)
+	{
+		this->grid->prefetch(this->block + 1, this->block + 2);
+	}
+	// an unreadable brick is skipped
+	if (!this->brick.isValid())
+	{
+		this->block++;
+		this->setBlock();
+		return;
+	}
+	this->data = this->brick.getData();
+	this->pos = this->lo;
+	this->row = 0;
+}
+
+/************************************************************************************************
+ ** Functions
+ ************************************************************************************************/
+template <class T>
+bool splWriteOutOfCoreGrid(const char *path, const SPLGrid<T> &grid, const SPLsizei brick, SPLThreadPool &pool) throw()
+{
+	SPLOutOfCoreGrid<T> out;
+	if (!out.create(path, grid.getSize(), brick, SPLint64(64) << 20))
+	{
+		return false;
+	}
+	pool.parallelFor(0, out.getBlockCount(), 1, [&](const SPLint64 first, const SPLint64 last)
+	{
+		SPLVector3i lo, hi;
+		for (SPLindex b = SPLindex(first); b < SPLindex(last); b++)
+		{
+			const typename SPLOutOfCoreGrid<T>::Brick handle = out.getBrick(b, true);
+			if (!handle.isValid())
+			{
+				continue;
+			}
+			out.getBlock(b, lo, hi);
+			SPLGrid<T> &dst = handle.getGrid();
+			for (SPLindex z = lo.z; z < hi.z; z++)
+			{
+				for (SPLindex y = lo.y; y < hi.y; y++)
+				{
+					for (SPLindex x = lo.x; x < hi.x; x++)
+					{
+						dst(x - lo.x, y - lo.y, z - lo.z) = grid(x, y, z);
+					}
+				}
+			}
+		}
+	});
+	return out.close();
+}
+
+#endif /* _spl_outofcoregrid_hh_ */
@@ -0,0 +1,552 @@
+#ifndef _spl_pnm_hh_
+#define _spl_pnm_hh_
+
+#include <atomic>
+#include <chrono>
+#include <limits>
+#include <cstdio>    // for fopen(), fwrite()
+#include <cstring>   // for memcpy()
+#include <string>
+#include <vector>
+#include <algorithm> // for std::sort()
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <dirent.h>  // for opendir()
+#endif
+
+#include <spl/typesbase.hh>
+#include <spl/mathbase.hh>
+#include <spl/threadpool.hh>
+#include <spl/vector3.hh>
+#include <spl/grid.hh>
+#include <spl/mappedfile.hh>
+
+/*! \file pnm.hh
+ * \brief Reading and writing of PGM (\ref SPL_FILEIO_PGM_ID) and PPM (\ref SPL_FILEIO_PPM_ID) images.
+ *
+ * The binary (P5, P6) and ASCII (P2, P3) variants are supported with 8
+ * and 16 bit samples, where 16 bit samples are stored big-endian. An
+ * image is read into or written from one z slice of a \ref SPLGrid:
+ *
+ * - PGM images are stored in grids of scalar voxels, e.g. \ref SPLGridub
+ *   or \ref SPLGridus.
+ * - PPM images are stored in grids of \ref SPLVector3 voxels, e.g.
+ *   \c SPLGrid<SPLVector3<SPLuint8> >, with the red, green and blue
+ *   samples in x, y and z.
+ *
+ * The files are memory mapped and the samples are converted straight
+ * into the memory of the grid, i.e. an 8 bit image is one \c memcpy() per
+ * row in the linear layout. The ASCII variants are parsed without
+ * iostreams. \ref splReadPNMDirectory loads a directory of slices into
+ * one volume with parallel readers.
+ *
+ * Example
+ * \code
+ * SPLGridus volume;
+ * SPLPNMStats stats;
+ * if (splReadPNMDirectory("slices/", volume, SPLThreadPool::getGlobal(), &stats))
+ * {
+ *     printf("%d slices, %.0f MB/s\n", volume.getSize().z, stats.getMBps());
+ * }
+ * \endcode
+ * */
+
+/*! \struct SPLPNMHeader
+ * \brief The parsed header of a PGM or PPM file.
+ */
+struct SPLPNMHeader
+{
+	SPLenum format;		//!< \ref SPL_FILEIO_PGM_ID or \ref SPL_FILEIO_PPM_ID.
+	bool binary;		//!< Set for P5 and P6, cleared for P2 and P3.
+	SPLsizei width;		//!< Number of columns.
+	SPLsizei height;	//!< Number of rows.
+	SPLint32 maxval;	//!< Maximum sample value in \f$ [1, 65535] \f$.
+	SPLint64 offset;	//!< Byte offset of the samples.
+};
+
+/*! \struct SPLPNMStats
+ * \brief Statistics of \ref splReadPNMDirectory.
+ */
+struct SPLPNMStats
+{
+	SPLint64 files;		//!< Number of files read.
+	SPLint64 bytes;		//!< Number of bytes read.
+	SPLieee64 seconds;	//!< Wall time.
+
+	//! Returns the throughput in \f$ 10^6 \f$ bytes per second.
+	SPLieee64 getMBps(void) const throw() { return (this->seconds > 0.0) ? 1.0e-6 * SPLieee64(this->bytes) / this->seconds : 0.0; }
+};
+
+namespace SPLPNMDetail
+{
+	//! Number of samples per voxel and the sample type.
+	template <class T>
+	struct Traits
+	{
+		typedef T Sample;
+		static const SPLint32 channels = 1;
+		static T& get(T &v, const SPLindex) throw() { return v; }
+		static const T& get(const T &v, const SPLindex) throw() { return v; }
+	};
+
+	template <class S>
+	struct Traits<SPLVector3<S> >
+	{
+		typedef S Sample;
+		static const SPLint32 channels = 3;
+		static S& get(SPLVector3<S> &v, const SPLindex c) throw() { return (&v.x)[c]; }
+		static const S& get(const SPLVector3<S> &v, const SPLindex c) throw() { return (&v.x)[c]; }
+	};
+
+	//! Skips whitespace and comments, returns \c false at the end.
+	inline bool skip(const SPLuint8 *&p, const SPLuint8 *end) throw()
+	{
+		while (p < end)
+		{
+			if (*p == '#')
+			{
+				while (p < end && *p != '\n' && *p != '\r')
+				{
+					p++;
+				}
+			}
+			else if (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r' || *p == '\v' || *p == '\f')
+			{
+				p++;
+			}
+			else
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	//! Parses a non negative decimal integer, returns \c false if there is none.
+	inline bool integer(const SPLuint8 *&p, const SPLuint8 *end, SPLint32 &v) throw()
+	{
+		if (!skip(p, end) || *p < '0' || *p > '9')
+		{
+			return false;
+		}
+		SPLint64 r = 0;
+		for (; p < end && *p >= '0' && *p <= '9'; p++)
+		{
+			r = r * 10 + (*p - '0');
+			if (r > 0x7FFFFFFF)
+			{
+				return false;
+			}
+		}
+		v = SPLint32(r);
+		return true;
+	}
+
+	//! Orders names with embedded numbers naturally, e.g. "s9" before "s10".
+	inline bool natural(const std::string &a, const std::string &b) throw()
+	{
+		size_t i = 0, j = 0;
+		while (i < a.size() && j < b.size())
+		{
+			if (a[i] >= '0' && a[i] <= '9' && b[j] >= '0' && b[j] <= '9')
+			{
+				size_t ei = i, ej = j;
+				while (ei < a.size() && a[ei] >= '0' && a[ei] <= '9') ei++;
+				while (ej < b.size() && b[ej] >= '0' && b[ej] <= '9') ej++;
+				// skip leading zeros, then the longer number is larger
+				size_t si = i, sj = j;
+				while (si + 1 < ei && a[si] == '0') si++;
+				while (sj + 1 < ej && b[sj] == '0') sj++;
+				if (ei - si != ej - sj)
+				{
+					return ei - si < ej - sj;
+				}
+				const int c = a.compare(si, ei - si, b, sj, ej - sj);
+				if (c != 0)
+				{
+					return c < 0;
+				}
+				i = ei;
+				j = ej;
+			}
+			else
+			{
+				if (a[i] != b[j])
+				{
+					return a[i] < b[j];
+				}
+				i++;
+				j++;
+			}
+		}
+		return a.size() - i < b.size() - j;
+	}
+
+	//! Returns whether the name ends with .pgm or .ppm (any case).
+	inline bool isPNM(const std::string &name) throw()
+	{
+		if (name.size() < 4 || name[name.size() - 4] != '.')
+		{
+			return false;
+		}
+		const char a = char(name[name.size() - 3] | 0x20), b = char(name[name.size() - 2] | 0x20), c = char(name[name.size() - 1] | 0x20);
+		return a == 'p' && (b == 'g' || b == 'p') && c == 'm';
+	}
+}
+
+/*! \fn bool splParsePNMHeader(const SPLuint8 *data, const SPLint64 size, SPLPNMHeader &header)
+ * \brief Parses the header of a PGM or PPM file!
+ *
+ * \param data The first bytes of the file.
+ * \param size Number of bytes of \c data.
+ * \param header The parsed header.
+ *
+ * \return \c true on success and \c false otherwise.
+ */
+inline bool splParsePNMHeader(const SPLuint8 *data, const SPLint64 size, SPLPNMHeader &header) throw()
+{
+	if (data == 0 || size < 3 || data[0] != 'P')
+	{
+		return false;
+	}
+	switch (data[1])
+	{
+	case '2': header.format = SPL_FILEIO_PGM_ID; header.binary = false; break;
+	case '3': header.format = SPL_FILEIO_PPM_ID; header.binary = false; break;
+	case '5': header.format = SPL_FILEIO_PGM_ID; header.binary = true; break;
+	case '6': header.format = SPL_FILEIO_PPM_ID; header.binary = true; break;
+	default: return false;
+	}
+	const SPLuint8 *p = data + 2, *end = data + size;
+	if (!SPLPNMDetail::integer(p, end, header.width) || !SPLPNMDetail::integer(p, end, header.height) ||
+		!SPLPNMDetail::integer(p, end, header.maxval))
+	{
+		return false;
+	}
+	// exactly one whitespace character separates the header from the samples
+	if (p >= end || !(*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r'))
+	{
+		return false;
+	}
+	header.offset = SPLint64(p + 1 - data);
+	return header.width > 0 && header.height > 0 && header.maxval > 0 && header.maxval <= 65535;
+}
+
+/*! \fn bool splReadPNM(const char *path, SPLGrid<T> &grid, const SPLindex slice = 0)
+ * \brief Reads a PGM or PPM file into a slice of a grid!
+ *
+ * An empty grid is resized to one slice of the size of the image (in its
+ * current layout), otherwise the size of the image must match the x and y
+ * size of the grid. The samples are converted to the voxel type, which
+ * must be able to represent the maximum value of the file.
+ *
+ * \param path The file.
+ * \param grid The grid, with scalar voxels for PGM and \ref SPLVector3 voxels for PPM files.
+ * \param slice The z slice.
+ *
+ * \return \c true on success and \c false otherwise.
+ */
+template <class T>
+bool splReadPNM(const char *path, SPLGrid<T> &grid, const SPLindex slice = 0) throw()
+{
+	typedef SPLPNMDetail::Traits<T> Tr;
+	typedef typename Tr::Sample S;
+	SPLMappedFile file;
+	SPLPNMHeader h;
+	if (!file.open(path, SPL_FILEIO_ACCESS_SEQUENTIAL) || !splParsePNMHeader(file.getData(), file.getSize(), h))
+	{
+		return false;
+	}
+	const SPLint32 channels = (h.format == SPL_FILEIO_PPM_ID) ? 3 : 1;
+	if (channels != Tr::channels || SPLieee64(h.maxval) > SPLieee64(std::numeric_limits<S>::max()))
+	{
+		return false;
+	}
+	if (grid.getStorageSize() == 0 && !grid.resize(SPLVector3i(h.width, h.height, 1), grid.getLayout(), MAX(grid.getBrickSize(), 8)))
+	{
+		return false;
+	}
+	const SPLVector3i &n = grid.getSize();
+	if (n.x != h.width || n.y != h.height || slice < 0 || slice >= n.z)
+	{
+		return false;
+	}
+
+	const SPLint64 *ox = grid.getOffsets(0), *oy = grid.getOffsets(1);
+	T *dst = grid.getData() + grid.getOffsets(2)[slice];
+	const SPLuint8 *p = file.getData() + h.offset, *end = file.getData() + file.getSize();
+	const SPLint64 row = SPLint64(h.width) * channels;
+	if (h.binary)
+	{
+		const SPLint32 bytes = (h.maxval > 255) ? 2 : 1;
+		if (end - p < row * bytes * h.height)
+		{
+			return false;
+		}
+		// the samples of a row are contiguous in the linear layout
+		const bool contiguous = (grid.getLayout() == SPL_GRID_LINEAR && sizeof(T) == Tr::channels * sizeof(S));
+		for (SPLindex y = 0; y < h.height; y++, p += row * bytes)
+		{
+			T *r = dst + oy[y];
+			if (bytes == 1 && sizeof(S) == 1 && contiguous)
+			{
+				memcpy((void *)r, p, size_t(row));
+			}
+			else if (contiguous)
+			{
+				S *s = &Tr::get(r[0], 0);
+				for (SPLint64 i = 0; i < row; i++)
+				{
+					s[i] = (bytes == 1) ? S(p[i]) : S((SPLuint32(p[2 * i]) << 8) | p[2 * i + 1]);
+				}
+			}
+			else
+			{
+				for (SPLindex x = 0, i = 0; x < h.width; x++)
+				{
+					for (SPLindex c = 0; c < channels; c++, i++)
+					{
+						Tr::get(r[ox[x]], c) = (bytes == 1) ? S(p[i]) : S((SPLuint32(p[2 * i]) << 8) | p[2 * i + 1]);
+					}
+				}
+			}
+		}
+		return true;
+	}
+	for (SPLindex y = 0; y < h.height; y++)
+	{
+		T *r = dst + oy[y];
+		for (SPLindex x = 0; x < h.width; x++)
+		{
+			for (SPLindex c = 0; c < channels; c++)
+			{
+				SPLint32 v;
+				if (!SPLPNMDetail::integer(p, end, v) || v > h.maxval)
+				{
+					return false;
+				}
+				Tr::get(r[ox[x]], c) = S(v);
+			}
+		}
+	}
+	return true;
+}
+
+/*! \fn bool splWritePNM(const char *path, const SPLGrid<T> &grid, const SPLindex slice = 0, const bool binary = true, const SPLint32 maxval = 0)
+ * \brief Writes a slice of a grid as a PGM or PPM file!
+ *
+ * Grids of scalar voxels are written as PGM and grids of \ref SPLVector3
+ * voxels as PPM files. The samples are clamped to \f$ [0, maxval] \f$.
+ *
+ * \param path The file.
+ * \param grid The grid.
+ * \param slice The z slice.
+ * \param binary Writes P5/P6 if set and P2/P3 otherwise.
+ * \param maxval The maximum sample value in \f$ [1, 65535] \f$, or \f$ 0 \f$ for
+ * 255 with 8 bit and 65535 with larger sample types. Values above 255 are
+ * written with 2 bytes per sample.
+ *
+ * \return \c true on success and \c false otherwise.
+ */
+template <class T>
+bool splWritePNM(const char *path, const SPLGrid<T> &grid, const SPLindex slice = 0, const bool binary = true, const SPLint32 maxval = 0) throw()
+{
+	typedef SPLPNMDetail::Traits<T> Tr;
+	typedef typename Tr::Sample S;
+	const SPLVector3i &n = grid.getSize();
+	const SPLint32 max = (maxval > 0) ? maxval : ((sizeof(S) == 1) ? 255 : 65535);
+	if (slice < 0 || slice >= n.z || max > 65535)
+	{
+		return false;
+	}
+	FILE *f = fopen(path, "wb");
+	if (f == 0)
+	{
+		return false;
+	}
+	const SPLint32 channels = Tr::channels;
+	fprintf(f, "P%c\n%d %d\n%d\n", binary ? (channels == 3 ? '6' : '5') : (channels == 3 ? '3' : '2'), n.x, n.y, max);
+
+	const SPLint64 *ox = grid.getOffsets(0), *oy = grid.getOffsets(1);
+	const T *src = grid.getData() + grid.getOffsets(2)[slice];
+	const SPLint32 bytes = (max > 255) ? 2 : 1;
+	// one row of samples, at most 6 characters per sample in ASCII
+	std::vector<char> buffer(size_t(n.x) * channels * (binary ? bytes : 6) + 1);
+	bool ok = true;
+	for (SPLindex y = 0; y < n.y && ok; y++)
+	{
+		const T *r = src + oy[y];
+		char *b = &buffer[0];
+		for (SPLindex x = 0; x < n.x; x++)
+		{
+			for (SPLindex c = 0; c < channels; c++)
+			{
+				const SPLuint32 v = SPLuint32(CLAMP(SPLieee64(Tr::get(r[ox[x]], c)), 0.0, SPLieee64(max)));
+				if (binary)
+				{
+					if (bytes == 2)
+					{
+						*b++ = char(v >> 8);
+					}
+					*b++ = char(v & 0xFF);
+				}
+				else
+				{
+					// at most 5 digits and a separator
+					char digits[5];
+					SPLint32 k = 0;
+					SPLuint32 d = v;
+					do
+					{
+						digits[k++] = char('0' + d % 10);
+						d /= 10;
+					} while (d != 0);
+					while (k > 0)
+					{
+						*b++ = digits[--k];
+					}
+					*b++ = (x + 1 == n.x && c + 1 == channels) ? '\n' : ' ';
+				}
+			}
+		}
+		const size_t count = size_t(b - &buffer[0]);
+		ok = fwrite(&buffer[0], 1, count, f) == count;
+	}
+	return (fclose(f) == 0) && ok;
+}
+
+/*! \fn bool splListPNMFiles(const char *directory, std::vector<std::string> &files)
+ * \brief Lists the PGM and PPM files of a directory!
+ *
+ * \param directory The directory.
+ * \param files The paths of the .pgm and .ppm files in natural order, e.g.
+ * "slice9.pgm" before "slice10.pgm".
+ *
+ * \return \c true on success and \c false otherwise.
+ */
+inline bool splListPNMFiles(const char *directory, std::vector<std::string> &files) throw()
+{
+	std::string dir(directory);
+	if (!dir.empty() && dir[dir.size() - 1] != '/' && dir[dir.size() - 1] != '\\')
+	{
+		dir += '/';
+	}
+	std::vector<std::string> names;
+#ifdef _WIN32
+	WIN32_FIND_DATAA entry;
+	HANDLE h = FindFirstFileA((dir + "*").c_str(), &entry);
+	if (h == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+	do
+	{
+		if (!(entry.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) && SPLPNMDetail::isPNM(entry.cFileName))
+		{
+			names.push_back(entry.cFileName);
+		}
+	} while (FindNextFileA(h, &entry));
+	FindClose(h);
+#else
+	DIR *d = opendir(dir.c_str());
+	if (d == 0)
+	{
+		return false;
+	}
+	for (struct dirent *e = readdir(d); e != 0; e = readdir(d))
+	{
+		if (SPLPNMDetail::isPNM(e->d_name))
+		{
+			names.push_back(e->d_name);
+		}
+	}
+	closedir(d);
+#endif
+	std::sort(names.begin(), names.end(), SPLPNMDetail::natural);
+	files.clear();
+	for (size_t i = 0; i < names.size(); i++)
+	{
+		files.push_back(dir + names[i]);
+	}
+	return true;
+}
+
+/*! \fn bool splReadPNMSeries(const std::vector<std::string> &files, SPLGrid<T> &grid, SPLThreadPool &pool = SPLThreadPool::getGlobal(), SPLPNMStats *stats = 0)
+ * \brief Reads a series of PGM or PPM files into one volume!
+ *
+ * The grid is resized (in its current layout) to the size of the first
+ * image and one slice per file. The files are read in parallel, each
+ * into its own slice, see \ref splReadPNM.
+ *
+ * \param files The paths, the \c i-th file is the slice \f$ z = i \f$.
+ * \param grid The grid.
+ * \param pool The threads.
+ * \param stats Receives the number of bytes and the wall time (may be \c 0).
+ *
+ * \return \c true on success and \c false if any file cannot be read or
+ * differs in size.
+ */
+template <class T>
+bool splReadPNMSeries(const std::vector<std::string> &files, SPLGrid<T> &grid, SPLThreadPool &pool = SPLThreadPool::getGlobal(), SPLPNMStats *stats = 0) throw()
+{
+	const std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+	SPLPNMHeader h;
+	SPLuint8 head[64];
+	FILE *f = files.empty() ? 0 : fopen(files[0].c_str(), "rb");
+	const size_t read = (f != 0) ? fread(head, 1, sizeof(head), f) : 0;
+	if (f != 0)
+	{
+		fclose(f);
+	}
+	if (!splParsePNMHeader(head, SPLint64(read), h) ||
+		!grid.resize(SPLVector3i(h.width, h.height, SPLsizei(files.size())), grid.getLayout(), MAX(grid.getBrickSize(), 8)))
+	{
+		return false;
+	}
+	std::atomic<bool> ok(true);
+	pool.parallelFor(0, SPLint64(files.size()), 1, [&](const SPLint64 first, const SPLint64 last)
+	{
+		for (SPLint64 i = first; i < last && ok.load(); i++)
+		{
+			if (!splReadPNM(files[size_t(i)].c_str(), grid, SPLindex(i)))
+			{
+				ok.store(false);
+			}
+		}
+	});
+	if (stats != 0)
+	{
+		// the samples of all files (the headers are negligible)
+		stats->files = SPLint64(files.size());
+		stats->bytes = SPLint64(h.width) * h.height * SPLint64(files.size()) * ((h.format == SPL_FILEIO_PPM_ID) ? 3 : 1) * ((h.maxval > 255) ? 2 : 1);
+		stats->seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+	}
+	return ok.load();
+}
+
+/*! \fn bool splReadPNMDirectory(const char *directory, SPLGrid<T> &grid, SPLThreadPool &pool = SPLThreadPool::getGlobal(), SPLPNMStats *stats = 0)
+ * \brief Reads all PGM or PPM files of a directory into one volume!
+ *
+ * The files are sorted in natural order, see \ref splListPNMFiles, and
+ * read with \ref splReadPNMSeries.
+ *
+ * \param directory The directory.
+ * \param grid The grid.
+ * \param pool The threads.
+ * \param stats Receives the number of bytes and the wall time (may be \c 0).
+ *
+ * \return \c true on success and \c false otherwise.
+ */
+template <class T>
+bool splReadPNMDirectory(const char *directory, SPLGrid<T> &grid, SPLThreadPool &pool = SPLThreadPool::getGlobal(), SPLPNMStats *stats = 0) throw()
+{
+	std::vector<std::string> files;
+	return splListPNMFiles(directory, files) && splReadPNMSeries(files, grid, pool, stats);
+}
+
+#endif /* _spl_pnm_hh_ */
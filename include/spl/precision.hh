@@ -0,0 +1,161 @@
+#ifndef _spl_precision_hh_
+#define _spl_precision_hh_
+
+#include <cmath>
+
+#include <spl/typesbase.hh>
+#include <spl/cudadefs.hh>
+
+#if !defined(__CUDA_ARCH__) && (defined(__SSE__) || defined(_M_X64))
+#include <xmmintrin.h>
+#define SPL_PRECISION_SSE_RSQRT
+#endif
+
+/*! \file precision.hh
+ * \brief Precision policies for the length and normalization of vectors.
+ *
+ * The policies decide in which type the square, the length and the
+ * normalization of a vector are computed:
+ * - \ref SPLPrecisionDouble computes everything in \ref SPLieee64 (exact double),
+ * - \ref SPLPrecisionNative computes in the type of the vector components
+ *   (\ref SPLieee64 for integer vectors),
+ * - \ref SPLPrecisionFast is like \ref SPLPrecisionNative but replaces the
+ *   division by the square root by a reciprocal square root approximation
+ *   refined by one Newton step.
+ *
+ * The policy is selected per call, e.g. \c v.length<SPLPrecisionFast>(),
+ * or per type by specializing \ref SPLPrecisionDefault, which is used by
+ * \ref SPLVector3::length, \ref SPLVector3::normalize, ... .
+ * */
+
+/*! \class SPLPrecisionReal
+ * \brief Floating point type with the precision of \c T.
+ */
+template <class T> struct SPLPrecisionReal { typedef SPLieee64 Type; };
+template <> struct SPLPrecisionReal<SPLieee32> { typedef SPLieee32 Type; };
+template <> struct SPLPrecisionReal<SPLieee128> { typedef SPLieee128 Type; };
+
+/*! \fn SPLieee32 splRsqrt(const SPLieee32 s)
+ * \brief Fast reciprocal square root!
+ *
+ * Approximates \f$ 1 / \sqrt{s} \f$ in single precision with the hardware
+ * estimate (\c rsqrtss on the host, \c rsqrtf on the device) refined by one
+ * Newton step, i.e. the relative error is below \f$ 10^{-6} \f$.
+ *
+ * \param s A positive value.
+ *
+ * \return The reciprocal square root of \c s.
+ */
+CUDA_CALLABLE_MEMBER inline SPLieee32 splRsqrt(const SPLieee32 s) throw()
+{
+#if defined(__CUDA_ARCH__)
+	return rsqrtf(s);
+#elif defined(SPL_PRECISION_SSE_RSQRT)
+	const SPLieee32 y = _mm_cvtss_f32(_mm_rsqrt_ss(_mm_set_ss(s)));
+	return y * (1.5f - 0.5f * s * y * y);
+#else
+	return 1.0f / sqrtf(s);
+#endif
+}
+
+/*! \brief Reciprocal square root for non-float types!
+ *
+ * \param s A positive value.
+ *
+ * \return The reciprocal square root of \c s.
+ */
+template <class R>
+CUDA_CALLABLE_MEMBER inline R splRsqrt(const R s) throw()
+{
+	return R(1) / std::sqrt(s);
+}
+
+/*! \class SPLPrecisionDouble
+ * \brief Computes in \ref SPLieee64.
+ *
+ * Square roots and divisions are evaluated in double precision for all
+ * component types and their results are converted back to \c T, i.e. this
+ * policy trades speed for accuracy on \ref SPLieee32 vectors.
+ *
+ * Batch kernels (e.g. \ref SPLVector3ArrayView::normalize) compute in the
+ * precision of their lanes and treat this policy as \ref SPLPrecisionNative.
+ */
+struct SPLPrecisionDouble
+{
+	//! Type of the computation for vectors of type \c T.
+	template <class T> struct Real { typedef SPLieee64 Type; };
+
+	//! Returns \f$ \sqrt{s} \f$.
+	template <class R> CUDA_CALLABLE_MEMBER static R length(const R s) throw() { return std::sqrt(s); }
+
+	//! Returns \f$ 1 / \sqrt{s} \f$.
+	template <class R> CUDA_CALLABLE_MEMBER static R rsqrt(const R s) throw() { return R(1) / std::sqrt(s); }
+
+	//! Returns \f$ \sqrt{s} \f$ for a SIMD register, see \ref SPLSimd.
+	template <class S> static typename S::Type lengthSimd(const typename S::Type s) throw() { return S::sqrt(s); }
+
+	//! Returns \f$ 1 / \sqrt{s} \f$ for a SIMD register, see \ref SPLSimd.
+	template <class S> static typename S::Type rsqrtSimd(const typename S::Type s) throw() { return S::div(S::set(1), S::sqrt(s)); }
+};
+
+/*! \class SPLPrecisionNative
+ * \brief Computes in the precision of the vector components.
+ */
+struct SPLPrecisionNative
+{
+	//! Type of the computation for vectors of type \c T.
+	template <class T> struct Real { typedef typename SPLPrecisionReal<T>::Type Type; };
+
+	//! Returns \f$ \sqrt{s} \f$.
+	template <class R> CUDA_CALLABLE_MEMBER static R length(const R s) throw() { return std::sqrt(s); }
+
+	//! Returns \f$ 1 / \sqrt{s} \f$.
+	template <class R> CUDA_CALLABLE_MEMBER static R rsqrt(const R s) throw() { return R(1) / std::sqrt(s); }
+
+	//! Returns \f$ \sqrt{s} \f$ for a SIMD register, see \ref SPLSimd.
+	template <class S> static typename S::Type lengthSimd(const typename S::Type s) throw() { return S::sqrt(s); }
+
+	//! Returns \f$ 1 / \sqrt{s} \f$ for a SIMD register, see \ref SPLSimd.
+	template <class S> static typename S::Type rsqrtSimd(const typename S::Type s) throw() { return S::div(S::set(1), S::sqrt(s)); }
+};
+
+/*! \class SPLPrecisionFast
+ * \brief Computes in the precision of the vector components with a fast reciprocal square root.
+ *
+ * \sa splRsqrt
+ */
+struct SPLPrecisionFast
+{
+	//! Type of the computation for vectors of type \c T.
+	template <class T> struct Real { typedef typename SPLPrecisionReal<T>::Type Type; };
+
+	//! Returns \f$ \sqrt{s} = s / \sqrt{s} \f$.
+	template <class R> CUDA_CALLABLE_MEMBER static R length(const R s) throw() { return (s > R(0)) ? s * splRsqrt(s) : R(0); }
+
+	//! Returns \f$ 1 / \sqrt{s} \f$.
+	template <class R> CUDA_CALLABLE_MEMBER static R rsqrt(const R s) throw() { return splRsqrt(s); }
+
+	//! Returns \f$ \sqrt{s} = s / \sqrt{s} \f$ for a SIMD register, see \ref SPLSimd.
+	template <class S> static typename S::Type lengthSimd(const typename S::Type s) throw() { return S::selectZero(s, s, S::mul(s, S::rsqrt(s))); }
+
+	//! Returns \f$ 1 / \sqrt{s} \f$ for a SIMD register, see \ref SPLSimd.
+	template <class S> static typename S::Type rsqrtSimd(const typename S::Type s) throw() { return S::rsqrt(s); }
+};
+
+/*! \class SPLPrecisionDefault
+ * \brief The precision policy of vectors of type \c T.
+ *
+ * Specialize this class to change the precision of \ref SPLVector3::length,
+ * \ref SPLVector3::normalize, ... for a type, e.g.
+ * \code
+ * template <> struct SPLPrecisionDefault<SPLieee32> { typedef SPLPrecisionFast Type; };
+ * \endcode
+ * The specialization must be visible before the first use of the vector type.
+ */
+template <class T>
+struct SPLPrecisionDefault
+{
+	typedef SPLPrecisionDouble Type;	//!< The policy.
+};
+
+#endif /* _spl_precision_hh_ */
@@ -0,0 +1,506 @@
+#ifndef _spl_raycaster_hh_
+#define _spl_raycaster_hh_
+
+#include <atomic>
+#include <cmath>
+#include <vector>
+
+#include <spl/typesbase.hh>
+#include <spl/mathbase.hh>
+#include <spl/threadpool.hh>
+#include <spl/vector3.hh>
+#include <spl/vector4.hh>
+#include <spl/matrix3.hh>
+#include <spl/matrix4.hh>
+#include <spl/grid.hh>
+#include <spl/camera.hh>
+#include <spl/material.hh>
+#include <spl/materialtable.hh>
+#include <spl/light.hh>
+#include <spl/macrocells.hh>
+#include <spl/gradient.hh>
+
+/*! \file raycaster.hh
+ * */
+
+/*! \class SPLRayCaster
+ * \brief A multithreaded CPU volume ray caster.
+ *
+ * Renders a scalar \ref SPLGrid with the emission-absorption model of a
+ * \ref SPLMaterial, optionally shaded by \ref SPLLight sources (Phong
+ * shading with the gradient of central differences as normal, see
+ * \ref splShadePhong), or the gradients of a \ref SPLGradientVolume, see
+ * \ref setGradients. The frame is divided into square tiles, which are
+ * distributed over the threads of a \ref SPLThreadPool.
+ *
+ * Every ray of an orthographic or perspective \ref SPLCamera is clipped
+ * to the box of the voxel centers and sampled with trilinear
+ * interpolation at a fixed step size. The samples are composited front
+ * to back and the ray terminates early as soon as its opacity reaches the
+ * termination threshold. With the macrocells of the volume, see
+ * \ref setMacroCells, rays skip the cells in which the material is
+ * transparent without changing the image.
+ *
+ * The material is compiled into a \ref SPLMaterialTable, which is
+ * updated incrementally by \ref render, such that every sample costs one
+ * lookup of the quantized voxel value. With pre-integration, see
+ * \ref setPreIntegration, every step looks up the integral of the
+ * material between the values at its front and back instead, which
+ * avoids the artifacts of thin features at large step sizes.
+ *
+ * Voxel \f$ (x, y, z) \f$ is the point \f$ (x, y, z) \f$ in object
+ * coordinates, which \ref setModel maps to world coordinates. The frame
+ * is a grid of \f$ w \times h \times 1 \f$ RGBA pixels with premultiplied
+ * alpha, where \f$ w \times h \f$ is the size of the viewport and the
+ * first row is the top of the image.
+ *
+ * Example
+ * \code
+ * SPLRayCaster<SPLuint16> r;
+ * r.setModel(SPLMatrix4f(...));		// voxels to world
+ * r.setMaterial(material);
+ * r.addLight(SPLLight(SPL_LIGHT_DIRE));
+ *
+ * SPLGrid<SPLVector4f> frame;
+ * r.render(volume, camera, frame);
+ * \endcode
+ *
+ * \sa SPLCamera SPLMaterial SPLMaterialTable SPLLight
+ */
+template <class T>
+class SPLRayCaster
+{
+public:
+	/*! \brief Constructor!
+	 *
+	 * Initializes the identity model matrix, the default material, no
+	 * lights, a step size of \f$ 0.5 \f$ voxels, a termination threshold
+	 * of \f$ 0.99 \f$, tiles of \f$ 16 \times 16 \f$ pixels and no
+	 * pre-integration.
+	 */
+	SPLRayCaster(void) throw();
+
+	/*! \brief Sets the model matrix!
+	 *
+	 * \param m Object (voxel) to world coordinates (not singular).
+	 */
+	void setModel(const SPLMatrix4f &m) throw() { this->model = m; }
+
+	/*! \brief Returns the model matrix!
+	 *
+	 * \return Object (voxel) to world coordinates.
+	 */
+	const SPLMatrix4f& getModel(void) const throw() { return this->model; }
+
+	/*! \brief Sets the material!
+	 *
+	 * \param m The material.
+	 */
+	void setMaterial(const SPLMaterial &m) throw() { this->material = m; }
+
+	/*! \brief Returns the material!
+	 *
+	 * \return The material.
+	 */
+	const SPLMaterial& getMaterial(void) const throw() { return this->material; }
+
+	/*! \brief Adds a light!
+	 *
+	 * Lights are only evaluated if the material is shaded, see \ref SPLMaterial::isShaded.
+	 *
+	 * \param l The light in world coordinates.
+	 */
+	void addLight(const SPLLight &l) throw() { this->lights.push_back(l); }
+
+	/*! \brief Removes all lights!
+	 */
+	void clearLights(void) throw() { this->lights.clear(); }
+
+	/*! \brief Returns the number of lights!
+	 *
+	 * \return Number of lights.
+	 */
+	SPLsizei getLightCount(void) const throw() { return SPLsizei(this->lights.size()); }
+
+	/*! \brief Sets the distance of two samples!
+	 *
+	 * The opacities of the material are corrected to the step size.
+	 *
+	 * \param s Step size in voxels (positive).
+	 */
+	void setStepSize(const SPLieee32 s) throw() { assert(s > 0.0f); this->step = s; }
+
+	/*! \brief Returns the distance of two samples!
+	 *
+	 * \return Step size in voxels.
+	 */
+	SPLieee32 getStepSize(void) const throw() { return this->step; }
+
+	/*! \brief Sets the threshold of the early ray termination!
+	 *
+	 * \param t Opacity which terminates a ray (\f$ > 1 \f$ disables the early termination).
+	 */
+	void setTermination(const SPLieee32 t) throw() { this->termination = t; }
+
+	/*! \brief Returns the threshold of the early ray termination!
+	 *
+	 * \return Opacity which terminates a ray.
+	 */
+	SPLieee32 getTermination(void) const throw() { return this->termination; }
+
+	/*! \brief Sets the size of the tiles!
+	 *
+	 * \param s Edge length of the tiles in pixels (positive).
+	 */
+	void setTileSize(const SPLsizei s) throw() { assert(s > 0); this->tile = s; }
+
+	/*! \brief Returns the size of the tiles!
+	 *
+	 * \return Edge length of the tiles in pixels.
+	 */
+	SPLsizei getTileSize(void) const throw() { return this->tile; }
+
+	/*! \brief Sets the macrocells for empty space skipping!
+	 *
+	 * \param cells The macrocells of the rendered volume (must be up to date) or \c NULL.
+	 */
+	void setMacroCells(const SPLMacroCells<T> *cells) throw() { this->cells = cells; }
+
+	/*! \brief Returns the macrocells for empty space skipping!
+	 *
+	 * \return The macrocells or \c NULL.
+	 */
+	const SPLMacroCells<T>* getMacroCells(void) const throw() { return this->cells; }
+
+	/*! \brief Sets the gradients for shading!
+	 *
+	 * \param gradients The gradients of the rendered volume, or \c NULL for
+	 * central differences of the interpolated volume per sample.
+	 */
+	void setGradients(const SPLGradientVolume<T> *gradients) throw() { this->gradients = gradients; }
+
+	/*! \brief Returns the gradients for shading!
+	 *
+	 * \return The gradients or \c NULL.
+	 */
+	const SPLGradientVolume<T>* getGradients(void) const throw() { return this->gradients; }
+
+	/*! \brief Enables or disables the pre-integration!
+	 *
+	 * \param p Whether to composite pre-integrated ray segments instead of samples.
+	 */
+	void setPreIntegration(const bool p) throw() { this->preintegration = p; }
+
+	/*! \brief Returns whether the pre-integration is enabled!
+	 *
+	 * \return \c true if ray segments are pre-integrated.
+	 */
+	bool isPreIntegration(void) const throw() { return this->preintegration; }
+
+	/*! \brief Returns the lookup tables of the material!
+	 *
+	 * \return The tables of the last \ref render.
+	 */
+	const SPLMaterialTable& getMaterialTable(void) const throw() { return this->table; }
+
+	/*! \brief Renders a volume!
+	 *
+	 * \param volume The volume.
+	 * \param camera The camera.
+	 * \param frame The RGBA frame, which is resized to the viewport.
+	 * \param pool The threads.
+	 *
+	 * \return \c true on success and \c false otherwise.
+	 */
+	bool render(const SPLGrid<T> &volume, const SPLCamera &camera, SPLGrid<SPLVector4f> &frame,
+				SPLThreadPool &pool = SPLThreadPool::getGlobal()) throw();
+
+	/*! \brief Returns the number of samples of the last frame!
+	 *
+	 * \return Number of samples taken by \ref render.
+	 */
+	SPLint64 getSamples(void) const throw() { return this->samples; }
+
+private:
+	/*! \brief Returns the trilinear interpolation at a point inside the volume!
+	 */
+	static SPLieee32 sample(const SPLGrid<T> &volume, const SPLVector3f &p) throw();
+
+	/*! \brief Returns the gradient of central differences at a point inside the volume!
+	 */
+	static SPLVector3f gradient(const SPLGrid<T> &volume, const SPLVector3f &p) throw();
+
+	/*! \brief Returns the reflected light of a sample!
+	 */
+	SPLVector3f shade(const SPLGrid<T> &volume, const SPLMatrix3f &normal, const SPLVector3f &p, const SPLindex i,
+					  const SPLVector3f &view) const throw();
+
+	/*! \brief Casts the ray through a window position!
+	 */
+	SPLVector4f cast(const SPLGrid<T> &volume, const SPLMatrix4f &unprojection, const SPLMatrix3f &normal,
+					 const SPLieee32 x, const SPLieee32 y, const bool shaded, const SPLuint8 *visible, SPLint64 &count) const throw();
+
+	SPLMatrix4f model;				//!< Object to world coordinates.
+	SPLMaterial material;			//!< The material.
+	SPLMaterialTable table;			//!< Lookup tables of the material.
+	bool preintegration;			//!< Whether to pre-integrate ray segments.
+	std::vector<SPLLight> lights;	//!< The lights.
+	SPLieee32 step;					//!< Step size in voxels.
+	SPLieee32 termination;			//!< Opacity of the early ray termination.
+	SPLsizei tile;					//!< Edge length of the tiles.
+	const SPLMacroCells<T> *cells;	//!< Macrocells of the volume.
+	const SPLGradientVolume<T> *gradients;	//!< Gradients of the volume.
+	SPLint64 samples;				//!< Samples of the last frame.
+};
+
+/************************************************************************************************
+ ** SPLRayCaster class implementation
+ ************************************************************************************************/
+template <class T>
+SPLRayCaster<T>::SPLRayCaster(void) throw()
+{
+	this->step = 0.5f;
+	this->termination = 0.99f;
+	this->tile = 16;
+	this->cells = NULL;
+	this->gradients = NULL;
+	this->preintegration = false;
+	this->samples = 0;
+}
+
+template <class T>
+bool SPLRayCaster<T>::render(const SPLGrid<T> &volume, const SPLCamera &camera, SPLGrid<SPLVector4f> &frame, SPLThreadPool &pool) throw()
+{
+	const SPLVector3i &n = volume.getSize();
+	const SPLVector4i &viewport = camera.getViewport();
+	if (n.x <= 0 || n.y <= 0 || n.z <= 0)
+	{
+		return false;
+	}
+	const SPLVector3i size(viewport.z, viewport.w, 1);
+	if (frame.getSize() != size && !frame.resize(size))
+	{
+		return false;
+	}
+
+	const SPLMatrix4f unprojection = camera.getUnprojection(this->model);
+	const SPLMatrix3f normal = this->model.getNormalMatrix();
+	const bool shaded = this->material.isShaded() && !this->lights.empty();
+	if ((this->cells && this->cells->getSize() != n) || (this->gradients && this->gradients->getSize() != n))
+	{
+		return false;
+	}
+	this->table.update(this->material, this->step, this->preintegration, pool);
+	std::vector<SPLuint8> visible;
+	if (this->cells)
+	{
+		this->cells->classify(0, this->table, visible, pool);
+	}
+	const SPLint64 tx = (size.x + this->tile - 1) / this->tile, ty = (size.y + this->tile - 1) / this->tile;
+
+	std::atomic<SPLint64> total(0);
+	pool.parallelFor(0, tx * ty, 1, [&](const SPLint64 first, const SPLint64 last)
+	{
+		SPLint64 count = 0;
+		for (SPLint64 t = first; t < last; t++)
+		{
+			const SPLindex x0 = SPLindex(t % tx) * this->tile, y0 = SPLindex(t / tx) * this->tile;
+			const SPLindex x1 = MIN(x0 + this->tile, size.x), y1 = MIN(y0 + this->tile, size.y);
+			for (SPLindex y = y0; y < y1; y++)
+			{
+				// the first row is the top, the window origin is the bottom
+				const SPLieee32 wy = SPLieee32(viewport.y + size.y - 1 - y) + 0.5f;
+				for (SPLindex x = x0; x < x1; x++)
+				{
+					frame(x, y, 0) = this->cast(volume, unprojection, normal, SPLieee32(viewport.x + x) + 0.5f, wy, shaded,
+											   visible.empty() ? NULL : &visible[0], count);
+				}
+			}
+		}
+		total += count;
+	});
+	this->samples = total;
+	return true;
+}
+
+template <class T>
+SPLieee32 SPLRayCaster<T>::sample(const SPLGrid<T> &volume, const SPLVector3f &p) throw()
+{
+	const SPLVector3i &n = volume.getSize();
+	const SPLint64 *ox = volume.getOffsets(0), *oy = volume.getOffsets(1), *oz = volume.getOffsets(2);
+	const T *data = volume.getData();
+
+	const SPLindex x0 = MIN(SPLindex(p.x), n.x - 1), y0 = MIN(SPLindex(p.y), n.y - 1), z0 = MIN(SPLindex(p.z), n.z - 1);
+	const SPLindex x1 = MIN(x0 + 1, n.x - 1), y1 = MIN(y0 + 1, n.y - 1), z1 = MIN(z0 + 1, n.z - 1);
+	const SPLieee32 fx = p.x - SPLieee32(x0), fy = p.y - SPLieee32(y0), fz = p.z - SPLieee32(z0);
+
+	const SPLint64 a = oy[y0] + oz[z0], b = oy[y1] + oz[z0], c = oy[y0] + oz[z1], d = oy[y1] + oz[z1];
+	const SPLieee32 v00 = SPLieee32(data[ox[x0] + a]) + fx * (SPLieee32(data[ox[x1] + a]) - SPLieee32(data[ox[x0] + a]));
+	const SPLieee32 v10 = SPLieee32(data[ox[x0] + b]) + fx * (SPLieee32(data[ox[x1] + b]) - SPLieee32(data[ox[x0] + b]));
+	const SPLieee32 v01 = SPLieee32(data[ox[x0] + c]) + fx * (SPLieee32(data[ox[x1] + c]) - SPLieee32(data[ox[x0] + c]));
+	const SPLieee32 v11 = SPLieee32(data[ox[x0] + d]) + fx * (SPLieee32(data[ox[x1] + d]) - SPLieee32(data[ox[x0] + d]));
+	const SPLieee32 v0 = v00 + fy * (v10 - v00), v1 = v01 + fy * (v11 - v01);
+	return v0 + fz * (v1 - v0);
+}
+
+template <class T>
+SPLVector3f SPLRayCaster<T>::gradient(const SPLGrid<T> &volume, const SPLVector3f &p) throw()
+{
+	const SPLVector3i &n = volume.getSize();
+	const SPLieee32 hx = SPLieee32(n.x - 1), hy = SPLieee32(n.y - 1), hz = SPLieee32(n.z - 1);
+	return SPLVector3f(
+		sample(volume, SPLVector3f(MIN(p.x + 1.0f, hx), p.y, p.z)) - sample(volume, SPLVector3f(MAX(p.x - 1.0f, 0.0f), p.y, p.z)),
+		sample(volume, SPLVector3f(p.x, MIN(p.y + 1.0f, hy), p.z)) - sample(volume, SPLVector3f(p.x, MAX(p.y - 1.0f, 0.0f), p.z)),
+		sample(volume, SPLVector3f(p.x, p.y, MIN(p.z + 1.0f, hz))) - sample(volume, SPLVector3f(p.x, p.y, MAX(p.z - 1.0f, 0.0f))));
+}
+
+template <class T>
+SPLVector3f SPLRayCaster<T>::shade(const SPLGrid<T> &volume, const SPLMatrix3f &normal, const SPLVector3f &p, const SPLindex i,
+								   const SPLVector3f &view) const throw()
+{
+	const SPLVector3f g = normal * (this->gradients ? this->gradients->getGradient(p) : gradient(volume, p));
+	if (g.x == 0.0f && g.y == 0.0f && g.z == 0.0f)
+	{
+		return SPLVector3f(0.0f, 0.0f, 0.0f);
+	}
+	const SPLMaterialTable &m = this->table;
+	const SPLVector3f ka(m.getChannel(SPL_MATERIAL_AMBIENT_RED)[i], m.getChannel(SPL_MATERIAL_AMBIENT_GREEN)[i],
+						 m.getChannel(SPL_MATERIAL_AMBIENT_BLUE)[i]);
+	const SPLVector3f kd(m.getChannel(SPL_MATERIAL_DIFFUSE_RED)[i], m.getChannel(SPL_MATERIAL_DIFFUSE_GREEN)[i],
+						 m.getChannel(SPL_MATERIAL_DIFFUSE_BLUE)[i]);
+	const SPLVector3f ks(m.getChannel(SPL_MATERIAL_SPECULAR_RED)[i], m.getChannel(SPL_MATERIAL_SPECULAR_GREEN)[i],
+						 m.getChannel(SPL_MATERIAL_SPECULAR_BLUE)[i]);
+	return splShadePhong(ka, kd, ks, m.getChannel(SPL_MATERIAL_SHININESS)[i], this->model.transformPoint(p), g.getNormalized(1.0f),
+						 view, &this->lights[0], SPLsizei(this->lights.size()));
+}
+
+template <class T>
+SPLVector4f SPLRayCaster<T>::cast(const SPLGrid<T> &volume, const SPLMatrix4f &unprojection, const SPLMatrix3f &normal,
+								  const SPLieee32 x, const SPLieee32 y, const bool shaded, const SPLuint8 *visible, SPLint64 &count) const throw()
+{
+	SPLVector4f ret(0.0f, 0.0f, 0.0f, 0.0f);
+	SPLVector3f origin, direction;
+	SPLCamera::getRay(unprojection, x, y, origin, direction);
+	const SPLieee32 length = SPLieee32(direction.length());
+	if (!(length > 0.0f))
+	{
+		return ret;
+	}
+	direction /= length;
+
+	// clip the ray to the box of the voxel centers (slab method)
+	const SPLVector3i &n = volume.getSize();
+	const SPLVector3f hi(SPLieee32(n.x - 1), SPLieee32(n.y - 1), SPLieee32(n.z - 1));
+	SPLieee32 t0 = 0.0f, t1 = length;
+	for (SPLindex i = 0; i < 3; i++)
+	{
+		if (direction[i] == 0.0f)
+		{
+			if (origin[i] < 0.0f || origin[i] > hi[i])
+			{
+				return ret;
+			}
+			continue;
+		}
+		const SPLieee32 a = -origin[i] / direction[i], b = (hi[i] - origin[i]) / direction[i];
+		t0 = MAX(t0, MIN(a, b));
+		t1 = MIN(t1, MAX(a, b));
+	}
+	if (t0 > t1)
+	{
+		return ret;
+	}
+
+	SPLVector3f view;
+	if (shaded)
+	{
+		view = -this->model.transformVector(direction).getNormalized(1.0f);
+	}
+	const auto at = [&](const SPLint64 k)
+	{
+		const SPLVector3f q = origin + direction * (t0 + SPLieee32(k) * this->step);
+		return SPLVector3f(CLAMP(q.x, 0.0f, hi.x), CLAMP(q.y, 0.0f, hi.y), CLAMP(q.z, 0.0f, hi.z));
+	};
+	const bool preintegrated = this->table.isPreIntegrated();
+	// the samples are at t0 + k * step with and without skipping, front is the entry of sample k - 1 or -1
+	SPLindex front = -1;
+	for (SPLint64 k = 0; ; k++)
+	{
+		const SPLieee32 t = t0 + SPLieee32(k) * this->step;
+		if (t > t1)
+		{
+			break;
+		}
+		const SPLVector3f p = at(k);
+		SPLint64 next = k;
+		if (visible)
+		{
+			const SPLsizei size = this->cells->getCellSize();
+			const SPLVector3i &cc = this->cells->getCellCount(0);
+			const SPLVector3i c(MIN(SPLindex(p.x) / size, cc.x - 1), MIN(SPLindex(p.y) / size, cc.y - 1), MIN(SPLindex(p.z) / size, cc.z - 1));
+			if (!visible[this->cells->getIndex(0, c.x, c.y, c.z)])
+			{
+				// skip the samples inside the cell, keeping a margin for rounding
+				SPLieee32 exit = t1;
+				for (SPLindex i = 0; i < 3; i++)
+				{
+					if (direction[i] != 0.0f)
+					{
+						const SPLieee32 plane = SPLieee32((direction[i] > 0.0f) ? (c[i] + 1) * size : c[i] * size);
+						exit = MIN(exit, (plane - origin[i]) / direction[i]);
+					}
+				}
+				next = MAX(k, SPLint64(std::ceil((exit - 0.01f - t0) / this->step)) - 1);
+				// a segment is transparent only if both of its ends are inside the cell
+				if (!preintegrated)
+				{
+					k = next;
+					continue;
+				}
+			}
+		}
+		count++;
+		const SPLindex i = this->table.getIndex(sample(volume, p));
+		SPLVector4f e;
+		if (preintegrated)
+		{
+			// the first sample only starts a segment
+			if (k > 0 && front < 0)
+			{
+				count++;
+				front = this->table.getIndex(sample(volume, at(k - 1)));
+			}
+			e = (front < 0) ? SPLVector4f(0.0f, 0.0f, 0.0f, 0.0f) : this->table.getSegment(front, i);
+			front = (next > k) ? -1 : i;
+		}
+		else
+		{
+			e = this->table.getSample(i);
+		}
+		k = next;
+		if (e.w <= 0.0f)
+		{
+			continue;
+		}
+
+		if (shaded)
+		{
+			const SPLVector3f c = this->shade(volume, normal, p, i, view) * e.w;
+			e.x += c.x;
+			e.y += c.y;
+			e.z += c.z;
+		}
+		const SPLieee32 w = 1.0f - ret.w;
+		ret.x += w * e.x;
+		ret.y += w * e.y;
+		ret.z += w * e.z;
+		ret.w += w * e.w;
+		if (ret.w >= this->termination)
+		{
+			break;
+		}
+	}
+	return ret;
+}
+
+#endif /* _spl_raycaster_hh_ */
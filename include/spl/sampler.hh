@@ -0,0 +1,618 @@
+#ifndef _spl_sampler_hh_
+#define _spl_sampler_hh_
+
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+#include <spl/typesbase.hh>
+#include <spl/mathbase.hh>
+#include <spl/simd.hh>
+#include <spl/vector3.hh>
+#include <spl/vector3array.hh>
+#include <spl/grid.hh>
+
+#define SPL_SAMPLER_BLOCK 64		//!< Number of fixed point samples which are converted to float at once by the cubic filter.
+#define SPL_SAMPLER_FIXED_BITS 16	//!< Fraction bits of the fixed point coordinates.
+#define SPL_SAMPLER_WEIGHT_BITS 12	//!< Fraction bits of the fixed point weights.
+#define SPL_SAMPLER_AHEAD 16		//!< Distance in points of the voxels which are prefetched.
+#define SPL_SAMPLER_PREFETCH (1 << 22)	//!< Size in bytes of the grids beyond the caches, whose voxels are prefetched.
+
+/*! \file sampler.hh
+ * \brief Batched interpolation of grids at arbitrary points.
+ * */
+
+/*! \class SPLSampler
+ * \brief Interpolates a grid at batches of points.
+ *
+ * The voxel \f$ (x, y, z) \f$ is at the point \f$ (x, y, z) \f$, i.e.
+ * the points inside the grid are \f$ [0, n_x - 1] \times [0, n_y - 1]
+ * \times [0, n_z - 1] \f$. Three filters are provided:
+ *
+ * - \ref SPL_SAMPLER_NEAREST: the value of the nearest voxel.
+ * - \ref SPL_SAMPLER_LINEAR: the trilinear interpolation of the
+ *   \f$ 2^3 \f$ surrounding voxels.
+ * - \ref SPL_SAMPLER_CUBIC: the tricubic Catmull-Rom interpolation of
+ *   the \f$ 4^3 \f$ surrounding voxels, which passes through the voxels
+ *   and has continuous first derivatives.
+ *
+ * The voxels outside the grid are given by \ref SPL_BORDER_CLAMP or
+ * \ref SPL_BORDER_WRAP. The points are given as a structure of arrays,
+ * see \ref SPLVector3ArrayView, and are interpolated on
+ * \c SPLSimd<SPLieee32>::width points at once: the border, the floor
+ * and the weights are computed in registers, the voxel addresses are the
+ * sums of per-axis offsets tabulated for the border (gathered once per
+ * axis and tap), and all taps are accumulated in registers. The taps are
+ * loaded with the gather instructions of \ref SPLSimd for grids of
+ * \ref SPLieee32 below \f$ 2^{31} \f$ voxels and per lane otherwise.
+ *
+ * Grids of 8 and 16 bit voxels are also interpolated with fixed point
+ * coordinates of \ref SPL_SAMPLER_FIXED_BITS fraction bits, see
+ * \ref toFixed, and integer weights of \ref SPL_SAMPLER_WEIGHT_BITS bits
+ * in the integer registers of \ref SPLSimd, which returns voxels of the
+ * grid type without a conversion to float.
+ *
+ * The sampler keeps a pointer to the grid, which must stay valid and
+ * must not be resized. A sampler is not changed by the interpolation,
+ * i.e. the threads may share it.
+ *
+ * Example
+ * \code
+ * SPLSampler<SPLuint16> s;
+ * s.setVolume(volume, SPL_SAMPLER_CUBIC);
+ *
+ * SPLVector3Arrayf p(n);
+ * std::vector<SPLieee32> v(n);
+ * ...
+ * s.sample(p, &v[0]);
+ * \endcode
+ *
+ * \sa SPLGrid SPLVector3ArrayView
+ */
+template <class T>
+class SPLSampler
+{
+public:
+	/*! \brief Constructor!
+	 *
+	 * Initializes a sampler without a grid.
+	 */
+	SPLSampler(void) throw() : volume(NULL), filter(SPL_SAMPLER_LINEAR), border(SPL_BORDER_CLAMP), narrow(false) {}
+
+	/*! \brief Sets the grid!
+	 *
+	 * Tabulates the offsets of the voxels for the border.
+	 *
+	 * \param volume The grid with at least one voxel.
+	 * \param filter A \c SPL_SAMPLER_* identification number.
+	 * \param border \ref SPL_BORDER_CLAMP or \ref SPL_BORDER_WRAP.
+	 *
+	 * \return \c true on success and \c false otherwise.
+	 */
+	bool setVolume(const SPLGrid<T> &volume, const SPLenum filter = SPL_SAMPLER_LINEAR, const SPLenum border = SPL_BORDER_CLAMP) throw();
+
+	/*! \brief Returns the grid!
+	 *
+	 * \return Pointer to the grid or \c NULL.
+	 */
+	const SPLGrid<T>* getVolume(void) const throw() { return this->volume; }
+
+	/*! \brief Sets the filter!
+	 *
+	 * \param filter A \c SPL_SAMPLER_* identification number.
+	 */
+	void setFilter(const SPLenum filter) throw() { assert(filter > SPL_SAMPLER_MIN && filter < SPL_SAMPLER_MAX); this->filter = filter; }
+
+	/*! \brief Returns the filter!
+	 *
+	 * \return A \c SPL_SAMPLER_* identification number.
+	 */
+	SPLenum getFilter(void) const throw() { return this->filter; }
+
+	/*! \brief Returns the border mode!
+	 *
+	 * \return \ref SPL_BORDER_CLAMP or \ref SPL_BORDER_WRAP.
+	 */
+	SPLenum getBorder(void) const throw() { return this->border; }
+
+	/*! \brief Interpolates the grid at a batch of points!
+	 *
+	 * \param p The finite points.
+	 * \param v The \f$ n \f$ interpolated values (output).
+	 */
+	void sample(const SPLVector3ArrayView<SPLieee32> &p, SPLieee32 *v) const throw();
+
+	/*! \brief Interpolates the grid of 8 or 16 bit voxels at a batch of fixed point coordinates!
+	 *
+	 * The interpolated values are rounded to the nearest voxel value,
+	 * the cubic filter converts the coordinates to float. The grid must
+	 * have less than \f$ 2^{15} \f$ voxels along every axis.
+	 *
+	 * \param p The points with \ref SPL_SAMPLER_FIXED_BITS fraction bits, see \ref toFixed.
+	 * \param v The \f$ n \f$ interpolated values (output).
+	 */
+	void sample(const SPLVector3ArrayView<SPLint32> &p, T *v) const throw();
+
+	/*! \brief Interpolates the grid at a point!
+	 *
+	 * \param p The point.
+	 *
+	 * \return The interpolated value.
+	 */
+	SPLieee32 operator () (const SPLVector3f &p) const throw();
+
+	/*! \brief Converts points to fixed point coordinates!
+	 *
+	 * \param p The points.
+	 * \param q The points with \ref SPL_SAMPLER_FIXED_BITS fraction bits, rounded down (output).
+	 */
+	static void toFixed(const SPLVector3ArrayView<SPLieee32> &p, SPLVector3ArrayView<SPLint32> &q) throw();
+
+private:
+	template <SPLsizei K, class O>
+	void run(const SPLieee32 *px, const SPLieee32 *py, const SPLieee32 *pz, const SPLsizei n, SPLieee32 *v) const throw();
+	template <class O>
+	void runFixed(const SPLint32 *px, const SPLint32 *py, const SPLint32 *pz, const SPLsizei n, T *v) const throw();
+	template <class O>
+	const O* getTable(const SPLindex axis) const throw();
+
+	const SPLGrid<T> *volume;			//!< The grid.
+	SPLenum filter;						//!< The filter.
+	SPLenum border;						//!< The border mode.
+	bool narrow;						//!< Whether the offsets fit into 32 bits.
+	std::vector<SPLint64> offsets[3];	//!< Offsets of the coordinates \f$ [-3, n + 3] \f$ per axis.
+	std::vector<SPLint32> offsets32[3];	//!< The offsets in 32 bits if \ref narrow.
+};
+
+namespace SPLSamplerDetail
+{
+	//! The first tabulated coordinate is \f$ -3 \f$.
+	static const SPLindex origin = 3;
+
+	//! Rounds a value to the nearest value of the type, saturated for integer types.
+	template <class T>
+	inline T saturate(const SPLieee32 v) throw()
+	{
+		if constexpr (std::numeric_limits<T>::is_integer)
+		{
+			const SPLieee32 r = FLOOR(v + 0.5f);
+			return T(CLAMP(r, SPLieee32(std::numeric_limits<T>::min()), SPLieee32(std::numeric_limits<T>::max())));
+		}
+		else
+		{
+			return T(v);
+		}
+	}
+
+	//! The integer registers of the width of the registers \c S.
+	template <class S>
+	using Int = typename std::conditional<S::width == 1, SPLSimdScalar<SPLint32>, SPLSimd<SPLint32> >::type;
+
+	//! Linear interpolation of integer registers with fixed point weights.
+	template <class I>
+	inline typename I::Type lerp(const typename I::Type a, const typename I::Type b, const typename I::Type w) throw()
+	{
+		const typename I::Type r = I::add(I::mul(I::sub(b, a), w), I::set(1 << (SPL_SAMPLER_WEIGHT_BITS - 1)));
+		return I::add(a, I::shiftRight(r, SPL_SAMPLER_WEIGHT_BITS));
+	}
+
+	//! Clamps or wraps the coordinates \c c of an axis of \c m voxels and returns the index of the first tap.
+	template <class S, class I, SPLsizei K>
+	inline typename I::Type locate(typename S::Type &c, const SPLindex m, const bool wrap) throw()
+	{
+		const SPLieee32 size = SPLieee32(m);
+		if (wrap)
+		{
+			c = S::sub(c, S::mul(S::set(size), S::floor(S::div(c, S::set(size)))));
+		}
+		else
+		{
+			// outside [-2, n + 1] the clamped taps do not change
+			c = S::min(S::max(c, S::set(-2.0f)), S::set(size + 1.0f));
+		}
+		// the coordinates are above -3, i.e. the truncation of c + 3 is the floor
+		return I::sub(S::toInt(S::add(c, S::set((K == 1) ? 3.5f : 3.0f))), I::set(3));
+	}
+
+	//! Clamps or wraps the fixed point coordinates \c c of an axis of \c m voxels, rounded for the nearest voxel.
+	template <class I>
+	inline typename I::Type locateFixed(typename I::Type c, const SPLindex m, const bool wrap, const bool nearest) throw()
+	{
+		const SPLint32 one = 1 << SPL_SAMPLER_FIXED_BITS;
+		if (wrap)
+		{
+			const SPLint32 period = SPLint32(m) << SPL_SAMPLER_FIXED_BITS;
+			SPLint32 q[I::width];
+			I::store(q, c);
+			for (SPLindex j = 0; j < I::width; j++)
+			{
+				q[j] = ((q[j] % period) + period) % period;
+			}
+			c = I::load(q);
+		}
+		else
+		{
+			c = I::min(I::max(c, I::set(-2 * one)), I::set(SPLint32(m + 1) << SPL_SAMPLER_FIXED_BITS));
+		}
+		return nearest ? I::add(c, I::set(one >> 1)) : c;
+	}
+
+	//! Requests the cache lines of the first taps of the points of a register.
+	template <class I, class T, class O>
+	inline void prefetch(const T *data, const O *const (&table)[3], const typename I::Type (&index)[3]) throw()
+	{
+		SPLint32 q[3][I::width];
+		for (SPLindex a = 0; a < 3; a++)
+		{
+			I::store(q[a], index[a]);
+		}
+		for (SPLindex j = 0; j < I::width; j++)
+		{
+			splSimdPrefetch(data + (table[0][q[0][j]] + table[1][q[1][j]] + table[2][q[2][j]]));
+		}
+	}
+
+	//! Looks up the offsets of \c K taps per axis, in registers for 32 bit offsets and per lane otherwise.
+	template <class I, SPLsizei K, class O>
+	inline void offsets(const O *table, const typename I::Type index, typename I::Type *o, O (*lanes)[I::width]) throw()
+	{
+		if constexpr (std::is_same<O, SPLint32>::value)
+		{
+			for (SPLindex k = 0; k < K; k++)
+			{
+				o[k] = I::gather(table + k, index);
+			}
+		}
+		else
+		{
+			SPLint32 q[I::width];
+			I::store(q, index);
+			for (SPLindex k = 0; k < K; k++)
+			{
+				for (SPLindex j = 0; j < I::width; j++)
+				{
+					lanes[k][j] = table[q[j] + k];
+				}
+			}
+		}
+	}
+
+	//! Loads the voxels of the tap \f$ (a, b, c) \f$ as a register of \c S of values \c E.
+	template <class S, class I, class E, class T, class O, SPLsizei K>
+	inline typename S::Type tap(const T *data, const typename I::Type (&o)[3][K], const O (&lanes)[3][K][I::width],
+								const SPLindex a, const SPLindex b, const SPLindex c) throw()
+	{
+		if constexpr (std::is_same<O, SPLint32>::value && std::is_same<T, E>::value)
+		{
+			return S::gather(data, I::add(o[0][a], I::add(o[1][b], o[2][c])));
+		}
+		else if constexpr (std::is_same<O, SPLint32>::value && std::numeric_limits<T>::is_integer && sizeof(T) <= 2 && I::width > 1)
+		{
+			// gathers the aligned words of 32 bits which contain the voxels, i.e. the loads stay in the pages of the voxels
+			const SPLint32 size = SPLint32(sizeof(T)), skew = SPLint32(uintptr_t(data) & 3) / size, bits = 32 - 8 * size;
+			const typename I::Type address = I::add(I::add(o[0][a], I::add(o[1][b], o[2][c])), I::set(skew));
+			const typename I::Type word = I::gather((const SPLint32 *)(data - skew), I::shiftRight(address, (size == 1) ? 2 : 1));
+			typename I::Type x = I::shiftRightLanes(word, I::shiftLeft(I::bitAnd(address, I::set(4 / size - 1)), (size == 1) ? 3 : 4));
+			x = std::numeric_limits<T>::is_signed ? I::shiftRight(I::shiftLeft(x, bits), bits) : I::bitAnd(x, I::set((1 << (8 * size)) - 1));
+			if constexpr (std::is_same<E, SPLieee32>::value)
+			{
+				return I::toFloat(x);
+			}
+			else
+			{
+				return x;
+			}
+		}
+		else
+		{
+			E x[I::width];
+			if constexpr (std::is_same<O, SPLint32>::value)
+			{
+				SPLint32 q[I::width];
+				I::store(q, I::add(o[0][a], I::add(o[1][b], o[2][c])));
+				for (SPLindex j = 0; j < I::width; j++)
+				{
+					x[j] = E(data[q[j]]);
+				}
+			}
+			else
+			{
+				for (SPLindex j = 0; j < I::width; j++)
+				{
+					x[j] = E(data[lanes[0][a][j] + lanes[1][b][j] + lanes[2][c][j]]);
+				}
+			}
+			return S::load(x);
+		}
+	}
+}
+
+/************************************************************************************************
+ ** SPLSampler class implementation
+ ************************************************************************************************/
+template <class T>
+bool SPLSampler<T>::setVolume(const SPLGrid<T> &volume, const SPLenum filter, const SPLenum border) throw()
+{
+	assert(filter > SPL_SAMPLER_MIN && filter < SPL_SAMPLER_MAX);
+	assert(border == SPL_BORDER_CLAMP || border == SPL_BORDER_WRAP);
+	const SPLVector3i &n = volume.getSize();
+	if (n.x <= 0 || n.y <= 0 || n.z <= 0)
+	{
+		return false;
+	}
+	this->volume = &volume;
+	this->filter = filter;
+	this->border = border;
+
+	// the taps of the coordinates in [-2, n + 1] are in [-3, n + 3]
+	SPLint64 largest = 0;
+	for (SPLindex a = 0; a < 3; a++)
+	{
+		const SPLint64 *o = volume.getOffsets(a);
+		std::vector<SPLint64> &table = this->offsets[a];
+		table.resize(size_t(n[a] + 2 * SPLSamplerDetail::origin + 1));
+		SPLint64 m = 0;
+		for (SPLindex j = 0; j < SPLindex(table.size()); j++)
+		{
+			SPLindex i = j - SPLSamplerDetail::origin;
+			i = (border == SPL_BORDER_WRAP) ? ((i % n[a]) + n[a]) % n[a] : CLAMP(i, 0, n[a] - 1);
+			table[size_t(j)] = o[i];
+			m = MAX(m, o[i]);
+		}
+		largest += m;
+	}
+	this->narrow = largest < SPLint64(std::numeric_limits<SPLint32>::max());
+	for (SPLindex a = 0; a < 3; a++)
+	{
+		this->offsets32[a].assign(this->offsets[a].begin(), this->offsets[a].end());
+		if (!this->narrow)
+		{
+			this->offsets32[a].clear();
+		}
+	}
+	return true;
+}
+
+template <class T>
+template <class O>
+const O* SPLSampler<T>::getTable(const SPLindex axis) const throw()
+{
+	if constexpr (std::is_same<O, SPLint32>::value)
+	{
+		return &this->offsets32[axis][0] + SPLSamplerDetail::origin;
+	}
+	else
+	{
+		return &this->offsets[axis][0] + SPLSamplerDetail::origin;
+	}
+}
+
+template <class T>
+void SPLSampler<T>::sample(const SPLVector3ArrayView<SPLieee32> &p, SPLieee32 *v) const throw()
+{
+	assert(this->volume);
+	const SPLsizei n = p.size();
+	switch (this->filter)
+	{
+	case SPL_SAMPLER_NEAREST:
+		this->narrow ? this->run<1, SPLint32>(p.x, p.y, p.z, n, v) : this->run<1, SPLint64>(p.x, p.y, p.z, n, v);
+		break;
+	case SPL_SAMPLER_LINEAR:
+		this->narrow ? this->run<2, SPLint32>(p.x, p.y, p.z, n, v) : this->run<2, SPLint64>(p.x, p.y, p.z, n, v);
+		break;
+	default:
+		this->narrow ? this->run<4, SPLint32>(p.x, p.y, p.z, n, v) : this->run<4, SPLint64>(p.x, p.y, p.z, n, v);
+		break;
+	}
+}
+
+template <class T>
+void SPLSampler<T>::sample(const SPLVector3ArrayView<SPLint32> &p, T *v) const throw()
+{
+	static_assert(std::numeric_limits<T>::is_integer && sizeof(T) <= 2, "fixed point interpolation of 8 and 16 bit voxels");
+	assert(this->volume);
+	const SPLsizei n = p.size();
+	if (this->filter != SPL_SAMPLER_CUBIC)
+	{
+		this->narrow ? this->runFixed<SPLint32>(p.x, p.y, p.z, n, v) : this->runFixed<SPLint64>(p.x, p.y, p.z, n, v);
+		return;
+	}
+	for (SPLindex first = 0; first < n; first += SPL_SAMPLER_BLOCK)
+	{
+		const SPLsizei count = MIN(SPLsizei(SPL_SAMPLER_BLOCK), n - first);
+		SPLieee32 q[3][SPL_SAMPLER_BLOCK], r[SPL_SAMPLER_BLOCK];
+		const SPLieee32 s = 1.0f / SPLieee32(1 << SPL_SAMPLER_FIXED_BITS);
+		for (SPLindex i = 0; i < count; i++)
+		{
+			q[0][i] = SPLieee32(p.x[first + i]) * s;
+			q[1][i] = SPLieee32(p.y[first + i]) * s;
+			q[2][i] = SPLieee32(p.z[first + i]) * s;
+		}
+		this->narrow ? this->run<4, SPLint32>(q[0], q[1], q[2], count, r) : this->run<4, SPLint64>(q[0], q[1], q[2], count, r);
+		for (SPLindex i = 0; i < count; i++)
+		{
+			v[first + i] = SPLSamplerDetail::saturate<T>(r[i]);
+		}
+	}
+}
+
+template <class T>
+SPLieee32 SPLSampler<T>::operator () (const SPLVector3f &p) const throw()
+{
+	SPLieee32 x = p.x, y = p.y, z = p.z, v = 0.0f;
+	this->sample(SPLVector3ArrayView<SPLieee32>(&x, &y, &z, 1), &v);
+	return v;
+}
+
+template <class T>
+void SPLSampler<T>::toFixed(const SPLVector3ArrayView<SPLieee32> &p, SPLVector3ArrayView<SPLint32> &q) throw()
+{
+	assert(q.size() == p.size());
+	const SPLieee32 s = SPLieee32(1 << SPL_SAMPLER_FIXED_BITS);
+	splSimdForEach<SPLieee32>(p.size(), [&](auto simd, const SPLindex i)
+	{
+		typedef decltype(simd) S;
+		S::storeInt(q.x + i, S::floor(S::mul(S::load(p.x + i), S::set(s))));
+		S::storeInt(q.y + i, S::floor(S::mul(S::load(p.y + i), S::set(s))));
+		S::storeInt(q.z + i, S::floor(S::mul(S::load(p.z + i), S::set(s))));
+	});
+}
+
+template <class T>
+template <SPLsizei K, class O>
+void SPLSampler<T>::run(const SPLieee32 *px, const SPLieee32 *py, const SPLieee32 *pz, const SPLsizei n, SPLieee32 *v) const throw()
+{
+	// the taps of a point are at floor(p) - 1 ... floor(p) + 2 (cubic), floor(p) ... floor(p) + 1 (linear) or round(p) (nearest)
+	const SPLindex first = (K == 4) ? -1 : 0;
+	const bool wrap = (this->border == SPL_BORDER_WRAP);
+	const SPLVector3i &size = this->volume->getSize();
+	const SPLieee32 *p[3] = { px, py, pz };
+	const O *table[3] = { this->getTable<O>(0) + first, this->getTable<O>(1) + first, this->getTable<O>(2) + first };
+	const T *data = this->volume->getData();
+	const bool ahead = this->volume->getStorageSize() * SPLint64(sizeof(T)) > SPL_SAMPLER_PREFETCH;
+	splSimdForEach<SPLieee32>(n, [&](auto simd, const SPLindex i)
+	{
+		typedef decltype(simd) S;
+		typedef typename S::Type V;
+		typedef SPLSamplerDetail::Int<S> I;
+		typename I::Type o[3][K];	// the offsets of the taps in registers if narrow
+		O lanes[3][K][S::width];	// and per lane otherwise
+		V w[3][K];
+		if (ahead && i + SPL_SAMPLER_AHEAD + SPLindex(S::width) <= n)
+		{
+			typename I::Type index[3];
+			for (SPLindex a = 0; a < 3; a++)
+			{
+				V c = S::load(p[a] + i + SPL_SAMPLER_AHEAD);
+				index[a] = SPLSamplerDetail::locate<S, I, K>(c, size[a], wrap);
+			}
+			SPLSamplerDetail::prefetch<I>(data, table, index);
+		}
+		for (SPLindex a = 0; a < 3; a++)
+		{
+			V c = S::load(p[a] + i);
+			const typename I::Type index = SPLSamplerDetail::locate<S, I, K>(c, size[a], wrap);
+			if constexpr (K > 1)
+			{
+				const V t = S::sub(c, I::toFloat(index));
+				if constexpr (K == 2)
+				{
+					w[a][0] = t;
+				}
+				else
+				{
+					// Catmull-Rom weights
+					const V h = S::set(0.5f), t2 = S::mul(t, t);
+					w[a][0] = S::mul(h, S::mul(t, S::sub(S::mul(S::sub(S::set(2.0f), t), t), S::set(1.0f))));
+					w[a][1] = S::mul(h, S::add(S::mul(t2, S::sub(S::mul(S::set(3.0f), t), S::set(5.0f))), S::set(2.0f)));
+					w[a][2] = S::mul(h, S::mul(t, S::add(S::mul(S::sub(S::set(4.0f), S::mul(S::set(3.0f), t)), t), S::set(1.0f))));
+					w[a][3] = S::mul(h, S::mul(S::sub(t, S::set(1.0f)), t2));
+				}
+			}
+			SPLSamplerDetail::offsets<I, K>(table[a], index, o[a], lanes[a]);
+		}
+
+		// the taps along x are weighted with wx, the rows of a slice with wy and the slices with wz
+		auto weigh = [&](const V *x, const V *weight) -> V
+		{
+			if constexpr (K == 1)
+			{
+				return x[0];
+			}
+			else if constexpr (K == 2)
+			{
+				return S::add(x[0], S::mul(weight[0], S::sub(x[1], x[0])));
+			}
+			else
+			{
+				V r = S::mul(x[0], weight[0]);
+				for (SPLindex k = 1; k < K; k++)
+				{
+					r = S::add(r, S::mul(x[k], weight[k]));
+				}
+				return r;
+			}
+		};
+		V plane[K];
+		for (SPLindex c = 0; c < K; c++)
+		{
+			V row[K];
+			for (SPLindex b = 0; b < K; b++)
+			{
+				V x[K];
+				for (SPLindex a = 0; a < K; a++)
+				{
+					x[a] = SPLSamplerDetail::tap<S, I, SPLieee32>(data, o, lanes, a, b, c);
+				}
+				row[b] = weigh(x, w[0]);
+			}
+			plane[c] = weigh(row, w[1]);
+		}
+		S::store(v + i, weigh(plane, w[2]));
+	});
+}
+
+template <class T>
+template <class O>
+void SPLSampler<T>::runFixed(const SPLint32 *px, const SPLint32 *py, const SPLint32 *pz, const SPLsizei n, T *v) const throw()
+{
+	const SPLVector3i &size = this->volume->getSize();
+	const bool wrap = (this->border == SPL_BORDER_WRAP), nearest = (this->filter == SPL_SAMPLER_NEAREST);
+	const SPLint32 *p[3] = { px, py, pz };
+	const O *table[3] = { this->getTable<O>(0), this->getTable<O>(1), this->getTable<O>(2) };
+	const T *data = this->volume->getData();
+	const bool ahead = this->volume->getStorageSize() * SPLint64(sizeof(T)) > SPL_SAMPLER_PREFETCH;
+	splSimdForEach<SPLieee32>(n, [&](auto simd, const SPLindex i)
+	{
+		typedef SPLSamplerDetail::Int<decltype(simd)> I;
+		typedef typename I::Type R;
+		R o[3][2], weight[3];
+		O lanes[3][2][I::width];
+		if (ahead && i + SPL_SAMPLER_AHEAD + SPLindex(I::width) <= n)
+		{
+			R index[3];
+			for (SPLindex a = 0; a < 3; a++)
+			{
+				const R c = SPLSamplerDetail::locateFixed<I>(I::load(p[a] + i + SPL_SAMPLER_AHEAD), size[a], wrap, nearest);
+				index[a] = I::shiftRight(c, SPL_SAMPLER_FIXED_BITS);
+			}
+			SPLSamplerDetail::prefetch<I>(data, table, index);
+		}
+		for (SPLindex a = 0; a < 3; a++)
+		{
+			const R c = SPLSamplerDetail::locateFixed<I>(I::load(p[a] + i), size[a], wrap, nearest);
+			const R index = I::shiftRight(c, SPL_SAMPLER_FIXED_BITS);
+			weight[a] = I::shiftRight(I::sub(c, I::shiftLeft(index, SPL_SAMPLER_FIXED_BITS)), SPL_SAMPLER_FIXED_BITS - SPL_SAMPLER_WEIGHT_BITS);
+			SPLSamplerDetail::offsets<I, 2>(table[a], index, o[a], lanes[a]);
+		}
+
+		R r;
+		if (nearest)
+		{
+			r = SPLSamplerDetail::tap<I, I, SPLint32>(data, o, lanes, 0, 0, 0);
+		}
+		else
+		{
+			const R wx = weight[0], wy = weight[1], wz = weight[2];
+			R x[2][2];
+			for (SPLindex c = 0; c < 2; c++)
+			{
+				for (SPLindex b = 0; b < 2; b++)
+				{
+					x[c][b] = SPLSamplerDetail::lerp<I>(SPLSamplerDetail::tap<I, I, SPLint32>(data, o, lanes, 0, b, c),
+														SPLSamplerDetail::tap<I, I, SPLint32>(data, o, lanes, 1, b, c), wx);
+				}
+			}
+			r = SPLSamplerDetail::lerp<I>(SPLSamplerDetail::lerp<I>(x[0][0], x[0][1], wy), SPLSamplerDetail::lerp<I>(x[1][0], x[1][1], wy), wz);
+		}
+		SPLint32 q[I::width];
+		I::store(q, r);
+		for (SPLindex j = 0; j < I::width; j++)
+		{
+			v[i + j] = T(q[j]);
+		}
+	});
+}
+
+#endif /* _spl_sampler_hh_ */
@@ -0,0 +1,160 @@
+#ifndef _spl_shading_hh_
+#define _spl_shading_hh_
+
+#include <spl/typesbase.hh>
+#include <spl/mathbase.hh>
+#include <spl/simd.hh>
+#include <spl/vector3array.hh>
+#include <spl/light.hh>
+#include <spl/materialtable.hh>
+
+#define SPL_SHADING_CHUNK 256	//!< Number of samples whose coefficients are gathered at once by the batched shading.
+
+/*! \file shading.hh
+ * \brief Batched Phong shading of samples in structure-of-arrays form.
+ * */
+
+/*! \brief Batched Phong shading of samples!
+ *
+ * Computes the same Blinn-Phong model as the \ref splShadePhong of a
+ * single voxel for \f$ n \f$ samples at once. The coefficients of the
+ * ambient, diffuse, specular and shininess channels are gathered from
+ * the tables at the material indices, then all lights are evaluated
+ * for \c SPLSimd<SPLieee32>::width samples per instruction, i.e. the
+ * branches of the light types are taken once per light and chunk of
+ * \ref SPL_SHADING_CHUNK samples instead of once per sample. Lights
+ * without intensity are skipped.
+ *
+ * The specular and spot exponents are computed with the fast
+ * \ref SPLSimdScalar::pow "pow" of \ref SPLSimd, which has a relative
+ * error of about \f$ 10^{-5} k_e \f$.
+ *
+ * Example
+ * \code
+ * SPLVector3Arrayf p(n), normals(n), v(n), c(n);
+ * std::vector<SPLindex> m(n);
+ * ...
+ * m[i] = table.getIndex(value[i]);
+ * ...
+ * splShadePhong(table, &m[0], p, normals, v, &lights[0], SPLsizei(lights.size()), c);
+ * \endcode
+ *
+ * \param table The tables of the material, see \ref SPLMaterialTable::getChannel.
+ * \param materials Array of \f$ n \f$ table indices, see \ref SPLMaterialTable::getIndex.
+ * \param positions The \f$ n \f$ positions.
+ * \param normals The \f$ n \f$ unit normals.
+ * \param views The \f$ n \f$ unit directions from the positions to the viewer.
+ * \param lights Array of lights.
+ * \param count Number of lights.
+ * \param colors The \f$ n \f$ reflected red, green and blue lights (output).
+ *
+ * \sa SPLLight SPLMaterialTable
+ */
+inline void splShadePhong(const SPLMaterialTable &table, const SPLindex *materials, const SPLVector3ArrayView<SPLieee32> &positions,
+						  const SPLVector3ArrayView<SPLieee32> &normals, const SPLVector3ArrayView<SPLieee32> &views,
+						  const SPLLight *lights, const SPLsizei count, SPLVector3ArrayView<SPLieee32> &colors) throw();
+
+/************************************************************************************************
+ ** Functions
+ ************************************************************************************************/
+inline void splShadePhong(const SPLMaterialTable &table, const SPLindex *materials, const SPLVector3ArrayView<SPLieee32> &positions,
+						  const SPLVector3ArrayView<SPLieee32> &normals, const SPLVector3ArrayView<SPLieee32> &views,
+						  const SPLLight *lights, const SPLsizei count, SPLVector3ArrayView<SPLieee32> &colors) throw()
+{
+	const SPLsizei n = colors.size();
+	assert(positions.size() == n && normals.size() == n && views.size() == n);
+	assert(count == 0 || lights);
+
+	// ambient, diffuse and specular red, green and blue and the shininess
+	const SPLenum channels[10] = { SPL_MATERIAL_AMBIENT_RED, SPL_MATERIAL_AMBIENT_GREEN, SPL_MATERIAL_AMBIENT_BLUE,
+								   SPL_MATERIAL_DIFFUSE_RED, SPL_MATERIAL_DIFFUSE_GREEN, SPL_MATERIAL_DIFFUSE_BLUE,
+								   SPL_MATERIAL_SPECULAR_RED, SPL_MATERIAL_SPECULAR_GREEN, SPL_MATERIAL_SPECULAR_BLUE,
+								   SPL_MATERIAL_SHININESS };
+	const SPLieee32 *tables[10];
+	for (SPLindex c = 0; c < 10; c++)
+	{
+		tables[c] = table.getChannel(channels[c]);
+	}
+
+	SPLieee32 k[10][SPL_SHADING_CHUNK];
+	for (SPLindex first = 0; first < n; first += SPL_SHADING_CHUNK)
+	{
+		const SPLsizei m = MIN(n - first, SPLsizei(SPL_SHADING_CHUNK));
+		for (SPLindex c = 0; c < 10; c++)
+		{
+			const SPLieee32 *t = tables[c];
+			for (SPLindex j = 0; j < m; j++)
+			{
+				assert(materials[first + j] >= 0 && materials[first + j] < table.getSize());
+				k[c][j] = t[materials[first + j]];
+			}
+		}
+
+		splSimdForEach<SPLieee32>(m, [&](auto simd, const SPLindex j)
+		{
+			typedef decltype(simd) S;
+			typedef typename S::Type R;
+			const SPLindex i = first + j;
+			const R zero = S::set(0.0f);
+			const R px = S::load(positions.x + i), py = S::load(positions.y + i), pz = S::load(positions.z + i);
+			const R vx = S::load(views.x + i), vy = S::load(views.y + i), vz = S::load(views.z + i);
+			R nx = S::load(normals.x + i), ny = S::load(normals.y + i), nz = S::load(normals.z + i);
+
+			// two-sided lighting
+			const R nv = S::add(S::add(S::mul(nx, vx), S::mul(ny, vy)), S::mul(nz, vz));
+			nx = S::selectNegative(nv, S::sub(zero, nx), nx);
+			ny = S::selectNegative(nv, S::sub(zero, ny), ny);
+			nz = S::selectNegative(nv, S::sub(zero, nz), nz);
+
+			const R kar = S::load(k[0] + j), kag = S::load(k[1] + j), kab = S::load(k[2] + j);
+			const R kdr = S::load(k[3] + j), kdg = S::load(k[4] + j), kdb = S::load(k[5] + j);
+			const R ksr = S::load(k[6] + j), ksg = S::load(k[7] + j), ksb = S::load(k[8] + j);
+			const R shininess = S::load(k[9] + j);
+
+			R r = zero, g = zero, b = zero;
+			for (SPLsizei l = 0; l < count; l++)
+			{
+				const SPLLight &light = lights[l];
+				const SPLVector3f &c = light.getColor(), &d = light.getDirection();
+				if (c.x == 0.0f && c.y == 0.0f && c.z == 0.0f)
+				{
+					continue;
+				}
+
+				// the unit direction to the light and the intensity of the spot
+				R lx = S::set(-d.x), ly = S::set(-d.y), lz = S::set(-d.z), f = S::set(1.0f);
+				if (light.getType() != SPL_LIGHT_DIRE)
+				{
+					const SPLVector3f &o = light.getPosition();
+					const R tx = S::sub(S::set(o.x), px), ty = S::sub(S::set(o.y), py), tz = S::sub(S::set(o.z), pz);
+					const R sq = S::add(S::add(S::mul(tx, tx), S::mul(ty, ty)), S::mul(tz, tz)), s = S::rsqrt(sq);
+					// a light at the position shines along its direction
+					lx = S::selectZero(sq, lx, S::mul(tx, s));
+					ly = S::selectZero(sq, ly, S::mul(ty, s));
+					lz = S::selectZero(sq, lz, S::mul(tz, s));
+					if (light.getType() == SPL_LIGHT_SPOT)
+					{
+						const R cosine = S::sub(zero, S::add(S::add(S::mul(lx, S::set(d.x)), S::mul(ly, S::set(d.y))), S::mul(lz, S::set(d.z))));
+						const R e = (light.getExponent() > 0.0f) ? S::pow(S::max(cosine, zero), S::set(light.getExponent())) : f;
+						f = S::selectZero(sq, f, S::selectNegative(S::sub(cosine, S::set(light.getCutoff())), zero, e));
+					}
+				}
+
+				const R diffuse = S::max(S::add(S::add(S::mul(nx, lx), S::mul(ny, ly)), S::mul(nz, lz)), zero);
+				const R hx = S::add(lx, vx), hy = S::add(ly, vy), hz = S::add(lz, vz);
+				const R hh = S::add(S::add(S::mul(hx, hx), S::mul(hy, hy)), S::mul(hz, hz));
+				const R nh = S::mul(S::add(S::add(S::mul(nx, hx), S::mul(ny, hy)), S::mul(nz, hz)), S::selectZero(hh, zero, S::rsqrt(hh)));
+				const R specular = S::selectZero(diffuse, zero, S::pow(S::max(nh, zero), shininess));
+
+				r = S::add(r, S::mul(S::mul(f, S::set(c.x)), S::add(S::add(kar, S::mul(kdr, diffuse)), S::mul(ksr, specular))));
+				g = S::add(g, S::mul(S::mul(f, S::set(c.y)), S::add(S::add(kag, S::mul(kdg, diffuse)), S::mul(ksg, specular))));
+				b = S::add(b, S::mul(S::mul(f, S::set(c.z)), S::add(S::add(kab, S::mul(kdb, diffuse)), S::mul(ksb, specular))));
+			}
+			S::store(colors.x + i, r);
+			S::store(colors.y + i, g);
+			S::store(colors.z + i, b);
+		});
+	}
+}
+
+#endif /* _spl_shading_hh_ */
@@ -0,0 +1,549 @@
+#ifndef _spl_simd_hh_
+#define _spl_simd_hh_
+
+#include <cmath>     // for std::sqrt(), std::floor(), std::frexp(), std::ldexp()
+#include <cstdlib>   // for posix_memalign(), free()
+#ifdef _WIN32
+#include <malloc.h>  // for _aligned_malloc(), _aligned_free()
+#endif
+
+#include <spl/typesbase.hh>
+#include <spl/mathbase.hh>
+
+#if !defined(__CUDA_ARCH__) && defined(__AVX512F__)
+#define SPL_SIMD_AVX512
+#elif !defined(__CUDA_ARCH__) && defined(__AVX2__)
+#define SPL_SIMD_AVX2
+#else
+#define SPL_SIMD_SCALAR
+#endif
+
+#if defined(SPL_SIMD_AVX512) || defined(SPL_SIMD_AVX2)
+#include <immintrin.h>
+#endif
+
+#define SPL_SIMD_ALIGNMENT 64	//!< Alignment in bytes of SIMD buffers (one cache line, one AVX-512 register).
+
+/*! \file simd.hh
+ * \brief Thin wrappers around the SIMD instruction sets.
+ *
+ * The instruction set is selected at compile time by the compiler flags,
+ * i.e. AVX-512 (\c -mavx512f), AVX2 (\c -mavx2) or a scalar fallback.
+ * Batch kernels are written once against \ref SPLSimd and are executed
+ * by \ref splSimdForEach, which runs full registers first and the
+ * remaining elements with \ref SPLSimdScalar.
+ * */
+
+namespace SPLSimdDetail
+{
+	//! Returns \f$ \log_2(1 + t) \f$ for \f$ t \in [0, 1) \f$ (absolute error below \f$ 10^{-5} \f$).
+	template <class S>
+	inline typename S::Type log2Mantissa(const typename S::Type t) throw()
+	{
+		typename S::Type q = S::add(S::mul(t, S::set(-0.033822046f)), S::set(0.144471096f));
+		q = S::add(S::mul(t, q), S::set(-0.30163801f));
+		q = S::add(S::mul(t, q), S::set(0.468658879f));
+		q = S::add(S::mul(t, q), S::set(-0.720358773f));
+		q = S::add(S::mul(t, q), S::set(1.44268147f));
+		return S::mul(t, q);
+	}
+
+	//! Returns \f$ 2^r \f$ for \f$ r \in [0, 1) \f$ (relative error below \f$ 10^{-6} \f$).
+	template <class S>
+	inline typename S::Type exp2Fraction(const typename S::Type r) throw()
+	{
+		typename S::Type q = S::add(S::mul(r, S::set(0.00178836874f)), S::set(0.0091993876f));
+		q = S::add(S::mul(r, q), S::set(0.0556570544f));
+		q = S::add(S::mul(r, q), S::set(0.240207194f));
+		q = S::add(S::mul(r, q), S::set(0.693147568f));
+		return S::add(S::set(1.0f), S::mul(r, q));
+	}
+}
+
+/*! \class SPLSimdScalar
+ * \brief Scalar fallback with a register width of one element.
+ *
+ * Defines the interface every \ref SPLSimd specialization provides.
+ * The fast \ref log2, \ref exp2 and \ref pow are not provided by the
+ * double precision and integer registers.
+ */
+template <class T>
+struct SPLSimdScalar
+{
+	typedef T Type;				//!< Register type.
+	enum { width = 1 };			//!< Number of elements per register.
+
+	static inline Type load(const T *p) throw() { return *p; }
+	static inline void store(T *p, const Type a) throw() { *p = a; }
+	//! Loads the elements \c p[index[0]], \c p[index[1]], ...
+	static inline Type gather(const T *p, const SPLint32 *index) throw() { return p[*index]; }
+	//! Loads the elements of \c p at the indices of a register of \c SPLSimd<SPLint32> of the same width.
+	static inline Type gather(const T *p, const SPLint32 index) throw() { return p[index]; }
+	static inline Type set(const T s) throw() { return s; }
+	static inline Type add(const Type a, const Type b) throw() { return a + b; }
+	static inline Type sub(const Type a, const Type b) throw() { return a - b; }
+	static inline Type mul(const Type a, const Type b) throw() { return a * b; }
+	static inline Type div(const Type a, const Type b) throw() { return a / b; }
+	static inline Type sqrt(const Type a) throw() { return T(std::sqrt(a)); }
+	//! Reciprocal square root with at least single precision.
+	static inline Type rsqrt(const Type a) throw() { return T(1) / T(std::sqrt(a)); }
+	static inline Type floor(const Type a) throw() { return T(std::floor(a)); }
+	static inline void storeInt(SPLint32 *p, const Type a) throw() { *p = SPLint32(a); }
+	//! Converts to a register of \c SPLSimd<SPLint32> of the same width (rounded towards zero).
+	static inline SPLint32 toInt(const Type a) throw() { return SPLint32(a); }
+	//! Converts to a register of \c SPLSimd<SPLieee32> of the same width.
+	static inline SPLieee32 toFloat(const Type a) throw() { return SPLieee32(a); }
+	//! Shifts the bits of integers to the left.
+	static inline Type shiftLeft(const Type a, const int n) throw() { return Type(a << n); }
+	//! Shifts the bits of integers to the right (arithmetic shift).
+	static inline Type shiftRight(const Type a, const int n) throw() { return Type(a >> n); }
+	//! Shifts the bits of every integer to the right by the integer of \c n (logical shift).
+	static inline Type shiftRightLanes(const Type a, const Type n) throw() { return Type(SPLuint32(a) >> n); }
+	//! Bitwise and of integers.
+	static inline Type bitAnd(const Type a, const Type b) throw() { return Type(a & b); }
+	//! Returns \c a where \c t is zero and \c b otherwise.
+	static inline Type selectZero(const Type t, const Type a, const Type b) throw() { return (t == T(0)) ? a : b; }
+	//! Returns \c a where \c t is negative and \c b otherwise.
+	static inline Type selectNegative(const Type t, const Type a, const Type b) throw() { return (t < T(0)) ? a : b; }
+	static inline Type min(const Type a, const Type b) throw() { return (b < a) ? b : a; }
+	static inline Type max(const Type a, const Type b) throw() { return (a < b) ? b : a; }
+	//! Fast approximation of \f$ \log_2 a \f$ with single precision, values below the smallest normal one are clamped.
+	static inline Type log2(const Type a) throw()
+	{
+		int e = 0;
+		const T m = T(std::frexp(max(a, T(1.17549435e-38f)), &e));
+		return T(e - 1) + SPLSimdDetail::log2Mantissa<SPLSimdScalar<T> >(m + m - T(1));
+	}
+	//! Fast approximation of \f$ 2^a \f$ with single precision, exponents are clamped to \f$ [-126, 127] \f$.
+	static inline Type exp2(const Type a) throw()
+	{
+		const T x = min(max(a, T(-126)), T(127)), f = T(std::floor(x));
+		return T(std::ldexp(SPLSimdDetail::exp2Fraction<SPLSimdScalar<T> >(x - f), int(f)));
+	}
+	//! Fast approximation of \f$ a^b \f$ for \f$ a \geq 0 \f$, i.e. \f$ 2^{b \log_2 a} \f$.
+	static inline Type pow(const Type a, const Type b) throw() { return exp2(b * log2(a)); }
+};
+
+/*! \class SPLSimd
+ * \brief SIMD register abstraction for the type \c T.
+ *
+ * Types without a specialization use \ref SPLSimdScalar.
+ */
+template <class T>
+struct SPLSimd : public SPLSimdScalar<T>
+{
+};
+
+/*! \class SPLSimdConvert
+ * \brief Conversion of 8 and 16 bit integers from and to the registers of \c SPLSimd<SPLieee32>.
+ *
+ * \c load converts exactly, \c store rounds to the nearest integer (ties
+ * to even) and saturates. Provided for \ref SPLuint8, \ref SPLint8,
+ * \ref SPLuint16 and \ref SPLint16 by the AVX2 and AVX-512 builds, see
+ * \ref splConvert.
+ */
+template <class T>
+struct SPLSimdConvert;
+
+#if defined(SPL_SIMD_AVX512)
+
+template <>
+struct SPLSimd<SPLieee32>
+{
+	typedef __m512 Type;
+	enum { width = 16 };
+
+	static inline Type load(const SPLieee32 *p) throw() { return _mm512_loadu_ps(p); }
+	static inline void store(SPLieee32 *p, const Type a) throw() { _mm512_storeu_ps(p, a); }
+	static inline Type gather(const SPLieee32 *p, const SPLint32 *index) throw() { return _mm512_i32gather_ps(_mm512_loadu_si512(index), p, 4); }
+	static inline Type gather(const SPLieee32 *p, const __m512i index) throw() { return _mm512_i32gather_ps(index, p, 4); }
+	static inline Type set(const SPLieee32 s) throw() { return _mm512_set1_ps(s); }
+	static inline Type add(const Type a, const Type b) throw() { return _mm512_add_ps(a, b); }
+	static inline Type sub(const Type a, const Type b) throw() { return _mm512_sub_ps(a, b); }
+	static inline Type mul(const Type a, const Type b) throw() { return _mm512_mul_ps(a, b); }
+	static inline Type div(const Type a, const Type b) throw() { return _mm512_div_ps(a, b); }
+	static inline Type sqrt(const Type a) throw() { return _mm512_sqrt_ps(a); }
+	static inline Type rsqrt(const Type a) throw()
+	{
+		const Type y = _mm512_rsqrt14_ps(a);
+		return _mm512_mul_ps(y, _mm512_sub_ps(_mm512_set1_ps(1.5f), _mm512_mul_ps(_mm512_mul_ps(_mm512_set1_ps(0.5f), a), _mm512_mul_ps(y, y))));
+	}
+	static inline Type floor(const Type a) throw() { return _mm512_roundscale_ps(a, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC); }
+	static inline void storeInt(SPLint32 *p, const Type a) throw() { _mm512_storeu_si512(p, _mm512_cvttps_epi32(a)); }
+	static inline __m512i toInt(const Type a) throw() { return _mm512_cvttps_epi32(a); }
+	static inline Type selectZero(const Type t, const Type a, const Type b) throw()
+	{
+		return _mm512_mask_blend_ps(_mm512_cmp_ps_mask(t, _mm512_setzero_ps(), _CMP_EQ_OQ), b, a);
+	}
+	static inline Type selectNegative(const Type t, const Type a, const Type b) throw()
+	{
+		return _mm512_mask_blend_ps(_mm512_cmp_ps_mask(t, _mm512_setzero_ps(), _CMP_LT_OQ), b, a);
+	}
+	static inline Type min(const Type a, const Type b) throw() { return _mm512_min_ps(a, b); }
+	static inline Type max(const Type a, const Type b) throw() { return _mm512_max_ps(a, b); }
+	static inline Type log2(const Type a) throw()
+	{
+		const __m512i i = _mm512_castps_si512(_mm512_max_ps(a, _mm512_set1_ps(1.17549435e-38f)));
+		const Type e = _mm512_cvtepi32_ps(_mm512_sub_epi32(_mm512_srli_epi32(i, 23), _mm512_set1_epi32(127)));
+		const Type m = _mm512_castsi512_ps(_mm512_or_si512(_mm512_and_si512(i, _mm512_set1_epi32(0x007fffff)), _mm512_set1_epi32(0x3f800000)));
+		return _mm512_add_ps(e, SPLSimdDetail::log2Mantissa<SPLSimd<SPLieee32> >(_mm512_sub_ps(m, _mm512_set1_ps(1.0f))));
+	}
+	static inline Type exp2(const Type a) throw()
+	{
+		const Type x = _mm512_min_ps(_mm512_max_ps(a, _mm512_set1_ps(-126.0f)), _mm512_set1_ps(127.0f)), f = floor(x);
+		const __m512i p = _mm512_castps_si512(SPLSimdDetail::exp2Fraction<SPLSimd<SPLieee32> >(_mm512_sub_ps(x, f)));
+		return _mm512_castsi512_ps(_mm512_add_epi32(p, _mm512_slli_epi32(_mm512_cvttps_epi32(f), 23)));
+	}
+	static inline Type pow(const Type a, const Type b) throw() { return exp2(_mm512_mul_ps(b, log2(a))); }
+};
+
+template <>
+struct SPLSimd<SPLieee64>
+{
+	typedef __m512d Type;
+	enum { width = 8 };
+
+	static inline Type load(const SPLieee64 *p) throw() { return _mm512_loadu_pd(p); }
+	static inline void store(SPLieee64 *p, const Type a) throw() { _mm512_storeu_pd(p, a); }
+	static inline Type set(const SPLieee64 s) throw() { return _mm512_set1_pd(s); }
+	static inline Type add(const Type a, const Type b) throw() { return _mm512_add_pd(a, b); }
+	static inline Type sub(const Type a, const Type b) throw() { return _mm512_sub_pd(a, b); }
+	static inline Type mul(const Type a, const Type b) throw() { return _mm512_mul_pd(a, b); }
+	static inline Type div(const Type a, const Type b) throw() { return _mm512_div_pd(a, b); }
+	static inline Type sqrt(const Type a) throw() { return _mm512_sqrt_pd(a); }
+	static inline Type rsqrt(const Type a) throw()
+	{
+		const Type y = _mm512_rsqrt14_pd(a);
+		return _mm512_mul_pd(y, _mm512_sub_pd(_mm512_set1_pd(1.5), _mm512_mul_pd(_mm512_mul_pd(_mm512_set1_pd(0.5), a), _mm512_mul_pd(y, y))));
+	}
+	static inline Type floor(const Type a) throw() { return _mm512_roundscale_pd(a, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC); }
+	static inline void storeInt(SPLint32 *p, const Type a) throw() { _mm256_storeu_si256((__m256i *)p, _mm512_cvttpd_epi32(a)); }
+	static inline Type selectZero(const Type t, const Type a, const Type b) throw()
+	{
+		return _mm512_mask_blend_pd(_mm512_cmp_pd_mask(t, _mm512_setzero_pd(), _CMP_EQ_OQ), b, a);
+	}
+	static inline Type selectNegative(const Type t, const Type a, const Type b) throw()
+	{
+		return _mm512_mask_blend_pd(_mm512_cmp_pd_mask(t, _mm512_setzero_pd(), _CMP_LT_OQ), b, a);
+	}
+	static inline Type min(const Type a, const Type b) throw() { return _mm512_min_pd(a, b); }
+	static inline Type max(const Type a, const Type b) throw() { return _mm512_max_pd(a, b); }
+};
+
+template <>
+struct SPLSimd<SPLint32>
+{
+	typedef __m512i Type;
+	enum { width = 16 };
+
+	static inline Type load(const SPLint32 *p) throw() { return _mm512_loadu_si512(p); }
+	static inline void store(SPLint32 *p, const Type a) throw() { _mm512_storeu_si512(p, a); }
+	static inline Type gather(const SPLint32 *p, const Type index) throw() { return _mm512_i32gather_epi32(index, p, 4); }
+	static inline Type set(const SPLint32 s) throw() { return _mm512_set1_epi32(s); }
+	static inline Type add(const Type a, const Type b) throw() { return _mm512_add_epi32(a, b); }
+	static inline Type sub(const Type a, const Type b) throw() { return _mm512_sub_epi32(a, b); }
+	static inline Type mul(const Type a, const Type b) throw() { return _mm512_mullo_epi32(a, b); }
+	static inline Type floor(const Type a) throw() { return a; }
+	static inline void storeInt(SPLint32 *p, const Type a) throw() { _mm512_storeu_si512(p, a); }
+	static inline Type toInt(const Type a) throw() { return a; }
+	static inline __m512 toFloat(const Type a) throw() { return _mm512_cvtepi32_ps(a); }
+	static inline Type shiftLeft(const Type a, const int n) throw() { return _mm512_sll_epi32(a, _mm_cvtsi32_si128(n)); }
+	static inline Type shiftRight(const Type a, const int n) throw() { return _mm512_sra_epi32(a, _mm_cvtsi32_si128(n)); }
+	static inline Type shiftRightLanes(const Type a, const Type n) throw() { return _mm512_srlv_epi32(a, n); }
+	static inline Type bitAnd(const Type a, const Type b) throw() { return _mm512_and_si512(a, b); }
+	static inline Type min(const Type a, const Type b) throw() { return _mm512_min_epi32(a, b); }
+	static inline Type max(const Type a, const Type b) throw() { return _mm512_max_epi32(a, b); }
+};
+
+template <>
+struct SPLSimdConvert<SPLuint8>
+{
+	static inline SPLSimd<SPLieee32>::Type load(const SPLuint8 *p) throw() { return _mm512_cvtepi32_ps(_mm512_cvtepu8_epi32(_mm_loadu_si128((const __m128i *)p))); }
+	static inline void store(SPLuint8 *p, const SPLSimd<SPLieee32>::Type a) throw()
+	{
+		const __m512i i = _mm512_cvtps_epi32(_mm512_min_ps(_mm512_max_ps(a, _mm512_set1_ps(0.0f)), _mm512_set1_ps(255.0f)));
+		_mm_storeu_si128((__m128i *)p, _mm512_cvtepi32_epi8(i));
+	}
+};
+
+template <>
+struct SPLSimdConvert<SPLint8>
+{
+	static inline SPLSimd<SPLieee32>::Type load(const SPLint8 *p) throw() { return _mm512_cvtepi32_ps(_mm512_cvtepi8_epi32(_mm_loadu_si128((const __m128i *)p))); }
+	static inline void store(SPLint8 *p, const SPLSimd<SPLieee32>::Type a) throw()
+	{
+		const __m512i i = _mm512_cvtps_epi32(_mm512_min_ps(_mm512_max_ps(a, _mm512_set1_ps(-128.0f)), _mm512_set1_ps(127.0f)));
+		_mm_storeu_si128((__m128i *)p, _mm512_cvtepi32_epi8(i));
+	}
+};
+
+template <>
+struct SPLSimdConvert<SPLuint16>
+{
+	static inline SPLSimd<SPLieee32>::Type load(const SPLuint16 *p) throw() { return _mm512_cvtepi32_ps(_mm512_cvtepu16_epi32(_mm256_loadu_si256((const __m256i *)p))); }
+	static inline void store(SPLuint16 *p, const SPLSimd<SPLieee32>::Type a) throw()
+	{
+		const __m512i i = _mm512_cvtps_epi32(_mm512_min_ps(_mm512_max_ps(a, _mm512_set1_ps(0.0f)), _mm512_set1_ps(65535.0f)));
+		_mm256_storeu_si256((__m256i *)p, _mm512_cvtepi32_epi16(i));
+	}
+};
+
+template <>
+struct SPLSimdConvert<SPLint16>
+{
+	static inline SPLSimd<SPLieee32>::Type load(const SPLint16 *p) throw() { return _mm512_cvtepi32_ps(_mm512_cvtepi16_epi32(_mm256_loadu_si256((const __m256i *)p))); }
+	static inline void store(SPLint16 *p, const SPLSimd<SPLieee32>::Type a) throw()
+	{
+		const __m512i i = _mm512_cvtps_epi32(_mm512_min_ps(_mm512_max_ps(a, _mm512_set1_ps(-32768.0f)), _mm512_set1_ps(32767.0f)));
+		_mm256_storeu_si256((__m256i *)p, _mm512_cvtepi32_epi16(i));
+	}
+};
+
+#elif defined(SPL_SIMD_AVX2)
+
+template <>
+struct SPLSimd<SPLieee32>
+{
+	typedef __m256 Type;
+	enum { width = 8 };
+
+	static inline Type load(const SPLieee32 *p) throw() { return _mm256_loadu_ps(p); }
+	static inline void store(SPLieee32 *p, const Type a) throw() { _mm256_storeu_ps(p, a); }
+	static inline Type gather(const SPLieee32 *p, const SPLint32 *index) throw() { return _mm256_i32gather_ps(p, _mm256_loadu_si256((const __m256i *)index), 4); }
+	static inline Type gather(const SPLieee32 *p, const __m256i index) throw() { return _mm256_i32gather_ps(p, index, 4); }
+	static inline Type set(const SPLieee32 s) throw() { return _mm256_set1_ps(s); }
+	static inline Type add(const Type a, const Type b) throw() { return _mm256_add_ps(a, b); }
+	static inline Type sub(const Type a, const Type b) throw() { return _mm256_sub_ps(a, b); }
+	static inline Type mul(const Type a, const Type b) throw() { return _mm256_mul_ps(a, b); }
+	static inline Type div(const Type a, const Type b) throw() { return _mm256_div_ps(a, b); }
+	static inline Type sqrt(const Type a) throw() { return _mm256_sqrt_ps(a); }
+	static inline Type rsqrt(const Type a) throw()
+	{
+		const Type y = _mm256_rsqrt_ps(a);
+		return _mm256_mul_ps(y, _mm256_sub_ps(_mm256_set1_ps(1.5f), _mm256_mul_ps(_mm256_mul_ps(_mm256_set1_ps(0.5f), a), _mm256_mul_ps(y, y))));
+	}
+	static inline Type floor(const Type a) throw() { return _mm256_floor_ps(a); }
+	static inline void storeInt(SPLint32 *p, const Type a) throw() { _mm256_storeu_si256((__m256i *)p, _mm256_cvttps_epi32(a)); }
+	static inline __m256i toInt(const Type a) throw() { return _mm256_cvttps_epi32(a); }
+	static inline Type selectZero(const Type t, const Type a, const Type b) throw()
+	{
+		return _mm256_blendv_ps(b, a, _mm256_cmp_ps(t, _mm256_setzero_ps(), _CMP_EQ_OQ));
+	}
+	static inline Type selectNegative(const Type t, const Type a, const Type b) throw()
+	{
+		return _mm256_blendv_ps(b, a, _mm256_cmp_ps(t, _mm256_setzero_ps(), _CMP_LT_OQ));
+	}
+	static inline Type min(const Type a, const Type b) throw() { return _mm256_min_ps(a, b); }
+	static inline Type max(const Type a, const Type b) throw() { return _mm256_max_ps(a, b); }
+	static inline Type log2(const Type a) throw()
+	{
+		const __m256i i = _mm256_castps_si256(_mm256_max_ps(a, _mm256_set1_ps(1.17549435e-38f)));
+		const Type e = _mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_srli_epi32(i, 23), _mm256_set1_epi32(127)));
+		const Type m = _mm256_castsi256_ps(_mm256_or_si256(_mm256_and_si256(i, _mm256_set1_epi32(0x007fffff)), _mm256_set1_epi32(0x3f800000)));
+		return _mm256_add_ps(e, SPLSimdDetail::log2Mantissa<SPLSimd<SPLieee32> >(_mm256_sub_ps(m, _mm256_set1_ps(1.0f))));
+	}
+	static inline Type exp2(const Type a) throw()
+	{
+		const Type x = _mm256_min_ps(_mm256_max_ps(a, _mm256_set1_ps(-126.0f)), _mm256_set1_ps(127.0f)), f = _mm256_floor_ps(x);
+		const __m256i p = _mm256_castps_si256(SPLSimdDetail::exp2Fraction<SPLSimd<SPLieee32> >(_mm256_sub_ps(x, f)));
+		return _mm256_castsi256_ps(_mm256_add_epi32(p, _mm256_slli_epi32(_mm256_cvttps_epi32(f), 23)));
+	}
+	static inline Type pow(const Type a, const Type b) throw() { return exp2(_mm256_mul_ps(b, log2(a))); }
+};
+
+template <>
+struct SPLSimd<SPLieee64>
+{
+	typedef __m256d Type;
+	enum { width = 4 };
+
+	static inline Type load(const SPLieee64 *p) throw() { return _mm256_loadu_pd(p); }
+	static inline void store(SPLieee64 *p, const Type a) throw() { _mm256_storeu_pd(p, a); }
+	static inline Type set(const SPLieee64 s) throw() { return _mm256_set1_pd(s); }
+	static inline Type add(const Type a, const Type b) throw() { return _mm256_add_pd(a, b); }
+	static inline Type sub(const Type a, const Type b) throw() { return _mm256_sub_pd(a, b); }
+	static inline Type mul(const Type a, const Type b) throw() { return _mm256_mul_pd(a, b); }
+	static inline Type div(const Type a, const Type b) throw() { return _mm256_div_pd(a, b); }
+	static inline Type sqrt(const Type a) throw() { return _mm256_sqrt_pd(a); }
+	static inline Type rsqrt(const Type a) throw()
+	{
+		// single precision estimate, there is no rsqrt for doubles in AVX2
+		const Type y = _mm256_cvtps_pd(_mm_rsqrt_ps(_mm256_cvtpd_ps(a)));
+		return _mm256_mul_pd(y, _mm256_sub_pd(_mm256_set1_pd(1.5), _mm256_mul_pd(_mm256_mul_pd(_mm256_set1_pd(0.5), a), _mm256_mul_pd(y, y))));
+	}
+	static inline Type floor(const Type a) throw() { return _mm256_floor_pd(a); }
+	static inline void storeInt(SPLint32 *p, const Type a) throw() { _mm_storeu_si128((__m128i *)p, _mm256_cvttpd_epi32(a)); }
+	static inline Type selectZero(const Type t, const Type a, const Type b) throw()
+	{
+		return _mm256_blendv_pd(b, a, _mm256_cmp_pd(t, _mm256_setzero_pd(), _CMP_EQ_OQ));
+	}
+	static inline Type selectNegative(const Type t, const Type a, const Type b) throw()
+	{
+		return _mm256_blendv_pd(b, a, _mm256_cmp_pd(t, _mm256_setzero_pd(), _CMP_LT_OQ));
+	}
+	static inline Type min(const Type a, const Type b) throw() { return _mm256_min_pd(a, b); }
+	static inline Type max(const Type a, const Type b) throw() { return _mm256_max_pd(a, b); }
+};
+
+template <>
+struct SPLSimd<SPLint32>
+{
+	typedef __m256i Type;
+	enum { width = 8 };
+
+	static inline Type load(const SPLint32 *p) throw() { return _mm256_loadu_si256((const __m256i *)p); }
+	static inline void store(SPLint32 *p, const Type a) throw() { _mm256_storeu_si256((__m256i *)p, a); }
+	static inline Type gather(const SPLint32 *p, const Type index) throw() { return _mm256_i32gather_epi32(p, index, 4); }
+	static inline Type set(const SPLint32 s) throw() { return _mm256_set1_epi32(s); }
+	static inline Type add(const Type a, const Type b) throw() { return _mm256_add_epi32(a, b); }
+	static inline Type sub(const Type a, const Type b) throw() { return _mm256_sub_epi32(a, b); }
+	static inline Type mul(const Type a, const Type b) throw() { return _mm256_mullo_epi32(a, b); }
+	static inline Type floor(const Type a) throw() { return a; }
+	static inline void storeInt(SPLint32 *p, const Type a) throw() { _mm256_storeu_si256((__m256i *)p, a); }
+	static inline Type toInt(const Type a) throw() { return a; }
+	static inline __m256 toFloat(const Type a) throw() { return _mm256_cvtepi32_ps(a); }
+	static inline Type shiftLeft(const Type a, const int n) throw() { return _mm256_sll_epi32(a, _mm_cvtsi32_si128(n)); }
+	static inline Type shiftRight(const Type a, const int n) throw() { return _mm256_sra_epi32(a, _mm_cvtsi32_si128(n)); }
+	static inline Type shiftRightLanes(const Type a, const Type n) throw() { return _mm256_srlv_epi32(a, n); }
+	static inline Type bitAnd(const Type a, const Type b) throw() { return _mm256_and_si256(a, b); }
+	static inline Type min(const Type a, const Type b) throw() { return _mm256_min_epi32(a, b); }
+	static inline Type max(const Type a, const Type b) throw() { return _mm256_max_epi32(a, b); }
+};
+
+template <>
+struct SPLSimdConvert<SPLuint8>
+{
+	static inline SPLSimd<SPLieee32>::Type load(const SPLuint8 *p) throw() { return _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)p))); }
+	static inline void store(SPLuint8 *p, const SPLSimd<SPLieee32>::Type a) throw()
+	{
+		const __m256i i = _mm256_cvtps_epi32(_mm256_min_ps(_mm256_max_ps(a, _mm256_set1_ps(0.0f)), _mm256_set1_ps(255.0f)));
+		const __m128i w = _mm_packus_epi32(_mm256_castsi256_si128(i), _mm256_extracti128_si256(i, 1));
+		_mm_storel_epi64((__m128i *)p, _mm_packus_epi16(w, w));
+	}
+};
+
+template <>
+struct SPLSimdConvert<SPLint8>
+{
+	static inline SPLSimd<SPLieee32>::Type load(const SPLint8 *p) throw() { return _mm256_cvtepi32_ps(_mm256_cvtepi8_epi32(_mm_loadl_epi64((const __m128i *)p))); }
+	static inline void store(SPLint8 *p, const SPLSimd<SPLieee32>::Type a) throw()
+	{
+		const __m256i i = _mm256_cvtps_epi32(_mm256_min_ps(_mm256_max_ps(a, _mm256_set1_ps(-128.0f)), _mm256_set1_ps(127.0f)));
+		const __m128i w = _mm_packs_epi32(_mm256_castsi256_si128(i), _mm256_extracti128_si256(i, 1));
+		_mm_storel_epi64((__m128i *)p, _mm_packs_epi16(w, w));
+	}
+};
+
+template <>
+struct SPLSimdConvert<SPLuint16>
+{
+	static inline SPLSimd<SPLieee32>::Type load(const SPLuint16 *p) throw() { return _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *)p))); }
+	static inline void store(SPLuint16 *p, const SPLSimd<SPLieee32>::Type a) throw()
+	{
+		const __m256i i = _mm256_cvtps_epi32(_mm256_min_ps(_mm256_max_ps(a, _mm256_set1_ps(0.0f)), _mm256_set1_ps(65535.0f)));
+		_mm_storeu_si128((__m128i *)p, _mm_packus_epi32(_mm256_castsi256_si128(i), _mm256_extracti128_si256(i, 1)));
+	}
+};
+
+template <>
+struct SPLSimdConvert<SPLint16>
+{
+	static inline SPLSimd<SPLieee32>::Type load(const SPLint16 *p) throw() { return _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *)p))); }
+	static inline void store(SPLint16 *p, const SPLSimd<SPLieee32>::Type a) throw()
+	{
+		const __m256i i = _mm256_cvtps_epi32(_mm256_min_ps(_mm256_max_ps(a, _mm256_set1_ps(-32768.0f)), _mm256_set1_ps(32767.0f)));
+		_mm_storeu_si128((__m128i *)p, _mm_packs_epi32(_mm256_castsi256_si128(i), _mm256_extracti128_si256(i, 1)));
+	}
+};
+
+#endif
+
+/*! \fn void splSimdForEach(const SPLsizei n, K kernel)
+ * \brief Applies a batch kernel to the elements \f$ [0, n) \f$.
+ *
+ * The kernel is called as \c kernel(S(), i) where \c S is either
+ * \ref SPLSimd (for \c S::width elements starting at index \c i) or
+ * \ref SPLSimdScalar (for the remaining elements).
+ *
+ * Example
+ * \code
+ * splSimdForEach<SPLieee32>(n, [&](auto simd, const SPLindex i)
+ * {
+ * 	typedef decltype(simd) S;
+ * 	S::store(c + i, S::add(S::load(a + i), S::load(b + i)));
+ * });
+ * \endcode
+ *
+ * \param n Number of elements.
+ * \param kernel The batch kernel.
+ */
+template <class T, class K>
+inline void splSimdForEach(const SPLsizei n, K kernel)
+{
+	typedef SPLSimd<T> S;
+	SPLindex i = 0;
+	for (; i + SPLindex(S::width) <= n; i += SPLindex(S::width))
+	{
+		kernel(S(), i);
+	}
+	for (; i < n; i++)
+	{
+		kernel(SPLSimdScalar<T>(), i);
+	}
+}
+
+/*! \brief Requests the cache line of an address.
+ *
+ * Lets the loads of scattered addresses, e.g. of gathers, start before
+ * the preceding loads have finished.
+ *
+ * \param p The address.
+ */
+inline void splSimdPrefetch(const void *p) throw()
+{
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+	// GCC drops the calls of functions whose only effect is __builtin_prefetch()
+	__asm__ __volatile__("prefetcht0 %0" : : "m"(*(const char *)p));
+#elif defined(__GNUC__)
+	__builtin_prefetch(p);
+#elif defined(SPL_SIMD_AVX512) || defined(SPL_SIMD_AVX2)
+	_mm_prefetch((const char *)p, _MM_HINT_T0);
+#else
+	(void)p;
+#endif
+}
+
+/*! \brief Allocates memory aligned to \ref SPL_SIMD_ALIGNMENT.
+ *
+ * \param size Number of bytes.
+ *
+ * \return Pointer to the memory or \c 0 on failure.
+ */
+inline SPLvoidp splSimdMalloc(const size_t size) throw()
+{
+	SPLvoidp p = 0;
+#ifdef _WIN32
+	p = _aligned_malloc(size, SPL_SIMD_ALIGNMENT);
+#else
+	if (posix_memalign(&p, SPL_SIMD_ALIGNMENT, size) != 0)
+	{
+		p = 0;
+	}
+#endif
+	return p;
+}
+
+/*! \brief Frees memory allocated with \ref splSimdMalloc.
+ *
+ * \param p Pointer to the memory (may be \c 0).
+ */
+inline void splSimdFree(SPLvoidp p) throw()
+{
+#ifdef _WIN32
+	_aligned_free(p);
+#else
+	free(p);
+#endif
+}
+
+#endif /* _spl_simd_hh_ */
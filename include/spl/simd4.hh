@@ -0,0 +1,180 @@
+#ifndef _spl_simd4_hh_
+#define _spl_simd4_hh_
+
+#include <spl/typesbase.hh>
+
+#if !defined(__CUDA_ARCH__) && (defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1))
+#include <xmmintrin.h>
+#ifdef __SSE4_1__
+#include <smmintrin.h>
+#endif
+#define SPL_SIMD4_SSE
+#elif !defined(__CUDA_ARCH__) && (defined(__ARM_NEON) || defined(__ARM_NEON__))
+#include <arm_neon.h>
+#define SPL_SIMD4_NEON
+#endif
+
+#if defined(SPL_SIMD4_SSE) || defined(SPL_SIMD4_NEON)
+#define SPL_SIMD4	//!< Defined if \ref SPLSimd4f is available.
+#endif
+
+/*! \file simd4.hh
+ * \brief One small vector per SIMD register.
+ *
+ * In contrast to the batch kernels of \ref simd.hh, which process a
+ * register of elements of many vectors, \ref SPLSimd4f holds the 4
+ * components of one \ref SPLVector4f or \ref SPLVector3a (the 4th one
+ * being padding) in one SSE or NEON register. It is used by the
+ * operators of these types and by \ref SPLMatrix4f, such that a dot
+ * product, a cross product or a normalization compiles to a few
+ * instructions. The pointers passed to \ref SPLSimd4f::load and
+ * \ref SPLSimd4f::store must be aligned to 16 bytes.
+ * */
+
+#ifdef SPL_SIMD4
+
+/*! \class SPLSimd4f
+ * \brief A register of 4 \ref SPLieee32 values with SSE or NEON.
+ */
+struct SPLSimd4f
+{
+#ifdef SPL_SIMD4_SSE
+	typedef __m128 Type;	//!< Register type.
+
+	static inline Type load(const SPLieee32 *p) throw() { return _mm_load_ps(p); }
+	static inline void store(SPLieee32 *p, const Type a) throw() { _mm_store_ps(p, a); }
+	static inline Type set(const SPLieee32 x, const SPLieee32 y, const SPLieee32 z, const SPLieee32 w) throw() { return _mm_set_ps(w, z, y, x); }
+	static inline Type set1(const SPLieee32 s) throw() { return _mm_set1_ps(s); }
+	static inline Type zero(void) throw() { return _mm_setzero_ps(); }
+	static inline Type add(const Type a, const Type b) throw() { return _mm_add_ps(a, b); }
+	static inline Type sub(const Type a, const Type b) throw() { return _mm_sub_ps(a, b); }
+	static inline Type mul(const Type a, const Type b) throw() { return _mm_mul_ps(a, b); }
+	static inline Type div(const Type a, const Type b) throw() { return _mm_div_ps(a, b); }
+	static inline Type sqrt(const Type a) throw() { return _mm_sqrt_ps(a); }
+	static inline SPLieee32 first(const Type a) throw() { return _mm_cvtss_f32(a); }
+
+	//! Returns lane \c L of \c a in all lanes.
+	template <int L>
+	static inline Type splat(const Type a) throw() { return _mm_shuffle_ps(a, a, _MM_SHUFFLE(L, L, L, L)); }
+
+	//! Returns \f$ a_0 b_0 + a_1 b_1 + a_2 b_2 + a_3 b_3 \f$ in all lanes.
+	static inline Type dot4(const Type a, const Type b) throw()
+	{
+#ifdef __SSE4_1__
+		return _mm_dp_ps(a, b, 0xFF);
+#else
+		const Type m = _mm_mul_ps(a, b);
+		const Type s = _mm_add_ps(m, _mm_shuffle_ps(m, m, _MM_SHUFFLE(2, 3, 0, 1)));
+		return _mm_add_ps(s, _mm_shuffle_ps(s, s, _MM_SHUFFLE(1, 0, 3, 2)));
+#endif
+	}
+
+	//! Returns \f$ {\bf a} \times {\bf b} \f$ of the first 3 lanes, the 4th lane is zero.
+	static inline Type cross(const Type a, const Type b) throw()
+	{
+		const Type a1 = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1)), b1 = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 2, 1));
+		const Type a2 = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 1, 0, 2)), b2 = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 1, 0, 2));
+		return _mm_sub_ps(_mm_mul_ps(a1, b2), _mm_mul_ps(a2, b1));
+	}
+
+	//! Returns \f$ 1 / \sqrt{a} \f$, i.e. the estimate refined by one Newton step.
+	static inline Type rsqrt(const Type a) throw()
+	{
+		const Type y = _mm_rsqrt_ps(a);
+		return _mm_mul_ps(y, _mm_sub_ps(_mm_set1_ps(1.5f), _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(0.5f), a), _mm_mul_ps(y, y))));
+	}
+#else
+	typedef float32x4_t Type;	//!< Register type.
+
+	static inline Type load(const SPLieee32 *p) throw() { return vld1q_f32(p); }
+	static inline void store(SPLieee32 *p, const Type a) throw() { vst1q_f32(p, a); }
+	static inline Type set(const SPLieee32 x, const SPLieee32 y, const SPLieee32 z, const SPLieee32 w) throw()
+	{
+		const SPLieee32 v[4] = { x, y, z, w };
+		return vld1q_f32(v);
+	}
+	static inline Type set1(const SPLieee32 s) throw() { return vdupq_n_f32(s); }
+	static inline Type zero(void) throw() { return vdupq_n_f32(0.0f); }
+	static inline Type add(const Type a, const Type b) throw() { return vaddq_f32(a, b); }
+	static inline Type sub(const Type a, const Type b) throw() { return vsubq_f32(a, b); }
+	static inline Type mul(const Type a, const Type b) throw() { return vmulq_f32(a, b); }
+	static inline SPLieee32 first(const Type a) throw() { return vgetq_lane_f32(a, 0); }
+
+	//! Returns lane \c L of \c a in all lanes.
+	template <int L>
+	static inline Type splat(const Type a) throw() { return vdupq_n_f32(vgetq_lane_f32(a, L)); }
+
+	static inline Type div(const Type a, const Type b) throw()
+	{
+#ifdef __aarch64__
+		return vdivq_f32(a, b);
+#else
+		// reciprocal estimate refined by two Newton steps
+		Type r = vrecpeq_f32(b);
+		r = vmulq_f32(vrecpsq_f32(b, r), r);
+		r = vmulq_f32(vrecpsq_f32(b, r), r);
+		return vmulq_f32(a, r);
+#endif
+	}
+
+	static inline Type sqrt(const Type a) throw()
+	{
+#ifdef __aarch64__
+		return vsqrtq_f32(a);
+#else
+		const Type r = rsqrt(a);
+		// sqrt(0) = 0 instead of 0 * inf
+		return vbslq_f32(vceqq_f32(a, vdupq_n_f32(0.0f)), a, vmulq_f32(a, r));
+#endif
+	}
+
+	//! Returns \f$ a_0 b_0 + a_1 b_1 + a_2 b_2 + a_3 b_3 \f$ in all lanes.
+	static inline Type dot4(const Type a, const Type b) throw()
+	{
+		const Type m = vmulq_f32(a, b);
+#ifdef __aarch64__
+		return vdupq_n_f32(vaddvq_f32(m));
+#else
+		const float32x2_t s = vadd_f32(vget_low_f32(m), vget_high_f32(m));
+		return vdupq_lane_f32(vpadd_f32(s, s), 0);
+#endif
+	}
+
+	//! Returns \f$ {\bf a} \times {\bf b} \f$ of the first 3 lanes, the 4th lane is zero.
+	static inline Type cross(const Type a, const Type b) throw()
+	{
+		// (a * b.yzx - a.yzx * b).yzx
+		const Type c = vsubq_f32(vmulq_f32(a, yzx(b)), vmulq_f32(yzx(a), b));
+		return vsetq_lane_f32(0.0f, yzx(c), 3);
+	}
+
+	//! Returns \f$ 1 / \sqrt{a} \f$, i.e. the estimate refined by one Newton step.
+	static inline Type rsqrt(const Type a) throw()
+	{
+		const Type y = vrsqrteq_f32(a);
+		return vmulq_f32(y, vrsqrtsq_f32(vmulq_f32(a, y), y));
+	}
+
+private:
+	//! Returns \f$ (a_1, a_2, a_0, a_1) \f$.
+	static inline Type yzx(const Type a) throw()
+	{
+		return vcombine_f32(vext_f32(vget_low_f32(a), vget_high_f32(a), 1), vget_low_f32(a));
+	}
+#endif
+
+public:
+	//! Returns \f$ a_0 b_0 + a_1 b_1 + a_2 b_2 \f$ in all lanes.
+	static inline Type dot3(const Type a, const Type b) throw()
+	{
+#if defined(SPL_SIMD4_SSE) && defined(__SSE4_1__)
+		return _mm_dp_ps(a, b, 0x7F);
+#else
+		return dot4(mul(a, set(1.0f, 1.0f, 1.0f, 0.0f)), b);
+#endif
+	}
+};
+
+#endif
+
+#endif /* _spl_simd4_hh_ */
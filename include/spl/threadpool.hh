@@ -0,0 +1,250 @@
+#ifndef _spl_threadpool_hh_
+#define _spl_threadpool_hh_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdlib>   // for getenv(), atoi()
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <spl/typesbase.hh>
+
+/*! \file threadpool.hh
+ * */
+
+/*! \class SPLThreadPool
+ * \brief A pool of worker threads for data parallel loops.
+ *
+ * The workers are created once and wait for ranges of indices which are
+ * distributed in chunks by \ref parallelFor. The calling thread processes
+ * chunks as well, i.e. a pool of \f$ n \f$ threads creates \f$ n - 1 \f$
+ * workers. Calls of \ref parallelFor from within a chunk are executed
+ * serially by the calling thread.
+ *
+ * Example
+ * \code
+ * SPLThreadPool &pool = SPLThreadPool::getGlobal();
+ *
+ * pool.parallelFor(0, n, 4096, [&](const SPLint64 first, const SPLint64 last)
+ * {
+ * 	for (SPLint64 i = first; i < last; i++)
+ * 	{
+ * 		c[i] = a[i] + b[i];
+ * 	}
+ * });
+ * \endcode
+ */
+class SPLThreadPool
+{
+public:
+	/*! \brief Constructor!
+	 *
+	 * Starts the worker threads.
+	 *
+	 * \param threads Number of threads including the calling thread. The
+	 * default \c 0 uses the environment variable \c SPL_NUM_THREADS or the
+	 * number of hardware threads.
+	 */
+	explicit SPLThreadPool(const SPLsizei threads = 0) throw();
+
+	/*! \brief Destructor!
+	 *
+	 * Stops and joins the worker threads.
+	 */
+	~SPLThreadPool(void) throw();
+
+	/*! \brief Returns the number of threads including the calling thread!
+	 *
+	 * \return Number of threads.
+	 */
+	SPLsizei getNumThreads(void) const throw() { return SPLsizei(this->workers.size()) + 1; }
+
+	/*! \brief Executes a function for the range \f$ [begin, end) \f$ in parallel!
+	 *
+	 * The range is split into chunks of \c grain indices (the last chunk
+	 * may be smaller) which are processed by the threads in any order.
+	 * The function is called as \c f(first, last) for each chunk and the
+	 * call returns when all chunks are done.
+	 *
+	 * \param begin First index.
+	 * \param end One past the last index.
+	 * \param grain Number of indices per chunk.
+	 * \param f The function.
+	 */
+	template <class F>
+	void parallelFor(const SPLint64 begin, const SPLint64 end, const SPLint64 grain, const F &f) throw();
+
+	/*! \brief Returns a suitable chunk size!
+	 *
+	 * \param n Number of indices.
+	 * \param minimum Minimum number of indices per chunk.
+	 *
+	 * \return Chunk size with a few chunks per thread.
+	 */
+	SPLint64 getGrain(const SPLint64 n, const SPLint64 minimum = 1) const throw();
+
+	/*! \brief Returns the pool shared by the library!
+	 *
+	 * \return Reference of the global pool.
+	 */
+	static SPLThreadPool& getGlobal(void) throw();
+
+private:
+	SPLThreadPool(const SPLThreadPool &);
+	SPLThreadPool& operator = (const SPLThreadPool &);
+
+	void run(void) throw();
+	void work(void) throw();
+
+	std::vector<std::thread> workers;	//!< The worker threads.
+	std::mutex jobMutex;				//!< Serializes concurrent calls of parallelFor().
+	std::mutex mutex;					//!< Protects the job state.
+	std::condition_variable wake;		//!< Signals a new job or the shutdown.
+	std::condition_variable done;		//!< Signals the end of a job.
+	std::function<void(SPLint64, SPLint64)> job;	//!< The current chunk function.
+	SPLint64 jobBegin;					//!< First index of the current job.
+	SPLint64 jobEnd;					//!< End index of the current job.
+	SPLint64 jobGrain;					//!< Chunk size of the current job.
+	std::atomic<SPLint64> next;			//!< Index of the next unprocessed chunk.
+	SPLsizei busy;						//!< Number of workers processing the current job.
+	SPLuint64 generation;				//!< Counter of the jobs.
+	bool stop;							//!< Shutdown flag.
+};
+
+/************************************************************************************************
+ ** SPLThreadPool class implementation
+ ************************************************************************************************/
+inline SPLThreadPool::SPLThreadPool(const SPLsizei threads) throw()
+	: jobBegin(0), jobEnd(0), jobGrain(1), next(0), busy(0), generation(0), stop(false)
+{
+	SPLsizei n = threads;
+	if (n <= 0)
+	{
+		const char *env = getenv("SPL_NUM_THREADS");
+		n = (env != 0) ? atoi(env) : 0;
+	}
+	if (n <= 0)
+	{
+		n = SPLsizei(std::thread::hardware_concurrency());
+	}
+	for (SPLsizei i = 1; i < n; i++)
+	{
+		try
+		{
+			this->workers.push_back(std::thread(&SPLThreadPool::run, this));
+		}
+		catch (...)
+		{
+			// fewer threads than requested
+			break;
+		}
+	}
+}
+
+inline SPLThreadPool::~SPLThreadPool(void) throw()
+{
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		this->stop = true;
+	}
+	this->wake.notify_all();
+	for (size_t i = 0; i < this->workers.size(); i++)
+	{
+		this->workers[i].join();
+	}
+}
+
+inline SPLThreadPool& SPLThreadPool::getGlobal(void) throw()
+{
+	static SPLThreadPool pool;
+	return pool;
+}
+
+inline SPLint64 SPLThreadPool::getGrain(const SPLint64 n, const SPLint64 minimum) const throw()
+{
+	// a few chunks per thread balance the load
+	const SPLint64 chunks = SPLint64(this->getNumThreads()) * 4;
+	const SPLint64 grain = (n + chunks - 1) / chunks;
+	return (grain < minimum) ? minimum : grain;
+}
+
+namespace SPLThreadPoolDetail
+{
+	//! Set for threads which currently process a chunk.
+	inline bool& inParallel(void) throw()
+	{
+		static thread_local bool flag = false;
+		return flag;
+	}
+}
+
+template <class F>
+void SPLThreadPool::parallelFor(const SPLint64 begin, const SPLint64 end, const SPLint64 grain, const F &f) throw()
+{
+	assert(grain > 0);
+	if (end <= begin)
+	{
+		return;
+	}
+	if (this->workers.empty() || end - begin <= grain || SPLThreadPoolDetail::inParallel())
+	{
+		f(begin, end);
+		return;
+	}
+	std::lock_guard<std::mutex> jobLock(this->jobMutex);
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		this->job = [&f](const SPLint64 first, const SPLint64 last) { f(first, last); };
+		this->jobBegin = begin;
+		this->jobEnd = end;
+		this->jobGrain = grain;
+		this->next.store(0);
+		this->busy = SPLsizei(this->workers.size());
+		this->generation++;
+	}
+	this->wake.notify_all();
+	this->work();
+	std::unique_lock<std::mutex> lock(this->mutex);
+	this->done.wait(lock, [this]() { return this->busy == 0; });
+	this->job = std::function<void(SPLint64, SPLint64)>();
+}
+
+inline void SPLThreadPool::work(void) throw()
+{
+	const SPLint64 chunks = (this->jobEnd - this->jobBegin + this->jobGrain - 1) / this->jobGrain;
+	SPLThreadPoolDetail::inParallel() = true;
+	for (SPLint64 c = this->next.fetch_add(1); c < chunks; c = this->next.fetch_add(1))
+	{
+		const SPLint64 first = this->jobBegin + c * this->jobGrain;
+		const SPLint64 last = (first + this->jobGrain < this->jobEnd) ? first + this->jobGrain : this->jobEnd;
+		this->job(first, last);
+	}
+	SPLThreadPoolDetail::inParallel() = false;
+}
+
+inline void SPLThreadPool::run(void) throw()
+{
+	SPLuint64 seen = 0;
+	for (;;)
+	{
+		{
+			std::unique_lock<std::mutex> lock(this->mutex);
+			this->wake.wait(lock, [this, seen]() { return this->stop || this->generation != seen; });
+			if (this->stop)
+			{
+				return;
+			}
+			seen = this->generation;
+		}
+		this->work();
+		{
+			std::lock_guard<std::mutex> lock(this->mutex);
+			this->busy--;
+		}
+		this->done.notify_one();
+	}
+}
+
+#endif /* _spl_threadpool_hh_ */
@@ -41,6 +41,11 @@ enum m_SPLenum
    SPL_CAMERA_MIN                  		 = __SPL_ENUM_FIRST + __SPL_ENUM_RANGE * 2,
    SPL_MATERIAL_MIN						 = __SPL_ENUM_FIRST + __SPL_ENUM_RANGE * 3,
    SPL_LIGHT_MIN						 = __SPL_ENUM_FIRST + __SPL_ENUM_RANGE * 4,
+   SPL_GRID_MIN							 = __SPL_ENUM_FIRST + __SPL_ENUM_RANGE * 5,
+   SPL_GRADIENT_MIN						 = __SPL_ENUM_FIRST + __SPL_ENUM_RANGE * 6,
+   SPL_BORDER_MIN						 = __SPL_ENUM_FIRST + __SPL_ENUM_RANGE * 7,
+   SPL_CONVOLUTION_MIN					 = __SPL_ENUM_FIRST + __SPL_ENUM_RANGE * 8,
+   SPL_SAMPLER_MIN						 = __SPL_ENUM_FIRST + __SPL_ENUM_RANGE * 9,
    // type identifier constants
    // for scalar types
    SPL_TYPE_UINT8 = SPL_TYPE_MIN + 1, //!< Identification number for storage type \ref SPLuint8 
@@ -59,6 +64,10 @@ enum m_SPLenum
    SPL_TYPE_RGBA8,	//!< Identification number for storage type \ref SPLRGBA8
    SPL_TYPE_RGBAf,	//!< Identification number for storage type \ref SPLRGBAf
 //   SPL_TYPE_VEC4I,	//!< Identification number for storage type \ref SPLRGBA8
+   // for compact storage types of floating point data (half precision and normalized integers), see half.hh
+   SPL_TYPE_IEEE16,	//!< Identification number for storage type \ref SPLieee16
+   SPL_TYPE_UNORM8,	//!< Identification number for storage type \ref SPLunorm8
+   SPL_TYPE_UNORM16,	//!< Identification number for storage type \ref SPLunorm16
    SPL_TYPE_MAX,
    
    SPL_FILEIO_PGM_ID = SPL_FILEIO_MIN + 1,	//!< Identification number for the \b "pgm" file storage type, see \ref SPLFileIO, \ref SPLGrid
@@ -69,6 +78,12 @@ enum m_SPLenum
    SPL_FILEIO_NII_ID,		//!< Identification number for the \b "nii" file storage type, see \ref SPLFileIO, \ref SPLGrid
    SPL_FILEIO_VTR_ID,		//!< Identification number for the \b "vtr" file storage type, see \ref SPLFileIO, \ref SPLGrid
    SPL_FILEIO_MAX,
+
+   SPL_FILEIO_ACCESS_MIN,
+   SPL_FILEIO_ACCESS_NORMAL,		//!< Identification number for no access pattern hint, see \ref SPLMappedFile
+   SPL_FILEIO_ACCESS_SEQUENTIAL,	//!< Identification number for a sequential access pattern (read ahead), see \ref SPLMappedFile
+   SPL_FILEIO_ACCESS_RANDOM,		//!< Identification number for a random access pattern (no read ahead), see \ref SPLMappedFile
+   SPL_FILEIO_ACCESS_MAX,
    
    SPL_CAMERA_MATRIX_MODELVIEW = SPL_CAMERA_MIN + 1,	//!< Identification number for the modelview camera matrix, see \ref SPLCamera \ref SPLMatrix4 
    SPL_CAMERA_MATRIX_ORTHO,		//!< Identification number for the projection (orthographic) camera matrix, see \ref SPLCamera \ref SPLMatrix4 
@@ -103,8 +118,54 @@ enum m_SPLenum
 
 	SPL_LIGHT_POIN = SPL_LIGHT_MIN + 1, //!< Identification number for the point light source
 	SPL_LIGHT_DIRE,						//!< Identification number for the directional light source
-	SPL_LIGHT_SPOT						//!< Identification number for the spot light source
+	SPL_LIGHT_SPOT,						//!< Identification number for the spot light source
+	SPL_LIGHT_MAX,
+
+	SPL_GRID_LINEAR = SPL_GRID_MIN + 1,	//!< Identification number for the linear (x fastest) memory layout, see \ref SPLGrid
+	SPL_GRID_BRICKED,					//!< Identification number for the bricked (Morton ordered) memory layout, see \ref SPLGrid
+	SPL_GRID_MAX,
+
+	SPL_GRADIENT_ONTHEFLY = SPL_GRADIENT_MIN + 1,	//!< Identification number for gradients computed per sample, see \ref SPLGradientVolume
+	SPL_GRADIENT_FLOAT,								//!< Identification number for precomputed float gradients, see \ref SPLGradientVolume
+	SPL_GRADIENT_QUANTIZED,							//!< Identification number for precomputed octahedral normals and magnitudes, see \ref SPLGradientVolume
+	SPL_GRADIENT_MAX,
+
+	SPL_BORDER_CLAMP = SPL_BORDER_MIN + 1,	//!< Identification number for voxels outside a grid repeating the border voxel, see \ref convolution.hh
+	SPL_BORDER_MIRROR,						//!< Identification number for voxels outside a grid mirrored at the border voxel, see \ref convolution.hh
+	SPL_BORDER_WRAP,						//!< Identification number for periodic voxels outside a grid, see \ref convolution.hh
+	SPL_BORDER_ZERO,						//!< Identification number for zero voxels outside a grid, see \ref convolution.hh
+	SPL_BORDER_MAX,
+
+	SPL_CONVOLUTION_AUTO = SPL_CONVOLUTION_MIN + 1,	//!< Identification number for the faster of the direct and the spectral convolution, see \ref splConvolve
+	SPL_CONVOLUTION_DIRECT,							//!< Identification number for the direct convolution, see \ref splConvolve
+	SPL_CONVOLUTION_SPECTRAL,						//!< Identification number for the convolution by FFTs, see \ref splConvolve
+	SPL_CONVOLUTION_MAX,
+
+	SPL_SAMPLER_NEAREST = SPL_SAMPLER_MIN + 1,	//!< Identification number for the value of the nearest voxel, see \ref SPLSampler
+	SPL_SAMPLER_LINEAR,							//!< Identification number for the trilinear interpolation of 2^3 voxels, see \ref SPLSampler
+	SPL_SAMPLER_CUBIC,							//!< Identification number for the tricubic (Catmull-Rom) interpolation of 4^3 voxels, see \ref SPLSampler
+	SPL_SAMPLER_MAX
 };
 
+/*! \brief Identification number of a storage type!
+ *
+ * \c SPLTypeId<T>::value is the \c SPL_TYPE_* constant of the storage type
+ * \c T, e.g. \c SPLTypeId<SPLieee32>::value is \ref SPL_TYPE_IEEE32, and
+ * \ref SPL_TYPE_MIN for types without an identification number.
+ */
+template <class T> struct SPLTypeId { static const SPLenum value = SPL_TYPE_MIN; };
+template <> struct SPLTypeId<SPLuint8> { static const SPLenum value = SPL_TYPE_UINT8; };
+template <> struct SPLTypeId<SPLint8> { static const SPLenum value = SPL_TYPE_INT8; };
+template <> struct SPLTypeId<SPLuint16> { static const SPLenum value = SPL_TYPE_UINT16; };
+template <> struct SPLTypeId<SPLint16> { static const SPLenum value = SPL_TYPE_INT16; };
+template <> struct SPLTypeId<SPLuint32> { static const SPLenum value = SPL_TYPE_UINT32; };
+template <> struct SPLTypeId<SPLint32> { static const SPLenum value = SPL_TYPE_INT32; };
+template <> struct SPLTypeId<SPLuint64> { static const SPLenum value = SPL_TYPE_UINT64; };
+template <> struct SPLTypeId<SPLint64> { static const SPLenum value = SPL_TYPE_INT64; };
+template <> struct SPLTypeId<SPLieee32> { static const SPLenum value = SPL_TYPE_IEEE32; };
+template <> struct SPLTypeId<SPLieee64> { static const SPLenum value = SPL_TYPE_IEEE64; };
+template <> struct SPLTypeId<SPLieee128> { static const SPLenum value = SPL_TYPE_IEEE128; };
+template <> struct SPLTypeId<SPLvoidp> { static const SPLenum value = SPL_TYPE_VOIDP; };
+
 #endif /* _spl_typesbase_hh_ */
 
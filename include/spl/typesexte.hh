@@ -1,11 +1,11 @@
 #ifndef _typesexte_hh_
 #define _typesexte_hh_
 
-#include <spl/vector2.hh>
 #include <spl/vector3.hh>
 #include <spl/vector4.hh>
+#include <spl/matrix3.hh>
 #include <spl/matrix4.hh>
-#include <spl/rgba.hh>
+#include <spl/grid.hh>
 
 /*! \file typesexte.hh
  * \brief This file includes all extended data types.
@@ -13,7 +13,7 @@
  * The usuall data type are, for example, \ref SPLuint8, ..., \ref SPLieee64. 
  * For extended data types there is often a class definition with appropriate 
  * functions and behaviour of that type. Examples are \ref SPLVector4, 
- * \ref SPLMatrix4, \ref SPLRGBA, ... .
+ * \ref SPLMatrix4, ... .
  * */ 
  
 #endif /*_typesexte_hh_*/
@@ -6,13 +6,9 @@
 #endif
 
 #include <spl/typesbase.hh>
-
-#define __CUDACC__
-#ifdef __CUDACC__
-#define CUDA_CALLABLE_MEMBER __host__ __device__
-#else
-#define CUDA_CALLABLE_MEMBER
-#endif
+#include <spl/mathbase.hh>
+#include <spl/cudadefs.hh>
+#include <spl/precision.hh>
 
 #ifdef __DEBUG__
 # include <cstdio>
@@ -22,6 +18,7 @@ template <class T> class SPLVector3;
 template <class T> class SPLVector4;
 template <class T> class SPLMatrix3;
 template <class T> class SPLMatrix4;
+template <class E> class SPLVector3Expr;
 
 typedef SPLVector3<SPLint32> SPLVector3i;	//!< Vector type with SPLint32 (32bit) resolution for each vector component!
 typedef SPLVector3<SPLieee32> SPLVector3f;	//!< Vector type with SPLieee32 (32bit) resolution for each vector component!
@@ -171,6 +168,23 @@ public:
 	 */
 	CUDA_CALLABLE_MEMBER SPLVector3(const SPLVector4<T> &v) throw();
 
+ 	/*! \brief Constructor!
+	 * 
+	 * Initializes the class variables by evaluating a lazy vector 
+	 * expression, see \ref vector3expr.hh.
+	 * 
+	 * Example 
+	 * \code
+	 * SPLVector3f a, b, c;
+	 * SPLVector3f V(splExpr(a) + b * 2.0f - c);
+	 * 
+	 * \endcode
+	 * 
+	 * \param e A vector expression.
+	 */
+	template <class E>
+	CUDA_CALLABLE_MEMBER SPLVector3(const SPLVector3Expr<E> &e) throw();
+
 	/*! \brief Destructor!
 	 *
 	 * Frees all previously alloced space.
@@ -253,6 +267,17 @@ public:
 	 */	
 	CUDA_CALLABLE_MEMBER SPLVector3<T>& operator = (const SPLVector4<SPLieee64> &v) throw();
 
+	/*! \brief Assigment operator!
+	 * 
+	 * Evaluates a lazy vector expression in one pass, see \ref vector3expr.hh.
+	 * 
+	 * \param e A vector expression.
+	 * 
+	 * \return Reference of this vector.
+	 */	
+	template <class E>
+	CUDA_CALLABLE_MEMBER SPLVector3<T>& operator = (const SPLVector3Expr<E> &e) throw();
+
 
 	/*! \brief Access operator!
 	 * 
@@ -538,10 +563,32 @@ public:
 	 * 
 	 * \endcode
 	 * 
+	 * The value is computed with the precision policy \ref SPLPrecisionDefault
+	 * of the type \c T, see \ref precision.hh.
+	 * 
 	 * \return The scalar square value of this vector.
 	 */	
 	CUDA_CALLABLE_MEMBER SPLieee64 square(void) const throw();
 
+	/*! \brief Returns the square value of the vector with a precision policy!
+	 * 
+	 * Computes the square value like \ref square(void) const in the type
+	 * selected by the precision policy \c P, see \ref precision.hh.
+	 * 
+	 * Example 
+	 * \code
+	 * SPLVector3f V(1.0f, 2.0f, 3.0f);
+	 * SPLieee32 s
+	 * 
+	 * s = V.square<SPLPrecisionNative>(); // s == 14.0f
+	 * 
+	 * \endcode
+	 * 
+	 * \return The scalar square value of this vector.
+	 */	
+	template <class P>
+	CUDA_CALLABLE_MEMBER typename P::template Real<T>::Type square(void) const throw();
+
 	/*! \brief Returns the length value of the vector!
 	 * 
 	 * Computes and returns the scalar length value \f$ s \f$ of this vector \f$ {\bf V} \f$.
@@ -557,10 +604,32 @@ public:
 	 * 
 	 * \endcode
 	 * 
+	 * The value is computed with the precision policy \ref SPLPrecisionDefault
+	 * of the type \c T, see \ref precision.hh.
+	 * 
 	 * \return The scalar length of this vector.
 	 */	
 	CUDA_CALLABLE_MEMBER SPLieee64 length(void) const throw();
 
+	/*! \brief Returns the length value of the vector with a precision policy!
+	 * 
+	 * Computes the length like \ref length(void) const in the type
+	 * selected by the precision policy \c P, see \ref precision.hh.
+	 * 
+	 * Example 
+	 * \code
+	 * SPLVector3f V(1.0f, 2.0f, 3.0f);
+	 * SPLieee32 s
+	 * 
+	 * s = V.length<SPLPrecisionFast>(); // s == 3.74f
+	 * 
+	 * \endcode
+	 * 
+	 * \return The scalar length of this vector.
+	 */	
+	template <class P>
+	CUDA_CALLABLE_MEMBER typename P::template Real<T>::Type length(void) const throw();
+
 	/*! \brief Returns the normalized vector (inplace)!
 	 * 
 	 * Normalizes this vector \f$ {\bf V} \f$.
@@ -578,10 +647,33 @@ public:
 	 * 
 	 * \param l The length of the resulting vector.
 	 * 
+	 * The vector is normalized with the precision policy \ref SPLPrecisionDefault
+	 * of the type \c T, see \ref precision.hh. A vector of length zero is not changed.
+	 * 
 	 * \return Reference of this normalized vector to a certain length.
 	 */	
 	CUDA_CALLABLE_MEMBER SPLVector3<T>& normalize(const SPLieee64 l = 1.0) throw();
 
+	/*! \brief Returns the normalized vector (inplace) with a precision policy!
+	 * 
+	 * Normalizes this vector like \ref normalize(const SPLieee64) in the type
+	 * selected by the precision policy \c P, see \ref precision.hh.
+	 * 
+	 * Example 
+	 * \code
+	 * SPLVector3f V(1.0f, 2.0f, 3.0f);
+	 *  
+	 * V.normalize<SPLPrecisionFast>(); // single precision only
+	 * 
+	 * \endcode
+	 * 
+	 * \param l The length of the resulting vector.
+	 * 
+	 * \return Reference of this normalized vector to a certain length.
+	 */	
+	template <class P>
+	CUDA_CALLABLE_MEMBER SPLVector3<T>& normalize(const typename P::template Real<T>::Type l = 1) throw();
+
 	/*! \brief Returns the normalized vector!
 	 * 
 	 * Returns a new normalized vector \f$ {\bf n} \f$ of 
@@ -604,6 +696,18 @@ public:
 	 */	
 	CUDA_CALLABLE_MEMBER SPLVector3<T> getNormalized(const SPLieee64 length = 1.0) const throw();
 
+	/*! \brief Returns the normalized vector with a precision policy!
+	 * 
+	 * Returns a new normalized vector like \ref getNormalized(const SPLieee64) const 
+	 * computed in the type selected by the precision policy \c P, see \ref precision.hh.
+	 * 
+	 * \param length The length of the resulting vector.
+	 * 
+	 * \return New normalized vector to a certain length
+	 */	
+	template <class P>
+	CUDA_CALLABLE_MEMBER SPLVector3<T> getNormalized(const typename P::template Real<T>::Type length = 1) const throw();
+
 	/*! \brief The cross product of two vectors!
 	 * 
 	 * Computes the cross product of a vector \f$ {\bf v} \f$ and 
@@ -780,16 +884,6 @@ SPLVector3<T>& SPLVector3<T>::operator = (const SPLVector3<T> &v) throw()
 	return (*this);
 }
 
-template <class T>
-SPLVector3<T>& SPLVector3<T>::operator = (const SPLVector4<SPLieee64> &v) throw()
-{
-	this->x=T(v.x);
-	this->y=T(v.y);
-	this->z=T(v.z);
-	// v.w discard
-	return (*this);
-}
-
 
 template <class T>
 T& SPLVector3<T>::operator [] (const SPLindex i) throw()
@@ -858,33 +952,26 @@ SPLVector3<T>& SPLVector3<T>::operator /= (T s) throw()
 template <class T>
 SPLVector3<T> SPLVector3<T>::operator + (const SPLVector3<T> &v) const throw()
 {
-	SPLVector3<T> ret(*this);
-	ret += v;
-	return ret;
+	return SPLVector3<T>(this->x + v.x, this->y + v.y, this->z + v.z);
 }
 
 template <class T>
 SPLVector3<T> SPLVector3<T>::operator - (const SPLVector3<T> &v) const throw()
 {
-	SPLVector3<T> ret(*this);
-	ret -= v;
-	return ret;
+	return SPLVector3<T>(this->x - v.x, this->y - v.y, this->z - v.z);
 }
 
 template <class T>
 SPLVector3<T> SPLVector3<T>::operator * (T s) const throw()
 {
-	SPLVector3<T> ret(*this);
-	ret *= s;
-	return ret;
+	return SPLVector3<T>(this->x * s, this->y * s, this->z * s);
 }
 
 template <class T>
 SPLVector3<T> SPLVector3<T>::operator / (T s) const throw()
 {
-	SPLVector3<T> ret(*this);
-	ret /= s;
-	return ret;
+	assert (s != T(0));
+	return SPLVector3<T>(this->x / s, this->y / s, this->z / s);
 }
 
 template <class T>
@@ -910,37 +997,56 @@ SPLVector3<T> SPLVector3<T>::crossProduct(const SPLVector3<T> &v) const throw()
 template<class T>
 SPLieee64 SPLVector3<T>::square(void) const throw()
 {
-	double xx = POW2(this->x);
-	double yy = POW2(this->y);
-	double zz = POW2(this->z);
-	return SPLieee64(xx + yy + zz);
+	return SPLieee64(this->template square<typename SPLPrecisionDefault<T>::Type>());
+}
+
+template<class T>
+template<class P>
+typename P::template Real<T>::Type SPLVector3<T>::square(void) const throw()
+{
+	typedef typename P::template Real<T>::Type R;
+	return R(this->x) * R(this->x) + R(this->y) * R(this->y) + R(this->z) * R(this->z);
 }
 
 template<class T>
 SPLieee64 SPLVector3<T>::length(void) const throw()
 {
-	double help;
-	help = double(this->square());
-	assert(help >= double(0));
-	help = SQRT(help);
-	assert(help >= double(0));
-	return SPLieee64(help);
+	return SPLieee64(this->template length<typename SPLPrecisionDefault<T>::Type>());
+}
+
+template<class T>
+template<class P>
+typename P::template Real<T>::Type SPLVector3<T>::length(void) const throw()
+{
+	typedef typename P::template Real<T>::Type R;
+	const R help = this->template square<P>();
+	assert(help >= R(0));
+	return P::length(help);
 }
 
 template<class T>
 SPLVector3<T>& SPLVector3<T>::normalize(const SPLieee64 length) throw()
 {
-	assert(length > SPLieee64(0));
-	SPLieee64 len;
-	len = this->length();
-	if (len == SPLieee64(0))
+	typedef typename SPLPrecisionDefault<T>::Type P;
+	return this->template normalize<P>(typename P::template Real<T>::Type(length));
+}
+
+template<class T>
+template<class P>
+SPLVector3<T>& SPLVector3<T>::normalize(const typename P::template Real<T>::Type length) throw()
+{
+	typedef typename P::template Real<T>::Type R;
+	assert(length > R(0));
+	const R sq = this->template square<P>();
+	if (sq == R(0))
 	{
 		return *this;
 	}
-	this->x = SPLieee32(SPLieee64(this->x) * length / len);
-	this->y = SPLieee32(SPLieee64(this->y) * length / len);
-	this->z = SPLieee32(SPLieee64(this->z) * length / len);
-	assert(ABS(this->length() - length) < SPLieee64(EPS));
+	const R f = length * P::rsqrt(sq);
+	this->x = T(R(this->x) * f);
+	this->y = T(R(this->y) * f);
+	this->z = T(R(this->z) * f);
+	assert(ABS(SPLieee64(this->template length<P>()) - SPLieee64(length)) < SPLieee64(EPS) * SPLieee64(length));
 	return *this;
 }
 
@@ -952,6 +1058,15 @@ SPLVector3<T> SPLVector3<T>::getNormalized(const SPLieee64 length) const throw()
 	return ret;
 }
 
+template<class T>
+template<class P>
+SPLVector3<T> SPLVector3<T>::getNormalized(const typename P::template Real<T>::Type length) const throw()
+{
+	SPLVector3<T> ret(*this);
+	ret.template normalize<P>(length);
+	return ret;
+}
+
 template<class T>
 SPLVector3<SPLint32> SPLVector3<T>::getROUNDint(void) const throw()
 {
@@ -0,0 +1,543 @@
+#ifndef _spl_vector3a_hh_
+#define _spl_vector3a_hh_
+
+#ifdef __DEBUG__
+#include <cstdio>
+#endif
+#include <type_traits>
+
+#include <spl/typesbase.hh>
+#include <spl/mathbase.hh>
+#include <spl/cudadefs.hh>
+#include <spl/precision.hh>
+#include <spl/simd4.hh>
+#include <spl/vector3.hh>
+#include <spl/vector4.hh>
+
+template <class T> class SPLVector3a;
+
+typedef SPLVector3a<SPLint32> SPLVector3ai;		//!< Padded vector type with SPLint32 (32bit) resolution for each vector component!
+typedef SPLVector3a<SPLieee32> SPLVector3af;	//!< Padded vector type with SPLieee32 (32bit) resolution for each vector component!
+typedef SPLVector3a<SPLieee64> SPLVector3ad;	//!< Padded vector type with SPLieee64 (64bit) resolution for each vector component!
+
+/*! \file vector3a.hh
+ * */
+
+/*! \class SPLVector3a
+ * \brief A \f$ 3 \f$ dimensional vector padded to a SIMD register.
+ *
+ * The vector has the components of \ref SPLVector3 plus a padding element
+ * \c w, which is always \f$ 0 \f$, and is aligned to 16 bytes. An
+ * \ref SPLVector3af therefore occupies exactly one SSE or NEON register
+ * and arrays of it never straddle cache lines, at the cost of 4 more
+ * bytes per vector. Its operators are computed with \ref SPLSimd4f, e.g.
+ * the cross product takes 4 shuffles, 2 multiplications and 1 subtraction
+ * and the normalization a dot product, a square root and a multiplication.
+ *
+ * Unlike \ref SPLVector3, the length and the normalization are computed in
+ * the precision of the components (\ref SPLPrecisionNative) unless another
+ * policy is given, e.g. \c v.normalize<SPLPrecisionFast>().
+ *
+ * Example
+ * \code
+ * SPLVector3f p(1.0f, 2.0f, 3.0f);
+ * SPLVector3af a(p), b(0.0f, 0.0f, 1.0f);
+ *
+ * a = a.crossProduct(b).normalize();
+ * p = a.getVector3();
+ * \endcode
+ *
+ * \sa SPLVector3 SPLVector4
+*/
+template <class T>
+class alignas(16) SPLVector3a
+{
+public:
+	/*! \brief Constructor!
+	 *
+	 * Initializes all elements to \f$ 0 \f$.
+	 */
+	CUDA_CALLABLE_MEMBER SPLVector3a(void) throw();
+
+	/*! \brief Constructor!
+	 *
+	 * \param x 1st vector element (i.e. \c v.x = \c x).
+	 * \param y 2nd vector element (i.e. \c v.y = \c y).
+	 * \param z 3rd vector element (i.e. \c v.z = \c z).
+	 */
+	CUDA_CALLABLE_MEMBER SPLVector3a(const T x, const T y, const T z) throw();
+
+	/*! \brief Constructor!
+	 *
+	 * Converts an unpadded vector.
+	 *
+	 * \param v A vector with type \c T.
+	 */
+	CUDA_CALLABLE_MEMBER explicit SPLVector3a(const SPLVector3<T> &v) throw();
+
+	/*! \brief Constructor!
+	 *
+	 * Converts a homogeneous vector, the element \c v.w is discarded.
+	 *
+	 * \param v A vector with type \c T.
+	 */
+	CUDA_CALLABLE_MEMBER explicit SPLVector3a(const SPLVector4<T> &v) throw();
+
+	/*! \brief Returns the unpadded vector!
+	 *
+	 * \return New vector.
+	 */
+	CUDA_CALLABLE_MEMBER SPLVector3<T> getVector3(void) const throw();
+
+	/*! \brief Comparison operator!
+	 *
+	 * \param v Another vector.
+	 *
+	 * \return \c true if all elements are equal and \c false ontherwise.
+	 */
+	CUDA_CALLABLE_MEMBER bool operator == (const SPLVector3a<T> &v) const throw();
+
+	/*! \brief Comparison operator!
+	 *
+	 * \param v Another vector.
+	 *
+	 * \return \c true if any element differs and \c false ontherwise.
+	 */
+	CUDA_CALLABLE_MEMBER bool operator != (const SPLVector3a<T> &v) const throw();
+
+	/*! \brief Access operator!
+	 *
+	 * \param i Index into the vector elements \f$ [0, 2] \f$.
+	 *
+	 * \return Reference of an element.
+	 */
+	CUDA_CALLABLE_MEMBER T& operator [] (const SPLindex i) throw();
+
+	/*! \brief Access operator!
+	 *
+	 * \param i Index into the vector elements \f$ [0, 2] \f$.
+	 *
+	 * \return Reference of an element.
+	 */
+	CUDA_CALLABLE_MEMBER const T& operator [] (const SPLindex i) const throw();
+
+	/*! \brief Unary minus!
+	 *
+	 * \return New vector \f$ -{\bf V} \f$.
+	 */
+	CUDA_CALLABLE_MEMBER SPLVector3a<T> operator - (void) const throw();
+
+	/*! \brief Multiplication operator!
+	 *
+	 * \param v Another vector.
+	 *
+	 * \return Scalar value (vector product) \f$ {\bf V} * {\bf v} \f$.
+	 */
+	CUDA_CALLABLE_MEMBER T operator * (const SPLVector3a<T> &v) const throw();
+
+	/*! \brief Addition operator!
+	 *
+	 * \param v Another vector.
+	 *
+	 * \return Reference of this vector.
+	 */
+	CUDA_CALLABLE_MEMBER SPLVector3a<T>& operator += (const SPLVector3a<T> &v) throw();
+
+	/*! \brief Subtraction operator!
+	 *
+	 * \param v Another vector.
+	 *
+	 * \return Reference of this vector.
+	 */
+	CUDA_CALLABLE_MEMBER SPLVector3a<T>& operator -= (const SPLVector3a<T> &v) throw();
+
+	/*! \brief Multiplication operator!
+	 *
+	 * \param s A scalar value.
+	 *
+	 * \return Reference of this vector.
+	 */
+	CUDA_CALLABLE_MEMBER SPLVector3a<T>& operator *= (const T s) throw();
+
+	/*! \brief Division operator!
+	 *
+	 * \param s A scalar value (non zero).
+	 *
+	 * \return Reference of this vector.
+	 */
+	CUDA_CALLABLE_MEMBER SPLVector3a<T>& operator /= (const T s) throw();
+
+	/*! \brief Addition operator!
+	 *
+	 * \param v Another vector.
+	 *
+	 * \return New vector \f$ {\bf V} + {\bf v} \f$.
+	 */
+	CUDA_CALLABLE_MEMBER SPLVector3a<T> operator + (const SPLVector3a<T> &v) const throw();
+
+	/*! \brief Subtraction operator!
+	 *
+	 * \param v Another vector.
+	 *
+	 * \return New vector \f$ {\bf V} - {\bf v} \f$.
+	 */
+	CUDA_CALLABLE_MEMBER SPLVector3a<T> operator - (const SPLVector3a<T> &v) const throw();
+
+	/*! \brief Multiplication operator!
+	 *
+	 * \param s A scalar value.
+	 *
+	 * \return New vector \f$ s * {\bf V} \f$.
+	 */
+	CUDA_CALLABLE_MEMBER SPLVector3a<T> operator * (const T s) const throw();
+
+	/*! \brief Division operator!
+	 *
+	 * \param s A scalar value (non zero).
+	 *
+	 * \return New vector \f$ {1 \over s} * {\bf V} \f$.
+	 */
+	CUDA_CALLABLE_MEMBER SPLVector3a<T> operator / (const T s) const throw();
+
+	/*! \brief Print the elements to standard output!
+	 *
+	 * The elements are printed only in debugging mode,
+	 * i.e. when the library has been compiled with the flag -D__DEBUG__.
+	 */
+	CUDA_CALLABLE_MEMBER void print(void) const throw();
+
+	/*! \brief Returns the square value of the vector!
+	 *
+	 * \return \f$ {\| {\bf V} \|}^2 \f$ in the type of the policy \c P.
+	 */
+	template <class P = SPLPrecisionNative>
+	CUDA_CALLABLE_MEMBER typename P::template Real<T>::Type square(void) const throw();
+
+	/*! \brief Returns the length value of the vector!
+	 *
+	 * \return \f$ {\| {\bf V} \|} \f$ in the type of the policy \c P.
+	 */
+	template <class P = SPLPrecisionNative>
+	CUDA_CALLABLE_MEMBER typename P::template Real<T>::Type length(void) const throw();
+
+	/*! \brief Returns the normalized vector (inplace)!
+	 *
+	 * \f[ {\bf V} = l * {\bf V} / {\| {\bf V} \|} \f]
+	 * A vector of length zero is not changed.
+	 *
+	 * \param l The length of the resulting vector.
+	 *
+	 * \return Reference of this normalized vector to a certain length.
+	 */
+	template <class P = SPLPrecisionNative>
+	CUDA_CALLABLE_MEMBER SPLVector3a<T>& normalize(const typename P::template Real<T>::Type l = 1) throw();
+
+	/*! \brief Returns the normalized vector!
+	 *
+	 * \param l The length of the resulting vector.
+	 *
+	 * \return New normalized vector to a certain length.
+	 */
+	template <class P = SPLPrecisionNative>
+	CUDA_CALLABLE_MEMBER SPLVector3a<T> getNormalized(const typename P::template Real<T>::Type l = 1) const throw();
+
+	/*! \brief The cross product of two vectors!
+	 *
+	 * \param v Another vector.
+	 *
+	 * \return New vector \f$ {\bf V} \times {\bf v} \f$.
+	 */
+	CUDA_CALLABLE_MEMBER SPLVector3a<T> crossProduct(const SPLVector3a<T> &v) const throw();
+
+	T x;	//!< 1st component (or element) of the vector.
+	T y;	//!< 2nd component (or element) of the vector.
+	T z;	//!< 3rd component (or element) of the vector.
+	T w;	//!< Padding, always \f$ 0 \f$.
+};
+
+/************************************************************************************************
+ ** Non member functions for SPLVector3a
+ ************************************************************************************************/
+/*! \fn SPLVector3a<T> operator * (const T s, const SPLVector3a<T> &v)
+ * \brief Multiplication operator!
+ *
+ * \param s A scalar value.
+ * \param v A vector.
+ *
+ * \return New vector \f$ s * {\bf v} \f$.
+*/
+template <class T>
+SPLVector3a<T> operator * (const T s, const SPLVector3a<T> &v)
+{
+	return v * s;
+}
+
+/************************************************************************************************
+ ** SPLVector3a class implementation
+ ************************************************************************************************/
+template <class T>
+SPLVector3a<T>::SPLVector3a(void) throw()
+	: x(T(0)), y(T(0)), z(T(0)), w(T(0))
+{
+}
+
+template <class T>
+SPLVector3a<T>::SPLVector3a(const T x, const T y, const T z) throw()
+	: x(x), y(y), z(z), w(T(0))
+{
+}
+
+template <class T>
+SPLVector3a<T>::SPLVector3a(const SPLVector3<T> &v) throw()
+	: x(v.x), y(v.y), z(v.z), w(T(0))
+{
+}
+
+template <class T>
+SPLVector3a<T>::SPLVector3a(const SPLVector4<T> &v) throw()
+	: x(v.x), y(v.y), z(v.z), w(T(0))
+{
+}
+
+template <class T>
+SPLVector3<T> SPLVector3a<T>::getVector3(void) const throw()
+{
+	return SPLVector3<T>(this->x, this->y, this->z);
+}
+
+template <class T>
+bool SPLVector3a<T>::operator == (const SPLVector3a<T> &v) const throw()
+{
+	return (this->x == v.x && this->y == v.y && this->z == v.z);
+}
+
+template <class T>
+bool SPLVector3a<T>::operator != (const SPLVector3a<T> &v) const throw()
+{
+	return !(this->operator == (v));
+}
+
+template <class T>
+T& SPLVector3a<T>::operator [] (const SPLindex i) throw()
+{
+	assert (i >= 0 && i <= 2);
+	return (&x)[i];
+}
+
+template <class T>
+const T& SPLVector3a<T>::operator [] (const SPLindex i) const throw()
+{
+	assert (i >= 0 && i <= 2);
+	return (&x)[i];
+}
+
+template <class T>
+SPLVector3a<T> SPLVector3a<T>::operator - (void) const throw()
+{
+#ifdef SPL_SIMD4
+	if constexpr (std::is_same<T, SPLieee32>::value)
+	{
+		SPLVector3a<T> ret;
+		SPLSimd4f::store(&ret.x, SPLSimd4f::sub(SPLSimd4f::zero(), SPLSimd4f::load(&this->x)));
+		return ret;
+	}
+#endif
+	return SPLVector3a<T>(-this->x, -this->y, -this->z);
+}
+
+template <class T>
+T SPLVector3a<T>::operator * (const SPLVector3a<T> &v) const throw()
+{
+#ifdef SPL_SIMD4
+	if constexpr (std::is_same<T, SPLieee32>::value)
+	{
+		// the padding is zero, i.e. all 4 lanes are summed up
+		return SPLSimd4f::first(SPLSimd4f::dot4(SPLSimd4f::load(&this->x), SPLSimd4f::load(&v.x)));
+	}
+#endif
+	return (this->x*v.x + this->y*v.y + this->z*v.z);
+}
+
+template <class T>
+SPLVector3a<T>& SPLVector3a<T>::operator += (const SPLVector3a<T> &v) throw()
+{
+#ifdef SPL_SIMD4
+	if constexpr (std::is_same<T, SPLieee32>::value)
+	{
+		SPLSimd4f::store(&this->x, SPLSimd4f::add(SPLSimd4f::load(&this->x), SPLSimd4f::load(&v.x)));
+		return (*this);
+	}
+#endif
+	this->x += v.x;
+	this->y += v.y;
+	this->z += v.z;
+	return (*this);
+}
+
+template <class T>
+SPLVector3a<T>& SPLVector3a<T>::operator -= (const SPLVector3a<T> &v) throw()
+{
+#ifdef SPL_SIMD4
+	if constexpr (std::is_same<T, SPLieee32>::value)
+	{
+		SPLSimd4f::store(&this->x, SPLSimd4f::sub(SPLSimd4f::load(&this->x), SPLSimd4f::load(&v.x)));
+		return (*this);
+	}
+#endif
+	this->x -= v.x;
+	this->y -= v.y;
+	this->z -= v.z;
+	return (*this);
+}
+
+template <class T>
+SPLVector3a<T>& SPLVector3a<T>::operator *= (const T s) throw()
+{
+	*this = (*this) * s;
+	return (*this);
+}
+
+template <class T>
+SPLVector3a<T>& SPLVector3a<T>::operator /= (const T s) throw()
+{
+	*this = (*this) / s;
+	return (*this);
+}
+
+template <class T>
+SPLVector3a<T> SPLVector3a<T>::operator + (const SPLVector3a<T> &v) const throw()
+{
+	SPLVector3a<T> ret(*this);
+	ret += v;
+	return ret;
+}
+
+template <class T>
+SPLVector3a<T> SPLVector3a<T>::operator - (const SPLVector3a<T> &v) const throw()
+{
+	SPLVector3a<T> ret(*this);
+	ret -= v;
+	return ret;
+}
+
+template <class T>
+SPLVector3a<T> SPLVector3a<T>::operator * (const T s) const throw()
+{
+#ifdef SPL_SIMD4
+	if constexpr (std::is_same<T, SPLieee32>::value)
+	{
+		SPLVector3a<T> ret;
+		SPLSimd4f::store(&ret.x, SPLSimd4f::mul(SPLSimd4f::load(&this->x), SPLSimd4f::set1(s)));
+		return ret;
+	}
+#endif
+	return SPLVector3a<T>(this->x * s, this->y * s, this->z * s);
+}
+
+template <class T>
+SPLVector3a<T> SPLVector3a<T>::operator / (const T s) const throw()
+{
+	assert (s != T(0));
+#ifdef SPL_SIMD4
+	if constexpr (std::is_same<T, SPLieee32>::value)
+	{
+		// the padding stays 0 / s = 0
+		SPLVector3a<T> ret;
+		SPLSimd4f::store(&ret.x, SPLSimd4f::div(SPLSimd4f::load(&this->x), SPLSimd4f::set1(s)));
+		return ret;
+	}
+#endif
+	return SPLVector3a<T>(this->x / s, this->y / s, this->z / s);
+}
+
+template <class T>
+void SPLVector3a<T>::print(void) const throw()
+{
+#ifdef __DEBUG__
+	printf("SPLVector3a:\n");
+	printf("%10.9f %10.9f %10.9f\n", double(x), double(y), double(z));
+#endif
+}
+
+template <class T>
+template <class P>
+typename P::template Real<T>::Type SPLVector3a<T>::square(void) const throw()
+{
+	typedef typename P::template Real<T>::Type R;
+#ifdef SPL_SIMD4
+	if constexpr (std::is_same<R, SPLieee32>::value && std::is_same<T, SPLieee32>::value)
+	{
+		const SPLSimd4f::Type v = SPLSimd4f::load(&this->x);
+		return SPLSimd4f::first(SPLSimd4f::dot4(v, v));
+	}
+#endif
+	return R(this->x) * R(this->x) + R(this->y) * R(this->y) + R(this->z) * R(this->z);
+}
+
+template <class T>
+template <class P>
+typename P::template Real<T>::Type SPLVector3a<T>::length(void) const throw()
+{
+	return P::length(this->template square<P>());
+}
+
+template <class T>
+template <class P>
+SPLVector3a<T>& SPLVector3a<T>::normalize(const typename P::template Real<T>::Type l) throw()
+{
+	typedef typename P::template Real<T>::Type R;
+	assert(l > R(0));
+#ifdef SPL_SIMD4
+	if constexpr (std::is_same<R, SPLieee32>::value && std::is_same<T, SPLieee32>::value)
+	{
+		const SPLSimd4f::Type v = SPLSimd4f::load(&this->x);
+		const SPLSimd4f::Type sq = SPLSimd4f::dot4(v, v);
+		if (SPLSimd4f::first(sq) == 0.0f)
+		{
+			return *this;
+		}
+		// the policy decides between the exact and the approximated root
+		const SPLSimd4f::Type f = std::is_same<P, SPLPrecisionFast>::value ?
+			SPLSimd4f::mul(SPLSimd4f::set1(l), SPLSimd4f::rsqrt(sq)) : SPLSimd4f::div(SPLSimd4f::set1(l), SPLSimd4f::sqrt(sq));
+		SPLSimd4f::store(&this->x, SPLSimd4f::mul(v, f));
+		return *this;
+	}
+#endif
+	const R sq = this->template square<P>();
+	if (sq == R(0))
+	{
+		return *this;
+	}
+	const R f = l * P::rsqrt(sq);
+	this->x = T(R(this->x) * f);
+	this->y = T(R(this->y) * f);
+	this->z = T(R(this->z) * f);
+	return *this;
+}
+
+template <class T>
+template <class P>
+SPLVector3a<T> SPLVector3a<T>::getNormalized(const typename P::template Real<T>::Type l) const throw()
+{
+	SPLVector3a<T> ret(*this);
+	ret.template normalize<P>(l);
+	return ret;
+}
+
+template <class T>
+SPLVector3a<T> SPLVector3a<T>::crossProduct(const SPLVector3a<T> &v) const throw()
+{
+#ifdef SPL_SIMD4
+	if constexpr (std::is_same<T, SPLieee32>::value)
+	{
+		SPLVector3a<T> ret;
+		SPLSimd4f::store(&ret.x, SPLSimd4f::cross(SPLSimd4f::load(&this->x), SPLSimd4f::load(&v.x)));
+		return ret;
+	}
+#endif
+	return SPLVector3a<T>(this->y * v.z - this->z * v.y,
+						  this->z * v.x - this->x * v.z,
+						  this->x * v.y - this->y * v.x);
+}
+
+#endif /*_spl_vector3a_hh_*/
@@ -0,0 +1,700 @@
+#ifndef _spl_vector3array_hh_
+#define _spl_vector3array_hh_
+
+#include <cstring>   // for memcpy(), memset()
+#include <limits>    // for std::numeric_limits
+
+#include <spl/typesbase.hh>
+#include <spl/simd.hh>
+#include <spl/allocator.hh>
+#include <spl/vector3.hh>
+#include <spl/vector3expr.hh>
+
+template <class T> class SPLVector3ArrayView;
+template <class T> class SPLVector3Array;
+
+typedef SPLVector3Array<SPLint32> SPLVector3Arrayi;		//!< Vector array with SPLint32 (32bit) resolution for each vector component!
+typedef SPLVector3Array<SPLieee32> SPLVector3Arrayf;	//!< Vector array with SPLieee32 (32bit) resolution for each vector component!
+typedef SPLVector3Array<SPLieee64> SPLVector3Arrayd;	//!< Vector array with SPLieee64 (64bit) resolution for each vector component!
+
+/*! \file vector3array.hh
+ * \brief Structure-of-arrays storage and batch operations for 3D vectors.
+ *
+ * \ref SPLVector3Array stores the x, y and z components of \f$ n \f$
+ * vectors in three separate lanes of one allocation. Each lane starts on a
+ * \ref SPL_SIMD_ALIGNMENT (64) byte boundary and is padded with zeros to a
+ * multiple of it, so the batch operations of \ref SPLVector3ArrayView load
+ * the lanes with aligned SIMD registers. \ref SPLVector3ArrayView itself
+ * only references three lanes and does not own them.
+ * */
+
+/*! \class SPLVector3ArrayView
+ * \brief A non-owning structure-of-arrays view onto \f$ n \f$ vectors.
+ *
+ * The components of the vectors are stored in three separate lanes,
+ * i.e. \f$ {\bf V}_i = ({\bf x}[i], {\bf y}[i], {\bf z}[i]) \f$, such
+ * that the batch operations process \c SPLSimd<T>::width vectors per
+ * instruction. The batch operations mirror the ones of \ref SPLVector3
+ * and write their result into this view, e.g.
+ * \code
+ * SPLVector3Arrayf a(n), b(n), c(n);
+ *
+ * c.add(a, b);		// c[i] = a[i] + b[i]
+ * c.normalize();	// c[i].normalize()
+ * \endcode
+ *
+ * A view is copied in constant time and never frees the lanes. The
+ * lanes of the destination may be the same as the ones of an operand
+ * (in-place operation) but must not overlap them partially.
+ *
+ * \sa SPLVector3Array SPLVector3
+ */
+template <class T>
+class SPLVector3ArrayView
+{
+public:
+	/*! \brief Constructor!
+	 *
+	 * Initializes an empty view.
+	 */
+	SPLVector3ArrayView(void) throw();
+
+	/*! \brief Constructor!
+	 *
+	 * Initializes a view onto existing lanes.
+	 *
+	 * \param x Lane of the 1st components.
+	 * \param y Lane of the 2nd components.
+	 * \param z Lane of the 3rd components.
+	 * \param n Number of vectors.
+	 */
+	SPLVector3ArrayView(T *x, T *y, T *z, const SPLsizei n) throw();
+
+	/*! \brief Returns the number of vectors!
+	 *
+	 * \return Number of vectors.
+	 */
+	CUDA_CALLABLE_MEMBER SPLsizei size(void) const throw() { return this->n; }
+
+	/*! \brief Returns a vector!
+	 *
+	 * \param i Index of the vector.
+	 *
+	 * \return New vector with the components of the \c i-th vector.
+	 */
+	CUDA_CALLABLE_MEMBER SPLVector3<T> get(const SPLindex i) const throw();
+
+	/*! \brief Sets a vector!
+	 *
+	 * \param i Index of the vector.
+	 * \param v The new value of the \c i-th vector.
+	 */
+	CUDA_CALLABLE_MEMBER void set(const SPLindex i, const SPLVector3<T> &v) throw();
+
+	/*! \brief Returns a view onto a range of vectors (zero-copy)!
+	 *
+	 * \param first Index of the first vector.
+	 * \param count Number of vectors.
+	 *
+	 * \return View onto the vectors \f$ [first, first + count) \f$.
+	 */
+	SPLVector3ArrayView<T> getView(const SPLindex first, const SPLsizei count) const throw();
+
+	/*! \brief Sets all vectors to the same value!
+	 *
+	 * \param v The value.
+	 */
+	void fill(const SPLVector3<T> &v) throw();
+
+	/*! \brief Converts an array of structures into this view!
+	 *
+	 * \param v Array of \ref size() vectors.
+	 */
+	void fromAoS(const SPLVector3<T> *v) throw();
+
+	/*! \brief Converts this view into an array of structures!
+	 *
+	 * \param v Array of \ref size() vectors.
+	 */
+	void toAoS(SPLVector3<T> *v) const throw();
+
+	/*! \brief Batch addition!
+	 *
+	 * \f[ {\bf V}_i = {\bf a}_i + {\bf b}_i \f]
+	 *
+	 * \param a 1st operand.
+	 * \param b 2nd operand.
+	 */
+	void add(const SPLVector3ArrayView<T> &a, const SPLVector3ArrayView<T> &b) throw();
+
+	/*! \brief Batch subtraction!
+	 *
+	 * \f[ {\bf V}_i = {\bf a}_i - {\bf b}_i \f]
+	 *
+	 * \param a 1st operand.
+	 * \param b 2nd operand.
+	 */
+	void sub(const SPLVector3ArrayView<T> &a, const SPLVector3ArrayView<T> &b) throw();
+
+	/*! \brief Batch multiplication with a scalar value!
+	 *
+	 * \f[ {\bf V}_i = s * {\bf a}_i \f]
+	 *
+	 * \param a The vectors.
+	 * \param s A scalar value.
+	 */
+	void scale(const SPLVector3ArrayView<T> &a, const T s) throw();
+
+	/*! \brief Batch cross product!
+	 *
+	 * \f[ {\bf V}_i = {\bf a}_i \times {\bf b}_i \f]
+	 *
+	 * \param a 1st operand.
+	 * \param b 2nd operand.
+	 *
+	 * \sa SPLVector3::crossProduct
+	 */
+	void crossProduct(const SPLVector3ArrayView<T> &a, const SPLVector3ArrayView<T> &b) throw();
+
+	/*! \brief Batch scalar product!
+	 *
+	 * \f[ s_i = {\bf V}_i * {\bf v}_i \f]
+	 *
+	 * \param v The other vectors.
+	 * \param s Array of \ref size() scalar values.
+	 */
+	void dotProduct(const SPLVector3ArrayView<T> &v, T *s) const throw();
+
+	/*! \brief Batch length!
+	 *
+	 * \f[ s_i = {\| {\bf V}_i \|} \f]
+	 *
+	 * In contrast to \ref SPLVector3::length the length is computed
+	 * with the precision of \c T, see \ref SPLPrecisionDouble.
+	 *
+	 * \param s Array of \ref size() scalar values.
+	 */
+	void length(T *s) const throw();
+
+	/*! \brief Batch length with a precision policy!
+	 *
+	 * Example
+	 * \code
+	 * SPLVector3Arrayf V(n);
+	 * std::vector<SPLieee32> s(n);
+	 *
+	 * V.length<SPLPrecisionFast>(&s[0]);
+	 * \endcode
+	 *
+	 * \param s Array of \ref size() scalar values.
+	 *
+	 * \sa precision.hh
+	 */
+	template <class P>
+	void length(T *s) const throw();
+
+	/*! \brief Batch normalization (inplace)!
+	 *
+	 * \f[ {\bf V}_i = l * {\bf V}_i / {\| {\bf V}_i \|} \f]
+	 *
+	 * Vectors of zero length are not changed, see \ref SPLVector3::normalize.
+	 *
+	 * \param l The length of the resulting vectors.
+	 */
+	void normalize(const T l = T(1)) throw();
+
+	/*! \brief Batch normalization (inplace) with a precision policy!
+	 *
+	 * \param l The length of the resulting vectors.
+	 *
+	 * \sa precision.hh
+	 */
+	template <class P>
+	void normalize(const T l = T(1)) throw();
+
+	/*! \brief Batch floor to integer values!
+	 *
+	 * \param v Destination with \ref size() vectors of type \ref SPLint32.
+	 *
+	 * \sa SPLVector3::getFLOORint
+	 */
+	void getFLOORint(SPLVector3ArrayView<SPLint32> &v) const throw();
+
+	/*! \brief Evaluates a vector expression for all vectors!
+	 *
+	 * The whole expression is fused into one SIMD pass over the lanes,
+	 * i.e. no temporary arrays are created, see \ref vector3expr.hh.
+	 *
+	 * Example
+	 * \code
+	 * SPLVector3Arrayf a(n), b(n), c(n), r(n);
+	 *
+	 * r.assign(splExpr(a) + splExpr(b) * 2.0f - splExpr(c));
+	 * \endcode
+	 *
+	 * \param e A vector expression of \ref size() elements.
+	 */
+	template <class E>
+	void assign(const SPLVector3Expr<E> &e) throw();
+
+	T *x;	//!< Lane of the 1st components.
+	T *y;	//!< Lane of the 2nd components.
+	T *z;	//!< Lane of the 3rd components.
+
+protected:
+	SPLsizei n;	//!< Number of vectors.
+};
+
+/*! \class SPLVector3Array
+ * \brief A structure-of-arrays container for \f$ n \f$ vectors.
+ *
+ * The three lanes are stored in one block of memory where each lane
+ * is aligned to \ref SPL_SIMD_ALIGNMENT bytes and padded with zeros
+ * to a multiple of it. All batch operations of \ref SPLVector3ArrayView
+ * are available, and existing \ref SPLVector3 buffers can be converted
+ * with \ref fromAoS and \ref toAoS.
+ *
+ * Example
+ * \code
+ * std::vector<SPLVector3f> points(n);
+ * SPLVector3Arrayf soa(&points[0], n);
+ *
+ * soa.normalize();
+ * soa.toAoS(&points[0]);
+ * \endcode
+ *
+ * \sa SPLVector3ArrayView SPLVector3
+ */
+template <class T>
+class SPLVector3Array : public SPLVector3ArrayView<T>
+{
+public:
+	/*! \brief Constructor!
+	 *
+	 * Allocates \c n zero vectors.
+	 *
+	 * \param n Number of vectors.
+	 */
+	explicit SPLVector3Array(const SPLsizei n = 0) throw();
+
+	/*! \brief Constructor!
+	 *
+	 * Allocates \c n vectors and converts them from an array of structures.
+	 *
+	 * \param v Array of \c n vectors.
+	 * \param n Number of vectors.
+	 */
+	SPLVector3Array(const SPLVector3<T> *v, const SPLsizei n) throw();
+
+	/*! \brief Constructor!
+	 *
+	 * Deep copy of the vectors of a view.
+	 *
+	 * \param v Another view.
+	 */
+	SPLVector3Array(const SPLVector3ArrayView<T> &v) throw();
+
+	/*! \brief Constructor!
+	 *
+	 * Deep copy of another array.
+	 *
+	 * \param v Another array.
+	 */
+	SPLVector3Array(const SPLVector3Array<T> &v) throw();
+
+	/*! \brief Destructor!
+	 *
+	 * Frees all previously alloced space.
+	 */
+	~SPLVector3Array(void) throw();
+
+	/*! \brief Assigment operator!
+	 *
+	 * \param v Another array.
+	 *
+	 * \return Reference of this array.
+	 */
+	SPLVector3Array<T>& operator = (const SPLVector3Array<T> &v) throw();
+
+	/*! \brief Changes the number of vectors!
+	 *
+	 * The first \f$ \min(n, size()) \f$ vectors are kept and new vectors
+	 * are zero. Views onto this array become invalid.
+	 *
+	 * \param n New number of vectors.
+	 *
+	 * \return \c true on success and \c false otherwise.
+	 */
+	bool resize(const SPLsizei n) throw();
+
+	/*! \brief Returns the padded number of vectors per lane!
+	 *
+	 * \return Capacity of each lane.
+	 */
+	SPLsizei capacity(void) const throw() { return this->cap; }
+
+private:
+	SPLsizei cap;	//!< Padded number of vectors per lane.
+	T *data;		//!< Memory of all three lanes.
+};
+
+/************************************************************************************************
+ ** Non member functions for SPLVector3ArrayView
+ ************************************************************************************************/
+/*! \fn SPLVector3ExprLanes<T> splExpr(const SPLVector3ArrayView<T> &v)
+ * \brief Starts a lazy vector expression over all vectors of a view!
+ *
+ * \param v A view.
+ *
+ * \return Leaf expression referencing the lanes of \c v.
+ */
+template <class T>
+inline SPLVector3ExprLanes<T> splExpr(const SPLVector3ArrayView<T> &v) throw()
+{
+	return SPLVector3ExprLanes<T>(v.x, v.y, v.z);
+}
+
+/************************************************************************************************
+ ** SPLVector3ArrayView class implementation
+ ************************************************************************************************/
+template <class T>
+SPLVector3ArrayView<T>::SPLVector3ArrayView(void) throw()
+{
+	this->x = 0;
+	this->y = 0;
+	this->z = 0;
+	this->n = 0;
+}
+
+template <class T>
+SPLVector3ArrayView<T>::SPLVector3ArrayView(T *x, T *y, T *z, const SPLsizei n) throw()
+{
+	assert(n >= 0);
+	this->x = x;
+	this->y = y;
+	this->z = z;
+	this->n = n;
+}
+
+template <class T>
+SPLVector3<T> SPLVector3ArrayView<T>::get(const SPLindex i) const throw()
+{
+	assert(i >= 0 && i < this->n);
+	return SPLVector3<T>(this->x[i], this->y[i], this->z[i]);
+}
+
+template <class T>
+void SPLVector3ArrayView<T>::set(const SPLindex i, const SPLVector3<T> &v) throw()
+{
+	assert(i >= 0 && i < this->n);
+	this->x[i] = v.x;
+	this->y[i] = v.y;
+	this->z[i] = v.z;
+}
+
+template <class T>
+SPLVector3ArrayView<T> SPLVector3ArrayView<T>::getView(const SPLindex first, const SPLsizei count) const throw()
+{
+	assert(first >= 0 && count >= 0 && first + count <= this->n);
+	return SPLVector3ArrayView<T>(this->x + first, this->y + first, this->z + first, count);
+}
+
+template <class T>
+void SPLVector3ArrayView<T>::fill(const SPLVector3<T> &v) throw()
+{
+	T *dx = this->x, *dy = this->y, *dz = this->z;
+	splSimdForEach<T>(this->n, [&](auto simd, const SPLindex i)
+	{
+		typedef decltype(simd) S;
+		S::store(dx + i, S::set(v.x));
+		S::store(dy + i, S::set(v.y));
+		S::store(dz + i, S::set(v.z));
+	});
+}
+
+template <class T>
+void SPLVector3ArrayView<T>::fromAoS(const SPLVector3<T> *v) throw()
+{
+	static_assert(sizeof(SPLVector3<T>) == 3 * sizeof(T), "SPLVector3 must not be padded");
+	const T *p = &v[0].x;
+	for (SPLindex i = 0; i < this->n; i++)
+	{
+		this->x[i] = p[3 * i + 0];
+		this->y[i] = p[3 * i + 1];
+		this->z[i] = p[3 * i + 2];
+	}
+}
+
+template <class T>
+void SPLVector3ArrayView<T>::toAoS(SPLVector3<T> *v) const throw()
+{
+	static_assert(sizeof(SPLVector3<T>) == 3 * sizeof(T), "SPLVector3 must not be padded");
+	T *p = &v[0].x;
+	for (SPLindex i = 0; i < this->n; i++)
+	{
+		p[3 * i + 0] = this->x[i];
+		p[3 * i + 1] = this->y[i];
+		p[3 * i + 2] = this->z[i];
+	}
+}
+
+template <class T>
+void SPLVector3ArrayView<T>::add(const SPLVector3ArrayView<T> &a, const SPLVector3ArrayView<T> &b) throw()
+{
+	assert(a.size() == this->n && b.size() == this->n);
+	T *dx = this->x, *dy = this->y, *dz = this->z;
+	splSimdForEach<T>(this->n, [&](auto simd, const SPLindex i)
+	{
+		typedef decltype(simd) S;
+		S::store(dx + i, S::add(S::load(a.x + i), S::load(b.x + i)));
+		S::store(dy + i, S::add(S::load(a.y + i), S::load(b.y + i)));
+		S::store(dz + i, S::add(S::load(a.z + i), S::load(b.z + i)));
+	});
+}
+
+template <class T>
+void SPLVector3ArrayView<T>::sub(const SPLVector3ArrayView<T> &a, const SPLVector3ArrayView<T> &b) throw()
+{
+	assert(a.size() == this->n && b.size() == this->n);
+	T *dx = this->x, *dy = this->y, *dz = this->z;
+	splSimdForEach<T>(this->n, [&](auto simd, const SPLindex i)
+	{
+		typedef decltype(simd) S;
+		S::store(dx + i, S::sub(S::load(a.x + i), S::load(b.x + i)));
+		S::store(dy + i, S::sub(S::load(a.y + i), S::load(b.y + i)));
+		S::store(dz + i, S::sub(S::load(a.z + i), S::load(b.z + i)));
+	});
+}
+
+template <class T>
+void SPLVector3ArrayView<T>::scale(const SPLVector3ArrayView<T> &a, const T s) throw()
+{
+	assert(a.size() == this->n);
+	T *dx = this->x, *dy = this->y, *dz = this->z;
+	splSimdForEach<T>(this->n, [&](auto simd, const SPLindex i)
+	{
+		typedef decltype(simd) S;
+		const typename S::Type f = S::set(s);
+		S::store(dx + i, S::mul(S::load(a.x + i), f));
+		S::store(dy + i, S::mul(S::load(a.y + i), f));
+		S::store(dz + i, S::mul(S::load(a.z + i), f));
+	});
+}
+
+template <class T>
+void SPLVector3ArrayView<T>::crossProduct(const SPLVector3ArrayView<T> &a, const SPLVector3ArrayView<T> &b) throw()
+{
+	assert(a.size() == this->n && b.size() == this->n);
+	T *dx = this->x, *dy = this->y, *dz = this->z;
+	splSimdForEach<T>(this->n, [&](auto simd, const SPLindex i)
+	{
+		typedef decltype(simd) S;
+		const typename S::Type ax = S::load(a.x + i), ay = S::load(a.y + i), az = S::load(a.z + i);
+		const typename S::Type bx = S::load(b.x + i), by = S::load(b.y + i), bz = S::load(b.z + i);
+		S::store(dx + i, S::sub(S::mul(ay, bz), S::mul(az, by)));
+		S::store(dy + i, S::sub(S::mul(az, bx), S::mul(ax, bz)));
+		S::store(dz + i, S::sub(S::mul(ax, by), S::mul(ay, bx)));
+	});
+}
+
+template <class T>
+void SPLVector3ArrayView<T>::dotProduct(const SPLVector3ArrayView<T> &v, T *s) const throw()
+{
+	assert(v.size() == this->n);
+	const SPLVector3ArrayView<T> &a = *this;
+	splSimdForEach<T>(this->n, [&](auto simd, const SPLindex i)
+	{
+		typedef decltype(simd) S;
+		const typename S::Type xx = S::mul(S::load(a.x + i), S::load(v.x + i));
+		const typename S::Type yy = S::mul(S::load(a.y + i), S::load(v.y + i));
+		const typename S::Type zz = S::mul(S::load(a.z + i), S::load(v.z + i));
+		S::store(s + i, S::add(S::add(xx, yy), zz));
+	});
+}
+
+template <class T>
+void SPLVector3ArrayView<T>::length(T *s) const throw()
+{
+	this->template length<typename SPLPrecisionDefault<T>::Type>(s);
+}
+
+template <class T>
+template <class P>
+void SPLVector3ArrayView<T>::length(T *s) const throw()
+{
+	static_assert(!std::numeric_limits<T>::is_integer, "SPLVector3ArrayView::length() requires a floating point type");
+	const SPLVector3ArrayView<T> &a = *this;
+	splSimdForEach<T>(this->n, [&](auto simd, const SPLindex i)
+	{
+		typedef decltype(simd) S;
+		const typename S::Type vx = S::load(a.x + i), vy = S::load(a.y + i), vz = S::load(a.z + i);
+		const typename S::Type sq = S::add(S::add(S::mul(vx, vx), S::mul(vy, vy)), S::mul(vz, vz));
+		S::store(s + i, P::template lengthSimd<S>(sq));
+	});
+}
+
+template <class T>
+void SPLVector3ArrayView<T>::normalize(const T l) throw()
+{
+	this->template normalize<typename SPLPrecisionDefault<T>::Type>(l);
+}
+
+template <class T>
+template <class P>
+void SPLVector3ArrayView<T>::normalize(const T l) throw()
+{
+	static_assert(!std::numeric_limits<T>::is_integer, "SPLVector3ArrayView::normalize() requires a floating point type");
+	assert(l > T(0));
+	T *dx = this->x, *dy = this->y, *dz = this->z;
+	splSimdForEach<T>(this->n, [&](auto simd, const SPLindex i)
+	{
+		typedef decltype(simd) S;
+		const typename S::Type vx = S::load(dx + i), vy = S::load(dy + i), vz = S::load(dz + i);
+		const typename S::Type sq = S::add(S::add(S::mul(vx, vx), S::mul(vy, vy)), S::mul(vz, vz));
+		// zero vectors keep their value, i.e. are scaled by one
+		const typename S::Type f = S::selectZero(sq, S::set(T(1)), S::mul(S::set(l), P::template rsqrtSimd<S>(sq)));
+		S::store(dx + i, S::mul(vx, f));
+		S::store(dy + i, S::mul(vy, f));
+		S::store(dz + i, S::mul(vz, f));
+	});
+}
+
+template <class T>
+void SPLVector3ArrayView<T>::getFLOORint(SPLVector3ArrayView<SPLint32> &v) const throw()
+{
+	assert(v.size() == this->n);
+	const SPLVector3ArrayView<T> &a = *this;
+	splSimdForEach<T>(this->n, [&](auto simd, const SPLindex i)
+	{
+		typedef decltype(simd) S;
+		S::storeInt(v.x + i, S::floor(S::load(a.x + i)));
+		S::storeInt(v.y + i, S::floor(S::load(a.y + i)));
+		S::storeInt(v.z + i, S::floor(S::load(a.z + i)));
+	});
+}
+
+template <class T>
+template <class E>
+void SPLVector3ArrayView<T>::assign(const SPLVector3Expr<E> &e) throw()
+{
+	const E &expr = e.self();
+	T *dx = this->x, *dy = this->y, *dz = this->z;
+	splSimdForEach<T>(this->n, [&](auto simd, const SPLindex i)
+	{
+		typedef decltype(simd) S;
+		// evaluate all components first, the expression may reference this view
+		const typename S::Type vx = expr.template load<S, 0>(i);
+		const typename S::Type vy = expr.template load<S, 1>(i);
+		const typename S::Type vz = expr.template load<S, 2>(i);
+		S::store(dx + i, vx);
+		S::store(dy + i, vy);
+		S::store(dz + i, vz);
+	});
+}
+
+/************************************************************************************************
+ ** SPLVector3Array class implementation
+ ************************************************************************************************/
+template <class T>
+SPLVector3Array<T>::SPLVector3Array(const SPLsizei n) throw()
+{
+	this->cap = 0;
+	this->data = 0;
+	this->resize(n);
+}
+
+template <class T>
+SPLVector3Array<T>::SPLVector3Array(const SPLVector3<T> *v, const SPLsizei n) throw()
+{
+	this->cap = 0;
+	this->data = 0;
+	if (this->resize(n))
+	{
+		this->fromAoS(v);
+	}
+}
+
+template <class T>
+SPLVector3Array<T>::SPLVector3Array(const SPLVector3ArrayView<T> &v) throw()
+{
+	this->cap = 0;
+	this->data = 0;
+	if (this->resize(v.size()) && this->n > 0)
+	{
+		memcpy(this->x, v.x, size_t(this->n) * sizeof(T));
+		memcpy(this->y, v.y, size_t(this->n) * sizeof(T));
+		memcpy(this->z, v.z, size_t(this->n) * sizeof(T));
+	}
+}
+
+template <class T>
+SPLVector3Array<T>::SPLVector3Array(const SPLVector3Array<T> &v) throw()
+	: SPLVector3ArrayView<T>()
+{
+	this->cap = 0;
+	this->data = 0;
+	this->operator = (v);
+}
+
+template <class T>
+SPLVector3Array<T>::~SPLVector3Array(void) throw()
+{
+	splMemoryFree(this->data);
+}
+
+template <class T>
+SPLVector3Array<T>& SPLVector3Array<T>::operator = (const SPLVector3Array<T> &v) throw()
+{
+	if (this != &v && this->resize(v.size()) && this->n > 0)
+	{
+		memcpy(this->x, v.x, size_t(this->n) * sizeof(T));
+		memcpy(this->y, v.y, size_t(this->n) * sizeof(T));
+		memcpy(this->z, v.z, size_t(this->n) * sizeof(T));
+	}
+	return (*this);
+}
+
+template <class T>
+bool SPLVector3Array<T>::resize(const SPLsizei n) throw()
+{
+	assert(n >= 0);
+	const SPLsizei lane = SPL_SIMD_ALIGNMENT / SPLsizei(sizeof(T));
+	const SPLsizei cap = ((n + lane - 1) / lane) * lane;
+	if (cap == this->cap)
+	{
+		// shrinking within the padding clears the dropped vectors
+		for (SPLindex i = n; i < this->n; i++)
+		{
+			this->x[i] = this->y[i] = this->z[i] = T(0);
+		}
+		this->n = n;
+		return true;
+	}
+	T *data = 0;
+	if (cap > 0)
+	{
+		data = (T *)splMemoryAlloc(3 * SPLint64(cap) * SPLint64(sizeof(T)));
+		if (data == 0)
+		{
+			return false;
+		}
+		memset((void *)data, 0, 3 * size_t(cap) * sizeof(T));
+		const SPLsizei keep = MIN(n, this->n);
+		if (keep > 0)
+		{
+			memcpy(data + 0 * cap, this->x, size_t(keep) * sizeof(T));
+			memcpy(data + 1 * cap, this->y, size_t(keep) * sizeof(T));
+			memcpy(data + 2 * cap, this->z, size_t(keep) * sizeof(T));
+		}
+	}
+	splMemoryFree(this->data);
+	this->data = data;
+	this->cap = cap;
+	this->n = n;
+	this->x = data ? data + 0 * cap : 0;
+	this->y = data ? data + 1 * cap : 0;
+	this->z = data ? data + 2 * cap : 0;
+	return true;
+}
+
+#endif /*_spl_vector3array_hh_*/
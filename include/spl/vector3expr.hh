@@ -0,0 +1,352 @@
+#ifndef _spl_vector3expr_hh_
+#define _spl_vector3expr_hh_
+
+#include <spl/typesbase.hh>
+#include <spl/simd.hh>
+#include <spl/vector3.hh>
+
+/*! \file vector3expr.hh
+ * \brief Expression templates for \ref SPLVector3 arithmetic.
+ *
+ * An expression such as
+ * \code
+ * SPLVector3f a, b, c, n;
+ * SPLieee32 s;
+ *
+ * n = splExpr(a) + b * s - c;
+ * \endcode
+ * builds a tree of \ref SPLVector3Expr nodes which is evaluated lazily,
+ * component by component, when it is assigned. No intermediate vectors
+ * are created. The same expressions work on structure-of-arrays data,
+ * see \ref SPLVector3ArrayView::assign, where the whole expression is
+ * fused into one SIMD pass over the lanes.
+ *
+ * The nodes reference their operands, i.e. an expression must be
+ * evaluated before its operands go out of scope.
+ * */
+
+/*! \class SPLVector3Expr
+ * \brief Base class of all vector expressions.
+ *
+ * Each expression \c E provides the type \c ValueType and the methods
+ * \code
+ * template <int C> CUDA_CALLABLE_MEMBER ValueType get(const SPLindex i) const;
+ * template <class S, int C> typename S::Type load(const SPLindex i) const;
+ * \endcode
+ * which return the component \c C of the \c i-th element, either as a
+ * scalar or as a SIMD register of \c S::width elements (see \ref SPLSimd).
+ * Single vectors ignore the index \c i.
+ */
+template <class E>
+class SPLVector3Expr
+{
+public:
+	/*! \brief Returns the expression itself!
+	 *
+	 * \return Reference of the derived expression.
+	 */
+	CUDA_CALLABLE_MEMBER const E& self(void) const throw() { return static_cast<const E&>(*this); }
+};
+
+/*! \class SPLVector3ExprVector
+ * \brief Leaf expression referencing a single vector.
+ */
+template <class T>
+class SPLVector3ExprVector : public SPLVector3Expr<SPLVector3ExprVector<T> >
+{
+public:
+	typedef T ValueType;	//!< Type of the vector components.
+
+	CUDA_CALLABLE_MEMBER explicit SPLVector3ExprVector(const SPLVector3<T> &v) throw() : v(v) {}
+
+	template <int C>
+	CUDA_CALLABLE_MEMBER T get(const SPLindex) const throw() { return (&v.x)[C]; }
+
+	template <class S, int C>
+	typename S::Type load(const SPLindex) const throw() { return S::set((&v.x)[C]); }
+
+private:
+	const SPLVector3<T> &v;	//!< The referenced vector.
+};
+
+/*! \class SPLVector3ExprLanes
+ * \brief Leaf expression referencing three lanes of vector components.
+ *
+ * \sa SPLVector3ArrayView
+ */
+template <class T>
+class SPLVector3ExprLanes : public SPLVector3Expr<SPLVector3ExprLanes<T> >
+{
+public:
+	typedef T ValueType;	//!< Type of the vector components.
+
+	CUDA_CALLABLE_MEMBER SPLVector3ExprLanes(const T *x, const T *y, const T *z) throw()
+	{
+		this->lane[0] = x;
+		this->lane[1] = y;
+		this->lane[2] = z;
+	}
+
+	template <int C>
+	CUDA_CALLABLE_MEMBER T get(const SPLindex i) const throw() { return this->lane[C][i]; }
+
+	template <class S, int C>
+	typename S::Type load(const SPLindex i) const throw() { return S::load(this->lane[C] + i); }
+
+private:
+	const T *lane[3];	//!< The referenced lanes.
+};
+
+/*! \class SPLVector3ExprBinary
+ * \brief Element-wise operation of two vector expressions.
+ *
+ * \c Op provides the static methods \c get (scalar) and \c load (SIMD).
+ */
+template <class A, class B, class Op>
+class SPLVector3ExprBinary : public SPLVector3Expr<SPLVector3ExprBinary<A, B, Op> >
+{
+public:
+	typedef typename A::ValueType ValueType;	//!< Type of the vector components.
+
+	CUDA_CALLABLE_MEMBER SPLVector3ExprBinary(const A &a, const B &b) throw() : a(a), b(b) {}
+
+	template <int C>
+	CUDA_CALLABLE_MEMBER ValueType get(const SPLindex i) const throw()
+	{
+		return Op::get(this->a.template get<C>(i), this->b.template get<C>(i));
+	}
+
+	template <class S, int C>
+	typename S::Type load(const SPLindex i) const throw()
+	{
+		return Op::template load<S>(this->a.template load<S, C>(i), this->b.template load<S, C>(i));
+	}
+
+private:
+	const A a;	//!< 1st operand.
+	const B b;	//!< 2nd operand.
+};
+
+/*! \class SPLVector3ExprScalar
+ * \brief Element-wise operation of a vector expression and a scalar value.
+ */
+template <class A, class Op>
+class SPLVector3ExprScalar : public SPLVector3Expr<SPLVector3ExprScalar<A, Op> >
+{
+public:
+	typedef typename A::ValueType ValueType;	//!< Type of the vector components.
+
+	CUDA_CALLABLE_MEMBER SPLVector3ExprScalar(const A &a, const ValueType s) throw() : a(a), s(s) {}
+
+	template <int C>
+	CUDA_CALLABLE_MEMBER ValueType get(const SPLindex i) const throw()
+	{
+		return Op::get(this->a.template get<C>(i), this->s);
+	}
+
+	template <class S, int C>
+	typename S::Type load(const SPLindex i) const throw()
+	{
+		return Op::template load<S>(this->a.template load<S, C>(i), S::set(this->s));
+	}
+
+private:
+	const A a;				//!< Vector operand.
+	const ValueType s;		//!< Scalar operand.
+};
+
+/*! \class SPLVector3ExprCross
+ * \brief Cross product of two vector expressions.
+ *
+ * \sa SPLVector3::crossProduct
+ */
+template <class A, class B>
+class SPLVector3ExprCross : public SPLVector3Expr<SPLVector3ExprCross<A, B> >
+{
+public:
+	typedef typename A::ValueType ValueType;	//!< Type of the vector components.
+
+	CUDA_CALLABLE_MEMBER SPLVector3ExprCross(const A &a, const B &b) throw() : a(a), b(b) {}
+
+	template <int C>
+	CUDA_CALLABLE_MEMBER ValueType get(const SPLindex i) const throw()
+	{
+		return this->a.template get<(C + 1) % 3>(i) * this->b.template get<(C + 2) % 3>(i)
+			 - this->a.template get<(C + 2) % 3>(i) * this->b.template get<(C + 1) % 3>(i);
+	}
+
+	template <class S, int C>
+	typename S::Type load(const SPLindex i) const throw()
+	{
+		return S::sub(S::mul(this->a.template load<S, (C + 1) % 3>(i), this->b.template load<S, (C + 2) % 3>(i)),
+					  S::mul(this->a.template load<S, (C + 2) % 3>(i), this->b.template load<S, (C + 1) % 3>(i)));
+	}
+
+private:
+	const A a;	//!< 1st operand.
+	const B b;	//!< 2nd operand.
+};
+
+/*! \brief Element-wise operations used by the expression nodes.
+ */
+struct SPLVector3OpAdd
+{
+	template <class T> CUDA_CALLABLE_MEMBER static T get(const T a, const T b) throw() { return a + b; }
+	template <class S> static typename S::Type load(const typename S::Type a, const typename S::Type b) throw() { return S::add(a, b); }
+};
+
+struct SPLVector3OpSub
+{
+	template <class T> CUDA_CALLABLE_MEMBER static T get(const T a, const T b) throw() { return a - b; }
+	template <class S> static typename S::Type load(const typename S::Type a, const typename S::Type b) throw() { return S::sub(a, b); }
+};
+
+struct SPLVector3OpMul
+{
+	template <class T> CUDA_CALLABLE_MEMBER static T get(const T a, const T b) throw() { return a * b; }
+	template <class S> static typename S::Type load(const typename S::Type a, const typename S::Type b) throw() { return S::mul(a, b); }
+};
+
+struct SPLVector3OpDiv
+{
+	template <class T> CUDA_CALLABLE_MEMBER static T get(const T a, const T b) throw() { return a / b; }
+	template <class S> static typename S::Type load(const typename S::Type a, const typename S::Type b) throw() { return S::div(a, b); }
+};
+
+/************************************************************************************************
+ ** Non member functions for SPLVector3Expr
+ ************************************************************************************************/
+/*! \fn SPLVector3ExprVector<T> splExpr(const SPLVector3<T> &v)
+ * \brief Starts a lazy vector expression!
+ *
+ * \param v A vector.
+ *
+ * \return Leaf expression referencing \c v.
+ */
+template <class T>
+CUDA_CALLABLE_MEMBER inline SPLVector3ExprVector<T> splExpr(const SPLVector3<T> &v) throw()
+{
+	return SPLVector3ExprVector<T>(v);
+}
+
+/*! \brief Addition of two expressions! */
+template <class A, class B>
+CUDA_CALLABLE_MEMBER inline SPLVector3ExprBinary<A, B, SPLVector3OpAdd>
+operator + (const SPLVector3Expr<A> &a, const SPLVector3Expr<B> &b) throw()
+{
+	return SPLVector3ExprBinary<A, B, SPLVector3OpAdd>(a.self(), b.self());
+}
+
+/*! \brief Addition of an expression and a vector! */
+template <class A, class T>
+CUDA_CALLABLE_MEMBER inline SPLVector3ExprBinary<A, SPLVector3ExprVector<T>, SPLVector3OpAdd>
+operator + (const SPLVector3Expr<A> &a, const SPLVector3<T> &b) throw()
+{
+	return SPLVector3ExprBinary<A, SPLVector3ExprVector<T>, SPLVector3OpAdd>(a.self(), SPLVector3ExprVector<T>(b));
+}
+
+/*! \brief Addition of a vector and an expression! */
+template <class T, class B>
+CUDA_CALLABLE_MEMBER inline SPLVector3ExprBinary<SPLVector3ExprVector<T>, B, SPLVector3OpAdd>
+operator + (const SPLVector3<T> &a, const SPLVector3Expr<B> &b) throw()
+{
+	return SPLVector3ExprBinary<SPLVector3ExprVector<T>, B, SPLVector3OpAdd>(SPLVector3ExprVector<T>(a), b.self());
+}
+
+/*! \brief Subtraction of two expressions! */
+template <class A, class B>
+CUDA_CALLABLE_MEMBER inline SPLVector3ExprBinary<A, B, SPLVector3OpSub>
+operator - (const SPLVector3Expr<A> &a, const SPLVector3Expr<B> &b) throw()
+{
+	return SPLVector3ExprBinary<A, B, SPLVector3OpSub>(a.self(), b.self());
+}
+
+/*! \brief Subtraction of a vector from an expression! */
+template <class A, class T>
+CUDA_CALLABLE_MEMBER inline SPLVector3ExprBinary<A, SPLVector3ExprVector<T>, SPLVector3OpSub>
+operator - (const SPLVector3Expr<A> &a, const SPLVector3<T> &b) throw()
+{
+	return SPLVector3ExprBinary<A, SPLVector3ExprVector<T>, SPLVector3OpSub>(a.self(), SPLVector3ExprVector<T>(b));
+}
+
+/*! \brief Subtraction of an expression from a vector! */
+template <class T, class B>
+CUDA_CALLABLE_MEMBER inline SPLVector3ExprBinary<SPLVector3ExprVector<T>, B, SPLVector3OpSub>
+operator - (const SPLVector3<T> &a, const SPLVector3Expr<B> &b) throw()
+{
+	return SPLVector3ExprBinary<SPLVector3ExprVector<T>, B, SPLVector3OpSub>(SPLVector3ExprVector<T>(a), b.self());
+}
+
+/*! \brief Unary minus of an expression! */
+template <class A>
+CUDA_CALLABLE_MEMBER inline SPLVector3ExprScalar<A, SPLVector3OpMul>
+operator - (const SPLVector3Expr<A> &a) throw()
+{
+	return SPLVector3ExprScalar<A, SPLVector3OpMul>(a.self(), typename A::ValueType(-1));
+}
+
+/*! \brief Multiplication of an expression with a scalar value! */
+template <class A>
+CUDA_CALLABLE_MEMBER inline SPLVector3ExprScalar<A, SPLVector3OpMul>
+operator * (const SPLVector3Expr<A> &a, const typename A::ValueType s) throw()
+{
+	return SPLVector3ExprScalar<A, SPLVector3OpMul>(a.self(), s);
+}
+
+/*! \brief Multiplication of a scalar value with an expression! */
+template <class A>
+CUDA_CALLABLE_MEMBER inline SPLVector3ExprScalar<A, SPLVector3OpMul>
+operator * (const typename A::ValueType s, const SPLVector3Expr<A> &a) throw()
+{
+	return SPLVector3ExprScalar<A, SPLVector3OpMul>(a.self(), s);
+}
+
+/*! \brief Division of an expression by a scalar value! */
+template <class A>
+CUDA_CALLABLE_MEMBER inline SPLVector3ExprScalar<A, SPLVector3OpDiv>
+operator / (const SPLVector3Expr<A> &a, const typename A::ValueType s) throw()
+{
+	assert(s != typename A::ValueType(0));
+	return SPLVector3ExprScalar<A, SPLVector3OpDiv>(a.self(), s);
+}
+
+/*! \brief Cross product of two expressions!
+ *
+ * \sa SPLVector3::crossProduct
+ */
+template <class A, class B>
+CUDA_CALLABLE_MEMBER inline SPLVector3ExprCross<A, B>
+splCrossProduct(const SPLVector3Expr<A> &a, const SPLVector3Expr<B> &b) throw()
+{
+	return SPLVector3ExprCross<A, B>(a.self(), b.self());
+}
+
+/************************************************************************************************
+ ** Evaluation of SPLVector3Expr into SPLVector3
+ ************************************************************************************************/
+template <class T>
+template <class E>
+SPLVector3<T>::SPLVector3(const SPLVector3Expr<E> &e) throw()
+{
+	const E &expr = e.self();
+	this->x = expr.template get<0>(0);
+	this->y = expr.template get<1>(0);
+	this->z = expr.template get<2>(0);
+}
+
+template <class T>
+template <class E>
+SPLVector3<T>& SPLVector3<T>::operator = (const SPLVector3Expr<E> &e) throw()
+{
+	// evaluate all components first, the expression may reference this vector
+	const E &expr = e.self();
+	const T x = expr.template get<0>(0);
+	const T y = expr.template get<1>(0);
+	const T z = expr.template get<2>(0);
+	this->x = x;
+	this->y = y;
+	this->z = z;
+	return (*this);
+}
+
+#endif /*_spl_vector3expr_hh_*/
@@ -0,0 +1,576 @@
+#ifndef _spl_vector4_hh_
+#define _spl_vector4_hh_
+
+#ifdef __DEBUG__
+#include <cstdio>
+#endif
+
+#include <spl/typesbase.hh>
+#include <spl/mathbase.hh>
+#include <spl/cudadefs.hh>
+#include <spl/precision.hh>
+#include <spl/vector3.hh>
+#include <spl/simd4.hh>
+
+#include <type_traits>
+
+template <class T> class SPLVector4;
+
+typedef SPLVector4<SPLint32> SPLVector4i;	//!< Vector type with SPLint32 (32bit) resolution for each vector component!
+typedef SPLVector4<SPLieee32> SPLVector4f;	//!< Vector type with SPLieee32 (32bit) resolution for each vector component!
+typedef SPLVector4<SPLieee64> SPLVector4d;	//!< Vector type with SPLieee64 (64bit) resolution for each vector component!
+
+/*! \file vector4.hh
+ * */
+
+/*! \class SPLVector4
+ * \brief A \f$ 4 \f$ dimensional vector class.
+ *
+ * This class defines variables and implements methods for 4 dimensional
+ * vectors, i.e. for \f$ {\bf V} \in \mathbb{R}^{4} \f$, which are mainly
+ * used as homogeneous coordinates and as the columns of \ref SPLMatrix4.
+ * The elements are addressed as
+ * \f[
+ * {\bf V} =
+ * \left(
+ * \begin{array}{r}
+ * {\bf V}.{x} \\
+ * {\bf V}.{y} \\
+ * {\bf V}.{z} \\
+ * {\bf V}.{w}
+ * \end{array}
+ * \right) =
+ * \left(
+ * \begin{array}{r}
+ * {\bf V}[0] \\
+ * {\bf V}[1] \\
+ * {\bf V}[2] \\
+ * {\bf V}[3]
+ * \end{array}
+ * \right)
+ * \f]
+ *
+ * The vector is aligned to 16 bytes, such that an \ref SPLVector4f fills
+ * one SSE or NEON register and never straddles a cache line. Its
+ * arithmetic operators, the scalar product and the normalization are
+ * computed with \ref SPLSimd4f.
+ *
+ * \sa SPLVector3 SPLVector3a SPLMatrix4
+*/
+template <class T>
+class alignas(16) SPLVector4
+{
+public:
+	/*! \brief Constructor!
+	 *
+	 * Initializes all elements to \f$ 0 \f$.
+	 */
+	CUDA_CALLABLE_MEMBER SPLVector4(void) throw();
+
+	/*! \brief Constructor!
+	 *
+	 * Example
+	 * \code
+	 * SPLVector4f V(2.0f, -2.0f, 2.1f, 1.0f);
+	 *
+	 * \endcode
+	 *
+	 * \param x 1st vector element (i.e. \c v.x = \c x).
+	 * \param y 2nd vector element (i.e. \c v.y = \c y).
+	 * \param z 3rd vector element (i.e. \c v.z = \c z).
+	 * \param w 4th vector element (i.e. \c v.w = \c w).
+	 */
+	CUDA_CALLABLE_MEMBER SPLVector4(const T x, const T y, const T z, const T w) throw();
+
+	/*! \brief Constructor!
+	 *
+	 * Extends a 3 dimensional vector, e.g. a point with \c w = 1 or a
+	 * direction with \c w = 0.
+	 *
+	 * Example
+	 * \code
+	 * SPLVector3f v(2.0f, -2.0f, 2.1f);
+	 * SPLVector4f P(v, 1.0f);
+	 *
+	 * \endcode
+	 *
+	 * \param v A vector with type \c T.
+	 * \param w 4th vector element.
+	 */
+	CUDA_CALLABLE_MEMBER SPLVector4(const SPLVector3<T> &v, const T w = T(0)) throw();
+
+	/*! \brief Constructor!
+	 *
+	 * \param v Another vector with type \c T.
+	 */
+	CUDA_CALLABLE_MEMBER SPLVector4(const SPLVector4<T> &v) throw();
+
+	/*! \brief Destructor!
+	 */
+	CUDA_CALLABLE_MEMBER ~SPLVector4(void) throw() {};
+
+	/*! \brief Comparison operator!
+	 *
+	 * \param v Another vector.
+	 *
+	 * \return \c true if all elements are equal and \c false ontherwise.
+	 */
+	CUDA_CALLABLE_MEMBER bool operator == (const SPLVector4<T> &v) const throw();
+
+	/*! \brief Comparison operator!
+	 *
+	 * \param v Another vector.
+	 *
+	 * \return \c true if any element differs and \c false ontherwise.
+	 */
+	CUDA_CALLABLE_MEMBER bool operator != (const SPLVector4<T> &v) const throw();
+
+	/*! \brief Assigment operator!
+	 *
+	 * \param v Another vector.
+	 *
+	 * \return Reference of this vector.
+	 */
+	CUDA_CALLABLE_MEMBER SPLVector4<T>& operator = (const SPLVector4<T> &v) throw();
+
+	/*! \brief Access operator!
+	 *
+	 * \param i Index into the vector elements \f$ [0, 3] \f$.
+	 *
+	 * \return Reference of an element.
+	 */
+	CUDA_CALLABLE_MEMBER T& operator [] (const SPLindex i) throw();
+
+	/*! \brief Access operator!
+	 *
+	 * \param i Index into the vector elements \f$ [0, 3] \f$.
+	 *
+	 * \return Reference of an element.
+	 */
+	CUDA_CALLABLE_MEMBER const T& operator [] (const SPLindex i) const throw();
+
+	/*! \brief Unary minus!
+	 *
+	 * \return New vector \f$ -{\bf V} \f$.
+	 */
+	CUDA_CALLABLE_MEMBER SPLVector4<T> operator - (void) const throw();
+
+	/*! \brief Multiplication operator!
+	 *
+	 * Returns the scalar product of all 4 elements, i.e.
+	 * \f[ s = {\bf V} * {\bf v} \f]
+	 *
+	 * \param v Another vector.
+	 *
+	 * \return Scalar value (vector product).
+	 */
+	CUDA_CALLABLE_MEMBER T operator * (const SPLVector4<T> &v) const throw();
+
+	/*! \brief Addition operator!
+	 *
+	 * \param v Another vector.
+	 *
+	 * \return Reference of this vector.
+	 */
+	CUDA_CALLABLE_MEMBER SPLVector4<T>& operator += (const SPLVector4<T> &v) throw();
+
+	/*! \brief Subtraction operator!
+	 *
+	 * \param v Another vector.
+	 *
+	 * \return Reference of this vector.
+	 */
+	CUDA_CALLABLE_MEMBER SPLVector4<T>& operator -= (const SPLVector4<T> &v) throw();
+
+	/*! \brief Multiplication operator!
+	 *
+	 * \param s A scalar value.
+	 *
+	 * \return Reference of this vector.
+	 */
+	CUDA_CALLABLE_MEMBER SPLVector4<T>& operator *= (const T s) throw();
+
+	/*! \brief Division operator!
+	 *
+	 * \param s A scalar value (non zero).
+	 *
+	 * \return Reference of this vector.
+	 */
+	CUDA_CALLABLE_MEMBER SPLVector4<T>& operator /= (const T s) throw();
+
+	/*! \brief Addition operator!
+	 *
+	 * \param v Another vector.
+	 *
+	 * \return New vector \f$ {\bf V} + {\bf v} \f$.
+	 */
+	CUDA_CALLABLE_MEMBER SPLVector4<T> operator + (const SPLVector4<T> &v) const throw();
+
+	/*! \brief Subtraction operator!
+	 *
+	 * \param v Another vector.
+	 *
+	 * \return New vector \f$ {\bf V} - {\bf v} \f$.
+	 */
+	CUDA_CALLABLE_MEMBER SPLVector4<T> operator - (const SPLVector4<T> &v) const throw();
+
+	/*! \brief Multiplication operator!
+	 *
+	 * \param s A scalar value.
+	 *
+	 * \return New vector \f$ s * {\bf V} \f$.
+	 */
+	CUDA_CALLABLE_MEMBER SPLVector4<T> operator * (const T s) const throw();
+
+	/*! \brief Division operator!
+	 *
+	 * \param s A scalar value (non zero).
+	 *
+	 * \return New vector \f$ {1 \over s} * {\bf V} \f$.
+	 */
+	CUDA_CALLABLE_MEMBER SPLVector4<T> operator / (const T s) const throw();
+
+	/*! \brief Print the elements to standard output!
+	 *
+	 * The elements are printed only in debugging mode,
+	 * i.e. when the library has been compiled with the flag -D__DEBUG__.
+	 */
+	CUDA_CALLABLE_MEMBER void print(void) const throw();
+
+	/*! \brief Returns the square value of the vector!
+	 *
+	 * \f[ s = {\| {\bf V} \|}^2 = {\bf V}_x^2 + {\bf V}_y^2 + {\bf V}_z^2 + {\bf V}_w^2 \f]
+	 *
+	 * The value is computed with the precision policy \ref SPLPrecisionDefault
+	 * of the type \c T, see \ref precision.hh.
+	 *
+	 * \return The scalar square value of this vector.
+	 */
+	CUDA_CALLABLE_MEMBER SPLieee64 square(void) const throw();
+
+	/*! \brief Returns the length value of the vector!
+	 *
+	 * \f[ s = {\| {\bf V} \|} \f]
+	 *
+	 * \return The scalar length of this vector.
+	 */
+	CUDA_CALLABLE_MEMBER SPLieee64 length(void) const throw();
+
+	/*! \brief Returns the normalized vector (inplace)!
+	 *
+	 * \f[ {\bf V} = l * {\bf V} / {\| {\bf V} \|} \f]
+	 * A vector of length zero is not changed.
+	 *
+	 * \param l The length of the resulting vector.
+	 *
+	 * \return Reference of this normalized vector to a certain length.
+	 */
+	CUDA_CALLABLE_MEMBER SPLVector4<T>& normalize(const SPLieee64 l = 1.0) throw();
+
+	/*! \brief Returns the 3 dimensional vector after the homogeneous division!
+	 *
+	 * \f[ {\bf n} = ({\bf V}_x, {\bf V}_y, {\bf V}_z)^T / {\bf V}_w \f]
+	 *
+	 * \return New vector, or the first 3 elements if \c w is zero.
+	 */
+	CUDA_CALLABLE_MEMBER SPLVector3<T> getHomogenized(void) const throw();
+
+	T x;	//!< 1st component (or element) of the vector.
+	T y;	//!< 2nd component (or element) of the vector.
+	T z;	//!< 3rd component (or element) of the vector.
+	T w;	//!< 4th component (or element) of the vector.
+};
+
+/************************************************************************************************
+ ** Non member functions for SPLVector4
+ ************************************************************************************************/
+/*! \fn SPLVector4<T> operator * (const T s, const SPLVector4<T> &v)
+ * \brief Multiplication operator!
+ *
+ * \param s A scalar value.
+ * \param v A vector.
+ *
+ * \return New vector \f$ s * {\bf v} \f$.
+*/
+template <class T>
+SPLVector4<T> operator * (const T s, const SPLVector4<T> &v)
+{
+	return SPLVector4<T>(s*v.x, s*v.y, s*v.z, s*v.w);
+}
+
+/************************************************************************************************
+ ** SPLVector4 class implementation
+ ************************************************************************************************/
+template <class T>
+SPLVector4<T>::SPLVector4(void) throw()
+{
+	this->x = T(0);
+	this->y = T(0);
+	this->z = T(0);
+	this->w = T(0);
+}
+
+template <class T>
+SPLVector4<T>::SPLVector4(const T x, const T y, const T z, const T w) throw()
+{
+	this->x = x;
+	this->y = y;
+	this->z = z;
+	this->w = w;
+}
+
+template <class T>
+SPLVector4<T>::SPLVector4(const SPLVector3<T> &v, const T w) throw()
+{
+	this->x = v.x;
+	this->y = v.y;
+	this->z = v.z;
+	this->w = w;
+}
+
+template <class T>
+SPLVector4<T>::SPLVector4(const SPLVector4<T> &v) throw()
+{
+	this->x = v.x;
+	this->y = v.y;
+	this->z = v.z;
+	this->w = v.w;
+}
+
+template <class T>
+bool SPLVector4<T>::operator == (const SPLVector4<T> &v) const throw()
+{
+	return (this->x == v.x && this->y == v.y && this->z == v.z && this->w == v.w);
+}
+
+template <class T>
+bool SPLVector4<T>::operator != (const SPLVector4<T> &v) const throw()
+{
+	return !(this->operator == (v));
+}
+
+template <class T>
+SPLVector4<T>& SPLVector4<T>::operator = (const SPLVector4<T> &v) throw()
+{
+	this->x = v.x;
+	this->y = v.y;
+	this->z = v.z;
+	this->w = v.w;
+	return (*this);
+}
+
+template <class T>
+T& SPLVector4<T>::operator [] (const SPLindex i) throw()
+{
+	assert (i >= 0 && i <= 3);
+	return (&x)[i];
+}
+
+template <class T>
+const T& SPLVector4<T>::operator [] (const SPLindex i) const throw()
+{
+	assert (i >= 0 && i <= 3);
+	return (&x)[i];
+}
+
+template <class T>
+SPLVector4<T> SPLVector4<T>::operator - (void) const throw()
+{
+#ifdef SPL_SIMD4
+	if constexpr (std::is_same<T, SPLieee32>::value)
+	{
+		SPLVector4<T> ret;
+		SPLSimd4f::store(&ret.x, SPLSimd4f::sub(SPLSimd4f::zero(), SPLSimd4f::load(&this->x)));
+		return ret;
+	}
+#endif
+	return SPLVector4<T>(-this->x, -this->y, -this->z, -this->w);
+}
+
+template <class T>
+T SPLVector4<T>::operator * (const SPLVector4<T> &v) const throw()
+{
+#ifdef SPL_SIMD4
+	if constexpr (std::is_same<T, SPLieee32>::value)
+	{
+		return SPLSimd4f::first(SPLSimd4f::dot4(SPLSimd4f::load(&this->x), SPLSimd4f::load(&v.x)));
+	}
+#endif
+	return (this->x*v.x + this->y*v.y + this->z*v.z + this->w*v.w);
+}
+
+template <class T>
+SPLVector4<T>& SPLVector4<T>::operator += (const SPLVector4<T> &v) throw()
+{
+#ifdef SPL_SIMD4
+	if constexpr (std::is_same<T, SPLieee32>::value)
+	{
+		SPLSimd4f::store(&this->x, SPLSimd4f::add(SPLSimd4f::load(&this->x), SPLSimd4f::load(&v.x)));
+		return (*this);
+	}
+#endif
+	this->x += v.x;
+	this->y += v.y;
+	this->z += v.z;
+	this->w += v.w;
+	return (*this);
+}
+
+template <class T>
+SPLVector4<T>& SPLVector4<T>::operator -= (const SPLVector4<T> &v) throw()
+{
+#ifdef SPL_SIMD4
+	if constexpr (std::is_same<T, SPLieee32>::value)
+	{
+		SPLSimd4f::store(&this->x, SPLSimd4f::sub(SPLSimd4f::load(&this->x), SPLSimd4f::load(&v.x)));
+		return (*this);
+	}
+#endif
+	this->x -= v.x;
+	this->y -= v.y;
+	this->z -= v.z;
+	this->w -= v.w;
+	return (*this);
+}
+
+template <class T>
+SPLVector4<T>& SPLVector4<T>::operator *= (const T s) throw()
+{
+#ifdef SPL_SIMD4
+	if constexpr (std::is_same<T, SPLieee32>::value)
+	{
+		SPLSimd4f::store(&this->x, SPLSimd4f::mul(SPLSimd4f::load(&this->x), SPLSimd4f::set1(s)));
+		return (*this);
+	}
+#endif
+	this->x *= s;
+	this->y *= s;
+	this->z *= s;
+	this->w *= s;
+	return (*this);
+}
+
+template <class T>
+SPLVector4<T>& SPLVector4<T>::operator /= (const T s) throw()
+{
+	assert (s != T(0));
+	this->x /= s;
+	this->y /= s;
+	this->z /= s;
+	this->w /= s;
+	return (*this);
+}
+
+template <class T>
+SPLVector4<T> SPLVector4<T>::operator + (const SPLVector4<T> &v) const throw()
+{
+#ifdef SPL_SIMD4
+	if constexpr (std::is_same<T, SPLieee32>::value)
+	{
+		SPLVector4<T> ret;
+		SPLSimd4f::store(&ret.x, SPLSimd4f::add(SPLSimd4f::load(&this->x), SPLSimd4f::load(&v.x)));
+		return ret;
+	}
+#endif
+	return SPLVector4<T>(this->x + v.x, this->y + v.y, this->z + v.z, this->w + v.w);
+}
+
+template <class T>
+SPLVector4<T> SPLVector4<T>::operator - (const SPLVector4<T> &v) const throw()
+{
+#ifdef SPL_SIMD4
+	if constexpr (std::is_same<T, SPLieee32>::value)
+	{
+		SPLVector4<T> ret;
+		SPLSimd4f::store(&ret.x, SPLSimd4f::sub(SPLSimd4f::load(&this->x), SPLSimd4f::load(&v.x)));
+		return ret;
+	}
+#endif
+	return SPLVector4<T>(this->x - v.x, this->y - v.y, this->z - v.z, this->w - v.w);
+}
+
+template <class T>
+SPLVector4<T> SPLVector4<T>::operator * (const T s) const throw()
+{
+#ifdef SPL_SIMD4
+	if constexpr (std::is_same<T, SPLieee32>::value)
+	{
+		SPLVector4<T> ret;
+		SPLSimd4f::store(&ret.x, SPLSimd4f::mul(SPLSimd4f::load(&this->x), SPLSimd4f::set1(s)));
+		return ret;
+	}
+#endif
+	return SPLVector4<T>(this->x * s, this->y * s, this->z * s, this->w * s);
+}
+
+template <class T>
+SPLVector4<T> SPLVector4<T>::operator / (const T s) const throw()
+{
+	assert (s != T(0));
+	return SPLVector4<T>(this->x / s, this->y / s, this->z / s, this->w / s);
+}
+
+template <class T>
+void SPLVector4<T>::print(void) const throw()
+{
+#ifdef __DEBUG__
+	printf("SPLVector4:\n");
+	printf("%10.9f %10.9f %10.9f %10.9f\n", double(x), double(y), double(z), double(w));
+#endif
+}
+
+template <class T>
+SPLieee64 SPLVector4<T>::square(void) const throw()
+{
+	typedef typename SPLPrecisionDefault<T>::Type P;
+	typedef typename P::template Real<T>::Type R;
+	return SPLieee64(R(this->x) * R(this->x) + R(this->y) * R(this->y) + R(this->z) * R(this->z) + R(this->w) * R(this->w));
+}
+
+template <class T>
+SPLieee64 SPLVector4<T>::length(void) const throw()
+{
+	return SQRT(this->square());
+}
+
+template <class T>
+SPLVector4<T>& SPLVector4<T>::normalize(const SPLieee64 l) throw()
+{
+	assert(l > 0.0);
+	const SPLieee64 sq = this->square();
+	if (sq == 0.0)
+	{
+		return *this;
+	}
+	const SPLieee64 f = l / SQRT(sq);
+	this->x = T(SPLieee64(this->x) * f);
+	this->y = T(SPLieee64(this->y) * f);
+	this->z = T(SPLieee64(this->z) * f);
+	this->w = T(SPLieee64(this->w) * f);
+	return *this;
+}
+
+template <class T>
+SPLVector3<T> SPLVector4<T>::getHomogenized(void) const throw()
+{
+	if (this->w == T(0))
+	{
+		return SPLVector3<T>(this->x, this->y, this->z);
+	}
+	return SPLVector3<T>(this->x / this->w, this->y / this->w, this->z / this->w);
+}
+
+/************************************************************************************************
+ ** SPLVector3 members which need the complete SPLVector4
+ ************************************************************************************************/
+template <class T>
+SPLVector3<T>& SPLVector3<T>::operator = (const SPLVector4<SPLieee64> &v) throw()
+{
+	this->x=T(v.x);
+	this->y=T(v.y);
+	this->z=T(v.z);
+	// v.w discard
+	return (*this);
+}
+
+#endif /*_spl_vector4_hh_*/
@@ -0,0 +1,492 @@
+#ifndef _spl_vtr_hh_
+#define _spl_vtr_hh_
+
+#include <cstdio>    // for fopen(), fwrite()
+#include <cstring>   // for memcpy()
+#include <functional>
+#include <string>
+#include <vector>
+
+#ifdef SPL_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#include <spl/typesbase.hh>
+#include <spl/mathbase.hh>
+#include <spl/threadpool.hh>
+#include <spl/vector3.hh>
+#include <spl/grid.hh>
+
+/*! \file vtr.hh
+ * */
+
+/*! \class SPLVTRWriter
+ * \brief Writes grids as VTK rectilinear grid files (\ref SPL_FILEIO_VTR_ID).
+ *
+ * The writer emits an XML .vtr file with all point and cell arrays in
+ * the raw appended binary section, i.e. the samples are copied in the
+ * VTK layout (x fastest) instead of being formatted as text. All arrays
+ * of a file are written in one pass and grids in the linear layout are
+ * written straight from their memory.
+ *
+ * With \ref setCompression (requires zlib, i.e. \c SPL_HAVE_ZLIB) each
+ * array is split into blocks, see \ref setBlockSize, which are
+ * compressed in parallel on the threads of the pool and written in
+ * order, in the format of the \c vtkZLibDataCompressor.
+ *
+ * Example
+ * \code
+ * SPLGridf density(SPLVector3i(256, 256, 256));
+ * SPLGrid<SPLVector3f> velocity(SPLVector3i(256, 256, 256));
+ * ...
+ * SPLVTRWriter w(density.getSize());
+ * w.setSpacing(SPLVector3d(0.0, 0.0, 0.0), SPLVector3d(0.5, 0.5, 0.5));
+ * w.addPointData("density", density);
+ * w.addPointData("velocity", velocity);
+ * w.setCompression(1);
+ * w.write("result.vtr");
+ * \endcode
+ *
+ * Scalar voxels and \ref SPLVector3 voxels (3 components) of the types
+ * \ref SPLint8 to \ref SPLieee64 are supported. The grids are referenced,
+ * i.e. they must exist until \ref write returns.
+ *
+ * \sa SPLGrid
+ */
+class SPLVTRWriter
+{
+public:
+	/*! \brief Constructor!
+	 *
+	 * The coordinates are \f$ 0, 1, \ldots, n - 1 \f$ along each axis.
+	 *
+	 * \param size Number of points along x, y and z (at least 1).
+	 */
+	explicit SPLVTRWriter(const SPLVector3i &size) throw();
+
+	/*! \brief Sets equidistant coordinates!
+	 *
+	 * \param origin The coordinates of the first point.
+	 * \param spacing The distance of the points along x, y and z.
+	 */
+	void setSpacing(const SPLVector3d &origin, const SPLVector3d &spacing) throw();
+
+	/*! \brief Sets the coordinates along one axis!
+	 *
+	 * \param axis \f$ 0 \f$ (x), \f$ 1 \f$ (y) or \f$ 2 \f$ (z).
+	 * \param c Array with one coordinate per point along the axis.
+	 */
+	void setCoordinates(const SPLindex axis, const SPLieee64 *c) throw();
+
+	/*! \brief Adds a point array!
+	 *
+	 * \param name The name of the array.
+	 * \param grid A grid with the number of points.
+	 *
+	 * \return \c true on success and \c false if the size or the voxel type is not supported.
+	 */
+	template <class T>
+	bool addPointData(const char *name, const SPLGrid<T> &grid) throw();
+
+	/*! \brief Adds a cell array!
+	 *
+	 * \param name The name of the array.
+	 * \param grid A grid with the number of cells, i.e. one less than the number of points along each axis.
+	 *
+	 * \return \c true on success and \c false if the size or the voxel type is not supported.
+	 */
+	template <class T>
+	bool addCellData(const char *name, const SPLGrid<T> &grid) throw();
+
+	/*! \brief Enables the compression!
+	 *
+	 * \param level The zlib level in \f$ [1, 9] \f$, or \f$ 0 \f$ for no compression.
+	 *
+	 * \return \c true on success and \c false if zlib is not available.
+	 */
+	bool setCompression(const SPLint32 level) throw();
+
+	/*! \brief Sets the size of the compressed blocks!
+	 *
+	 * \param bytes Uncompressed bytes per block (default 1 MiB).
+	 */
+	void setBlockSize(const SPLint64 bytes) throw();
+
+	/*! \brief Writes the file!
+	 *
+	 * \param path The file.
+	 * \param pool The threads, which gather and compress the blocks.
+	 *
+	 * \return \c true on success and \c false otherwise.
+	 */
+	bool write(const char *path, SPLThreadPool &pool = SPLThreadPool::getGlobal()) const throw();
+
+private:
+	struct Array
+	{
+		std::string name;		//!< Name of the array.
+		std::string type;		//!< VTK type of the components.
+		SPLint32 components;	//!< Number of components.
+		SPLint64 bytes;			//!< Size in bytes.
+		SPLint64 tuple;			//!< Bytes per tuple.
+		const SPLuint8 *data;	//!< Contiguous memory in the VTK layout, or 0.
+		std::function<void(SPLint64, SPLint64, SPLuint8 *)> gather;	//!< Copies the tuples [first, first + count).
+	};
+
+	template <class T>
+	bool add(std::vector<Array> &arrays, const char *name, const SPLGrid<T> &grid) throw();
+	bool writeArray(FILE *f, const Array &a, SPLThreadPool &pool) const throw();
+
+	SPLVector3i size;				//!< Number of points.
+	std::vector<SPLieee64> coordinates[3];	//!< Coordinates of the points along x, y and z.
+	std::vector<Array> points;		//!< Point arrays.
+	std::vector<Array> cells;		//!< Cell arrays.
+	SPLint32 level;					//!< Compression level.
+	SPLint64 block;					//!< Uncompressed bytes per block.
+};
+
+namespace SPLVTRDetail
+{
+	//! VTK type name and number of components of a voxel type.
+	template <class T>
+	struct Traits
+	{
+		typedef T Sample;
+		static const SPLint32 components = 1;
+	};
+
+	template <class S>
+	struct Traits<SPLVector3<S> >
+	{
+		typedef S Sample;
+		static const SPLint32 components = 3;
+	};
+
+	inline const char* typeName(const SPLenum type) throw()
+	{
+		switch (type)
+		{
+		case SPL_TYPE_INT8: return "Int8";
+		case SPL_TYPE_UINT8: return "UInt8";
+		case SPL_TYPE_INT16: return "Int16";
+		case SPL_TYPE_UINT16: return "UInt16";
+		case SPL_TYPE_INT32: return "Int32";
+		case SPL_TYPE_UINT32: return "UInt32";
+		case SPL_TYPE_INT64: return "Int64";
+		case SPL_TYPE_UINT64: return "UInt64";
+		case SPL_TYPE_IEEE32: return "Float32";
+		case SPL_TYPE_IEEE64: return "Float64";
+		default: return 0;
+		}
+	}
+
+	//! Escapes a string for an XML attribute.
+	inline std::string escape(const char *s) throw()
+	{
+		std::string r;
+		for (; *s != 0; s++)
+		{
+			switch (*s)
+			{
+			case '&': r += "&amp;"; break;
+			case '<': r += "&lt;"; break;
+			case '>': r += "&gt;"; break;
+			case '"': r += "&quot;"; break;
+			default: r += *s;
+			}
+		}
+		return r;
+	}
+
+	inline bool seek(FILE *f, const SPLint64 position) throw()
+	{
+#ifdef _WIN32
+		return _fseeki64(f, position, SEEK_SET) == 0;
+#else
+		return fseeko(f, off_t(position), SEEK_SET) == 0;
+#endif
+	}
+
+	inline SPLint64 tell(FILE *f) throw()
+	{
+#ifdef _WIN32
+		return SPLint64(_ftelli64(f));
+#else
+		return SPLint64(ftello(f));
+#endif
+	}
+
+	//! Width of the patched offset attributes.
+	static const SPLint32 OFFSET_DIGITS = 20;
+}
+
+/************************************************************************************************
+ ** SPLVTRWriter class implementation
+ ************************************************************************************************/
+inline SPLVTRWriter::SPLVTRWriter(const SPLVector3i &size) throw()
+{
+	assert(size.x >= 1 && size.y >= 1 && size.z >= 1);
+	this->size = size;
+	this->level = 0;
+	this->block = 1 << 20;
+	this->setSpacing(SPLVector3d(0.0, 0.0, 0.0), SPLVector3d(1.0, 1.0, 1.0));
+}
+
+inline void SPLVTRWriter::setSpacing(const SPLVector3d &origin, const SPLVector3d &spacing) throw()
+{
+	const SPLindex n[3] = { this->size.x, this->size.y, this->size.z };
+	for (SPLindex a = 0; a < 3; a++)
+	{
+		this->coordinates[a].resize(size_t(n[a]));
+		for (SPLindex i = 0; i < n[a]; i++)
+		{
+			this->coordinates[a][size_t(i)] = origin[a] + SPLieee64(i) * spacing[a];
+		}
+	}
+}
+
+inline void SPLVTRWriter::setCoordinates(const SPLindex axis, const SPLieee64 *c) throw()
+{
+	assert(axis >= 0 && axis <= 2);
+	std::vector<SPLieee64> &v = this->coordinates[axis];
+	v.assign(c, c + v.size());
+}
+
+template <class T>
+bool SPLVTRWriter::addPointData(const char *name, const SPLGrid<T> &grid) throw()
+{
+	return grid.getSize() == this->size && this->add(this->points, name, grid);
+}
+
+template <class T>
+bool SPLVTRWriter::addCellData(const char *name, const SPLGrid<T> &grid) throw()
+{
+	const SPLVector3i cells(MAX(this->size.x - 1, 1), MAX(this->size.y - 1, 1), MAX(this->size.z - 1, 1));
+	return grid.getSize() == cells && this->add(this->cells, name, grid);
+}
+
+inline bool SPLVTRWriter::setCompression(const SPLint32 level) throw()
+{
+#ifdef SPL_HAVE_ZLIB
+	this->level = CLAMP(level, 0, 9);
+	return true;
+#else
+	this->level = 0;
+	return level == 0;
+#endif
+}
+
+inline void SPLVTRWriter::setBlockSize(const SPLint64 bytes) throw()
+{
+	assert(bytes > 0);
+	this->block = bytes;
+}
+
+template <class T>
+bool SPLVTRWriter::add(std::vector<Array> &arrays, const char *name, const SPLGrid<T> &grid) throw()
+{
+	typedef SPLVTRDetail::Traits<T> Tr;
+	typedef typename Tr::Sample S;
+	const char *type = SPLVTRDetail::typeName(SPLTypeId<S>::value);
+	// the tuples are copied as they are, i.e. they must not be padded
+	if (type == 0 || sizeof(T) != Tr::components * sizeof(S))
+	{
+		return false;
+	}
+	const SPLVector3i n = grid.getSize();
+	Array a;
+	a.name = SPLVTRDetail::escape(name);
+	a.type = type;
+	a.components = Tr::components;
+	a.tuple = SPLint64(sizeof(T));
+	a.bytes = SPLint64(n.x) * n.y * n.z * a.tuple;
+	a.data = (grid.getLayout() == SPL_GRID_LINEAR) ? (const SPLuint8 *)grid.getData() : 0;
+	const SPLGrid<T> *g = &grid;
+	a.gather = [g, n](const SPLint64 first, const SPLint64 count, SPLuint8 *dst)
+	{
+		const SPLint64 *ox = g->getOffsets(0), *oy = g->getOffsets(1), *oz = g->getOffsets(2);
+		const T *v = g->getData();
+		SPLint64 e = first;
+		const SPLint64 end = first + count;
+		while (e < end)
+		{
+			// the rest of the current row
+			const SPLindex x0 = SPLindex(e % n.x), y = SPLindex((e / n.x) % n.y), z = SPLindex(e / (SPLint64(n.x) * n.y));
+			const SPLindex x1 = SPLindex(MIN(SPLint64(n.x), x0 + (end - e)));
+			const T *r = v + oy[y] + oz[z];
+			for (SPLindex x = x0; x < x1; x++, dst += sizeof(T))
+			{
+				memcpy(dst, r + ox[x], sizeof(T));
+			}
+			e += x1 - x0;
+		}
+	};
+	arrays.push_back(a);
+	return true;
+}
+
+inline bool SPLVTRWriter::writeArray(FILE *f, const Array &a, SPLThreadPool &pool) const throw()
+{
+	// blocks of whole tuples
+	const SPLint64 tuples = MAX(this->block / a.tuple, SPLint64(1)), bytes = tuples * a.tuple;
+	const SPLint64 blocks = (a.bytes + bytes - 1) / bytes;
+	const SPLint64 batch = 2 * SPLint64(pool.getNumThreads());
+	const size_t buffers = size_t(batch);
+	std::vector<std::vector<SPLuint8> > raw(buffers), packed(buffers);
+	std::vector<SPLuint64> sizes;
+
+	SPLint64 header = 0;
+	if (this->level > 0)
+	{
+		// nblocks, block size, size of the last block (0 if full), compressed sizes
+		const SPLuint64 h[3] = { SPLuint64(blocks), SPLuint64(bytes), SPLuint64(a.bytes % bytes) };
+		header = SPLVTRDetail::tell(f);
+		sizes.assign(size_t(blocks), 0);
+		if (fwrite(h, sizeof(h), 1, f) != 1 || (blocks > 0 && fwrite(&sizes[0], sizeof(SPLuint64), size_t(blocks), f) != size_t(blocks)))
+		{
+			return false;
+		}
+	}
+	else
+	{
+		const SPLuint64 n = SPLuint64(a.bytes);
+		if (fwrite(&n, sizeof(n), 1, f) != 1)
+		{
+			return false;
+		}
+		if (a.data != 0)
+		{
+			return a.bytes == 0 || fwrite(a.data, 1, size_t(a.bytes), f) == size_t(a.bytes);
+		}
+	}
+
+	bool ok = true;
+	for (SPLint64 b0 = 0; b0 < blocks && ok; b0 += batch)
+	{
+		const SPLint64 count = MIN(batch, blocks - b0);
+		pool.parallelFor(0, count, 1, [&](const SPLint64 first, const SPLint64 last)
+		{
+			for (SPLint64 i = first; i < last; i++)
+			{
+				const SPLint64 b = b0 + i, start = b * bytes, length = MIN(bytes, a.bytes - start);
+				const SPLuint8 *src = (a.data != 0) ? a.data + start : 0;
+				if (src == 0)
+				{
+					raw[size_t(i)].resize(size_t(length));
+					a.gather(start / a.tuple, length / a.tuple, &raw[size_t(i)][0]);
+					src = &raw[size_t(i)][0];
+				}
+#ifdef SPL_HAVE_ZLIB
+				if (this->level > 0)
+				{
+					uLongf n = compressBound(uLong(length));
+					packed[size_t(i)].resize(size_t(n));
+					if (compress2(&packed[size_t(i)][0], &n, src, uLong(length), this->level) != Z_OK)
+					{
+						n = 0;
+					}
+					packed[size_t(i)].resize(size_t(n));
+					continue;
+				}
+#endif
+				if (src != &raw[size_t(i)][0])
+				{
+					raw[size_t(i)].assign(src, src + length);
+				}
+			}
+		});
+		for (SPLint64 i = 0; i < count && ok; i++)
+		{
+			const std::vector<SPLuint8> &out = (this->level > 0) ? packed[size_t(i)] : raw[size_t(i)];
+			ok = !out.empty() && fwrite(&out[0], 1, out.size(), f) == out.size();
+			if (this->level > 0)
+			{
+				sizes[size_t(b0 + i)] = SPLuint64(out.size());
+			}
+		}
+	}
+	if (ok && this->level > 0 && blocks > 0)
+	{
+		// the compressed sizes are known now
+		const SPLint64 end = SPLVTRDetail::tell(f);
+		ok = SPLVTRDetail::seek(f, header + 3 * SPLint64(sizeof(SPLuint64))) &&
+			fwrite(&sizes[0], sizeof(SPLuint64), size_t(blocks), f) == size_t(blocks) &&
+			SPLVTRDetail::seek(f, end);
+	}
+	return ok;
+}
+
+inline bool SPLVTRWriter::write(const char *path, SPLThreadPool &pool) const throw()
+{
+	// the coordinates are arrays as well
+	std::vector<Array> coords(3);
+	static const char *axes[3] = { "x", "y", "z" };
+	for (SPLindex i = 0; i < 3; i++)
+	{
+		coords[size_t(i)].name = axes[i];
+		coords[size_t(i)].type = "Float64";
+		coords[size_t(i)].components = 1;
+		coords[size_t(i)].tuple = SPLint64(sizeof(SPLieee64));
+		coords[size_t(i)].bytes = SPLint64(this->coordinates[i].size() * sizeof(SPLieee64));
+		coords[size_t(i)].data = (const SPLuint8 *)&this->coordinates[i][0];
+	}
+
+	const SPLuint16 one = 1;
+	const bool little = (*(const SPLuint8 *)&one == 1);
+	char extent[128];
+	snprintf(extent, sizeof(extent), "0 %d 0 %d 0 %d", this->size.x - 1, this->size.y - 1, this->size.z - 1);
+
+	// the offsets are patched after the data has been written
+	std::string xml;
+	std::vector<size_t> patches;
+	const std::vector<Array> *groups[3] = { &this->points, &this->cells, &coords };
+	static const char *tags[3] = { "PointData", "CellData", "Coordinates" };
+	xml += "<?xml version=\"1.0\"?>\n";
+	xml += std::string("<VTKFile type=\"RectilinearGrid\" version=\"1.0\" byte_order=\"") + (little ? "LittleEndian" : "BigEndian") + "\" header_type=\"UInt64\"";
+	xml += (this->level > 0) ? " compressor=\"vtkZLibDataCompressor\">\n" : ">\n";
+	xml += std::string("  <RectilinearGrid WholeExtent=\"") + extent + "\">\n";
+	xml += std::string("    <Piece Extent=\"") + extent + "\">\n";
+	for (SPLindex g = 0; g < 3; g++)
+	{
+		xml += std::string("      <") + tags[g] + ">\n";
+		for (size_t i = 0; i < groups[g]->size(); i++)
+		{
+			const Array &a = (*groups[g])[i];
+			char components[16];
+			snprintf(components, sizeof(components), "%d", a.components);
+			xml += "        <DataArray type=\"" + a.type + "\" Name=\"" + a.name + "\" NumberOfComponents=\"" + components + "\" format=\"appended\" offset=\"";
+			patches.push_back(xml.size());
+			xml += std::string(size_t(SPLVTRDetail::OFFSET_DIGITS), '0') + "\"/>\n";
+		}
+		xml += std::string("      </") + tags[g] + ">\n";
+	}
+	xml += "    </Piece>\n  </RectilinearGrid>\n  <AppendedData encoding=\"raw\">\n   _";
+
+	FILE *f = fopen(path, "wb");
+	if (f == 0)
+	{
+		return false;
+	}
+	bool ok = fwrite(xml.data(), 1, xml.size(), f) == xml.size();
+	const SPLint64 start = SPLVTRDetail::tell(f);
+	std::vector<SPLint64> offsets;
+	for (SPLindex g = 0; g < 3 && ok; g++)
+	{
+		for (size_t i = 0; i < groups[g]->size() && ok; i++)
+		{
+			offsets.push_back(SPLVTRDetail::tell(f) - start);
+			ok = this->writeArray(f, (*groups[g])[i], pool);
+		}
+	}
+	const char tail[] = "\n  </AppendedData>\n</VTKFile>\n";
+	ok = ok && fwrite(tail, 1, sizeof(tail) - 1, f) == sizeof(tail) - 1;
+	for (size_t i = 0; i < patches.size() && ok; i++)
+	{
+		char digits[32];
+		snprintf(digits, sizeof(digits), "%0*lld", int(SPLVTRDetail::OFFSET_DIGITS), (long long)offsets[i]);
+		ok = SPLVTRDetail::seek(f, SPLint64(patches[i])) && fwrite(digits, 1, size_t(SPLVTRDetail::OFFSET_DIGITS), f) == size_t(SPLVTRDetail::OFFSET_DIGITS);
+	}
+	return (fclose(f) == 0) && ok;
+}
+
+#endif /* _spl_vtr_hh_ */
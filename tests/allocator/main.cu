@@ -0,0 +1,209 @@
+// main.cu: Tests of the aligned allocation, the arenas and the pools of buffers.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <chrono>
+
+#include <spl/grid.hh>
+#include <spl/vector3array.hh>
+
+#include "../check.hh"
+
+static bool aligned(const void *p, const SPLint64 alignment)
+{
+	return (uintptr_t(p) & uintptr_t(alignment - 1)) == 0;
+}
+
+static void testAlloc(void)
+{
+	const SPLMemoryStats s0 = splMemoryGetStats();
+	SPLvoidp a = splMemoryAlloc(1000);
+	SPLvoidp b = splMemoryAlloc(100, 4096);
+	SPLvoidp c = splMemoryAlloc(0);
+	check(a != 0 && b != 0 && c != 0 && aligned(a, SPL_SIMD_ALIGNMENT) && aligned(b, 4096) && aligned(c, SPL_SIMD_ALIGNMENT), "alignment");
+	check(splMemoryGetSize(a) == 1000 && splMemoryGetSize(b) == 100 && splMemoryGetSize(0) == 0, "sizes");
+	check(splMemoryAlloc(10, 48) == 0 && splMemoryAlloc(-1) == 0, "invalid requests");
+	memset(a, 1, 1000);
+	memset(b, 2, 100);
+
+	const SPLMemoryStats s1 = splMemoryGetStats();
+	check(s1.allocations == s0.allocations + 3 && s1.bytes >= s0.bytes + 1100 && s1.peak >= s1.bytes, "counted allocations");
+	splMemoryFree(a);
+	splMemoryFree(b);
+	splMemoryFree(c);
+	splMemoryFree(0);
+	const SPLMemoryStats s2 = splMemoryGetStats();
+	check(s2.frees == s0.frees + 3 && s2.bytes == s0.bytes && s2.peak == s1.peak, "counted frees");
+	splMemoryResetPeak();
+	check(splMemoryGetStats().peak == s2.bytes, "reset peak");
+
+	// grids and vector arrays are counted
+	{
+		SPLGrid<SPLieee32> g(SPLVector3i(64, 64, 64));
+		SPLVector3Arrayf v(1000);
+		check(splMemoryGetStats().bytes >= s2.bytes + 64 * 64 * 64 * 4 + 3000 * 4, "grids and arrays");
+	}
+	check(splMemoryGetStats().bytes == s2.bytes, "grids and arrays freed");
+}
+
+static void testOptions(void)
+{
+	// huge pages: the allocation starts on a huge page in front of the header, advised if the system supports it
+	splMemorySetHugePages(true);
+	SPLvoidp p = splMemoryAlloc(3 * SPL_MEMORY_HUGE_PAGE_SIZE);
+	SPLvoidp q = splMemoryAlloc(1000);
+	check(splMemoryGetHugePages() && p != 0 && q != 0, "huge page allocation");
+	check(aligned((SPLuint8 *)p - SPL_SIMD_ALIGNMENT, SPL_MEMORY_HUGE_PAGE_SIZE), "huge page alignment");
+	memset(p, 3, size_t(3 * SPL_MEMORY_HUGE_PAGE_SIZE));
+	printf("allocator: %lld bytes advised for huge pages\n", (long long)splMemoryGetStats().hugeBytes);
+	splMemoryFree(p);
+	splMemoryFree(q);
+	check(splMemoryGetStats().hugeBytes == 0, "huge pages freed");
+	splMemorySetHugePages(false);
+
+	// first touch: grids are zeroed by the threads of the pool
+	splMemorySetFirstTouch(true);
+	SPLGrid<SPLint16> g(SPLVector3i(200, 100, 300), SPL_GRID_BRICKED, 8);
+	bool zero = true;
+	const SPLint16 *d = g.getData();
+	for (SPLint64 i = 0; i < g.getStorageSize(); i++)
+	{
+		zero = zero && d[i] == 0;
+	}
+	check(splMemoryGetFirstTouch() && zero, "first touch");
+	splMemorySetFirstTouch(false);
+}
+
+static void testArena(void)
+{
+	SPLArena arena(1 << 20);
+	const SPLMemoryStats s0 = splMemoryGetStats();
+	SPLieee32 *a = arena.allocate<SPLieee32>(1000);
+	SPLvoidp b = arena.allocate(10, 8);
+	SPLvoidp c = arena.allocate(100, 256);
+	check(a != 0 && b != 0 && c != 0 && aligned(a, SPL_SIMD_ALIGNMENT) && aligned(b, 8) && aligned(c, 256), "arena alignment");
+	check((SPLuint8 *)b == (SPLuint8 *)a + 4000 && arena.getUsed() >= 4110 && arena.getCapacity() == (1 << 20), "arena chunk");
+	check(arena.allocate(10, 3) == 0 && arena.allocate(10, 8192) == 0, "invalid arena requests");
+
+	// a larger allocation gets a chunk of its own
+	SPLvoidp d = arena.allocate(3 << 20);
+	check(d != 0 && arena.getCapacity() == (1 << 20) + (3 << 20), "large arena allocation");
+	const SPLMemoryStats s1 = splMemoryGetStats();
+	check(s1.allocations == s0.allocations + 2 && s1.arenaBytes == s0.arenaBytes + (4 << 20) && s1.arenaUsed >= s0.arenaUsed + (3 << 20),
+		  "arena counters");
+
+	// reset frees in bulk and keeps the chunks
+	arena.reset();
+	check(arena.getUsed() == 0 && arena.allocate<SPLieee32>(1000) == a && splMemoryGetStats().allocations == s1.allocations, "arena reset");
+	SPLGrid<SPLuint8> g;
+	check(g.resize(SPLVector3i(100, 100, 100), SPL_GRID_LINEAR, 8, arena) && g.isExternal() && g(99, 99, 99) == 0, "grid of an arena");
+	check(splMemoryGetStats().allocations == s1.allocations, "grid in the kept chunks");
+	g.resize(SPLVector3i(0, 0, 0));
+	arena.release();
+	check(arena.getCapacity() == 0 && splMemoryGetStats().arenaBytes == s0.arenaBytes && splMemoryGetStats().arenaUsed == s0.arenaUsed,
+		  "arena release");
+}
+
+static void testPool(void)
+{
+	check(SPLMemoryPool::getSizeClass(1) == 64 && SPLMemoryPool::getSizeClass(4096) == 4096 && SPLMemoryPool::getSizeClass(4097) == 5120 &&
+		  SPLMemoryPool::getSizeClass(100 << 20) == (112 << 20) && SPLMemoryPool::getSizeClass(128 << 20) == (128 << 20), "size classes");
+	bool bounded = true;
+	for (SPLint64 n = 1; n < (SPLint64(1) << 34); n = n * 3 + 1)
+	{
+		const SPLint64 c = SPLMemoryPool::getSizeClass(n);
+		bounded = bounded && c >= n && (n < 4096 || c <= n + n / 4 + 1);
+	}
+	check(bounded, "waste of the size classes");
+
+	SPLMemoryPool pool;
+	const SPLMemoryStats s0 = splMemoryGetStats();
+	SPLvoidp a = pool.allocate(100000);
+	pool.deallocate(a);
+	SPLvoidp b = pool.allocate(99000);
+	SPLvoidp c = pool.allocate(99000);
+	const SPLMemoryStats s1 = splMemoryGetStats();
+	check(a == b && c != b && aligned(c, SPL_SIMD_ALIGNMENT) && s1.poolHits == s0.poolHits + 1 && s1.poolMisses == s0.poolMisses + 2,
+		  "recycled buffer");
+	pool.deallocate(b);
+	pool.deallocate(c);
+	check(pool.getCached() == 2 * SPLMemoryPool::getSizeClass(100000) && splMemoryGetStats().poolCached == s0.poolCached + pool.getCached(),
+		  "cached buffers");
+	pool.setLimit(SPLMemoryPool::getSizeClass(100000));
+	check(pool.getCached() == SPLMemoryPool::getSizeClass(100000) && pool.getLimit() == SPLMemoryPool::getSizeClass(100000), "limit");
+	pool.trim();
+	check(pool.getCached() == 0 && splMemoryGetStats().bytes == s0.bytes, "trim");
+
+	// grids return their memory to the pool and get it zeroed again
+	pool.setLimit(-1);
+	const SPLuint8 *data = 0;
+	{
+		SPLGrid<SPLuint8> g;
+		check(g.resize(SPLVector3i(50, 40, 30), SPL_GRID_BRICKED, 4, pool) && !g.isExternal(), "grid of a pool");
+		g(1, 2, 3) = 7;
+		data = g.getData();
+		SPLGrid<SPLuint8> h(g);
+		check(h(1, 2, 3) == 7 && h.getData() != data, "copy of a grid of a pool");
+	}
+	SPLGrid<SPLuint8> g;
+	g.resize(SPLVector3i(40, 50, 30), SPL_GRID_BRICKED, 4, pool);
+	check(g.getData() == data && g(1, 2, 3) == 0 && pool.getCached() == 0, "grid recycled");
+	g.resize(SPLVector3i(3, 3, 3));
+	check(pool.getCached() == SPLMemoryPool::getSizeClass(SPLGrid<SPLuint8>::getStorageSize(SPLVector3i(40, 50, 30), SPL_GRID_BRICKED, 4)),
+		  "grid returned");
+}
+
+// time of a pipeline in seconds
+template <class F>
+static double timing(F f)
+{
+	const std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+	f();
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+static void testTiming(void)
+{
+	// stages with a volume sized scratch grid each
+	const SPLVector3i n(256, 256, 128);
+	const SPLindex stages = 16;
+	SPLGrid<SPLieee32> volume(n);
+	SPLMemoryPool pool;
+	double sum = 0.0;
+	const double t0 = timing([&]()
+	{
+		for (SPLindex s = 0; s < stages; s++)
+		{
+			SPLGrid<SPLieee32> tmp(n);
+			tmp(s, 1, 2) = volume(s, 2, 1) + 1.0f;
+			sum += tmp(s, 1, 2);
+		}
+	});
+	const double t1 = timing([&]()
+	{
+		for (SPLindex s = 0; s < stages; s++)
+		{
+			SPLGrid<SPLieee32> tmp;
+			tmp.resize(n, SPL_GRID_LINEAR, 8, pool);
+			tmp(s, 1, 2) = volume(s, 2, 1) + 1.0f;
+			sum += tmp(s, 1, 2);
+		}
+	});
+	const SPLMemoryStats s = splMemoryGetStats();
+	printf("allocator: 16 stages of 32 MB system %.3f s, pool %.3f s, peak %lld MB, pool hits %lld (%g)\n", t0, t1,
+		   (long long)(s.peak >> 20), (long long)s.poolHits, sum);
+}
+
+int main(void)
+{
+	testAlloc();
+	testOptions();
+	testArena();
+	testPool();
+	testTiming();
+
+	printf("allocator: %s\n", failures ? "failed" : "passed");
+	return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,770 @@
+// main.cu: Microbenchmarks of the SPL math types (spl_bench).
+//
+// Measures the throughput (ns, TSC cycles and GB/s per element) of every
+// SPLVector3 operation for SPLint32, SPLieee32 and SPLieee64, for the AoS
+// (SPLVector3), padded AoS (SPLVector3a, SPLVector4) and SoA (SPLVector3Array)
+// layouts and for 1 to N threads, plus the latency of a dependent chain of
+// each operation, the neighborhood sampling along x, y and z of a grid in
+// the linear and bricked layouts, and the direct, spectral and automatic
+// convolution of the grid (per voxel). The results can be written as JSON and
+// compared against a stored baseline:
+//
+//   spl_bench [--quick] [--n N] [--threads T] [--filter S]
+//             [--json FILE] [--baseline FILE] [--tolerance X]
+//
+// The exit code is 1 if an operation is slower than the baseline by more
+// than the tolerance (default 0.25, i.e. 25%), or if the baseline has been
+// measured with another SIMD level. A baseline of another processor or
+// number of elements is compared with a warning.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__)
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#include <x86intrin.h>
+#endif
+#define SPL_BENCH_TSC
+#endif
+
+#include <spl/vector3array.hh>
+#include <spl/vector3a.hh>
+#include <spl/vector4.hh>
+#include <spl/grid.hh>
+#include <spl/threadpool.hh>
+#include <spl/fft.hh>
+
+/************************************************************************************************
+ ** Timing
+ ************************************************************************************************/
+static inline SPLuint64 ticks(void)
+{
+#ifdef SPL_BENCH_TSC
+	return SPLuint64(__rdtsc());
+#else
+	return 0;
+#endif
+}
+
+struct Timing
+{
+	double seconds;	//!< Wall time.
+	double cycles;	//!< TSC cycles (0 if unavailable).
+};
+
+// best of several runs, i.e. the least disturbed one
+template <class F>
+static Timing measure(const int repeat, F f)
+{
+	Timing best = { 1.0e30, 0.0 };
+	f();	// warm up caches and page tables
+	for (int r = 0; r < repeat; r++)
+	{
+		const SPLuint64 c0 = ticks();
+		const std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+		f();
+		const std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+		const SPLuint64 c1 = ticks();
+		const double s = std::chrono::duration<double>(t1 - t0).count();
+		if (s < best.seconds)
+		{
+			best.seconds = s;
+			best.cycles = double(c1 - c0);
+		}
+	}
+	return best;
+}
+
+/************************************************************************************************
+ ** Benchmark cases
+ ************************************************************************************************/
+struct Result
+{
+	std::string op;
+	std::string type;
+	std::string layout;
+	int threads;
+	double nsPerElement;
+	double cyclesPerElement;
+	double gbPerSecond;
+	double latencyNs;	//!< Latency of a dependent operation (-1 if not measured).
+};
+
+struct Case
+{
+	std::string op;
+	std::string type;
+	std::string layout;
+	double bytes;	//!< Bytes read and written per element.
+	std::function<void(SPLint64, SPLint64)> run;	//!< Processes the elements [first, last).
+	std::function<double(SPLint64)> latency;		//!< Runs a dependent chain, returns a sink value.
+	std::function<void(SPLThreadPool &)> pass;		//!< Processes all elements with the threads at once (instead of run).
+	double elements;	//!< Number of elements of pass.
+};
+
+template <class T>
+struct Data
+{
+	explicit Data(const SPLsizei n) : a(n), b(n), c(n), a3(n), b3(n), c3(n), a4(n), b4(n), c4(n), ci(n), out(n), A(n), B(n), C(n), I(n)
+	{
+		for (SPLindex i = 0; i < n; i++)
+		{
+			a[i] = SPLVector3<T>(T(1 + i % 13), T(2 + i % 7), T(3 + i % 5));
+			b[i] = SPLVector3<T>(T(1 + i % 3), T(1 + i % 11), T(2 + i % 17));
+			a3[i] = SPLVector3a<T>(a[i]);
+			b3[i] = SPLVector3a<T>(b[i]);
+			a4[i] = SPLVector4<T>(a[i], T(1));
+			b4[i] = SPLVector4<T>(b[i], T(1));
+		}
+		A.fromAoS(&a[0]);
+		B.fromAoS(&b[0]);
+		C.fromAoS(&a[0]);
+	}
+
+	// the operands a, b and the results c of the vector type V
+	template <class V>
+	struct Operands
+	{
+		std::vector<V> *a, *b, *c;
+	};
+	Operands<SPLVector3<T> > get(const SPLVector3<T> *) { return Operands<SPLVector3<T> >{ &a, &b, &c }; }
+	Operands<SPLVector3a<T> > get(const SPLVector3a<T> *) { return Operands<SPLVector3a<T> >{ &a3, &b3, &c3 }; }
+	Operands<SPLVector4<T> > get(const SPLVector4<T> *) { return Operands<SPLVector4<T> >{ &a4, &b4, &c4 }; }
+
+	std::vector<SPLVector3<T> > a, b, c;
+	std::vector<SPLVector3a<T> > a3, b3, c3;
+	std::vector<SPLVector4<T> > a4, b4, c4;
+	std::vector<SPLVector3i> ci;
+	std::vector<T> out;
+	SPLVector3Array<T> A, B, C;
+	SPLVector3Arrayi I;
+};
+
+static volatile double sink;	// keeps the results of the latency chains alive
+
+// hides the value from the optimizer, i.e. a dependent chain cannot be folded
+template <class T>
+static inline void opaque(T &x)
+{
+#if defined(SPL_BENCH_TSC) && defined(__GNUC__)
+	if constexpr (std::is_floating_point<T>::value && sizeof(T) <= 8)
+	{
+		__asm__ volatile("" : "+x"(x));
+	}
+	else
+	{
+		__asm__ volatile("" : "+r"(x));
+	}
+#else
+	volatile T y = x;
+	x = y;
+#endif
+}
+
+// hides a vector, a padded SPLieee32 vector as one register
+template <class V>
+static inline void opaqueVector(V &v)
+{
+#if defined(SPL_BENCH_TSC) && defined(__GNUC__) && defined(SPL_SIMD4_SSE)
+	if constexpr (sizeof(V) == sizeof(SPLSimd4f::Type) && std::is_same<decltype(v.x), SPLieee32>::value)
+	{
+		SPLSimd4f::Type r = SPLSimd4f::load(&v.x);
+		__asm__ volatile("" : "+x"(r));
+		SPLSimd4f::store(&v.x, r);
+		return;
+	}
+#endif
+	opaque(v.x);
+	opaque(v.y);
+	opaque(v.z);
+}
+
+template <class V>
+static inline V make(const SPLVector3<decltype(V().x)> &v)
+{
+	if constexpr (std::is_same<V, SPLVector3<decltype(V().x)> >::value)
+	{
+		return v;
+	}
+	else
+	{
+		return V(v);
+	}
+}
+
+template <class V> struct Layout;
+template <class T> struct Layout<SPLVector3<T> > { static const char *name(void) { return "AoS"; } };
+template <class T> struct Layout<SPLVector3a<T> > { static const char *name(void) { return "AoS3a"; } };
+template <class T> struct Layout<SPLVector4<T> > { static const char *name(void) { return "AoS4"; } };
+
+template <class T, class V, class R>
+static inline void store(Data<T> &d, V *c, const SPLindex i, const R &r)
+{
+	if constexpr (std::is_same<R, V>::value)
+	{
+		c[i] = r;
+	}
+	else if constexpr (std::is_same<R, SPLVector3i>::value)
+	{
+		d.ci[i] = r;
+	}
+	else
+	{
+		d.out[i] = T(r);
+	}
+}
+
+// feeds the result of an operation back into its operand
+template <class V, class R>
+static inline void feed(V &v, const R &r)
+{
+	typedef decltype(v.x) T;
+	if constexpr (std::is_same<R, V>::value)
+	{
+		v = r;
+	}
+	else if constexpr (std::is_same<R, SPLVector3i>::value)
+	{
+		v = make<V>(SPLVector3<T>(T(r.x), T(r.y), T(r.z)));
+	}
+	else
+	{
+		v.x = T(r);
+	}
+}
+
+// f(v, w, s) is one operation on the vectors v, w of type V and the scalar s
+template <class V, class T, class F>
+static void aos(std::vector<Case> &cases, Data<T> &d, const char *type, const char *op, const int reads, F f)
+{
+	const typename Data<T>::template Operands<V> v = d.get((const V *)0);
+	typedef decltype(f((*v.a)[0], (*v.b)[0], T(1))) R;
+	Case c;
+	c.op = op;
+	c.type = type;
+	c.layout = Layout<V>::name();
+	c.bytes = double(reads * sizeof(V) + sizeof(R));
+	Data<T> *p = &d;
+	const V *a = &(*v.a)[0], *b = &(*v.b)[0];
+	V *o = &(*v.c)[0];
+	c.run = [p, a, b, o, f](const SPLint64 first, const SPLint64 last)
+	{
+		const T s = T(1);
+		for (SPLindex i = SPLindex(first); i < SPLindex(last); i++)
+		{
+			store(*p, o, i, f(a[i], b[i], s));
+		}
+	};
+	// (1,0,0) and (0,0,1) keep every chain bounded, e.g. the cross product rotates
+	c.latency = [f](const SPLint64 iterations)
+	{
+		V v = make<V>(SPLVector3<T>(T(1), T(0), T(0))), w = make<V>(SPLVector3<T>(T(0), T(0), T(1)));
+		const T s = T(sink >= 0.0 ? 1 : 2);
+		for (SPLint64 k = 0; k < iterations; k++)
+		{
+			feed(v, f(v, w, s));
+			opaqueVector(v);
+		}
+		return double(v.x) + double(v.y) + double(v.z);
+	};
+	cases.push_back(c);
+}
+
+// f(V, A, B, first, count) is one batch operation on views
+template <class T, class F>
+static void soa(std::vector<Case> &cases, Data<T> &d, const char *type, const char *op, const double bytes, F f)
+{
+	Case c;
+	c.op = op;
+	c.type = type;
+	c.layout = "SoA";
+	c.bytes = bytes;
+	Data<T> *p = &d;
+	c.run = [p, f](const SPLint64 first, const SPLint64 last)
+	{
+		f(*p, SPLindex(first), SPLsizei(last - first));
+	};
+	cases.push_back(c);
+}
+
+template <class T>
+static void addCases(std::vector<Case> &cases, Data<T> &d, const char *type)
+{
+	typedef SPLVector3<T> V;
+	const bool real = !std::numeric_limits<T>::is_integer;
+	const double v = double(sizeof(V)), t = double(sizeof(T));
+
+	aos<V>(cases, d, type, "construct", 1, [](const V &a, const V &, const T) { return V(a.z, a.y, a.x); });
+	aos<V>(cases, d, type, "compare", 2, [](const V &a, const V &b, const T) { return a == b; });
+	aos<V>(cases, d, type, "negate", 1, [](const V &a, const V &, const T) { return -a; });
+	aos<V>(cases, d, type, "add", 2, [](const V &a, const V &b, const T) { return a + b; });
+	aos<V>(cases, d, type, "sub", 2, [](const V &a, const V &b, const T) { return a - b; });
+	aos<V>(cases, d, type, "scale", 1, [](const V &a, const V &, const T s) { return a * s; });
+	aos<V>(cases, d, type, "divide", 1, [](const V &a, const V &, const T s) { return a / s; });
+	aos<V>(cases, d, type, "add_assign", 2, [](const V &a, const V &b, const T) { V r(a); r += b; return r; });
+	aos<V>(cases, d, type, "dot", 2, [](const V &a, const V &b, const T) { return a * b; });
+	aos<V>(cases, d, type, "cross", 2, [](const V &a, const V &b, const T) { return a.crossProduct(b); });
+	aos<V>(cases, d, type, "square", 1, [](const V &a, const V &, const T) { return a.square(); });
+	aos<V>(cases, d, type, "length", 1, [](const V &a, const V &, const T) { return a.length(); });
+	if (real)
+	{
+		aos<V>(cases, d, type, "normalize", 1, [](const V &a, const V &, const T) { return a.getNormalized(); });
+		aos<V>(cases, d, type, "normalize_fast", 1, [](const V &a, const V &, const T) { return a.template getNormalized<SPLPrecisionFast>(); });
+	}
+	aos<V>(cases, d, type, "floor", 1, [](const V &a, const V &, const T) { return a.getFLOORint(); });
+	aos<V>(cases, d, type, "round", 1, [](const V &a, const V &, const T) { return a.getROUNDint(); });
+	aos<V>(cases, d, type, "ceil", 1, [](const V &a, const V &, const T) { return a.getCEILint(); });
+
+	if constexpr (!std::numeric_limits<T>::is_integer)
+	{
+		typedef SPLVector3a<T> A;
+		aos<A>(cases, d, type, "negate", 1, [](const A &a, const A &, const T) { return -a; });
+		aos<A>(cases, d, type, "add", 2, [](const A &a, const A &b, const T) { return a + b; });
+		aos<A>(cases, d, type, "sub", 2, [](const A &a, const A &b, const T) { return a - b; });
+		aos<A>(cases, d, type, "scale", 1, [](const A &a, const A &, const T s) { return a * s; });
+		aos<A>(cases, d, type, "dot", 2, [](const A &a, const A &b, const T) { return a * b; });
+		aos<A>(cases, d, type, "cross", 2, [](const A &a, const A &b, const T) { return a.crossProduct(b); });
+		aos<A>(cases, d, type, "length", 1, [](const A &a, const A &, const T) { return a.length(); });
+		aos<A>(cases, d, type, "normalize", 1, [](const A &a, const A &, const T) { return a.getNormalized(); });
+		aos<A>(cases, d, type, "normalize_fast", 1, [](const A &a, const A &, const T) { return a.template getNormalized<SPLPrecisionFast>(); });
+
+		typedef SPLVector4<T> W;
+		aos<W>(cases, d, type, "add", 2, [](const W &a, const W &b, const T) { return a + b; });
+		aos<W>(cases, d, type, "scale", 1, [](const W &a, const W &, const T s) { return a * s; });
+		aos<W>(cases, d, type, "dot", 2, [](const W &a, const W &b, const T) { return a * b; });
+	}
+
+	soa(cases, d, type, "add", 3 * v, [](Data<T> &d, const SPLindex i, const SPLsizei n) { d.C.getView(i, n).add(d.A.getView(i, n), d.B.getView(i, n)); });
+	soa(cases, d, type, "sub", 3 * v, [](Data<T> &d, const SPLindex i, const SPLsizei n) { d.C.getView(i, n).sub(d.A.getView(i, n), d.B.getView(i, n)); });
+	soa(cases, d, type, "scale", 2 * v, [](Data<T> &d, const SPLindex i, const SPLsizei n) { d.C.getView(i, n).scale(d.A.getView(i, n), T(1)); });
+	soa(cases, d, type, "dot", 2 * v + t, [](Data<T> &d, const SPLindex i, const SPLsizei n) { d.A.getView(i, n).dotProduct(d.B.getView(i, n), &d.out[i]); });
+	soa(cases, d, type, "cross", 3 * v, [](Data<T> &d, const SPLindex i, const SPLsizei n) { d.C.getView(i, n).crossProduct(d.A.getView(i, n), d.B.getView(i, n)); });
+	soa(cases, d, type, "fused_expr", 4 * v, [](Data<T> &d, const SPLindex i, const SPLsizei n)
+	{
+		d.C.getView(i, n).assign(splExpr(d.A.getView(i, n)) + splExpr(d.B.getView(i, n)) * T(1) - splExpr(d.A.getView(i, n)));
+	});
+	if constexpr (!std::numeric_limits<T>::is_integer)
+	{
+		soa(cases, d, type, "length", v + t, [](Data<T> &d, const SPLindex i, const SPLsizei n) { d.A.getView(i, n).length(&d.out[i]); });
+		soa(cases, d, type, "normalize", 2 * v, [](Data<T> &d, const SPLindex i, const SPLsizei n) { d.C.getView(i, n).normalize(); });
+		soa(cases, d, type, "normalize_fast", 2 * v, [](Data<T> &d, const SPLindex i, const SPLsizei n) { d.C.getView(i, n).template normalize<SPLPrecisionFast>(); });
+	}
+	soa(cases, d, type, "floor", v + 3.0 * sizeof(SPLint32), [](Data<T> &d, const SPLindex i, const SPLsizei n)
+	{
+		SPLVector3ArrayView<SPLint32> I = d.I.getView(i, n);
+		d.A.getView(i, n).getFLOORint(I);
+	});
+}
+
+// element e is the (e % edge)-th sample of the line e / edge along the axis, which
+// reads a 7 point neighborhood, i.e. the access pattern of a ray caster or filter
+static void addGridCases(std::vector<Case> &cases, const SPLGridf &g, const char *layout, std::vector<SPLieee32> &out)
+{
+	static const char *ops[] = { "walk_x", "walk_y", "walk_z" };
+	for (SPLindex axis = 0; axis < 3; axis++)
+	{
+		Case c;
+		c.op = ops[axis];
+		c.type = "SPLieee32";
+		c.layout = layout;
+		c.bytes = 8.0 * sizeof(SPLieee32);
+		const SPLGridf *p = &g;
+		SPLieee32 *o = &out[0];
+		c.run = [p, o, axis](const SPLint64 first, const SPLint64 last)
+		{
+			// the edge is a power of 2
+			SPLindex shift = 0;
+			while ((1 << shift) < p->getSize().x)
+			{
+				shift++;
+			}
+			const SPLint64 mask = (SPLint64(1) << shift) - 1;
+			const SPLint64 *ox = p->getOffsets(0), *oy = p->getOffsets(1), *oz = p->getOffsets(2);
+			const SPLieee32 *v = p->getData();
+			for (SPLint64 e = first; e < last; e++)
+			{
+				const SPLindex t = SPLindex(e & mask), u = SPLindex((e >> shift) & mask), w = SPLindex((e >> (2 * shift)) & mask);
+				const SPLindex x = (axis == 0) ? t : u, y = (axis == 1) ? t : (axis == 0 ? u : w), z = (axis == 2) ? t : w;
+				const SPLint64 i = ox[x] + oy[y] + oz[z];
+				o[e] = v[i] + v[ox[x - 1] + oy[y] + oz[z]] + v[ox[x + 1] + oy[y] + oz[z]]
+					+ v[ox[x] + oy[y - 1] + oz[z]] + v[ox[x] + oy[y + 1] + oz[z]]
+					+ v[ox[x] + oy[y] + oz[z - 1]] + v[ox[x] + oy[y] + oz[z + 1]];
+			}
+		};
+		cases.push_back(c);
+	}
+}
+
+// the convolution of a grid with cubic kernels by every method
+static void addConvolutionCases(std::vector<Case> &cases, const SPLGridf &g, SPLGridf &out)
+{
+	static const SPLenum methods[3] = { SPL_CONVOLUTION_DIRECT, SPL_CONVOLUTION_SPECTRAL, SPL_CONVOLUTION_AUTO };
+	static const char *names[3] = { "direct", "spectral", "auto" };
+	const SPLsizei sizes[3] = { 3, 5, 9 };
+	for (SPLindex i = 0; i < 3; i++)
+	{
+		std::shared_ptr<SPLGridf> k(new SPLGridf(SPLVector3i(sizes[i], sizes[i], sizes[i])));
+		k->fill(1.0f / SPLieee32(sizes[i] * sizes[i] * sizes[i]));
+		for (SPLindex m = 0; m < 3; m++)
+		{
+			Case c;
+			c.op = "conv" + std::to_string(sizes[i]) + "_" + names[m];
+			c.type = "SPLieee32";
+			c.layout = "Grid";
+			c.bytes = 2.0 * sizeof(SPLieee32);
+			const SPLGridf *p = &g;
+			SPLGridf *o = &out;
+			const SPLenum method = methods[m];
+			c.pass = [p, o, k, method](SPLThreadPool &pool) { splConvolve(*p, *k, *o, SPL_BORDER_CLAMP, method, pool); };
+			c.elements = double(g.getSize().x) * g.getSize().y * g.getSize().z;
+			cases.push_back(c);
+		}
+	}
+}
+
+/************************************************************************************************
+ ** JSON output and baseline comparison
+ ************************************************************************************************/
+static const char *simdName(void)
+{
+#if defined(SPL_SIMD_AVX512)
+	return "AVX-512";
+#elif defined(SPL_SIMD_AVX2)
+	return "AVX2";
+#else
+	return "scalar";
+#endif
+}
+
+static std::string cpuName(void)
+{
+	// the brand string of the processor
+	unsigned int regs[12] = {0};
+#if defined(SPL_BENCH_TSC) && defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 0x80000000);
+	if (unsigned(info[0]) < 0x80000004u)
+	{
+		return "unknown";
+	}
+	for (int i = 0; i < 3; i++)
+	{
+		__cpuid((int *)(regs + 4 * i), 0x80000002 + i);
+	}
+#elif defined(SPL_BENCH_TSC)
+	if (__get_cpuid_max(0x80000000u, 0) < 0x80000004u)
+	{
+		return "unknown";
+	}
+	for (unsigned int i = 0; i < 3; i++)
+	{
+		__get_cpuid(0x80000002u + i, regs + 4 * i, regs + 4 * i + 1, regs + 4 * i + 2, regs + 4 * i + 3);
+	}
+#else
+	return "unknown";
+#endif
+	char name[49];
+	memcpy(name, regs, 48);
+	name[48] = 0;
+	std::string n;
+	for (const char *c = name; *c != 0; c++)
+	{
+		// without quotes, and without leading and repeated spaces
+		if (*c != '"' && !(*c == ' ' && (n.empty() || n.back() == ' ')))
+		{
+			n += *c;
+		}
+	}
+	while (!n.empty() && n.back() == ' ')
+	{
+		n.pop_back();
+	}
+	return n.empty() ? "unknown" : n;
+}
+
+static std::string key(const Result &r)
+{
+	char buf[256];
+	snprintf(buf, sizeof(buf), "%s/%s/%s/%d", r.op.c_str(), r.type.c_str(), r.layout.c_str(), r.threads);
+	return buf;
+}
+
+static bool writeJSON(const char *file, const std::vector<Result> &results, const SPLsizei n)
+{
+	FILE *f = fopen(file, "w");
+	if (f == 0)
+	{
+		return false;
+	}
+	fprintf(f, "{\n  \"simd\": \"%s\",\n  \"cpu\": \"%s\",\n  \"elements\": %d,\n  \"results\": [\n", simdName(), cpuName().c_str(), n);
+	for (size_t i = 0; i < results.size(); i++)
+	{
+		const Result &r = results[i];
+		// one result per line, see readBaseline()
+		fprintf(f, "    {\"op\": \"%s\", \"type\": \"%s\", \"layout\": \"%s\", \"threads\": %d, "
+			"\"ns_per_element\": %.4f, \"cycles_per_element\": %.4f, \"gb_per_s\": %.3f, \"latency_ns\": %.4f}%s\n",
+			r.op.c_str(), r.type.c_str(), r.layout.c_str(), r.threads,
+			r.nsPerElement, r.cyclesPerElement, r.gbPerSecond, r.latencyNs, (i + 1 < results.size()) ? "," : "");
+	}
+	fprintf(f, "  ]\n}\n");
+	return fclose(f) == 0;
+}
+
+static bool field(const char *line, const char *name, char *value, const size_t size)
+{
+	char pattern[64];
+	snprintf(pattern, sizeof(pattern), "\"%s\": ", name);
+	const char *p = strstr(line, pattern);
+	if (p == 0)
+	{
+		return false;
+	}
+	p += strlen(pattern);
+	// a string ends at its quote, a number at the next separator
+	const bool quoted = (*p == '"');
+	if (quoted)
+	{
+		p++;
+	}
+	size_t k = 0;
+	while (*p != 0 && *p != '"' && (quoted || (*p != ',' && *p != '}')) && k + 1 < size)
+	{
+		value[k++] = *p++;
+	}
+	value[k] = 0;
+	return true;
+}
+
+// the measurements of a baseline and how they were taken
+struct Baseline
+{
+	std::string simd, cpu;
+	SPLsizei elements;
+	std::vector<Result> results;
+};
+
+static bool readBaseline(const char *file, Baseline &baseline)
+{
+	FILE *f = fopen(file, "r");
+	if (f == 0)
+	{
+		return false;
+	}
+	char line[1024], op[64], type[64], layout[64], threads[16], ns[32], value[128];
+	baseline.simd = baseline.cpu = "unknown";
+	baseline.elements = 0;
+	while (fgets(line, sizeof(line), f) != 0)
+	{
+		if (field(line, "simd", value, sizeof(value)))
+		{
+			baseline.simd = value;
+		}
+		else if (field(line, "cpu", value, sizeof(value)))
+		{
+			baseline.cpu = value;
+		}
+		else if (field(line, "elements", value, sizeof(value)))
+		{
+			baseline.elements = atoi(value);
+		}
+		else if (field(line, "op", op, sizeof(op)) && field(line, "type", type, sizeof(type)) &&
+			field(line, "layout", layout, sizeof(layout)) && field(line, "threads", threads, sizeof(threads)) &&
+			field(line, "ns_per_element", ns, sizeof(ns)))
+		{
+			Result r;
+			r.op = op;
+			r.type = type;
+			r.layout = layout;
+			r.threads = atoi(threads);
+			r.nsPerElement = atof(ns);
+			baseline.results.push_back(r);
+		}
+	}
+	fclose(f);
+	return true;
+}
+
+// returns the number of regressions, or -1 if the baseline is of another SIMD level
+static int compare(const std::vector<Result> &results, const Baseline &b, const SPLsizei n, const double tolerance)
+{
+	// another SIMD level runs other code, another processor or size shifts all timings
+	if (b.simd != simdName())
+	{
+		printf("the baseline has been measured with SIMD %s, this build uses %s: not compared\n", b.simd.c_str(), simdName());
+		return -1;
+	}
+	if (b.cpu != cpuName())
+	{
+		printf("WARNING: the baseline has been measured on \"%s\", this is \"%s\"\n", b.cpu.c_str(), cpuName().c_str());
+	}
+	if (b.elements != n)
+	{
+		printf("WARNING: the baseline has been measured with %d elements, this run uses %d\n", b.elements, n);
+	}
+	const std::vector<Result> &baseline = b.results;
+	int regressions = 0, compared = 0;
+	for (size_t i = 0; i < results.size(); i++)
+	{
+		for (size_t j = 0; j < baseline.size(); j++)
+		{
+			if (key(results[i]) != key(baseline[j]) || baseline[j].nsPerElement <= 0.0)
+			{
+				continue;
+			}
+			compared++;
+			const double ratio = results[i].nsPerElement / baseline[j].nsPerElement;
+			if (ratio > 1.0 + tolerance)
+			{
+				printf("REGRESSION %-40s %8.3f ns -> %8.3f ns (%+.0f%%)\n", key(results[i]).c_str(),
+					baseline[j].nsPerElement, results[i].nsPerElement, 100.0 * (ratio - 1.0));
+				regressions++;
+			}
+		}
+	}
+	printf("compared %d results against the baseline, %d regressions\n", compared, regressions);
+	return regressions;
+}
+
+/************************************************************************************************
+ ** Main
+ ************************************************************************************************/
+int main(int argc, char **argv)
+{
+	SPLsizei n = 1 << 20, maxThreads = SPLThreadPool::getGlobal().getNumThreads();
+	int repeat = 7;
+	SPLint64 chain = 1 << 22;
+	const char *json = 0, *baselineFile = 0, *filter = 0;
+	double tolerance = 0.25;
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--quick") == 0)
+		{
+			n = 1 << 14;
+			repeat = 2;
+			chain = 1 << 14;
+		}
+		else if (strcmp(argv[i], "--n") == 0 && i + 1 < argc) n = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) maxThreads = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc) filter = argv[++i];
+		else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) json = argv[++i];
+		else if (strcmp(argv[i], "--baseline") == 0 && i + 1 < argc) baselineFile = argv[++i];
+		else if (strcmp(argv[i], "--tolerance") == 0 && i + 1 < argc) tolerance = atof(argv[++i]);
+		else
+		{
+			printf("usage: %s [--quick] [--n N] [--threads T] [--filter S] [--json FILE] [--baseline FILE] [--tolerance X]\n", argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+
+	Data<SPLint32> di(n);
+	Data<SPLieee32> df(n);
+	Data<SPLieee64> dd(n);
+	std::vector<Case> cases;
+	addCases(cases, di, "SPLint32");
+	addCases(cases, df, "SPLieee32");
+	addCases(cases, dd, "SPLieee64");
+
+	// cubic grids of about 2n voxels in both layouts
+	SPLindex edge = 16;
+	while (SPLint64(2 * edge) * (2 * edge) * (2 * edge) <= 2 * SPLint64(n))
+	{
+		edge *= 2;
+	}
+	SPLGridf linear(SPLVector3i(edge, edge, edge), SPL_GRID_LINEAR), bricked(SPLVector3i(edge, edge, edge), SPL_GRID_BRICKED, 8);
+	for (SPLGridf::Iterator it = linear.begin(); it != linear.end(); ++it)
+	{
+		*it = SPLieee32(it.getOffset() % 251);
+	}
+	std::vector<SPLieee32> voxels(size_t(linear.getStorageSize()));
+	linear.toLinear(&voxels[0]);
+	bricked.fromLinear(&voxels[0]);
+	addGridCases(cases, linear, "Grid", df.out);
+	addGridCases(cases, bricked, "Brick8", df.out);
+	SPLGridf convolved;
+	addConvolutionCases(cases, linear, convolved);
+
+	std::vector<SPLsizei> threads;
+	for (SPLsizei t = 1; t < maxThreads; t *= 2)
+	{
+		threads.push_back(t);
+	}
+	threads.push_back(MAX(maxThreads, 1));
+
+	printf("spl_bench: %d elements, SIMD %s, up to %d threads\n", n, simdName(), threads.back());
+	printf("%-16s %-10s %-4s %4s %10s %10s %10s %10s\n", "op", "type", "lay", "thr", "ns/elem", "cyc/elem", "GB/s", "lat ns");
+	std::vector<Result> results;
+	for (size_t k = 0; k < threads.size(); k++)
+	{
+		SPLThreadPool pool(threads[k]);
+		for (size_t c = 0; c < cases.size(); c++)
+		{
+			const Case &bc = cases[c];
+			if (filter != 0 && strstr((bc.op + "/" + bc.type + "/" + bc.layout).c_str(), filter) == 0)
+			{
+				continue;
+			}
+			const double elements = bc.pass ? bc.elements : double(n);
+			const Timing t = measure(repeat, [&]()
+			{
+				if (bc.pass)
+				{
+					bc.pass(pool);
+				}
+				else
+				{
+					pool.parallelFor(0, n, pool.getGrain(n, 1024), bc.run);
+				}
+			});
+			Result r;
+			r.op = bc.op;
+			r.type = bc.type;
+			r.layout = bc.layout;
+			r.threads = pool.getNumThreads();
+			r.nsPerElement = 1.0e9 * t.seconds / elements;
+			r.cyclesPerElement = t.cycles / elements;
+			r.gbPerSecond = 1.0e-9 * bc.bytes * elements / t.seconds;
+			r.latencyNs = -1.0;
+			if (k == 0 && bc.latency)
+			{
+				double value = 0.0;
+				const Timing l = measure(1, [&]() { value = bc.latency(chain); });
+				sink = value;
+				r.latencyNs = 1.0e9 * l.seconds / double(chain);
+			}
+			printf("%-16s %-10s %-4s %4d %10.3f %10.3f %10.2f %10.3f\n", r.op.c_str(), r.type.c_str(), r.layout.c_str(),
+				r.threads, r.nsPerElement, r.cyclesPerElement, r.gbPerSecond, r.latencyNs);
+			results.push_back(r);
+		}
+	}
+
+	if (json != 0 && !writeJSON(json, results, n))
+	{
+		printf("cannot write %s\n", json);
+		return EXIT_FAILURE;
+	}
+	if (baselineFile != 0)
+	{
+		Baseline baseline;
+		if (!readBaseline(baselineFile, baseline))
+		{
+			printf("cannot read %s\n", baselineFile);
+			return EXIT_FAILURE;
+		}
+		if (compare(results, baseline, n, tolerance) != 0)
+		{
+			return EXIT_FAILURE;
+		}
+	}
+	return EXIT_SUCCESS;
+}
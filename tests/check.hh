@@ -0,0 +1,25 @@
+// check.hh: Failure counting shared by the tests.
+//
+// Each test is a single translation unit which includes this header once,
+// calls check() for every expectation and returns EXIT_FAILURE when
+// failures is not zero.
+
+#ifndef _spl_tests_check_hh_
+#define _spl_tests_check_hh_
+
+#include <stdio.h>
+
+static int failures = 0;
+
+#define check(ok, what) checkLine(ok, what, __LINE__)
+
+static void checkLine(const bool ok, const char *what, const int line)
+{
+	if (!ok)
+	{
+		printf("FAILED: %s (line %d)\n", what, line);
+		failures++;
+	}
+}
+
+#endif
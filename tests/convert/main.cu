@@ -0,0 +1,168 @@
+// main.cu: Tests of the type dispatch and the conversions between storage types.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <chrono>
+#include <vector>
+
+#include <spl/convert.hh>
+
+#include "../check.hh"
+
+static void testDispatch(void)
+{
+	// every dispatched type maps back to its identification number
+	SPLsizei count = 0;
+	SPLenum last = SPL_TYPE_MIN;
+	bool mapped = true;
+	splForEachType([&](auto tag)
+	{
+		typedef typename decltype(tag)::Type T;
+		mapped = mapped && SPLTypeId<T>::value > last && splGetTypeSize(SPLTypeId<T>::value) == SPLsizei(sizeof(T));
+		last = SPLTypeId<T>::value;
+		count++;
+	});
+	check(count == 14 && mapped, "dispatched types");
+	check(splGetTypeSize(SPL_TYPE_UINT16) == 2 && splGetTypeSize(SPL_TYPE_VOIDP) == 0 && splGetTypeSize(SPL_GRID_LINEAR) == 0, "type sizes");
+
+	SPLenum a = SPL_TYPE_MIN, b = SPL_TYPE_MIN;
+	check(splDispatchTypes(SPL_TYPE_INT16, SPL_TYPE_IEEE64, [&](auto ta, auto tb)
+	{
+		a = SPLTypeId<typename decltype(ta)::Type>::value;
+		b = SPLTypeId<typename decltype(tb)::Type>::value;
+	}) && a == SPL_TYPE_INT16 && b == SPL_TYPE_IEEE64, "pair of types");
+	check(!splDispatchTypes(SPL_TYPE_INT16, SPL_TYPE_RGBA8, [&](auto, auto) {}), "unknown type");
+}
+
+// values around and beyond the ranges of all types
+static std::vector<SPLieee64> values(void)
+{
+	std::vector<SPLieee64> v;
+	const SPLieee64 special[] = { 0.0, 0.5, 1.5, 2.5, -0.5, -1.5, 127.4, 127.6, 128.0, 255.5, 256.0, -128.5, -129.0, 32767.5,
+								  65535.4, 65536.0, -32768.6, 1.0e10, -1.0e10 };
+	v.assign(special, special + sizeof(special) / sizeof(special[0]));
+	srand(4);
+	for (SPLindex i = 0; i < 1000; i++)
+	{
+		v.push_back((SPLieee64(rand()) / RAND_MAX - 0.3) * ((i % 3 == 0) ? 300.0 : 70000.0));
+	}
+	return v;
+}
+
+template <class S, class D>
+static bool testPair(const SPLieee64 scale, const SPLieee64 offset, SPLThreadPool &pool)
+{
+	const std::vector<SPLieee64> v = values();
+	std::vector<S> src(v.size());
+	for (size_t i = 0; i < v.size(); i++)
+	{
+		src[i] = SPLConvertDetail::saturate<S>(v[i]);
+	}
+	std::vector<D> dst(v.size());
+	splConvert(&src[0], &dst[0], SPLint64(src.size()), scale, offset, pool);
+	for (size_t i = 0; i < v.size(); i++)
+	{
+		const bool single = SPLConvertDetail::Simd<S>::value && SPLConvertDetail::Simd<D>::value;
+		const D e = single ? SPLConvertDetail::saturate<D>(SPLieee32(src[i]) * SPLieee32(scale) + SPLieee32(offset)) :
+							 SPLConvertDetail::saturate<D>(SPLieee64(src[i]) * scale + offset);
+		if (!(dst[i] == e))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+static void testConversions(SPLThreadPool &pool)
+{
+	// all pairs with the conversion of a single element as reference
+	SPLsizei pairs = 0, correct = 0;
+	for (SPLenum s = SPL_TYPE_MIN + 1; s < SPL_TYPE_MAX; s++)
+	{
+		for (SPLenum d = SPL_TYPE_MIN + 1; d < SPL_TYPE_MAX; d++)
+		{
+			splDispatchTypes(s, d, [&](auto ts, auto td)
+			{
+				pairs++;
+				correct += testPair<typename decltype(ts)::Type, typename decltype(td)::Type>(0.75, 3.25, pool) ? 1 : 0;
+			});
+		}
+	}
+	check(pairs == 196 && correct == pairs, "conversions of all pairs");
+
+	// rounding ties to even and saturation
+	const SPLieee32 f[8] = { 0.5f, 1.5f, 2.5f, -3.0f, 254.5f, 255.5f, 300.0f, 1.0e9f };
+	SPLuint8 u[8];
+	SPLint16 s[8];
+	splConvert(f, u, 8, 1.0, 0.0, pool);
+	splConvert(f, s, 8, 100.0, 0.0, pool);
+	check(u[0] == 0 && u[1] == 2 && u[2] == 2 && u[3] == 0 && u[4] == 254 && u[5] == 255 && u[6] == 255 && u[7] == 255, "float to uint8");
+	check(s[0] == 50 && s[3] == -300 && s[5] == 25550 && s[6] == 30000 && s[7] == 32767, "float to int16");
+
+	// run-time types
+	std::vector<SPLuint16> raw(100);
+	std::vector<SPLieee64> hu(100);
+	for (size_t i = 0; i < raw.size(); i++)
+	{
+		raw[i] = SPLuint16(40 * i);
+	}
+	check(splConvert(&raw[0], SPL_TYPE_UINT16, &hu[0], SPL_TYPE_IEEE64, 100, 1.0, -1024.0, pool) && hu[3] == -904.0, "run-time types");
+	check(!splConvert(&raw[0], SPL_TYPE_UINT16, &hu[0], SPL_TYPE_VOIDP, 100, 1.0, 0.0, pool), "unknown run-time type");
+
+	// grids keep the layout
+	SPLGrid<SPLint16> g(SPLVector3i(13, 10, 6), SPL_GRID_BRICKED, 4);
+	for (SPLGrid<SPLint16>::Iterator it = g.begin(); it != g.end(); ++it)
+	{
+		const SPLVector3i &p = it.getPosition();
+		*it = SPLint16(p.x * 100 - p.y * 10 + p.z);
+	}
+	SPLGrid<SPLuint8> h;
+	check(splConvert(g, h, 0.25, 10.0, pool), "grid conversion");
+	check(h.getLayout() == SPL_GRID_BRICKED && h.getBrickSize() == 4 && h(12, 0, 5) == 255 && h(0, 9, 2) == 0 && h(2, 3, 1) == 53,
+		  "converted grid");
+}
+
+// time of a conversion in seconds
+template <class F>
+static double timing(F f)
+{
+	const std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+	f();
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+static void testTiming(SPLThreadPool &pool)
+{
+	const SPLint64 n = 1 << 24;
+	std::vector<SPLuint16> a(n);
+	std::vector<SPLieee32> b(n);
+	std::vector<SPLuint8> c(n);
+	for (SPLint64 i = 0; i < n; i++)
+	{
+		a[size_t(i)] = SPLuint16(i * 7);
+	}
+	const double t0 = timing([&]() { for (SPLint64 i = 0; i < n; i++) b[size_t(i)] = SPLieee32(a[size_t(i)]) * 0.5f + 1.0f; });
+	const double t1 = timing([&]() { splConvert(&a[0], &b[0], n, 0.5, 1.0, pool); });
+	const double t2 = timing([&]()
+	{
+		for (SPLint64 i = 0; i < n; i++)
+		{
+			c[size_t(i)] = SPLuint8(CLAMP(std::nearbyint(b[size_t(i)] * 0.01f), 0.0f, 255.0f));
+		}
+	});
+	const double t3 = timing([&]() { splConvert(&b[0], &c[0], n, 0.01, 0.0, pool); });
+	printf("convert: 16M uint16 to float loop %.3f s, splConvert %.3f s, float to uint8 loop %.3f s, splConvert %.3f s\n", t0, t1, t2, t3);
+}
+
+int main(void)
+{
+	SPLThreadPool pool(4);
+	testDispatch();
+	testConversions(pool);
+	testTiming(pool);
+
+	printf("convert: %s\n", failures ? "failed" : "passed");
+	return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,189 @@
+// main.cu: Tests of the separable convolution, box and recursive Gaussian filters.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <chrono>
+
+#include <spl/convolution.hh>
+
+#include "../check.hh"
+
+static const SPLenum borders[4] = { SPL_BORDER_CLAMP, SPL_BORDER_MIRROR, SPL_BORDER_WRAP, SPL_BORDER_ZERO };
+
+static void random(SPLGridf &g)
+{
+	srand(5);
+	for (SPLGridf::Iterator it = g.begin(); it != g.end(); ++it)
+	{
+		*it = SPLieee32(rand()) / RAND_MAX;
+	}
+}
+
+// the voxel of a coordinate outside the grid, or -1 for zero
+static SPLindex outside(SPLindex i, const SPLindex n, const SPLenum border)
+{
+	if (border == SPL_BORDER_ZERO)
+	{
+		return (i >= 0 && i < n) ? i : -1;
+	}
+	while (i < 0 || i >= n)
+	{
+		if (border == SPL_BORDER_CLAMP)
+		{
+			i = CLAMP(i, 0, n - 1);
+		}
+		else if (border == SPL_BORDER_WRAP)
+		{
+			i = (i < 0) ? i + n : i - n;
+		}
+		else
+		{
+			i = (i < 0) ? -i : 2 * (n - 1) - i;
+		}
+	}
+	return i;
+}
+
+// direct 3D convolution of one voxel
+static double convolve(const SPLGridf &g, const SPLConvolutionKernel *k, const SPLVector3i &p, const SPLenum border)
+{
+	const SPLVector3i &n = g.getSize();
+	double sum = 0.0;
+	for (SPLindex c = -k[2].getRadius(); c <= k[2].getRadius(); c++)
+	{
+		for (SPLindex b = -k[1].getRadius(); b <= k[1].getRadius(); b++)
+		{
+			for (SPLindex a = -k[0].getRadius(); a <= k[0].getRadius(); a++)
+			{
+				const SPLindex x = outside(p.x - a, n.x, border), y = outside(p.y - b, n.y, border), z = outside(p.z - c, n.z, border);
+				if (x >= 0 && y >= 0 && z >= 0)
+				{
+					sum += double(k[0][a]) * k[1][b] * k[2][c] * g(x, y, z);
+				}
+			}
+		}
+	}
+	return sum;
+}
+
+static void testSeparable(SPLThreadPool &pool)
+{
+	// the sizes are no multiple of the tiles
+	SPLGridf g(SPLVector3i(70, 9, 6), SPL_GRID_BRICKED, 4), out;
+	random(g);
+	std::vector<SPLieee32> taps(5);
+	for (SPLindex i = 0; i < 5; i++)
+	{
+		taps[size_t(i)] = SPLieee32(i + 1) / 15.0f;
+	}
+	const SPLConvolutionKernel k[3] = { SPLConvolutionKernel(taps), SPLConvolutionKernel::gaussian(1.0f, 1), SPLConvolutionKernel::box(4) };
+	for (SPLindex b = 0; b < 4; b++)
+	{
+		check(splConvolveSeparable(g, out, k[0], k[1], k[2], borders[b], pool), "convolution");
+		double worst = 0.0;
+		for (SPLGridf::Iterator it = out.begin(); it != out.end(); ++it)
+		{
+			worst = MAX(worst, fabs(*it - convolve(g, k, it.getPosition(), borders[b])));
+		}
+		check(worst < 1.0e-5, "direct convolution");
+	}
+	check(out.getSize() == g.getSize() && out.getLayout() == SPL_GRID_BRICKED && out.getBrickSize() == 4, "layout of the result");
+
+	// the identity skips axes, the input may be the output
+	SPLGridf h(g);
+	check(splConvolveSeparable(h, h, SPLConvolutionKernel(), SPLConvolutionKernel(), SPLConvolutionKernel(), SPL_BORDER_CLAMP, pool), "identity");
+	check(h(7, 3, 2) == g(7, 3, 2) && h(69, 8, 5) == g(69, 8, 5), "unchanged grid");
+}
+
+static void testGaussian(SPLThreadPool &pool)
+{
+	// the derivatives of a quadratic function
+	const SPLVector3i n(40, 40, 40);
+	SPLGrid<SPLuint16> q(n);
+	for (SPLGrid<SPLuint16>::Iterator it = q.begin(); it != q.end(); ++it)
+	{
+		const SPLVector3i &p = it.getPosition();
+		*it = SPLuint16(3 * p.x + (p.y - 20) * (p.y - 20) + 100);
+	}
+	SPLGridf dx, dyy;
+	check(splFilterGaussian(q, dx, SPLVector3f(1.5f, 1.5f, 1.5f), SPLVector3i(1, 0, 0), SPL_BORDER_CLAMP, pool), "first derivative");
+	check(splFilterGaussian(q, dyy, SPLVector3f(1.5f, 1.5f, 0.0f), SPLVector3i(0, 2, 0), SPL_BORDER_CLAMP, pool), "second derivative");
+	check(fabs(dx(20, 20, 20) - 3.0) < 1.0e-3 && fabs(dyy(20, 20, 20) - 2.0) < 1.0e-3, "derivatives of a quadratic function");
+
+	// the recursive filter approximates the sampled Gaussian, the last tile of rows is partial
+	SPLGridf g(SPLVector3i(96, 81, 24)), exact, fast;
+	random(g);
+	for (SPLindex b = 0; b < 8; b++)
+	{
+		const SPLieee32 s = (b < 4) ? 4.0f : SPL_CONVOLUTION_RECURSIVE_SIGMA;
+		const SPLConvolutionKernel k = SPLConvolutionKernel::gaussian(s);
+		splConvolveSeparable(g, exact, k, k, SPLConvolutionKernel(), borders[b % 4], pool);
+		check(splFilterGaussian(g, fast, SPLVector3f(s, s, 0.0f), SPLVector3i(0, 0, 0), borders[b % 4], pool), "recursive Gaussian");
+		double worst = 0.0;
+		for (SPLGridf::Iterator it = exact.begin(); it != exact.end(); ++it)
+		{
+			worst = MAX(worst, fabs(*it - fast[it.getPosition()]));
+		}
+		check(worst < 0.02, "recursive and sampled Gaussian");
+	}
+
+	// a constant grid stays constant with the clamped border
+	g.fill(2.0f);
+	check(splFilterRecursiveGaussian(g, fast, SPLVector3f(2.0f, 7.0f, 1.0f), SPL_BORDER_CLAMP, pool), "constant grid");
+	check(fabs(fast(0, 0, 0) - 2.0f) < 1.0e-4 && fabs(fast(95, 40, 23) - 2.0f) < 1.0e-4, "recursive Gaussian of a constant");
+}
+
+static void testBox(SPLThreadPool &pool)
+{
+	SPLGridf g(SPLVector3i(33, 20, 17)), box, direct;
+	random(g);
+	for (SPLindex b = 0; b < 4; b++)
+	{
+		check(splFilterBox(g, box, SPLVector3i(3, 2, 5), borders[b], pool), "box filter");
+		splConvolveSeparable(g, direct, SPLConvolutionKernel::box(3), SPLConvolutionKernel::box(2), SPLConvolutionKernel::box(5), borders[b], pool);
+		double worst = 0.0;
+		for (SPLGridf::Iterator it = box.begin(); it != box.end(); ++it)
+		{
+			worst = MAX(worst, fabs(*it - direct[it.getPosition()]));
+		}
+		check(worst < 1.0e-5, "running sums");
+	}
+}
+
+// time of a filter in seconds
+template <class F>
+static double timing(F f)
+{
+	const std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+	f();
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+static void testTiming(SPLThreadPool &pool)
+{
+	// printed only, the times depend on the build and the load of the machine
+	SPLGridf g(SPLVector3i(96, 96, 96)), out;
+	random(g);
+	const SPLConvolutionKernel k = SPLConvolutionKernel::gaussian(8.0f);
+	const double b2 = timing([&]() { splFilterBox(g, out, SPLVector3i(2, 2, 2), SPL_BORDER_CLAMP, pool); });
+	const double b16 = timing([&]() { splFilterBox(g, out, SPLVector3i(16, 16, 16), SPL_BORDER_CLAMP, pool); });
+	const double r2 = timing([&]() { splFilterRecursiveGaussian(g, out, SPLVector3f(2.0f, 2.0f, 2.0f), SPL_BORDER_CLAMP, pool); });
+	const double r8 = timing([&]() { splFilterRecursiveGaussian(g, out, SPLVector3f(8.0f, 8.0f, 8.0f), SPL_BORDER_CLAMP, pool); });
+	const double f8 = timing([&]() { splConvolveSeparable(g, out, k, k, k, SPL_BORDER_CLAMP, pool); });
+	printf("convolution: 96^3 box radius 2 %.3f s, radius 16 %.3f s, recursive sigma 2 %.3f s, sigma 8 %.3f s, sampled sigma 8 %.3f s\n",
+		   b2, b16, r2, r8, f8);
+}
+
+int main(void)
+{
+	SPLThreadPool pool(4);
+	testSeparable(pool);
+	testGaussian(pool);
+	testBox(pool);
+	testTiming(pool);
+
+	printf("convolution: %s\n", failures ? "failed" : "passed");
+	return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
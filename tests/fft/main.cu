@@ -0,0 +1,272 @@
+// main.cu: Tests of the fast Fourier transforms and the convolution by FFTs.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include <spl/fft.hh>
+
+#include "../check.hh"
+
+static const SPLenum borders[4] = { SPL_BORDER_CLAMP, SPL_BORDER_MIRROR, SPL_BORDER_WRAP, SPL_BORDER_ZERO };
+
+static void random(SPLGridf &g, const int seed)
+{
+	srand(seed);
+	for (SPLGridf::Iterator it = g.begin(); it != g.end(); ++it)
+	{
+		*it = SPLieee32(rand()) / RAND_MAX - 0.5f;
+	}
+}
+
+template <class T>
+static void testLine(const SPLsizei n, const double tolerance)
+{
+	std::vector<T> re(n), im(n), wr(n), wi(n);
+	std::vector<double> xr(n), xi(n);
+	srand(n);
+	for (SPLindex i = 0; i < n; i++)
+	{
+		re[i] = T(xr[i] = double(rand()) / RAND_MAX - 0.5);
+		im[i] = T(xi[i] = double(rand()) / RAND_MAX - 0.5);
+	}
+	const std::shared_ptr<const SPLFFTPlan<T> > plan = SPLFFTPlan<T>::get(n);
+	plan->forward(&re[0], &im[0], &wr[0], &wi[0]);
+
+	// the naive transform
+	double worst = 0.0;
+	for (SPLindex k = 0; k < n; k++)
+	{
+		double sr = 0.0, si = 0.0;
+		for (SPLindex j = 0; j < n; j++)
+		{
+			const double a = -2.0 * PI * double(j) * double(k) / n;
+			sr += xr[j] * cos(a) - xi[j] * sin(a);
+			si += xr[j] * sin(a) + xi[j] * cos(a);
+		}
+		worst = MAX(worst, MAX(fabs(sr - re[k]), fabs(si - im[k])));
+	}
+	check(worst < tolerance * n, "discrete Fourier transform");
+
+	// interleaved lines, the line l is scaled by l + 1 and a partial tile leaves out the last
+	const SPLsizei lanes = SPL_FFT_LANES - 3;
+	std::vector<T> lr(size_t(n) * SPL_FFT_LANES, T(0)), li(lr), vr(lr), vi(lr);
+	for (SPLindex j = 0; j < n; j++)
+	{
+		for (SPLindex l = 0; l < lanes; l++)
+		{
+			lr[size_t(j * SPL_FFT_LANES + l)] = T(xr[j] * (l + 1));
+			li[size_t(j * SPL_FFT_LANES + l)] = T(xi[j] * (l + 1));
+		}
+	}
+	plan->forwardLines(&lr[0], &li[0], &vr[0], &vi[0], lanes);
+	worst = 0.0;
+	for (SPLindex j = 0; j < n; j++)
+	{
+		for (SPLindex l = 0; l < lanes; l++)
+		{
+			worst = MAX(worst, MAX(fabs(lr[size_t(j * SPL_FFT_LANES + l)] - re[j] * (l + 1)), fabs(li[size_t(j * SPL_FFT_LANES + l)] - im[j] * (l + 1))));
+		}
+	}
+	check(worst < tolerance * n * lanes, "interleaved lines");
+
+	plan->inverse(&re[0], &im[0], &wr[0], &wi[0]);
+	worst = 0.0;
+	for (SPLindex i = 0; i < n; i++)
+	{
+		worst = MAX(worst, MAX(fabs(re[i] / n - xr[i]), fabs(im[i] / n - xi[i])));
+	}
+	check(worst < tolerance * 4, "inverse transform");
+}
+
+static void testPlans(void)
+{
+	const SPLsizei sizes[] = { 1, 2, 3, 4, 5, 8, 12, 45, 60, 64, 100, 243, 1000 };
+	for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+	{
+		testLine<SPLieee32>(sizes[i], 1.0e-6);
+		testLine<SPLieee64>(sizes[i], 1.0e-14);
+	}
+	check(SPLFFTPlan<SPLieee32>::isSupported(360) && !SPLFFTPlan<SPLieee32>::isSupported(7) && !SPLFFTPlan<SPLieee32>::isSupported(0),
+		  "supported sizes");
+	check(SPLFFTPlan<SPLieee32>::getGoodSize(7) == 8 && SPLFFTPlan<SPLieee32>::getGoodSize(131) == 135 &&
+		  SPLFFTPlan<SPLieee32>::getGoodSize(1) == 1, "good sizes");
+
+	// the cache returns the same plan
+	const SPLsizei cached = SPLFFTPlan<SPLieee32>::getCacheSize();
+	check(SPLFFTPlan<SPLieee32>::get(60).get() == SPLFFTPlan<SPLieee32>::get(60).get(), "cached plan");
+	check(SPLFFTPlan<SPLieee32>::getCacheSize() == cached, "no new plans");
+	SPLFFTPlan<SPLieee32>::clearCache();
+	check(SPLFFTPlan<SPLieee32>::getCacheSize() == 0, "cleared cache");
+}
+
+static void testSpectrum(SPLThreadPool &pool)
+{
+	// an odd number of rows, the last row has no partner
+	const SPLVector3i n(12, 5, 3);
+	SPLGridf g(n, SPL_GRID_BRICKED, 4), back;
+	random(g, 3);
+	SPLSpectrum<SPLieee32> s;
+	check(s.forward(g, pool), "real transform");
+	check(s.getSpectrumSize() == SPLVector3i(7, 5, 3) && s.isHalf(), "half spectrum");
+
+	// the naive transform of some coefficients
+	double worst = 0.0;
+	for (SPLindex kz = 0; kz < n.z; kz++)
+	{
+		for (SPLindex ky = 0; ky < n.y; ky++)
+		{
+			for (SPLindex kx = 0; kx <= n.x / 2; kx++)
+			{
+				double sr = 0.0, si = 0.0;
+				for (SPLGridf::Iterator it = g.begin(); it != g.end(); ++it)
+				{
+					const SPLVector3i &p = it.getPosition();
+					const double a = -2.0 * PI * (double(kx * p.x) / n.x + double(ky * p.y) / n.y + double(kz * p.z) / n.z);
+					sr += *it * cos(a);
+					si += *it * sin(a);
+				}
+				const std::complex<SPLieee32> c = s(kx, ky, kz);
+				worst = MAX(worst, MAX(fabs(sr - c.real()), fabs(si - c.imag())));
+			}
+		}
+	}
+	check(worst < 1.0e-4, "coefficients of a real grid");
+
+	check(s.inverse(back, SPL_GRID_BRICKED, 4, pool), "inverse real transform");
+	worst = 0.0;
+	for (SPLGridf::Iterator it = back.begin(); it != back.end(); ++it)
+	{
+		worst = MAX(worst, fabs(*it - g[it.getPosition()]));
+	}
+	check(worst < 1.0e-6 && back.getLayout() == SPL_GRID_BRICKED, "real round trip");
+	check(!s.forward(SPLGridf(SPLVector3i(7, 4, 4)), pool), "unsupported size");
+
+	// complex grids agree with the real transform
+	const SPLVector3i m(10, 9, 8);
+	std::vector<SPLieee32> re(720), im(720, 0.0f), r2(720), i2(720);
+	srand(7);
+	for (size_t i = 0; i < re.size(); i++)
+	{
+		re[i] = SPLieee32(rand()) / RAND_MAX;
+	}
+	SPLSpectrum<SPLieee32> c, h;
+	check(c.forward(&re[0], &im[0], m, pool) && h.forward(&re[0], m, pool), "complex and real transform");
+	worst = 0.0;
+	for (SPLindex z = 0; z < m.z; z++)
+	{
+		for (SPLindex y = 0; y < m.y; y++)
+		{
+			for (SPLindex x = 0; x <= m.x / 2; x++)
+			{
+				worst = MAX(worst, std::abs(c(x, y, z) - h(x, y, z)));
+			}
+		}
+	}
+	check(worst < 1.0e-4, "complex transform of a real grid");
+	check(c.inverse(&r2[0], &i2[0], pool), "inverse complex transform");
+	worst = 0.0;
+	for (size_t i = 0; i < re.size(); i++)
+	{
+		worst = MAX(worst, MAX(fabs(r2[i] - re[i]), fabs(i2[i])));
+	}
+	check(worst < 1.0e-6, "complex round trip");
+}
+
+// direct convolution or correlation of one voxel
+static double convolve(const SPLGridf &g, const SPLGridf &k, const SPLVector3i &p, const SPLenum border, const bool correlate)
+{
+	const SPLVector3i &n = g.getSize(), r((k.getSize().x - 1) / 2, (k.getSize().y - 1) / 2, (k.getSize().z - 1) / 2);
+	const SPLindex s = correlate ? 1 : -1;
+	double sum = 0.0;
+	for (SPLGridf::ConstIterator it = k.begin(); it != k.end(); ++it)
+	{
+		const SPLVector3i &q = it.getPosition();
+		const SPLindex x = SPLConvolutionDetail::border(p.x + s * (q.x - r.x), n.x, border);
+		const SPLindex y = SPLConvolutionDetail::border(p.y + s * (q.y - r.y), n.y, border);
+		const SPLindex z = SPLConvolutionDetail::border(p.z + s * (q.z - r.z), n.z, border);
+		if (x >= 0 && y >= 0 && z >= 0)
+		{
+			sum += double(*it) * g(x, y, z);
+		}
+	}
+	return sum;
+}
+
+static void testConvolution(SPLThreadPool &pool)
+{
+	SPLGridf g(SPLVector3i(21, 14, 9), SPL_GRID_BRICKED, 4), k(SPLVector3i(5, 3, 7)), direct, spectral;
+	random(g, 11);
+	random(k, 13);
+	for (SPLindex b = 0; b < 4; b++)
+	{
+		for (int correlate = 0; correlate < 2; correlate++)
+		{
+			const bool c = correlate != 0;
+			check((c ? splCorrelate(g, k, direct, borders[b], SPL_CONVOLUTION_DIRECT, pool) :
+					   splConvolve(g, k, direct, borders[b], SPL_CONVOLUTION_DIRECT, pool)), "direct convolution");
+			check((c ? splCorrelate(g, k, spectral, borders[b], SPL_CONVOLUTION_SPECTRAL, pool) :
+					   splConvolve(g, k, spectral, borders[b], SPL_CONVOLUTION_SPECTRAL, pool)), "spectral convolution");
+			double worst = 0.0, error = 0.0;
+			for (SPLGridf::Iterator it = direct.begin(); it != direct.end(); ++it)
+			{
+				const double e = convolve(g, k, it.getPosition(), borders[b], c);
+				worst = MAX(worst, fabs(*it - e));
+				error = MAX(error, fabs(spectral[it.getPosition()] - e));
+			}
+			check(worst < 1.0e-5, "direct against naive convolution");
+			check(error < 1.0e-4, "spectral against naive convolution");
+		}
+	}
+	check(spectral.getSize() == g.getSize() && spectral.getLayout() == SPL_GRID_BRICKED, "layout of the result");
+	check(!splConvolve(g, SPLGridf(SPLVector3i(4, 3, 3)), direct, SPL_BORDER_CLAMP, SPL_CONVOLUTION_AUTO, pool), "even kernel");
+
+	// integer grids
+	SPLGrid<SPLuint8> u(SPLVector3i(16, 16, 16));
+	u.fill(10);
+	k.fill(1.0f / 105.0f);
+	check(splConvolve(u, k, spectral, SPL_BORDER_CLAMP, SPL_CONVOLUTION_SPECTRAL, pool) && fabs(spectral(3, 8, 15) - 10.0f) < 1.0e-4,
+		  "convolution of a constant");
+}
+
+static void testMethod(SPLThreadPool &pool)
+{
+	// small kernels run directly and large kernels through the spectra, for SIMD widths up to 16
+	const SPLVector3i n(128, 128, 128);
+	check(splGetConvolutionMethod(n, SPLVector3i(1, 1, 1)) == SPL_CONVOLUTION_DIRECT, "method of a single tap");
+	check(splGetConvolutionMethod(n, SPLVector3i(3, 3, 3)) == SPL_CONVOLUTION_DIRECT, "method of a small kernel");
+	check(splGetConvolutionMethod(n, SPLVector3i(31, 1, 1)) == SPL_CONVOLUTION_DIRECT, "method of a line kernel");
+	check(splGetConvolutionMethod(n, SPLVector3i(15, 15, 15)) == SPL_CONVOLUTION_SPECTRAL, "method of a large kernel");
+	check(splGetConvolutionMethod(SPLVector3i(24, 24, 24), SPLVector3i(15, 15, 15)) == SPL_CONVOLUTION_SPECTRAL, "method of a small grid");
+
+	// the automatic method is the chosen one
+	SPLGridf g(SPLVector3i(24, 24, 24)), a, m;
+	random(g, 23);
+	const SPLsizei sizes[2] = { 3, 15 };
+	for (SPLindex i = 0; i < 2; i++)
+	{
+		SPLGridf k(SPLVector3i(sizes[i], sizes[i], sizes[i]));
+		random(k, 29);
+		splConvolve(g, k, a, SPL_BORDER_CLAMP, SPL_CONVOLUTION_AUTO, pool);
+		splConvolve(g, k, m, SPL_BORDER_CLAMP, splGetConvolutionMethod(g.getSize(), k.getSize()), pool);
+		bool same = true;
+		for (SPLGridf::Iterator it = a.begin(); it != a.end(); ++it)
+		{
+			same = same && *it == m[it.getPosition()];
+		}
+		check(same, "automatic method");
+	}
+}
+
+int main(void)
+{
+	SPLThreadPool pool(4);
+	testPlans();
+	testSpectrum(pool);
+	testConvolution(pool);
+	testMethod(pool);
+
+	printf("fft: %s\n", failures ? "failed" : "passed");
+	return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
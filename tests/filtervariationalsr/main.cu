@@ -0,0 +1,256 @@
+// main.cu: Tests of the variational two-region segmentation.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <chrono>
+#include <vector>
+
+#include <spl/filtervariationalsr.hh>
+
+#include "../check.hh"
+
+// uniform noise in [-a, a]
+static SPLieee32 noise(const SPLieee32 a)
+{
+	return a * (2.0f * SPLieee32(rand()) / RAND_MAX - 1.0f);
+}
+
+// a disk (a ball for volumes) and a square, the slices of volumes shift the disk
+static bool inside(const SPLVector3i &p, const SPLVector3i &n, const bool ball)
+{
+	const SPLieee32 x = SPLieee32(p.x) / n.x - 0.4f, y = SPLieee32(p.y) / n.y - 0.45f;
+	const SPLieee32 z = ball ? SPLieee32(p.z) / n.z - 0.5f : 0.1f * SPLieee32(p.z) / n.z;
+	const bool square = p.x > n.x * 3 / 4 && p.x < n.x * 9 / 10 && p.y > n.y / 10 && p.y < n.y / 3;
+	return (x - z) * (x - z) + y * y + (ball ? z * z : 0.0f) < 0.09f || square;
+}
+
+static void image(SPLGridf &g, const SPLieee32 a, const bool ball)
+{
+	srand(13);
+	for (SPLGridf::Iterator it = g.begin(); it != g.end(); ++it)
+	{
+		*it = (inside(it.getPosition(), g.getSize(), ball) ? 0.7f : 0.3f) + noise(a);
+	}
+}
+
+static SPLieee64 error(const SPLGrid<SPLuint8> &s, const bool ball)
+{
+	SPLint64 wrong = 0;
+	for (SPLGrid<SPLuint8>::ConstIterator it = s.begin(); it != s.end(); ++it)
+	{
+		wrong += ((*it != 0) != inside(it.getPosition(), s.getSize(), ball)) ? 1 : 0;
+	}
+	return SPLieee64(wrong) / SPLieee64(s.getStorageSize());
+}
+
+// explicit gradient descent of the same energy with the total variation smoothed by epsilon
+static SPLsizei descent(const SPLGridf &g, const SPLieee32 lambda, const SPLieee32 epsilon, const SPLieee32 tolerance,
+						SPLGrid<SPLuint8> &s)
+{
+	const SPLindex nx = g.getSize().x, ny = g.getSize().y, n = nx * ny;
+	std::vector<SPLieee32> f(size_t(n), 0.0f), w(size_t(n), 0.0f), b(size_t(n), 0.0f), d(size_t(n), 0.0f);
+	std::vector<SPLuint8> mask(size_t(n), 0);
+	g.toLinear(&f[0]);
+	SPLieee64 mean = 0.0;
+	for (SPLindex i = 0; i < n; i++)
+	{
+		mean += f[i] / n;
+	}
+	for (SPLindex i = 0; i < n; i++)
+	{
+		mask[i] = (f[i] > mean) ? 1 : 0;
+	}
+
+	const SPLieee32 tau = 1.0f / (1.0f + 4.0f * lambda / epsilon);
+	SPLsizei steps = 0;
+	for (SPLsizei update = 0; update < 100; update++)
+	{
+		SPLieee64 c[2] = { 0.0, 0.0 }, count[2] = { 0.0, 0.0 }, largest = 0.0;
+		for (SPLindex i = 0; i < n; i++)
+		{
+			c[mask[i]] += f[i];
+			count[mask[i]] += 1.0;
+		}
+		for (SPLindex i = 0; i < n; i++)
+		{
+			const SPLieee32 d0 = f[i] - SPLieee32(c[0] / count[0]), d1 = f[i] - SPLieee32(c[1] / count[1]);
+			b[i] = d0 * d0 - d1 * d1;
+			largest = MAX(largest, SPLieee64(ABS(b[i])));
+		}
+		for (SPLindex i = 0; i < n; i++)
+		{
+			b[i] /= SPLieee32(largest);
+			w[i] = (update == 0) ? b[i] : w[i];
+		}
+		for (SPLieee32 change = 1.0f; change >= tolerance && steps < 100000; steps++)
+		{
+			for (SPLindex i = 0; i < n; i++)
+			{
+				const SPLindex x = i % nx, y = i / nx;
+				const SPLieee32 gx = (x + 1 < nx) ? w[i + 1] - w[i] : 0.0f, gy = (y + 1 < ny) ? w[i + nx] - w[i] : 0.0f;
+				d[i] = 1.0f / sqrtf(gx * gx + gy * gy + epsilon * epsilon);
+			}
+			change = 0.0f;
+			std::vector<SPLieee32> v(w);
+			for (SPLindex i = 0; i < n; i++)
+			{
+				const SPLindex x = i % nx, y = i / nx;
+				SPLieee32 div = 0.0f;
+				if (x > 0) div += (d[i] + d[i - 1]) * (w[i - 1] - w[i]);
+				if (x + 1 < nx) div += (d[i] + d[i + 1]) * (w[i + 1] - w[i]);
+				if (y > 0) div += (d[i] + d[i - nx]) * (w[i - nx] - w[i]);
+				if (y + 1 < ny) div += (d[i] + d[i + nx]) * (w[i + nx] - w[i]);
+				v[i] = w[i] + tau * (b[i] - w[i] + 0.5f * lambda * div);
+				change = MAX(change, ABS(v[i] - w[i]) / tau);
+			}
+			w.swap(v);
+		}
+		SPLint64 changed = 0;
+		for (SPLindex i = 0; i < n; i++)
+		{
+			const SPLuint8 m = (w[i] > 0.0f) ? 1 : 0;
+			changed += (m != mask[i]) ? 1 : 0;
+			mask[i] = m;
+		}
+		if (changed == 0)
+		{
+			break;
+		}
+	}
+	s.resize(g.getSize());
+	s.fromLinear(&mask[0]);
+	return steps;
+}
+
+// time of a segmentation in seconds
+template <class F>
+static double timing(F f)
+{
+	const std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+	f();
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+static void testGray(SPLThreadPool &pool)
+{
+	const SPLindex n = 160;
+	SPLGridf g(SPLVector3i(n, n, 1));
+	image(g, 0.35f, false);
+	SPLGrid<SPLuint8> s, r;
+	SPLFilterVariationalSR2d filter;
+	check(filter.getDimension() == 2 && filter.getLambda() == 0.1f, "defaults");
+
+	// a single iteration is about a smoothed threshold
+	filter.setMaxIterations(1);
+	filter.setLevels(1);
+	filter.apply(g, s, pool);
+	const SPLieee64 e0 = error(s, false);
+
+	filter.setLambda(0.3f);
+	filter.setMaxIterations(200);
+	filter.setLevels(0);
+	check(filter.apply(g, s, pool), "segmentation");
+	const SPLieee64 e1 = error(s, false);
+	check(e1 < 0.01 && e1 * 10.0 < e0, "denoised segmentation");
+	check(fabs(filter.getMean(1) - 0.7) < 0.02 && fabs(filter.getMean(0) - 0.3) < 0.02, "means");
+	check(filter.getIterations() < filter.getMaxIterations() && filter.getUpdates() > 1, "converged");
+	check(s.getSize() == g.getSize() && s.getLayout() == g.getLayout(), "layout of the segmentation");
+	const SPLsizei iterations = filter.getIterations();
+
+	// gradient descent, the times are printed only
+	SPLsizei steps = 0;
+	const double t1 = timing([&]() { filter.apply(g, s, pool); });
+	const double t2 = timing([&]() { steps = descent(g, filter.getLambda(), 0.01f, filter.getTolerance(), r); });
+	check(error(r, false) < 0.01, "segmentation of gradient descent");
+	check(iterations * 10 < steps, "fewer iterations than gradient descent");
+	printf("filtervariationalsr: error %.4f thresholded and %.4f segmented\n", e0, e1);
+	printf("filtervariationalsr: %d iterations in %.3f s, %d gradient descent steps in %.3f s\n", int(iterations), t1, int(steps), t2);
+
+	// a strong coupling coarsens, the finest level only for comparison
+	filter.setPenalty(64.0f);
+	filter.setMaxIterations(1000);
+	filter.setLevels(0);
+	const double t3 = timing([&]() { filter.apply(g, s, pool); });
+	const SPLsizei cycles = filter.getIterations();
+	filter.setLevels(1);
+	const double t4 = timing([&]() { filter.apply(g, r, pool); });
+	const SPLsizei sweeps = filter.getIterations();
+	check(error(s, false) < 0.01 && error(r, false) < 0.01, "segmentation of a strong coupling");
+	check(cycles * 3 < sweeps, "V-cycles of a strong coupling");
+	printf("filtervariationalsr: penalty 64 %d V-cycles in %.3f s, %d red-black iterations in %.3f s\n", int(cycles), t3, int(sweeps), t4);
+}
+
+static void testColor(SPLThreadPool &pool)
+{
+	// colors of a similar brightness
+	const SPLindex n = 96;
+	SPLGrid<SPLVector3f> g(SPLVector3i(n, n, 1), SPL_GRID_BRICKED);
+	srand(17);
+	for (SPLGrid<SPLVector3f>::Iterator it = g.begin(); it != g.end(); ++it)
+	{
+		const SPLVector3f c = inside(it.getPosition(), g.getSize(), false) ? SPLVector3f(0.8f, 0.2f, 0.3f) : SPLVector3f(0.2f, 0.4f, 0.6f);
+		*it = c + SPLVector3f(noise(0.3f), noise(0.3f), noise(0.3f));
+	}
+	SPLGrid<SPLuint8> s;
+	SPLFilterVariationalSR2d filter;
+	check(filter.apply(g, s, pool), "color segmentation");
+	const SPLieee64 e = MIN(error(s, false), 1.0 - error(s, false));
+	check(e < 0.01, "segmented colors");
+	check(s.getLayout() == SPL_GRID_BRICKED, "bricked segmentation");
+	printf("filtervariationalsr: color error %.4f after %d iterations\n", e, int(filter.getIterations()));
+}
+
+static void testVolume(SPLThreadPool &pool)
+{
+	const SPLindex n = 48;
+	SPLGridf g(SPLVector3i(n, n, n));
+	image(g, 0.35f, true);
+	SPLGrid<SPLuint8> s;
+	SPLFilterVariationalSR3d filter;
+	check(filter.apply(g, s, pool), "volume segmentation");
+	const SPLieee64 e3 = error(s, true);
+	check(e3 < 0.01, "segmented volume");
+
+	// the slices on their own, the same slice as an image
+	SPLFilterVariationalSR2d slices;
+	slices.setLambda(0.3f);
+	check(slices.apply(g, s, pool), "slice segmentation");
+	const SPLieee64 e2 = error(s, true);
+	check(e2 < 0.01, "segmented slices");
+	printf("filtervariationalsr: volume error %.4f after %d iterations, slices error %.4f after %d iterations\n", e3,
+		   int(filter.getIterations()), e2, int(slices.getIterations()));
+
+	// every slice has means of its own, the offset of the last slices exceeds the contrast, the ball is small in the first and last
+	// slices
+	for (SPLGridf::Iterator it = g.begin(); it != g.end(); ++it)
+	{
+		*it += 0.8f * SPLieee32(it.getPosition().z) / n;
+	}
+	check(slices.apply(g, s, pool), "slices of different brightness");
+	const SPLieee64 e4 = error(s, true);
+	bool means = true;
+	for (SPLindex z = 0; z < n; z++)
+	{
+		const SPLieee64 offset = 0.8 * SPLieee64(z) / n;
+		means = means && fabs(slices.getMean(1, 0, z) - 0.7 - offset) < 0.1 && fabs(slices.getMean(0, 0, z) - 0.3 - offset) < 0.02;
+	}
+	check(e4 < 0.01 && means, "means of the slices");
+	printf("filtervariationalsr: slices of different brightness error %.4f after %d iterations\n", e4, int(slices.getIterations()));
+
+	// a uniform image has one region
+	g.fill(0.5f);
+	check(filter.apply(g, s, pool) && s(5, 6, 7) == 0 && filter.getIterations() == 0, "uniform image");
+}
+
+int main(void)
+{
+	SPLThreadPool pool(4);
+	testGray(pool);
+	testColor(pool);
+	testVolume(pool);
+
+	printf("filtervariationalsr: %s\n", failures ? "failed" : "passed");
+	return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,265 @@
+// main.cu: Tests of the gradient volumes.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <chrono>
+
+#include <spl/gradient.hh>
+#include <spl/raycaster.hh>
+
+#include "../check.hh"
+
+static const SPLenum modes[3] = { SPL_GRADIENT_ONTHEFLY, SPL_GRADIENT_FLOAT, SPL_GRADIENT_QUANTIZED };
+
+// angle between two vectors in degrees
+static double angle(const SPLVector3f &a, const SPLVector3f &b)
+{
+	const double c = (a * b) / (a.length() * b.length());
+	return acos(CLAMP(c, -1.0, 1.0)) * 180.0 / 3.14159265358979;
+}
+
+static void ball(SPLGridf &g, const SPLVector3f &c, const SPLieee32 r)
+{
+	for (SPLGridf::Iterator it = g.begin(); it != g.end(); ++it)
+	{
+		const SPLVector3i &p = it.getPosition();
+		*it = r - SPLieee32((SPLVector3f(SPLieee32(p.x), SPLieee32(p.y), SPLieee32(p.z)) - c).length());
+	}
+}
+
+static void testEncoding(void)
+{
+	srand(3);
+	double worst = 0.0;
+	for (SPLindex i = 0; i < 100000; i++)
+	{
+		const SPLVector3f g(SPLieee32(rand()) / RAND_MAX - 0.5f, SPLieee32(rand()) / RAND_MAX - 0.5f, SPLieee32(rand()) / RAND_MAX - 0.5f);
+		if (g.length() < 1.0e-3)
+		{
+			continue;
+		}
+		const SPLVector3f d = SPLGradientVolume<SPLieee32>::decode(SPLGradientVolume<SPLieee32>::encode(g, 1.0f / 255.0f), 1.0f / 255.0f);
+		worst = MAX(worst, angle(g, d));
+	}
+	check(worst < 0.1, "octahedral normals");
+
+	const SPLVector3f axes[6] = { SPLVector3f(1.0f, 0.0f, 0.0f), SPLVector3f(0.0f, -1.0f, 0.0f), SPLVector3f(0.0f, 0.0f, 1.0f),
+								  SPLVector3f(0.0f, 0.0f, -1.0f), SPLVector3f(-1.0f, 0.0f, 0.0f), SPLVector3f(0.0f, 1.0f, 0.0f) };
+	bool exact = true;
+	for (SPLindex i = 0; i < 6; i++)
+	{
+		const SPLVector3f d = SPLGradientVolume<SPLieee32>::decode(SPLGradientVolume<SPLieee32>::encode(axes[i] * 2.0f, 0.01f), 0.01f);
+		exact = exact && angle(axes[i], d) < 1.0e-3 && fabs(d.length() - 2.0) < 0.01;
+	}
+	check(exact, "axes");
+	check(SPLGradientVolume<SPLieee32>::decode(SPLGradientVolume<SPLieee32>::encode(SPLVector3f(0.0f, 0.0f, 0.0f), 1.0f), 1.0f) ==
+		  SPLVector3f(0.0f, 0.0f, 0.0f), "zero gradient");
+	check(SPLGradientVolume<SPLieee32>::decode(SPLGradientVolume<SPLieee32>::encode(SPLVector3f(1.0e-4f, 0.0f, 0.0f), 1.0f), 1.0f).x > 0.0f,
+		  "small gradients keep their direction");
+}
+
+static void testLinear(SPLThreadPool &pool)
+{
+	// the central differences of a linear function are exact inside the volume
+	for (SPLindex layout = 0; layout < 2; layout++)
+	{
+		SPLGrid<SPLint16> g(SPLVector3i(21, 18, 13), layout ? SPL_GRID_BRICKED : SPL_GRID_LINEAR, 4);
+		for (SPLGrid<SPLint16>::Iterator it = g.begin(); it != g.end(); ++it)
+		{
+			const SPLVector3i &p = it.getPosition();
+			*it = SPLint16(2 * p.x + 3 * p.y - p.z);
+		}
+		for (SPLindex m = 0; m < 3; m++)
+		{
+			SPLGradientVolume<SPLint16> v;
+			check(v.build(g, modes[m], pool) && v.getMode() == modes[m], "build");
+			bool inside = true, border = true;
+			for (SPLindex z = 0; z < 13; z++)
+			{
+				for (SPLindex y = 0; y < 18; y++)
+				{
+					for (SPLindex x = 0; x < 21; x++)
+					{
+						const SPLVector3f d = v.getGradient(x, y, z);
+						const SPLVector3f e((x > 0 && x < 20) ? 2.0f : 1.0f, (y > 0 && y < 17) ? 3.0f : 1.5f, (z > 0 && z < 12) ? -1.0f : -0.5f);
+						const bool ok = (modes[m] == SPL_GRADIENT_QUANTIZED) ? (angle(d, e) < 0.1 && fabs(d.length() - e.length()) < 0.01)
+																			 : (d == e);
+						((x > 0 && x < 20 && y > 0 && y < 17 && z > 0 && z < 12) ? inside : border) &= ok;
+					}
+				}
+			}
+			check(inside, "gradients inside");
+			check(border, "gradients at the border");
+			check(v.getGradient(SPLVector3f(5.5f, 7.25f, 3.125f)) == v.getGradient(5, 7, 3) || modes[m] == SPL_GRADIENT_QUANTIZED,
+				  "interpolated constant gradient");
+		}
+	}
+}
+
+static void testModes(SPLThreadPool &pool)
+{
+	SPLGridf g(SPLVector3i(30, 27, 33), SPL_GRID_BRICKED);
+	ball(g, SPLVector3f(14.2f, 13.1f, 16.7f), 9.5f);
+	SPLGradientVolume<SPLieee32> fly, exact, quantized;
+	fly.build(g, SPL_GRADIENT_ONTHEFLY, pool);
+	exact.build(g, SPL_GRADIENT_FLOAT, pool);
+	quantized.build(g, SPL_GRADIENT_QUANTIZED, pool);
+	check(fly.getMemorySize() == 0 && exact.getMemorySize() == g.getStorageSize() * 12 && quantized.getMemorySize() == g.getStorageSize() * 4,
+		  "memory");
+	check(exact.getMaxMagnitude() == 0.0f && quantized.getMaxMagnitude() > 1.0f && quantized.getMaxMagnitude() <= 1.75f, "maximum magnitude");
+
+	srand(5);
+	bool same = true;
+	double worst = 0.0;
+	for (SPLindex i = 0; i < 10000; i++)
+	{
+		const SPLVector3f p(SPLieee32(rand()) / RAND_MAX * 29.0f, SPLieee32(rand()) / RAND_MAX * 26.0f, SPLieee32(rand()) / RAND_MAX * 32.0f);
+		const SPLVector3f a = fly.getGradient(p), b = exact.getGradient(p), c = quantized.getGradient(p);
+		same = same && a == b;
+		if (b.length() > 0.5)
+		{
+			worst = MAX(worst, angle(b, c));
+		}
+	}
+	check(same, "on the fly and precomputed gradients");
+	check(worst < 0.1, "quantized gradients");
+
+	// same gradients with 1 and 4 threads and in both layouts
+	SPLGridf linear(g.getSize());
+	for (SPLGridf::Iterator it = linear.begin(); it != linear.end(); ++it)
+	{
+		*it = g[it.getPosition()];
+	}
+	SPLThreadPool one(1);
+	SPLGradientVolume<SPLieee32> other;
+	other.build(linear, SPL_GRADIENT_QUANTIZED, one);
+	bool layouts = true;
+	for (SPLindex z = 0; z < 33; z++)
+	{
+		for (SPLindex y = 0; y < 27; y++)
+		{
+			for (SPLindex x = 0; x < 30; x++)
+			{
+				layouts = layouts && other.getGradient(x, y, z) == quantized.getGradient(x, y, z);
+			}
+		}
+	}
+	check(layouts, "layouts and threads");
+	check(!other.build(SPLGridf(), SPL_GRADIENT_FLOAT, pool), "empty volume");
+}
+
+static void testShading(SPLThreadPool &pool)
+{
+	const SPLindex n = 48;
+	SPLGridf g(SPLVector3i(n, n, n), SPL_GRID_BRICKED);
+	ball(g, SPLVector3f(23.5f, 23.5f, 23.5f), 20.0f);
+	for (SPLGridf::Iterator it = g.begin(); it != g.end(); ++it)
+	{
+		*it = CLAMP(*it, 0.0f, 1.0f);
+	}
+	SPLMaterial m;
+	m.setChannel(SPL_MATERIAL_EMISSION_RED, 0.0f);
+	m.setChannel(SPL_MATERIAL_EMISSION_GREEN, 0.0f);
+	m.setChannel(SPL_MATERIAL_EMISSION_BLUE, 0.0f);
+	m.setChannel(SPL_MATERIAL_DIFFUSE_RED, 1.0f);
+	m.setChannel(SPL_MATERIAL_SPECULAR_GREEN, 1.0f);
+	const SPLieee32 s = 2.0f / SPLieee32(n - 1);
+	SPLRayCaster<SPLieee32> r;
+	r.setModel(SPLMatrix4f(s, 0.0f, 0.0f, -1.0f, 0.0f, s, 0.0f, -1.0f, 0.0f, 0.0f, s, -1.0f, 0.0f, 0.0f, 0.0f, 1.0f));
+	r.setMaterial(m);
+	SPLLight light;
+	light.setDirection(SPLVector3f(-0.3f, -0.4f, -1.0f).getNormalized(1.0f));
+	r.addLight(light);
+	SPLCamera c;
+	c.setLookAt(SPLVector3f(0.0f, 0.0f, 3.0f), SPLVector3f(0.0f, 0.0f, 0.0f), SPLVector3f(0.0f, 1.0f, 0.0f));
+	c.setOrtho(-1.0f, 1.0f, -1.0f, 1.0f, 1.0f, 5.0f);
+	c.setViewport(0, 0, 64, 64);
+
+	SPLGrid<SPLVector4f> images[4];
+	r.render(g, c, images[0], pool);
+	double t[3];
+	for (SPLindex i = 0; i < 3; i++)
+	{
+		SPLGradientVolume<SPLieee32> v;
+		const std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+		v.build(g, modes[i], pool);
+		r.setGradients(&v);
+		check(r.render(g, c, images[i + 1], pool), "render with gradients");
+		t[i] = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+		r.setGradients(NULL);
+	}
+
+	// all gradients shade the ball alike
+	double diff[3] = { 0.0, 0.0, 0.0 };
+	for (SPLindex y = 0; y < 64; y++)
+	{
+		for (SPLindex x = 0; x < 64; x++)
+		{
+			for (SPLindex i = 0; i < 3; i++)
+			{
+				diff[i] = MAX(diff[i], fabs(images[i + 1](x, y, 0).x - images[0](x, y, 0).x) + fabs(images[i + 1](x, y, 0).y - images[0](x, y, 0).y));
+			}
+		}
+	}
+	check(images[0](32, 32, 0).x > 0.5f, "lit ball");
+	check(diff[0] < 0.05 && diff[1] < 0.05 && diff[2] < 0.05, "same shading");
+	check(images[1](32, 32, 0) == images[2](32, 32, 0), "on the fly and float gradients");
+	SPLGradientVolume<SPLieee32> other;
+	SPLGridf small(SPLVector3i(4, 4, 4));
+	other.build(small, SPL_GRADIENT_FLOAT, pool);
+	r.setGradients(&other);
+	check(!r.render(g, c, images[0], pool), "gradients of another volume");
+	printf("gradient: shading with on the fly %.3f s, float %.3f s, quantized %.3f s\n", t[0], t[1], t[2]);
+}
+
+static void testSpeed(SPLThreadPool &pool)
+{
+	const SPLindex n = 160;
+	SPLGrid<SPLuint16> g(SPLVector3i(n, n, n), SPL_GRID_BRICKED);
+	for (SPLGrid<SPLuint16>::Iterator it = g.begin(); it != g.end(); ++it)
+	{
+		const SPLVector3i &p = it.getPosition();
+		*it = SPLuint16((p.x * p.y + p.z * 17) & 4095);
+	}
+	const char *names[3] = { "on the fly", "float", "quantized" };
+	for (SPLindex i = 0; i < 3; i++)
+	{
+		SPLGradientVolume<SPLuint16> v;
+		std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+		v.build(g, modes[i], pool);
+		const double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+		// samples along a ray through the volume
+		const SPLindex count = 1000000;
+		SPLVector3f sum(0.0f, 0.0f, 0.0f);
+		t0 = std::chrono::steady_clock::now();
+		for (SPLindex k = 0; k < count; k++)
+		{
+			const SPLieee32 t = SPLieee32(k % 1000) * 0.15f;
+			sum += v.getGradient(SPLVector3f(t, 0.7f * t + 3.3f, 0.4f * t + 10.1f));
+		}
+		const double r = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+		check(sum.length() > 0.0, "samples");
+		printf("gradient: %s %.1f MB, %.1f Msamples/s", names[i], v.getMemorySize() / 1048576.0, count / 1.0e6 / r);
+		if (modes[i] != SPL_GRADIENT_ONTHEFLY)
+		{
+			printf(", build %.1f Mvoxels/s", SPLieee64(n) * n * n / 1.0e6 / s);
+		}
+		printf("\n");
+	}
+}
+
+int main(void)
+{
+	SPLThreadPool pool(4);
+	testEncoding();
+	testLinear(pool);
+	testModes(pool);
+	testShading(pool);
+	testSpeed(pool);
+
+	printf("gradient: %s\n", failures ? "failed" : "passed");
+	return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
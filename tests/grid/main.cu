@@ -0,0 +1,187 @@
+// main.cu: Tests of SPLGrid in the linear and bricked layouts.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+#include <spl/grid.hh>
+
+#include "../check.hh"
+
+static SPLieee32 pattern(const SPLindex x, const SPLindex y, const SPLindex z)
+{
+	return SPLieee32(x + 100 * y + 10000 * z);
+}
+
+static SPLieee32 clamped(const SPLVector3i &n, const SPLindex x, const SPLindex y, const SPLindex z)
+{
+	return pattern(CLAMP(x, 0, n.x - 1), CLAMP(y, 0, n.y - 1), CLAMP(z, 0, n.z - 1));
+}
+
+static void testGrid(const SPLVector3i &n, const SPLenum layout, const SPLsizei brick, SPLThreadPool &pool)
+{
+	const SPLint64 voxels = SPLint64(n.x) * n.y * n.z;
+	const size_t count = size_t(voxels);
+	std::vector<SPLieee32> linear(count), back(count, -1.0f);
+	for (SPLindex z = 0; z < n.z; z++)
+	{
+		for (SPLindex y = 0; y < n.y; y++)
+		{
+			for (SPLindex x = 0; x < n.x; x++)
+			{
+				linear[size_t((SPLint64(z) * n.y + y) * n.x + x)] = pattern(x, y, z);
+			}
+		}
+	}
+
+	SPLGridf g(n, layout, brick);
+	check(g.getSize() == n && g.getLayout() == layout, "size and layout");
+	check(g.getStorageSize() == SPLGridf::getStorageSize(n, layout, brick) && g.getStorageSize() >= voxels, "storage size");
+	g.fromLinear(&linear[0], pool);
+	g.toLinear(&back[0], pool);
+	check(back == linear, "fromLinear/toLinear round trip");
+
+	// every voxel has its own offset inside the storage
+	std::vector<char> used(size_t(g.getStorageSize()), 0);
+	bool unique = true, values = true;
+	for (SPLindex z = 0; z < n.z; z++)
+	{
+		for (SPLindex y = 0; y < n.y; y++)
+		{
+			for (SPLindex x = 0; x < n.x; x++)
+			{
+				const SPLint64 o = g.getOffset(x, y, z);
+				unique = unique && o >= 0 && o < g.getStorageSize() && !used[size_t(o)];
+				used[size_t(o)] = 1;
+				values = values && g(x, y, z) == pattern(x, y, z) && g[SPLVector3i(x, y, z)] == pattern(x, y, z);
+			}
+		}
+	}
+	check(unique, "offsets are unique");
+	check(values, "access operators");
+	check(g.getClamped(-5, n.y + 3, 1) == clamped(n, -5, n.y + 3, 1), "clamped access");
+
+	// the iterator visits every voxel once, in memory order, with clamped neighbors
+	std::vector<char> seen(count, 0);
+	bool once = true, order = true, neighbors = true;
+	SPLint64 visits = 0, previous = -1;
+	const SPLGridf &c = g;
+	for (SPLGridf::ConstIterator it = c.begin(); it != c.end(); ++it)
+	{
+		const SPLVector3i &p = it.getPosition();
+		const size_t i = size_t((SPLint64(p.z) * n.y + p.y) * n.x + p.x);
+		once = once && !seen[i];
+		seen[i] = 1;
+		values = values && *it == pattern(p.x, p.y, p.z);
+		// within a brick the Morton order is not monotonous in x, y, z
+		order = order && (layout == SPL_GRID_BRICKED || it.getOffset() > previous);
+		previous = it.getOffset();
+		for (SPLindex dz = -1; dz <= 1; dz++)
+		{
+			for (SPLindex dy = -1; dy <= 1; dy++)
+			{
+				for (SPLindex dx = -1; dx <= 1; dx++)
+				{
+					neighbors = neighbors && it.getNeighbor(dx, dy, dz) == clamped(n, p.x + dx, p.y + dy, p.z + dz);
+				}
+			}
+		}
+		visits++;
+	}
+	check(once && visits == voxels, "iterator visits every voxel once");
+	check(values, "iterator values");
+	check(order, "iterator in memory order");
+	check(neighbors, "iterator neighbors");
+
+	// the blocks cover the grid, i.e. parallel iteration writes every voxel
+	std::vector<SPLint64> hits(count, 0);
+	pool.parallelFor(0, g.getBlockCount(), 1, [&](const SPLint64 first, const SPLint64 last)
+	{
+		for (SPLGridf::Iterator it = g.begin(first, last); it != g.end(first, last); ++it)
+		{
+			const SPLVector3i &p = it.getPosition();
+			hits[size_t((SPLint64(p.z) * n.y + p.y) * n.x + p.x)]++;
+			*it += 1.0f;
+		}
+	});
+	bool covered = true;
+	for (size_t i = 0; i < hits.size(); i++)
+	{
+		covered = covered && hits[i] == 1;
+	}
+	check(covered, "blocks cover the grid");
+	check(g(n.x - 1, n.y - 1, n.z - 1) == pattern(n.x - 1, n.y - 1, n.z - 1) + 1.0f, "write through iterator");
+
+	// reordering keeps the values
+	SPLGridf h(g);
+	const SPLenum other = (layout == SPL_GRID_LINEAR) ? SPL_GRID_BRICKED : SPL_GRID_LINEAR;
+	check(h.setLayout(other, 4, pool) && h.getLayout() == other, "setLayout");
+	h.toLinear(&back[0], pool);
+	bool same = true;
+	for (size_t i = 0; i < back.size(); i++)
+	{
+		same = same && back[i] == linear[i] + 1.0f;
+	}
+	check(same, "setLayout keeps the values");
+}
+
+static void testMorton(void)
+{
+	SPLGridf g(SPLVector3i(20, 9, 9), SPL_GRID_BRICKED, 8);
+	check(g.getBlockCount() == 3 * 2 * 2, "brick count");
+	check(g.getStorageSize() == 12 * 512, "padded to whole bricks");
+	check(g.getOffset(1, 0, 0) == 1 && g.getOffset(0, 1, 0) == 2 && g.getOffset(0, 0, 1) == 4, "Morton order within a brick");
+	check(g.getOffset(1, 1, 1) == 7 && g.getOffset(2, 0, 0) == 8 && g.getOffset(7, 7, 7) == 511, "Morton order within a brick");
+	check(g.getOffset(8, 0, 0) == 512 && g.getOffset(0, 8, 0) == 3 * 512 && g.getOffset(0, 0, 8) == 6 * 512, "bricks x fastest");
+	check(g.getOffset(-1, 0, 0) == g.getOffset(0, 0, 0) && g.getOffset(20, 0, 0) == g.getOffset(19, 0, 0), "clamped offsets");
+
+	SPLVector3i lo, hi;
+	g.getBlock(5, lo, hi);
+	check(lo == SPLVector3i(16, 8, 0) && hi == SPLVector3i(20, 9, 8), "partial brick");
+}
+
+static void testExternal(void)
+{
+	const SPLVector3i n(5, 4, 3);
+	check(SPLGridf::getStorageSize(n, SPL_GRID_BRICKED, 3) == -1, "brick size must be a power of 2");
+	check(SPLGridf::getStorageSize(n, SPL_GRID_MIN, 8) == -1, "unknown layout");
+
+	std::vector<SPLieee32> memory(size_t(SPLGridf::getStorageSize(n, SPL_GRID_BRICKED, 2)), 0.0f);
+	SPLGridf g;
+	check(!g.resize(n, SPL_GRID_BRICKED, 6), "invalid brick size");
+	check(g.setExternal(&memory[0], n, SPL_GRID_BRICKED, 2) && g.isExternal() && g.getData() == &memory[0], "setExternal");
+	g(1, 1, 1) = 3.0f;
+	check(memory[7] == 3.0f, "write into external memory");
+
+	SPLGridf copy(g);
+	check(!copy.isExternal() && copy.getData() != &memory[0] && copy(1, 1, 1) == 3.0f, "deep copy of external memory");
+	copy(1, 1, 1) = 4.0f;
+	check(memory[7] == 3.0f, "copy is independent");
+
+	check(g.setLayout(SPL_GRID_LINEAR) && !g.isExternal() && g(1, 1, 1) == 3.0f, "setLayout of external memory");
+
+	SPLGridf empty;
+	check(empty.begin() == empty.end() && empty.getBlockCount() == 0, "empty grid");
+}
+
+int main(void)
+{
+	check(SPLGridub::getType() == SPL_TYPE_UINT8 && SPLGridus::getType() == SPL_TYPE_UINT16, "type ids");
+	check(SPLGridf::getType() == SPL_TYPE_IEEE32 && SPLGridd::getType() == SPL_TYPE_IEEE64, "type ids");
+	check(SPLGrid<SPLVector3f>::getType() == SPL_TYPE_MIN, "no type id");
+
+	SPLThreadPool pool(4);
+	const SPLVector3i sizes[] = { SPLVector3i(13, 7, 5), SPLVector3i(16, 16, 16), SPLVector3i(33, 1, 17), SPLVector3i(1, 1, 1) };
+	for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++)
+	{
+		testGrid(sizes[s], SPL_GRID_LINEAR, 0, pool);
+		testGrid(sizes[s], SPL_GRID_BRICKED, 4, pool);
+		testGrid(sizes[s], SPL_GRID_BRICKED, 8, pool);
+	}
+	testMorton();
+	testExternal();
+
+	printf("grid: %s\n", failures ? "failed" : "passed");
+	return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,209 @@
+// main.cu: Tests of the half precision and normalized integer storage types.
+//
+// NaNs: SPLHalfDetail quiets them without the payload, F16C keeps the payload.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <chrono>
+#include <vector>
+
+#include <spl/convert.hh>
+
+#include "../check.hh"
+
+static SPLuint32 bitsOf(const SPLieee32 f)
+{
+	SPLuint32 u;
+	memcpy(&u, &f, 4);
+	return u;
+}
+
+static SPLieee32 floatOf(const SPLuint32 u)
+{
+	SPLieee32 f;
+	memcpy(&f, &u, 4);
+	return f;
+}
+
+static void testHalf(void)
+{
+	// every half converts exactly to float and back
+	bool exact = true, software = true;
+	for (SPLuint32 h = 0; h < 65536; h++)
+	{
+		const SPLieee16 a = SPLieee16::fromBits(SPLuint16(h));
+		const SPLieee32 f = a;
+		const bool nan = (h & 0x7c00) == 0x7c00 && (h & 0x3ff) != 0;
+		exact = exact && (nan ? f != f : SPLieee16(f).getBits() == h);
+		software = software && (nan ? SPLHalfDetail::toFloat(SPLuint16(h)) != f : bitsOf(SPLHalfDetail::toFloat(SPLuint16(h))) == bitsOf(f));
+	}
+	check(exact, "half to float to half");
+	check(software, "half to float in software");
+
+	// rounding ties to even, overflow, subnormals
+	check(SPLieee16(1.0f).getBits() == 0x3c00 && SPLieee16(-2.0f).getBits() == 0xc000 && SPLieee16(65504.0f).getBits() == 0x7bff,
+		  "normal values");
+	check(SPLieee16(1.0f + 1.0f / 2048.0f).getBits() == 0x3c00 && SPLieee16(1.0f + 3.0f / 2048.0f).getBits() == 0x3c02, "ties to even");
+	check(SPLieee16(65519.0f).getBits() == 0x7bff && SPLieee16(65520.0f).getBits() == 0x7c00 && SPLieee16(-1.0e9f).getBits() == 0xfc00,
+		  "overflow to infinity");
+	check(SPLieee16(ldexpf(1.0f, -24)).getBits() == 0x0001 && SPLieee16(ldexpf(1.0f, -25)).getBits() == 0x0000 &&
+		  SPLieee16(ldexpf(3.0f, -25)).getBits() == 0x0002 && SPLieee16(-ldexpf(1.0f, -14)).getBits() == 0x8400, "subnormals");
+	check(SPLieee32(SPLieee16(NAN)) != SPLieee32(SPLieee16(NAN)) && SPLieee32(SPLieee16(INFINITY)) == INFINITY, "NaN and infinity");
+
+	// the software conversion rounds like F16C
+	srand(5);
+	bool same = true;
+	for (SPLindex i = 0; i < 1000000; i++)
+	{
+		const SPLuint32 u = (SPLuint32(rand()) << 16) ^ SPLuint32(rand());
+		const SPLieee32 f = floatOf(u);
+		if (f == f)
+		{
+			same = same && SPLHalfDetail::fromFloat(f) == SPLieee16(f).getBits();
+		}
+	}
+	check(same, "float to half in software");
+
+	// the arrays convert like the values (with F16C if the processor has it)
+	std::vector<SPLuint16> bits(65536), back(65536);
+	std::vector<SPLieee32> floats(65536);
+	for (SPLuint32 i = 0; i < 65536; i++)
+	{
+		bits[i] = SPLuint16(i);
+	}
+	SPLHalfDetail::toFloat(&bits[0], &floats[0], 65536);
+	SPLHalfDetail::fromFloat(&floats[0], &back[0], 65536);
+	bool arrays = true;
+	for (SPLuint32 i = 0; i < 65536; i++)
+	{
+		const bool nan = (i & 0x7c00) == 0x7c00 && (i & 0x3ff) != 0;
+		arrays = arrays && (nan ? floats[i] != floats[i] && (back[i] & 0x7e00) == 0x7e00 : bitsOf(floats[i]) == bitsOf(SPLieee16::fromBits(SPLuint16(i))) && back[i] == i);
+	}
+	check(arrays, "arrays of halfs");
+
+#if defined(SPL_HALF_DISPATCH)
+	// the F16C kernels of the run time dispatch against the software conversion, bit for bit (NaNs without the payload)
+	if (SPLHalfDetail::hasF16C())
+	{
+		std::vector<SPLieee32> hardware(65536), values(1000000);
+		std::vector<SPLuint16> rounded(values.size());
+		SPLHalfDetail::toFloatF16C(&bits[0], &hardware[0], 65536);
+		bool up = true;
+		for (SPLuint32 i = 0; i < 65536; i++)
+		{
+			const SPLieee32 f = SPLHalfDetail::toFloat(SPLuint16(i));
+			up = up && ((f != f) ? hardware[i] != hardware[i] : bitsOf(hardware[i]) == bitsOf(f));
+		}
+		check(up, "half to float with F16C");
+		for (size_t i = 0; i < values.size(); i++)
+		{
+			const SPLieee32 f = floatOf((SPLuint32(rand()) << 16) ^ SPLuint32(rand()));
+			values[i] = (f == f) ? f : 0.0f;
+		}
+		SPLHalfDetail::fromFloatF16C(&values[0], &rounded[0], SPLint64(values.size()));
+		bool down = true;
+		for (size_t i = 0; i < values.size(); i++)
+		{
+			down = down && rounded[i] == SPLHalfDetail::fromFloat(values[i]);
+		}
+		check(down, "float to half with F16C");
+	}
+#endif
+
+	// arithmetic in float
+	SPLieee16 h = 1.5f;
+	h += 2.0f;
+	h *= 3.0f;
+	h -= 0.5f;
+	h /= 2.0f;
+	check(SPLieee32(h) == 5.0f && SPLieee32(h) * 2.0f + 1.0f == 11.0f, "arithmetic");
+}
+
+static void testUnorm(void)
+{
+	check(SPLunorm8(0.5f).getBits() == 128 && SPLunorm8(-0.2f).getBits() == 0 && SPLunorm8(1.5f).getBits() == 255 &&
+		  SPLunorm8(NAN).getBits() == 0, "unorm8 saturation");
+	check(SPLieee32(SPLunorm8::fromBits(51)) == 0.2f && SPLieee32(SPLunorm16::fromBits(65535)) == 1.0f, "unorm values");
+	check(SPLunorm16(0.25f).getBits() == 16384 && SPLunorm16(1.0f / 65535.0f).getBits() == 1, "unorm16 steps");
+	bool exact = true;
+	for (SPLuint32 u = 0; u < 65536; u++)
+	{
+		exact = exact && SPLunorm16(SPLieee32(SPLunorm16::fromBits(SPLuint16(u)))).getBits() == u;
+	}
+	check(exact, "unorm16 to float to unorm16");
+	SPLunorm8 u = 0.5f;
+	u += 0.75f;
+	check(u.getBits() == 255, "saturated arithmetic");
+}
+
+template <class T>
+static void testGrid(const char *name)
+{
+	// grids and vectors with a compact storage type
+	SPLGrid<T> g(SPLVector3i(21, 13, 5), SPL_GRID_BRICKED, 4);
+	for (typename SPLGrid<T>::Iterator it = g.begin(); it != g.end(); ++it)
+	{
+		const SPLVector3i &p = it.getPosition();
+		*it = SPLieee32(p.x + p.y + p.z) / 64.0f;
+	}
+	check(SPLieee32(g(20, 8, 4)) == SPLieee32(T(0.5f)) && 2.0f * g(1, 2, 3) == 2.0f * SPLieee32(T(0.09375f)), name);
+
+	SPLGrid<SPLieee32> f;
+	SPLGrid<T> h;
+	bool ok = splConvert(g, f, 2.0, 0.0) && splConvert(f, h, 0.5, 0.0);
+	for (typename SPLGrid<T>::Iterator it = g.begin(); it != g.end(); ++it)
+	{
+		const SPLVector3i &p = it.getPosition();
+		ok = ok && f(p.x, p.y, p.z) == 2.0f * SPLieee32(*it) && h(p.x, p.y, p.z).getBits() == (*it).getBits();
+	}
+	check(ok && h.getLayout() == SPL_GRID_BRICKED, name);
+
+	SPLVector3<T> v(0.25f, 0.5f, 0.125f), w(v);
+	v += w;
+	// the steps of unorm8 are 0.004 and add up in the dot product
+	check(fabs(v.x - 0.5f) < 0.004f && fabs(v.z - 0.25f) < 0.004f && fabs(v * w - 0.65625f) < 0.01f && fabs(w.length() - 0.5728) < 0.004, name);
+	check(splGetTypeSize(SPLTypeId<T>::value) == SPLsizei(sizeof(T)), name);
+}
+
+// time of a pass in seconds
+template <class F>
+static double timing(F f)
+{
+	const std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+	f();
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+static void testTiming(void)
+{
+	// a bandwidth bound pass over 32M voxels: read, scale, write
+	const SPLVector3i n(512, 256, 256);
+	SPLGrid<SPLieee32> a(n), b(n);
+	SPLGrid<SPLieee16> c(n), d(n);
+	for (SPLGrid<SPLieee32>::Iterator it = a.begin(); it != a.end(); ++it)
+	{
+		*it = SPLieee32(it.getPosition().x) / 512.0f;
+	}
+	splConvert(a, c);
+	splConvert(a, b, 0.5, 1.0);
+	splConvert(c, d, 0.5, 1.0);
+	// printed only, the times depend on the build and the load of the machine
+	const double t0 = timing([&]() { splConvert(a, b, 0.5, 1.0); });
+	const double t1 = timing([&]() { splConvert(c, d, 0.5, 1.0); });
+	check(SPLieee32(d(511, 3, 4)) == SPLieee32(SPLieee16(b(511, 3, 4))), "scaled half grid");
+	printf("half: 32M voxels scale float %.3f s, half %.3f s (%.2fx)\n", t0, t1, t0 / t1);
+}
+
+int main(void)
+{
+	testHalf();
+	testUnorm();
+	testGrid<SPLieee16>("half grid");
+	testGrid<SPLunorm8>("unorm8 grid");
+	testGrid<SPLunorm16>("unorm16 grid");
+	testTiming();
+
+	printf("half: %s\n", failures ? "failed" : "passed");
+	return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,208 @@
+// main.cu: Tests of the min-max macrocells and the empty space skipping.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+
+#include <spl/macrocells.hh>
+#include <spl/raycaster.hh>
+
+#include "../check.hh"
+
+static SPLuint16 pattern(const SPLindex x, const SPLindex y, const SPLindex z)
+{
+	return SPLuint16((x * 7919 + y * 104729 + z * 1299709) % 1000);
+}
+
+// compares every cell with the voxels it covers
+template <class T>
+static bool verify(const SPLMacroCells<T> &m, const SPLGrid<T> &g)
+{
+	const SPLVector3i &n = g.getSize();
+	for (SPLindex l = 0; l < m.getLevelCount(); l++)
+	{
+		const SPLVector3i &c = m.getCellCount(l);
+		const SPLsizei s = m.getCellSize(l);
+		for (SPLindex z = 0; z < c.z; z++)
+		{
+			for (SPLindex y = 0; y < c.y; y++)
+			{
+				for (SPLindex x = 0; x < c.x; x++)
+				{
+					T a = g(x * s, y * s, z * s), b = a;
+					for (SPLindex k = z * s; k <= MIN(z * s + s, n.z - 1); k++)
+					{
+						for (SPLindex j = y * s; j <= MIN(y * s + s, n.y - 1); j++)
+						{
+							for (SPLindex i = x * s; i <= MIN(x * s + s, n.x - 1); i++)
+							{
+								a = MIN(a, g(i, j, k));
+								b = MAX(b, g(i, j, k));
+							}
+						}
+					}
+					if (m.getMin(l, x, y, z) != a || m.getMax(l, x, y, z) != b)
+					{
+						return false;
+					}
+				}
+			}
+		}
+	}
+	return true;
+}
+
+static void testBuild(SPLThreadPool &pool)
+{
+	const SPLVector3i n(37, 20, 9);
+	SPLGrid<SPLuint16> g(n, SPL_GRID_BRICKED);
+	for (SPLGrid<SPLuint16>::Iterator it = g.begin(); it != g.end(); ++it)
+	{
+		*it = pattern(it.getPosition().x, it.getPosition().y, it.getPosition().z);
+	}
+
+	SPLMacroCells<SPLuint16> m;
+	check(!m.build(g, 0, pool), "invalid cell size");
+	check(m.build(g, 4, pool), "build");
+	check(m.getCellCount(0) == SPLVector3i(9, 5, 2), "cells of level 0");
+	check(m.getLevelCount() == 5 && m.getCellCount(4) == SPLVector3i(1, 1, 1), "levels");
+	check(verify(m, g), "minimum and maximum");
+
+	// a voxel on a cell border changes both cells
+	g(8, 4, 4) = 5000;
+	check(m.update(g, SPLVector3i(8, 4, 4), SPLVector3i(8, 4, 4), pool), "update voxel");
+	check(m.getMax(0, 1, 0, 0) == 5000 && m.getMax(0, 2, 1, 1) == 5000 && m.getMax(4, 0, 0, 0) == 5000, "update shared border");
+	check(verify(m, g), "update voxel");
+
+	for (SPLindex z = 2; z < 7; z++)
+	{
+		for (SPLindex y = 0; y < 20; y++)
+		{
+			for (SPLindex x = 30; x < 37; x++)
+			{
+				g(x, y, z) = 7;
+			}
+		}
+	}
+	check(m.update(g, SPLVector3i(30, 0, 2), SPLVector3i(40, 19, 6), pool), "update region");
+	check(verify(m, g), "update region");
+	check(!m.update(SPLGrid<SPLuint16>(SPLVector3i(4, 4, 4)), SPLVector3i(0, 0, 0), SPLVector3i(1, 1, 1), pool), "other volume");
+
+	// a single voxel
+	SPLGrid<SPLuint16> one(SPLVector3i(1, 1, 1));
+	one(0, 0, 0) = 3;
+	check(m.build(one, 8, pool) && m.getLevelCount() == 1 && m.getMax(0, 0, 0, 0) == 3, "single voxel");
+}
+
+static void testQueries(SPLThreadPool &pool)
+{
+	SPLGridf g(SPLVector3i(17, 17, 17));
+	g.fill(0.0f);
+	g(16, 16, 16) = 0.75f;
+	SPLMacroCells<SPLieee32> m;
+	m.build(g, 8, pool);
+
+	check(m.containsIsovalue(0, 1, 1, 1, 0.5f) && !m.containsIsovalue(0, 0, 0, 0, 0.5f), "isovalue");
+	check(m.containsIsovalue(1, 0, 0, 0, 0.5f) && !m.containsIsovalue(1, 0, 0, 0, 0.8f), "isovalue of level 1");
+	check(m.intersects(0, 1, 1, 1, 0.7f, 2.0f) && !m.intersects(0, 1, 0, 1, 0.7f, 2.0f), "range");
+
+	SPLMaterial a;
+	check(a.getMaxOpacity(0.0f, 0.0f) == 0.0f && a.getMaxOpacity(0.0f, 0.5f) == 0.5f, "maximum opacity");
+	std::vector<SPLuint8> v;
+	check(m.classify(0, a, v, pool) == 1 && v[7] == 1 && v[0] == 0, "classify linear ramp");
+
+	// a transparent band in the middle of the range
+	a.setChannel(SPL_MATERIAL_OPACITY, SPL_MATERIAL_APPROX_QUADRATIC, 1.0f, -4.0f, 4.0f);
+	check(a.getMaxOpacity(0.25f, 0.75f) == 0.25f, "maximum opacity of a convex parabola");
+	a.setChannel(SPL_MATERIAL_OPACITY, SPL_MATERIAL_APPROX_QUADRATIC, 0.0f, 4.0f, -4.0f);
+	check(a.getMaxOpacity(0.0f, 1.0f) == 1.0f && a.getMaxOpacity(1.0f, 1.0f) == 0.0f, "maximum opacity of a concave parabola");
+	check(m.classify(0, a, v, pool) == 1 && m.isVisible(1, 0, 0, 0, a), "classify concave parabola");
+	a.setChannel(SPL_MATERIAL_OPACITY, SPL_MATERIAL_APPROX_LINEAR, 0.0f, 1.0f);
+	a.setRange(0.75f, 1.0f);
+	check(m.classify(0, a, v, pool) == 0 && !m.isVisible(1, 0, 0, 0, a), "classify below the range");
+}
+
+static void ball(SPLGridf &g, const SPLVector3f &c, const SPLieee32 r)
+{
+	for (SPLGridf::Iterator it = g.begin(); it != g.end(); ++it)
+	{
+		const SPLVector3i &p = it.getPosition();
+		const SPLieee32 d = SPLieee32((SPLVector3f(SPLieee32(p.x), SPLieee32(p.y), SPLieee32(p.z)) - c).length());
+		*it = CLAMP(r - d, 0.0f, 1.0f);
+	}
+}
+
+static void testSkipping(SPLThreadPool &pool)
+{
+	const SPLindex n = 96;
+	SPLGridf g(SPLVector3i(n, n, n), SPL_GRID_BRICKED);
+	ball(g, SPLVector3f(60.0f, 40.0f, 50.0f), 16.0f);
+	SPLMacroCells<SPLieee32> m;
+	m.build(g, 8, pool);
+
+	SPLMaterial a;
+	a.setChannel(SPL_MATERIAL_OPACITY, SPL_MATERIAL_APPROX_LINEAR, 0.0f, 0.2f);
+	SPLRayCaster<SPLieee32> r;
+	const SPLieee32 s = 2.0f / SPLieee32(n - 1);
+	r.setModel(SPLMatrix4f(s, 0.0f, 0.0f, -1.0f, 0.0f, s, 0.0f, -1.0f, 0.0f, 0.0f, s, -1.0f, 0.0f, 0.0f, 0.0f, 1.0f));
+	r.setMaterial(a);
+	SPLCamera c;
+	c.setLookAt(SPLVector3f(1.0f, 2.0f, 3.0f), SPLVector3f(0.0f, 0.0f, 0.0f), SPLVector3f(0.0f, 1.0f, 0.0f));
+	c.setPerspective(45.0f, 1.0f, 0.1f, 10.0f);
+	c.setViewport(0, 0, 128, 128);
+
+	SPLGrid<SPLVector4f> full, skipped;
+	std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+	r.render(g, c, full, pool);
+	const double t1 = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+	const SPLint64 samples = r.getSamples();
+
+	r.setMacroCells(&m);
+	t0 = std::chrono::steady_clock::now();
+	check(r.render(g, c, skipped, pool), "render with macrocells");
+	const double t2 = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+	check(r.getSamples() * 4 < samples, "skipped samples");
+
+	bool same = true, visible = false;
+	for (SPLindex y = 0; y < 128; y++)
+	{
+		for (SPLindex x = 0; x < 128; x++)
+		{
+			same = same && full(x, y, 0).x == skipped(x, y, 0).x && full(x, y, 0).w == skipped(x, y, 0).w;
+			visible = visible || full(x, y, 0).w > 0.5f;
+		}
+	}
+	check(visible, "visible ball");
+	check(same, "same image with macrocells");
+	printf("macrocells: %lld samples without and %lld with macrocells, speedup %.1f\n", (long long)samples,
+		   (long long)r.getSamples(), t1 / t2);
+
+	SPLGridf other(SPLVector3i(8, 8, 8));
+	check(!r.render(other, c, skipped, pool), "macrocells of another volume");
+}
+
+static void testSpeed(SPLThreadPool &pool)
+{
+	const SPLVector3i n(256, 256, 256);
+	SPLGrid<SPLuint16> g(n, SPL_GRID_BRICKED);
+	g.fill(1);
+	SPLMacroCells<SPLuint16> m;
+	const std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+	m.build(g, 8, pool);
+	const double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+	check(m.getMin(m.getLevelCount() - 1, 0, 0, 0) == 1, "build large volume");
+	printf("macrocells: build %.1f Mvoxels/s\n", SPLieee64(n.x) * n.y * n.z / 1.0e6 / s);
+}
+
+int main(void)
+{
+	SPLThreadPool pool(4);
+	testBuild(pool);
+	testQueries(pool);
+	testSkipping(pool);
+	testSpeed(pool);
+
+	printf("macrocells: %s\n", failures ? "failed" : "passed");
+	return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
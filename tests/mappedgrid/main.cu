@@ -0,0 +1,189 @@
+// main.cu: Tests of the memory mapped RAW and NIfTI-1 volumes.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include <spl/mappedgrid.hh>
+
+#include "../check.hh"
+
+static bool writeFile(const char *path, const std::vector<SPLuint8> &bytes)
+{
+	FILE *f = fopen(path, "wb");
+	if (f == 0)
+	{
+		return false;
+	}
+	const bool ok = fwrite(&bytes[0], 1, bytes.size(), f) == bytes.size();
+	return fclose(f) == 0 && ok;
+}
+
+template <class T>
+static void put(std::vector<SPLuint8> &bytes, const size_t offset, const T v, const bool swapped = false)
+{
+	memcpy(&bytes[offset], &v, sizeof(T));
+	if (swapped)
+	{
+		for (size_t i = 0; i < sizeof(T) / 2; i++)
+		{
+			const SPLuint8 t = bytes[offset + i];
+			bytes[offset + i] = bytes[offset + sizeof(T) - 1 - i];
+			bytes[offset + sizeof(T) - 1 - i] = t;
+		}
+	}
+}
+
+// a NIfTI-1 header with the voxels at offset 352 ("n+1") or in a separate file ("ni1")
+static std::vector<SPLuint8> header(const SPLVector3i &n, const SPLint16 volumes, const SPLint16 datatype, const SPLint16 bitpix,
+									const bool single, const bool swapped)
+{
+	std::vector<SPLuint8> h(single ? 352 : 348, 0);
+	put<SPLint32>(h, 0, 348, swapped);
+	put<SPLint16>(h, 40, volumes > 1 ? 4 : 3, swapped);
+	put<SPLint16>(h, 42, SPLint16(n.x), swapped);
+	put<SPLint16>(h, 44, SPLint16(n.y), swapped);
+	put<SPLint16>(h, 46, SPLint16(n.z), swapped);
+	put<SPLint16>(h, 48, volumes, swapped);
+	put<SPLint16>(h, 70, datatype, swapped);
+	put<SPLint16>(h, 72, bitpix, swapped);
+	put<SPLieee32>(h, 80, 0.5f, swapped);
+	put<SPLieee32>(h, 84, 0.75f, swapped);
+	put<SPLieee32>(h, 88, 2.0f, swapped);
+	put<SPLieee32>(h, 108, single ? 352.0f : 0.0f, swapped);
+	memcpy(&h[344], single ? "n+1\0" : "ni1\0", 4);
+	return h;
+}
+
+template <class T>
+static void append(std::vector<SPLuint8> &bytes, const SPLint64 voxels, const SPLint64 first)
+{
+	const size_t offset = bytes.size();
+	bytes.resize(offset + size_t(voxels) * sizeof(T));
+	for (SPLint64 i = 0; i < voxels; i++)
+	{
+		put<T>(bytes, offset + size_t(i) * sizeof(T), T((first + i) % 100));
+	}
+}
+
+template <class T>
+static bool matches(const SPLGrid<T> &g, const SPLint64 first)
+{
+	const SPLVector3i &n = g.getSize();
+	for (SPLindex z = 0; z < n.z; z++)
+	{
+		for (SPLindex y = 0; y < n.y; y++)
+		{
+			for (SPLindex x = 0; x < n.x; x++)
+			{
+				if (g(x, y, z) != T((first + (SPLint64(z) * n.y + y) * n.x + x) % 100))
+				{
+					return false;
+				}
+			}
+		}
+	}
+	return true;
+}
+
+static void testRAW(void)
+{
+	const SPLVector3i n(7, 5, 3);
+	std::vector<SPLuint8> bytes(16, 0xFF);
+	append<SPLuint16>(bytes, 105, 0);
+	check(writeFile("mappedgrid.raw", bytes), "write RAW file");
+
+	SPLMappedGrid<SPLuint16> m;
+	check(m.openRAW("mappedgrid.raw", n, 16, SPL_FILEIO_ACCESS_SEQUENTIAL), "open RAW file");
+	check(m.getFormat() == SPL_FILEIO_RAW_ID && m.getGrid().getSize() == n && m.getGrid().isExternal(), "RAW grid");
+	check(matches(m.getGrid(), 0), "RAW voxels");
+	check((const SPLuint8 *)m.getGrid().getData() == m.getFile().getData() + 16, "RAW zero-copy");
+	check(m.getFile().advise(SPL_FILEIO_ACCESS_RANDOM, 16, 100) && m.getFile().prefetch(100, 50), "access hints");
+
+	// a writable copy, e.g. in the bricked layout
+	SPLGrid<SPLuint16> copy(m.getGrid());
+	check(copy.setLayout(SPL_GRID_BRICKED, 4) && matches(copy, 0), "bricked copy");
+
+	check(!m.openRAW("mappedgrid.raw", SPLVector3i(7, 5, 4), 16), "RAW file too small");
+	check(m.getFormat() == SPL_FILEIO_MIN && m.getGrid().getStorageSize() == 0, "failed open leaves an empty grid");
+	check(!m.openRAW("mappedgrid.raw", n, 15), "misaligned voxels");
+	check(!m.openRAW("mappedgrid.missing", n), "missing file");
+	remove("mappedgrid.raw");
+}
+
+static void testNIfTI(void)
+{
+	const SPLVector3i n(6, 4, 5);
+	const SPLint64 voxels = 6 * 4 * 5;
+
+	// single file with two volumes of SPLieee32
+	std::vector<SPLuint8> nii = header(n, 2, 16, 32, true, false);
+	append<SPLieee32>(nii, 2 * voxels, 0);
+	check(writeFile("mappedgrid.nii", nii), "write NIfTI file");
+
+	SPLNIfTIHeader h;
+	check(splReadNIfTIHeader("mappedgrid.nii", h), "read NIfTI header");
+	check(h.size == n && h.volumes == 2 && h.type == SPL_TYPE_IEEE32 && h.bytes == 4 && h.offset == 352, "NIfTI header");
+	check(h.spacing == SPLVector3d(0.5, 0.75, 2.0) && !h.swapped && !h.pair, "NIfTI spacing");
+
+	SPLMappedGrid<SPLieee32> f;
+	check(f.openNIfTI("mappedgrid.nii", SPL_FILEIO_ACCESS_RANDOM), "open NIfTI file");
+	check(f.getFormat() == SPL_FILEIO_NII_ID && f.getSpacing() == h.spacing && matches(f.getGrid(), 0), "NIfTI voxels");
+	check(f.openNIfTI("mappedgrid.nii", SPL_FILEIO_ACCESS_NORMAL, 1) && matches(f.getGrid(), voxels), "2nd volume");
+	check(!f.openNIfTI("mappedgrid.nii", SPL_FILEIO_ACCESS_NORMAL, 2), "volume out of range");
+
+	SPLMappedGrid<SPLint16> wrong;
+	check(!wrong.openNIfTI("mappedgrid.nii"), "data type must match");
+
+	// truncated file
+	nii.resize(nii.size() - 4);
+	check(writeFile("mappedgrid.nii", nii) && !f.openNIfTI("mappedgrid.nii", SPL_FILEIO_ACCESS_NORMAL, 1), "truncated file");
+
+	// .hdr/.img pair with swapped byte order, which is fine for 1 byte voxels
+	std::vector<SPLuint8> img;
+	append<SPLuint8>(img, voxels, 0);
+	check(writeFile("mappedgrid.hdr", header(n, 1, 2, 8, false, true)) && writeFile("mappedgrid.img", img), "write NIfTI pair");
+	SPLMappedGrid<SPLuint8> pair;
+	check(splReadNIfTIHeader("mappedgrid.hdr", h) && h.swapped && h.pair && h.size == n, "swapped header");
+	check(pair.openNIfTI("mappedgrid.img") && matches(pair.getGrid(), 0), "open NIfTI pair");
+
+	// swapped multi byte voxels cannot be mapped
+	check(writeFile("mappedgrid.hdr", header(n, 1, 4, 16, false, true)), "write swapped header");
+	SPLMappedGrid<SPLint16> swapped;
+	check(!swapped.openNIfTI("mappedgrid.hdr"), "swapped 16 bit voxels");
+
+	std::vector<SPLuint8> bad = header(n, 1, 2, 8, true, false);
+	memcpy(&bad[344], "xyz\0", 4);
+	check(splParseNIfTIHeader(&bad[0], SPLint64(bad.size()), h) == false, "missing magic");
+	check(splParseNIfTIHeader(&bad[0], 100, h) == false, "short header");
+
+	// products of the dimensions beyond the field of the volumes and beyond the file
+	std::vector<SPLuint8> big = header(n, 1, 16, 32, true, false);
+	put<SPLint16>(big, 40, 7);
+	for (SPLint32 i = 4; i <= 7; i++)
+	{
+		put<SPLint16>(big, 40 + 2 * i, 32767);
+	}
+	check(!splParseNIfTIHeader(&big[0], SPLint64(big.size()), h), "volumes beyond 32 bits");
+	put<SPLint16>(big, 50, 1);
+	put<SPLint16>(big, 52, 1);
+	put<SPLint16>(big, 54, 1);
+	append<SPLieee32>(big, voxels, 0);
+	check(splParseNIfTIHeader(&big[0], SPLint64(big.size()), h) && h.volumes == 32767, "many volumes");
+	check(writeFile("mappedgrid.nii", big) && !splReadNIfTIHeader("mappedgrid.nii", h) && !f.openNIfTI("mappedgrid.nii"), "volumes beyond the file");
+
+	remove("mappedgrid.nii");
+	remove("mappedgrid.hdr");
+	remove("mappedgrid.img");
+}
+
+int main(void)
+{
+	testRAW();
+	testNIfTI();
+
+	printf("mappedgrid: %s\n", failures ? "failed" : "passed");
+	return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
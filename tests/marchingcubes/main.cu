@@ -0,0 +1,192 @@
+// main.cu: Tests of the marching cubes isosurface extraction.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+#include <spl/marchingcubes.hh>
+
+#include "../check.hh"
+
+// a closed, consistently oriented mesh has every directed edge once and its reverse once
+template <class T>
+static bool watertight(const SPLMarchingCubes<T> &mc, SPLint64 *euler = NULL)
+{
+	const std::vector<SPLuint32> &i = mc.getIndices();
+	std::vector<SPLuint64> edges;
+	for (size_t t = 0; t < i.size(); t += 3)
+	{
+		for (size_t k = 0; k < 3; k++)
+		{
+			const SPLuint32 a = i[t + k], b = i[t + (k + 1) % 3];
+			if (a == b || a >= SPLuint32(mc.getVertexCount()))
+			{
+				return false;
+			}
+			edges.push_back((SPLuint64(a) << 32) | b);
+		}
+	}
+	std::sort(edges.begin(), edges.end());
+	if (std::adjacent_find(edges.begin(), edges.end()) != edges.end())
+	{
+		return false;
+	}
+	for (size_t e = 0; e < edges.size(); e++)
+	{
+		if (!std::binary_search(edges.begin(), edges.end(), (edges[e] << 32) | (edges[e] >> 32)))
+		{
+			return false;
+		}
+	}
+	if (euler)
+	{
+		*euler = SPLint64(mc.getVertexCount()) - SPLint64(edges.size() / 2) + mc.getTriangleCount();
+	}
+	return true;
+}
+
+static void ball(SPLGridf &g, const SPLVector3f &c, const SPLieee32 r)
+{
+	for (SPLGridf::Iterator it = g.begin(); it != g.end(); ++it)
+	{
+		const SPLVector3i &p = it.getPosition();
+		*it = r - SPLieee32((SPLVector3f(SPLieee32(p.x), SPLieee32(p.y), SPLieee32(p.z)) - c).length());
+	}
+}
+
+static void testSphere(SPLThreadPool &pool)
+{
+	const SPLVector3f c(15.5f, 14.2f, 16.1f);
+	const SPLieee32 r = 10.3f;
+	for (SPLindex layout = 0; layout < 2; layout++)
+	{
+		SPLGridf g(SPLVector3i(32, 31, 33), layout ? SPL_GRID_BRICKED : SPL_GRID_LINEAR);
+		ball(g, c, r);
+		SPLMarchingCubes<SPLieee32> mc;
+		check(mc.extract(g, 0.0f, pool), "extract sphere");
+		check(mc.getTriangleCount() > 1000, "sphere triangles");
+
+		SPLint64 euler = 0;
+		check(watertight(mc, &euler), "sphere watertight");
+		check(euler == 2, "sphere Euler characteristic");
+
+		const SPLVector3Arrayf &p = mc.getPositions(), &n = mc.getNormals();
+		bool onSphere = true, outward = true, ccw = true;
+		for (SPLindex v = 0; v < mc.getVertexCount(); v++)
+		{
+			const SPLVector3f d = p.get(v) - c;
+			onSphere = onSphere && fabs(d.length() - r) < 0.05;
+			outward = outward && n.get(v) * d > 0.9f * SPLieee32(d.length());
+		}
+		const std::vector<SPLuint32> &i = mc.getIndices();
+		for (size_t t = 0; t < i.size(); t += 3)
+		{
+			const SPLVector3f a = p.get(i[t]), b = p.get(i[t + 1]), e = p.get(i[t + 2]);
+			ccw = ccw && (b - a).crossProduct(e - a) * (a - c) >= -1.0e-6f;
+		}
+		check(onSphere, "vertices on the sphere");
+		check(outward, "outward normals");
+		check(ccw, "counterclockwise triangles");
+	}
+}
+
+static void testTorus(SPLThreadPool &pool)
+{
+	SPLGridf g(SPLVector3i(40, 40, 20));
+	for (SPLGridf::Iterator it = g.begin(); it != g.end(); ++it)
+	{
+		const SPLVector3i &p = it.getPosition();
+		const SPLieee32 x = SPLieee32(p.x) - 19.5f, y = SPLieee32(p.y) - 19.5f, z = SPLieee32(p.z) - 9.5f;
+		const SPLieee32 q = sqrtf(x * x + y * y) - 12.0f;
+		*it = 5.0f - sqrtf(q * q + z * z);
+	}
+	SPLMarchingCubes<SPLieee32> mc;
+	mc.extract(g, 0.0f, pool);
+	SPLint64 euler = -1;
+	check(watertight(mc, &euler) && euler == 0, "torus");
+}
+
+static void testRandom(SPLThreadPool &pool)
+{
+	// noise exercises all cases including the ambiguous faces
+	srand(7);
+	for (SPLindex round = 0; round < 4; round++)
+	{
+		SPLGrid<SPLuint8> g(SPLVector3i(20 + round, 18, 17));
+		g.fill(0);
+		for (SPLindex z = 1; z < 16; z++)
+		{
+			for (SPLindex y = 1; y < 17; y++)
+			{
+				for (SPLindex x = 1; x < 19 + round; x++)
+				{
+					g(x, y, z) = SPLuint8(1 + rand() % 254);
+				}
+			}
+		}
+		SPLMarchingCubes<SPLuint8> mc;
+		mc.extract(g, 127.5f, pool);
+		check(mc.getTriangleCount() > 0 && watertight(mc), "noise watertight");
+	}
+
+	// the table has every case
+	const SPLMarchingCubesDetail::Table &t = SPLMarchingCubesDetail::getTable();
+	bool cases = t.count[0] == 0 && t.count[255] == 0;
+	for (SPLindex c = 1; c < 255; c++)
+	{
+		cases = cases && t.count[c] > 0;
+	}
+	check(cases, "cases");
+}
+
+static void testThreads(void)
+{
+	SPLGridf g(SPLVector3i(30, 30, 30));
+	ball(g, SPLVector3f(14.0f, 15.0f, 16.0f), 11.0f);
+	SPLThreadPool one(1), four(4);
+	SPLMarchingCubes<SPLieee32> a, b;
+	a.extract(g, 0.5f, one);
+	b.extract(g, 0.5f, four);
+	bool same = a.getIndices() == b.getIndices() && a.getVertexCount() == b.getVertexCount();
+	for (SPLindex v = 0; same && v < a.getVertexCount(); v++)
+	{
+		same = a.getPositions().get(v) == b.getPositions().get(v) && a.getNormals().get(v) == b.getNormals().get(v);
+	}
+	check(same, "same mesh with 1 and 4 threads");
+
+	// no surface
+	a.extract(g, 100.0f, four);
+	check(a.getVertexCount() == 0 && a.getTriangleCount() == 0, "empty mesh");
+	SPLGridf flat(SPLVector3i(5, 5, 1));
+	check(a.extract(flat, 0.0f, four) && a.getTriangleCount() == 0, "single slice");
+}
+
+static void testSpeed(SPLThreadPool &pool)
+{
+	const SPLindex n = 192;
+	SPLGridf g(SPLVector3i(n, n, n));
+	ball(g, SPLVector3f(95.5f, 95.5f, 95.5f), 80.0f);
+	SPLMarchingCubes<SPLieee32> mc;
+	const std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+	mc.extract(g, 0.0f, pool);
+	const double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+	printf("marchingcubes: %d vertices, %lld triangles, %.1f Mvoxels/s\n", mc.getVertexCount(), (long long)mc.getTriangleCount(),
+		   SPLieee64(n) * n * n / 1.0e6 / s);
+}
+
+int main(void)
+{
+	SPLThreadPool pool(4);
+	testSphere(pool);
+	testTorus(pool);
+	testRandom(pool);
+	testThreads();
+	testSpeed(pool);
+
+	printf("marchingcubes: %s\n", failures ? "failed" : "passed");
+	return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,213 @@
+// main.cu: Tests of the lookup tables of materials and the pre-integrated ray casting.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <chrono>
+
+#include <spl/materialtable.hh>
+#include <spl/macrocells.hh>
+#include <spl/raycaster.hh>
+
+#include "../check.hh"
+
+// a thin shell of the values in [0.49, 0.51], transparent elsewhere
+static SPLMaterial shell(void)
+{
+	SPLMaterial m;
+	m.setRange(0.4f, 0.6f);
+	m.setChannel(SPL_MATERIAL_OPACITY, SPL_MATERIAL_APPROX_QUADRATIC, -19.8f, 80.0f, -80.0f);
+	m.setChannel(SPL_MATERIAL_EMISSION_RED, SPL_MATERIAL_APPROX_LINEAR, 0.0f, 1.0f);
+	m.setChannel(SPL_MATERIAL_EMISSION_BLUE, SPL_MATERIAL_APPROX_LINEAR, 1.0f, -1.0f);
+	return m;
+}
+
+static void testTables(SPLThreadPool &pool)
+{
+	SPLMaterial m;
+	m.setChannel(SPL_MATERIAL_OPACITY, SPL_MATERIAL_APPROX_QUADRATIC, 0.1f, 0.2f, 0.3f);
+	m.setChannel(SPL_MATERIAL_DIFFUSE_GREEN, SPL_MATERIAL_APPROX_LINEAR, 0.5f, 0.25f);
+	m.setRange(10.0f, 20.0f);
+	SPLMaterialTable t(65);
+	check(!t.isPreIntegrated() && t.getSize() == 65, "empty tables");
+	check(t.update(m, 1.0f, false, pool) == SPL_MATERIAL_MAX - SPL_MATERIAL_MIN - 1, "first update builds all channels");
+
+	bool same = true;
+	for (SPLenum ch = SPL_MATERIAL_MIN + 1; ch < SPL_MATERIAL_MAX; ch++)
+	{
+		for (SPLindex i = 0; i < 65; i++)
+		{
+			same = same && fabsf(t.getChannel(ch)[i] - m.getChannel(ch, SPLieee32(i) / 64.0f)) < 1.0e-6f;
+		}
+	}
+	check(same, "channel tables");
+	check(t.getIndex(5.0f) == 0 && t.getIndex(15.0f) == 32 && t.getIndex(20.0f) == 64 && t.getIndex(15.08f) == 33, "indices");
+
+	// premultiplied and corrected to the step
+	const SPLieee32 a = m.getChannel(SPL_MATERIAL_OPACITY, 0.5f);
+	check(fabsf(t.getSample(32).w - a) < 1.0e-6f && fabsf(t.getSample(32).x - a) < 1.0e-6f, "premultiplied sample");
+	check(t.update(m, 0.5f, false, pool) == 0, "step changes no channel");
+	check(fabsf(t.getSample(32).w - (1.0f - sqrtf(1.0f - a))) < 1.0e-6f, "opacity correction");
+
+	// only the edited channel
+	check(t.update(m, 0.5f, false, pool) == 0, "unchanged material");
+	m.setChannel(SPL_MATERIAL_SPECULAR_BLUE, 0.75f);
+	check(t.update(m, 0.5f, false, pool) == 1 && t.getChannel(SPL_MATERIAL_SPECULAR_BLUE)[7] == 0.75f, "edited channel");
+	m.setChannel(SPL_MATERIAL_EMISSION_GREEN, 0.5f);
+	check(t.update(m, 0.5f, false, pool) == 1 && fabsf(t.getSample(32).y - 0.5f * t.getSample(32).w) < 1.0e-6f, "edited emission");
+	m.setRange(0.0f, 20.0f);
+	check(t.update(m, 0.5f, false, pool) == 0 && t.getIndex(15.0f) == 48, "range changes no channel");
+
+	// visibility of ranges
+	SPLMaterialTable v(101);
+	v.update(shell(), 1.0f, false, pool);
+	check(!v.isVisible(0, 0) && !v.isVisible(100, 100) && v.isVisible(0, 100) && v.isVisible(50, 50), "visible ranges");
+}
+
+static void testSegments(SPLThreadPool &pool)
+{
+	SPLMaterial m;
+	m.setChannel(SPL_MATERIAL_EMISSION_RED, 0.25f);
+	SPLMaterialTable t(128);
+	t.update(m, 2.0f, true, pool);
+	check(t.isPreIntegrated(), "pre-integrated");
+
+	// a segment of a constant value is a sample
+	bool constant = true, color = true;
+	for (SPLindex i = 0; i < 127; i++)
+	{
+		const SPLVector4f &s = t.getSample(i), &e = t.getSegment(i, i);
+		constant = constant && fabsf(s.w - e.w) < 1.0e-5f && fabsf(s.x - e.x) < 1.0e-5f;
+		for (SPLindex k = 0; k < 128; k += 9)
+		{
+			const SPLVector4f &f = t.getSegment(i, k);
+			color = color && fabsf(f.x - 0.25f * f.w) < 1.0e-5f && f.w >= 0.0f && f.w <= 1.0f;
+		}
+	}
+	check(constant, "constant segments");
+	check(color, "constant color");
+	check(t.getSegment(10, 90).w == t.getSegment(90, 10).w, "symmetric opacity");
+
+	// the integral of a linear opacity ramp
+	const SPLieee64 s0 = 10.0 / 127.0, s1 = 90.0 / 127.0;
+	const SPLieee64 tau = ((1.0 - s1) * log(1.0 - s1) + s1 - (1.0 - s0) * log(1.0 - s0) - s0) / (s1 - s0);
+	check(fabs(t.getSegment(10, 90).w - (1.0 - exp(-2.0 * tau))) < 2.0e-3, "integrated ramp");
+
+	// the shell between two transparent values
+	SPLMaterialTable v(101);
+	v.update(shell(), 4.0f, true, pool);
+	const SPLVector4f &e = v.getSegment(0, 100);
+	check(v.getSample(0).w == 0.0f && v.getSample(100).w == 0.0f && e.w > 0.05f, "thin shell");
+	check(fabsf(e.x - e.z) < 1.0e-3f * e.w, "mean color of the shell");
+	check(t.update(m, 2.0f, false, pool) == 0 && !t.isPreIntegrated(), "disable pre-integration");
+}
+
+// a ramp of the values along the diagonal, such that the shell is a thin plane
+static void ramp(SPLGridf &g)
+{
+	const SPLVector3i &n = g.getSize();
+	for (SPLGridf::Iterator it = g.begin(); it != g.end(); ++it)
+	{
+		const SPLVector3i &p = it.getPosition();
+		*it = SPLieee32(p.x + p.y + p.z) / SPLieee32(n.x + n.y + n.z - 3);
+	}
+}
+
+static SPLieee64 error(const SPLGrid<SPLVector4f> &a, const SPLGrid<SPLVector4f> &b)
+{
+	SPLieee64 e = 0.0;
+	for (SPLindex y = 0; y < a.getSize().y; y++)
+	{
+		for (SPLindex x = 0; x < a.getSize().x; x++)
+		{
+			e += fabs(a(x, y, 0).w - b(x, y, 0).w);
+		}
+	}
+	return e / (SPLieee64(a.getSize().x) * a.getSize().y);
+}
+
+static void testRender(SPLThreadPool &pool)
+{
+	const SPLindex n = 48;
+	SPLGridf g(SPLVector3i(n, n, n), SPL_GRID_BRICKED);
+	ramp(g);
+	const SPLieee32 s = 2.0f / SPLieee32(n - 1);
+	SPLRayCaster<SPLieee32> r;
+	r.setModel(SPLMatrix4f(s, 0.0f, 0.0f, -1.0f, 0.0f, s, 0.0f, -1.0f, 0.0f, 0.0f, s, -1.0f, 0.0f, 0.0f, 0.0f, 1.0f));
+	r.setMaterial(shell());
+	SPLCamera c;
+	c.setLookAt(SPLVector3f(3.0f, 0.5f, 1.0f), SPLVector3f(0.0f, 0.0f, 0.0f), SPLVector3f(0.0f, 1.0f, 0.0f));
+	c.setPerspective(45.0f, 1.0f, 0.1f, 10.0f);
+	c.setViewport(0, 0, 64, 64);
+
+	SPLGrid<SPLVector4f> reference, sampled, integrated, skipped;
+	r.setStepSize(0.125f);
+	check(r.render(g, c, reference, pool), "reference");
+	r.setStepSize(3.0f);
+	r.render(g, c, sampled, pool);
+	r.setPreIntegration(true);
+	check(r.render(g, c, integrated, pool) && r.getMaterialTable().isPreIntegrated(), "pre-integrated rendering");
+	const SPLieee64 e0 = error(reference, sampled), e1 = error(reference, integrated);
+	check(e1 < 0.02 && e1 * 4.0 < e0, "pre-integration of a thin shell");
+
+	// skipping keeps the pre-integrated image
+	SPLMacroCells<SPLieee32> m;
+	m.build(g, 8, pool);
+	r.setStepSize(0.75f);
+	r.render(g, c, integrated, pool);
+	const SPLint64 samples = r.getSamples();
+	r.setMacroCells(&m);
+	r.render(g, c, skipped, pool);
+	bool same = true;
+	for (SPLindex y = 0; y < 64; y++)
+	{
+		for (SPLindex x = 0; x < 64; x++)
+		{
+			same = same && integrated(x, y, 0) == skipped(x, y, 0);
+		}
+	}
+	check(same, "same pre-integrated image with macrocells");
+	check(r.getSamples() * 3 < samples * 2, "skipped pre-integrated samples");
+	printf("materialtable: error %.4f sampled and %.4f pre-integrated, %lld of %lld samples with macrocells\n", e0, e1,
+		   (long long)r.getSamples(), (long long)samples);
+}
+
+static void testSpeed(SPLThreadPool &pool)
+{
+	SPLMaterial m = shell();
+	SPLMaterialTable t;
+	t.update(m, 0.5f, false, pool);
+	const SPLindex count = 4000000;
+	SPLieee32 a = 0.0f, b = 0.0f;
+	std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+	for (SPLindex i = 0; i < count; i++)
+	{
+		const SPLieee32 v = 0.4f + SPLieee32(i & 1023) * 2.0e-4f, s = m.getNormalized(v);
+		const SPLieee32 alpha = 1.0f - powf(1.0f - m.getChannel(SPL_MATERIAL_OPACITY, s), 0.5f);
+		a += alpha * (m.getChannel(SPL_MATERIAL_EMISSION_RED, s) + m.getChannel(SPL_MATERIAL_EMISSION_GREEN, s) +
+					  m.getChannel(SPL_MATERIAL_EMISSION_BLUE, s));
+	}
+	const double t1 = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+	t0 = std::chrono::steady_clock::now();
+	for (SPLindex i = 0; i < count; i++)
+	{
+		const SPLVector4f &e = t.getSample(t.getIndex(0.4f + SPLieee32(i & 1023) * 2.0e-4f));
+		b += e.x + e.y + e.z;
+	}
+	const double t2 = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+	check(fabsf(a - b) < 0.02f * fabsf(a), "same classification");
+	printf("materialtable: %.1f Msamples/s evaluated and %.1f Msamples/s looked up\n", count / 1.0e6 / t1, count / 1.0e6 / t2);
+}
+
+int main(void)
+{
+	SPLThreadPool pool(4);
+	testTables(pool);
+	testSegments(pool);
+	testRender(pool);
+	testSpeed(pool);
+
+	printf("materialtable: %s\n", failures ? "failed" : "passed");
+	return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,174 @@
+// main.cu: Tests of SPLMatrix3/SPLMatrix4 and the batched transformations.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <vector>
+
+#include <spl/typesexte.hh>
+
+#include "../check.hh"
+
+template <class T>
+static bool near(const SPLVector3<T> &a, const SPLVector3<T> &b, const double tol)
+{
+	return fabs(double(a.x - b.x)) <= tol && fabs(double(a.y - b.y)) <= tol && fabs(double(a.z - b.z)) <= tol;
+}
+
+template <class T>
+static bool near(const SPLMatrix4<T> &a, const SPLMatrix4<T> &b, const double tol)
+{
+	for (SPLindex r = 0; r < 4; r++)
+	{
+		for (SPLindex c = 0; c < 4; c++)
+		{
+			if (fabs(double(a(r, c) - b(r, c))) > tol)
+			{
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+template <class T>
+static SPLMatrix4<T> product(const SPLMatrix4<T> &a, const SPLMatrix4<T> &b)
+{
+	SPLMatrix4<T> r;
+	for (SPLindex i = 0; i < 4; i++)
+	{
+		for (SPLindex j = 0; j < 4; j++)
+		{
+			SPLieee64 s = 0.0;
+			for (SPLindex k = 0; k < 4; k++)
+			{
+				s += SPLieee64(a(i, k)) * SPLieee64(b(k, j));
+			}
+			r(i, j) = T(s);
+		}
+	}
+	return r;
+}
+
+template <class T>
+static void testMatrix(const char *name, const double tol)
+{
+	const SPLMatrix4<T> A(T(2), T(1), T(0), T(3),
+						  T(0), T(1), T(-1), T(1),
+						  T(1), T(0), T(4), T(-2),
+						  T(0.5), T(0), T(0), T(1));
+	const SPLMatrix4<T> B = SPLMatrix4<T>::getRotation(SPLVector3<T>(T(1), T(2), T(3)), T(0.7)) *
+							SPLMatrix4<T>::getTranslation(SPLVector3<T>(T(-1), T(2), T(0.5)));
+
+	check(A(0, 3) == T(3) && A.w.x == T(3) && A[3][0] == T(3) && A(3, 0) == T(0.5), name);
+	check(SPLMatrix4<T>() * A == A && A * SPLMatrix4<T>() == A, name);
+	check(near(A * B, product(A, B), tol), name);
+	check(A.getTransposed().getTransposed() == A && A.getTransposed()(1, 2) == A(2, 1), name);
+
+	// inverse
+	const SPLMatrix4<T> I = A.getInverse();
+	check(near(A * I, SPLMatrix4<T>(), tol) && near(I * A, SPLMatrix4<T>(), tol), name);
+	check(near(B * B.getInverse(), SPLMatrix4<T>(), tol), name);
+	check(fabs(double(A.determinant() * I.determinant()) - 1.0) <= tol, name);
+	check(fabs(double(SPLMatrix4<T>::getScaling(SPLVector3<T>(T(2), T(3), T(4))).determinant()) - 24.0) <= tol, name);
+	SPLMatrix4<T> S(A);
+	S.z = S.x * T(2);
+	const SPLMatrix4<T> singular(S);
+	check(!S.invert() && S == singular, name);
+	check(near(SPLMatrix4<T>(A.getMatrix3().getInverse()), SPLMatrix4<T>(A.getMatrix3()).getInverse(), tol), name);
+
+	// transformations of single vectors
+	const SPLMatrix4<T> R = SPLMatrix4<T>::getRotation(SPLVector3<T>(T(0), T(0), T(2)), T(PI / 2));
+	check(near(R.transformPoint(SPLVector3<T>(T(1), T(0), T(0))), SPLVector3<T>(T(0), T(1), T(0)), tol), name);
+	check(near(B.transformPoint(SPLVector3<T>()), SPLVector3<T>(B.w), tol), name);
+	check(near(B.transformVector(SPLVector3<T>(T(1), T(2), T(3))), B * SPLVector3<T>(T(1), T(2), T(3)), tol), name);
+	check(near(A.transformPoint(SPLVector3<T>(T(1), T(1), T(1))), SPLVector3<T>(T(6), T(1), T(3)) / T(1.5), tol), name);
+}
+
+template <class T>
+static void testBatch(const char *name, const double tol)
+{
+	// odd size such that the SIMD tail and several tiles are exercised
+	const SPLsizei n = 10007;
+	SPLThreadPool pool(4);
+	std::vector<SPLVector3<T> > p(n), r(n), q(n);
+	for (SPLindex i = 0; i < n; i++)
+	{
+		p[i] = SPLVector3<T>(T((i % 17) - 8) * T(0.5), T((i % 5) - 2), T((i % 11) - 3) * T(1.5));
+	}
+	const SPLMatrix4<T> affine = SPLMatrix4<T>::getTranslation(SPLVector3<T>(T(1), T(-2), T(3))) *
+								 SPLMatrix4<T>::getRotation(SPLVector3<T>(T(1), T(1), T(0)), T(0.3)) *
+								 SPLMatrix4<T>::getScaling(SPLVector3<T>(T(1), T(4), T(0.5)));
+	const SPLMatrix4<T> projective(T(1), T(0), T(0), T(0),
+								   T(0), T(1), T(0), T(0),
+								   T(0), T(0), T(1), T(0),
+								   T(0), T(0), T(0.1), T(10));
+	const SPLMatrix4<T> *matrices[] = { &affine, &projective };
+	for (int m = 0; m < 2; m++)
+	{
+		const SPLMatrix4<T> &M = *matrices[m];
+		bool ok = true;
+		M.transformPoints(&p[0], &r[0], n, pool);
+		for (SPLindex i = 0; i < n; i++) ok = ok && near(r[i], M.transformPoint(p[i]), tol);
+		check(ok, name);
+
+		// inplace
+		q = p;
+		M.transformPoints(&q[0], &q[0], n, pool);
+		check(q == r, name);
+
+		// SoA
+		SPLVector3Array<T> P(&p[0], n), Q(n);
+		M.transformPoints(P, Q, pool);
+		Q.toAoS(&q[0]);
+		ok = true;
+		for (SPLindex i = 0; i < n; i++) ok = ok && near(q[i], r[i], tol);
+		check(ok, name);
+	}
+
+	// normals stay perpendicular to the transformed tangents and have unit length
+	std::vector<SPLVector3<T> > tangents(n);
+	for (SPLindex i = 0; i < n; i++)
+	{
+		tangents[i] = p[i].crossProduct(SPLVector3<T>(T(0.3), T(1), T(-0.2)));
+	}
+	p[1] = SPLVector3<T>();
+	affine.transformNormals(&p[0], &r[0], n, pool);
+	bool ok = true;
+	for (SPLindex i = 0; i < n; i++)
+	{
+		const SPLVector3<T> t = affine.transformVector(tangents[i]);
+		if (p[i] == SPLVector3<T>())
+		{
+			ok = ok && r[i] == SPLVector3<T>();
+			continue;
+		}
+		ok = ok && fabs(double(r[i] * t)) <= tol * t.length() && fabs(r[i].length() - 1.0) <= tol;
+	}
+	check(ok, name);
+	SPLVector3Array<T> P(&p[0], n);
+	affine.transformNormals(P, P, pool);
+	P.toAoS(&q[0]);
+	ok = true;
+	for (SPLindex i = 0; i < n; i++) ok = ok && near(q[i], r[i], tol);
+	check(ok, name);
+}
+
+int main(void)
+{
+	testMatrix<SPLieee32>("SPLMatrix4f", 1.0e-4);
+	testMatrix<SPLieee64>("SPLMatrix4d", 1.0e-10);
+	testBatch<SPLieee32>("SPLMatrix4f batch", 1.0e-4);
+	testBatch<SPLieee64>("SPLMatrix4d batch", 1.0e-10);
+
+	const SPLMatrix3d m(2.0, 0.0, 1.0,
+						0.0, 3.0, 0.0,
+						-1.0, 0.0, 1.0);
+	check(fabs(m.determinant() - 9.0) < 1.0e-12, "SPLMatrix3d");
+	const SPLMatrix3d mi = m.getInverse() * m;
+	check(near(SPLMatrix4d(mi), SPLMatrix4d(), 1.0e-12), "SPLMatrix3d");
+
+	printf("matrix: %s\n", failures ? "failed" : "passed");
+	return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,180 @@
+// main.cu: Tests of the out-of-core grid and its brick cache.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <vector>
+
+#include <spl/outofcoregrid.hh>
+
+#include "../check.hh"
+
+static SPLieee32 pattern(const SPLindex x, const SPLindex y, const SPLindex z)
+{
+	return SPLieee32(x + 100 * y + 10000 * z);
+}
+
+// written once against the accessor interface of SPLGrid
+template <class G>
+static SPLieee64 laplacian(const G &g, SPLThreadPool &pool)
+{
+	std::vector<SPLieee64> sums(size_t(g.getBlockCount()), 0.0);
+	pool.parallelFor(0, g.getBlockCount(), 1, [&](const SPLint64 first, const SPLint64 last)
+	{
+		for (typename G::ConstIterator it = g.begin(first, last); it != g.end(first, last); ++it)
+		{
+			const SPLieee64 l = SPLieee64(it.getNeighbor(-1, 0, 0)) + it.getNeighbor(1, 0, 0) + it.getNeighbor(0, -1, 0) +
+				it.getNeighbor(0, 1, 0) + it.getNeighbor(0, 0, -1) + it.getNeighbor(0, 0, 1) - 6.0 * (*it);
+			sums[size_t(first)] += l * SPLieee64(it.getPosition().x + 1);
+		}
+	});
+	SPLieee64 s = 0.0;
+	for (size_t i = 0; i < sums.size(); i++)
+	{
+		s += sums[i];
+	}
+	return s;
+}
+
+static void testRoundTrip(SPLThreadPool &pool)
+{
+	const SPLVector3i n(45, 33, 20);
+	SPLGridf g(n);
+	for (SPLGridf::Iterator it = g.begin(); it != g.end(); ++it)
+	{
+		*it = pattern(it.getPosition().x, it.getPosition().y, it.getPosition().z);
+	}
+	check(splWriteOutOfCoreGrid("outofcore.brk", g, 8, pool), "write tiled file");
+
+	// a budget of a few bricks, i.e. most bricks are evicted again
+	SPLOutOfCoreGrid<SPLieee32> o;
+	check(o.open("outofcore.brk", 1), "open tiled file");
+	check(o.getSize() == n && o.getBrickSize() == 8 && o.getBlockCount() == 6 * 5 * 3 && !o.isWritable(), "size");
+	check(o.getCapacity() < o.getBlockCount(), "cache smaller than the grid");
+	const SPLOutOfCoreGrid<SPLieee32> &r = o;
+	bool same = true;
+	for (SPLOutOfCoreGrid<SPLieee32>::ConstIterator it = r.begin(); it != r.end(); ++it)
+	{
+		same = same && *it == g[it.getPosition()];
+	}
+	check(same, "voxels");
+	check(o(44, 32, 19) == pattern(44, 32, 19) && o.getClamped(-3, 40, 7) == pattern(0, 32, 7), "random access");
+
+	const SPLOutOfCoreStats s = o.getStats();
+	check(s.misses >= o.getBlockCount() && s.evictions > 0 && s.writes == 0 && s.errors == 0, "stats");
+	check(laplacian(o, pool) == laplacian(g, pool), "same results as in memory");
+
+	// a brick as a grid
+	SPLVector3i lo, hi;
+	o.getBlock(o.getBlockCount() - 1, lo, hi);
+	const SPLOutOfCoreGrid<SPLieee32>::Brick b = o.getBrick(o.getBlockCount() - 1);
+	check(b.isValid() && b.getGrid().getSize() == hi - lo && b.getGrid()(0, 0, 0) == pattern(lo.x, lo.y, lo.z), "brick view");
+	SPLOutOfCoreGrid<SPLieee32>::Brick c = b;
+	check(c.getIndex() == o.getBlockCount() - 1, "copied handle");
+	c.release();
+	check(!c.isValid() && b.isValid(), "release");
+	check(o.prefetch(0, 10) && o.prefetch(SPLVector3i(3, 3, 3), SPLVector3i(20, 40, 9)), "prefetch");
+
+	SPLOutOfCoreGrid<SPLieee64> wrong;
+	check(!wrong.open("outofcore.brk"), "voxel type must match");
+	check(!wrong.open("outofcore.missing"), "missing file");
+}
+
+static void testWrite(SPLThreadPool &pool)
+{
+	const SPLVector3i n(30, 20, 17);
+	SPLOutOfCoreGrid<SPLuint16> o;
+	check(o.create("outofcore.brk", n, 4, 1) && o.isWritable(), "create tiled file");
+	check(o.getCapacity() == 1, "capacity of the budget");
+	check(o(29, 19, 16) == 0, "zero voxels");
+	pool.parallelFor(0, o.getBlockCount(), 1, [&](const SPLint64 first, const SPLint64 last)
+	{
+		for (SPLOutOfCoreGrid<SPLuint16>::Iterator it = o.begin(first, last); it != o.end(first, last); ++it)
+		{
+			*it = SPLuint16(it.getPosition().x + 7 * it.getPosition().z);
+		}
+	});
+	check(o.set(1, 2, 3, 999), "set");
+	check(o.getStats().writes > 0, "dirty bricks are written back");
+
+	// the bricks are read again while other modified bricks are written back
+	std::vector<char> right(size_t(o.getBlockCount()), 1);
+	pool.parallelFor(0, o.getBlockCount(), 1, [&](const SPLint64 first, const SPLint64 last)
+	{
+		for (SPLOutOfCoreGrid<SPLuint16>::Iterator it = o.begin(first, last); it != o.end(first, last); ++it)
+		{
+			const SPLVector3i &p = it.getPosition();
+			right[size_t(first)] = right[size_t(first)] && *it == ((p.x == 1 && p.y == 2 && p.z == 3) ? 999 : p.x + 7 * p.z);
+			*it = *it;
+		}
+	});
+	bool read = true;
+	for (size_t b = 0; b < right.size(); b++)
+	{
+		read = read && right[b];
+	}
+	check(read && o.getStats().errors == 0, "bricks read after write back");
+	check(o.close(), "close");
+
+	check(o.open("outofcore.brk", 1 << 20), "reopen");
+	SPLOutOfCoreGrid<SPLuint16>::Accessor a(o);
+	bool same = true;
+	for (SPLindex z = 0; z < n.z; z++)
+	{
+		for (SPLindex y = 0; y < n.y; y++)
+		{
+			for (SPLindex x = 0; x < n.x; x++)
+			{
+				same = same && a.get(x, y, z) == ((x == 1 && y == 2 && z == 3) ? 999 : x + 7 * z);
+			}
+		}
+	}
+	a.release();
+	check(same, "written voxels");
+	o.close();
+	remove("outofcore.brk");
+}
+
+static void testBandwidth(SPLThreadPool &pool)
+{
+	// a cache of a tenth of the grid
+	const SPLVector3i n(256, 256, 256);
+	SPLGridf g(n);
+	g.fill(1.0f);
+	check(splWriteOutOfCoreGrid("outofcore.brk", g, 32, pool), "write large file");
+	SPLOutOfCoreGrid<SPLieee32> o;
+	check(o.open("outofcore.brk", SPLint64(n.x) * n.y * n.z * 4 / 10), "open large file");
+	for (SPLindex pass = 0; pass < 2; pass++)
+	{
+		const std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+		const SPLieee64 l = laplacian(o, pool);
+		const double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+		check(l == 0.0, "Laplacian of a constant");
+		printf("outofcoregrid: pass %d, %.1f Mvoxels/s, hit rate %.2f\n", pass, SPLieee64(n.x) * n.y * n.z / 1.0e6 / s, o.getStats().getHitRate());
+	}
+
+	// random access within the resident bricks
+	const std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+	SPLieee64 sum = 0.0;
+	for (SPLindex i = 0; i < 1000000; i++)
+	{
+		sum += o((i * 7) & 63, (i * 13) & 63, (i * 29) & 63);
+	}
+	const double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+	check(sum == 1000000.0, "random access of resident bricks");
+	printf("outofcoregrid: random access %.1f Mvoxels/s\n", 1.0 / s);
+	o.close();
+	remove("outofcore.brk");
+}
+
+int main(void)
+{
+	SPLThreadPool pool(4);
+	testRoundTrip(pool);
+	testWrite(pool);
+	testBandwidth(pool);
+
+	printf("outofcoregrid: %s\n", failures ? "failed" : "passed");
+	return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
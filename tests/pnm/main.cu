@@ -0,0 +1,228 @@
+// main.cu: Tests of the PGM/PPM reader and writer.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <direct.h>
+#define mkdir(path, mode) _mkdir(path)
+#else
+#include <sys/stat.h>
+#endif
+
+#include <spl/pnm.hh>
+
+#include "../check.hh"
+
+static bool writeText(const char *path, const char *text, const size_t n)
+{
+	FILE *f = fopen(path, "wb");
+	if (f == 0)
+	{
+		return false;
+	}
+	const bool ok = fwrite(text, 1, n, f) == n;
+	return fclose(f) == 0 && ok;
+}
+
+static std::vector<SPLuint8> readBytes(const char *path)
+{
+	std::vector<SPLuint8> bytes;
+	FILE *f = fopen(path, "rb");
+	if (f != 0)
+	{
+		SPLuint8 b[4096];
+		for (size_t n = fread(b, 1, sizeof(b), f); n > 0; n = fread(b, 1, sizeof(b), f))
+		{
+			bytes.insert(bytes.end(), b, b + n);
+		}
+		fclose(f);
+	}
+	return bytes;
+}
+
+template <class T>
+static T value(const SPLindex x, const SPLindex y, const SPLindex z, const SPLint32 max)
+{
+	return T((x * 37 + y * 101 + z * 7) % (max + 1));
+}
+
+template <class T>
+static SPLVector3<T> color(const SPLindex x, const SPLindex y, const SPLindex z, const SPLint32 max)
+{
+	return SPLVector3<T>(value<T>(x, y, z, max), value<T>(x + 1, y, z, max), value<T>(x, y + 3, z, max));
+}
+
+template <class T>
+static bool equal(const SPLGrid<T> &a, const SPLGrid<T> &b)
+{
+	const SPLVector3i &n = a.getSize();
+	if (!(n == b.getSize()))
+	{
+		return false;
+	}
+	for (SPLindex z = 0; z < n.z; z++)
+	{
+		for (SPLindex y = 0; y < n.y; y++)
+		{
+			for (SPLindex x = 0; x < n.x; x++)
+			{
+				if (!(a(x, y, z) == b(x, y, z)))
+				{
+					return false;
+				}
+			}
+		}
+	}
+	return true;
+}
+
+template <class T>
+static void testGray(const SPLint32 max, const bool binary, const SPLenum layout)
+{
+	SPLGrid<T> g(SPLVector3i(13, 6, 2), layout, 4);
+	for (typename SPLGrid<T>::Iterator it = g.begin(); it != g.end(); ++it)
+	{
+		*it = value<T>(it.getPosition().x, it.getPosition().y, it.getPosition().z, max);
+	}
+	check(splWritePNM("pnm_gray.pgm", g, 1, binary, max), "write PGM");
+
+	SPLPNMHeader h;
+	const std::vector<SPLuint8> bytes = readBytes("pnm_gray.pgm");
+	check(splParsePNMHeader(&bytes[0], SPLint64(bytes.size()), h), "parse PGM header");
+	check(h.format == SPL_FILEIO_PGM_ID && h.binary == binary && h.width == 13 && h.height == 6 && h.maxval == max, "PGM header");
+	if (binary && max > 255)
+	{
+		// 16 bit samples are big-endian
+		const SPLuint32 v = value<SPLuint32>(1, 0, 1, max);
+		check(bytes[size_t(h.offset) + 2] == (v >> 8) && bytes[size_t(h.offset) + 3] == (v & 0xFF), "big-endian samples");
+	}
+
+	SPLGrid<T> r(SPLVector3i(0, 0, 0), layout, 4);
+	check(splReadPNM("pnm_gray.pgm", r) && r.getSize() == SPLVector3i(13, 6, 1) && r.getLayout() == layout, "read PGM into empty grid");
+	bool same = true;
+	for (SPLindex y = 0; y < 6; y++)
+	{
+		for (SPLindex x = 0; x < 13; x++)
+		{
+			same = same && r(x, y, 0) == g(x, y, 1);
+		}
+	}
+	check(same, "PGM round trip");
+	check(!splReadPNM("pnm_gray.pgm", r, 1), "slice out of range");
+	remove("pnm_gray.pgm");
+}
+
+template <class T>
+static void testColor(const SPLint32 max, const bool binary)
+{
+	typedef SPLVector3<T> C;
+	SPLGrid<C> g(SPLVector3i(5, 7, 1));
+	for (typename SPLGrid<C>::Iterator it = g.begin(); it != g.end(); ++it)
+	{
+		*it = color<T>(it.getPosition().x, it.getPosition().y, it.getPosition().z, max);
+	}
+	SPLGrid<C> r;
+	check(splWritePNM("pnm_color.ppm", g, 0, binary, max), "write PPM");
+	check(splReadPNM("pnm_color.ppm", r) && equal(g, r), "PPM round trip");
+
+	SPLGrid<T> gray;
+	check(!splReadPNM("pnm_color.ppm", gray), "PPM needs vector voxels");
+	remove("pnm_color.ppm");
+}
+
+static void testParser(void)
+{
+	// comments and arbitrary whitespace in the header and between ASCII samples
+	const char text[] = "P2\n# a comment\n3 # width\n 2\n9\n0 1 2\n\n3\t4  5 # trailing\n";
+	check(writeText("pnm_parse.pgm", text, sizeof(text) - 1), "write ASCII PGM");
+	SPLGridub g;
+	check(splReadPNM("pnm_parse.pgm", g) && g.getSize() == SPLVector3i(3, 2, 1), "read ASCII PGM");
+	check(g(0, 0, 0) == 0 && g(2, 0, 0) == 2 && g(0, 1, 0) == 3 && g(2, 1, 0) == 5, "ASCII samples");
+
+	const char big[] = "P5 2 1 65535\n\x12\x34\xAB\xCD";
+	check(writeText("pnm_parse.pgm", big, sizeof(big) - 1), "write 16 bit PGM");
+	SPLGridus s;
+	check(splReadPNM("pnm_parse.pgm", s) && s(0, 0, 0) == 0x1234 && s(1, 0, 0) == 0xABCD, "byte swapping");
+	check(!splReadPNM("pnm_parse.pgm", g), "16 bit samples do not fit into 8 bit voxels");
+
+	const char truncated[] = "P5 4 4 255\n\x01\x02";
+	check(writeText("pnm_parse.pgm", truncated, sizeof(truncated) - 1) && !splReadPNM("pnm_parse.pgm", s), "truncated file");
+	const char range[] = "P2 2 1 7 3 8";
+	check(writeText("pnm_parse.pgm", range, sizeof(range) - 1) && !splReadPNM("pnm_parse.pgm", s), "sample above maxval");
+	remove("pnm_parse.pgm");
+
+	SPLPNMHeader h;
+	const SPLuint8 bad[] = "P7 1 1 255\n";
+	check(!splParsePNMHeader(bad, sizeof(bad) - 1, h), "unknown magic");
+	check(SPLPNMDetail::natural("s9.pgm", "s10.pgm") && !SPLPNMDetail::natural("s10.pgm", "s9.pgm"), "natural order");
+	check(SPLPNMDetail::natural("s009.pgm", "s10.pgm") && SPLPNMDetail::natural("a.pgm", "b.pgm"), "natural order");
+}
+
+static void testDirectory(void)
+{
+	mkdir("pnm_slices", 0755);
+	const SPLVector3i n(64, 48, 20);
+	SPLGridus volume(n);
+	for (SPLGridus::Iterator it = volume.begin(); it != volume.end(); ++it)
+	{
+		*it = value<SPLuint16>(it.getPosition().x, it.getPosition().y, it.getPosition().z, 4095);
+	}
+	// unpadded numbers, i.e. the natural order differs from the lexical one
+	std::vector<std::string> files;
+	for (SPLindex z = 0; z < n.z; z++)
+	{
+		char name[64];
+		snprintf(name, sizeof(name), "pnm_slices/slice%d.pgm", z);
+		check(splWritePNM(name, volume, z, true, 4095), "write slice");
+		files.push_back(name);
+	}
+	check(writeText("pnm_slices/readme.txt", "x", 1), "other file");
+
+	std::vector<std::string> listed;
+	check(splListPNMFiles("pnm_slices", listed) && listed == files, "list slices in natural order");
+
+	SPLThreadPool pool(4);
+	SPLGridus loaded(SPLVector3i(0, 0, 0), SPL_GRID_BRICKED, 8);
+	SPLPNMStats stats;
+	check(splReadPNMDirectory("pnm_slices/", loaded, pool, &stats), "read slice directory");
+	check(loaded.getLayout() == SPL_GRID_BRICKED && equal(volume, loaded), "slices into one volume");
+	check(stats.files == n.z && stats.bytes == SPLint64(n.x) * n.y * n.z * 2 && stats.getMBps() > 0.0, "stats");
+	printf("pnm: %lld slices, %.1f MB/s\n", (long long)stats.files, stats.getMBps());
+
+	SPLGridus small(SPLVector3i(3, 3, 1));
+	check(splWritePNM("pnm_slices/slice99.pgm", small), "write mismatching slice");
+	check(!splReadPNMDirectory("pnm_slices", loaded, pool), "slices must have the same size");
+	remove("pnm_slices/slice99.pgm");
+
+	for (size_t i = 0; i < files.size(); i++)
+	{
+		remove(files[i].c_str());
+	}
+	remove("pnm_slices/readme.txt");
+	remove("pnm_slices");
+}
+
+int main(void)
+{
+	testGray<SPLuint8>(255, true, SPL_GRID_LINEAR);
+	testGray<SPLuint8>(255, true, SPL_GRID_BRICKED);
+	testGray<SPLuint8>(100, false, SPL_GRID_LINEAR);
+	testGray<SPLuint16>(65535, true, SPL_GRID_LINEAR);
+	testGray<SPLuint16>(1000, true, SPL_GRID_BRICKED);
+	testGray<SPLuint16>(4095, false, SPL_GRID_BRICKED);
+	testGray<SPLieee32>(255, true, SPL_GRID_LINEAR);
+	testColor<SPLuint8>(255, true);
+	testColor<SPLuint8>(255, false);
+	testColor<SPLuint16>(65535, true);
+	testColor<SPLuint16>(300, false);
+	testParser();
+	testDirectory();
+
+	printf("pnm: %s\n", failures ? "failed" : "passed");
+	return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
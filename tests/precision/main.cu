@@ -0,0 +1,125 @@
+// main.cu: Accuracy and throughput table of the precision policies for
+// SPLVector3::length/normalize and the SPLVector3Array batch kernels.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <chrono>
+#include <vector>
+
+#include <spl/vector3array.hh>
+
+static int failures = 0;
+
+template <class F>
+static double seconds(const int repeat, F f)
+{
+	std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+	for (int r = 0; r < repeat; r++)
+	{
+		f();
+	}
+	std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+	return std::chrono::duration<double>(t1 - t0).count() / repeat;
+}
+
+template <class T, class P>
+static void row(const char *type, const char *policy, const std::vector<SPLVector3<T> > &v, const double tol)
+{
+	const SPLsizei n = SPLsizei(v.size());
+	const int repeat = 10;
+	std::vector<SPLVector3<T> > r(v);
+	std::vector<T> s(n);
+	SPLVector3Array<T> a(&v[0], n), b(n);
+	double errLength = 0.0, errNormalize = 0.0, errBatch = 0.0;
+
+	// accuracy against long double
+	for (SPLindex i = 0; i < n; i++)
+	{
+		const long double ref = sqrtl((long double)v[i].x * v[i].x + (long double)v[i].y * v[i].y + (long double)v[i].z * v[i].z);
+		errLength = MAX(errLength, double(fabsl(ref - (long double)v[i].template length<P>()) / ref));
+		r[i] = v[i].template getNormalized<P>();
+		const long double len = sqrtl((long double)r[i].x * r[i].x + (long double)r[i].y * r[i].y + (long double)r[i].z * r[i].z);
+		errNormalize = MAX(errNormalize, double(fabsl(len - 1.0L)));
+	}
+	b = a;
+	b.template normalize<P>();
+	for (SPLindex i = 0; i < n; i++)
+	{
+		const SPLVector3<T> u = b.get(i);
+		const long double len = sqrtl((long double)u.x * u.x + (long double)u.y * u.y + (long double)u.z * u.z);
+		errBatch = MAX(errBatch, double(fabsl(len - 1.0L)));
+	}
+
+	// throughput
+	const double tLength = seconds(repeat, [&]()
+	{
+		for (SPLindex i = 0; i < n; i++)
+		{
+			s[i] = T(v[i].template length<P>());
+		}
+	});
+	const double tNormalize = seconds(repeat, [&]()
+	{
+		for (SPLindex i = 0; i < n; i++)
+		{
+			r[i] = v[i];
+			r[i].template normalize<P>();
+		}
+	});
+	const double tBatch = seconds(repeat, [&]()
+	{
+		b = a;
+		b.template normalize<P>();
+	});
+
+	printf("%-10s %-8s %12.3e %12.3e %12.3e %10.1f %10.1f %10.1f\n", type, policy,
+		errLength, errNormalize, errBatch, 1.0e-6 * n / tLength, 1.0e-6 * n / tNormalize, 1.0e-6 * n / tBatch);
+	if (errLength > tol || errNormalize > tol || errBatch > tol)
+	{
+		printf("FAILED: %s %s exceeds %.1e\n", type, policy, tol);
+		failures++;
+	}
+}
+
+template <class T>
+static std::vector<SPLVector3<T> > vectors(const SPLsizei n)
+{
+	std::vector<SPLVector3<T> > v(n);
+	unsigned int seed = 12345u;
+	for (SPLindex i = 0; i < n; i++)
+	{
+		T c[3];
+		for (int k = 0; k < 3; k++)
+		{
+			seed = seed * 1664525u + 1013904223u;
+			c[k] = T(SPLieee64(seed >> 8) / SPLieee64(1 << 24) * 200.0 - 100.0);
+		}
+		v[i] = SPLVector3<T>(c[0], c[1], c[2]);
+		if (v[i].square() == 0.0)
+		{
+			v[i].x = T(1);
+		}
+	}
+	return v;
+}
+
+int main(int argc, char **argv)
+{
+	const SPLsizei n = (argc > 1) ? atoi(argv[1]) : 1000000;
+	const std::vector<SPLVector3f> vf = vectors<SPLieee32>(n);
+	const std::vector<SPLVector3d> vd = vectors<SPLieee64>(n);
+
+	printf("%-10s %-8s %12s %12s %12s %10s %10s %10s\n", "type", "policy",
+		"rel.err len", "err norm", "err batch", "len Mv/s", "norm Mv/s", "batch Mv/s");
+	row<SPLieee32, SPLPrecisionDouble>("SPLieee32", "double", vf, 1.0e-6);
+	row<SPLieee32, SPLPrecisionNative>("SPLieee32", "native", vf, 1.0e-6);
+	row<SPLieee32, SPLPrecisionFast>("SPLieee32", "fast", vf, 2.0e-6);
+	row<SPLieee64, SPLPrecisionDouble>("SPLieee64", "double", vd, 1.0e-14);
+	row<SPLieee64, SPLPrecisionNative>("SPLieee64", "native", vd, 1.0e-14);
+	row<SPLieee64, SPLPrecisionFast>("SPLieee64", "fast", vd, 2.0e-6);
+
+	printf("precision: %s\n", failures ? "failed" : "passed");
+	return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,262 @@
+// main.cu: Tests of the camera, material, lights and the volume ray caster.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <chrono>
+
+#include <spl/raycaster.hh>
+
+#include "../check.hh"
+
+static bool near(const SPLVector3f &a, const SPLVector3f &b, const SPLieee32 eps = 1.0e-4f)
+{
+	return fabsf(a.x - b.x) <= eps && fabsf(a.y - b.y) <= eps && fabsf(a.z - b.z) <= eps;
+}
+
+// a ball of the radius r around c with a smooth boundary
+static void ball(SPLGridf &g, const SPLVector3f &c, const SPLieee32 r)
+{
+	for (SPLGridf::Iterator it = g.begin(); it != g.end(); ++it)
+	{
+		const SPLVector3i &p = it.getPosition();
+		const SPLieee32 d = SPLieee32((SPLVector3f(SPLieee32(p.x), SPLieee32(p.y), SPLieee32(p.z)) - c).length());
+		*it = CLAMP(r - d, 0.0f, 1.0f);
+	}
+}
+
+// maps the voxels of a cube of n voxels to [-1, 1]^3
+static SPLMatrix4f cube(const SPLindex n)
+{
+	const SPLieee32 s = 2.0f / SPLieee32(n - 1);
+	return SPLMatrix4f(s, 0.0f, 0.0f, -1.0f,
+					   0.0f, s, 0.0f, -1.0f,
+					   0.0f, 0.0f, s, -1.0f,
+					   0.0f, 0.0f, 0.0f, 1.0f);
+}
+
+static void testCamera(void)
+{
+	SPLCamera c;
+	check(c.getProjection() == SPL_CAMERA_MATRIX_ORTHO, "default projection");
+	c.setLookAt(SPLVector3f(0.0f, 0.0f, 3.0f), SPLVector3f(0.0f, 0.0f, 0.0f), SPLVector3f(0.0f, 1.0f, 0.0f));
+	c.setOrtho(-2.0f, 2.0f, -1.0f, 1.0f, 1.0f, 5.0f);
+	c.setViewport(0, 0, 200, 100);
+	check(near(c.getMatrix(SPL_CAMERA_MATRIX_MODELVIEW).transformPoint(SPLVector3f(1.0f, 2.0f, 0.0f)), SPLVector3f(1.0f, 2.0f, -3.0f)),
+		  "look at");
+
+	SPLVector3f o, d;
+	SPLCamera::getRay(c.getUnprojection(), 150.0f, 75.0f, o, d);
+	check(near(o, SPLVector3f(1.0f, 0.5f, 2.0f)), "ortho ray origin");
+	check(near(d, SPLVector3f(0.0f, 0.0f, -4.0f)), "ortho ray direction");
+
+	// a model matrix moves the rays into object coordinates
+	SPLCamera::getRay(c.getUnprojection(cube(3)), 100.0f, 50.0f, o, d);
+	check(near(o, SPLVector3f(1.0f, 1.0f, 3.0f)), "object ray origin");
+
+	c.setPerspective(90.0f, 2.0f, 1.0f, 5.0f);
+	check(c.getProjection() == SPL_CAMERA_MATRIX_FRUSTUM, "perspective projection");
+	SPLCamera::getRay(c.getUnprojection(), 200.0f, 100.0f, o, d);
+	check(near(o, SPLVector3f(2.0f, 1.0f, 2.0f)), "perspective ray origin");
+	check(near(o + d, SPLVector3f(10.0f, 5.0f, -2.0f), 1.0e-3f), "perspective ray end");
+}
+
+static void testMaterial(void)
+{
+	SPLMaterial m;
+	check(!m.isShaded(), "default material unshaded");
+	check(m.getChannel(SPL_MATERIAL_OPACITY, 0.25f) == 0.25f, "default opacity");
+	check(near(m.getEmission(0.5f), SPLVector3f(1.0f, 1.0f, 1.0f)), "default emission");
+
+	m.setChannel(SPL_MATERIAL_OPACITY, SPL_MATERIAL_APPROX_QUADRATIC, 0.0f, 1.0f, 4.0f);
+	check(m.getApproximation(SPL_MATERIAL_OPACITY) == SPL_MATERIAL_APPROX_QUADRATIC, "approximation");
+	check(m.getChannel(SPL_MATERIAL_OPACITY, 0.25f) == 0.5f, "quadratic opacity");
+	check(m.getChannel(SPL_MATERIAL_OPACITY, 1.0f) == 1.0f, "clamped opacity");
+	m.setChannel(SPL_MATERIAL_EMISSION_RED, SPL_MATERIAL_APPROX_CONSTANT, 2.0f, 3.0f);
+	check(m.getChannel(SPL_MATERIAL_EMISSION_RED, 1.0f) == 2.0f, "constant ignores higher coefficients");
+
+	m.setRange(100.0f, 300.0f);
+	check(m.getNormalized(150.0f) == 0.25f && m.getNormalized(0.0f) == 0.0f && m.getNormalized(500.0f) == 1.0f, "range");
+	m.setChannel(SPL_MATERIAL_DIFFUSE_GREEN, 0.5f);
+	check(m.isShaded(), "diffuse material shaded");
+}
+
+static void testLight(void)
+{
+	SPLVector3f l;
+	SPLLight d;
+	d.setDirection(SPLVector3f(0.0f, -2.0f, 0.0f));
+	d.setColor(SPLVector3f(0.5f, 0.5f, 0.5f));
+	check(near(d.illuminate(SPLVector3f(7.0f, 7.0f, 7.0f), l), SPLVector3f(0.5f, 0.5f, 0.5f)) && near(l, SPLVector3f(0.0f, 1.0f, 0.0f)),
+		  "directional light");
+
+	SPLLight p(SPL_LIGHT_POIN);
+	p.setPosition(SPLVector3f(0.0f, 0.0f, 4.0f));
+	check(near(p.illuminate(SPLVector3f(0.0f, 0.0f, 1.0f), l), SPLVector3f(1.0f, 1.0f, 1.0f)) && near(l, SPLVector3f(0.0f, 0.0f, 1.0f)),
+		  "point light");
+
+	SPLLight s(SPL_LIGHT_SPOT);
+	s.setPosition(SPLVector3f(0.0f, 0.0f, 5.0f));
+	s.setDirection(SPLVector3f(0.0f, 0.0f, -1.0f));
+	s.setSpot(10.0f, 2.0f);
+	check(near(s.illuminate(SPLVector3f(0.0f, 0.0f, 0.0f), l), SPLVector3f(1.0f, 1.0f, 1.0f)), "spot light axis");
+	check(near(s.illuminate(SPLVector3f(5.0f, 0.0f, 0.0f), l), SPLVector3f(0.0f, 0.0f, 0.0f)), "spot light outside");
+	check(near(s.getTransformed(cube(3)).illuminate(SPLVector3f(-1.0f, -1.0f, 0.0f), l), SPLVector3f(1.0f, 1.0f, 1.0f)), "transformed spot light");
+
+	// Blinn-Phong of a white diffuse material facing the light
+	SPLMaterial m;
+	m.setChannel(SPL_MATERIAL_DIFFUSE_RED, 1.0f);
+	const SPLVector3f r = splShadePhong(m, 0.5f, SPLVector3f(0.0f, 0.0f, 0.0f), SPLVector3f(0.0f, 1.0f, 0.0f), SPLVector3f(0.0f, 1.0f, 0.0f), &d, 1);
+	check(near(r, SPLVector3f(0.5f, 0.0f, 0.0f)), "diffuse shading");
+}
+
+static SPLCamera camera(const SPLindex w, const SPLindex h, const bool perspective)
+{
+	SPLCamera c;
+	c.setLookAt(SPLVector3f(0.0f, 0.0f, 3.0f), SPLVector3f(0.0f, 0.0f, 0.0f), SPLVector3f(0.0f, 1.0f, 0.0f));
+	if (perspective)
+	{
+		c.setPerspective(60.0f, SPLieee32(w) / SPLieee32(h), 0.1f, 10.0f);
+	}
+	else
+	{
+		c.setOrtho(-1.2f, 1.2f, -1.2f, 1.2f, 0.1f, 10.0f);
+	}
+	c.setViewport(0, 0, w, h);
+	return c;
+}
+
+static void testRender(SPLThreadPool &pool)
+{
+	const SPLindex n = 48;
+	SPLGridf g(SPLVector3i(n, n, n), SPL_GRID_BRICKED);
+	ball(g, SPLVector3f(23.5f, 23.5f, 23.5f), 20.0f);
+
+	SPLRayCaster<SPLieee32> r;
+	r.setModel(cube(n));
+	SPLGrid<SPLVector4f> frame;
+	for (SPLindex perspective = 0; perspective < 2; perspective++)
+	{
+		check(r.render(g, camera(64, 48, perspective != 0), frame, pool), "render");
+		check(frame.getSize() == SPLVector3i(64, 48, 1), "frame size");
+		check(frame(32, 24, 0).w >= 0.99f && frame(32, 24, 0).w <= 1.0f, "opaque center");
+		check(frame(32, 24, 0).x == frame(32, 24, 0).w, "white emission");
+		check(frame(0, 0, 0).w == 0.0f && frame(63, 47, 0).w == 0.0f, "transparent corners");
+	}
+
+	// the first row is the top of the image
+	ball(g, SPLVector3f(40.0f, 40.0f, 23.5f), 6.0f);
+	r.render(g, camera(64, 64, false), frame, pool);
+	check(frame(52, 11, 0).w > 0.5f, "top right ball");
+	check(frame(11, 52, 0).w == 0.0f && frame(11, 11, 0).w == 0.0f && frame(52, 52, 0).w == 0.0f, "empty quadrants");
+}
+
+static void testThreads(void)
+{
+	const SPLindex n = 40;
+	SPLGridf g(SPLVector3i(n, n, n));
+	ball(g, SPLVector3f(19.5f, 17.0f, 21.0f), 15.0f);
+	SPLMaterial m;
+	m.setChannel(SPL_MATERIAL_OPACITY, SPL_MATERIAL_APPROX_LINEAR, 0.0f, 0.1f);
+	SPLRayCaster<SPLieee32> r;
+	r.setModel(cube(n));
+	r.setMaterial(m);
+	r.setTileSize(7);
+
+	SPLThreadPool one(1), four(4);
+	SPLGrid<SPLVector4f> a, b;
+	r.render(g, camera(50, 30, true), a, one);
+	const SPLint64 terminated = r.getSamples();
+	r.render(g, camera(50, 30, true), b, four);
+	check(r.getSamples() == terminated, "same samples");
+	bool same = true;
+	for (SPLindex y = 0; y < 30; y++)
+	{
+		for (SPLindex x = 0; x < 50; x++)
+		{
+			same = same && a(x, y, 0).x == b(x, y, 0).x && a(x, y, 0).w == b(x, y, 0).w;
+		}
+	}
+	check(same, "same frame with 1 and 4 threads");
+
+	// early ray termination
+	r.setMaterial(SPLMaterial());
+	r.render(g, camera(50, 30, true), a, four);
+	const SPLint64 early = r.getSamples();
+	r.setTermination(2.0f);
+	r.render(g, camera(50, 30, true), a, four);
+	check(early > 0 && early < r.getSamples(), "fewer samples with early ray termination");
+	printf("raycaster: %lld samples with and %lld without early ray termination\n", (long long)early, (long long)r.getSamples());
+}
+
+static void testShading(SPLThreadPool &pool)
+{
+	const SPLindex n = 48;
+	SPLGridf g(SPLVector3i(n, n, n));
+	ball(g, SPLVector3f(23.5f, 23.5f, 23.5f), 20.0f);
+	SPLMaterial m;
+	m.setChannel(SPL_MATERIAL_EMISSION_RED, 0.0f);
+	m.setChannel(SPL_MATERIAL_EMISSION_GREEN, 0.0f);
+	m.setChannel(SPL_MATERIAL_EMISSION_BLUE, 0.0f);
+	m.setChannel(SPL_MATERIAL_DIFFUSE_RED, 1.0f);
+	SPLRayCaster<SPLieee32> r;
+	r.setModel(cube(n));
+	r.setMaterial(m);
+
+	SPLGrid<SPLVector4f> f;
+	r.render(g, camera(32, 32, false), f, pool);
+	check(f(16, 16, 0).x == 0.0f, "no light, no color");
+
+	SPLLight front;
+	front.setDirection(SPLVector3f(0.0f, 0.0f, -1.0f));
+	r.addLight(front);
+	r.render(g, camera(32, 32, false), f, pool);
+	const SPLieee32 center = f(16, 16, 0).x, rim = f(16, 6, 0).x;
+	check(center > 0.5f && f(16, 16, 0).y == 0.0f, "lit center");
+	check(rim < center, "darker rim");
+
+	r.clearLights();
+	SPLLight back;
+	back.setDirection(SPLVector3f(0.0f, 0.0f, 1.0f));
+	r.addLight(back);
+	r.render(g, camera(32, 32, false), f, pool);
+	check(f(16, 16, 0).x < 0.1f * center, "back light");
+}
+
+static void testSpeed(SPLThreadPool &pool)
+{
+	const SPLindex n = 128;
+	SPLGridf g(SPLVector3i(n, n, n), SPL_GRID_BRICKED);
+	ball(g, SPLVector3f(63.5f, 63.5f, 63.5f), 60.0f);
+	SPLMaterial m;
+	m.setChannel(SPL_MATERIAL_OPACITY, SPL_MATERIAL_APPROX_LINEAR, 0.0f, 0.05f);
+	SPLRayCaster<SPLieee32> r;
+	r.setModel(cube(n));
+	r.setMaterial(m);
+	SPLGrid<SPLVector4f> f;
+
+	const SPLindex frames = 4;
+	const std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+	for (SPLindex i = 0; i < frames; i++)
+	{
+		r.render(g, camera(256, 256, true), f, pool);
+	}
+	const double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+	printf("raycaster: %.1f fps, %.1f Msamples/s (256x256, 128^3)\n", frames / s, SPLieee64(r.getSamples()) * frames / 1.0e6 / s);
+}
+
+int main(void)
+{
+	SPLThreadPool pool(4);
+	testCamera();
+	testMaterial();
+	testLight();
+	testRender(pool);
+	testThreads();
+	testShading(pool);
+	testSpeed(pool);
+
+	printf("raycaster: %s\n", failures ? "failed" : "passed");
+	return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,240 @@
+// main.cu: Tests of the batched interpolation of grids.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <chrono>
+
+#include <spl/sampler.hh>
+
+#include "../check.hh"
+
+static const SPLenum filters[3] = { SPL_SAMPLER_NEAREST, SPL_SAMPLER_LINEAR, SPL_SAMPLER_CUBIC };
+static const SPLenum borders[2] = { SPL_BORDER_CLAMP, SPL_BORDER_WRAP };
+
+template <class T>
+static void random(SPLGrid<T> &g, const double scale)
+{
+	srand(3);
+	for (typename SPLGrid<T>::Iterator it = g.begin(); it != g.end(); ++it)
+	{
+		*it = T(scale * rand() / RAND_MAX);
+	}
+}
+
+// random points in and around the grid
+static void points(SPLVector3Arrayf &p, const SPLVector3i &n)
+{
+	srand(9);
+	for (SPLindex i = 0; i < p.size(); i++)
+	{
+		p.set(i, SPLVector3f(SPLieee32(n.x + 10) * rand() / RAND_MAX - 5.0f, SPLieee32(n.y + 10) * rand() / RAND_MAX - 5.0f,
+							 SPLieee32(n.z + 10) * rand() / RAND_MAX - 5.0f));
+	}
+}
+
+// the voxel of a coordinate outside the grid
+static SPLindex outside(const SPLindex i, const SPLindex n, const SPLenum border)
+{
+	return (border == SPL_BORDER_WRAP) ? ((i % n) + n) % n : CLAMP(i, 0, n - 1);
+}
+
+// the taps and weights of one axis
+static SPLindex taps(const double c, const SPLenum filter, double *w)
+{
+	const double f = floor(c), t = c - f;
+	if (filter == SPL_SAMPLER_NEAREST)
+	{
+		w[0] = 1.0;
+		return SPLindex(floor(c + 0.5));
+	}
+	if (filter == SPL_SAMPLER_LINEAR)
+	{
+		w[0] = 1.0 - t;
+		w[1] = t;
+		return SPLindex(f);
+	}
+	w[0] = 0.5 * (-t * t * t + 2.0 * t * t - t);
+	w[1] = 0.5 * (3.0 * t * t * t - 5.0 * t * t + 2.0);
+	w[2] = 0.5 * (-3.0 * t * t * t + 4.0 * t * t + t);
+	w[3] = 0.5 * (t * t * t - t * t);
+	return SPLindex(f) - 1;
+}
+
+// scalar interpolation of one point
+template <class T>
+static double reference(const SPLGrid<T> &g, const SPLVector3f &p, const SPLenum filter, const SPLenum border)
+{
+	const SPLVector3i &n = g.getSize();
+	const SPLindex k = (filter == SPL_SAMPLER_NEAREST) ? 1 : ((filter == SPL_SAMPLER_LINEAR) ? 2 : 4);
+	double wx[4], wy[4], wz[4];
+	const SPLindex x = taps(p.x, filter, wx), y = taps(p.y, filter, wy), z = taps(p.z, filter, wz);
+	double sum = 0.0;
+	for (SPLindex c = 0; c < k; c++)
+	{
+		for (SPLindex b = 0; b < k; b++)
+		{
+			for (SPLindex a = 0; a < k; a++)
+			{
+				sum += wx[a] * wy[b] * wz[c] * double(g(outside(x + a, n.x, border), outside(y + b, n.y, border), outside(z + c, n.z, border)));
+			}
+		}
+	}
+	return sum;
+}
+
+template <class T>
+static void testFilters(const double scale)
+{
+	SPLGrid<T> g(SPLVector3i(19, 12, 7), SPL_GRID_BRICKED, 4);
+	random(g, scale);
+	SPLVector3Arrayf p(1001);
+	points(p, g.getSize());
+	std::vector<SPLieee32> v(p.size());
+	SPLSampler<T> s;
+	for (SPLindex f = 0; f < 3; f++)
+	{
+		for (SPLindex b = 0; b < 2; b++)
+		{
+			check(s.setVolume(g, filters[f], borders[b]), "sampler");
+			s.sample(p, &v[0]);
+			double worst = 0.0;
+			for (SPLindex i = 0; i < p.size(); i++)
+			{
+				worst = MAX(worst, fabs(v[size_t(i)] - reference(g, p.get(i), filters[f], borders[b])));
+			}
+			check(worst < 1.0e-5 * fabs(scale), "batched against scalar interpolation");
+		}
+	}
+
+	// the cubic filter passes through the voxels
+	s.setVolume(g, SPL_SAMPLER_CUBIC, SPL_BORDER_CLAMP);
+	check(fabs(s(SPLVector3f(5.0f, 3.0f, 2.0f)) - SPLieee32(g(5, 3, 2))) < 1.0e-5 * fabs(scale), "cubic interpolation of a voxel");
+	check(s.getFilter() == SPL_SAMPLER_CUBIC && s.getBorder() == SPL_BORDER_CLAMP && s.getVolume() == &g, "settings");
+}
+
+template <class T>
+static void testFixed(const double scale)
+{
+	SPLGrid<T> g(SPLVector3i(33, 17, 9));
+	random(g, scale);
+	SPLVector3Arrayf p(777);
+	points(p, g.getSize());
+	SPLVector3Arrayi q(p.size());
+	SPLSampler<T>::toFixed(p, q);
+	check(q.get(5).x == SPLint32(floor(p.get(5).x * 65536.0f)), "fixed point coordinates");
+
+	std::vector<T> v(p.size());
+	std::vector<SPLieee32> f(p.size());
+	SPLSampler<T> s;
+	for (SPLindex m = 0; m < 3; m++)
+	{
+		for (SPLindex b = 0; b < 2; b++)
+		{
+			s.setVolume(g, filters[m], borders[b]);
+			s.sample(q, &v[0]);
+			s.sample(p, &f[0]);
+			double worst = 0.0;
+			for (size_t i = 0; i < v.size(); i++)
+			{
+				const SPLieee32 clamped = CLAMP(f[i], 0.0f, SPLieee32(std::numeric_limits<T>::max()));
+				worst = MAX(worst, fabs(double(v[i]) - clamped));
+			}
+			// the weights have 12 bits and every interpolation rounds
+			check(worst <= ((filters[m] == SPL_SAMPLER_NEAREST) ? 0.0 : 2.0 + 3.0 * scale / 4096.0), "fixed point interpolation");
+		}
+	}
+}
+
+// time of a batch in seconds
+template <class F>
+static double timing(F f)
+{
+	const std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+	f();
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+// the trilinear interpolation of one point inside the grid as done per sample so far
+template <class T>
+static SPLieee32 scalar(const SPLGrid<T> &g, const SPLVector3f &p)
+{
+	const SPLVector3i &n = g.getSize(), i = p.getFLOORint();
+	const SPLint64 *ox = g.getOffsets(0), *oy = g.getOffsets(1), *oz = g.getOffsets(2);
+	const T *data = g.getData();
+	const SPLindex x1 = MIN(i.x + 1, n.x - 1), y1 = MIN(i.y + 1, n.y - 1), z1 = MIN(i.z + 1, n.z - 1);
+	const SPLieee32 fx = p.x - i.x, fy = p.y - i.y, fz = p.z - i.z;
+	const SPLint64 a = oy[i.y] + oz[i.z], b = oy[y1] + oz[i.z], c = oy[i.y] + oz[z1], d = oy[y1] + oz[z1];
+	const SPLieee32 v00 = data[ox[i.x] + a] + fx * (data[ox[x1] + a] - data[ox[i.x] + a]);
+	const SPLieee32 v10 = data[ox[i.x] + b] + fx * (data[ox[x1] + b] - data[ox[i.x] + b]);
+	const SPLieee32 v01 = data[ox[i.x] + c] + fx * (data[ox[x1] + c] - data[ox[i.x] + c]);
+	const SPLieee32 v11 = data[ox[i.x] + d] + fx * (data[ox[x1] + d] - data[ox[i.x] + d]);
+	const SPLieee32 v0 = v00 + fy * (v10 - v00), v1 = v01 + fy * (v11 - v01);
+	return v0 + fz * (v1 - v0);
+}
+
+// times of 256K points per sample, batched, fixed point and tricubic
+template <class T>
+static void timings(const SPLindex n, const SPLindex runs, double *t)
+{
+	SPLGrid<T> g(SPLVector3i(n, n, n), SPL_GRID_BRICKED, 8);
+	random(g, 200.0);
+	SPLVector3Arrayf p(1 << 18);
+	srand(1);
+	for (SPLindex i = 0; i < p.size(); i++)
+	{
+		const SPLieee32 s = SPLieee32(n - 1) / RAND_MAX;
+		p.set(i, SPLVector3f(s * rand(), s * rand(), s * rand()));
+	}
+	SPLVector3Arrayi q(p.size());
+	SPLSampler<T>::toFixed(p, q);
+	std::vector<SPLieee32> v(p.size());
+	std::vector<T> u(p.size());
+	SPLSampler<T> s;
+	s.setVolume(g, SPL_SAMPLER_LINEAR);
+
+	// the best of alternating runs
+	double sum = 0.0;
+	t[0] = t[1] = t[2] = 1.0e9;
+	for (SPLindex r = 0; r < runs; r++)
+	{
+		t[0] = MIN(t[0], timing([&]() { for (SPLindex i = 0; i < p.size(); i++) v[size_t(i)] = scalar(g, p.get(i)); }));
+		sum += v[7];
+		t[1] = MIN(t[1], timing([&]() { s.sample(p, &v[0]); }));
+		sum += v[7];
+		if constexpr (std::numeric_limits<T>::is_integer)
+		{
+			t[2] = MIN(t[2], timing([&]() { s.sample(q, &u[0]); }));
+			sum += u[7];
+		}
+	}
+	t[2] = std::numeric_limits<T>::is_integer ? t[2] : 0.0;
+	s.setFilter(SPL_SAMPLER_CUBIC);
+	t[3] = timing([&]() { s.sample(p, &v[0]); });
+	check(sum > 0.0, "interpolated values");
+}
+
+template <class T>
+static void testTiming(const char *name)
+{
+	// a cached grid, where the instructions per point bound the time (printed only, the timings depend on the build and the load)
+	double t[4];
+	timings<T>(64, 2, t);
+	printf("sampler %s: 256K points in 64^3 scalar %.3f s, trilinear %.3f s, fixed point %.3f s, tricubic %.3f s\n", name, t[0], t[1], t[2], t[3]);
+}
+
+int main(void)
+{
+	testFilters<SPLieee32>(1.0);
+	testFilters<SPLuint16>(60000.0);
+	testFilters<SPLuint8>(250.0);
+	testFilters<SPLint16>(-30000.0);
+	testFixed<SPLuint8>(250.0);
+	testFixed<SPLuint16>(60000.0);
+	testTiming<SPLieee32>("float");
+	testTiming<SPLuint16>("uint16");
+
+	printf("sampler: %s\n", failures ? "failed" : "passed");
+	return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,210 @@
+// main.cu: Tests of the batched Phong shading and the fast pow of the SIMD registers.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <chrono>
+#include <vector>
+
+#include <spl/shading.hh>
+
+#include "../check.hh"
+
+static SPLieee32 random(const SPLieee32 a, const SPLieee32 b)
+{
+	return a + (b - a) * SPLieee32(rand()) / RAND_MAX;
+}
+
+static void testPow(void)
+{
+	// the registers and the remaining elements
+	const SPLsizei n = 4099;
+	std::vector<SPLieee32> a(size_t(n), 0.0f), b(size_t(n), 0.0f), c(size_t(n), 0.0f);
+	srand(7);
+	for (SPLindex i = 0; i < n; i++)
+	{
+		a[i] = (i < 8) ? SPLieee32(i) / 7.0f : random(0.0f, 1.0f);
+		b[i] = (i % 5 == 0) ? 0.0f : random(0.0f, 128.0f);
+	}
+	splSimdForEach<SPLieee32>(n, [&](auto simd, const SPLindex i)
+	{
+		typedef decltype(simd) S;
+		S::store(&c[0] + i, S::pow(S::load(&a[0] + i), S::load(&b[0] + i)));
+	});
+	SPLieee64 worst = 0.0;
+	bool small = true;
+	for (SPLindex i = 0; i < n; i++)
+	{
+		const SPLieee64 r = pow(SPLieee64(a[i]), SPLieee64(b[i]));
+		if (r > 1.0e-30)
+		{
+			worst = MAX(worst, fabs(c[i] - r) / r / MAX(SPLieee64(b[i]), 1.0));
+		}
+		else
+		{
+			small = small && c[i] < 1.0e-30f;
+		}
+	}
+	check(worst < 2.0e-5, "relative error of pow");
+	check(small, "pow of tiny values");
+
+	typedef SPLSimdScalar<SPLieee32> S;
+	check(S::pow(1.0f, 64.0f) == 1.0f && S::pow(0.5f, 0.0f) == 1.0f && S::pow(0.0f, 0.0f) == 1.0f, "exact pow");
+	check(S::exp2(3.0f) == 8.0f && S::exp2(-2.0f) == 0.25f && S::log2(16.0f) == 4.0f && S::log2(0.125f) == -3.0f, "powers of two");
+	check(S::exp2(-1000.0f) > 0.0f && S::exp2(1000.0f) < 1.8e38f && S::log2(0.0f) == -126.0f, "clamped exponents");
+	check(S::selectNegative(-1.0f, 1.0f, 2.0f) == 1.0f && S::selectNegative(0.0f, 1.0f, 2.0f) == 2.0f, "select negative");
+	printf("shading: pow with a relative error of %.2g per unit exponent\n", worst);
+}
+
+static SPLMaterial material(void)
+{
+	SPLMaterial m;
+	m.setChannel(SPL_MATERIAL_AMBIENT_RED, SPL_MATERIAL_APPROX_LINEAR, 0.1f, 0.1f);
+	m.setChannel(SPL_MATERIAL_AMBIENT_BLUE, 0.05f);
+	m.setChannel(SPL_MATERIAL_DIFFUSE_RED, SPL_MATERIAL_APPROX_LINEAR, 0.8f, -0.5f);
+	m.setChannel(SPL_MATERIAL_DIFFUSE_GREEN, SPL_MATERIAL_APPROX_LINEAR, 0.2f, 0.6f);
+	m.setChannel(SPL_MATERIAL_DIFFUSE_BLUE, 0.5f);
+	m.setChannel(SPL_MATERIAL_SPECULAR_RED, 0.4f);
+	m.setChannel(SPL_MATERIAL_SPECULAR_GREEN, SPL_MATERIAL_APPROX_LINEAR, 0.0f, 0.7f);
+	m.setChannel(SPL_MATERIAL_SPECULAR_BLUE, 0.3f);
+	m.setChannel(SPL_MATERIAL_SHININESS, SPL_MATERIAL_APPROX_LINEAR, 2.0f, 62.0f);
+	return m;
+}
+
+static std::vector<SPLLight> lights(void)
+{
+	std::vector<SPLLight> l(5);
+	l[0].setDirection(SPLVector3f(1.0f, -1.0f, -0.5f));
+	l[0].setColor(SPLVector3f(0.6f, 0.6f, 0.5f));
+	l[1] = SPLLight(SPL_LIGHT_POIN);
+	l[1].setPosition(SPLVector3f(2.0f, 3.0f, 1.0f));
+	l[1].setColor(SPLVector3f(0.2f, 0.3f, 0.4f));
+	l[2] = SPLLight(SPL_LIGHT_SPOT);
+	l[2].setPosition(SPLVector3f(0.0f, 0.0f, 4.0f));
+	l[2].setDirection(SPLVector3f(0.0f, 0.1f, -1.0f));
+	l[2].setSpot(25.0f, 8.0f);
+	l[3] = SPLLight(SPL_LIGHT_SPOT);
+	l[3].setPosition(SPLVector3f(-3.0f, 0.0f, 0.0f));
+	l[3].setDirection(SPLVector3f(1.0f, 0.0f, 0.0f));
+	l[3].setSpot(40.0f, 0.0f);
+	l[3].setColor(SPLVector3f(0.5f, 0.1f, 0.1f));
+	l[4].setColor(SPLVector3f(0.0f, 0.0f, 0.0f));
+	return l;
+}
+
+// random samples, some at the lights, with zero normals and facing away from the viewer
+static void samples(const SPLMaterialTable &t, std::vector<SPLindex> &m, SPLVector3Arrayf &p, SPLVector3Arrayf &n, SPLVector3Arrayf &v)
+{
+	srand(11);
+	for (SPLindex i = 0; i < p.size(); i++)
+	{
+		m[i] = t.getIndex(random(0.0f, 1.0f));
+		p.set(i, (i % 97 == 0) ? SPLVector3f(0.0f, 0.0f, 4.0f) : SPLVector3f(random(-1.0f, 1.0f), random(-1.0f, 1.0f), random(-1.0f, 1.0f)));
+		const SPLVector3f d(random(-1.0f, 1.0f), random(-1.0f, 1.0f), random(-1.0f, 1.0f));
+		n.set(i, (i % 89 == 0) ? SPLVector3f(0.0f, 0.0f, 0.0f) : d.getNormalized(1.0f));
+		v.set(i, (SPLVector3f(0.5f, 1.0f, 5.0f) - p.get(i)).getNormalized(1.0f));
+	}
+}
+
+static SPLVector3f reference(const SPLMaterialTable &t, const SPLindex m, const SPLVector3f &p, const SPLVector3f &n,
+							 const SPLVector3f &v, const std::vector<SPLLight> &l)
+{
+	const SPLVector3f ka(t.getChannel(SPL_MATERIAL_AMBIENT_RED)[m], t.getChannel(SPL_MATERIAL_AMBIENT_GREEN)[m],
+						 t.getChannel(SPL_MATERIAL_AMBIENT_BLUE)[m]);
+	const SPLVector3f kd(t.getChannel(SPL_MATERIAL_DIFFUSE_RED)[m], t.getChannel(SPL_MATERIAL_DIFFUSE_GREEN)[m],
+						 t.getChannel(SPL_MATERIAL_DIFFUSE_BLUE)[m]);
+	const SPLVector3f ks(t.getChannel(SPL_MATERIAL_SPECULAR_RED)[m], t.getChannel(SPL_MATERIAL_SPECULAR_GREEN)[m],
+						 t.getChannel(SPL_MATERIAL_SPECULAR_BLUE)[m]);
+	return splShadePhong(ka, kd, ks, t.getChannel(SPL_MATERIAL_SHININESS)[m], p, n, v, &l[0], SPLsizei(l.size()));
+}
+
+static void testShading(SPLThreadPool &pool)
+{
+	SPLMaterialTable t;
+	t.update(material(), 1.0f, false, pool);
+	const std::vector<SPLLight> l = lights();
+
+	// more than one chunk and not a multiple of the register width
+	const SPLsizei count = 3 * SPL_SHADING_CHUNK + 13;
+	std::vector<SPLindex> m(size_t(count), 0);
+	SPLVector3Arrayf p(count), n(count), v(count), c(count);
+	samples(t, m, p, n, v);
+	splShadePhong(t, &m[0], p, n, v, &l[0], SPLsizei(l.size()), c);
+
+	SPLieee32 worst = 0.0f;
+	bool ambient = true;
+	for (SPLindex i = 0; i < count; i++)
+	{
+		const SPLVector3f r = reference(t, m[i], p.get(i), n.get(i), v.get(i), l), d = c.get(i) - r;
+		worst = MAX(worst, MAX(fabsf(d.x), MAX(fabsf(d.y), fabsf(d.z))));
+		if (i % 89 == 0)
+		{
+			ambient = ambient && fabsf(d.x) < 1.0e-5f && fabsf(d.y) < 1.0e-5f && fabsf(d.z) < 1.0e-5f;
+		}
+	}
+	check(worst < 2.0e-3f, "same shading as a single voxel");
+	check(ambient, "ambient light of zero normals");
+
+	// the types of the lights one by one
+	bool types = true;
+	for (size_t k = 0; k < l.size(); k++)
+	{
+		splShadePhong(t, &m[0], p, n, v, &l[k], 1, c);
+		for (SPLindex i = 0; i < count; i++)
+		{
+			const SPLVector3f r = reference(t, m[i], p.get(i), n.get(i), v.get(i), std::vector<SPLLight>(1, l[k])), d = c.get(i) - r;
+			types = types && fabsf(d.x) < 2.0e-3f && fabsf(d.y) < 2.0e-3f && fabsf(d.z) < 2.0e-3f;
+		}
+	}
+	check(types, "each type of light");
+
+	// no lights
+	splShadePhong(t, &m[0], p, n, v, 0, 0, c);
+	check(c.get(0) == SPLVector3f(0.0f, 0.0f, 0.0f) && c.get(count - 1) == SPLVector3f(0.0f, 0.0f, 0.0f), "no lights");
+	printf("shading: maximum difference %.2g to the single voxel shading\n", worst);
+}
+
+static void testSpeed(SPLThreadPool &pool)
+{
+	SPLMaterialTable t;
+	t.update(material(), 1.0f, false, pool);
+	const std::vector<SPLLight> l = lights();
+	const SPLsizei count = 65536, repeat = 8;
+	std::vector<SPLindex> m(size_t(count), 0);
+	SPLVector3Arrayf p(count), n(count), v(count), c(count);
+	samples(t, m, p, n, v);
+
+	SPLieee32 a = 0.0f;
+	std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+	for (SPLindex k = 0; k < repeat; k++)
+	{
+		for (SPLindex i = 0; i < count; i++)
+		{
+			a += reference(t, m[i], p.get(i), n.get(i), v.get(i), l).x;
+		}
+	}
+	const double t1 = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+	SPLieee32 b = 0.0f;
+	t0 = std::chrono::steady_clock::now();
+	for (SPLindex k = 0; k < repeat; k++)
+	{
+		splShadePhong(t, &m[0], p, n, v, &l[0], SPLsizei(l.size()), c);
+		b += c.x[k];
+	}
+	const double t2 = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+	check(a == a && b == b, "finite shading");
+	printf("shading: %.1f Msamples/s single and %.1f Msamples/s batched with %d lights and %d lanes\n", count * repeat / 1.0e6 / t1,
+		   count * repeat / 1.0e6 / t2, int(l.size()), int(SPLSimd<SPLieee32>::width));
+}
+
+int main(void)
+{
+	SPLThreadPool pool(2);
+	testPow();
+	testShading(pool);
+	testSpeed(pool);
+
+	printf("shading: %s\n", failures ? "failed" : "passed");
+	return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -5,18 +5,22 @@
 #include <stdlib.h>
 #include <math.h>
 #include <assert.h>
-#include <cuda.h>
-#include <cuda_runtime.h>
 
 #include <spl/vector3.hh>
+#include <spl/launch.hh>
 
 //using namespace std;
 
-//__global__ void cuda_hello();
+struct AddKernel
+{
+	const SPLVector3<SPLieee32> *a, *b;
+	SPLVector3<SPLieee32> *c;
 
-__global__ void cuda_hello() {
-	printf("Hello World from GPU!\n");
-}
+	CUDA_CALLABLE_MEMBER void operator () (const SPLindex i) const
+	{
+		c[i] = a[i] + b[i];
+	}
+};
 
 int main()
 {
@@ -29,7 +33,26 @@ int main()
 	vec = vec1 + vec2;
 	vec.print();
 
-	cuda_hello<<<1, 1>>>();
-
-	return 0;
+	// the same kernel runs on the GPU or on the host threads
+	const SPLsizei n = 1 << 20;
+	SPLVector3<SPLieee32> *a = (SPLVector3<SPLieee32> *)splLaunchMalloc(n * sizeof(SPLVector3<SPLieee32>));
+	SPLVector3<SPLieee32> *b = (SPLVector3<SPLieee32> *)splLaunchMalloc(n * sizeof(SPLVector3<SPLieee32>));
+	SPLVector3<SPLieee32> *c = (SPLVector3<SPLieee32> *)splLaunchMalloc(n * sizeof(SPLVector3<SPLieee32>));
+	for (SPLindex i = 0; i < n; i++)
+	{
+		a[i] = vec1 * SPLieee32(i % 10);
+		b[i] = vec2;
+	}
+	AddKernel kernel = { a, b, c };
+	bool ok = splLaunch(SPLDim3((n + 255) / 256), SPLDim3(256), n, kernel);
+	for (SPLindex i = 0; ok && i < n; i++)
+	{
+		ok = (c[i] == vec1 * SPLieee32(i % 10) + vec2);
+	}
+	printf("Hello World from %s: %s\n", splLaunchHasDevice() ? "GPU" : "CPU", ok ? "passed" : "failed");
+	splLaunchFree(a);
+	splLaunchFree(b);
+	splLaunchFree(c);
+
+	return ok ? 0 : 1;
 }
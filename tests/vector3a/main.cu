@@ -0,0 +1,96 @@
+// main.cu: Compares SPLVector3a and SPLVector4 (SIMD per vector) with SPLVector3.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <vector>
+
+#include <spl/vector3a.hh>
+
+static int failures = 0;
+
+static void check(const bool ok, const char *what)
+{
+	if (!ok)
+	{
+		printf("FAILED: %s\n", what);
+		failures++;
+	}
+}
+
+template <class T>
+static bool near(const SPLVector3<T> &a, const SPLVector3<T> &b, const double tol)
+{
+	return fabs(double(a.x - b.x)) <= tol && fabs(double(a.y - b.y)) <= tol && fabs(double(a.z - b.z)) <= tol;
+}
+
+template <class T>
+static void testType(const char *name, const double tol)
+{
+	check(sizeof(SPLVector3a<T>) == 4 * sizeof(T) && alignof(SPLVector3a<T>) >= 16, name);
+	check(sizeof(SPLVector4<T>) == 4 * sizeof(T) && alignof(SPLVector4<T>) >= 16, name);
+
+	// the containers honour the alignment
+	std::vector<SPLVector3a<T> > array(7);
+	check((size_t(&array[1]) % 16) == 0, name);
+
+	const SPLsizei n = 257;
+	bool ok = true;
+	for (SPLindex i = 0; i < n; i++)
+	{
+		const SPLVector3<T> a(T((i % 17) - 8) * T(0.75), T((i % 5) - 2), T((i % 11) - 3) * T(1.5));
+		const SPLVector3<T> b(T((i % 7) - 3), T((i % 13) - 6) * T(0.25), T((i % 3) + 1));
+		const SPLVector3a<T> A(a), B(b);
+		const T s = T(2.5);
+
+		ok = ok && (A.getVector3() == a) && (SPLVector3a<T>(SPLVector4<T>(a, T(7))) == A);
+		ok = ok && near((A + B).getVector3(), a + b, tol) && near((A - B).getVector3(), a - b, tol);
+		ok = ok && near((A * s).getVector3(), a * s, tol) && near((s * A).getVector3(), a * s, tol);
+		ok = ok && near((A / s).getVector3(), a / s, tol) && near((-A).getVector3(), -a, tol);
+		ok = ok && fabs(double(A * B - a * b)) <= tol;
+		ok = ok && near(A.crossProduct(B).getVector3(), a.crossProduct(b), tol);
+		ok = ok && fabs(double(A.square()) - a.square()) <= tol * a.square() && fabs(double(A.length()) - a.length()) <= tol * a.length();
+
+		SPLVector3a<T> C(A);
+		C += B;
+		C -= A;
+		C *= s;
+		C /= s;
+		ok = ok && near(C.getVector3(), b, tol);
+
+		// the padding stays zero
+		ok = ok && A.crossProduct(B).w == T(0) && (A / s).w == T(0) && (A + B).w == T(0);
+
+		if (a.square() > 0.0)
+		{
+			ok = ok && near(A.getNormalized().getVector3(), a.getNormalized(), tol);
+			ok = ok && near(A.template getNormalized<SPLPrecisionFast>(T(2)).getVector3(), a.getNormalized(2.0), 4.0 * tol);
+			ok = ok && near(A.template getNormalized<SPLPrecisionDouble>().getVector3(), a.getNormalized(), tol);
+		}
+		else
+		{
+			ok = ok && (A.getNormalized() == A);
+		}
+
+		// SPLVector4
+		const SPLVector4<T> P(a, T(1)), Q(b, T(-2));
+		const SPLVector4<T> R = P + Q * s - (-P);
+		ok = ok && near(SPLVector3<T>(R), a + b * s + a, tol) && fabs(double(R.w) - (2.0 - 2.0 * s)) <= tol;
+		ok = ok && fabs(double(P * Q) - (a * b - 2.0)) <= tol;
+		SPLVector4<T> S(P);
+		S += Q;
+		S -= P;
+		S *= s;
+		ok = ok && (S == Q * s);
+	}
+	check(ok, name);
+}
+
+int main(void)
+{
+	testType<SPLieee32>("SPLVector3af", 1.0e-5);
+	testType<SPLieee64>("SPLVector3ad", 1.0e-12);
+	printf("vector3a: %s\n", failures ? "failed" : "passed");
+	return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,113 @@
+// main.cu: Compares the batch kernels of SPLVector3Array with SPLVector3.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <vector>
+
+#include <spl/vector3array.hh>
+
+static int failures = 0;
+
+static void check(const bool ok, const char *what)
+{
+	if (!ok)
+	{
+		printf("FAILED: %s\n", what);
+		failures++;
+	}
+}
+
+template <class T>
+static bool near(const SPLVector3<T> &a, const SPLVector3<T> &b, const double tol)
+{
+	return fabs(double(a.x - b.x)) <= tol && fabs(double(a.y - b.y)) <= tol && fabs(double(a.z - b.z)) <= tol;
+}
+
+template <class T>
+static void testType(const char *name, const double tol)
+{
+	// odd size such that the scalar tail is exercised as well
+	const SPLsizei n = 1003;
+	std::vector<SPLVector3<T> > a(n), b(n), r(n);
+	for (SPLindex i = 0; i < n; i++)
+	{
+		a[i] = SPLVector3<T>(T((i % 17) - 8) * T(0.75), T((i % 5) - 2), T((i % 11) - 3) * T(1.5));
+		b[i] = SPLVector3<T>(T((i % 7) - 3), T((i % 13) - 6) * T(0.25), T((i % 3) + 1));
+	}
+	a[0] = SPLVector3<T>();	// zero vector must survive normalize()
+
+	SPLVector3Array<T> A(&a[0], n), B(&b[0], n), C(n);
+	std::vector<T> s(n);
+	bool ok;
+
+	C.add(A, B);
+	C.toAoS(&r[0]);
+	ok = true;
+	for (SPLindex i = 0; i < n; i++) ok = ok && near(r[i], a[i] + b[i], tol);
+	check(ok, name);
+
+	C.sub(A, B);
+	C.toAoS(&r[0]);
+	ok = true;
+	for (SPLindex i = 0; i < n; i++) ok = ok && near(r[i], a[i] - b[i], tol);
+	check(ok, name);
+
+	C.scale(A, T(2.5));
+	C.toAoS(&r[0]);
+	ok = true;
+	for (SPLindex i = 0; i < n; i++) ok = ok && near(r[i], a[i] * T(2.5), tol);
+	check(ok, name);
+
+	C.crossProduct(A, B);
+	C.toAoS(&r[0]);
+	ok = true;
+	for (SPLindex i = 0; i < n; i++) ok = ok && near(r[i], a[i].crossProduct(b[i]), tol);
+	check(ok, name);
+
+	A.dotProduct(B, &s[0]);
+	ok = true;
+	for (SPLindex i = 0; i < n; i++) ok = ok && fabs(double(s[i] - a[i] * b[i])) <= tol;
+	check(ok, name);
+
+	A.length(&s[0]);
+	ok = true;
+	for (SPLindex i = 0; i < n; i++) ok = ok && fabs(double(s[i]) - a[i].length()) <= tol;
+	check(ok, name);
+
+	C = A;
+	C.normalize();
+	C.toAoS(&r[0]);
+	ok = r[0] == SPLVector3<T>();
+	for (SPLindex i = 1; i < n; i++) ok = ok && near(r[i], a[i].getNormalized(), 1.0e-6);
+	check(ok, name);
+
+	SPLVector3Arrayi I(n);
+	A.getFLOORint(I);
+	ok = true;
+	for (SPLindex i = 0; i < n; i++) ok = ok && I.get(i) == a[i].getFLOORint();
+	check(ok, name);
+
+	// views alias the lanes of the array
+	SPLVector3ArrayView<T> V = C.getView(10, 20);
+	V.fill(SPLVector3<T>(T(1), T(2), T(3)));
+	check(V.size() == 20 && C.get(10) == SPLVector3<T>(T(1), T(2), T(3)) && C.get(29) == V.get(19), name);
+	check(size_t(A.x) % SPL_SIMD_ALIGNMENT == 0 && size_t(A.z) % SPL_SIMD_ALIGNMENT == 0, name);
+
+	printf("%s: %s\n", name, failures ? "failed" : "passed");
+}
+
+int main()
+{
+	testType<SPLieee32>("SPLVector3Arrayf", 1.0e-5);
+	testType<SPLieee64>("SPLVector3Arrayd", 1.0e-12);
+
+	SPLVector3Arrayi a(5), b(5), c(5);
+	a.fill(SPLVector3i(1, 2, 3));
+	b.fill(SPLVector3i(4, 5, 6));
+	c.crossProduct(a, b);
+	check(c.get(4) == SPLVector3i(1, 2, 3).crossProduct(SPLVector3i(4, 5, 6)), "SPLVector3Arrayi");
+
+	return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
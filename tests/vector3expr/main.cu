@@ -0,0 +1,113 @@
+// main.cu: Checks the vector expression templates and compares the fused
+// evaluation of r = a + b*s - c with the SPLVector3 operators.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <chrono>
+#include <vector>
+
+#include <spl/vector3array.hh>
+#include <spl/vector3expr.hh>
+
+static int failures = 0;
+
+static void check(const bool ok, const char *what)
+{
+	if (!ok)
+	{
+		printf("FAILED: %s\n", what);
+		failures++;
+	}
+}
+
+// tolerates contraction into fused multiply-adds by the compiler
+static bool near(const SPLVector3f &a, const SPLVector3f &b)
+{
+	return fabs(a.x - b.x) <= 1.0e-4f && fabs(a.y - b.y) <= 1.0e-4f && fabs(a.z - b.z) <= 1.0e-4f;
+}
+
+template <class F>
+static double seconds(const int repeat, F f)
+{
+	std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+	for (int r = 0; r < repeat; r++)
+	{
+		f();
+	}
+	std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+	return std::chrono::duration<double>(t1 - t0).count() / repeat;
+}
+
+int main(int argc, char **argv)
+{
+	// single vectors
+	SPLVector3f a(1.0f, 2.0f, 3.0f), b(-1.0f, 0.5f, 2.0f), c(0.25f, 0.25f, -4.0f), n;
+	const SPLieee32 s = 1.5f;
+
+	n = splExpr(a) + b * s - c;
+	check(near(n, a + b * s - c), "a + b*s - c");
+	n = -(splExpr(a) - c) / 2.0f;
+	check(n == -(a - c) / 2.0f, "-(a - c)/2");
+	n = splCrossProduct(splExpr(a), splExpr(b) * 2.0f);
+	check(near(n, a.crossProduct(b * 2.0f)), "cross(a, b*2)");
+	a = splExpr(b) + a;	// aliasing
+	check(a == SPLVector3f(0.0f, 2.5f, 5.0f), "a = b + a");
+	SPLVector3d d(splExpr(SPLVector3d(1.0, 2.0, 3.0)) * 2.0);
+	check(d == SPLVector3d(2.0, 4.0, 6.0), "SPLVector3d(expr)");
+
+	// arrays
+	const SPLsizei N = (argc > 1) ? atoi(argv[1]) : 1000003;
+	std::vector<SPLVector3f> A(N), B(N), C(N), R(N);
+	for (SPLindex i = 0; i < N; i++)
+	{
+		A[i] = SPLVector3f(SPLieee32(i % 101), SPLieee32(i % 7) - 3.0f, 0.5f * SPLieee32(i % 13));
+		B[i] = SPLVector3f(SPLieee32(i % 3), SPLieee32(i % 17) * 0.25f, -SPLieee32(i % 5));
+		C[i] = SPLVector3f(1.0f, SPLieee32(i % 11), SPLieee32(i % 19) - 9.0f);
+	}
+	SPLVector3Arrayf SA(&A[0], N), SB(&B[0], N), SC(&C[0], N), SR(N), tmp(N);
+
+	SR.assign(splExpr(SA) + splExpr(SB) * s - splExpr(SC));
+	bool ok = true;
+	for (SPLindex i = 0; i < N; i++)
+	{
+		ok = ok && near(SR.get(i), A[i] + B[i] * s - C[i]);
+	}
+	check(ok, "array a + b*s - c");
+	SR.assign(splCrossProduct(splExpr(SA), splExpr(SB)) + splExpr(SR));
+	ok = true;
+	for (SPLindex i = 0; i < N; i++)
+	{
+		ok = ok && near(SR.get(i), A[i].crossProduct(B[i]) + (A[i] + B[i] * s - C[i]));
+	}
+	check(ok, "array cross(a, b) + r");
+
+	// benchmark
+	const int repeat = 20;
+	const double tAoS = seconds(repeat, [&]()
+	{
+		for (SPLindex i = 0; i < N; i++)
+		{
+			R[i] = A[i] + B[i] * s - C[i];
+		}
+	});
+	const double tBatch = seconds(repeat, [&]()
+	{
+		tmp.scale(SB, s);
+		tmp.add(SA, tmp);
+		SR.sub(tmp, SC);
+	});
+	const double tFused = seconds(repeat, [&]()
+	{
+		SR.assign(splExpr(SA) + splExpr(SB) * s - splExpr(SC));
+	});
+	printf("r = a + b*s - c, %d vectors\n", N);
+	printf("%-28s %10s %10s\n", "", "ms", "Mvec/s");
+	printf("%-28s %10.3f %10.1f\n", "SPLVector3 operators (AoS)", 1.0e3 * tAoS, 1.0e-6 * N / tAoS);
+	printf("%-28s %10.3f %10.1f\n", "batch kernels (SoA)", 1.0e3 * tBatch, 1.0e-6 * N / tBatch);
+	printf("%-28s %10.3f %10.1f\n", "fused expression (SoA)", 1.0e3 * tFused, 1.0e-6 * N / tFused);
+
+	printf("vector3expr: %s\n", failures ? "failed" : "passed");
+	return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
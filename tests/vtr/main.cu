@@ -0,0 +1,180 @@
+// main.cu: Tests of the VTK rectilinear grid writer.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include <spl/vtr.hh>
+
+#include "../check.hh"
+
+static std::string readFile(const char *path)
+{
+	std::string bytes;
+	FILE *f = fopen(path, "rb");
+	if (f != 0)
+	{
+		char b[4096];
+		for (size_t n = fread(b, 1, sizeof(b), f); n > 0; n = fread(b, 1, sizeof(b), f))
+		{
+			bytes.append(b, n);
+		}
+		fclose(f);
+	}
+	return bytes;
+}
+
+// the appended bytes of an array, decompressed if necessary
+static std::vector<SPLuint8> payload(const std::string &file, const char *name, const bool compressed)
+{
+	std::vector<SPLuint8> out;
+	const size_t a = file.find(std::string("Name=\"") + name + "\"");
+	const size_t o = file.find("offset=\"", a);
+	const size_t start = file.find("<AppendedData encoding=\"raw\">");
+	const size_t underscore = file.find('_', start);
+	if (a == std::string::npos || o == std::string::npos || start == std::string::npos || underscore == std::string::npos)
+	{
+		return out;
+	}
+	const SPLuint8 *p = (const SPLuint8 *)file.data() + underscore + 1 + strtoull(file.c_str() + o + 8, 0, 10);
+	SPLuint64 h[3];
+	memcpy(h, p, sizeof(h));
+	if (!compressed)
+	{
+		out.assign(p + 8, p + 8 + h[0]);
+		return out;
+	}
+#ifdef SPL_HAVE_ZLIB
+	const SPLuint8 *block = p + (3 + h[0]) * 8;
+	for (SPLuint64 b = 0; b < h[0]; b++)
+	{
+		SPLuint64 packed;
+		memcpy(&packed, p + (3 + b) * 8, 8);
+		uLongf n = uLongf((b + 1 == h[0] && h[2] != 0) ? h[2] : h[1]);
+		const size_t offset = out.size();
+		out.resize(offset + n);
+		if (uncompress(&out[offset], &n, block, uLong(packed)) != Z_OK)
+		{
+			out.clear();
+			return out;
+		}
+		block += packed;
+	}
+#endif
+	return out;
+}
+
+template <class T>
+static std::vector<SPLuint8> linear(const SPLGrid<T> &g)
+{
+	const SPLVector3i &n = g.getSize();
+	std::vector<SPLuint8> bytes;
+	for (SPLindex z = 0; z < n.z; z++)
+	{
+		for (SPLindex y = 0; y < n.y; y++)
+		{
+			for (SPLindex x = 0; x < n.x; x++)
+			{
+				const SPLuint8 *v = (const SPLuint8 *)&g(x, y, z);
+				bytes.insert(bytes.end(), v, v + sizeof(T));
+			}
+		}
+	}
+	return bytes;
+}
+
+static void testWrite(const SPLenum layout, const SPLint32 level)
+{
+	const SPLVector3i n(19, 7, 5);
+	SPLGridf density(n, layout, 4);
+	SPLGrid<SPLVector3f> velocity(n, layout, 4);
+	SPLGridus label(n - SPLVector3i(1, 1, 1), layout, 4);
+	for (SPLGridf::Iterator it = density.begin(); it != density.end(); ++it)
+	{
+		const SPLVector3i &p = it.getPosition();
+		*it = SPLieee32(p.x) * 0.5f + SPLieee32(p.y * p.z);
+		velocity[p] = SPLVector3f(SPLieee32(p.x), -SPLieee32(p.y), SPLieee32(p.z) * 2.0f);
+	}
+	for (SPLGridus::Iterator it = label.begin(); it != label.end(); ++it)
+	{
+		*it = SPLuint16(it.getPosition().x * 3 + it.getPosition().z);
+	}
+
+	SPLThreadPool pool(3);
+	SPLVTRWriter w(n);
+	w.setSpacing(SPLVector3d(1.0, 2.0, 3.0), SPLVector3d(0.5, 0.25, 2.0));
+	check(w.addPointData("density", density), "add point array");
+	check(w.addPointData("velocity", velocity), "add vector array");
+	check(w.addCellData("label", label), "add cell array");
+	check(!w.addPointData("label", label) && !w.addCellData("density", density), "array sizes");
+	check(w.setCompression(level), "compression");
+	// small blocks, i.e. several batches and a partial last block
+	w.setBlockSize(100);
+	check(w.write("vtr_test.vtr", pool), "write");
+
+	const std::string file = readFile("vtr_test.vtr");
+	const bool compressed = level > 0;
+	check(file.find("type=\"RectilinearGrid\"") != std::string::npos && file.find("WholeExtent=\"0 18 0 6 0 4\"") != std::string::npos, "XML header");
+	check((file.find("compressor=\"vtkZLibDataCompressor\"") != std::string::npos) == compressed, "compressor attribute");
+	check(file.find("type=\"Float32\" Name=\"velocity\" NumberOfComponents=\"3\"") != std::string::npos, "vector array");
+	check(file.find("<CellData>\n        <DataArray type=\"UInt16\" Name=\"label\"") != std::string::npos, "cell array");
+	const std::string tail = "\n  </AppendedData>\n</VTKFile>\n";
+	check(file.size() > tail.size() && file.compare(file.size() - tail.size(), tail.size(), tail) == 0, "end of file");
+
+	check(payload(file, "density", compressed) == linear(density), "density samples");
+	check(payload(file, "velocity", compressed) == linear(velocity), "velocity samples");
+	check(payload(file, "label", compressed) == linear(label), "label samples");
+	const std::vector<SPLuint8> y = payload(file, "y", compressed);
+	SPLieee64 c[7];
+	check(y.size() == sizeof(c), "coordinates");
+	memcpy(c, &y[0], MIN(sizeof(c), y.size()));
+	check(c[0] == 2.0 && c[6] == 3.5, "coordinate values");
+	remove("vtr_test.vtr");
+}
+
+static void testBandwidth(void)
+{
+	const SPLVector3i n(256, 256, 128);
+	SPLGridf g(n);
+	g.fill(0.0f);
+	for (SPLGridf::Iterator it = g.begin(); it != g.end(); ++it)
+	{
+		*it = SPLieee32((it.getPosition().x ^ it.getPosition().y) & 15);
+	}
+	SPLVTRWriter w(n);
+	w.addPointData("v", g);
+	const SPLint32 levels[2] = { 0, 1 };
+	for (SPLint32 i = 0; i < 2; i++)
+	{
+		if (!w.setCompression(levels[i]))
+		{
+			continue;
+		}
+		const std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+		check(w.write("vtr_bandwidth.vtr"), "write large file");
+		const double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+		printf("vtr: level %d, %.1f MB/s\n", levels[i], SPLieee64(n.x) * n.y * n.z * 4.0 / 1.0e6 / s);
+		remove("vtr_bandwidth.vtr");
+	}
+}
+
+int main(void)
+{
+	testWrite(SPL_GRID_LINEAR, 0);
+	testWrite(SPL_GRID_BRICKED, 0);
+#ifdef SPL_HAVE_ZLIB
+	testWrite(SPL_GRID_LINEAR, 6);
+	testWrite(SPL_GRID_BRICKED, 1);
+#else
+	SPLVTRWriter w(SPLVector3i(2, 2, 2));
+	check(!w.setCompression(1), "no zlib");
+#endif
+	testBandwidth();
+
+	printf("vtr: %s\n", failures ? "failed" : "passed");
+	return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}